@@ -0,0 +1,111 @@
+/**
+  ******************************************************************************
+  * @file    bus_arbiter.h
+  * @author  ISCA Lab
+  * @brief   Shared bus arbitration with atomic sequences and deferred requests
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef BUS_ARBITER_H
+#define BUS_ARBITER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * A client owns the bus between BUS_ARB_Acquire and BUS_ARB_Release, so a
+ * register bank switch, the access and the switch back form one indivisible
+ * sequence. Acquiring again from the owner context nests, which lets the
+ * bus primitives take the bus themselves.
+ *
+ * A client running at another context (typically an interrupt preempting
+ * the owner) cannot wait: BUS_ARB_Acquire returns BUS_ARB_BUSY. It can
+ * instead submit a request, queued by priority and run as soon as the owner
+ * releases the bus, in the owner context.
+ *
+ * Interrupt masking, the time source and the context identification come
+ * from a port structure, so the arbiter builds and runs on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#ifndef BUS_ARB_MAX_CLIENTS
+#define BUS_ARB_MAX_CLIENTS  4U
+#endif
+
+#define BUS_ARB_OK       0
+#define BUS_ARB_ERROR   -1
+#define BUS_ARB_BUSY    -2
+#define BUS_ARB_QUEUED   1
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t (*Clock)(void);          /* Time source for the statistics */
+  uint32_t (*Context)(void);        /* Identifies the running context (IPSR on target) */
+  uint32_t (*Lock)(void);           /* Masks interrupts, returns the previous state */
+  void (*Unlock)(uint32_t State);   /* Restores the state returned by Lock */
+} BUS_ARB_Port_t;
+
+typedef int32_t (*BUS_ARB_Sequence_t)(void *Context);
+typedef void (*BUS_ARB_Done_t)(void *Context, int32_t Status);
+
+typedef struct BUS_ARB_Request_s
+{
+  BUS_ARB_Sequence_t Sequence; /* Bus accesses, run with the bus owned */
+  BUS_ARB_Done_t Done;         /* Called with the sequence status, may be NULL */
+  void *Context;
+  uint8_t Client;
+  uint8_t Priority;            /* 0 is the highest */
+  /* Managed by the arbiter */
+  uint8_t Pending;
+  uint32_t SubmitTime;
+  struct BUS_ARB_Request_s *Next;
+} BUS_ARB_Request_t;
+
+typedef struct
+{
+  uint32_t Acquired;   /* Sequences run, direct and queued */
+  uint32_t Busy;       /* Acquire attempts refused */
+  uint32_t Queued;     /* Requests that had to wait */
+  uint32_t TotalWait;  /* Submit to start of queued requests */
+  uint32_t MaxWait;
+  uint32_t MaxHold;    /* Longest bus ownership */
+} BUS_ARB_Stats_t;
+
+typedef struct
+{
+  const BUS_ARB_Port_t *Port;
+  volatile uint8_t Busy;
+  uint8_t Depth;          /* Nesting of the owner */
+  uint8_t Owner;          /* Owner client */
+  uint32_t OwnerContext;
+  uint32_t HoldStart;
+  BUS_ARB_Request_t *Queue;
+  BUS_ARB_Stats_t Stats[BUS_ARB_MAX_CLIENTS];
+} BUS_ARB_t;
+
+/* Exported functions --------------------------------------------------------*/
+void BUS_ARB_Init(BUS_ARB_t *Arb, const BUS_ARB_Port_t *Port);
+int32_t BUS_ARB_Acquire(BUS_ARB_t *Arb, uint32_t Client);
+void BUS_ARB_Release(BUS_ARB_t *Arb);
+int32_t BUS_ARB_Run(BUS_ARB_t *Arb, uint32_t Client, BUS_ARB_Sequence_t Sequence, void *Context);
+int32_t BUS_ARB_Submit(BUS_ARB_t *Arb, BUS_ARB_Request_t *Req);
+int32_t BUS_ARB_GetStats(const BUS_ARB_t *Arb, uint32_t Client, BUS_ARB_Stats_t *Stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BUS_ARBITER_H */
@@ -0,0 +1,65 @@
+/**
+  ******************************************************************************
+  * @file    lat_hist.h
+  * @author  ISCA Lab
+  * @brief   Log-linear latency histogram with percentile queries
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef LAT_HIST_H
+#define LAT_HIST_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * Values below 8 get one bin each. Each power of two above that is split in
+ * 8 bins, so a bin is at most 12.5 % wide and a percentile is read back
+ * within that error whatever the spread of the values. Values at or above
+ * LAT_HIST_RANGE go in the last bin, the exact maximum is kept aside.
+ *
+ * The bins are 16 bits wide. When one would overflow, all of them are
+ * halved: the shape of the distribution is kept and the oldest samples
+ * weigh less.
+ *
+ * The module has no hardware dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define LAT_HIST_SUB_BITS  3U
+#define LAT_HIST_SUB_BINS  (1U << LAT_HIST_SUB_BITS)
+#define LAT_HIST_BINS      160U
+#define LAT_HIST_RANGE     (1UL << ((LAT_HIST_BINS / LAT_HIST_SUB_BINS) + 2U))
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Count;  /* Samples held in the bins */
+  uint32_t Max;    /* Largest sample since the reset */
+  uint16_t Bins[LAT_HIST_BINS];
+} LAT_HIST_t;
+
+/* Exported functions --------------------------------------------------------*/
+void LAT_HIST_Reset(LAT_HIST_t *Hist);
+void LAT_HIST_Add(LAT_HIST_t *Hist, uint32_t Value);
+uint32_t LAT_HIST_Percentile(const LAT_HIST_t *Hist, uint32_t Permille);
+uint32_t LAT_HIST_BinOf(uint32_t Value);
+uint32_t LAT_HIST_BinHigh(uint32_t Bin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LAT_HIST_H */
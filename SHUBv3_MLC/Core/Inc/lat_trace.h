@@ -0,0 +1,85 @@
+/**
+  ******************************************************************************
+  * @file    lat_trace.h
+  * @author  ISCA Lab
+  * @brief   MLC alarm latency tracing, from the INT1 line to the last UART byte
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef LAT_TRACE_H
+#define LAT_TRACE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "lat_hist.h"
+#include "mem_budget.h"
+
+/*
+ * One pipeline per MLC sensor instance: the MLC report of the sensor from
+ * its interrupt line going high to the last byte of the report line leaving
+ * LPUART1. The points are stamped with the free-running 32 bit TIM2, the
+ * time between two consecutive points goes in a histogram of its segment,
+ * in microseconds (see lat_hist.h).
+ *
+ * EXTI line 0 belongs to the user button (PA0), so INT1 (PC0) is not an
+ * interrupt: LAT_TRACE_EDGE is the first poll that finds the line high and
+ * the time before it, up to the MLC poll period, is not seen. A sensor
+ * without interrupt line has no edge and no wait segment, its total starts
+ * at the bus read.
+ *
+ * Typing "lat" on the log terminal prints the percentiles of each segment,
+ * "lat reset" clears them.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#ifndef LAT_TRACE_PIPES
+#define LAT_TRACE_PIPES   MEM_BUDGET_SNAP_SENSORS
+#endif
+
+/* Console poll period and completed trace collection [ms] */
+#ifndef LAT_TRACE_PERIOD
+#define LAT_TRACE_PERIOD  200U
+#endif
+
+/* Points of a pipeline, in order */
+#define LAT_TRACE_EDGE        0U  /* Interrupt line found high */
+#define LAT_TRACE_READ_START  1U  /* Bus requested for the MLC sources */
+#define LAT_TRACE_READ_END    2U  /* Bus released */
+#define LAT_TRACE_FORMAT      3U  /* Report line formatted */
+#define LAT_TRACE_POINTS      4U
+
+/* Segments, each with its histogram */
+#define LAT_TRACE_SEG_WAIT    0U  /* Edge to read start */
+#define LAT_TRACE_SEG_READ    1U  /* Read start to read end */
+#define LAT_TRACE_SEG_FORMAT  2U  /* Read end to report formatted */
+#define LAT_TRACE_SEG_TX      3U  /* Report formatted to last byte sent */
+#define LAT_TRACE_SEG_TOTAL   4U  /* Edge (or read start) to last byte sent */
+#define LAT_TRACE_SEGMENTS    5U
+
+/* Exported functions --------------------------------------------------------*/
+void LAT_TRACE_Init(void);
+uint32_t LAT_TRACE_Now(void);
+void LAT_TRACE_Stamp(uint32_t Pipe, uint32_t Point);
+void LAT_TRACE_Queue(uint32_t Pipe, uint32_t Mark);
+void LAT_TRACE_Abort(uint32_t Pipe);
+void LAT_TRACE_Sent(uint32_t Position);
+const LAT_HIST_t *LAT_TRACE_GetHist(uint32_t Pipe, uint32_t Segment);
+void LAT_TRACE_Reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LAT_TRACE_H */
@@ -0,0 +1,72 @@
+/**
+  ******************************************************************************
+  * @file    log_ring.h
+  * @author  ISCA Lab
+  * @brief   Lock-free single producer / single consumer byte ring
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+/*
+ * The producer only writes Head, the consumer only writes Tail. Both indexes
+ * run freely and are masked on access, so Size must be a power of two.
+ * The consumer reads the pending data in place (LOG_RING_Peek) and releases
+ * it once done (LOG_RING_Release), which lets a DMA stream straight out of
+ * the ring without an intermediate copy.
+ */
+typedef struct
+{
+  uint8_t *Buffer;
+  uint32_t Size;
+  volatile uint32_t Head;     /* Written by the producer */
+  volatile uint32_t Tail;     /* Written by the consumer */
+  volatile uint32_t Written;  /* Bytes accepted */
+  volatile uint32_t Dropped;  /* Bytes rejected because the ring was full */
+  volatile uint32_t Overflows; /* Writes rejected because the ring was full */
+  volatile uint32_t HighWater; /* Maximum fill level observed */
+} LOG_RING_t;
+
+typedef struct
+{
+  uint32_t Written;
+  uint32_t Dropped;
+  uint32_t Overflows;
+  uint32_t HighWater;
+  uint32_t Used;
+} LOG_RING_Stats_t;
+
+/* Exported defines ----------------------------------------------------------*/
+#define LOG_RING_OK     0
+#define LOG_RING_ERROR -1
+
+/* Exported functions --------------------------------------------------------*/
+int32_t LOG_RING_Init(LOG_RING_t *Ring, uint8_t *Buffer, uint32_t Size);
+int32_t LOG_RING_Write(LOG_RING_t *Ring, const uint8_t *Data, uint32_t Len);
+uint32_t LOG_RING_Peek(LOG_RING_t *Ring, uint8_t **Data);
+void LOG_RING_Release(LOG_RING_t *Ring, uint32_t Len);
+uint32_t LOG_RING_Used(const LOG_RING_t *Ring);
+void LOG_RING_GetStats(const LOG_RING_t *Ring, LOG_RING_Stats_t *Stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_RING_H */
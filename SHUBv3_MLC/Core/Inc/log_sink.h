@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file    log_sink.h
+  * @author  ISCA Lab
+  * @brief   Buffered log output drained by LPUART1 TX DMA
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "log_ring.h"
+#include "mem_budget.h"
+
+/* Exported defines ----------------------------------------------------------*/
+/* Ring size in bytes, set in mem_budget.h */
+#define LOG_SINK_BUFFER_SIZE  ((uint32_t)MEM_BUDGET_LOG_RING_SIZE)
+
+/* Terminal input, received by circular DMA and read by polling */
+#ifndef LOG_SINK_RX_SIZE
+#define LOG_SINK_RX_SIZE      64U
+#endif
+
+#define LOG_SINK_OK      0
+#define LOG_SINK_ERROR  -1
+
+/* Exported functions --------------------------------------------------------*/
+void LOG_SINK_Init(void);
+int32_t LOG_SINK_Write(const uint8_t *Data, uint32_t Len);
+void LOG_SINK_WriteBlocking(const uint8_t *Data, uint32_t Len);
+void LOG_SINK_Flush(uint32_t Timeout);
+void LOG_SINK_GetStats(LOG_RING_Stats_t *Stats);
+uint32_t LOG_SINK_Position(void);
+uint32_t LOG_SINK_Read(uint8_t *Data, uint32_t Len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LOG_SINK_H */
@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * @file    lsm6dsox_mlc.h
+  * @author  ISCA Lab
+  * @brief   LSM6DSOX Machine Learning Core service
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef LSM6DSOX_MLC_H
+#define LSM6DSOX_MLC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+/* Run the accelerometer self-test at startup, adds about 350 ms */
+#ifndef LSM6DSOX_MLC_SELF_TEST
+#define LSM6DSOX_MLC_SELF_TEST  0
+#endif
+
+/*
+ * One MLC service per LSM6DSOX instance of custom_motion_sensors.h, each with
+ * its own UCF program and interrupt line. A second sensor is enabled with
+ * USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 and MEM_BUDGET_SNAP_SENSORS set to 2.
+ */
+
+/* UCF program of each instance, an array of ucf_line_t */
+#ifndef LSM6DSOX_MLC_0_UCF
+#define LSM6DSOX_MLC_0_UCF  falling
+#endif
+#ifndef LSM6DSOX_MLC_1_UCF
+#define LSM6DSOX_MLC_1_UCF  falling
+#endif
+
+/* MLC interrupt line (INT1) of each instance. While it is low the interrupt
+ * sources are not read, undefined to poll them over the bus. */
+#ifndef LSM6DSOX_MLC_0_INT_PORT
+#define LSM6DSOX_MLC_0_INT_PORT  GPIOC
+#define LSM6DSOX_MLC_0_INT_PIN   GPIO_PIN_0
+#endif
+
+/* Exported functions --------------------------------------------------------*/
+/* Startup steps, see startup_seq.h for the return codes */
+int32_t lsm6dsox_mlc_power_on(void);
+int32_t lsm6dsox_mlc_boot_poll(uint32_t elapsed);
+int32_t lsm6dsox_mlc_self_test_start(void);
+int32_t lsm6dsox_mlc_self_test_poll(uint32_t elapsed);
+int32_t lsm6dsox_mlc_reset_start(void);
+int32_t lsm6dsox_mlc_reset_poll(uint32_t elapsed);
+int32_t lsm6dsox_mlc_config(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LSM6DSOX_MLC_H */
@@ -0,0 +1,103 @@
+/**
+  ******************************************************************************
+  * @file    mem_budget.h
+  * @author  ISCA Lab
+  * @brief   Static memory budget of the firmware buffers
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * Every large buffer of the application is listed here with its size and the
+ * SRAM bank it lives in. The buffers are carved at initialization from one
+ * pool per bank (see mem_budget.c), the pools are sized from this table and
+ * the build fails if a bank goes over its limit. Each entry is also printed
+ * as a compiler note when mem_budget.c is built.
+ *
+ * To add a buffer: add its _REGION/_SIZE pair, add it to MEM_BUDGET_TOTAL
+ * and to the report in mem_budget.c, then take it with MEM_BUDGET_ALLOC.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+/* Regions */
+#define MEM_BUDGET_SRAM1  1
+#define MEM_BUDGET_SRAM2  2
+
+/* Region limits in bytes. SRAM1 also holds .data, .bss, heap and stack,
+ * SRAM2 also holds the code copied by .ram2_text. */
+#define MEM_BUDGET_SRAM1_LIMIT  8192
+#define MEM_BUDGET_SRAM2_LIMIT  16384
+
+/* Log ring drained by LPUART1 TX DMA, must be a power of two */
+#define MEM_BUDGET_LOG_RING_REGION      MEM_BUDGET_SRAM2
+#define MEM_BUDGET_LOG_RING_SIZE        2048
+
+/* MLC interrupt report formatting */
+#define MEM_BUDGET_MLC_TX_REGION        MEM_BUDGET_SRAM2
+#define MEM_BUDGET_MLC_TX_SIZE          1000
+
+/* DataLogTerminal line formatting */
+#define MEM_BUDGET_TERMINAL_OUT_REGION  MEM_BUDGET_SRAM2
+#define MEM_BUDGET_TERMINAL_OUT_SIZE    256
+
+/* MLC event snapshot: FIFO words (8 bytes each) per sensor and encoded
+ * output, shared */
+#ifndef MEM_BUDGET_SNAP_SENSORS
+#define MEM_BUDGET_SNAP_SENSORS         1
+#endif
+#define MEM_BUDGET_SNAP_WORDS_REGION    MEM_BUDGET_SRAM2
+#define MEM_BUDGET_SNAP_WORDS_SIZE      (2048 * MEM_BUDGET_SNAP_SENSORS)
+#define MEM_BUDGET_SNAP_OUT_REGION      MEM_BUDGET_SRAM2
+#define MEM_BUDGET_SNAP_OUT_SIZE        2336
+
+/* MLC alarm latency histograms: 5 segments of 328 bytes per sensor */
+#define MEM_BUDGET_LAT_TRACE_REGION     MEM_BUDGET_SRAM2
+#define MEM_BUDGET_LAT_TRACE_SIZE       (1640 * MEM_BUDGET_SNAP_SENSORS)
+
+/* Exported macro ------------------------------------------------------------*/
+/* Block size once aligned, same as MEM_ARENA_ROUND but usable in #if */
+#define MEM_BUDGET_ROUND(Size)  (((Size) + 7) & ~7)
+
+/* Bytes taken by an entry from a region */
+#define MEM_BUDGET_ENTRY(Name, Region) \
+  ((MEM_BUDGET_##Name##_REGION == (Region)) ? MEM_BUDGET_ROUND(MEM_BUDGET_##Name##_SIZE) : 0)
+
+/* Total size of a region pool */
+#define MEM_BUDGET_TOTAL(Region)             \
+  (MEM_BUDGET_ENTRY(LOG_RING, Region)        \
+   + MEM_BUDGET_ENTRY(MLC_TX, Region)        \
+   + MEM_BUDGET_ENTRY(TERMINAL_OUT, Region)  \
+   + MEM_BUDGET_ENTRY(SNAP_WORDS, Region)    \
+   + MEM_BUDGET_ENTRY(SNAP_OUT, Region)      \
+   + MEM_BUDGET_ENTRY(LAT_TRACE, Region))
+
+/* Take the block of an entry from its region */
+#define MEM_BUDGET_ALLOC(Name) \
+  MEM_BUDGET_Alloc(MEM_BUDGET_##Name##_REGION, MEM_BUDGET_##Name##_SIZE)
+
+/* Exported functions --------------------------------------------------------*/
+void *MEM_BUDGET_Alloc(uint32_t Region, uint32_t Size);
+uint32_t MEM_BUDGET_Available(uint32_t Region);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEM_BUDGET_H */
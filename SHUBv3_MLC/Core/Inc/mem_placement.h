@@ -0,0 +1,58 @@
+/**
+  ******************************************************************************
+  * @file    mem_placement.h
+  * @author  ISCA Lab
+  * @brief   Memory placement attributes for code and buffers
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef MEM_PLACEMENT_H
+#define MEM_PLACEMENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * RAM_FUNC marks code on the interrupt and sample path that may run from
+ * SRAM2 (section .RamFunc, see .ram2_text in STM32WL55JCIX_FLASH.ld). It
+ * stays in flash unless MEM_PLACEMENT_RAM_CODE is 1: at the 4 MHz MSI clock
+ * the flash has no wait states, and code in SRAM2 is fetched over the S-bus
+ * it shares with the data accesses. Time both builds with the DWT before
+ * turning it on (Tools/mem_placement).
+ *
+ * RAM2_BSS places a zero-initialized buffer in SRAM2 (section .ram2_bss),
+ * keeping SRAM1 for .data, .bss, heap and stack.
+ *
+ * Both expand to nothing outside the ARM build so the same sources still
+ * compile for the host.
+ */
+#ifndef MEM_PLACEMENT_RAM_CODE
+#define MEM_PLACEMENT_RAM_CODE  0
+#endif
+
+#if defined(__GNUC__) && defined(__arm__)
+#if (MEM_PLACEMENT_RAM_CODE == 1)
+#define RAM_FUNC   __attribute__((section(".RamFunc"), noinline))
+#else
+#define RAM_FUNC
+#endif
+#define RAM2_BSS   __attribute__((section(".ram2_bss")))
+#else
+#define RAM_FUNC
+#define RAM2_BSS
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEM_PLACEMENT_H */
@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    mlc_snapshot.h
+  * @author  ISCA Lab
+  * @brief   Pre/post-trigger motion snapshot assembly and encoding
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef MLC_SNAPSHOT_H
+#define MLC_SNAPSHOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * A snapshot collects the FIFO words drained around an MLC event, oldest
+ * first, and marks where the trigger happened. The encoder splits the words
+ * per sensor and delta codes each axis, which takes a few bytes per sample
+ * for the slow motion around a fall instead of six.
+ *
+ * Encoded snapshot, little endian:
+ *   'S' 'N' version code odr(u16) streams reserved
+ *   per stream: tag pre(u16) count(u16) first sample (3 x i16)
+ *               then (count - 1) x 3 zigzag varint axis deltas
+ *   CRC-16/CCITT (u16) of all the previous bytes
+ *
+ * The module has no hardware dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define MLC_SNAP_OK     0
+#define MLC_SNAP_ERROR -1
+
+#define MLC_SNAP_VERSION    1U
+
+/* FIFO word tags (TAG_SENSOR field of FIFO_DATA_OUT_TAG) */
+#define MLC_SNAP_TAG_GYR    0x01U
+#define MLC_SNAP_TAG_ACC    0x02U
+
+#define MLC_SNAP_FIFO_WORD_SIZE  7U /* Tag byte and three 16 bit axes */
+#define MLC_SNAP_STREAMS         2U
+
+/* Worst case encoded size: every delta takes a 3 byte varint */
+#define MLC_SNAP_ENCODED_MAX(Words) \
+  (8U + (MLC_SNAP_STREAMS * 11U) + ((Words) * 9U) + 2U)
+
+/* Text size of Len bytes once base64 encoded */
+#define MLC_SNAP_BASE64_SIZE(Len)  ((((Len) + 2U) / 3U) * 4U)
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t Tag;
+  uint8_t Reserved;
+  int16_t Data[3];
+} MLC_SNAP_Word_t;
+
+typedef struct
+{
+  MLC_SNAP_Word_t *Words;
+  uint32_t Capacity;
+  uint32_t Count;
+  uint32_t Trigger;  /* Index of the first word after the trigger */
+  uint32_t Dropped;  /* Words that did not fit */
+  uint16_t Odr;      /* Batching rate in Hz */
+  uint8_t Code;      /* MLC output that triggered the capture */
+} MLC_SNAP_t;
+
+/* Exported functions --------------------------------------------------------*/
+void MLC_SNAP_Init(MLC_SNAP_t *Snap, MLC_SNAP_Word_t *Words, uint32_t Capacity);
+void MLC_SNAP_Start(MLC_SNAP_t *Snap, uint8_t Code, uint16_t Odr);
+int32_t MLC_SNAP_AddRaw(MLC_SNAP_t *Snap, const uint8_t *Raw);
+void MLC_SNAP_MarkTrigger(MLC_SNAP_t *Snap);
+uint32_t MLC_SNAP_Peak(const MLC_SNAP_t *Snap, uint8_t Tag, uint32_t *Count);
+int32_t MLC_SNAP_Encode(const MLC_SNAP_t *Snap, uint8_t *Out, uint32_t Size, uint32_t *Len);
+uint32_t MLC_SNAP_Base64(const uint8_t *In, uint32_t Len, char *Out);
+uint16_t MLC_SNAP_Crc16(const uint8_t *Data, uint32_t Len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MLC_SNAPSHOT_H */
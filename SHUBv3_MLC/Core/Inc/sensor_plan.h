@@ -0,0 +1,111 @@
+/**
+  ******************************************************************************
+  * @file    sensor_plan.h
+  * @author  ISCA Lab
+  * @brief   Lowest power LSM6DSOX configuration for a set of consumers
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SENSOR_PLAN_H
+#define SENSOR_PLAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * Each consumer of a sensor states what it needs: the lowest accelerometer,
+ * gyroscope and MLC rates, the FIFO batching rates, the FIFO window it keeps
+ * and the longest a batched word may wait, and the noisiest power mode its
+ * data tolerates. SENSOR_PLAN_Solve merges them into one configuration:
+ *
+ *  - each sensor runs at the lowest rate of the ladder that covers every
+ *    rate, batching rate and the MLC rate asked of it,
+ *  - of the power modes all its consumers accept, the one drawing the
+ *    least current at that rate is taken. Low-power / normal mode goes up to
+ *    208 Hz, ultra-low-power only for the accelerometer with the gyroscope
+ *    off, high-performance from 12.5 Hz,
+ *  - the watermark is the largest the latency budgets allow, at least the
+ *    largest window kept. With no latency budget it is that window.
+ *
+ * The currents are typical planning figures (datasheet order of magnitude,
+ * rounded), the total in the plan is for comparing configurations. A
+ * request no configuration meets leaves the plan untouched.
+ *
+ * The module has no hardware dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define SENSOR_PLAN_OK      0
+#define SENSOR_PLAN_ERROR  -1
+
+/* Rate ladder of the sensor */
+#define SENSOR_PLAN_RATE_OFF     0U
+#define SENSOR_PLAN_RATE_1Hz6    1U  /* Accelerometer low-power modes only */
+#define SENSOR_PLAN_RATE_12Hz5   2U
+#define SENSOR_PLAN_RATE_26Hz    3U
+#define SENSOR_PLAN_RATE_52Hz    4U
+#define SENSOR_PLAN_RATE_104Hz   5U
+#define SENSOR_PLAN_RATE_208Hz   6U
+#define SENSOR_PLAN_RATE_417Hz   7U
+#define SENSOR_PLAN_RATE_833Hz   8U
+#define SENSOR_PLAN_RATE_1667Hz  9U
+#define SENSOR_PLAN_RATE_3333Hz  10U
+#define SENSOR_PLAN_RATE_6667Hz  11U
+#define SENSOR_PLAN_RATES        12U
+
+/* Power modes, from the least to the most noisy */
+#define SENSOR_PLAN_MODE_HP   0U  /* High-performance */
+#define SENSOR_PLAN_MODE_LP   1U  /* Low-power / normal */
+#define SENSOR_PLAN_MODE_ULP  2U  /* Ultra-low-power, accelerometer only */
+
+#define SENSOR_PLAN_MAX_WATERMARK  511U  /* FIFO words, 9 bits */
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  const char *Name;
+  uint32_t AccRate;      /* Lowest accelerometer rate [0.1 Hz], 0 if unused */
+  uint32_t GyrRate;      /* Lowest gyroscope rate [0.1 Hz], 0 if unused */
+  uint32_t MlcRate;      /* MLC rate [0.1 Hz], 0 if unused, runs on the accelerometer */
+  uint32_t AccBatch;     /* Lowest accelerometer FIFO batching rate [0.1 Hz], 0 if none */
+  uint32_t GyrBatch;     /* Lowest gyroscope FIFO batching rate [0.1 Hz], 0 if none */
+  uint16_t FifoWindow;   /* FIFO words kept below the watermark, 0 if none */
+  uint16_t FifoLatency;  /* Longest wait of a batched word [ms], 0 if none */
+  uint8_t AccMode;       /* Noisiest accelerometer mode accepted, SENSOR_PLAN_MODE_x */
+  uint8_t GyrMode;       /* Noisiest gyroscope mode accepted */
+} SENSOR_PLAN_Req_t;
+
+typedef struct
+{
+  uint8_t AccRate;       /* SENSOR_PLAN_RATE_x */
+  uint8_t AccMode;       /* SENSOR_PLAN_MODE_x */
+  uint8_t GyrRate;
+  uint8_t GyrMode;
+  uint8_t MlcRate;
+  uint8_t AccBatch;      /* SENSOR_PLAN_RATE_x, OFF if not batched */
+  uint8_t GyrBatch;
+  uint16_t Watermark;    /* [words], 0 if nothing is batched */
+  uint32_t Current;      /* Planning figure [0.1 uA] */
+} SENSOR_PLAN_t;
+
+/* Exported functions --------------------------------------------------------*/
+int32_t SENSOR_PLAN_Solve(const SENSOR_PLAN_Req_t *Reqs, uint32_t Count, SENSOR_PLAN_t *Plan);
+uint32_t SENSOR_PLAN_RateOf(uint8_t Rate);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSOR_PLAN_H */
@@ -0,0 +1,61 @@
+/**
+  ******************************************************************************
+  * @file    spi_reg.h
+  * @author  ISCA Lab
+  * @brief   Register access framing for SPI sensors
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SPI_REG_H
+#define SPI_REG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * ST MEMS register protocol over 4-wire SPI: chip select low, one address
+ * byte with bit 7 set for a read, then the data bytes, the device increments
+ * the address (IF_INC, on by default). Chip select is always released, also
+ * after an error.
+ *
+ * The bus itself is reached through a port, so the framing has no hardware
+ * dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define SPI_REG_READ  0x80U /* Read bit of the address byte */
+
+#define SPI_REG_OK      0
+#define SPI_REG_ERROR  -1
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  void *Context;
+  /* Drive chip select, Active 1 selects the device */
+  void (*Select)(void *Context, uint8_t Active);
+  /* Full duplex transfer, Tx NULL sends zeros, Rx NULL discards; 0 on success */
+  int32_t (*Exchange)(void *Context, const uint8_t *Tx, uint8_t *Rx, uint16_t Len);
+} SPI_REG_Port_t;
+
+/* Exported functions --------------------------------------------------------*/
+int32_t SPI_REG_Read(const SPI_REG_Port_t *Port, uint8_t Reg, uint8_t *Data, uint16_t Len);
+int32_t SPI_REG_Write(const SPI_REG_Port_t *Port, uint8_t Reg, const uint8_t *Data, uint16_t Len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPI_REG_H */
@@ -0,0 +1,84 @@
+/**
+  ******************************************************************************
+  * @file    startup_seq.h
+  * @author  ISCA Lab
+  * @brief   Startup sequencer running independent init steps side by side
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef STARTUP_SEQ_H
+#define STARTUP_SEQ_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * A step is started once all the steps it depends on are done, then polled
+ * until it reports done, fails or runs out of time. While a step waits on
+ * the hardware (a sensor booting, a reset bit clearing) the sequencer keeps
+ * starting and polling the others, so waits overlap instead of adding up.
+ * A mandatory step that fails skips the steps depending on it, an optional
+ * one only records its failure. A skipped step, optional or not, skips its
+ * dependents in turn.
+ *
+ * A table is refused before any step runs if a step depends on an index
+ * past the table, on itself or through a cycle, or polls without a timeout:
+ * such a table could never finish.
+ *
+ * The start and end time of every step are recorded. The sequencer has no
+ * hardware dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define STARTUP_MAX_STEPS  32U
+
+/* Step status */
+#define STARTUP_DONE        0
+#define STARTUP_PENDING     1
+#define STARTUP_ERROR      -1
+#define STARTUP_TIMEOUT    -2
+#define STARTUP_SKIPPED    -3
+#define STARTUP_NOT_RUN    -4
+
+/* Dependency on the step at index Index */
+#define STARTUP_DEP(Index)  (1UL << (Index))
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  const char *Name;
+  int32_t (*Start)(void);            /* NULL if the step only polls */
+  int32_t (*Poll)(uint32_t Elapsed); /* NULL if done once started, Elapsed since start */
+  uint32_t Depends;                  /* STARTUP_DEP mask */
+  uint32_t Timeout;                  /* Max time from start to done, required with Poll */
+  uint8_t Optional;                  /* A failure does not fail the sequence nor skip dependents */
+} STARTUP_Step_t;
+
+typedef struct
+{
+  uint32_t Start;
+  uint32_t End;
+  int32_t Status;
+} STARTUP_Record_t;
+
+/* Exported functions --------------------------------------------------------*/
+int32_t STARTUP_Run(const STARTUP_Step_t *Steps, uint32_t Count, STARTUP_Record_t *Records,
+                    uint32_t (*Clock)(void));
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STARTUP_SEQ_H */
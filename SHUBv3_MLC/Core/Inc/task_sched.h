@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    task_sched.h
+  * @author  ISCA Lab
+  * @brief   Cooperative run-to-completion task scheduler
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TASK_SCHED_H
+#define TASK_SCHED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * Tasks are plain functions that run to completion when events are posted to
+ * them. Events are bits OR-ed into a per task mask, so posting never blocks
+ * and is safe from interrupts. The highest priority task with events runs
+ * first, tasks of the same priority take turns.
+ *
+ * Each task also owns one timer, started with TASK_SCHED_SetTimer or by a
+ * non-zero Period at registration, which posts TASK_SCHED_EVT_TIMER.
+ *
+ * Times are in ticks of the clock given to TASK_SCHED_Init (HAL_GetTick on
+ * the target). The scheduler has no hardware dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#ifndef TASK_SCHED_MAX_TASKS
+#define TASK_SCHED_MAX_TASKS    8U
+#endif
+
+/* Priorities, 0 is the highest */
+#define TASK_SCHED_PRIO_HIGH    0U
+#define TASK_SCHED_PRIO_NORMAL  1U
+#define TASK_SCHED_PRIO_LOW     2U
+#define TASK_SCHED_PRIO_NBR     3U
+
+/* Event posted by the task timer, the other bits are free for the tasks */
+#define TASK_SCHED_EVT_TIMER    0x80000000U
+
+#define TASK_SCHED_OK      0
+#define TASK_SCHED_ERROR  -1
+
+/* Exported types ------------------------------------------------------------*/
+typedef void (*TASK_SCHED_Handler_t)(uint32_t Events);
+typedef uint32_t (*TASK_SCHED_Clock_t)(void);
+typedef void (*TASK_SCHED_Idle_t)(void);
+
+typedef struct
+{
+  const char *Name;
+  TASK_SCHED_Handler_t Handler;
+  uint8_t Priority;
+  uint32_t Period;   /* Timer period, 0 for no periodic run */
+  uint32_t Deadline; /* Max time from post to completion, 0 for none */
+} TASK_SCHED_Def_t;
+
+typedef struct
+{
+  uint32_t Runs;
+  uint32_t MaxLatency;     /* Post to start */
+  uint32_t MaxRunTime;     /* Start to completion */
+  uint32_t DeadlineMisses;
+} TASK_SCHED_Stats_t;
+
+/* Exported functions --------------------------------------------------------*/
+void TASK_SCHED_Init(TASK_SCHED_Clock_t Clock, TASK_SCHED_Idle_t Idle);
+int32_t TASK_SCHED_Register(const TASK_SCHED_Def_t *Def, uint32_t *Id);
+void TASK_SCHED_Post(uint32_t Id, uint32_t Events);
+void TASK_SCHED_SetTimer(uint32_t Id, uint32_t Delay, uint32_t Period);
+void TASK_SCHED_StopTimer(uint32_t Id);
+uint32_t TASK_SCHED_Pending(void);
+int32_t TASK_SCHED_NextTimer(uint32_t *Delay);
+uint32_t TASK_SCHED_RunOnce(void);
+void TASK_SCHED_Run(void);
+int32_t TASK_SCHED_GetStats(uint32_t Id, TASK_SCHED_Stats_t *Stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TASK_SCHED_H */
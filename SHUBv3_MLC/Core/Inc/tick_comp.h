@@ -0,0 +1,63 @@
+/**
+  ******************************************************************************
+  * @file    tick_comp.h
+  * @author  ISCA Lab
+  * @brief   Millisecond tick compensation across a tickless sleep
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TICK_COMP_H
+#define TICK_COMP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * While the 1 ms tick is stopped, the time is measured by a counter of Hz
+ * ticks per second. On wake, the elapsed counter ticks are turned into
+ * whole milliseconds for the tick and the rest is kept for the next sleep,
+ * so the tick never drifts from the counter. The part of the current
+ * millisecond already run when the tick stops is added the same way.
+ * A sleep ended by the compare is counted half a counter tick short, the
+ * mean phase of the counter when the sleep started.
+ *
+ * Rem is in 1/Hz ms: Hz of them make a millisecond.
+ *
+ * The module has no hardware dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define TICK_COMP_OK      0
+#define TICK_COMP_ERROR  -1
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Hz;   /* Counter clock */
+  uint32_t Rem;  /* Time run but not yet given to the tick, in 1/Hz ms */
+} TICK_COMP_t;
+
+/* Exported functions --------------------------------------------------------*/
+int32_t TICK_COMP_Init(TICK_COMP_t *Comp, uint32_t Hz);
+void TICK_COMP_AddFraction(TICK_COMP_t *Comp, uint32_t Part, uint32_t Whole);
+uint32_t TICK_COMP_Ticks(const TICK_COMP_t *Comp, uint32_t Ms);
+uint32_t TICK_COMP_Elapsed(TICK_COMP_t *Comp, uint32_t Ticks, uint8_t Edge);
+uint32_t TICK_COMP_MaxMs(const TICK_COMP_t *Comp, uint32_t MaxTicks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TICK_COMP_H */
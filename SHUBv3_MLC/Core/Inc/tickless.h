@@ -0,0 +1,55 @@
+/**
+  ******************************************************************************
+  * @file    tickless.h
+  * @author  ISCA Lab
+  * @brief   Tickless idle: SysTick stopped, LPTIM1 wakeup
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef TICKLESS_H
+#define TICKLESS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * LPTIM1 counts the LSE (32768 Hz) continuously. When the scheduler has
+ * nothing to run for a while, SysTick is stopped and an LPTIM1 compare is
+ * set at the next task timer, so the core sleeps through instead of waking
+ * every millisecond. On wake, by the compare or by any other interrupt, the
+ * time slept is added to uwTick (see tick_comp.h) before the interrupts are
+ * unmasked, so HAL_GetTick is right again when their handlers run.
+ *
+ * The core stays in Sleep mode: the log DMA and TIM2 keep running.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+/* Sleeps shorter than this keep SysTick running [ms] */
+#ifndef TICKLESS_MIN_MS
+#define TICKLESS_MIN_MS  2U
+#endif
+
+#define TICKLESS_HZ      32768U
+
+/* Exported functions --------------------------------------------------------*/
+void TICKLESS_Init(void);
+void TICKLESS_Sleep(uint32_t Ms);
+void TICKLESS_IRQHandler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TICKLESS_H */
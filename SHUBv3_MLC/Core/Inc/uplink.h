@@ -0,0 +1,114 @@
+/**
+  ******************************************************************************
+  * @file    uplink.h
+  * @author  ISCA Lab
+  * @brief   Event-compressed uplink packetizer
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef UPLINK_H
+#define UPLINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * Events are queued with their time and packed into as few payloads as the
+ * latency allows. A payload goes out when an urgent event is queued, when
+ * the oldest event has waited UPLINK_MAX_LATENCY or when the queue fills a
+ * payload, and only if the duty cycle credit covers its time on air. The
+ * MLC output of each sensor is only queued when it changes.
+ *
+ * Payload, bits packed MSB first:
+ *   header  version(2) seq(6) base(24)    base: time of the first event in s
+ *   events  type(3) delta time data...    until less than 8 bits are left
+ *
+ *   delta   time since the previous event (the base for the first one) in
+ *           UPLINK_TIME_UNIT ms: '0' + 4 bits, '10' + 10 bits,
+ *           '110' + 18 bits or '111' + 32 bits
+ *   data    MLC       sensor(1) code(8)
+ *           SNAPSHOT  id(8) peak(8, in 64 mg) duration(8, in 100 ms)
+ *           HEALTH    count(3), per counter: bits(5) value(bits)
+ *
+ * The packetizer has no hardware dependency and builds on a host, the
+ * payloads go through a transport given at initialization.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#ifndef UPLINK_MAX_EVENTS
+#define UPLINK_MAX_EVENTS      16U
+#endif
+#ifndef UPLINK_TIME_UNIT
+#define UPLINK_TIME_UNIT       100U   /* ms per delta time step */
+#endif
+#ifndef UPLINK_MAX_LATENCY
+#define UPLINK_MAX_LATENCY     60000U /* ms an event may wait to be batched */
+#endif
+#ifndef UPLINK_DUTY_PERMILLE
+#define UPLINK_DUTY_PERMILLE   10U    /* 1 % duty cycle */
+#endif
+#ifndef UPLINK_MAX_CREDIT
+#define UPLINK_MAX_CREDIT      2000U  /* ms of time on air that can be saved up */
+#endif
+
+#define UPLINK_MAX_PAYLOAD     51U    /* Largest payload of the transports */
+#define UPLINK_HEALTH_MAX      4U     /* Counters per health event */
+#define UPLINK_MLC_SENSORS     2U     /* Sensor instances, 1 bit */
+
+#define UPLINK_VERSION         2U
+
+/* Event types, 1 was the FSM output of version 1 */
+#define UPLINK_EVT_MLC         0U
+#define UPLINK_EVT_SNAPSHOT    2U
+#define UPLINK_EVT_HEALTH      3U
+
+#define UPLINK_OK      0
+#define UPLINK_ERROR  -1
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t MaxPayload;                          /* Bytes, at most UPLINK_MAX_PAYLOAD */
+  uint32_t (*TimeOnAir)(uint32_t Len);          /* ms to send Len bytes */
+  int32_t (*Send)(const uint8_t *Data, uint32_t Len);
+} UPLINK_Transport_t;
+
+typedef struct
+{
+  uint32_t Events;     /* Events queued */
+  uint32_t Suppressed; /* MLC outputs not queued, unchanged */
+  uint32_t Dropped;    /* Events lost, queue full */
+  uint32_t Packets;
+  uint32_t Bytes;
+  uint32_t Airtime;    /* ms */
+  uint32_t Deferred;   /* Sends held back by the duty cycle */
+  uint32_t Failed;     /* Sends refused by the transport */
+} UPLINK_Stats_t;
+
+/* Exported functions --------------------------------------------------------*/
+void UPLINK_Init(const UPLINK_Transport_t *Transport, uint32_t Now);
+int32_t UPLINK_PostMlc(uint8_t Sensor, uint8_t Code, uint32_t Time);
+int32_t UPLINK_PostSnapshot(uint8_t Id, uint32_t PeakMg, uint32_t DurationMs, uint32_t Time);
+int32_t UPLINK_PostHealth(const uint32_t *Counters, uint32_t Count, uint32_t Time);
+void UPLINK_Process(uint32_t Now);
+uint32_t UPLINK_Pending(void);
+uint32_t UPLINK_LoraTimeOnAir(uint32_t Len, uint32_t Sf);
+void UPLINK_GetStats(UPLINK_Stats_t *Stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPLINK_H */
@@ -0,0 +1,42 @@
+/**
+  ******************************************************************************
+  * @file    uplink_uart.h
+  * @author  ISCA Lab
+  * @brief   Uplink transport stand-in over the log UART
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef UPLINK_UART_H
+#define UPLINK_UART_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "uplink.h"
+
+/* Exported defines ----------------------------------------------------------*/
+/* Radio settings the time on air is accounted for */
+#define UPLINK_UART_SF             9U     /* LoRa spreading factor */
+#define UPLINK_UART_MAX_PAYLOAD    51U    /* EU868 DR0 to DR2 */
+
+#define UPLINK_UART_PERIOD         1000U    /* ms between two packetizer runs */
+#define UPLINK_UART_HEALTH_PERIOD  3600000U /* ms between two health reports */
+
+/* Exported functions --------------------------------------------------------*/
+void UPLINK_UART_Init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* UPLINK_UART_H */
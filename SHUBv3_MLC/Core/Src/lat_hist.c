@@ -0,0 +1,168 @@
+/**
+  ******************************************************************************
+  * @file    lat_hist.c
+  * @author  ISCA Lab
+  * @brief   Log-linear latency histogram with percentile queries
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "lat_hist.h"
+
+/* Private function prototypes -----------------------------------------------*/
+static void LAT_HIST_Halve(LAT_HIST_t *Hist);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Empty a histogram
+  * @param  Hist the histogram
+  * @retval None
+  */
+void LAT_HIST_Reset(LAT_HIST_t *Hist)
+{
+  (void)memset(Hist, 0, sizeof(*Hist));
+}
+
+/**
+  * @brief  Add a sample
+  * @param  Hist the histogram
+  * @param  Value the sample
+  * @retval None
+  */
+void LAT_HIST_Add(LAT_HIST_t *Hist, uint32_t Value)
+{
+  uint32_t bin = LAT_HIST_BinOf(Value);
+
+  if (Hist->Bins[bin] == UINT16_MAX)
+  {
+    LAT_HIST_Halve(Hist);
+  }
+
+  Hist->Bins[bin]++;
+  Hist->Count++;
+
+  if (Value > Hist->Max)
+  {
+    Hist->Max = Value;
+  }
+}
+
+/**
+  * @brief  Get a percentile
+  * @note   The upper bound of the bin holding the sample of that rank, so
+  *         the result is never below the exact percentile and at most one
+  *         bin width above it. Never above the maximum.
+  * @param  Hist the histogram
+  * @param  Permille the percentile in thousandths, 500 for the median
+  * @retval The percentile, 0 for an empty histogram
+  */
+uint32_t LAT_HIST_Percentile(const LAT_HIST_t *Hist, uint32_t Permille)
+{
+  uint32_t rank;
+  uint32_t seen = 0;
+  uint32_t bin;
+  uint32_t high;
+
+  if (Hist->Count == 0U)
+  {
+    return 0;
+  }
+
+  if (Permille >= 1000U)
+  {
+    return Hist->Max;
+  }
+
+  /* Rank of the sample, 1 based, rounded up */
+  rank = (uint32_t)((((uint64_t)Hist->Count * Permille) + 999U) / 1000U);
+  if (rank == 0U)
+  {
+    rank = 1;
+  }
+
+  for (bin = 0; bin < LAT_HIST_BINS; bin++)
+  {
+    seen += Hist->Bins[bin];
+    if (seen >= rank)
+    {
+      break;
+    }
+  }
+
+  if (bin >= (LAT_HIST_BINS - 1U))
+  {
+    return Hist->Max;
+  }
+
+  high = LAT_HIST_BinHigh(bin);
+  return (high < Hist->Max) ? high : Hist->Max;
+}
+
+/**
+  * @brief  Get the bin of a value
+  * @param  Value the value
+  * @retval The bin index, the last bin for values out of range
+  */
+uint32_t LAT_HIST_BinOf(uint32_t Value)
+{
+  uint32_t msb;
+  uint32_t bin;
+
+  if (Value < LAT_HIST_SUB_BINS)
+  {
+    return Value;
+  }
+
+  msb = 31U - (uint32_t)__builtin_clz(Value);
+  bin = ((msb - (LAT_HIST_SUB_BITS - 1U)) * LAT_HIST_SUB_BINS)
+        + ((Value >> (msb - LAT_HIST_SUB_BITS)) & (LAT_HIST_SUB_BINS - 1U));
+
+  return (bin < LAT_HIST_BINS) ? bin : (LAT_HIST_BINS - 1U);
+}
+
+/**
+  * @brief  Get the largest value of a bin
+  * @param  Bin the bin index
+  * @retval The largest value that falls in the bin
+  */
+uint32_t LAT_HIST_BinHigh(uint32_t Bin)
+{
+  uint32_t shift;
+  uint32_t low;
+
+  if (Bin < LAT_HIST_SUB_BINS)
+  {
+    return Bin;
+  }
+
+  shift = (Bin / LAT_HIST_SUB_BINS) - 1U;
+  low = (LAT_HIST_SUB_BINS + (Bin % LAT_HIST_SUB_BINS)) << shift;
+
+  return low + ((1UL << shift) - 1U);
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Halve every bin, called before one overflows
+  * @param  Hist the histogram
+  * @retval None
+  */
+static void LAT_HIST_Halve(LAT_HIST_t *Hist)
+{
+  uint32_t bin;
+
+  Hist->Count = 0;
+  for (bin = 0; bin < LAT_HIST_BINS; bin++)
+  {
+    Hist->Bins[bin] = (uint16_t)(Hist->Bins[bin] / 2U);
+    Hist->Count += Hist->Bins[bin];
+  }
+}
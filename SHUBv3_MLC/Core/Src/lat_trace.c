@@ -0,0 +1,384 @@
+/**
+  ******************************************************************************
+  * @file    lat_trace.c
+  * @author  ISCA Lab
+  * @brief   MLC alarm latency tracing, from the INT1 line to the last UART byte
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "main.h"
+#include "lat_trace.h"
+#include "log_sink.h"
+#include "mem_placement.h"
+#include "task_sched.h"
+
+/* Private define ------------------------------------------------------------*/
+#define LAT_TRACE_LINE_MAX  96U
+#define LAT_TRACE_CMD_MAX   16U
+
+/* Trace states */
+#define LAT_TRACE_IDLE    0U
+#define LAT_TRACE_OPEN    1U  /* Stamps being taken */
+#define LAT_TRACE_QUEUED  2U  /* Report on the log, waiting for the UART */
+#define LAT_TRACE_SENT    3U  /* Last byte sent, to be added to the histograms */
+
+_Static_assert(MEM_BUDGET_LAT_TRACE_SIZE >= (LAT_TRACE_PIPES * LAT_TRACE_SEGMENTS * sizeof(LAT_HIST_t)),
+               "latency histograms over budget");
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Stamp[LAT_TRACE_POINTS];
+  uint32_t Mark;            /* Log position after the report line */
+  volatile uint32_t Done;   /* Time the last byte was sent */
+  volatile uint8_t State;
+  uint8_t HasEdge;
+  uint32_t Events;
+  uint32_t Lost;            /* Reports overtaken by the next event before sent */
+} LAT_TRACE_Pipe_t;
+
+/* Private variables ---------------------------------------------------------*/
+static LAT_TRACE_Pipe_t LatPipes[LAT_TRACE_PIPES];
+static LAT_HIST_t (*LatHist)[LAT_TRACE_SEGMENTS];
+static volatile uint32_t LatSent;  /* Last log position reported sent */
+static uint32_t LatTimerHz;
+static uint32_t LatTaskId;
+static char LatCmd[LAT_TRACE_CMD_MAX];
+static uint32_t LatCmdLen;
+
+static const char *const LatSegNames[LAT_TRACE_SEGMENTS] =
+{
+  "wait", "read", "format", "tx", "total"
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void LAT_TRACE_Task(uint32_t Events);
+static void LAT_TRACE_Collect(LAT_TRACE_Pipe_t *Trace, uint32_t Pipe);
+static uint32_t LAT_TRACE_ToUs(uint32_t Ticks);
+static void LAT_TRACE_Command(void);
+static void LAT_TRACE_Print(void);
+
+static const TASK_SCHED_Def_t LatTaskDef =
+{
+  "lat", LAT_TRACE_Task, TASK_SCHED_PRIO_LOW, LAT_TRACE_PERIOD, 0U
+};
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Start the tracing
+  * @note   TIM2 must be running, see MX_TIM2_Init.
+  * @retval None
+  */
+void LAT_TRACE_Init(void)
+{
+  LatHist = (LAT_HIST_t (*)[LAT_TRACE_SEGMENTS])MEM_BUDGET_ALLOC(LAT_TRACE);
+
+  /* TIM2 runs on PCLK1, twice PCLK1 when APB1 is divided */
+  LatTimerHz = HAL_RCC_GetPCLK1Freq();
+  if ((RCC->CFGR & RCC_CFGR_PPRE1_2) != 0U)
+  {
+    LatTimerHz *= 2U;
+  }
+
+  LAT_TRACE_Reset();
+
+  if (TASK_SCHED_Register(&LatTaskDef, &LatTaskId) != TASK_SCHED_OK)
+  {
+    Error_Handler();
+  }
+}
+
+/**
+  * @brief  Get the trace time
+  * @retval TIM2 counter
+  */
+RAM_FUNC uint32_t LAT_TRACE_Now(void)
+{
+  return TIM2->CNT;
+}
+
+/**
+  * @brief  Stamp a point of a pipeline
+  * @note   LAT_TRACE_EDGE keeps the first stamp until the trace ends, the
+  *         other points take the last one. A point before the edge starts a
+  *         trace without wait segment.
+  * @param  Pipe the pipeline, the sensor instance
+  * @param  Point LAT_TRACE_EDGE to LAT_TRACE_FORMAT
+  * @retval None
+  */
+void LAT_TRACE_Stamp(uint32_t Pipe, uint32_t Point)
+{
+  LAT_TRACE_Pipe_t *trace;
+  uint32_t now = LAT_TRACE_Now();
+
+  if ((LatHist == NULL) || (Pipe >= LAT_TRACE_PIPES) || (Point >= LAT_TRACE_POINTS))
+  {
+    return;
+  }
+
+  trace = &LatPipes[Pipe];
+
+  /* A report still waiting for the UART is overtaken by the new event */
+  LAT_TRACE_Collect(trace, Pipe);
+  if (trace->State == LAT_TRACE_QUEUED)
+  {
+    trace->State = LAT_TRACE_IDLE;
+    trace->Lost++;
+  }
+
+  if (trace->State == LAT_TRACE_IDLE)
+  {
+    trace->HasEdge = (Point == LAT_TRACE_EDGE) ? 1U : 0U;
+    trace->Stamp[LAT_TRACE_EDGE] = now;
+    trace->State = LAT_TRACE_OPEN;
+  }
+
+  if (Point != LAT_TRACE_EDGE)
+  {
+    trace->Stamp[Point] = now;
+  }
+}
+
+/**
+  * @brief  Wait for the report line of a pipeline to leave the UART
+  * @param  Pipe the pipeline
+  * @param  Mark the log position after the last byte of the line, see
+  *         LOG_SINK_Position
+  * @retval None
+  */
+void LAT_TRACE_Queue(uint32_t Pipe, uint32_t Mark)
+{
+  LAT_TRACE_Pipe_t *trace;
+  uint32_t primask;
+
+  if ((LatHist == NULL) || (Pipe >= LAT_TRACE_PIPES) || (LatPipes[Pipe].State != LAT_TRACE_OPEN))
+  {
+    return;
+  }
+
+  trace = &LatPipes[Pipe];
+  trace->Mark = Mark;
+
+  /* The UART interrupt may already have gone past the mark */
+  primask = __get_PRIMASK();
+  __disable_irq();
+  if ((int32_t)(LatSent - Mark) >= 0)
+  {
+    trace->Done = LAT_TRACE_Now();
+    trace->State = LAT_TRACE_SENT;
+  }
+  else
+  {
+    trace->State = LAT_TRACE_QUEUED;
+  }
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Drop the trace of a pipeline
+  * @note   Called when the line was high but the MLC had no new output, or
+  *         when the report could not be queued.
+  * @param  Pipe the pipeline
+  * @retval None
+  */
+void LAT_TRACE_Abort(uint32_t Pipe)
+{
+  if ((Pipe < LAT_TRACE_PIPES) && (LatPipes[Pipe].State == LAT_TRACE_OPEN))
+  {
+    LatPipes[Pipe].State = LAT_TRACE_IDLE;
+  }
+}
+
+/**
+  * @brief  Report the log data sent so far, from the UART Tx complete
+  *         interrupt
+  * @param  Position the log position after the last byte sent
+  * @retval None
+  */
+RAM_FUNC void LAT_TRACE_Sent(uint32_t Position)
+{
+  uint32_t now = LAT_TRACE_Now();
+  uint32_t pipe;
+
+  LatSent = Position;
+
+  for (pipe = 0; pipe < LAT_TRACE_PIPES; pipe++)
+  {
+    if ((LatPipes[pipe].State == LAT_TRACE_QUEUED) && ((int32_t)(Position - LatPipes[pipe].Mark) >= 0))
+    {
+      LatPipes[pipe].Done = now;
+      LatPipes[pipe].State = LAT_TRACE_SENT;
+    }
+  }
+}
+
+/**
+  * @brief  Get the histogram of a segment
+  * @param  Pipe the pipeline
+  * @param  Segment LAT_TRACE_SEG_WAIT to LAT_TRACE_SEG_TOTAL
+  * @retval The histogram, NULL if out of range or not started
+  */
+const LAT_HIST_t *LAT_TRACE_GetHist(uint32_t Pipe, uint32_t Segment)
+{
+  if ((LatHist == NULL) || (Pipe >= LAT_TRACE_PIPES) || (Segment >= LAT_TRACE_SEGMENTS))
+  {
+    return NULL;
+  }
+
+  return &LatHist[Pipe][Segment];
+}
+
+/**
+  * @brief  Clear the histograms and counters
+  * @retval None
+  */
+void LAT_TRACE_Reset(void)
+{
+  uint32_t pipe;
+  uint32_t seg;
+
+  for (pipe = 0; pipe < LAT_TRACE_PIPES; pipe++)
+  {
+    for (seg = 0; seg < LAT_TRACE_SEGMENTS; seg++)
+    {
+      LAT_HIST_Reset(&LatHist[pipe][seg]);
+    }
+    LatPipes[pipe].Events = 0;
+    LatPipes[pipe].Lost = 0;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Trace task: adds the sent reports and reads the terminal
+  * @param  Events the scheduler events
+  * @retval None
+  */
+static void LAT_TRACE_Task(uint32_t Events)
+{
+  uint32_t pipe;
+  uint8_t c;
+
+  (void)Events;
+
+  for (pipe = 0; pipe < LAT_TRACE_PIPES; pipe++)
+  {
+    LAT_TRACE_Collect(&LatPipes[pipe], pipe);
+  }
+
+  while (LOG_SINK_Read(&c, 1) == 1U)
+  {
+    if ((c == '\r') || (c == '\n'))
+    {
+      LatCmd[LatCmdLen] = '\0';
+      LAT_TRACE_Command();
+      LatCmdLen = 0;
+    }
+    else if (LatCmdLen < (LAT_TRACE_CMD_MAX - 1U))
+    {
+      LatCmd[LatCmdLen++] = (char)c;
+    }
+  }
+}
+
+/**
+  * @brief  Add a sent report to the histograms of its pipeline
+  * @param  Trace the trace of the pipeline
+  * @param  Pipe the pipeline
+  * @retval None
+  */
+static void LAT_TRACE_Collect(LAT_TRACE_Pipe_t *Trace, uint32_t Pipe)
+{
+  LAT_HIST_t *hist = LatHist[Pipe];
+  const uint32_t *t = Trace->Stamp;
+  uint32_t start;
+
+  if (Trace->State != LAT_TRACE_SENT)
+  {
+    return;
+  }
+
+  if (Trace->HasEdge != 0U)
+  {
+    LAT_HIST_Add(&hist[LAT_TRACE_SEG_WAIT], LAT_TRACE_ToUs(t[LAT_TRACE_READ_START] - t[LAT_TRACE_EDGE]));
+    start = t[LAT_TRACE_EDGE];
+  }
+  else
+  {
+    start = t[LAT_TRACE_READ_START];
+  }
+
+  LAT_HIST_Add(&hist[LAT_TRACE_SEG_READ], LAT_TRACE_ToUs(t[LAT_TRACE_READ_END] - t[LAT_TRACE_READ_START]));
+  LAT_HIST_Add(&hist[LAT_TRACE_SEG_FORMAT], LAT_TRACE_ToUs(t[LAT_TRACE_FORMAT] - t[LAT_TRACE_READ_END]));
+  LAT_HIST_Add(&hist[LAT_TRACE_SEG_TX], LAT_TRACE_ToUs(Trace->Done - t[LAT_TRACE_FORMAT]));
+  LAT_HIST_Add(&hist[LAT_TRACE_SEG_TOTAL], LAT_TRACE_ToUs(Trace->Done - start));
+
+  Trace->Events++;
+  Trace->State = LAT_TRACE_IDLE;
+}
+
+/**
+  * @brief  Convert TIM2 ticks to microseconds
+  * @param  Ticks the time in TIM2 ticks
+  * @retval The time in us
+  */
+static uint32_t LAT_TRACE_ToUs(uint32_t Ticks)
+{
+  return (uint32_t)(((uint64_t)Ticks * 1000000U) / LatTimerHz);
+}
+
+/**
+  * @brief  Run a terminal command line
+  * @retval None
+  */
+static void LAT_TRACE_Command(void)
+{
+  if (strcmp(LatCmd, "lat") == 0)
+  {
+    LAT_TRACE_Print();
+  }
+  else if (strcmp(LatCmd, "lat reset") == 0)
+  {
+    LAT_TRACE_Reset();
+  }
+}
+
+/**
+  * @brief  Print the percentiles of each segment on the log
+  * @retval None
+  */
+static void LAT_TRACE_Print(void)
+{
+  char line[LAT_TRACE_LINE_MAX];
+  const LAT_HIST_t *hist;
+  uint32_t pipe;
+  uint32_t seg;
+  int len;
+
+  for (pipe = 0; pipe < LAT_TRACE_PIPES; pipe++)
+  {
+    len = snprintf(line, sizeof(line), "lat %lu: %lu events, %lu lost, us\r\n", (unsigned long)pipe,
+                   (unsigned long)LatPipes[pipe].Events, (unsigned long)LatPipes[pipe].Lost);
+    (void)LOG_SINK_Write((const uint8_t *)line, (uint32_t)len);
+
+    for (seg = 0; seg < LAT_TRACE_SEGMENTS; seg++)
+    {
+      hist = &LatHist[pipe][seg];
+      len = snprintf(line, sizeof(line), "lat %lu: %-6s n %6lu p50 %7lu p90 %7lu p99 %7lu max %7lu\r\n",
+                     (unsigned long)pipe, LatSegNames[seg], (unsigned long)hist->Count,
+                     (unsigned long)LAT_HIST_Percentile(hist, 500U), (unsigned long)LAT_HIST_Percentile(hist, 900U),
+                     (unsigned long)LAT_HIST_Percentile(hist, 990U), (unsigned long)hist->Max);
+      (void)LOG_SINK_Write((const uint8_t *)line, (uint32_t)len);
+    }
+  }
+}
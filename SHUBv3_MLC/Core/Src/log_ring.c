@@ -0,0 +1,158 @@
+/**
+  ******************************************************************************
+  * @file    log_ring.c
+  * @author  ISCA Lab
+  * @brief   Lock-free single producer / single consumer byte ring
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "log_ring.h"
+#include "mem_placement.h"
+
+/* Private macro -------------------------------------------------------------*/
+/* Index publication. On the Cortex-M4 these compile to plain loads/stores
+ * plus a DMB, on the host they give the same ordering between threads. */
+#define LOAD_ACQUIRE(x)      __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(x, v)  __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize a ring over a caller provided buffer
+  * @param  Ring the ring
+  * @param  Buffer the storage
+  * @param  Size the storage size, must be a power of two
+  * @retval LOG_RING_OK in case of success, LOG_RING_ERROR otherwise
+  */
+int32_t LOG_RING_Init(LOG_RING_t *Ring, uint8_t *Buffer, uint32_t Size)
+{
+  if ((Ring == NULL) || (Buffer == NULL) || (Size == 0U) || ((Size & (Size - 1U)) != 0U))
+  {
+    return LOG_RING_ERROR;
+  }
+
+  Ring->Buffer = Buffer;
+  Ring->Size = Size;
+  Ring->Head = 0;
+  Ring->Tail = 0;
+  Ring->Written = 0;
+  Ring->Dropped = 0;
+  Ring->Overflows = 0;
+  Ring->HighWater = 0;
+
+  return LOG_RING_OK;
+}
+
+/**
+  * @brief  Append data to the ring (producer side)
+  * @note   A write that does not fit is dropped as a whole and accounted in
+  *         the drop counters, so a full ring never leaves half a log line.
+  * @param  Ring the ring
+  * @param  Data the data to append
+  * @param  Len the data length
+  * @retval LOG_RING_OK if the data was queued, LOG_RING_ERROR if dropped
+  */
+RAM_FUNC int32_t LOG_RING_Write(LOG_RING_t *Ring, const uint8_t *Data, uint32_t Len)
+{
+  uint32_t head = Ring->Head;
+  uint32_t tail = LOAD_ACQUIRE(Ring->Tail);
+  uint32_t used = head - tail;
+  uint32_t offset;
+  uint32_t first;
+
+  if (Len > (Ring->Size - used))
+  {
+    Ring->Dropped += Len;
+    Ring->Overflows++;
+    return LOG_RING_ERROR;
+  }
+
+  offset = head & (Ring->Size - 1U);
+  first = Ring->Size - offset;
+  if (first > Len)
+  {
+    first = Len;
+  }
+
+  (void)memcpy(&Ring->Buffer[offset], Data, first);
+  (void)memcpy(&Ring->Buffer[0], &Data[first], Len - first);
+
+  STORE_RELEASE(Ring->Head, head + Len);
+
+  Ring->Written += Len;
+  used += Len;
+  if (used > Ring->HighWater)
+  {
+    Ring->HighWater = used;
+  }
+
+  return LOG_RING_OK;
+}
+
+/**
+  * @brief  Get the oldest contiguous block of pending data (consumer side)
+  * @note   At most one call to LOG_RING_Release per block, the block may be
+  *         shorter than LOG_RING_Used when the data wraps around.
+  * @param  Ring the ring
+  * @param  Data set to the start of the block
+  * @retval Length of the block, 0 if the ring is empty
+  */
+RAM_FUNC uint32_t LOG_RING_Peek(LOG_RING_t *Ring, uint8_t **Data)
+{
+  uint32_t tail = Ring->Tail;
+  uint32_t head = LOAD_ACQUIRE(Ring->Head);
+  uint32_t offset = tail & (Ring->Size - 1U);
+  uint32_t len = head - tail;
+
+  if (len > (Ring->Size - offset))
+  {
+    len = Ring->Size - offset;
+  }
+
+  *Data = &Ring->Buffer[offset];
+  return len;
+}
+
+/**
+  * @brief  Release data returned by LOG_RING_Peek (consumer side)
+  * @param  Ring the ring
+  * @param  Len the number of bytes consumed
+  * @retval None
+  */
+RAM_FUNC void LOG_RING_Release(LOG_RING_t *Ring, uint32_t Len)
+{
+  STORE_RELEASE(Ring->Tail, Ring->Tail + Len);
+}
+
+/**
+  * @brief  Get the number of pending bytes
+  * @param  Ring the ring
+  * @retval Pending bytes
+  */
+uint32_t LOG_RING_Used(const LOG_RING_t *Ring)
+{
+  return LOAD_ACQUIRE(Ring->Head) - LOAD_ACQUIRE(Ring->Tail);
+}
+
+/**
+  * @brief  Get a snapshot of the ring counters
+  * @param  Ring the ring
+  * @param  Stats the counters
+  * @retval None
+  */
+void LOG_RING_GetStats(const LOG_RING_t *Ring, LOG_RING_Stats_t *Stats)
+{
+  Stats->Written = Ring->Written;
+  Stats->Dropped = Ring->Dropped;
+  Stats->Overflows = Ring->Overflows;
+  Stats->HighWater = Ring->HighWater;
+  Stats->Used = LOG_RING_Used(Ring);
+}
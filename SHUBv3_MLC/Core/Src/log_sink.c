@@ -0,0 +1,307 @@
+/**
+  ******************************************************************************
+  * @file    log_sink.c
+  * @author  ISCA Lab
+  * @brief   Buffered log output drained by LPUART1 TX DMA
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "stm32wlxx_nucleo.h"
+#include "log_sink.h"
+#include "lat_trace.h"
+#include "mem_budget.h"
+#include "mem_placement.h"
+
+/* Private define ------------------------------------------------------------*/
+#define LOG_SINK_UART  hcom_uart[COM1]
+#define LOG_SINK_BLOCKING_TIMEOUT  1000U /* ms per block of a blocking write */
+
+/* Private variables ---------------------------------------------------------*/
+static LOG_RING_t LogRing;
+static volatile uint8_t LogReady = 0;
+static volatile uint32_t LogInFlight = 0; /* Bytes handed to the DMA, 0 when idle */
+static uint8_t LogRx[LOG_SINK_RX_SIZE];
+static uint32_t LogRxTail;
+static uint32_t LogEarlyDropped = 0; /* Blocking writes lost before the ring exists */
+
+/* Private function prototypes -----------------------------------------------*/
+static void LOG_SINK_Kick(void);
+static void LOG_SINK_StartRx(void);
+static void LOG_SINK_Drop(uint32_t Len);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize the log sink
+  * @note   LPUART1 must already be initialized (BSP_COM_Init). Calling it
+  *         again keeps the pending data and restarts the reception.
+  * @retval None
+  */
+void LOG_SINK_Init(void)
+{
+  if (LogReady == 0U)
+  {
+    (void)LOG_RING_Init(&LogRing, (uint8_t *)MEM_BUDGET_ALLOC(LOG_RING), LOG_SINK_BUFFER_SIZE);
+    LogRing.Dropped = LogEarlyDropped;
+    LogInFlight = 0;
+    LogReady = 1;
+  }
+
+  LOG_SINK_StartRx();
+}
+
+/**
+  * @brief  Queue data for transmission
+  * @note   Returns immediately, the data is sent by DMA in the background.
+  *         Not usable before LOG_SINK_Init or from fault handlers, where the
+  *         DMA interrupt can no longer run: the caller then falls back to
+  *         LOG_SINK_WriteBlocking. Peripheral interrupts may log, the ring
+  *         write is done with interrupts masked so the ring keeps a single
+  *         producer at a time.
+  * @param  Data the data to send
+  * @param  Len the data length
+  * @retval LOG_SINK_OK if queued (or dropped on overflow), LOG_SINK_ERROR if
+  *         the sink cannot be used
+  */
+int32_t LOG_SINK_Write(const uint8_t *Data, uint32_t Len)
+{
+  uint32_t ipsr = __get_IPSR();
+  uint32_t primask;
+
+  /* Exception numbers below 16 are the Cortex-M system exceptions */
+  if ((LogReady == 0U) || ((ipsr != 0U) && (ipsr < 16U)))
+  {
+    return LOG_SINK_ERROR;
+  }
+
+  /* Overflows are counted by the ring, logging never blocks the caller */
+  primask = __get_PRIMASK();
+  __disable_irq();
+  (void)LOG_RING_Write(&LogRing, Data, Len);
+  __set_PRIMASK(primask);
+
+  LOG_SINK_Kick();
+
+  return LOG_SINK_OK;
+}
+
+/**
+  * @brief  Send data with a blocking transmit, where LOG_SINK_Write cannot
+  *         be used (before LOG_SINK_Init, fault handlers)
+  * @note   In a fault handler the DMA interrupt no longer runs and the block
+  *         on the line never completes: it is aborted and accounted as
+  *         dropped so the fault report gets out. Data the UART does not take
+  *         is accounted as dropped too.
+  * @param  Data the data to send
+  * @param  Len the data length
+  * @retval None
+  */
+void LOG_SINK_WriteBlocking(const uint8_t *Data, uint32_t Len)
+{
+  uint32_t n;
+
+  if (LogInFlight != 0U)
+  {
+    (void)HAL_UART_AbortTransmit(&LOG_SINK_UART);
+    LogRing.Dropped += LogInFlight;
+    LOG_RING_Release(&LogRing, LogInFlight);
+    LogInFlight = 0;
+  }
+
+  while (Len != 0U)
+  {
+    n = (Len > 0xFFFFU) ? 0xFFFFU : Len;
+    if (HAL_UART_Transmit(&LOG_SINK_UART, (uint8_t *)Data, (uint16_t)n, LOG_SINK_BLOCKING_TIMEOUT) != HAL_OK)
+    {
+      LOG_SINK_Drop(Len);
+      return;
+    }
+    Data += n;
+    Len -= n;
+  }
+}
+
+/**
+  * @brief  Wait until all pending data has been sent
+  * @param  Timeout the maximum wait in ms
+  * @retval None
+  */
+void LOG_SINK_Flush(uint32_t Timeout)
+{
+  uint32_t tickstart = HAL_GetTick();
+
+  if (LogReady == 0U)
+  {
+    return;
+  }
+
+  while (((LOG_RING_Used(&LogRing) != 0U) || (LogInFlight != 0U)) && ((HAL_GetTick() - tickstart) < Timeout))
+  {
+    LOG_SINK_Kick();
+  }
+}
+
+/**
+  * @brief  Get the sink counters
+  * @param  Stats the counters
+  * @retval None
+  */
+void LOG_SINK_GetStats(LOG_RING_Stats_t *Stats)
+{
+  LOG_RING_GetStats(&LogRing, Stats);
+}
+
+/**
+  * @brief  Get the log position after the last byte queued
+  * @note   Positions count the bytes accepted since the initialization and
+  *         wrap around at 2^32. A write moves it by its length unless it was
+  *         dropped.
+  * @retval The log position
+  */
+uint32_t LOG_SINK_Position(void)
+{
+  return LogRing.Head;
+}
+
+/**
+  * @brief  Read the terminal input received so far
+  * @note   Input older than LOG_SINK_RX_SIZE bytes is overwritten.
+  * @param  Data the destination
+  * @param  Len the destination size
+  * @retval Number of bytes read
+  */
+uint32_t LOG_SINK_Read(uint8_t *Data, uint32_t Len)
+{
+  uint32_t head;
+  uint32_t n = 0;
+
+  if ((LogReady == 0U) || (LOG_SINK_UART.RxState != HAL_UART_STATE_BUSY_RX))
+  {
+    return 0;
+  }
+
+  /* The DMA counts down the bytes left before it wraps */
+  head = LOG_SINK_RX_SIZE - __HAL_DMA_GET_COUNTER(LOG_SINK_UART.hdmarx);
+  if (head >= LOG_SINK_RX_SIZE)
+  {
+    head = 0;
+  }
+
+  while ((LogRxTail != head) && (n < Len))
+  {
+    Data[n++] = LogRx[LogRxTail];
+    LogRxTail = (LogRxTail + 1U) % LOG_SINK_RX_SIZE;
+  }
+
+  return n;
+}
+
+/**
+  * @brief  Tx Transfer completed callback
+  * @param  huart UART handle
+  * @retval None
+  */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if (huart->Instance == LOG_SINK_UART.Instance)
+  {
+    LOG_RING_Release(&LogRing, LogInFlight);
+    LogInFlight = 0;
+    LAT_TRACE_Sent(LogRing.Tail);
+    LOG_SINK_Kick();
+  }
+}
+
+/**
+  * @brief  UART error callback
+  * @param  huart UART handle
+  * @retval None
+  */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  if ((huart->Instance == LOG_SINK_UART.Instance) && (LogInFlight != 0U) && (huart->gState == HAL_UART_STATE_READY))
+  {
+    /* The block is lost, account it and go on with the next one */
+    LogRing.Dropped += LogInFlight;
+    LOG_RING_Release(&LogRing, LogInFlight);
+    LogInFlight = 0;
+    LOG_SINK_Kick();
+  }
+
+  /* An overrun stops the reception, start it again */
+  if ((huart->Instance == LOG_SINK_UART.Instance) && (huart->RxState == HAL_UART_STATE_READY))
+  {
+    LOG_SINK_StartRx();
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Start a DMA transfer of the oldest pending block if the line is idle
+  * @note   Called from thread mode and from the UART interrupt, the check and
+  *         start are done with interrupts masked.
+  * @retval None
+  */
+RAM_FUNC static void LOG_SINK_Kick(void)
+{
+  uint8_t *data;
+  uint32_t len;
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+
+  if (LogInFlight == 0U)
+  {
+    len = LOG_RING_Peek(&LogRing, &data);
+    if (len > 0xFFFFU)
+    {
+      len = 0xFFFFU;
+    }
+
+    if (len != 0U)
+    {
+      if (HAL_UART_Transmit_DMA(&LOG_SINK_UART, data, (uint16_t)len) == HAL_OK)
+      {
+        LogInFlight = len;
+      }
+    }
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Account data that could not be sent
+  * @param  Len the data length
+  * @retval None
+  */
+static void LOG_SINK_Drop(uint32_t Len)
+{
+  if (LogReady == 0U)
+  {
+    LogEarlyDropped += Len;
+  }
+  else
+  {
+    LogRing.Dropped += Len;
+    LogRing.Overflows++;
+  }
+}
+
+/**
+  * @brief  Start the circular reception of the terminal input
+  * @retval None
+  */
+static void LOG_SINK_StartRx(void)
+{
+  LogRxTail = 0;
+  (void)HAL_UART_Receive_DMA(&LOG_SINK_UART, LogRx, LOG_SINK_RX_SIZE);
+}
@@ -65,18 +65,193 @@
 
 #include "main.h"
 #include "app_mems.h"
+#include "log_sink.h"
+#include "mem_budget.h"
+#include "task_sched.h"
+#include "lsm6dsox_mlc.h"
+#include "mlc_snapshot.h"
+#include "lat_trace.h"
+#include "mems_fixed.h"
+#include "uplink.h"
+#include "startup_seq.h"
+#include "sensor_plan.h"
+#include "custom_motion_sensors.h"
+#include "custom_motion_sensors_ex.h"
 
 
 /* Private macro -------------------------------------------------------------*/
-#define    BOOT_TIME            10 //ms
-#define    SENSOR_BUS			hi2c2
 #define    PWM_3V3   			915
+#define    MLC_POLL_PERIOD      10 //ms, the MLC runs at up to 104 Hz
+#define    MLC_INSTANCES        CUSTOM_MOTION_INSTANCES_NBR
+
+/* Accelerometer self-test (AN5272): 52 Hz, 4 g, five samples averaged with
+ * and without the positive stimulus, the difference must be in range */
+#define    ST_SETTLE            100 //ms after an ODR or stimulus change
+#define    ST_SAMPLE_PERIOD     20 //ms, one new sample at 52 Hz
+#define    ST_SAMPLES           5
+#define    ST_MIN_MG            50
+#define    ST_MAX_MG            1700
+
+/* Event capture: the sensor FIFO runs continuously, its depth limited by the
+ * watermark, so it always holds the last SNAP_PRE_WORDS words. On an MLC
+ * event the depth is raised to the whole snapshot, the FIFO keeps filling
+ * for SNAP_POST_MS, then batching stops and the FIFO is drained. */
+#define    SNAP_ODR             26 //Hz, FIFO batching rate
+#define    SNAP_ACC_FS          4 //g, set by lsm6dsox_mlc_config
+#define    SNAP_MAX_WORDS       (MEM_BUDGET_SNAP_WORDS_SIZE / MEM_BUDGET_SNAP_SENSORS / sizeof(MLC_SNAP_Word_t))
+#define    SNAP_PRE_WORDS       156 //3 s of acc + gyro, 6 s of acc alone
+#define    SNAP_POST_MS         1000 //ms
+#define    SNAP_LINE_BYTES      48 //snapshot bytes per output line
+#define    SNAP_LINE_MAX        (32 + MLC_SNAP_BASE64_SIZE(SNAP_LINE_BYTES))
+
+/* FIFO drain: the words are read in bursts, the address rolls back from
+ * FIFO_DATA_OUT_Z_H to FIFO_DATA_OUT_TAG. The sensors being drained take
+ * turns burst by burst and the bus is given back between bursts, so the
+ * other clients get in and no sensor waits for a whole FIFO of another. */
+#define    SNAP_BURST_WORDS     16
+#define    SNAP_DRAIN_SLICE     5 //ms of draining per task run
+
+/* Sensor configuration: the MLC program, the snapshot FIFO and the terminal
+ * each state what they need of a sensor, sensor_plan takes the lowest power
+ * rates and modes meeting all of them. The MLC needs are read from the UCF. */
+#define    TERM_ODR             125 //0.1 Hz, lowest rate, the terminal prints once a second
+
+_Static_assert(SNAP_PRE_WORDS < SNAP_MAX_WORDS, "no room for post-trigger data");
+_Static_assert(SNAP_MAX_WORDS <= 511, "FIFO watermark is 9 bits");
+_Static_assert(MEM_BUDGET_SNAP_OUT_SIZE >= MLC_SNAP_ENCODED_MAX(SNAP_MAX_WORDS), "snapshot output buffer too small");
+_Static_assert(MEM_BUDGET_MLC_TX_SIZE >= SNAP_LINE_MAX, "report buffer too small for a snapshot line");
+_Static_assert(MEM_BUDGET_SNAP_SENSORS == MLC_INSTANCES, "one snapshot buffer per sensor instance");
+_Static_assert(LAT_TRACE_PIPES >= MLC_INSTANCES, "one latency pipeline per sensor instance");
+_Static_assert(UPLINK_MLC_SENSORS >= MLC_INSTANCES, "uplink sensor field too narrow");
+
+/* Private types -------------------------------------------------------------*/
+typedef enum {
+  SNAP_IDLE = 0,
+  SNAP_ARMED,
+  SNAP_TRIGGER,
+  SNAP_POST,
+  SNAP_DRAIN,
+  SNAP_READY,
+  SNAP_SEND,
+} snap_state_t;
+
+/* Fixed set up of a sensor instance */
+typedef struct {
+  uint32_t instance;            //CUSTOM_LSM6DSOX_x
+  uint16_t address;             //I2C address until the probe has run
+  const ucf_line_t *ucf;
+  uint32_t ucf_lines;
+  GPIO_TypeDef *int_port;       //MLC interrupt line, NULL to poll
+  uint16_t int_pin;
+} mlc_dev_def_t;
+
+/* Run time state of a sensor instance */
+typedef struct {
+  stmdev_ctx_t ctx;
+  const mlc_dev_def_t *def;
+  uint8_t whoami, rst;
+  int32_t st_sum[2][3];
+  snap_state_t snap_state;
+  MLC_SNAP_t snap;
+  uint8_t snap_code;
+  uint16_t snap_pre;
+  uint16_t snap_level, snap_read;
+  uint32_t snap_tick;
+  uint32_t snap_id;
+  SENSOR_PLAN_t plan;
+} mlc_dev_t;
 
 /* Private variables ---------------------------------------------------------*/
-static uint8_t whoamI, rst;
-static uint8_t tx_buffer[1000];
+#define MLC_UCF(ucf)    ucf, (sizeof(ucf) / sizeof(ucf_line_t))
+
+static const mlc_dev_def_t mlc_dev_def[MLC_INSTANCES] = {
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1)
+  {
+    CUSTOM_LSM6DSOX_0, LSM6DSOX_I2C_ADD_L, MLC_UCF(LSM6DSOX_MLC_0_UCF),
+#ifdef LSM6DSOX_MLC_0_INT_PORT
+    LSM6DSOX_MLC_0_INT_PORT, LSM6DSOX_MLC_0_INT_PIN
+#else
+    NULL, 0
+#endif
+  },
+#endif
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
+  {
+    CUSTOM_LSM6DSOX_1, LSM6DSOX_I2C_ADD_H, MLC_UCF(LSM6DSOX_MLC_1_UCF),
+#ifdef LSM6DSOX_MLC_1_INT_PORT
+    LSM6DSOX_MLC_1_INT_PORT, LSM6DSOX_MLC_1_INT_PIN
+#else
+    NULL, 0
+#endif
+  },
+#endif
+};
+
+static mlc_dev_t mlc_dev[MLC_INSTANCES];
+static uint8_t *tx_buffer;
+static uint32_t MlcTaskId;
+
+static uint8_t *snap_out;
+static mlc_dev_t *snap_out_dev; //instance whose snapshot is in snap_out
+static uint32_t snap_len, snap_sent, snap_count;
+
+/* Driver values of the sensor_plan rate ladder, 1.6 Hz is accelerometer
+ * only and the MLC runs from 12.5 Hz to 104 Hz */
+static const lsm6dsox_odr_xl_t plan_xl_odr[SENSOR_PLAN_RATES] = {
+  LSM6DSOX_XL_ODR_OFF, LSM6DSOX_XL_ODR_1Hz6, LSM6DSOX_XL_ODR_12Hz5,
+  LSM6DSOX_XL_ODR_26Hz, LSM6DSOX_XL_ODR_52Hz, LSM6DSOX_XL_ODR_104Hz,
+  LSM6DSOX_XL_ODR_208Hz, LSM6DSOX_XL_ODR_417Hz, LSM6DSOX_XL_ODR_833Hz,
+  LSM6DSOX_XL_ODR_1667Hz, LSM6DSOX_XL_ODR_3333Hz, LSM6DSOX_XL_ODR_6667Hz
+};
+static const lsm6dsox_odr_g_t plan_gy_odr[SENSOR_PLAN_RATES] = {
+  LSM6DSOX_GY_ODR_OFF, LSM6DSOX_GY_ODR_OFF, LSM6DSOX_GY_ODR_12Hz5,
+  LSM6DSOX_GY_ODR_26Hz, LSM6DSOX_GY_ODR_52Hz, LSM6DSOX_GY_ODR_104Hz,
+  LSM6DSOX_GY_ODR_208Hz, LSM6DSOX_GY_ODR_417Hz, LSM6DSOX_GY_ODR_833Hz,
+  LSM6DSOX_GY_ODR_1667Hz, LSM6DSOX_GY_ODR_3333Hz, LSM6DSOX_GY_ODR_6667Hz
+};
+static const lsm6dsox_bdr_xl_t plan_xl_bdr[SENSOR_PLAN_RATES] = {
+  LSM6DSOX_XL_NOT_BATCHED, LSM6DSOX_XL_NOT_BATCHED, LSM6DSOX_XL_BATCHED_AT_12Hz5,
+  LSM6DSOX_XL_BATCHED_AT_26Hz, LSM6DSOX_XL_BATCHED_AT_52Hz, LSM6DSOX_XL_BATCHED_AT_104Hz,
+  LSM6DSOX_XL_BATCHED_AT_208Hz, LSM6DSOX_XL_BATCHED_AT_417Hz, LSM6DSOX_XL_BATCHED_AT_833Hz,
+  LSM6DSOX_XL_BATCHED_AT_1667Hz, LSM6DSOX_XL_BATCHED_AT_3333Hz, LSM6DSOX_XL_BATCHED_AT_6667Hz
+};
+static const lsm6dsox_bdr_gy_t plan_gy_bdr[SENSOR_PLAN_RATES] = {
+  LSM6DSOX_GY_NOT_BATCHED, LSM6DSOX_GY_NOT_BATCHED, LSM6DSOX_GY_BATCHED_AT_12Hz5,
+  LSM6DSOX_GY_BATCHED_AT_26Hz, LSM6DSOX_GY_BATCHED_AT_52Hz, LSM6DSOX_GY_BATCHED_AT_104Hz,
+  LSM6DSOX_GY_BATCHED_AT_208Hz, LSM6DSOX_GY_BATCHED_AT_417Hz, LSM6DSOX_GY_BATCHED_AT_833Hz,
+  LSM6DSOX_GY_BATCHED_AT_1667Hz, LSM6DSOX_GY_BATCHED_AT_3333Hz, LSM6DSOX_GY_BATCHED_AT_6667Hz
+};
+/* Driver values of the sensor_plan modes, the gyroscope has no
+ * ultra-low-power mode and the planner never picks it */
+static const lsm6dsox_xl_hm_mode_t plan_xl_mode[SENSOR_PLAN_MODE_ULP + 1] = {
+  [SENSOR_PLAN_MODE_HP] = LSM6DSOX_HIGH_PERFORMANCE_MD,
+  [SENSOR_PLAN_MODE_LP] = LSM6DSOX_LOW_NORMAL_POWER_MD,
+  [SENSOR_PLAN_MODE_ULP] = LSM6DSOX_ULTRA_LOW_POWER_MD
+};
+static const lsm6dsox_g_hm_mode_t plan_gy_mode[SENSOR_PLAN_MODE_ULP + 1] = {
+  [SENSOR_PLAN_MODE_HP] = LSM6DSOX_GY_HIGH_PERFORMANCE,
+  [SENSOR_PLAN_MODE_LP] = LSM6DSOX_GY_NORMAL,
+  [SENSOR_PLAN_MODE_ULP] = LSM6DSOX_GY_NORMAL
+};
+static const lsm6dsox_mlc_odr_t plan_mlc_odr[SENSOR_PLAN_RATES] = {
+  LSM6DSOX_ODR_PRGS_12Hz5, LSM6DSOX_ODR_PRGS_12Hz5, LSM6DSOX_ODR_PRGS_12Hz5,
+  LSM6DSOX_ODR_PRGS_26Hz, LSM6DSOX_ODR_PRGS_52Hz, LSM6DSOX_ODR_PRGS_104Hz,
+  LSM6DSOX_ODR_PRGS_104Hz, LSM6DSOX_ODR_PRGS_104Hz, LSM6DSOX_ODR_PRGS_104Hz,
+  LSM6DSOX_ODR_PRGS_104Hz, LSM6DSOX_ODR_PRGS_104Hz, LSM6DSOX_ODR_PRGS_104Hz
+};
+
+static uint8_t st_phase, st_count;
+static uint32_t st_base;
+
+/* Polls the MLC interrupt sources, runs next to the other tasks */
+static void lsm6dsox_mlc_task(uint32_t events);
+static const TASK_SCHED_Def_t MlcTaskDef =
+{
+  "mlc", lsm6dsox_mlc_task, TASK_SCHED_PRIO_NORMAL, MLC_POLL_PERIOD, 2 * MLC_POLL_PERIOD
+};
 
 /* Extern variables ----------------------------------------------------------*/
+extern void *MotionCompObj[CUSTOM_MOTION_INSTANCES_NBR];
 
 /* Private functions ---------------------------------------------------------*/
 
@@ -93,50 +268,285 @@ static int32_t platform_read(void *handle, uint8_t reg, uint8_t *bufp,
 static void platform_delay(uint32_t ms);
 static void tx_com( uint8_t *tx_buffer, uint16_t len );
 static void platform_init(void);
+static int32_t mlc_dev_config(mlc_dev_t *dev);
+static int32_t mlc_dev_plan(mlc_dev_t *dev);
+static void mlc_ucf_req(const mlc_dev_def_t *def, SENSOR_PLAN_Req_t *req);
+static void mlc_dev_poll(mlc_dev_t *dev);
+static void snapshot_arm(mlc_dev_t *dev);
+static void snapshot_trigger(mlc_dev_t *dev, uint8_t code);
+static void snapshot_process(void);
+static void snapshot_freeze(mlc_dev_t *dev);
+static void snapshot_drain(void);
+static uint32_t snapshot_burst(mlc_dev_t *dev);
+static void snapshot_encode(mlc_dev_t *dev);
+static void snapshot_send(void);
+static void snapshot_summary(mlc_dev_t *dev);
 
-/* Main Example --------------------------------------------------------------*/
-void lsm6dsox_mlc(void)
+/* Startup steps -------------------------------------------------------------*/
+/*
+ * @brief  Set up the driver interface and power the sensors
+ *
+ * @retval STARTUP_DONE
+ *
+ */
+int32_t lsm6dsox_mlc_power_on(void)
 {
-  /* Variable declaration */
-  lsm6dsox_pin_int1_route_t pin_int1_route;
-  lsm6dsox_all_sources_t status;
-  lsm6dsox_emb_sens_t emb_sens;
-  stmdev_ctx_t dev_ctx;
-  uint8_t mlc_out[8];
+  MLC_SNAP_Word_t *words;
   uint32_t i;
-  /* Initialize mems driver interface */
-  dev_ctx.write_reg = platform_write;
-  dev_ctx.read_reg  = platform_read;
-  dev_ctx.handle    = &SENSOR_BUS;
+
+  /* Take the report buffer from the memory budget */
+  if (tx_buffer == NULL)
+  {
+    tx_buffer = (uint8_t *)MEM_BUDGET_ALLOC(MLC_TX);
+    words = (MLC_SNAP_Word_t *)MEM_BUDGET_ALLOC(SNAP_WORDS);
+    for (i = 0; i < MLC_INSTANCES; i++)
+    {
+      MLC_SNAP_Init(&mlc_dev[i].snap, &words[i * SNAP_MAX_WORDS], SNAP_MAX_WORDS);
+    }
+    snap_out = (uint8_t *)MEM_BUDGET_ALLOC(SNAP_OUT);
+  }
+  /* Initialize mems driver interface, one per instance */
+  for (i = 0; i < MLC_INSTANCES; i++)
+  {
+    mlc_dev[i].def = &mlc_dev_def[i];
+    mlc_dev[i].ctx.write_reg = platform_write;
+    mlc_dev[i].ctx.read_reg  = platform_read;
+    mlc_dev[i].ctx.handle    = &mlc_dev[i];
+  }
   /* Init test platform */
   platform_init();
-  /* Wait sensor boot time */
-  platform_delay(BOOT_TIME);
-  /* Check device ID */
-  lsm6dsox_device_id_get(&dev_ctx, &whoamI);
 
-  if (whoamI != LSM6DSOX_ID)
-    while (1);
-/*  Debugging prints
+  return STARTUP_DONE;
+}
 
-    {
-  	  sprintf("MLC_WHOAMI: %d\r\n", whoamI);
-	  sprintf("lsm6dsox_device_id_get: %d\r\n", lsm6dsox_device_id_get);
+/*
+ * @brief  Wait for the sensors to answer after power up
+ *
+ * @param  elapsed       time since the step started
+ * @retval STARTUP_DONE once every device ID reads back, STARTUP_PENDING
+ *         before
+ *
+ */
+int32_t lsm6dsox_mlc_boot_poll(uint32_t elapsed)
+{
+  int32_t ret = STARTUP_DONE;
+  uint32_t i;
+
+  (void)elapsed;
+
+  /* Check device ID, the bus NACKs until the sensor is up */
+  for (i = 0; i < MLC_INSTANCES; i++) {
+    if (mlc_dev[i].whoami != LSM6DSOX_ID) {
+      lsm6dsox_device_id_get(&mlc_dev[i].ctx, &mlc_dev[i].whoami);
     }
-*/
+    if (mlc_dev[i].whoami != LSM6DSOX_ID) {
+      ret = STARTUP_PENDING;
+    }
+  }
 
-  /* Restore default configuration */
-  lsm6dsox_reset_set(&dev_ctx, PROPERTY_ENABLE);
+  return ret;
+}
 
-  do {
-    lsm6dsox_reset_get(&dev_ctx, &rst);
-  } while (rst);
+/*
+ * @brief  Start the accelerometer self-test, when enabled
+ *
+ * @retval STARTUP_PENDING, STARTUP_DONE if the self-test is disabled
+ *
+ */
+int32_t lsm6dsox_mlc_self_test_start(void)
+{
+#if (LSM6DSOX_MLC_SELF_TEST == 0)
+  return STARTUP_DONE;
+#else
+  uint32_t i;
 
-  /* Change 'falling' with the name of the function of the header for the Machile Learning Core Dataset  */
-  for ( i = 0; i < (sizeof(falling) /
-                    sizeof(ucf_line_t) ); i++ ) {
-    lsm6dsox_write_reg(&dev_ctx, falling[i].address,
-                       (uint8_t *)&falling[i].data, 1);
+  /* All the sensors are tested together */
+  for (i = 0; i < MLC_INSTANCES; i++) {
+    if ((CUSTOM_MOTION_SENSOR_SetOutputDataRate(mlc_dev_def[i].instance, MOTION_ACCELERO, 52.0f) != BSP_ERROR_NONE)
+        || (CUSTOM_MOTION_SENSOR_SetFullScale(mlc_dev_def[i].instance, MOTION_ACCELERO, 4) != BSP_ERROR_NONE)
+        || (CUSTOM_MOTION_SENSOR_Enable(mlc_dev_def[i].instance, MOTION_ACCELERO) != BSP_ERROR_NONE)) {
+      return STARTUP_ERROR;
+    }
+    memset(mlc_dev[i].st_sum, 0, sizeof(mlc_dev[i].st_sum));
+  }
+
+  st_phase = 0;
+  st_count = 0;
+  st_base = 0;
+
+  return STARTUP_PENDING;
+#endif
+}
+
+/*
+ * @brief  Take the self-test samples as they come, without blocking
+ *
+ * @param  elapsed       time since the step started
+ * @retval STARTUP_DONE if passed, STARTUP_PENDING while sampling,
+ *         STARTUP_ERROR if out of range
+ *
+ */
+int32_t lsm6dsox_mlc_self_test_poll(uint32_t elapsed)
+{
+  CUSTOM_MOTION_SENSOR_Axes_t axes;
+  int32_t diff;
+  uint32_t a, i;
+  mlc_dev_t *dev;
+
+  /* Discard the samples of the settling time, then one per ODR period */
+  if (elapsed < (st_base + ST_SETTLE + ((uint32_t)(st_count + 1U) * ST_SAMPLE_PERIOD))) {
+    return STARTUP_PENDING;
+  }
+
+  for (i = 0; i < MLC_INSTANCES; i++) {
+    dev = &mlc_dev[i];
+    if (CUSTOM_MOTION_SENSOR_GetAxes(dev->def->instance, MOTION_ACCELERO, &axes) != BSP_ERROR_NONE) {
+      return STARTUP_ERROR;
+    }
+    dev->st_sum[st_phase][0] += axes.x;
+    dev->st_sum[st_phase][1] += axes.y;
+    dev->st_sum[st_phase][2] += axes.z;
+  }
+
+  if (++st_count < ST_SAMPLES) {
+    return STARTUP_PENDING;
+  }
+
+  if (st_phase == 0U) {
+    /* Same again with the stimulus applied */
+    for (i = 0; i < MLC_INSTANCES; i++) {
+      if (lsm6dsox_xl_self_test_set(&mlc_dev[i].ctx, LSM6DSOX_XL_ST_POSITIVE) != 0) {
+        return STARTUP_ERROR;
+      }
+    }
+    st_phase = 1;
+    st_count = 0;
+    st_base = elapsed;
+    return STARTUP_PENDING;
+  }
+
+  for (i = 0; i < MLC_INSTANCES; i++) {
+    dev = &mlc_dev[i];
+    (void)lsm6dsox_xl_self_test_set(&dev->ctx, LSM6DSOX_XL_ST_DISABLE);
+
+    for (a = 0; a < 3U; a++) {
+      diff = (dev->st_sum[1][a] - dev->st_sum[0][a]) / ST_SAMPLES;
+      if (diff < 0) {
+        diff = -diff;
+      }
+      if ((diff < ST_MIN_MG) || (diff > ST_MAX_MG)) {
+        return STARTUP_ERROR;
+      }
+    }
+  }
+
+  return STARTUP_DONE;
+}
+
+/*
+ * @brief  Restore the default configuration
+ *
+ * @retval STARTUP_PENDING, the reset is polled by lsm6dsox_mlc_reset_poll
+ *
+ */
+int32_t lsm6dsox_mlc_reset_start(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < MLC_INSTANCES; i++) {
+    if (lsm6dsox_reset_set(&mlc_dev[i].ctx, PROPERTY_ENABLE) != 0) {
+      return STARTUP_ERROR;
+    }
+    mlc_dev[i].rst = 1;
+  }
+
+  return STARTUP_PENDING;
+}
+
+/*
+ * @brief  Wait for the resets to complete
+ *
+ * @param  elapsed       time since the step started
+ * @retval STARTUP_DONE once every reset bit cleared, STARTUP_PENDING before
+ *
+ */
+int32_t lsm6dsox_mlc_reset_poll(uint32_t elapsed)
+{
+  int32_t ret = STARTUP_DONE;
+  uint32_t i;
+
+  (void)elapsed;
+
+  for (i = 0; i < MLC_INSTANCES; i++) {
+    if (mlc_dev[i].rst != 0U) {
+      lsm6dsox_reset_get(&mlc_dev[i].ctx, &mlc_dev[i].rst);
+    }
+    if (mlc_dev[i].rst != 0U) {
+      ret = STARTUP_PENDING;
+    }
+  }
+
+  return ret;
+}
+
+/*
+ * @brief  Load the MLC programs, configure the sensors and register the
+ *         polling task
+ *
+ * @retval STARTUP_DONE
+ *
+ */
+int32_t lsm6dsox_mlc_config(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < MLC_INSTANCES; i++) {
+    if (mlc_dev_config(&mlc_dev[i]) != 0) {
+      return STARTUP_ERROR;
+    }
+  }
+
+  /* The MLC programs set their own full scales on the sensor registers */
+  MX_MEMS_RefreshSensitivity();
+
+  /* Poll from the scheduler instead of a main loop */
+  if (TASK_SCHED_Register(&MlcTaskDef, &MlcTaskId) != TASK_SCHED_OK) {
+    return STARTUP_ERROR;
+  }
+
+  return STARTUP_DONE;
+}
+
+/*
+ * @brief  Load the MLC program of a sensor and configure it
+ *
+ * @param  dev           sensor instance
+ * @retval 0 on success, -1 if the bus is busy or no configuration meets
+ *         the needs of the consumers
+ *
+ */
+static int32_t mlc_dev_config(mlc_dev_t *dev)
+{
+  /* Variable declaration */
+  lsm6dsox_pin_int1_route_t pin_int1_route;
+  lsm6dsox_emb_sens_t emb_sens;
+  uint32_t i;
+
+  /* Settle the rates before the first write, a failed plan leaves the
+   * sensor as it was */
+  if (mlc_dev_plan(dev) != 0) {
+    return -1;
+  }
+
+  /* The configuration switches register banks, keep the bus until done */
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_MLC) != BSP_ERROR_NONE) {
+    return -1;
+  }
+
+  /* The UCF of the instance, see LSM6DSOX_MLC_x_UCF */
+  for (i = 0; i < dev->def->ucf_lines; i++) {
+    lsm6dsox_write_reg(&dev->ctx, dev->def->ucf[i].address,
+                       (uint8_t *)&dev->def->ucf[i].data, 1);
   }
 
   /* End Machine Learning Core configuration */
@@ -147,49 +557,486 @@ void lsm6dsox_mlc(void)
    * to AN5259 "LSM6DSOX: Machine Learning Core".
    */
   /* Turn off embedded features */
-  lsm6dsox_embedded_sens_get(&dev_ctx, &emb_sens);
-  lsm6dsox_embedded_sens_off(&dev_ctx);
+  lsm6dsox_embedded_sens_get(&dev->ctx, &emb_sens);
+  lsm6dsox_embedded_sens_off(&dev->ctx);
   platform_delay(10);
   /* Turn off Sensors */
-  lsm6dsox_xl_data_rate_set(&dev_ctx, LSM6DSOX_XL_ODR_OFF);
-  lsm6dsox_gy_data_rate_set(&dev_ctx, LSM6DSOX_GY_ODR_OFF);
+  lsm6dsox_xl_data_rate_set(&dev->ctx, LSM6DSOX_XL_ODR_OFF);
+  lsm6dsox_gy_data_rate_set(&dev->ctx, LSM6DSOX_GY_ODR_OFF);
   /* Disable I3C interface */
-  lsm6dsox_i3c_disable_set(&dev_ctx, LSM6DSOX_I3C_DISABLE);
+  lsm6dsox_i3c_disable_set(&dev->ctx, LSM6DSOX_I3C_DISABLE);
   /* Enable Block Data Update */
-  lsm6dsox_block_data_update_set(&dev_ctx, PROPERTY_ENABLE);
+  lsm6dsox_block_data_update_set(&dev->ctx, PROPERTY_ENABLE);
   /* Set full scale */
-  lsm6dsox_xl_full_scale_set(&dev_ctx, LSM6DSOX_4g);
-  lsm6dsox_gy_full_scale_set(&dev_ctx, LSM6DSOX_2000dps);
+  lsm6dsox_xl_full_scale_set(&dev->ctx, LSM6DSOX_4g);
+  lsm6dsox_gy_full_scale_set(&dev->ctx, LSM6DSOX_2000dps);
   /* Route signals on interrupt pin 1 */
-  lsm6dsox_pin_int1_route_get(&dev_ctx, &pin_int1_route);
+  lsm6dsox_pin_int1_route_get(&dev->ctx, &pin_int1_route);
   pin_int1_route.mlc1 = PROPERTY_ENABLE;
-  lsm6dsox_pin_int1_route_set(&dev_ctx, pin_int1_route);
-  /* Configure interrupt pin mode notification */
-  lsm6dsox_int_notification_set(&dev_ctx,
+  lsm6dsox_pin_int1_route_set(&dev->ctx, pin_int1_route);
+  /* Configure interrupt pin mode notification, the MLC event stays on the
+   * line until the sources are read */
+  lsm6dsox_int_notification_set(&dev->ctx,
                                 LSM6DSOX_BASE_PULSED_EMB_LATCHED);
   /* Enable embedded features */
-  lsm6dsox_embedded_sens_set(&dev_ctx, &emb_sens);
-  /* Set Output Data Rate.
-   * Selected data rate have to be equal or greater with respect
-   * with MLC data rate.
+  lsm6dsox_embedded_sens_set(&dev->ctx, &emb_sens);
+  /* Set the planned power modes and Output Data Rates, the sensors are
+   * off since the UCF. The accelerometer data rate is equal or greater
+   * than the MLC data rate.
    */
-  lsm6dsox_xl_data_rate_set(&dev_ctx, LSM6DSOX_XL_ODR_26Hz);
-  lsm6dsox_gy_data_rate_set(&dev_ctx, LSM6DSOX_GY_ODR_OFF);
-
-  /* Main loop */
-  while (1) {
-    /* Read interrupt source registers in polling mode (no int) */
-    lsm6dsox_all_sources_get(&dev_ctx, &status);
-
-    if (status.mlc1) {
-      lsm6dsox_mlc_out_get(&dev_ctx, mlc_out);
-      sprintf((char *)tx_buffer, "Detect MLC interrupt code: %02X\r\n",
-              mlc_out[0]);
-      tx_com(tx_buffer, strlen((char const *)tx_buffer));
+  lsm6dsox_xl_power_mode_set(&dev->ctx, plan_xl_mode[dev->plan.AccMode]);
+  lsm6dsox_gy_power_mode_set(&dev->ctx, plan_gy_mode[dev->plan.GyrMode]);
+  lsm6dsox_mlc_data_rate_set(&dev->ctx, plan_mlc_odr[dev->plan.MlcRate]);
+  lsm6dsox_xl_data_rate_set(&dev->ctx, plan_xl_odr[dev->plan.AccRate]);
+  lsm6dsox_gy_data_rate_set(&dev->ctx, plan_gy_odr[dev->plan.GyrRate]);
+  /* Start keeping the pre-trigger window */
+  snapshot_arm(dev);
+  BSP_I2C2_Release();
+
+  return 0;
+}
+
+/*
+ * @brief  Merge the needs of the consumers of a sensor into its plan
+ *
+ * @param  dev           sensor instance
+ * @retval 0 on success, -1 if no configuration meets all the needs
+ *
+ */
+static int32_t mlc_dev_plan(mlc_dev_t *dev)
+{
+  SENSOR_PLAN_Req_t reqs[3] = {
+    /* Filled from the UCF */
+    { "mlc", 0, 0, 0, 0, 0, 0, 0, SENSOR_PLAN_MODE_HP, SENSOR_PLAN_MODE_HP },
+    /* Pre-trigger window of acc + gyro words, kept by the watermark */
+    { "snapshot", 0, 0, 0, SNAP_ODR * 10, SNAP_ODR * 10, SNAP_PRE_WORDS, 0,
+      SENSOR_PLAN_MODE_ULP, SENSOR_PLAN_MODE_LP },
+    { "terminal", TERM_ODR, TERM_ODR, 0, 0, 0, 0, 0,
+      SENSOR_PLAN_MODE_ULP, SENSOR_PLAN_MODE_LP },
+  };
+
+  mlc_ucf_req(dev->def, &reqs[0]);
+
+  if (SENSOR_PLAN_Solve(reqs, 3, &dev->plan) != SENSOR_PLAN_OK) {
+    return -1;
+  }
+  /* The snapshot depth is the pre-trigger window */
+  if (dev->plan.Watermark != SNAP_PRE_WORDS) {
+    return -1;
+  }
+
+  return 0;
+}
+
+/*
+ * @brief  Read the needs of the MLC program from its UCF: the MLC data rate,
+ *         the sensors it turns on and the power modes it was trained in
+ *
+ * @param  def           sensor instance set up
+ * @param  req           MLC needs
+ *
+ */
+static void mlc_ucf_req(const mlc_dev_def_t *def, SENSOR_PLAN_Req_t *req)
+{
+  static const uint32_t mlc_rate[4] = { 125, 260, 520, 1040 }; //0.1 Hz
+  uint8_t bank = 0, mlc_en = 0, mlc_odr = 0, gy_on = 0;
+  uint8_t ulp = 0, xl_hm = 0, g_hm = 0;
+  uint8_t reg, val;
+  uint32_t i;
+
+  for (i = 0; i < def->ucf_lines; i++) {
+    reg = def->ucf[i].address;
+    val = def->ucf[i].data;
+    if (reg == LSM6DSOX_FUNC_CFG_ACCESS) {
+      bank = val & 0xC0U; //embedded functions or sensor hub bank
+    } else if (bank == 0x80U) {
+      if (reg == LSM6DSOX_EMB_FUNC_ODR_CFG_C) {
+        mlc_odr = (val >> 4) & 0x03U;
+      } else if (reg == LSM6DSOX_EMB_FUNC_EN_B) {
+        mlc_en = ((val & 0x10U) != 0U);
+      }
+    } else if (bank == 0U) {
+      if (reg == LSM6DSOX_CTRL2_G) {
+        gy_on = ((val >> 4) != 0U);
+      } else if (reg == LSM6DSOX_CTRL5_C) {
+        ulp = ((val & 0x80U) != 0U);
+      } else if (reg == LSM6DSOX_CTRL6_C) {
+        xl_hm = ((val & 0x10U) != 0U);
+      } else if (reg == LSM6DSOX_CTRL7_G) {
+        g_hm = ((val & 0x80U) != 0U);
+      }
+    }
+  }
+
+  if (mlc_en == 0U) {
+    return;
+  }
+
+  /* The features are computed at the MLC data rate, in the modes of the
+   * training data */
+  req->MlcRate = mlc_rate[mlc_odr];
+  req->AccRate = mlc_rate[mlc_odr];
+  req->AccMode = ulp ? SENSOR_PLAN_MODE_ULP : (xl_hm ? SENSOR_PLAN_MODE_LP : SENSOR_PLAN_MODE_HP);
+  if (gy_on) {
+    req->GyrRate = mlc_rate[mlc_odr];
+    req->GyrMode = g_hm ? SENSOR_PLAN_MODE_LP : SENSOR_PLAN_MODE_HP;
+  }
+}
+
+/*
+ * @brief  MLC polling task, one pass of the former main loop
+ *
+ * @param  events        scheduler events (timer)
+ *
+ */
+static void lsm6dsox_mlc_task(uint32_t events)
+{
+  uint32_t i;
+
+  (void)events;
+
+  for (i = 0; i < MLC_INSTANCES; i++) {
+    mlc_dev_poll(&mlc_dev[i]);
+  }
+
+  snapshot_process();
+}
+
+/*
+ * @brief  Read the MLC output of a sensor if it has an event
+ *
+ * @param  dev           sensor instance
+ *
+ */
+static void mlc_dev_poll(mlc_dev_t *dev)
+{
+  lsm6dsox_all_sources_t status;
+  uint8_t mlc_out[8];
+  uint32_t pipe = (uint32_t)(dev - mlc_dev);
+  uint32_t mark;
+  uint16_t len;
+
+  /* The latched line tells without a bus access */
+  if (dev->def->int_port != NULL) {
+    if (HAL_GPIO_ReadPin(dev->def->int_port, dev->def->int_pin) == GPIO_PIN_RESET) {
+      return;
+    }
+    LAT_TRACE_Stamp(pipe, LAT_TRACE_EDGE);
+  }
+
+  /* Both reads go through the embedded functions bank, do them in one
+   * bus sequence so no other access lands on the wrong bank */
+  LAT_TRACE_Stamp(pipe, LAT_TRACE_READ_START);
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_MLC) != BSP_ERROR_NONE) {
+    return;
+  }
+
+  /* Read interrupt source registers, this also clears the latched line */
+  lsm6dsox_all_sources_get(&dev->ctx, &status);
+
+  if (status.mlc1) {
+    lsm6dsox_mlc_out_get(&dev->ctx, mlc_out);
+  }
+
+  BSP_I2C2_Release();
+  LAT_TRACE_Stamp(pipe, LAT_TRACE_READ_END);
+
+  if (status.mlc1) {
+    sprintf((char *)tx_buffer, "Detect MLC interrupt code: %02X, sensor %lu\r\n",
+            mlc_out[0], (unsigned long)dev->def->instance);
+    len = strlen((char const *)tx_buffer);
+    LAT_TRACE_Stamp(pipe, LAT_TRACE_FORMAT);
+    mark = LOG_SINK_Position() + len;
+    tx_com(tx_buffer, len);
+    /* The trace ends with the last byte of the line on the UART, unless
+     * the log dropped it */
+    if (LOG_SINK_Position() == mark) {
+      LAT_TRACE_Queue(pipe, mark);
+    } else {
+      LAT_TRACE_Abort(pipe);
+    }
+    (void)UPLINK_PostMlc((uint8_t)dev->def->instance, mlc_out[0], HAL_GetTick());
+    snapshot_trigger(dev, mlc_out[0]);
+  } else {
+    LAT_TRACE_Abort(pipe);
+  }
+}
+
+/*
+ * @brief  Flush the FIFO and restart it in continuous mode, depth limited
+ *         to the pre-trigger window
+ *
+ * @param  dev           sensor instance, bus acquired by the caller
+ *
+ */
+static void snapshot_arm(mlc_dev_t *dev)
+{
+  lsm6dsox_fifo_mode_set(&dev->ctx, LSM6DSOX_BYPASS_MODE);
+  lsm6dsox_fifo_watermark_set(&dev->ctx, dev->plan.Watermark);
+  lsm6dsox_fifo_stop_on_wtm_set(&dev->ctx, PROPERTY_ENABLE);
+  lsm6dsox_fifo_xl_batch_set(&dev->ctx, plan_xl_bdr[dev->plan.AccBatch]);
+  lsm6dsox_fifo_gy_batch_set(&dev->ctx, plan_gy_bdr[dev->plan.GyrBatch]);
+  lsm6dsox_fifo_mode_set(&dev->ctx, LSM6DSOX_STREAM_MODE);
+  dev->snap_state = SNAP_ARMED;
+}
+
+/*
+ * @brief  Start a capture, the words in the FIFO are the pre-trigger part
+ *
+ * @param  dev           sensor instance
+ * @param  code          MLC output of the event
+ *
+ */
+static void snapshot_trigger(mlc_dev_t *dev, uint8_t code)
+{
+  uint16_t level = 0;
+
+  if ((dev->snap_state != SNAP_ARMED) && (dev->snap_state != SNAP_TRIGGER)) {
+    return;
+  }
+
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_MLC) != BSP_ERROR_NONE) {
+    /* The event is read already, snapshot_process tries again */
+    dev->snap_code = code;
+    dev->snap_state = SNAP_TRIGGER;
+    return;
+  }
+  lsm6dsox_fifo_data_level_get(&dev->ctx, &level);
+  /* Let the FIFO grow past the window to hold the post-trigger data */
+  lsm6dsox_fifo_watermark_set(&dev->ctx, SNAP_MAX_WORDS);
+  BSP_I2C2_Release();
+
+  dev->snap_pre = (level > SNAP_PRE_WORDS) ? SNAP_PRE_WORDS : level;
+  dev->snap_tick = HAL_GetTick();
+  MLC_SNAP_Start(&dev->snap, code, SNAP_ODR);
+  dev->snap_state = SNAP_POST;
+}
+
+/*
+ * @brief  Advance the captures: start the ones the bus was busy for, freeze
+ *         the FIFOs once the post-trigger time is over, drain them, send the
+ *         snapshots one at a time as the log has room for them, then re-arm
+ *
+ */
+static void snapshot_process(void)
+{
+  mlc_dev_t *dev;
+  uint32_t i;
+
+  for (i = 0; i < MLC_INSTANCES; i++) {
+    dev = &mlc_dev[i];
+    if (dev->snap_state == SNAP_TRIGGER) {
+      snapshot_trigger(dev, dev->snap_code);
+    }
+    if ((dev->snap_state == SNAP_POST) && ((HAL_GetTick() - dev->snap_tick) >= SNAP_POST_MS)) {
+      snapshot_freeze(dev);
+    }
+  }
+
+  snapshot_drain();
+
+  for (i = 0; i < MLC_INSTANCES; i++) {
+    dev = &mlc_dev[i];
+    if ((dev->snap_state == SNAP_READY) && (snap_out_dev == NULL)) {
+      snapshot_encode(dev);
+    }
+  }
+
+  snapshot_send();
+
+  for (i = 0; i < MLC_INSTANCES; i++) {
+    dev = &mlc_dev[i];
+    if ((dev->snap_state == SNAP_IDLE) && (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_MLC) == BSP_ERROR_NONE)) {
+      snapshot_arm(dev);
+      BSP_I2C2_Release();
     }
   }
 }
 
+/*
+ * @brief  Stop batching and take the FIFO level, the words are read by
+ *         snapshot_drain
+ *
+ * @param  dev           sensor instance
+ *
+ */
+static void snapshot_freeze(mlc_dev_t *dev)
+{
+  uint16_t level = 0;
+
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_MLC) != BSP_ERROR_NONE) {
+    return;
+  }
+
+  /* Freeze: no new words while the FIFO is read */
+  lsm6dsox_fifo_xl_batch_set(&dev->ctx, LSM6DSOX_XL_NOT_BATCHED);
+  lsm6dsox_fifo_gy_batch_set(&dev->ctx, LSM6DSOX_GY_NOT_BATCHED);
+  lsm6dsox_fifo_data_level_get(&dev->ctx, &level);
+
+  BSP_I2C2_Release();
+
+  dev->snap_level = level;
+  dev->snap_read = 0;
+  dev->snap_state = SNAP_DRAIN;
+}
+
+/*
+ * @brief  Read the frozen FIFOs, one burst per sensor in turn, for at most
+ *         SNAP_DRAIN_SLICE
+ *
+ */
+static void snapshot_drain(void)
+{
+  uint32_t start = HAL_GetTick();
+  uint32_t active;
+  uint32_t i;
+
+  do {
+    active = 0;
+    for (i = 0; i < MLC_INSTANCES; i++) {
+      if (mlc_dev[i].snap_state == SNAP_DRAIN) {
+        active += snapshot_burst(&mlc_dev[i]);
+      }
+    }
+  } while ((active != 0U) && ((HAL_GetTick() - start) < SNAP_DRAIN_SLICE));
+}
+
+/*
+ * @brief  Read the next burst of a frozen FIFO
+ *
+ * @param  dev           sensor instance
+ * @retval 1 if words are left, 0 once the FIFO is read out or the bus is
+ *         busy
+ *
+ */
+static uint32_t snapshot_burst(mlc_dev_t *dev)
+{
+  uint8_t raw[SNAP_BURST_WORDS * MLC_SNAP_FIFO_WORD_SIZE];
+  uint16_t count = dev->snap_level - dev->snap_read;
+  uint16_t i;
+  int32_t ret;
+
+  if (count > SNAP_BURST_WORDS) {
+    count = SNAP_BURST_WORDS;
+  }
+
+  if (count > 0U) {
+    if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_MLC) != BSP_ERROR_NONE) {
+      return 0;
+    }
+    ret = lsm6dsox_read_reg(&dev->ctx, LSM6DSOX_FIFO_DATA_OUT_TAG, raw,
+                            count * MLC_SNAP_FIFO_WORD_SIZE);
+    BSP_I2C2_Release();
+
+    if (ret != 0) {
+      /* Keep what was read, the rest of the FIFO is lost */
+      dev->snap_level = dev->snap_read;
+      count = 0;
+    }
+  }
+
+  for (i = 0; i < count; i++) {
+    if ((uint16_t)(dev->snap_read + i) == dev->snap_pre) {
+      MLC_SNAP_MarkTrigger(&dev->snap);
+    }
+    (void)MLC_SNAP_AddRaw(&dev->snap, &raw[i * MLC_SNAP_FIFO_WORD_SIZE]);
+  }
+  dev->snap_read += count;
+
+  if (dev->snap_read < dev->snap_level) {
+    return 1;
+  }
+
+  if (dev->snap_level <= dev->snap_pre) {
+    MLC_SNAP_MarkTrigger(&dev->snap);
+  }
+  dev->snap_state = SNAP_READY;
+
+  return 0;
+}
+
+/*
+ * @brief  Encode a drained snapshot into the output buffer
+ *
+ * @param  dev           sensor instance, the output buffer is free
+ *
+ */
+static void snapshot_encode(mlc_dev_t *dev)
+{
+  if (MLC_SNAP_Encode(&dev->snap, snap_out, MEM_BUDGET_SNAP_OUT_SIZE, &snap_len) != MLC_SNAP_OK) {
+    snap_len = 0;
+  }
+  snap_sent = 0;
+  dev->snap_id = ++snap_count;
+  dev->snap_state = SNAP_SEND;
+  snap_out_dev = dev;
+
+  snapshot_summary(dev);
+}
+
+/*
+ * @brief  Queue the snapshot summary for the uplink: peak acceleration and
+ *         covered time
+ *
+ * @param  dev           sensor instance
+ *
+ */
+static void snapshot_summary(mlc_dev_t *dev)
+{
+  uint32_t sens = 0;
+  uint32_t count = 0;
+  uint32_t peak = MLC_SNAP_Peak(&dev->snap, MLC_SNAP_TAG_ACC, &count);
+
+  (void)MEMS_FIXED_AccSensitivity(SNAP_ACC_FS, &sens);
+  (void)UPLINK_PostSnapshot((uint8_t)dev->snap_id, (peak * sens) >> MEMS_FIXED_SENS_FRAC_BITS,
+                            (count * 1000U) / SNAP_ODR, dev->snap_tick);
+}
+
+/*
+ * @brief  Send the encoded snapshot in base64 lines, as many as the log
+ *         ring can take without dropping
+ *
+ *         SNAP <id> <offset> <base64>     one per SNAP_LINE_BYTES bytes
+ *         SNAP <id> END <length> <sensor>
+ *
+ */
+static void snapshot_send(void)
+{
+  LOG_RING_Stats_t stats;
+  mlc_dev_t *dev = snap_out_dev;
+  uint32_t chunk;
+  int len;
+
+  if (dev == NULL) {
+    return;
+  }
+
+  while (snap_sent < snap_len) {
+    LOG_SINK_GetStats(&stats);
+    if ((LOG_SINK_BUFFER_SIZE - stats.Used) < SNAP_LINE_MAX) {
+      return;
+    }
+
+    chunk = snap_len - snap_sent;
+    if (chunk > SNAP_LINE_BYTES) {
+      chunk = SNAP_LINE_BYTES;
+    }
+    len = sprintf((char *)tx_buffer, "SNAP %lu %lu ", (unsigned long)dev->snap_id,
+                  (unsigned long)snap_sent);
+    len += (int)MLC_SNAP_Base64(&snap_out[snap_sent], chunk, (char *)&tx_buffer[len]);
+    tx_buffer[len++] = '\r';
+    tx_buffer[len++] = '\n';
+    tx_com(tx_buffer, (uint16_t)len);
+    snap_sent += chunk;
+  }
+
+  sprintf((char *)tx_buffer, "SNAP %lu END %lu %lu\r\n", (unsigned long)dev->snap_id,
+          (unsigned long)snap_len, (unsigned long)dev->def->instance);
+  tx_com(tx_buffer, strlen((char const *)tx_buffer));
+  dev->snap_state = SNAP_IDLE;
+  snap_out_dev = NULL;
+}
+
 /*
  * @brief  Write generic device register (platform dependent)
  *
@@ -203,8 +1050,15 @@ void lsm6dsox_mlc(void)
 static int32_t platform_write(void *handle, uint8_t reg, const uint8_t *bufp,
                               uint16_t len)
 {
-  HAL_I2C_Mem_Write(handle, LSM6DSOX_I2C_ADD_L, reg,
-                    I2C_MEMADD_SIZE_8BIT, (uint8_t*) bufp, len, 1000);
+  /* Through the BSP so the accesses are arbitrated with the other clients,
+   * on the bus found by the probe of the instance (I2C2 or SPI1) */
+  const mlc_dev_def_t *def = ((mlc_dev_t *)handle)->def;
+  LSM6DSOX_Object_t *obj = (LSM6DSOX_Object_t *)MotionCompObj[def->instance];
+
+  if (obj == NULL) {
+    return BSP_I2C2_WriteReg(def->address, reg, (uint8_t*) bufp, len);
+  }
+  return obj->IO.WriteReg(obj->IO.Address, reg, (uint8_t*) bufp, len);
 }
 
 /*
@@ -220,8 +1074,13 @@ static int32_t platform_write(void *handle, uint8_t reg, const uint8_t *bufp,
 static int32_t platform_read(void *handle, uint8_t reg, uint8_t *bufp,
                              uint16_t len)
 {
-  HAL_I2C_Mem_Read(handle, LSM6DSOX_I2C_ADD_L, reg,
-                   I2C_MEMADD_SIZE_8BIT, bufp, len, 1000);
+  const mlc_dev_def_t *def = ((mlc_dev_t *)handle)->def;
+  LSM6DSOX_Object_t *obj = (LSM6DSOX_Object_t *)MotionCompObj[def->instance];
+
+  if (obj == NULL) {
+    return BSP_I2C2_ReadReg(def->address, reg, bufp, len);
+  }
+  return obj->IO.ReadReg(obj->IO.Address, reg, bufp, len);
 }
 
 /*
@@ -233,7 +1092,12 @@ static int32_t platform_read(void *handle, uint8_t reg, uint8_t *bufp,
  */
 static void tx_com(uint8_t *tx_buffer, uint16_t len)
 {
-  HAL_UART_Transmit(&hlpuart1, tx_buffer, len, 1000);
+  /* Shares LPUART1 with printf, go through the log sink so the two never
+   * collide on the DMA */
+  if (LOG_SINK_Write(tx_buffer, len) != LOG_SINK_OK)
+  {
+    LOG_SINK_WriteBlocking(tx_buffer, len);
+  }
 }
 
 /*
@@ -256,5 +1120,5 @@ static void platform_init(void)
 //  TIM1->CCR2 = PWM_3V3;
 //  HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_2);
 //  HAL_TIM_PWM_Start(&htim1, TIM_CHANNEL_2);
-  HAL_Delay(1000);
+  /* No fixed delay, the boot step polls the device ID until it answers */
 }
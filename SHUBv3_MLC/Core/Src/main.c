@@ -37,16 +37,37 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "shub_v3_0.h"
+#include "task_sched.h"
+#include "lsm6dsox_mlc.h"
+#include "uplink_uart.h"
+#include "startup_seq.h"
+#include "lat_trace.h"
+#include "tickless.h"
+#include <stdio.h>
 //#include "falling_detection.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
 /* USER CODE BEGIN PTD */
-
+/* Startup steps, in table order */
+typedef enum
+{
+  STEP_POWER = 0,
+  STEP_UPLINK,
+  STEP_BOOT,
+  STEP_SELF_TEST,
+  STEP_RESET,
+  STEP_MLC,
+  STEP_NBR
+} Startup_Index_t;
 /* USER CODE END PTD */
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
+/* Bounded waits of the startup steps [ms] */
+#define STARTUP_BOOT_TIMEOUT       100U
+#define STARTUP_SELF_TEST_TIMEOUT  1000U
+#define STARTUP_RESET_TIMEOUT      50U
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -78,12 +99,26 @@ static void MX_TIM1_Init(void);
 static void MX_USART1_UART_Init(void);
 static void MX_TIM2_Init(void);
 /* USER CODE BEGIN PFP */
+static void Sched_Idle(void);
+static int32_t Startup_Power(void);
+static int32_t Startup_Uplink(void);
+static void Startup_Report(int32_t Status);
 
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-
+/* The sensor boot and reset waits run while the independent steps go on */
+static const STARTUP_Step_t StartupSteps[STEP_NBR] =
+{
+  { "power",    Startup_Power,                NULL,                        0U,                           0U,                        0U },
+  { "uplink",   Startup_Uplink,               NULL,                        0U,                           0U,                        0U },
+  { "boot",     NULL,                         lsm6dsox_mlc_boot_poll,      STARTUP_DEP(STEP_POWER),      STARTUP_BOOT_TIMEOUT,      0U },
+  { "selftest", lsm6dsox_mlc_self_test_start, lsm6dsox_mlc_self_test_poll, STARTUP_DEP(STEP_BOOT),       STARTUP_SELF_TEST_TIMEOUT, 1U },
+  { "reset",    lsm6dsox_mlc_reset_start,     lsm6dsox_mlc_reset_poll,     STARTUP_DEP(STEP_SELF_TEST),  STARTUP_RESET_TIMEOUT,     0U },
+  { "mlc",      lsm6dsox_mlc_config,          NULL,                        STARTUP_DEP(STEP_RESET),      0U,                        0U },
+};
+static STARTUP_Record_t StartupRecords[STEP_NBR];
 /* USER CODE END 0 */
 
 /**
@@ -109,6 +144,8 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+  /* Tasks are registered by the init functions below */
+  TASK_SCHED_Init(HAL_GetTick, Sched_Idle);
 
   /* USER CODE END SysInit */
 
@@ -122,9 +159,12 @@ int main(void)
   MX_TIM2_Init();
   MX_MEMS_Init();
   /* USER CODE BEGIN 2 */
-  shub_init();
-  shub_power_i2c_on();
-  shub_power_i2c_mlc_on();
+  LAT_TRACE_Init();
+  TICKLESS_Init();
+
+  /* Power the sensor hub, bring up the MLC and the uplink. The steps poll
+   * the hardware with bounded timeouts instead of fixed delays. */
+  Startup_Report(STARTUP_Run(StartupSteps, STEP_NBR, StartupRecords, HAL_GetTick));
 
   /* USER CODE END 2 */
 
@@ -132,17 +172,12 @@ int main(void)
   /* USER CODE BEGIN WHILE */
   while (1)
   {
-//	  lsm6dsox_mlc();
     /* USER CODE END WHILE */
 
-  MX_MEMS_Process();
     /* USER CODE BEGIN 3 */
 
-    /* Call the MLC function inside the while(1) to have output of the Registers 
-     * for the Machine Learning Core*/
-
-  lsm6dsox_mlc();
-
+    /* The DataLogTerminal and MLC tasks run side by side, never returns */
+    TASK_SCHED_Run();
   }
 
   /* USER CODE END 3 */
@@ -431,7 +466,11 @@ static void MX_TIM2_Init(void)
     Error_Handler();
   }
   /* USER CODE BEGIN TIM2_Init 2 */
-
+  /* Free-running time base of the latency tracing */
+  if (HAL_TIM_Base_Start(&htim2) != HAL_OK)
+  {
+    Error_Handler();
+  }
   /* USER CODE END TIM2_Init 2 */
 
 }
@@ -450,6 +489,9 @@ static void MX_DMA_Init(void)
   /* DMA1_Channel6_IRQn interrupt configuration */
   HAL_NVIC_SetPriority(DMA1_Channel6_IRQn, 0, 0);
   HAL_NVIC_EnableIRQ(DMA1_Channel6_IRQn);
+  /* DMA1_Channel7_IRQn interrupt configuration */
+  HAL_NVIC_SetPriority(DMA1_Channel7_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel7_IRQn);
 
 }
 
@@ -518,6 +560,76 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+/**
+  * @brief  Scheduler idle hook, sleeps until the next interrupt
+  * @note   SysTick is stopped during the sleep and LPTIM1 wakes the core at
+  *         the next task timer, see tickless.h.
+  * @retval None
+  */
+static void Sched_Idle(void)
+{
+  uint32_t delay;
+
+  /* A post between the check and WFI still wakes the core: the interrupt
+   * stays pending while masked */
+  __disable_irq();
+  if (TASK_SCHED_Pending() == 0U)
+  {
+    if (TASK_SCHED_NextTimer(&delay) != TASK_SCHED_OK)
+    {
+      delay = UINT32_MAX;
+    }
+    TICKLESS_Sleep(delay);
+  }
+  __enable_irq();
+}
+
+/**
+  * @brief  Startup step: power the sensor hub and the MLC sensor
+  * @retval STARTUP_DONE
+  */
+static int32_t Startup_Power(void)
+{
+  shub_init();
+  shub_power_i2c_on();
+  shub_power_i2c_mlc_on();
+
+  return lsm6dsox_mlc_power_on();
+}
+
+/**
+  * @brief  Startup step: start the uplink packetizer
+  * @note   MLC changes and snapshot summaries are batched for the uplink.
+  * @retval STARTUP_DONE
+  */
+static int32_t Startup_Uplink(void)
+{
+  UPLINK_UART_Init();
+
+  return STARTUP_DONE;
+}
+
+/**
+  * @brief  Print the time taken by each startup step
+  * @param  Status the sequence status
+  * @retval None
+  */
+static void Startup_Report(int32_t Status)
+{
+  uint32_t i;
+
+  for (i = 0; i < STEP_NBR; i++)
+  {
+    printf("startup: %-8s %4ld ms, status %ld\r\n", StartupSteps[i].Name,
+           (long)(StartupRecords[i].End - StartupRecords[i].Start), (long)StartupRecords[i].Status);
+  }
+  printf("startup: ready at %lu ms\r\n", (unsigned long)HAL_GetTick());
+
+  if (Status != STARTUP_DONE)
+  {
+    Error_Handler();
+  }
+}
 
 /* USER CODE END 4 */
 
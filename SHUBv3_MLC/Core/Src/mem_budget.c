@@ -0,0 +1,122 @@
+/**
+  ******************************************************************************
+  * @file    mem_budget.c
+  * @author  ISCA Lab
+  * @brief   Static memory budget of the firmware buffers
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "main.h"
+#include "mem_budget.h"
+#include "mem_arena.h"
+#include "mem_placement.h"
+
+/* Private macro -------------------------------------------------------------*/
+#define MEM_BUDGET_STR_(x)   #x
+#define MEM_BUDGET_STR(x)    MEM_BUDGET_STR_(x)
+#define MEM_BUDGET_PRAGMA(x) _Pragma(#x)
+
+/* Print an entry as a compiler note */
+#define MEM_BUDGET_REPORT(Name)                                                       \
+  MEM_BUDGET_PRAGMA(message("mem budget: " #Name " " MEM_BUDGET_STR(MEM_BUDGET_##Name##_SIZE) \
+                            " bytes in SRAM" MEM_BUDGET_STR(MEM_BUDGET_##Name##_REGION)))
+
+/* Build time checks ---------------------------------------------------------*/
+_Static_assert(MEM_BUDGET_ROUND(1) == MEM_ARENA_ALIGNMENT, "MEM_BUDGET_ROUND does not match the arena alignment");
+_Static_assert(MEM_BUDGET_TOTAL(MEM_BUDGET_SRAM1) <= MEM_BUDGET_SRAM1_LIMIT, "SRAM1 buffers over budget");
+_Static_assert(MEM_BUDGET_TOTAL(MEM_BUDGET_SRAM2) <= MEM_BUDGET_SRAM2_LIMIT, "SRAM2 buffers over budget");
+
+/* Build time report ---------------------------------------------------------*/
+MEM_BUDGET_REPORT(LOG_RING)
+MEM_BUDGET_REPORT(MLC_TX)
+MEM_BUDGET_REPORT(TERMINAL_OUT)
+MEM_BUDGET_REPORT(SNAP_WORDS)
+MEM_BUDGET_REPORT(SNAP_OUT)
+MEM_BUDGET_REPORT(LAT_TRACE)
+
+/* Private variables ---------------------------------------------------------*/
+/* The pools show up with their budget size in the map file */
+#if MEM_BUDGET_TOTAL(MEM_BUDGET_SRAM1) > 0
+static uint8_t MemBudgetSram1Pool[MEM_BUDGET_TOTAL(MEM_BUDGET_SRAM1)] __attribute__((aligned(MEM_ARENA_ALIGNMENT)));
+static MEM_ARENA_t MemBudgetSram1 = MEM_ARENA_INITIALIZER(MemBudgetSram1Pool);
+#endif
+
+#if MEM_BUDGET_TOTAL(MEM_BUDGET_SRAM2) > 0
+static uint8_t MemBudgetSram2Pool[MEM_BUDGET_TOTAL(MEM_BUDGET_SRAM2)] __attribute__((aligned(MEM_ARENA_ALIGNMENT))) RAM2_BSS;
+static MEM_ARENA_t MemBudgetSram2 = MEM_ARENA_INITIALIZER(MemBudgetSram2Pool);
+#endif
+
+/* Private function prototypes -----------------------------------------------*/
+static MEM_ARENA_t *MEM_BUDGET_GetArena(uint32_t Region);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Take a buffer from a region pool
+  * @note   Meant to be called once per buffer at initialization, through
+  *         MEM_BUDGET_ALLOC. A request outside the budget is a configuration
+  *         error and ends in Error_Handler.
+  * @param  Region the region, MEM_BUDGET_SRAM1 or MEM_BUDGET_SRAM2
+  * @param  Size the buffer size in bytes
+  * @retval Pointer to the buffer, zero filled
+  */
+void *MEM_BUDGET_Alloc(uint32_t Region, uint32_t Size)
+{
+  MEM_ARENA_t *arena = MEM_BUDGET_GetArena(Region);
+  void *block = NULL;
+
+  if (arena != NULL)
+  {
+    block = MEM_ARENA_Alloc(arena, Size);
+  }
+
+  if (block == NULL)
+  {
+    Error_Handler();
+  }
+
+  return block;
+}
+
+/**
+  * @brief  Get the number of bytes left in a region pool
+  * @param  Region the region, MEM_BUDGET_SRAM1 or MEM_BUDGET_SRAM2
+  * @retval Available bytes
+  */
+uint32_t MEM_BUDGET_Available(uint32_t Region)
+{
+  MEM_ARENA_t *arena = MEM_BUDGET_GetArena(Region);
+
+  return (arena != NULL) ? MEM_ARENA_Available(arena) : 0U;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Get the arena of a region
+  * @param  Region the region
+  * @retval The arena, NULL if the region has no budget
+  */
+static MEM_ARENA_t *MEM_BUDGET_GetArena(uint32_t Region)
+{
+  switch (Region)
+  {
+#if MEM_BUDGET_TOTAL(MEM_BUDGET_SRAM1) > 0
+    case MEM_BUDGET_SRAM1:
+      return &MemBudgetSram1;
+#endif
+#if MEM_BUDGET_TOTAL(MEM_BUDGET_SRAM2) > 0
+    case MEM_BUDGET_SRAM2:
+      return &MemBudgetSram2;
+#endif
+    default:
+      return NULL;
+  }
+}
@@ -0,0 +1,360 @@
+/**
+  ******************************************************************************
+  * @file    mlc_snapshot.c
+  * @author  ISCA Lab
+  * @brief   Pre/post-trigger motion snapshot assembly and encoding
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "mlc_snapshot.h"
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t *Out;
+  uint32_t Size;
+  uint32_t Len;
+} MLC_SNAP_Writer_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const uint8_t StreamTags[MLC_SNAP_STREAMS] = { MLC_SNAP_TAG_ACC, MLC_SNAP_TAG_GYR };
+
+static const char Base64Table[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* Private function prototypes -----------------------------------------------*/
+static int32_t Put8(MLC_SNAP_Writer_t *W, uint8_t Value);
+static int32_t Put16(MLC_SNAP_Writer_t *W, uint16_t Value);
+static int32_t PutVarint(MLC_SNAP_Writer_t *W, int32_t Value);
+static int32_t EncodeStream(const MLC_SNAP_t *Snap, uint8_t Tag, MLC_SNAP_Writer_t *W);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize a snapshot over a caller provided word buffer
+  * @param  Snap the snapshot
+  * @param  Words the storage
+  * @param  Capacity the number of words of the storage
+  * @retval None
+  */
+void MLC_SNAP_Init(MLC_SNAP_t *Snap, MLC_SNAP_Word_t *Words, uint32_t Capacity)
+{
+  Snap->Words = Words;
+  Snap->Capacity = Capacity;
+  MLC_SNAP_Start(Snap, 0, 0);
+}
+
+/**
+  * @brief  Empty the snapshot before a new capture
+  * @param  Snap the snapshot
+  * @param  Code the MLC output of the event
+  * @param  Odr the batching rate in Hz
+  * @retval None
+  */
+void MLC_SNAP_Start(MLC_SNAP_t *Snap, uint8_t Code, uint16_t Odr)
+{
+  Snap->Count = 0;
+  Snap->Trigger = 0;
+  Snap->Dropped = 0;
+  Snap->Code = Code;
+  Snap->Odr = Odr;
+}
+
+/**
+  * @brief  Append a raw FIFO word, as read from FIFO_DATA_OUT_TAG onwards
+  * @note   Words of other sensors (timestamp, embedded functions) are
+  *         skipped, words beyond the capacity are counted as dropped.
+  * @param  Snap the snapshot
+  * @param  Raw the MLC_SNAP_FIFO_WORD_SIZE bytes of the word
+  * @retval MLC_SNAP_OK if stored or skipped, MLC_SNAP_ERROR if dropped
+  */
+int32_t MLC_SNAP_AddRaw(MLC_SNAP_t *Snap, const uint8_t *Raw)
+{
+  MLC_SNAP_Word_t *word;
+  uint8_t tag = Raw[0] >> 3;
+  uint32_t i;
+
+  if ((tag != MLC_SNAP_TAG_ACC) && (tag != MLC_SNAP_TAG_GYR))
+  {
+    return MLC_SNAP_OK;
+  }
+
+  if (Snap->Count >= Snap->Capacity)
+  {
+    Snap->Dropped++;
+    return MLC_SNAP_ERROR;
+  }
+
+  word = &Snap->Words[Snap->Count];
+  word->Tag = tag;
+  word->Reserved = 0;
+  for (i = 0; i < 3U; i++)
+  {
+    word->Data[i] = (int16_t)((uint16_t)Raw[1U + (2U * i)] | ((uint16_t)Raw[2U + (2U * i)] << 8));
+  }
+  Snap->Count++;
+
+  return MLC_SNAP_OK;
+}
+
+/**
+  * @brief  Mark the trigger, the next words are post-trigger
+  * @param  Snap the snapshot
+  * @retval None
+  */
+void MLC_SNAP_MarkTrigger(MLC_SNAP_t *Snap)
+{
+  Snap->Trigger = Snap->Count;
+}
+
+/**
+  * @brief  Get the largest absolute axis value of a sensor
+  * @param  Snap the snapshot
+  * @param  Tag the sensor tag
+  * @param  Count set to the number of words of the sensor, may be NULL
+  * @retval The peak raw value
+  */
+uint32_t MLC_SNAP_Peak(const MLC_SNAP_t *Snap, uint8_t Tag, uint32_t *Count)
+{
+  uint32_t peak = 0;
+  uint32_t n = 0;
+  uint32_t i;
+  uint32_t a;
+  int32_t v;
+
+  for (i = 0; i < Snap->Count; i++)
+  {
+    if (Snap->Words[i].Tag != Tag)
+    {
+      continue;
+    }
+
+    n++;
+    for (a = 0; a < 3U; a++)
+    {
+      v = Snap->Words[i].Data[a];
+      if ((uint32_t)((v < 0) ? -v : v) > peak)
+      {
+        peak = (uint32_t)((v < 0) ? -v : v);
+      }
+    }
+  }
+
+  if (Count != NULL)
+  {
+    *Count = n;
+  }
+
+  return peak;
+}
+
+/**
+  * @brief  Encode the snapshot
+  * @param  Snap the snapshot
+  * @param  Out the output buffer
+  * @param  Size the output buffer size, MLC_SNAP_ENCODED_MAX(Capacity) always fits
+  * @param  Len the encoded length
+  * @retval MLC_SNAP_OK in case of success, MLC_SNAP_ERROR if Out is too small
+  */
+int32_t MLC_SNAP_Encode(const MLC_SNAP_t *Snap, uint8_t *Out, uint32_t Size, uint32_t *Len)
+{
+  MLC_SNAP_Writer_t w = { Out, Size, 0 };
+  int32_t ret = MLC_SNAP_OK;
+  uint32_t s;
+
+  ret |= Put8(&w, (uint8_t)'S');
+  ret |= Put8(&w, (uint8_t)'N');
+  ret |= Put8(&w, MLC_SNAP_VERSION);
+  ret |= Put8(&w, Snap->Code);
+  ret |= Put16(&w, Snap->Odr);
+  ret |= Put8(&w, MLC_SNAP_STREAMS);
+  ret |= Put8(&w, 0);
+
+  for (s = 0; s < MLC_SNAP_STREAMS; s++)
+  {
+    ret |= EncodeStream(Snap, StreamTags[s], &w);
+  }
+
+  ret |= Put16(&w, MLC_SNAP_Crc16(Out, w.Len));
+
+  *Len = w.Len;
+
+  return (ret == MLC_SNAP_OK) ? MLC_SNAP_OK : MLC_SNAP_ERROR;
+}
+
+/**
+  * @brief  Base64 encode a block
+  * @param  In the data
+  * @param  Len the data length
+  * @param  Out the text, MLC_SNAP_BASE64_SIZE(Len) characters, not terminated
+  * @retval Number of characters written
+  */
+uint32_t MLC_SNAP_Base64(const uint8_t *In, uint32_t Len, char *Out)
+{
+  uint32_t i;
+  uint32_t n = 0;
+  uint32_t v;
+
+  for (i = 0; i < Len; i += 3U)
+  {
+    v = (uint32_t)In[i] << 16;
+    if ((i + 1U) < Len)
+    {
+      v |= (uint32_t)In[i + 1U] << 8;
+    }
+    if ((i + 2U) < Len)
+    {
+      v |= (uint32_t)In[i + 2U];
+    }
+
+    Out[n++] = Base64Table[(v >> 18) & 0x3FU];
+    Out[n++] = Base64Table[(v >> 12) & 0x3FU];
+    Out[n++] = ((i + 1U) < Len) ? Base64Table[(v >> 6) & 0x3FU] : '=';
+    Out[n++] = ((i + 2U) < Len) ? Base64Table[v & 0x3FU] : '=';
+  }
+
+  return n;
+}
+
+/**
+  * @brief  CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)
+  * @param  Data the data
+  * @param  Len the data length
+  * @retval The CRC
+  */
+uint16_t MLC_SNAP_Crc16(const uint8_t *Data, uint32_t Len)
+{
+  uint16_t crc = 0xFFFFU;
+  uint32_t i;
+  uint32_t b;
+
+  for (i = 0; i < Len; i++)
+  {
+    crc ^= (uint16_t)((uint16_t)Data[i] << 8);
+    for (b = 0; b < 8U; b++)
+    {
+      crc = ((crc & 0x8000U) != 0U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+    }
+  }
+
+  return crc;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Encode the words of one sensor
+  * @param  Snap the snapshot
+  * @param  Tag the sensor tag
+  * @param  W the output
+  * @retval MLC_SNAP_OK in case of success, MLC_SNAP_ERROR if the output is full
+  */
+static int32_t EncodeStream(const MLC_SNAP_t *Snap, uint8_t Tag, MLC_SNAP_Writer_t *W)
+{
+  const MLC_SNAP_Word_t *prev = NULL;
+  uint32_t count = 0;
+  uint32_t pre = 0;
+  int32_t ret = MLC_SNAP_OK;
+  uint32_t i;
+  uint32_t a;
+
+  for (i = 0; i < Snap->Count; i++)
+  {
+    if (Snap->Words[i].Tag == Tag)
+    {
+      count++;
+      if (i < Snap->Trigger)
+      {
+        pre++;
+      }
+    }
+  }
+
+  ret |= Put8(W, Tag);
+  ret |= Put16(W, (uint16_t)pre);
+  ret |= Put16(W, (uint16_t)count);
+
+  for (i = 0; i < Snap->Count; i++)
+  {
+    if (Snap->Words[i].Tag != Tag)
+    {
+      continue;
+    }
+
+    for (a = 0; a < 3U; a++)
+    {
+      if (prev == NULL)
+      {
+        ret |= Put16(W, (uint16_t)Snap->Words[i].Data[a]);
+      }
+      else
+      {
+        ret |= PutVarint(W, (int32_t)Snap->Words[i].Data[a] - (int32_t)prev->Data[a]);
+      }
+    }
+    prev = &Snap->Words[i];
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  Write a byte
+  * @param  W the output
+  * @param  Value the byte
+  * @retval MLC_SNAP_OK in case of success, MLC_SNAP_ERROR if the output is full
+  */
+static int32_t Put8(MLC_SNAP_Writer_t *W, uint8_t Value)
+{
+  if (W->Len >= W->Size)
+  {
+    return MLC_SNAP_ERROR;
+  }
+
+  W->Out[W->Len++] = Value;
+
+  return MLC_SNAP_OK;
+}
+
+/**
+  * @brief  Write a little endian 16 bit value
+  * @param  W the output
+  * @param  Value the value
+  * @retval MLC_SNAP_OK in case of success, MLC_SNAP_ERROR if the output is full
+  */
+static int32_t Put16(MLC_SNAP_Writer_t *W, uint16_t Value)
+{
+  int32_t ret = Put8(W, (uint8_t)(Value & 0xFFU));
+
+  ret |= Put8(W, (uint8_t)(Value >> 8));
+
+  return ret;
+}
+
+/**
+  * @brief  Write a signed value as a zigzag varint, 7 bits per byte
+  * @param  W the output
+  * @param  Value the value
+  * @retval MLC_SNAP_OK in case of success, MLC_SNAP_ERROR if the output is full
+  */
+static int32_t PutVarint(MLC_SNAP_Writer_t *W, int32_t Value)
+{
+  uint32_t zz = ((uint32_t)Value << 1) ^ (uint32_t)(Value >> 31);
+  int32_t ret = MLC_SNAP_OK;
+
+  while (zz >= 0x80U)
+  {
+    ret |= Put8(W, (uint8_t)((zz & 0x7FU) | 0x80U));
+    zz >>= 7;
+  }
+  ret |= Put8(W, (uint8_t)zz);
+
+  return ret;
+}
@@ -0,0 +1,256 @@
+/**
+  ******************************************************************************
+  * @file    sensor_plan.c
+  * @author  ISCA Lab
+  * @brief   Lowest power LSM6DSOX configuration for a set of consumers
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "sensor_plan.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SENSOR_PLAN_MODES  3U
+#define NA                 0U  /* Rate not available in the mode */
+
+/* Private variables ---------------------------------------------------------*/
+/* Rate of each ladder step [0.1 Hz] */
+static const uint32_t Rates[SENSOR_PLAN_RATES] =
+{
+  0U, 16U, 125U, 260U, 520U, 1040U, 2080U, 4170U, 8330U, 16670U, 33330U, 66670U
+};
+
+/* Accelerometer supply current [0.1 uA] by mode and rate. Low-power and
+ * ultra-low-power stop at 208 Hz, above it the part runs high-performance. */
+static const uint16_t AccCurrent[SENSOR_PLAN_MODES][SENSOR_PLAN_RATES] =
+{
+  /* OFF 1.6   12.5  26    52    104   208   417   833   1667  3333  6667 */
+  { NA,  NA,   1700, 1700, 1700, 1700, 1700, 1700, 1700, 1700, 1700, 1700 }, /* HP */
+  { NA,  45,   95,   150,  260,  450,  850,  NA,   NA,   NA,   NA,   NA   }, /* LP */
+  { NA,  30,   44,   65,   105,  190,  360,  NA,   NA,   NA,   NA,   NA   }, /* ULP */
+};
+
+/* Gyroscope supply current [0.1 uA], no ultra-low-power mode */
+static const uint16_t GyrCurrent[SENSOR_PLAN_MODES][SENSOR_PLAN_RATES] =
+{
+  /* OFF 1.6   12.5  26    52    104   208   417   833   1667  3333  6667 */
+  { NA,  NA,   4300, 4300, 4300, 4300, 4300, 4300, 4300, 4300, 4300, 4300 }, /* HP */
+  { NA,  NA,   2350, 2550, 2900, 3500, 4000, NA,   NA,   NA,   NA,   NA   }, /* LP */
+  { NA,  NA,   NA,   NA,   NA,   NA,   NA,   NA,   NA,   NA,   NA,   NA   },
+};
+
+/* MLC current on top of the accelerometer [0.1 uA], 12.5 Hz to 104 Hz */
+static const uint16_t MlcCurrent[SENSOR_PLAN_RATES] =
+{
+  0U, NA, 20U, 30U, 50U, 90U, NA, NA, NA, NA, NA, NA
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static uint8_t Ladder(uint32_t Rate);
+static int32_t Pick(const uint16_t Table[SENSOR_PLAN_MODES][SENSOR_PLAN_RATES], uint32_t Need,
+                    uint8_t MaxMode, uint8_t *Rate, uint8_t *Mode, uint32_t *Current);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Merge the needs of the consumers into the lowest power configuration
+  * @param  Reqs the needs of each consumer
+  * @param  Count the number of consumers
+  * @param  Plan the configuration, written only in case of success
+  * @retval SENSOR_PLAN_OK in case of success, SENSOR_PLAN_ERROR if no
+  *         configuration meets all the needs
+  */
+int32_t SENSOR_PLAN_Solve(const SENSOR_PLAN_Req_t *Reqs, uint32_t Count, SENSOR_PLAN_t *Plan)
+{
+  SENSOR_PLAN_t plan = {0};
+  uint32_t acc_need = 0, gyr_need = 0, mlc_need = 0, acc_batch = 0, gyr_batch = 0;
+  uint32_t window = 0, latency = 0, words, current;
+  uint8_t acc_mode = SENSOR_PLAN_MODE_ULP;
+  uint8_t gyr_mode = SENSOR_PLAN_MODE_LP;
+  const SENSOR_PLAN_Req_t *req;
+  uint32_t i;
+
+  if ((Reqs == NULL) || (Plan == NULL))
+  {
+    return SENSOR_PLAN_ERROR;
+  }
+
+  for (i = 0; i < Count; i++)
+  {
+    req = &Reqs[i];
+
+    if ((req->AccRate | req->MlcRate | req->AccBatch) != 0U)
+    {
+      acc_mode = (req->AccMode < acc_mode) ? req->AccMode : acc_mode;
+    }
+    if ((req->GyrRate | req->GyrBatch) != 0U)
+    {
+      gyr_mode = (req->GyrMode < gyr_mode) ? req->GyrMode : gyr_mode;
+    }
+
+    acc_need = (req->AccRate > acc_need) ? req->AccRate : acc_need;
+    gyr_need = (req->GyrRate > gyr_need) ? req->GyrRate : gyr_need;
+    mlc_need = (req->MlcRate > mlc_need) ? req->MlcRate : mlc_need;
+    acc_batch = (req->AccBatch > acc_batch) ? req->AccBatch : acc_batch;
+    gyr_batch = (req->GyrBatch > gyr_batch) ? req->GyrBatch : gyr_batch;
+    window = (req->FifoWindow > window) ? req->FifoWindow : window;
+    if ((req->FifoLatency != 0U) && ((latency == 0U) || (req->FifoLatency < latency)))
+    {
+      latency = req->FifoLatency;
+    }
+  }
+
+  /* The MLC runs from 12.5 Hz to 104 Hz, batching from 12.5 Hz */
+  plan.MlcRate = Ladder(mlc_need);
+  plan.AccBatch = Ladder(acc_batch);
+  plan.GyrBatch = Ladder(gyr_batch);
+  plan.MlcRate = (plan.MlcRate == SENSOR_PLAN_RATE_1Hz6) ? SENSOR_PLAN_RATE_12Hz5 : plan.MlcRate;
+  plan.AccBatch = (plan.AccBatch == SENSOR_PLAN_RATE_1Hz6) ? SENSOR_PLAN_RATE_12Hz5 : plan.AccBatch;
+  plan.GyrBatch = (plan.GyrBatch == SENSOR_PLAN_RATE_1Hz6) ? SENSOR_PLAN_RATE_12Hz5 : plan.GyrBatch;
+  if ((plan.MlcRate >= SENSOR_PLAN_RATES) || ((mlc_need != 0U) && (MlcCurrent[plan.MlcRate] == NA))
+      || (plan.AccBatch >= SENSOR_PLAN_RATES) || (plan.GyrBatch >= SENSOR_PLAN_RATES))
+  {
+    return SENSOR_PLAN_ERROR;
+  }
+
+  /* A sensor runs at least at the rate it is batched and the MLC runs at */
+  acc_need = (Rates[plan.AccBatch] > acc_need) ? Rates[plan.AccBatch] : acc_need;
+  acc_need = (Rates[plan.MlcRate] > acc_need) ? Rates[plan.MlcRate] : acc_need;
+  gyr_need = (Rates[plan.GyrBatch] > gyr_need) ? Rates[plan.GyrBatch] : gyr_need;
+
+  current = MlcCurrent[plan.MlcRate];
+
+  if (gyr_need != 0U)
+  {
+    if (Pick(GyrCurrent, gyr_need, gyr_mode, &plan.GyrRate, &plan.GyrMode, &current) != SENSOR_PLAN_OK)
+    {
+      return SENSOR_PLAN_ERROR;
+    }
+    /* Ultra-low-power needs the gyroscope off */
+    acc_mode = (acc_mode > SENSOR_PLAN_MODE_LP) ? SENSOR_PLAN_MODE_LP : acc_mode;
+  }
+
+  if (acc_need != 0U)
+  {
+    if (Pick(AccCurrent, acc_need, acc_mode, &plan.AccRate, &plan.AccMode, &current) != SENSOR_PLAN_OK)
+    {
+      return SENSOR_PLAN_ERROR;
+    }
+  }
+
+  /* Words batched per second [0.1 Hz] */
+  words = Rates[plan.AccBatch] + Rates[plan.GyrBatch];
+
+  if (words == 0U)
+  {
+    if ((window != 0U) || (latency != 0U))
+    {
+      return SENSOR_PLAN_ERROR;
+    }
+  }
+  else if (latency != 0U)
+  {
+    /* The fewest FIFO reads the latency budgets allow */
+    words = (latency * words) / 10000U;
+    words = (words > SENSOR_PLAN_MAX_WATERMARK) ? SENSOR_PLAN_MAX_WATERMARK : words;
+    if ((words == 0U) || (words < window))
+    {
+      return SENSOR_PLAN_ERROR;
+    }
+    plan.Watermark = (uint16_t)words;
+  }
+  else
+  {
+    if (window > SENSOR_PLAN_MAX_WATERMARK)
+    {
+      return SENSOR_PLAN_ERROR;
+    }
+    plan.Watermark = (uint16_t)window;
+  }
+
+  plan.Current = current;
+  *Plan = plan;
+
+  return SENSOR_PLAN_OK;
+}
+
+/**
+  * @brief  Get the rate of a ladder step
+  * @param  Rate the step, SENSOR_PLAN_RATE_x
+  * @retval The rate [0.1 Hz], 0 for an unknown step
+  */
+uint32_t SENSOR_PLAN_RateOf(uint8_t Rate)
+{
+  return (Rate < SENSOR_PLAN_RATES) ? Rates[Rate] : 0U;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Get the lowest ladder step covering a rate
+  * @param  Rate the rate [0.1 Hz]
+  * @retval The step, SENSOR_PLAN_RATES if above the ladder
+  */
+static uint8_t Ladder(uint32_t Rate)
+{
+  uint8_t step = 0;
+
+  while ((step < SENSOR_PLAN_RATES) && (Rates[step] < Rate))
+  {
+    step++;
+  }
+
+  return step;
+}
+
+/**
+  * @brief  Take the mode and rate drawing the least current
+  * @param  Table the current of the sensor by mode and rate
+  * @param  Need the lowest rate [0.1 Hz]
+  * @param  MaxMode the noisiest mode accepted
+  * @param  Rate the step taken
+  * @param  Mode the mode taken
+  * @param  Current the current, the sensor current is added to it
+  * @retval SENSOR_PLAN_OK in case of success, SENSOR_PLAN_ERROR if no mode
+  *         reaches the rate
+  */
+static int32_t Pick(const uint16_t Table[SENSOR_PLAN_MODES][SENSOR_PLAN_RATES], uint32_t Need,
+                    uint8_t MaxMode, uint8_t *Rate, uint8_t *Mode, uint32_t *Current)
+{
+  uint32_t best = 0;
+  uint8_t mode, step;
+
+  for (mode = 0; (mode <= MaxMode) && (mode < SENSOR_PLAN_MODES); mode++)
+  {
+    /* The currents rise with the rate, the lowest step available wins */
+    for (step = Ladder(Need); step < SENSOR_PLAN_RATES; step++)
+    {
+      if (Table[mode][step] != NA)
+      {
+        break;
+      }
+    }
+
+    /* Ties keep the less noisy mode */
+    if ((step < SENSOR_PLAN_RATES) && ((best == 0U) || (Table[mode][step] < best)))
+    {
+      best = Table[mode][step];
+      *Rate = step;
+      *Mode = mode;
+    }
+  }
+
+  if (best == 0U)
+  {
+    return SENSOR_PLAN_ERROR;
+  }
+
+  *Current += best;
+  return SENSOR_PLAN_OK;
+}
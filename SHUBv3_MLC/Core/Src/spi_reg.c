@@ -0,0 +1,93 @@
+/**
+  ******************************************************************************
+  * @file    spi_reg.c
+  * @author  ISCA Lab
+  * @brief   Register access framing for SPI sensors
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "spi_reg.h"
+
+/* Private function prototypes -----------------------------------------------*/
+static int32_t SPI_REG_Transfer(const SPI_REG_Port_t *Port, uint8_t Cmd, const uint8_t *Tx, uint8_t *Rx, uint16_t Len);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Read consecutive registers
+  * @param  Port the bus port
+  * @param  Reg the first register address, bit 7 clear
+  * @param  Data the read data
+  * @param  Len the number of registers
+  * @retval SPI_REG_OK in case of success, SPI_REG_ERROR otherwise
+  */
+int32_t SPI_REG_Read(const SPI_REG_Port_t *Port, uint8_t Reg, uint8_t *Data, uint16_t Len)
+{
+  if (Data == NULL)
+  {
+    return SPI_REG_ERROR;
+  }
+
+  return SPI_REG_Transfer(Port, (uint8_t)(Reg | SPI_REG_READ), NULL, Data, Len);
+}
+
+/**
+  * @brief  Write consecutive registers
+  * @param  Port the bus port
+  * @param  Reg the first register address, bit 7 clear
+  * @param  Data the data to write
+  * @param  Len the number of registers
+  * @retval SPI_REG_OK in case of success, SPI_REG_ERROR otherwise
+  */
+int32_t SPI_REG_Write(const SPI_REG_Port_t *Port, uint8_t Reg, const uint8_t *Data, uint16_t Len)
+{
+  if (Data == NULL)
+  {
+    return SPI_REG_ERROR;
+  }
+
+  return SPI_REG_Transfer(Port, (uint8_t)(Reg & ~SPI_REG_READ), Data, NULL, Len);
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Run one framed transaction
+  * @param  Port the bus port
+  * @param  Cmd the address byte
+  * @param  Tx the data to send, NULL for a read
+  * @param  Rx the data received, NULL for a write
+  * @param  Len the data length
+  * @retval SPI_REG_OK in case of success, SPI_REG_ERROR otherwise
+  */
+static int32_t SPI_REG_Transfer(const SPI_REG_Port_t *Port, uint8_t Cmd, const uint8_t *Tx, uint8_t *Rx, uint16_t Len)
+{
+  int32_t ret = SPI_REG_OK;
+
+  if ((Port == NULL) || (Port->Select == NULL) || (Port->Exchange == NULL))
+  {
+    return SPI_REG_ERROR;
+  }
+
+  Port->Select(Port->Context, 1U);
+
+  if (Port->Exchange(Port->Context, &Cmd, NULL, 1U) != 0)
+  {
+    ret = SPI_REG_ERROR;
+  }
+  else if ((Len != 0U) && (Port->Exchange(Port->Context, Tx, Rx, Len) != 0))
+  {
+    ret = SPI_REG_ERROR;
+  }
+
+  Port->Select(Port->Context, 0U);
+
+  return ret;
+}
@@ -0,0 +1,199 @@
+/**
+  ******************************************************************************
+  * @file    startup_seq.c
+  * @author  ISCA Lab
+  * @brief   Startup sequencer running independent init steps side by side
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "startup_seq.h"
+
+/* Private function prototypes -----------------------------------------------*/
+static int32_t STARTUP_Check(const STARTUP_Step_t *Steps, uint32_t Count, uint32_t All);
+static void STARTUP_Finish(const STARTUP_Step_t *Step, STARTUP_Record_t *Record, int32_t Status,
+                           uint32_t Now, uint32_t *Done, uint32_t *Failed, uint32_t Bit);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Run a set of startup steps to completion
+  * @note   Steps are started in table order once their dependencies are
+  *         done, a step can only depend on steps of the same table. A table
+  *         that could never finish is refused before any step runs.
+  * @param  Steps the steps
+  * @param  Count the number of steps, at most STARTUP_MAX_STEPS
+  * @param  Records the per step results, Count entries
+  * @param  Clock the time source, in the unit of the timeouts
+  * @retval STARTUP_DONE if every mandatory step is done, STARTUP_ERROR otherwise
+  */
+int32_t STARTUP_Run(const STARTUP_Step_t *Steps, uint32_t Count, STARTUP_Record_t *Records,
+                    uint32_t (*Clock)(void))
+{
+  uint32_t all = (Count >= 32U) ? 0xFFFFFFFFU : ((1UL << Count) - 1U);
+  uint32_t started = 0;
+  uint32_t done = 0;
+  uint32_t failed = 0;
+  uint32_t bit;
+  uint32_t now;
+  uint32_t i;
+  int32_t status;
+  int32_t ret = STARTUP_DONE;
+
+  if (Count > STARTUP_MAX_STEPS)
+  {
+    return STARTUP_ERROR;
+  }
+
+  for (i = 0; i < Count; i++)
+  {
+    Records[i].Start = 0;
+    Records[i].End = 0;
+    Records[i].Status = STARTUP_NOT_RUN;
+  }
+
+  if (STARTUP_Check(Steps, Count, all) != STARTUP_DONE)
+  {
+    return STARTUP_ERROR;
+  }
+
+  while ((done | failed) != all)
+  {
+    for (i = 0; i < Count; i++)
+    {
+      bit = 1UL << i;
+      if (((done | failed) & bit) != 0U)
+      {
+        continue;
+      }
+
+      now = Clock();
+
+      if ((started & bit) == 0U)
+      {
+        if ((Steps[i].Depends & failed) != 0U)
+        {
+          Records[i].Start = now;
+          STARTUP_Finish(&Steps[i], &Records[i], STARTUP_SKIPPED, now, &done, &failed, bit);
+          continue;
+        }
+        if ((Steps[i].Depends & ~done) != 0U)
+        {
+          continue;
+        }
+
+        started |= bit;
+        Records[i].Start = now;
+        status = (Steps[i].Start != NULL) ? Steps[i].Start() : STARTUP_PENDING;
+        if ((status == STARTUP_PENDING) && (Steps[i].Poll == NULL))
+        {
+          status = STARTUP_DONE;
+        }
+      }
+      else
+      {
+        status = Steps[i].Poll(now - Records[i].Start);
+        if ((status == STARTUP_PENDING) && ((now - Records[i].Start) >= Steps[i].Timeout))
+        {
+          status = STARTUP_TIMEOUT;
+        }
+      }
+
+      if (status != STARTUP_PENDING)
+      {
+        STARTUP_Finish(&Steps[i], &Records[i], status, Clock(), &done, &failed, bit);
+      }
+    }
+  }
+
+  for (i = 0; i < Count; i++)
+  {
+    if ((Records[i].Status != STARTUP_DONE) && (Steps[i].Optional == 0U))
+    {
+      ret = STARTUP_ERROR;
+    }
+  }
+
+  return ret;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Check that a step table can finish
+  * @note   A step is refused if it depends on an index past Count, on
+  *         itself, or through a cycle, or if it polls without a timeout.
+  *         Steps are resolved once all their dependencies are, at least one
+  *         per pass: what is left after Count passes is on a cycle.
+  * @param  Steps the steps
+  * @param  Count the number of steps
+  * @param  All the mask of the Count steps
+  * @retval STARTUP_DONE if the table can finish, STARTUP_ERROR otherwise
+  */
+static int32_t STARTUP_Check(const STARTUP_Step_t *Steps, uint32_t Count, uint32_t All)
+{
+  uint32_t resolved = 0;
+  uint32_t last;
+  uint32_t bit;
+  uint32_t i;
+
+  for (i = 0; i < Count; i++)
+  {
+    bit = 1UL << i;
+    if (((Steps[i].Depends & ~All) != 0U) || ((Steps[i].Depends & bit) != 0U)
+        || ((Steps[i].Poll != NULL) && (Steps[i].Timeout == 0U)))
+    {
+      return STARTUP_ERROR;
+    }
+  }
+
+  do
+  {
+    last = resolved;
+    for (i = 0; i < Count; i++)
+    {
+      if ((Steps[i].Depends & ~resolved) == 0U)
+      {
+        resolved |= 1UL << i;
+      }
+    }
+  } while (resolved != last);
+
+  return (resolved == All) ? STARTUP_DONE : STARTUP_ERROR;
+}
+
+/**
+  * @brief  Record the end of a step
+  * @note   An optional step unblocks the steps depending on it even when it
+  *         fails, not when it is skipped: its dependents then depend on the
+  *         failed step too.
+  * @param  Step the step
+  * @param  Record the step record
+  * @param  Status the final status
+  * @param  Now the current time
+  * @param  Done the mask of the steps done
+  * @param  Failed the mask of the steps failed or skipped
+  * @param  Bit the step bit
+  * @retval None
+  */
+static void STARTUP_Finish(const STARTUP_Step_t *Step, STARTUP_Record_t *Record, int32_t Status,
+                           uint32_t Now, uint32_t *Done, uint32_t *Failed, uint32_t Bit)
+{
+  Record->End = Now;
+  Record->Status = Status;
+
+  if ((Status == STARTUP_DONE) || ((Step->Optional != 0U) && (Status != STARTUP_SKIPPED)))
+  {
+    *Done |= Bit;
+  }
+  else
+  {
+    *Failed |= Bit;
+  }
+}
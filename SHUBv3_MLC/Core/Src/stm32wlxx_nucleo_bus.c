@@ -19,6 +19,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "stm32wlxx_nucleo_bus.h"
+#include "spi_reg.h"
 
 __weak HAL_StatusTypeDef MX_I2C2_Init(I2C_HandleTypeDef* hi2c);
 
@@ -51,6 +52,14 @@ I2C_HandleTypeDef hi2c2;
 static uint32_t IsI2C2MspCbValid = 0;
 #endif /* USE_HAL_I2C_REGISTER_CALLBACKS */
 static uint32_t I2C2InitCounter = 0;
+static BUS_ARB_t I2C2Arb;
+static uint32_t ArbInitialized = 0;
+static uint32_t SPI1InitCounter = 0;
+static DMA_HandleTypeDef hdma_spi1_rx;
+static DMA_HandleTypeDef hdma_spi1_tx;
+/* DMA source and sink of the unused direction */
+static const uint8_t SPI1TxDummy = 0;
+static uint8_t SPI1RxDummy;
 
 /**
   * @}
@@ -62,12 +71,39 @@ static uint32_t I2C2InitCounter = 0;
 
 static void I2C2_MspInit(I2C_HandleTypeDef* hI2c);
 static void I2C2_MspDeInit(I2C_HandleTypeDef* hI2c);
+static uint32_t I2C2_ArbClock(void);
+static uint32_t I2C2_ArbContext(void);
+static uint32_t I2C2_ArbLock(void);
+static void I2C2_ArbUnlock(uint32_t State);
+static void Bus_ArbInit(void);
+static void SPI1_MspInit(void);
+static void SPI1_MspDeInit(void);
+static void SPI1_Select(void *Context, uint8_t Active);
+static int32_t SPI1_Exchange(void *Context, const uint8_t *Tx, uint8_t *Rx, uint16_t Len);
+static int32_t SPI1_ExchangePoll(const uint8_t *Tx, uint8_t *Rx, uint16_t Len);
+static int32_t SPI1_ExchangeDma(const uint8_t *Tx, uint8_t *Rx, uint16_t Len);
+static int32_t SPI1_WaitIdle(uint32_t Tickstart);
 #if (USE_CUBEMX_BSP_V2 == 1)
 static uint32_t I2C_GetTiming(uint32_t clock_src_hz, uint32_t i2cfreq_hz);
 static void Compute_PRESC_SCLDEL_SDADEL(uint32_t clock_src_freq, uint32_t I2C_Speed);
 static uint32_t Compute_SCLL_SCLH (uint32_t clock_src_freq, uint32_t I2C_speed);
 #endif
 
+static const BUS_ARB_Port_t I2C2ArbPort =
+{
+  I2C2_ArbClock,
+  I2C2_ArbContext,
+  I2C2_ArbLock,
+  I2C2_ArbUnlock
+};
+
+static const SPI_REG_Port_t SPI1RegPort =
+{
+  NULL,
+  SPI1_Select,
+  SPI1_Exchange
+};
+
 /**
   * @}
   */
@@ -97,6 +133,8 @@ int32_t BSP_I2C2_Init(void)
 
   if(I2C2InitCounter++ == 0)
   {
+    Bus_ArbInit();
+
     if (HAL_I2C_GetState(&hi2c2) == HAL_I2C_STATE_RESET)
     {
     #if (USE_HAL_I2C_REGISTER_CALLBACKS == 0U)
@@ -168,11 +206,18 @@ int32_t BSP_I2C2_IsReady(uint16_t DevAddr, uint32_t Trials)
 {
   int32_t ret = BSP_ERROR_NONE;
 
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_SENSOR) != BSP_ERROR_NONE)
+  {
+    return BSP_ERROR_BUSY;
+  }
+
   if (HAL_I2C_IsDeviceReady(&hi2c2, DevAddr, Trials, BUS_I2C2_POLL_TIMEOUT) != HAL_OK)
   {
     ret = BSP_ERROR_BUSY;
   }
 
+  BSP_I2C2_Release();
+
   return ret;
 }
 
@@ -189,6 +234,11 @@ int32_t BSP_I2C2_WriteReg(uint16_t DevAddr, uint16_t Reg, uint8_t *pData, uint16
 {
   int32_t ret = BSP_ERROR_NONE;
 
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_SENSOR) != BSP_ERROR_NONE)
+  {
+    return BSP_ERROR_BUSY;
+  }
+
   if (HAL_I2C_Mem_Write(&hi2c2, DevAddr,Reg, I2C_MEMADD_SIZE_8BIT,pData, Length, BUS_I2C2_POLL_TIMEOUT) != HAL_OK)
   {
     if (HAL_I2C_GetError(&hi2c2) == HAL_I2C_ERROR_AF)
@@ -200,6 +250,9 @@ int32_t BSP_I2C2_WriteReg(uint16_t DevAddr, uint16_t Reg, uint8_t *pData, uint16
       ret =  BSP_ERROR_PERIPH_FAILURE;
     }
   }
+
+  BSP_I2C2_Release();
+
   return ret;
 }
 
@@ -215,6 +268,11 @@ int32_t  BSP_I2C2_ReadReg(uint16_t DevAddr, uint16_t Reg, uint8_t *pData, uint16
 {
   int32_t ret = BSP_ERROR_NONE;
 
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_SENSOR) != BSP_ERROR_NONE)
+  {
+    return BSP_ERROR_BUSY;
+  }
+
   if (HAL_I2C_Mem_Read(&hi2c2, DevAddr, Reg, I2C_MEMADD_SIZE_8BIT, pData, Length, BUS_I2C2_POLL_TIMEOUT) != HAL_OK)
   {
     if (HAL_I2C_GetError(&hi2c2) == HAL_I2C_ERROR_AF)
@@ -226,6 +284,9 @@ int32_t  BSP_I2C2_ReadReg(uint16_t DevAddr, uint16_t Reg, uint8_t *pData, uint16
       ret = BSP_ERROR_PERIPH_FAILURE;
     }
   }
+
+  BSP_I2C2_Release();
+
   return ret;
 }
 
@@ -243,6 +304,11 @@ int32_t BSP_I2C2_WriteReg16(uint16_t DevAddr, uint16_t Reg, uint8_t *pData, uint
 {
   int32_t ret = BSP_ERROR_NONE;
 
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_SENSOR) != BSP_ERROR_NONE)
+  {
+    return BSP_ERROR_BUSY;
+  }
+
   if (HAL_I2C_Mem_Write(&hi2c2, DevAddr, Reg, I2C_MEMADD_SIZE_16BIT, pData, Length, BUS_I2C2_POLL_TIMEOUT) != HAL_OK)
   {
     if (HAL_I2C_GetError(&hi2c2) == HAL_I2C_ERROR_AF)
@@ -254,6 +320,9 @@ int32_t BSP_I2C2_WriteReg16(uint16_t DevAddr, uint16_t Reg, uint8_t *pData, uint
       ret =  BSP_ERROR_PERIPH_FAILURE;
     }
   }
+
+  BSP_I2C2_Release();
+
   return ret;
 }
 
@@ -268,6 +337,11 @@ int32_t  BSP_I2C2_ReadReg16(uint16_t DevAddr, uint16_t Reg, uint8_t *pData, uint
 {
   int32_t ret = BSP_ERROR_NONE;
 
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_SENSOR) != BSP_ERROR_NONE)
+  {
+    return BSP_ERROR_BUSY;
+  }
+
   if (HAL_I2C_Mem_Read(&hi2c2, DevAddr, Reg, I2C_MEMADD_SIZE_16BIT, pData, Length, BUS_I2C2_POLL_TIMEOUT) != HAL_OK)
   {
     if (HAL_I2C_GetError(&hi2c2) != HAL_I2C_ERROR_AF)
@@ -279,6 +353,9 @@ int32_t  BSP_I2C2_ReadReg16(uint16_t DevAddr, uint16_t Reg, uint8_t *pData, uint
       ret =  BSP_ERROR_PERIPH_FAILURE;
     }
   }
+
+  BSP_I2C2_Release();
+
   return ret;
 }
 
@@ -292,6 +369,11 @@ int32_t  BSP_I2C2_ReadReg16(uint16_t DevAddr, uint16_t Reg, uint8_t *pData, uint
 int32_t BSP_I2C2_Send(uint16_t DevAddr, uint8_t *pData, uint16_t Length) {
   int32_t ret = BSP_ERROR_NONE;
 
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_SENSOR) != BSP_ERROR_NONE)
+  {
+    return BSP_ERROR_BUSY;
+  }
+
   if (HAL_I2C_Master_Transmit(&hi2c2, DevAddr, pData, Length, BUS_I2C2_POLL_TIMEOUT) != HAL_OK)
   {
     if (HAL_I2C_GetError(&hi2c2) != HAL_I2C_ERROR_AF)
@@ -304,6 +386,8 @@ int32_t BSP_I2C2_Send(uint16_t DevAddr, uint8_t *pData, uint16_t Length) {
     }
   }
 
+  BSP_I2C2_Release();
+
   return ret;
 }
 
@@ -317,6 +401,11 @@ int32_t BSP_I2C2_Send(uint16_t DevAddr, uint8_t *pData, uint16_t Length) {
 int32_t BSP_I2C2_Recv(uint16_t DevAddr, uint8_t *pData, uint16_t Length) {
   int32_t ret = BSP_ERROR_NONE;
 
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_SENSOR) != BSP_ERROR_NONE)
+  {
+    return BSP_ERROR_BUSY;
+  }
+
   if (HAL_I2C_Master_Receive(&hi2c2, DevAddr, pData, Length, BUS_I2C2_POLL_TIMEOUT) != HAL_OK)
   {
     if (HAL_I2C_GetError(&hi2c2) != HAL_I2C_ERROR_AF)
@@ -328,6 +417,9 @@ int32_t BSP_I2C2_Recv(uint16_t DevAddr, uint8_t *pData, uint16_t Length) {
       ret =  BSP_ERROR_PERIPH_FAILURE;
     }
   }
+
+  BSP_I2C2_Release();
+
   return ret;
 }
 
@@ -385,6 +477,269 @@ int32_t BSP_I2C2_RegisterMspCallbacks (BSP_I2C_Cb_t *Callbacks)
 }
 #endif /* USE_HAL_I2C_REGISTER_CALLBACKS */
 
+/**
+  * @brief  Take the I2C2 bus for a sequence of accesses
+  * @note   The register accesses done until BSP_I2C2_Release cannot be
+  *         interleaved with the ones of another client, e.g. a register bank
+  *         switch, the access and the switch back. Nests in the same context.
+  * @param  Client the client, one of BUS_I2C2_CLIENT_xxx
+  * @retval BSP status, BSP_ERROR_BUSY if a preempted context owns the bus
+  */
+int32_t BSP_I2C2_Acquire(uint32_t Client)
+{
+  int32_t ret = BSP_ERROR_NONE;
+
+  switch (BUS_ARB_Acquire(&I2C2Arb, Client))
+  {
+    case BUS_ARB_OK:
+      break;
+    case BUS_ARB_BUSY:
+      ret = BSP_ERROR_BUSY;
+      break;
+    default:
+      ret = BSP_ERROR_WRONG_PARAM;
+      break;
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  Give the I2C2 bus back
+  * @note   The last release runs the requests queued meanwhile.
+  * @retval None
+  */
+void BSP_I2C2_Release(void)
+{
+  BUS_ARB_Release(&I2C2Arb);
+}
+
+/**
+  * @brief  Submit an I2C2 request
+  * @note   For interrupt handlers: the request runs now if the bus is free,
+  *         or when its owner releases it, by priority.
+  * @param  Req the request, must stay valid until its Done callback
+  * @retval BSP status, BSP_ERROR_BUSY if the request is still pending
+  */
+int32_t BSP_I2C2_Submit(BUS_ARB_Request_t *Req)
+{
+  int32_t ret = BSP_ERROR_NONE;
+
+  switch (BUS_ARB_Submit(&I2C2Arb, Req))
+  {
+    case BUS_ARB_OK:
+    case BUS_ARB_QUEUED:
+      break;
+    case BUS_ARB_BUSY:
+      ret = BSP_ERROR_BUSY;
+      break;
+    default:
+      ret = BSP_ERROR_WRONG_PARAM;
+      break;
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  Get the I2C2 arbitration counters of a client
+  * @note   Times are in core clock cycles.
+  * @param  Client the client, one of BUS_I2C2_CLIENT_xxx
+  * @param  Stats the counters
+  * @retval BSP status
+  */
+int32_t BSP_I2C2_GetStats(uint32_t Client, BUS_ARB_Stats_t *Stats)
+{
+  if (BUS_ARB_GetStats(&I2C2Arb, Client, Stats) != BUS_ARB_OK)
+  {
+    return BSP_ERROR_WRONG_PARAM;
+  }
+
+  return BSP_ERROR_NONE;
+}
+
+/* BUS IO driver over SPI Peripheral */
+/*******************************************************************************
+                            BUS OPERATIONS OVER SPI
+*******************************************************************************/
+/**
+  * @brief  Initialize SPI1 as a mode 3 master, 8-bit frames, MSB first
+  * @retval BSP status
+  */
+int32_t BSP_SPI1_Init(void)
+{
+  uint32_t pclk2;
+  uint32_t br = 0;
+
+  if (SPI1InitCounter++ == 0U)
+  {
+    Bus_ArbInit();
+    SPI1_MspInit();
+
+    /* Smallest prescaler 2^(br+1) that keeps SCK within the limit */
+    pclk2 = HAL_RCC_GetPCLK2Freq();
+    while ((br < 7U) && ((pclk2 >> (br + 1U)) > BUS_SPI1_FREQUENCY))
+    {
+      br++;
+    }
+
+    SPI1->CR1 = 0;
+    SPI1->CR2 = SPI_CR2_DS_2 | SPI_CR2_DS_1 | SPI_CR2_DS_0 | SPI_CR2_FRXTH;
+    SPI1->CR1 = SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI | SPI_CR1_CPOL | SPI_CR1_CPHA
+                | (br << SPI_CR1_BR_Pos);
+    SPI1->CR1 |= SPI_CR1_SPE;
+
+    hdma_spi1_rx.Instance = BUS_SPI1_DMA_RX_CHANNEL;
+    hdma_spi1_rx.Init.Request = DMA_REQUEST_SPI1_RX;
+    hdma_spi1_rx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    hdma_spi1_rx.Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma_spi1_rx.Init.MemInc = DMA_MINC_ENABLE;
+    hdma_spi1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma_spi1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma_spi1_rx.Init.Mode = DMA_NORMAL;
+    hdma_spi1_rx.Init.Priority = DMA_PRIORITY_HIGH;
+
+    hdma_spi1_tx.Instance = BUS_SPI1_DMA_TX_CHANNEL;
+    hdma_spi1_tx.Init = hdma_spi1_rx.Init;
+    hdma_spi1_tx.Init.Request = DMA_REQUEST_SPI1_TX;
+    hdma_spi1_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+
+    if ((HAL_DMA_Init(&hdma_spi1_rx) != HAL_OK) || (HAL_DMA_Init(&hdma_spi1_tx) != HAL_OK))
+    {
+      return BSP_ERROR_PERIPH_FAILURE;
+    }
+  }
+
+  return BSP_ERROR_NONE;
+}
+
+/**
+  * @brief  DeInitialize SPI1
+  * @retval BSP status
+  */
+int32_t BSP_SPI1_DeInit(void)
+{
+  int32_t ret = BSP_ERROR_NONE;
+
+  if (SPI1InitCounter > 0U)
+  {
+    if (--SPI1InitCounter == 0U)
+    {
+      if (SPI1_WaitIdle(HAL_GetTick()) != BSP_ERROR_NONE)
+      {
+        ret = BSP_ERROR_BUS_FAILURE;
+      }
+      SPI1->CR1 &= ~SPI_CR1_SPE;
+
+      if ((HAL_DMA_DeInit(&hdma_spi1_rx) != HAL_OK) || (HAL_DMA_DeInit(&hdma_spi1_tx) != HAL_OK))
+      {
+        ret = BSP_ERROR_PERIPH_FAILURE;
+      }
+
+      SPI1_MspDeInit();
+    }
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  Send data through SPI1, chip select is left to the caller
+  * @param  pData: Data pointer
+  * @param  Length: Data length
+  * @retval BSP status
+  */
+int32_t BSP_SPI1_Send(uint8_t *pData, uint16_t Length)
+{
+  return SPI1_Exchange(NULL, pData, NULL, Length);
+}
+
+/**
+  * @brief  Receive data through SPI1, chip select is left to the caller
+  * @param  pData: Data pointer
+  * @param  Length: Data length
+  * @retval BSP status
+  */
+int32_t BSP_SPI1_Recv(uint8_t *pData, uint16_t Length)
+{
+  return SPI1_Exchange(NULL, NULL, pData, Length);
+}
+
+/**
+  * @brief  Send and receive data through SPI1 (Full duplex), chip select is
+  *         left to the caller
+  * @param  pTxData: Transmit data pointer
+  * @param  pRxData: Receive data pointer
+  * @param  Length: Data length
+  * @retval BSP status
+  */
+int32_t BSP_SPI1_SendRecv(uint8_t *pTxData, uint8_t *pRxData, uint16_t Length)
+{
+  return SPI1_Exchange(NULL, pTxData, pRxData, Length);
+}
+
+/**
+  * @brief  Write registers of the device through SPI1
+  * @note   Same signature as BSP_I2C2_WriteReg for the component IO, the
+  *         device address is not used.
+  * @param  Addr Not used
+  * @param  Reg The first register address
+  * @param  pData Pointer to data buffer to write
+  * @param  Length Data Length
+  * @retval BSP status
+  */
+int32_t BSP_SPI1_WriteReg(uint16_t Addr, uint16_t Reg, uint8_t *pData, uint16_t Length)
+{
+  int32_t ret = BSP_ERROR_NONE;
+
+  (void)Addr;
+
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_SENSOR) != BSP_ERROR_NONE)
+  {
+    return BSP_ERROR_BUSY;
+  }
+
+  if (SPI_REG_Write(&SPI1RegPort, (uint8_t)Reg, pData, Length) != SPI_REG_OK)
+  {
+    ret = BSP_ERROR_PERIPH_FAILURE;
+  }
+
+  BSP_I2C2_Release();
+
+  return ret;
+}
+
+/**
+  * @brief  Read registers of the device through SPI1
+  * @note   Same signature as BSP_I2C2_ReadReg for the component IO, the
+  *         device address is not used.
+  * @param  Addr Not used
+  * @param  Reg The first register address
+  * @param  pData Pointer to data buffer to read
+  * @param  Length Data Length
+  * @retval BSP status
+  */
+int32_t BSP_SPI1_ReadReg(uint16_t Addr, uint16_t Reg, uint8_t *pData, uint16_t Length)
+{
+  int32_t ret = BSP_ERROR_NONE;
+
+  (void)Addr;
+
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_SENSOR) != BSP_ERROR_NONE)
+  {
+    return BSP_ERROR_BUSY;
+  }
+
+  if (SPI_REG_Read(&SPI1RegPort, (uint8_t)Reg, pData, Length) != SPI_REG_OK)
+  {
+    ret = BSP_ERROR_PERIPH_FAILURE;
+  }
+
+  BSP_I2C2_Release();
+
+  return ret;
+}
+
 /**
   * @brief  Return system tick in ms
   * @retval Current HAL time base time stamp
@@ -487,6 +842,264 @@ static void I2C2_MspDeInit(I2C_HandleTypeDef* i2cHandle)
   /* USER CODE END I2C2_MspDeInit 1 */
 }
 
+/**
+  * @brief  Arbiter time source
+  * @note   Nothing may stop or clear the cycle counter, the ownership times
+  *         are taken as differences of it.
+  * @retval Core clock cycles
+  */
+static uint32_t I2C2_ArbClock(void)
+{
+  return DWT->CYCCNT;
+}
+
+/**
+  * @brief  Arbiter context identification
+  * @retval 0 in thread mode, the active exception number otherwise
+  */
+static uint32_t I2C2_ArbContext(void)
+{
+  return __get_IPSR();
+}
+
+/**
+  * @brief  Arbiter critical section entry
+  * @retval The previous PRIMASK
+  */
+static uint32_t I2C2_ArbLock(void)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+
+  return primask;
+}
+
+/**
+  * @brief  Arbiter critical section exit
+  * @param  State the PRIMASK returned by I2C2_ArbLock
+  * @retval None
+  */
+static void I2C2_ArbUnlock(uint32_t State)
+{
+  __set_PRIMASK(State);
+}
+
+/**
+  * @brief  Initialize the arbiter once, for the first of I2C2 and SPI1
+  * @retval None
+  */
+static void Bus_ArbInit(void)
+{
+  if (ArbInitialized == 0U)
+  {
+    ArbInitialized = 1U;
+    BUS_ARB_Init(&I2C2Arb, &I2C2ArbPort);
+
+    /* Cycle counter used to time the bus ownership */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  }
+}
+
+static void SPI1_MspInit(void)
+{
+  GPIO_InitTypeDef GPIO_InitStruct;
+
+  BUS_SPI1_GPIO_CLK_ENABLE();
+  __HAL_RCC_SPI1_CLK_ENABLE();
+  __HAL_RCC_DMAMUX1_CLK_ENABLE();
+  __HAL_RCC_DMA2_CLK_ENABLE();
+
+  /* Chip select high before the pin is driven */
+  HAL_GPIO_WritePin(BUS_SPI1_CS_GPIO_PORT, BUS_SPI1_CS_GPIO_PIN, GPIO_PIN_SET);
+  GPIO_InitStruct.Pin = BUS_SPI1_CS_GPIO_PIN;
+  GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+  GPIO_InitStruct.Alternate = 0;
+  HAL_GPIO_Init(BUS_SPI1_CS_GPIO_PORT, &GPIO_InitStruct);
+
+  /**SPI1 GPIO Configuration
+  PA5     ------> SPI1_SCK
+  PA6     ------> SPI1_MISO
+  PA7     ------> SPI1_MOSI
+  */
+  GPIO_InitStruct.Pin = BUS_SPI1_SCK_GPIO_PIN;
+  GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+  GPIO_InitStruct.Pull = GPIO_NOPULL;
+  GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+  GPIO_InitStruct.Alternate = BUS_SPI1_SCK_GPIO_AF;
+  HAL_GPIO_Init(BUS_SPI1_SCK_GPIO_PORT, &GPIO_InitStruct);
+
+  GPIO_InitStruct.Pin = BUS_SPI1_MISO_GPIO_PIN;
+  GPIO_InitStruct.Alternate = BUS_SPI1_MISO_GPIO_AF;
+  HAL_GPIO_Init(BUS_SPI1_MISO_GPIO_PORT, &GPIO_InitStruct);
+
+  GPIO_InitStruct.Pin = BUS_SPI1_MOSI_GPIO_PIN;
+  GPIO_InitStruct.Alternate = BUS_SPI1_MOSI_GPIO_AF;
+  HAL_GPIO_Init(BUS_SPI1_MOSI_GPIO_PORT, &GPIO_InitStruct);
+}
+
+static void SPI1_MspDeInit(void)
+{
+  __HAL_RCC_SPI1_CLK_DISABLE();
+
+  HAL_GPIO_DeInit(BUS_SPI1_SCK_GPIO_PORT, BUS_SPI1_SCK_GPIO_PIN);
+  HAL_GPIO_DeInit(BUS_SPI1_MISO_GPIO_PORT, BUS_SPI1_MISO_GPIO_PIN);
+  HAL_GPIO_DeInit(BUS_SPI1_MOSI_GPIO_PORT, BUS_SPI1_MOSI_GPIO_PIN);
+  HAL_GPIO_DeInit(BUS_SPI1_CS_GPIO_PORT, BUS_SPI1_CS_GPIO_PIN);
+}
+
+/**
+  * @brief  Register framing port, chip select
+  * @param  Context Not used
+  * @param  Active 1 to select the device
+  * @retval None
+  */
+static void SPI1_Select(void *Context, uint8_t Active)
+{
+  (void)Context;
+
+  HAL_GPIO_WritePin(BUS_SPI1_CS_GPIO_PORT, BUS_SPI1_CS_GPIO_PIN,
+                    (Active != 0U) ? GPIO_PIN_RESET : GPIO_PIN_SET);
+}
+
+/**
+  * @brief  Register framing port, full duplex transfer
+  * @note   Bursts of BUS_SPI1_DMA_THRESHOLD bytes and more (FIFO reads) go
+  *         through DMA, the address byte and short accesses are polled.
+  * @param  Context Not used
+  * @param  Tx the data to send, NULL sends zeros
+  * @param  Rx the data received, NULL discards them
+  * @param  Len the data length
+  * @retval BSP status
+  */
+static int32_t SPI1_Exchange(void *Context, const uint8_t *Tx, uint8_t *Rx, uint16_t Len)
+{
+  (void)Context;
+
+  if (SPI1InitCounter == 0U)
+  {
+    return BSP_ERROR_NO_INIT;
+  }
+
+  if (Len >= BUS_SPI1_DMA_THRESHOLD)
+  {
+    return SPI1_ExchangeDma(Tx, Rx, Len);
+  }
+
+  return SPI1_ExchangePoll(Tx, Rx, Len);
+}
+
+/**
+  * @brief  Polled transfer, one byte in flight
+  * @param  Tx the data to send, NULL sends zeros
+  * @param  Rx the data received, NULL discards them
+  * @param  Len the data length
+  * @retval BSP status
+  */
+static int32_t SPI1_ExchangePoll(const uint8_t *Tx, uint8_t *Rx, uint16_t Len)
+{
+  __IO uint8_t *dr = (__IO uint8_t *)&SPI1->DR;
+  uint32_t tickstart = HAL_GetTick();
+  uint8_t data;
+  uint16_t i;
+
+  for (i = 0; i < Len; i++)
+  {
+    /* 8-bit access, a 16-bit one would queue two frames */
+    *dr = (Tx != NULL) ? Tx[i] : 0U;
+
+    while ((SPI1->SR & SPI_SR_RXNE) == 0U)
+    {
+      if ((HAL_GetTick() - tickstart) > BUS_SPI1_POLL_TIMEOUT)
+      {
+        return BSP_ERROR_BUS_FAILURE;
+      }
+    }
+
+    data = *dr;
+    if (Rx != NULL)
+    {
+      Rx[i] = data;
+    }
+  }
+
+  return BSP_ERROR_NONE;
+}
+
+/**
+  * @brief  DMA transfer, waits for the end
+  * @note   The RX request is enabled before the TX one so that no received
+  *         byte is missed (RM0453, SPI communication using DMA).
+  * @param  Tx the data to send, NULL sends zeros
+  * @param  Rx the data received, NULL discards them
+  * @param  Len the data length
+  * @retval BSP status
+  */
+static int32_t SPI1_ExchangeDma(const uint8_t *Tx, uint8_t *Rx, uint16_t Len)
+{
+  int32_t ret = BSP_ERROR_NONE;
+  uint32_t tickstart = HAL_GetTick();
+
+  /* A missing buffer is replaced by a single byte, not incremented */
+  __HAL_DMA_DISABLE(&hdma_spi1_rx);
+  __HAL_DMA_DISABLE(&hdma_spi1_tx);
+  MODIFY_REG(hdma_spi1_rx.Instance->CCR, DMA_CCR_MINC, (Rx != NULL) ? DMA_CCR_MINC : 0U);
+  MODIFY_REG(hdma_spi1_tx.Instance->CCR, DMA_CCR_MINC, (Tx != NULL) ? DMA_CCR_MINC : 0U);
+
+  SPI1->CR2 |= SPI_CR2_RXDMAEN;
+
+  if ((HAL_DMA_Start(&hdma_spi1_rx, (uint32_t)&SPI1->DR,
+                     (Rx != NULL) ? (uint32_t)Rx : (uint32_t)&SPI1RxDummy, Len) != HAL_OK)
+      || (HAL_DMA_Start(&hdma_spi1_tx, (Tx != NULL) ? (uint32_t)Tx : (uint32_t)&SPI1TxDummy,
+                        (uint32_t)&SPI1->DR, Len) != HAL_OK))
+  {
+    ret = BSP_ERROR_PERIPH_FAILURE;
+  }
+  else
+  {
+    SPI1->CR2 |= SPI_CR2_TXDMAEN;
+
+    /* The last byte received ends the transfer */
+    if ((HAL_DMA_PollForTransfer(&hdma_spi1_rx, HAL_DMA_FULL_TRANSFER, BUS_SPI1_POLL_TIMEOUT) != HAL_OK)
+        || (HAL_DMA_PollForTransfer(&hdma_spi1_tx, HAL_DMA_FULL_TRANSFER, BUS_SPI1_POLL_TIMEOUT) != HAL_OK)
+        || (SPI1_WaitIdle(tickstart) != BSP_ERROR_NONE))
+    {
+      ret = BSP_ERROR_BUS_FAILURE;
+    }
+  }
+
+  SPI1->CR2 &= ~(SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
+
+  if (ret != BSP_ERROR_NONE)
+  {
+    (void)HAL_DMA_Abort(&hdma_spi1_rx);
+    (void)HAL_DMA_Abort(&hdma_spi1_tx);
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  Wait for the end of the current frame
+  * @param  Tickstart the start of the operation
+  * @retval BSP status
+  */
+static int32_t SPI1_WaitIdle(uint32_t Tickstart)
+{
+  while ((SPI1->SR & SPI_SR_BSY) != 0U)
+  {
+    if ((HAL_GetTick() - Tickstart) > BUS_SPI1_POLL_TIMEOUT)
+    {
+      return BSP_ERROR_BUS_FAILURE;
+    }
+  }
+
+  return BSP_ERROR_NONE;
+}
+
 /**
   * @}
   */
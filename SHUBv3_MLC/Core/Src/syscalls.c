@@ -29,6 +29,7 @@
 #include <time.h>
 #include <sys/time.h>
 #include <sys/times.h>
+#include "log_sink.h"
 
 
 /* Variables */
@@ -76,11 +77,11 @@ return len;
 
 __attribute__((weak)) int _write(int file, char *ptr, int len)
 {
-	int DataIdx;
-
-	for (DataIdx = 0; DataIdx < len; DataIdx++)
+	/* Queue to the DMA log sink, fall back to the blocking path before it is
+	 * initialized and from fault handlers */
+	if (LOG_SINK_Write((const uint8_t *)ptr, (uint32_t)len) != LOG_SINK_OK)
 	{
-		__io_putchar(*ptr++);
+		LOG_SINK_WriteBlocking((const uint8_t *)ptr, (uint32_t)len);
 	}
 	return len;
 }
@@ -0,0 +1,121 @@
+/**
+  ******************************************************************************
+  * @file    tick_comp.c
+  * @author  ISCA Lab
+  * @brief   Millisecond tick compensation across a tickless sleep
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "tick_comp.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Half a counter tick, in 1/Hz ms. A sleep ended by the compare stops on a
+ * counter edge but starts anywhere within a tick: it is half a tick shorter
+ * than counted on average. */
+#define TICK_COMP_HALF_TICK  500U
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize the compensation for a counter clock
+  * @param  Comp the compensation state
+  * @param  Hz the counter clock, at least 1 kHz
+  * @retval TICK_COMP_OK in case of success, TICK_COMP_ERROR otherwise
+  */
+int32_t TICK_COMP_Init(TICK_COMP_t *Comp, uint32_t Hz)
+{
+  if ((Comp == NULL) || (Hz < 1000U) || (Hz > (UINT32_MAX / 2U)))
+  {
+    return TICK_COMP_ERROR;
+  }
+
+  Comp->Hz = Hz;
+  Comp->Rem = 0;
+
+  return TICK_COMP_OK;
+}
+
+/**
+  * @brief  Add the part of a millisecond run before the tick was stopped
+  * @param  Comp the compensation state
+  * @param  Part the time run in the current millisecond, in tick clocks
+  * @param  Whole the tick clocks in a millisecond, Part is below it
+  * @retval None
+  */
+void TICK_COMP_AddFraction(TICK_COMP_t *Comp, uint32_t Part, uint32_t Whole)
+{
+  if ((Whole == 0U) || (Part >= Whole))
+  {
+    return;
+  }
+
+  /* Part counts whole tick clocks, the one running is half gone on average */
+  Comp->Rem += (uint32_t)(((((uint64_t)Part * 2U) + 1U) * Comp->Hz) / ((uint64_t)Whole * 2U));
+}
+
+/**
+  * @brief  Get the counter ticks after which Ms more milliseconds are due
+  * @param  Comp the compensation state
+  * @param  Ms the milliseconds to sleep
+  * @note   The ticks are for a compare wake, see TICK_COMP_Elapsed.
+  * @retval Counter ticks, rounded up, 0 if they are already due
+  */
+uint32_t TICK_COMP_Ticks(const TICK_COMP_t *Comp, uint32_t Ms)
+{
+  uint64_t need = ((uint64_t)Ms * Comp->Hz) + TICK_COMP_HALF_TICK;
+
+  if (need <= Comp->Rem)
+  {
+    return 0;
+  }
+
+  return (uint32_t)((need - Comp->Rem + 999U) / 1000U);
+}
+
+/**
+  * @brief  Account the counter ticks of a sleep
+  * @param  Comp the compensation state
+  * @param  Ticks the counter ticks elapsed
+  * @param  Edge 1 if the sleep was ended by the compare, on a counter edge,
+  *         0 if by another interrupt, anywhere within a tick
+  * @retval Whole milliseconds to add to the tick
+  */
+uint32_t TICK_COMP_Elapsed(TICK_COMP_t *Comp, uint32_t Ticks, uint8_t Edge)
+{
+  uint64_t total = ((uint64_t)Ticks * 1000U) + Comp->Rem;
+
+  if ((Edge != 0U) && (total >= TICK_COMP_HALF_TICK))
+  {
+    total -= TICK_COMP_HALF_TICK;
+  }
+
+  Comp->Rem = (uint32_t)(total % Comp->Hz);
+
+  return (uint32_t)(total / Comp->Hz);
+}
+
+/**
+  * @brief  Get the longest sleep a counter range allows
+  * @param  Comp the compensation state
+  * @param  MaxTicks the largest tick count the counter can wait for
+  * @retval Milliseconds whose TICK_COMP_Ticks stays within MaxTicks
+  */
+uint32_t TICK_COMP_MaxMs(const TICK_COMP_t *Comp, uint32_t MaxTicks)
+{
+  uint64_t range = (uint64_t)MaxTicks * 1000U;
+
+  if (range < TICK_COMP_HALF_TICK)
+  {
+    return 0;
+  }
+
+  return (uint32_t)((range - TICK_COMP_HALF_TICK) / Comp->Hz);
+}
@@ -0,0 +1,199 @@
+/**
+  ******************************************************************************
+  * @file    tickless.c
+  * @author  ISCA Lab
+  * @brief   Tickless idle: SysTick stopped, LPTIM1 wakeup
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "tickless.h"
+#include "tick_comp.h"
+
+/* Private define ------------------------------------------------------------*/
+#define TICKLESS_ARR        0xFFFFU
+/* Longest wait, short of a counter turn so the compare is never behind */
+#define TICKLESS_MAX_TICKS  0xFF00U
+/* Shortest wait, the compare write takes up to 3 counter clocks */
+#define TICKLESS_MIN_TICKS  4U
+/* Bound of the register update waits [ms], 3 LSE clocks expected */
+#define TICKLESS_TIMEOUT    10U
+
+/* Private variables ---------------------------------------------------------*/
+static TICK_COMP_t TickComp;
+static uint32_t TicklessMaxMs;
+static uint8_t TicklessReady = 0;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t TICKLESS_Count(void);
+static uint32_t TICKLESS_WaitFlag(uint32_t Flag);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Start LPTIM1 on the LSE
+  * @note   Without the LSE, or with a tick other than 1 kHz, the idle keeps
+  *         SysTick running.
+  * @retval None
+  */
+void TICKLESS_Init(void)
+{
+  if ((uwTickFreq != HAL_TICK_FREQ_1KHZ) || (TICK_COMP_Init(&TickComp, TICKLESS_HZ) != TICK_COMP_OK))
+  {
+    return;
+  }
+
+  __HAL_RCC_LPTIM1_CONFIG(RCC_LPTIM1CLKSOURCE_LSE);
+  __HAL_RCC_LPTIM1_CLK_ENABLE();
+
+  /* CFGR and IER are only written with the timer disabled: internal
+   * clock, no prescaler, software start, compare match interrupt */
+  LPTIM1->CR = 0;
+  LPTIM1->CFGR = 0;
+  LPTIM1->IER = LPTIM_IER_CMPMIE;
+  LPTIM1->CR = LPTIM_CR_ENABLE;
+
+  LPTIM1->ICR = LPTIM_ICR_ARROKCF;
+  LPTIM1->ARR = TICKLESS_ARR;
+  if (TICKLESS_WaitFlag(LPTIM_ISR_ARROK) != 0U)
+  {
+    LPTIM1->CR = 0;
+    return;
+  }
+  LPTIM1->CR |= LPTIM_CR_CNTSTRT;
+
+  /* LPTIM1 is a direct EXTI line, unmask its wakeup with interrupt */
+  EXTI->IMR1 |= EXTI_IMR1_IM29;
+  HAL_NVIC_SetPriority(LPTIM1_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(LPTIM1_IRQn);
+
+  TicklessMaxMs = TICK_COMP_MaxMs(&TickComp, TICKLESS_MAX_TICKS);
+  TicklessReady = 1;
+}
+
+/**
+  * @brief  Sleep until an interrupt, at most Ms milliseconds
+  * @note   To be called with interrupts masked, from the scheduler idle
+  *         hook. The pending interrupt runs once the caller unmasks them.
+  * @param  Ms the time to the next task timer, 0 to return at once
+  * @retval None
+  */
+void TICKLESS_Sleep(uint32_t Ms)
+{
+  uint32_t load;
+  uint32_t start;
+  uint32_t ticks;
+  uint8_t edge;
+
+  if (Ms == 0U)
+  {
+    return;
+  }
+
+  if ((TicklessReady == 0U) || (Ms < TICKLESS_MIN_MS))
+  {
+    __WFI();
+    return;
+  }
+
+  if (Ms > TicklessMaxMs)
+  {
+    Ms = TicklessMaxMs;
+  }
+
+  /* Stop the tick, a tick already due is counted here */
+  SysTick->CTRL &= ~(SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk);
+  if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0U)
+  {
+    SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+    uwTick++;
+  }
+
+  /* The part of the current millisecond already run */
+  load = SysTick->LOAD + 1U;
+  TICK_COMP_AddFraction(&TickComp, load - 1U - SysTick->VAL, load);
+
+  ticks = TICK_COMP_Ticks(&TickComp, Ms);
+  if (ticks < TICKLESS_MIN_TICKS)
+  {
+    ticks = TICKLESS_MIN_TICKS;
+  }
+
+  start = TICKLESS_Count();
+  LPTIM1->ICR = LPTIM_ICR_CMPOKCF | LPTIM_ICR_CMPMCF;
+  HAL_NVIC_ClearPendingIRQ(LPTIM1_IRQn);
+  LPTIM1->CMP = (start + ticks) & TICKLESS_ARR;
+  if ((TICKLESS_WaitFlag(LPTIM_ISR_CMPOK) == 0U) && (((TICKLESS_Count() - start) & TICKLESS_ARR) < ticks))
+  {
+    __WFI();
+  }
+
+  /* Give the time slept to the tick and start it again. The handler has
+   * not run yet, a compare match is still flagged */
+  edge = ((LPTIM1->ISR & LPTIM_ISR_CMPM) != 0U) ? 1U : 0U;
+  uwTick += TICK_COMP_Elapsed(&TickComp, (TICKLESS_Count() - start) & TICKLESS_ARR, edge);
+  SysTick->VAL = 0;
+  SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+}
+
+/**
+  * @brief  LPTIM1 interrupt, the wakeup compare
+  * @retval None
+  */
+void TICKLESS_IRQHandler(void)
+{
+  if ((LPTIM1->ISR & LPTIM_ISR_CMPM) != 0U)
+  {
+    LPTIM1->ICR = LPTIM_ICR_CMPMCF;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Read the LPTIM1 counter
+  * @note   The counter runs on the LSE, asynchronous to the bus: a value is
+  *         only valid once read twice.
+  * @retval The counter value
+  */
+static uint32_t TICKLESS_Count(void)
+{
+  uint32_t a;
+  uint32_t b = LPTIM1->CNT;
+
+  do
+  {
+    a = b;
+    b = LPTIM1->CNT;
+  } while (a != b);
+
+  return a;
+}
+
+/**
+  * @brief  Wait for a register update flag of LPTIM1
+  * @note   Also runs with SysTick stopped, so the bound is a loop count:
+  *         one core clock per pass at least, TICKLESS_TIMEOUT ms or more.
+  * @param  Flag the ISR flag
+  * @retval 0 once set, 1 on timeout
+  */
+static uint32_t TICKLESS_WaitFlag(uint32_t Flag)
+{
+  uint32_t budget = (SystemCoreClock / 1000U) * TICKLESS_TIMEOUT;
+
+  while ((LPTIM1->ISR & Flag) == 0U)
+  {
+    if (budget-- == 0U)
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
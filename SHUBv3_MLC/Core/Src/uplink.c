@@ -0,0 +1,507 @@
+/**
+  ******************************************************************************
+  * @file    uplink.c
+  * @author  ISCA Lab
+  * @brief   Event-compressed uplink packetizer
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
+#include "uplink.h"
+
+/* Private define ------------------------------------------------------------*/
+#define UPLINK_NONE         0xFFFFU
+
+_Static_assert((1000U % UPLINK_TIME_UNIT) == 0U, "UPLINK_TIME_UNIT must divide a second");
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t Type;
+  uint8_t Urgent;
+  uint8_t Count;
+  uint32_t Time;
+  uint32_t Data[UPLINK_HEALTH_MAX];
+} UPLINK_Event_t;
+
+typedef struct
+{
+  uint8_t *Data;    /* NULL to only count the bits */
+  uint32_t Pos;     /* Bits written */
+  uint32_t Size;    /* Bits available */
+} UPLINK_Bits_t;
+
+/* Private variables ---------------------------------------------------------*/
+static const UPLINK_Transport_t *UplinkTransport = NULL;
+static UPLINK_Event_t Queue[UPLINK_MAX_EVENTS];
+static uint32_t QueueHead;
+static uint32_t QueueCount;
+static uint8_t Seq;
+static uint16_t LastMlc[UPLINK_MLC_SENSORS];
+static uint32_t Credit;     /* Time on air available, us */
+static uint32_t CreditTime; /* Last credit update, ms */
+static UPLINK_Stats_t UplinkStats;
+
+/* Private function prototypes -----------------------------------------------*/
+static UPLINK_Event_t *UPLINK_Queue(uint8_t Type, uint8_t Urgent, uint32_t Time);
+static uint32_t UPLINK_Build(uint8_t *Payload, uint32_t Size, uint32_t *Len);
+static int32_t UPLINK_PutEvent(UPLINK_Bits_t *Bits, const UPLINK_Event_t *Event, uint32_t Delta);
+static int32_t UPLINK_PutDelta(UPLINK_Bits_t *Bits, uint32_t Delta);
+static int32_t UPLINK_PutBits(UPLINK_Bits_t *Bits, uint32_t Value, uint32_t Nbits);
+static uint32_t UPLINK_BitLength(uint32_t Value);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize the packetizer
+  * @note   The posting functions and UPLINK_Process are meant for thread
+  *         mode, not for interrupt handlers.
+  * @param  Transport the payload transport
+  * @param  Now the current time in ms
+  * @retval None
+  */
+void UPLINK_Init(const UPLINK_Transport_t *Transport, uint32_t Now)
+{
+  uint32_t i;
+
+  UplinkTransport = Transport;
+  QueueHead = 0;
+  QueueCount = 0;
+  Seq = 0;
+  for (i = 0; i < UPLINK_MLC_SENSORS; i++)
+  {
+    LastMlc[i] = UPLINK_NONE;
+  }
+  Credit = UPLINK_MAX_CREDIT * 1000U;
+  CreditTime = Now;
+  (void)memset(&UplinkStats, 0, sizeof(UplinkStats));
+}
+
+/**
+  * @brief  Report the MLC output of a sensor, queued if it changed
+  * @param  Sensor the sensor instance, below UPLINK_MLC_SENSORS
+  * @param  Code the MLC output
+  * @param  Time the event time in ms
+  * @retval UPLINK_OK if queued or unchanged, UPLINK_ERROR if dropped
+  */
+int32_t UPLINK_PostMlc(uint8_t Sensor, uint8_t Code, uint32_t Time)
+{
+  UPLINK_Event_t *event;
+
+  if (Sensor >= UPLINK_MLC_SENSORS)
+  {
+    return UPLINK_ERROR;
+  }
+
+  if (LastMlc[Sensor] == Code)
+  {
+    UplinkStats.Suppressed++;
+    return UPLINK_OK;
+  }
+
+  event = UPLINK_Queue(UPLINK_EVT_MLC, 1, Time);
+  if (event == NULL)
+  {
+    return UPLINK_ERROR;
+  }
+
+  event->Data[0] = Sensor;
+  event->Data[1] = Code;
+  LastMlc[Sensor] = Code;
+
+  return UPLINK_OK;
+}
+
+/**
+  * @brief  Report the summary of an event snapshot
+  * @param  Id the snapshot id
+  * @param  PeakMg the peak acceleration in mg
+  * @param  DurationMs the snapshot duration in ms
+  * @param  Time the event time in ms
+  * @retval UPLINK_OK if queued, UPLINK_ERROR if dropped
+  */
+int32_t UPLINK_PostSnapshot(uint8_t Id, uint32_t PeakMg, uint32_t DurationMs, uint32_t Time)
+{
+  UPLINK_Event_t *event = UPLINK_Queue(UPLINK_EVT_SNAPSHOT, 0, Time);
+
+  if (event == NULL)
+  {
+    return UPLINK_ERROR;
+  }
+
+  event->Data[0] = Id;
+  event->Data[1] = ((PeakMg / 64U) > 0xFFU) ? 0xFFU : (PeakMg / 64U);
+  event->Data[2] = ((DurationMs / 100U) > 0xFFU) ? 0xFFU : (DurationMs / 100U);
+
+  return UPLINK_OK;
+}
+
+/**
+  * @brief  Report health counters
+  * @param  Counters the counters, each sent on as many bits as it needs
+  * @param  Count the number of counters, at most UPLINK_HEALTH_MAX
+  * @param  Time the report time in ms
+  * @retval UPLINK_OK if queued, UPLINK_ERROR if dropped
+  */
+int32_t UPLINK_PostHealth(const uint32_t *Counters, uint32_t Count, uint32_t Time)
+{
+  UPLINK_Event_t *event;
+  uint32_t i;
+
+  if (Count > UPLINK_HEALTH_MAX)
+  {
+    return UPLINK_ERROR;
+  }
+
+  event = UPLINK_Queue(UPLINK_EVT_HEALTH, 0, Time);
+  if (event == NULL)
+  {
+    return UPLINK_ERROR;
+  }
+
+  event->Count = (uint8_t)Count;
+  for (i = 0; i < Count; i++)
+  {
+    /* 5 bits of length, 31 bits at most */
+    event->Data[i] = (Counters[i] > 0x7FFFFFFFU) ? 0x7FFFFFFFU : Counters[i];
+  }
+
+  return UPLINK_OK;
+}
+
+/**
+  * @brief  Send the payloads that are due and fit in the duty cycle
+  * @param  Now the current time in ms
+  * @retval None
+  */
+void UPLINK_Process(uint32_t Now)
+{
+  uint8_t payload[UPLINK_MAX_PAYLOAD];
+  uint32_t elapsed = Now - CreditTime;
+  uint32_t size;
+  uint32_t len;
+  uint32_t n;
+  uint32_t toa;
+  uint32_t i;
+  uint8_t urgent;
+
+  /* ms elapsed x permille is the us of time on air earned */
+  if (elapsed > ((UPLINK_MAX_CREDIT * 1000U) / UPLINK_DUTY_PERMILLE))
+  {
+    elapsed = (UPLINK_MAX_CREDIT * 1000U) / UPLINK_DUTY_PERMILLE;
+  }
+  Credit += elapsed * UPLINK_DUTY_PERMILLE;
+  if (Credit > (UPLINK_MAX_CREDIT * 1000U))
+  {
+    Credit = UPLINK_MAX_CREDIT * 1000U;
+  }
+  CreditTime = Now;
+
+  if (UplinkTransport == NULL)
+  {
+    return;
+  }
+
+  size = (UplinkTransport->MaxPayload < UPLINK_MAX_PAYLOAD) ? UplinkTransport->MaxPayload : UPLINK_MAX_PAYLOAD;
+
+  while (QueueCount > 0U)
+  {
+    urgent = 0;
+    for (i = 0; i < QueueCount; i++)
+    {
+      urgent |= Queue[(QueueHead + i) % UPLINK_MAX_EVENTS].Urgent;
+    }
+
+    n = UPLINK_Build(payload, size, &len);
+
+    /* Due when urgent, when the oldest event waited long enough or when
+     * the payload is full anyway */
+    if ((urgent == 0U) && ((Now - Queue[QueueHead].Time) < UPLINK_MAX_LATENCY) && (n == QueueCount)
+        && (QueueCount < UPLINK_MAX_EVENTS))
+    {
+      break;
+    }
+
+    if (n == 0U)
+    {
+      /* Cannot happen with a payload of a few bytes, do not stall on it */
+      QueueHead = (QueueHead + 1U) % UPLINK_MAX_EVENTS;
+      QueueCount--;
+      UplinkStats.Dropped++;
+      continue;
+    }
+
+    toa = UplinkTransport->TimeOnAir(len);
+    if ((toa * 1000U) > Credit)
+    {
+      UplinkStats.Deferred++;
+      break;
+    }
+
+    if (UplinkTransport->Send(payload, len) != UPLINK_OK)
+    {
+      UplinkStats.Failed++;
+      break;
+    }
+
+    Credit -= toa * 1000U;
+    QueueHead = (QueueHead + n) % UPLINK_MAX_EVENTS;
+    QueueCount -= n;
+    Seq++;
+    UplinkStats.Packets++;
+    UplinkStats.Bytes += len;
+    UplinkStats.Airtime += toa;
+  }
+}
+
+/**
+  * @brief  Get the number of queued events
+  * @retval Queued events
+  */
+uint32_t UPLINK_Pending(void)
+{
+  return QueueCount;
+}
+
+/**
+  * @brief  LoRa time on air, 125 kHz, CR 4/5, 8 symbols preamble, explicit
+  *         header and CRC, low data rate optimization from SF11
+  * @param  Len the payload length in bytes
+  * @param  Sf the spreading factor, 7 to 12
+  * @retval Time on air in ms, rounded up
+  */
+uint32_t UPLINK_LoraTimeOnAir(uint32_t Len, uint32_t Sf)
+{
+  uint32_t de = (Sf >= 11U) ? 1U : 0U;
+  uint32_t tsym = (1UL << Sf) * 8U; /* us */
+  int32_t num = (int32_t)(8U * Len) - (int32_t)(4U * Sf) + 28 + 16;
+  uint32_t den = 4U * (Sf - (2U * de));
+  uint32_t nsym = 8U;
+
+  if (num > 0)
+  {
+    nsym += (((uint32_t)num + den - 1U) / den) * 5U;
+  }
+
+  /* Preamble of 8 + 4.25 symbols */
+  return (((tsym * ((4U * nsym) + 49U)) / 4U) + 999U) / 1000U;
+}
+
+/**
+  * @brief  Get the packetizer counters
+  * @param  Stats the counters
+  * @retval None
+  */
+void UPLINK_GetStats(UPLINK_Stats_t *Stats)
+{
+  *Stats = UplinkStats;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Take a queue slot for a new event
+  * @param  Type the event type
+  * @param  Urgent 1 to send as soon as the duty cycle allows
+  * @param  Time the event time in ms
+  * @retval The event, NULL if the queue is full
+  */
+static UPLINK_Event_t *UPLINK_Queue(uint8_t Type, uint8_t Urgent, uint32_t Time)
+{
+  UPLINK_Event_t *event;
+
+  if (QueueCount >= UPLINK_MAX_EVENTS)
+  {
+    UplinkStats.Dropped++;
+    return NULL;
+  }
+
+  event = &Queue[(QueueHead + QueueCount) % UPLINK_MAX_EVENTS];
+  (void)memset(event, 0, sizeof(UPLINK_Event_t));
+  event->Type = Type;
+  event->Urgent = Urgent;
+  event->Time = Time;
+  QueueCount++;
+  UplinkStats.Events++;
+
+  return event;
+}
+
+/**
+  * @brief  Pack the oldest events into a payload
+  * @param  Payload the payload buffer
+  * @param  Size the payload size in bytes
+  * @param  Len the payload length
+  * @retval Number of events packed
+  */
+static uint32_t UPLINK_Build(uint8_t *Payload, uint32_t Size, uint32_t *Len)
+{
+  UPLINK_Bits_t bits = { Payload, 0, Size * 8U };
+  UPLINK_Bits_t probe;
+  const UPLINK_Event_t *event;
+  uint32_t base = Queue[QueueHead].Time / 1000U;
+  uint32_t prev = (base * 1000U) / UPLINK_TIME_UNIT;
+  uint32_t now;
+  uint32_t n;
+
+  (void)memset(Payload, 0, Size);
+  (void)UPLINK_PutBits(&bits, UPLINK_VERSION, 2);
+  (void)UPLINK_PutBits(&bits, Seq & 0x3FU, 6);
+  (void)UPLINK_PutBits(&bits, base & 0xFFFFFFU, 24);
+
+  for (n = 0; n < QueueCount; n++)
+  {
+    event = &Queue[(QueueHead + n) % UPLINK_MAX_EVENTS];
+    now = event->Time / UPLINK_TIME_UNIT;
+
+    /* Dry run first so a partial event never ends up in the payload */
+    probe = bits;
+    probe.Data = NULL;
+    if (UPLINK_PutEvent(&probe, event, now - prev) != UPLINK_OK)
+    {
+      break;
+    }
+
+    (void)UPLINK_PutEvent(&bits, event, now - prev);
+    prev = now;
+  }
+
+  *Len = (bits.Pos + 7U) / 8U;
+
+  return n;
+}
+
+/**
+  * @brief  Pack one event
+  * @param  Bits the output
+  * @param  Event the event
+  * @param  Delta the time since the previous event in UPLINK_TIME_UNIT
+  * @retval UPLINK_OK in case of success, UPLINK_ERROR if it does not fit
+  */
+static int32_t UPLINK_PutEvent(UPLINK_Bits_t *Bits, const UPLINK_Event_t *Event, uint32_t Delta)
+{
+  int32_t ret = UPLINK_PutBits(Bits, Event->Type, 3);
+  uint32_t nbits;
+  uint32_t i;
+
+  ret |= UPLINK_PutDelta(Bits, Delta);
+
+  switch (Event->Type)
+  {
+    case UPLINK_EVT_MLC:
+      ret |= UPLINK_PutBits(Bits, Event->Data[0], 1);
+      ret |= UPLINK_PutBits(Bits, Event->Data[1], 8);
+      break;
+    case UPLINK_EVT_SNAPSHOT:
+      ret |= UPLINK_PutBits(Bits, Event->Data[0], 8);
+      ret |= UPLINK_PutBits(Bits, Event->Data[1], 8);
+      ret |= UPLINK_PutBits(Bits, Event->Data[2], 8);
+      break;
+    default:
+      ret |= UPLINK_PutBits(Bits, Event->Count, 3);
+      for (i = 0; i < Event->Count; i++)
+      {
+        nbits = UPLINK_BitLength(Event->Data[i]);
+        ret |= UPLINK_PutBits(Bits, nbits, 5);
+        ret |= UPLINK_PutBits(Bits, Event->Data[i], nbits);
+      }
+      break;
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  Pack a delta time with a prefix code, short gaps take 5 bits
+  * @param  Bits the output
+  * @param  Delta the delta time
+  * @retval UPLINK_OK in case of success, UPLINK_ERROR if it does not fit
+  */
+static int32_t UPLINK_PutDelta(UPLINK_Bits_t *Bits, uint32_t Delta)
+{
+  int32_t ret;
+
+  if (Delta < (1UL << 4))
+  {
+    ret = UPLINK_PutBits(Bits, 0x0U, 1);
+    ret |= UPLINK_PutBits(Bits, Delta, 4);
+  }
+  else if (Delta < (1UL << 10))
+  {
+    ret = UPLINK_PutBits(Bits, 0x2U, 2);
+    ret |= UPLINK_PutBits(Bits, Delta, 10);
+  }
+  else if (Delta < (1UL << 18))
+  {
+    ret = UPLINK_PutBits(Bits, 0x6U, 3);
+    ret |= UPLINK_PutBits(Bits, Delta, 18);
+  }
+  else
+  {
+    ret = UPLINK_PutBits(Bits, 0x7U, 3);
+    ret |= UPLINK_PutBits(Bits, Delta, 32);
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  Append bits, MSB first
+  * @param  Bits the output
+  * @param  Value the value
+  * @param  Nbits the number of bits, 0 to 32
+  * @retval UPLINK_OK in case of success, UPLINK_ERROR if they do not fit
+  */
+static int32_t UPLINK_PutBits(UPLINK_Bits_t *Bits, uint32_t Value, uint32_t Nbits)
+{
+  uint32_t i;
+
+  if ((Bits->Pos + Nbits) > Bits->Size)
+  {
+    Bits->Pos = Bits->Size;
+    return UPLINK_ERROR;
+  }
+
+  if (Bits->Data != NULL)
+  {
+    for (i = Nbits; i > 0U; i--)
+    {
+      if (((Value >> (i - 1U)) & 1U) != 0U)
+      {
+        Bits->Data[Bits->Pos / 8U] |= (uint8_t)(0x80U >> (Bits->Pos % 8U));
+      }
+      Bits->Pos++;
+    }
+  }
+  else
+  {
+    Bits->Pos += Nbits;
+  }
+
+  return UPLINK_OK;
+}
+
+/**
+  * @brief  Number of significant bits of a value
+  * @param  Value the value
+  * @retval Bits needed, 0 for 0
+  */
+static uint32_t UPLINK_BitLength(uint32_t Value)
+{
+  uint32_t n = 0;
+
+  while (Value != 0U)
+  {
+    n++;
+    Value >>= 1;
+  }
+
+  return n;
+}
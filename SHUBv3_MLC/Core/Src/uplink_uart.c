@@ -0,0 +1,165 @@
+/**
+  ******************************************************************************
+  * @file    uplink_uart.c
+  * @author  ISCA Lab
+  * @brief   Uplink transport stand-in over the log UART
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "uplink_uart.h"
+#include "log_sink.h"
+#include "stm32wlxx_nucleo_bus.h"
+#include "task_sched.h"
+
+/*
+ * Until the SubGHz radio stack is part of the project, the payloads are
+ * printed on the log as "UPL <hex>" lines and accounted with the time on air
+ * they would take over LoRa, so the batching and the duty cycle behave as
+ * they will on the radio. A radio transport only has to provide the same
+ * three members.
+ */
+
+/* Private define ------------------------------------------------------------*/
+#define UPLINK_UART_LINE_MAX  (4U + (2U * UPLINK_UART_MAX_PAYLOAD) + 2U)
+
+/* Private function prototypes -----------------------------------------------*/
+static uint32_t UPLINK_UART_TimeOnAir(uint32_t Len);
+static int32_t UPLINK_UART_Send(const uint8_t *Data, uint32_t Len);
+static void UPLINK_UART_Task(uint32_t Events);
+static void UPLINK_UART_PostHealth(void);
+
+/* Private variables ---------------------------------------------------------*/
+static const UPLINK_Transport_t UplinkUartTransport =
+{
+  UPLINK_UART_MAX_PAYLOAD,
+  UPLINK_UART_TimeOnAir,
+  UPLINK_UART_Send
+};
+
+static const TASK_SCHED_Def_t UplinkTaskDef =
+{
+  "uplink", UPLINK_UART_Task, TASK_SCHED_PRIO_LOW, UPLINK_UART_PERIOD, 0
+};
+
+static uint32_t UplinkTaskId;
+static uint32_t LastHealth;
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Start the packetizer over the UART transport
+  * @retval None
+  */
+void UPLINK_UART_Init(void)
+{
+  LastHealth = HAL_GetTick();
+  UPLINK_Init(&UplinkUartTransport, LastHealth);
+
+  if (TASK_SCHED_Register(&UplinkTaskDef, &UplinkTaskId) != TASK_SCHED_OK)
+  {
+    Error_Handler();
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Uplink task, sends what is due and the periodic health report
+  * @param  Events the scheduler events
+  * @retval None
+  */
+static void UPLINK_UART_Task(uint32_t Events)
+{
+  uint32_t now = HAL_GetTick();
+
+  (void)Events;
+
+  if ((now - LastHealth) >= UPLINK_UART_HEALTH_PERIOD)
+  {
+    LastHealth = now;
+    UPLINK_UART_PostHealth();
+  }
+
+  UPLINK_Process(now);
+}
+
+/**
+  * @brief  Queue the health counters: log bytes dropped, I2C2 accesses
+  *         refused, uplink events dropped and deferred sends
+  * @retval None
+  */
+static void UPLINK_UART_PostHealth(void)
+{
+  uint32_t counters[UPLINK_HEALTH_MAX] = { 0 };
+  LOG_RING_Stats_t log;
+  BUS_ARB_Stats_t bus;
+  UPLINK_Stats_t uplink;
+  uint32_t client;
+
+  LOG_SINK_GetStats(&log);
+  counters[0] = log.Dropped;
+
+  for (client = 0; client < BUS_ARB_MAX_CLIENTS; client++)
+  {
+    if (BSP_I2C2_GetStats(client, &bus) == BSP_ERROR_NONE)
+    {
+      counters[1] += bus.Busy;
+    }
+  }
+
+  UPLINK_GetStats(&uplink);
+  counters[2] = uplink.Dropped;
+  counters[3] = uplink.Deferred;
+
+  (void)UPLINK_PostHealth(counters, UPLINK_HEALTH_MAX, HAL_GetTick());
+}
+
+/**
+  * @brief  Time on air of a payload over LoRa
+  * @param  Len the payload length
+  * @retval Time on air in ms
+  */
+static uint32_t UPLINK_UART_TimeOnAir(uint32_t Len)
+{
+  return UPLINK_LoraTimeOnAir(Len, UPLINK_UART_SF);
+}
+
+/**
+  * @brief  Print a payload as an hex line on the log
+  * @param  Data the payload
+  * @param  Len the payload length
+  * @retval UPLINK_OK if queued on the log, UPLINK_ERROR otherwise
+  */
+static int32_t UPLINK_UART_Send(const uint8_t *Data, uint32_t Len)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  uint8_t line[UPLINK_UART_LINE_MAX];
+  uint32_t n = 0;
+  uint32_t i;
+
+  if (Len > UPLINK_UART_MAX_PAYLOAD)
+  {
+    return UPLINK_ERROR;
+  }
+
+  line[n++] = 'U';
+  line[n++] = 'P';
+  line[n++] = 'L';
+  line[n++] = ' ';
+  for (i = 0; i < Len; i++)
+  {
+    line[n++] = (uint8_t)hex[Data[i] >> 4];
+    line[n++] = (uint8_t)hex[Data[i] & 0x0FU];
+  }
+  line[n++] = '\r';
+  line[n++] = '\n';
+
+  return (LOG_SINK_Write(line, n) == LOG_SINK_OK) ? UPLINK_OK : UPLINK_ERROR;
+}
@@ -43,6 +43,16 @@ defined in linker script */
 .word _sbss
 /* end address for the .bss section. defined in linker script */
 .word _ebss
+/* start address for the initialization values of the RAM2 code. defined in linker script */
+.word _siram2_text
+/* start address for the RAM2 code. defined in linker script */
+.word _sram2_text
+/* end address for the RAM2 code. defined in linker script */
+.word _eram2_text
+/* start address for the RAM2 buffers. defined in linker script */
+.word _sram2_bss
+/* end address for the RAM2 buffers. defined in linker script */
+.word _eram2_bss
 
 /**
  * @brief  This is the code that gets called when the processor first
@@ -94,6 +104,37 @@ LoopFillZerobss:
   cmp r2, r4
   bcc FillZerobss
 
+/* Copy the RAM2 code from flash to SRAM2 */
+  ldr r0, =_sram2_text
+  ldr r1, =_eram2_text
+  ldr r2, =_siram2_text
+  movs r3, #0
+  b LoopCopyRam2Text
+
+CopyRam2Text:
+  ldr r4, [r2, r3]
+  str r4, [r0, r3]
+  adds r3, r3, #4
+
+LoopCopyRam2Text:
+  adds r4, r0, r3
+  cmp r4, r1
+  bcc CopyRam2Text
+
+/* Zero fill the RAM2 buffers. */
+  ldr r2, =_sram2_bss
+  ldr r4, =_eram2_bss
+  movs r3, #0
+  b LoopFillZeroRam2Bss
+
+FillZeroRam2Bss:
+  str  r3, [r2]
+  adds r2, r2, #4
+
+LoopFillZeroRam2Bss:
+  cmp r2, r4
+  bcc FillZeroRam2Bss
+
 /* Call static constructors */
   bl __libc_init_array
 /* Call the application's entry point.*/
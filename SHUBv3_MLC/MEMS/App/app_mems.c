@@ -28,7 +28,10 @@ extern "C" {
 #include "custom_motion_sensors.h"
 #include "lsm6dsox_settings.h"
 #include "stm32wlxx_nucleo.h"
-#include "math.h"
+#include "mems_fixed.h"
+#include "log_sink.h"
+#include "mem_budget.h"
+#include "task_sched.h"
 
 /* Private typedef -----------------------------------------------------------*/
 typedef struct displayFloatToInt_s {
@@ -38,22 +41,37 @@ typedef struct displayFloatToInt_s {
 } displayFloatToInt_t;
 
 /* Private define ------------------------------------------------------------*/
-#define MAX_BUF_SIZE 256
+#define MAX_BUF_SIZE MEM_BUDGET_TERMINAL_OUT_SIZE
+#define TERMINAL_PERIOD  1000U /* Sensor data print period [ms] */
+#define TERMINAL_START_DELAY  5000U /* Time to read the capabilities [ms] */
+
+/* Task events */
+#define EVT_BUTTON  0x00000001U
 
 /* Private variables ---------------------------------------------------------*/
 static volatile uint8_t PushButtonDetected = 0;
 static uint8_t verbose = 1;  /* Verbose output to UART terminal ON/OFF. */
 static CUSTOM_MOTION_SENSOR_Capabilities_t MotionCapabilities[CUSTOM_MOTION_INSTANCES_NBR];
-static char dataOut[MAX_BUF_SIZE];
+static char *dataOut;
 static int32_t PushButtonState = GPIO_PIN_RESET;
+static uint32_t AccSensitivity[CUSTOM_MOTION_INSTANCES_NBR]; /* [mg/LSB, Q16] */
+static uint32_t GyrSensitivity[CUSTOM_MOTION_INSTANCES_NBR]; /* [mdps/LSB, Q16] */
+static uint32_t TerminalTaskId;
 
 /* Private function prototypes -----------------------------------------------*/
 static void floatToInt(float in, displayFloatToInt_t *out_value, int32_t dec_prec);
+static void Refresh_Sensitivity(uint32_t Instance);
 static void Motion_Accelero_Sensor_Handler(uint32_t Instance);
 static void Motion_Gyro_Sensor_Handler(uint32_t Instance);
 static void Motion_Magneto_Sensor_Handler(uint32_t Instance);
 static void MX_DataLogTerminal_Init(void);
 static void MX_DataLogTerminal_Process(void);
+static void MEMS_Task(uint32_t Events);
+
+static const TASK_SCHED_Def_t TerminalTaskDef =
+{
+  "terminal", MEMS_Task, TASK_SCHED_PRIO_LOW, TERMINAL_PERIOD, 0U
+};
 
 void MX_MEMS_Init(void)
 {
@@ -67,6 +85,11 @@ void MX_MEMS_Init(void)
 
   /* Initialize the peripherals and the MEMS components */
 
+  if (TASK_SCHED_Register(&TerminalTaskDef, &TerminalTaskId) != TASK_SCHED_OK)
+  {
+    Error_Handler();
+  }
+
   MX_DataLogTerminal_Init();
 
   /* USER CODE BEGIN MEMS_Init_PostTreatment */
@@ -90,6 +113,33 @@ void MX_MEMS_Process(void)
   /* USER CODE END MEMS_Process_PostTreatment */
 }
 
+/**
+  * @brief  Refresh the cached sensitivities of all instances, after a full
+  *         scale was written without the BSP
+  * @retval None
+  */
+void MX_MEMS_RefreshSensitivity(void)
+{
+  uint32_t i;
+
+  for (i = 0; i < CUSTOM_MOTION_INSTANCES_NBR; i++)
+  {
+    Refresh_Sensitivity(i);
+  }
+}
+
+/**
+  * @brief  DataLogTerminal task, runs every TERMINAL_PERIOD and on button press
+  * @param  Events the scheduler events
+  * @retval None
+  */
+static void MEMS_Task(uint32_t Events)
+{
+  (void)Events;
+
+  MX_MEMS_Process();
+}
+
 /**
   * @brief  Initialize the DataLogTerminal application
   * @retval None
@@ -99,6 +149,12 @@ void MX_DataLogTerminal_Init(void)
   displayFloatToInt_t out_value_odr;
   int i;
 
+  /* Take the line buffer from the memory budget */
+  if (dataOut == NULL)
+  {
+    dataOut = (char *)MEM_BUDGET_ALLOC(TERMINAL_OUT);
+  }
+
   /* Initialize LED */
   BSP_LED_Init(LED2);
 
@@ -108,24 +164,34 @@ void MX_DataLogTerminal_Init(void)
   /* Check what is the Push Button State when the button is not pressed. It can change across families */
   PushButtonState = (BSP_PB_GetState(BUTTON_KEY)) ?  0 : 1;
 
+  /* Let pending log output drain before LPUART1 is (re)initialized */
+  LOG_SINK_Flush(100);
+
   /* Initialize Virtual COM Port */
   BSP_COM_Init(COM1);
 
+  /* Route printf through the DMA log sink */
+  LOG_SINK_Init();
+
   snprintf(dataOut, MAX_BUF_SIZE, "\r\n__________________________________________________________________________\r\n");
   printf("%s", dataOut);
 
-  CUSTOM_MOTION_SENSOR_Init(CUSTOM_LSM6DSOX_0, MOTION_ACCELERO | MOTION_GYRO);
+  for(i = 0; i < CUSTOM_MOTION_INSTANCES_NBR; i++)
+  {
+    CUSTOM_MOTION_SENSOR_Init(i, MOTION_ACCELERO | MOTION_GYRO);
 
-  CUSTOM_MOTION_SENSOR_SetOutputDataRate(CUSTOM_LSM6DSOX_0, MOTION_ACCELERO, LSM6DSOX_ACC_ODR);
+    CUSTOM_MOTION_SENSOR_SetOutputDataRate(i, MOTION_ACCELERO, LSM6DSOX_ACC_ODR);
 
-  CUSTOM_MOTION_SENSOR_SetFullScale(CUSTOM_LSM6DSOX_0, MOTION_ACCELERO, LSM6DSOX_ACC_FS);
+    CUSTOM_MOTION_SENSOR_SetFullScale(i, MOTION_ACCELERO, LSM6DSOX_ACC_FS);
 
-  CUSTOM_MOTION_SENSOR_SetOutputDataRate(CUSTOM_LSM6DSOX_0, MOTION_GYRO, LSM6DSOX_GYRO_ODR);
+    CUSTOM_MOTION_SENSOR_SetOutputDataRate(i, MOTION_GYRO, LSM6DSOX_GYRO_ODR);
 
-  CUSTOM_MOTION_SENSOR_SetFullScale(CUSTOM_LSM6DSOX_0, MOTION_GYRO, LSM6DSOX_GYRO_FS);
+    CUSTOM_MOTION_SENSOR_SetFullScale(i, MOTION_GYRO, LSM6DSOX_GYRO_FS);
+  }
 
   for(i = 0; i < CUSTOM_MOTION_INSTANCES_NBR; i++)
   {
+    Refresh_Sensitivity(i);
     CUSTOM_MOTION_SENSOR_GetCapabilities(i, &MotionCapabilities[i]);
     snprintf(dataOut, MAX_BUF_SIZE,
              "\r\nMotion Sensor Instance %d capabilities: \r\n ACCELEROMETER: %d\r\n GYROSCOPE: %d\r\n MAGNETOMETER: %d\r\n LOW POWER: %d\r\n",
@@ -147,7 +213,9 @@ void MX_DataLogTerminal_Init(void)
 
   snprintf(dataOut, MAX_BUF_SIZE, "\r\nPlease wait...\r\n");
   printf("%s", dataOut);
-  HAL_Delay(5000);
+
+  /* Hold the data output back without blocking the other tasks */
+  TASK_SCHED_SetTimer(TerminalTaskId, TERMINAL_START_DELAY, TERMINAL_PERIOD);
 }
 
 /**
@@ -158,6 +226,7 @@ void MX_DataLogTerminal_Init(void)
 void BSP_PB_Callback(Button_TypeDef Button)
 {
   PushButtonDetected = 1;
+  TASK_SCHED_Post(TerminalTaskId, EVT_BUTTON);
 }
 
 /**
@@ -183,6 +252,7 @@ void MX_DataLogTerminal_Process(void)
     PushButtonDetected = 0;
 
     MX_DataLogTerminal_Init();
+    return;
   }
 
   snprintf(dataOut, MAX_BUF_SIZE, "\r\n__________________________________________________________________________\r\n");
@@ -203,8 +273,6 @@ void MX_DataLogTerminal_Process(void)
       Motion_Magneto_Sensor_Handler(i);
     }
   }
-
-  HAL_Delay( 1000 );
 }
 
 /**
@@ -216,6 +284,21 @@ void MX_DataLogTerminal_Process(void)
   */
 static void floatToInt(float in, displayFloatToInt_t *out_value, int32_t dec_prec)
 {
+  /* Powers of ten as integers, avoids the double precision pow()/trunc() emulation */
+  static const uint32_t pow10[] = {1U, 10U, 100U, 1000U, 10000U, 100000U};
+  uint32_t scale;
+  uint32_t scaled;
+
+  if (dec_prec < 0)
+  {
+    dec_prec = 0;
+  }
+  else if (dec_prec > 5)
+  {
+    dec_prec = 5;
+  }
+  scale = pow10[dec_prec];
+
   if(in >= 0.0f)
   {
     out_value->sign = 0;
@@ -225,10 +308,38 @@ static void floatToInt(float in, displayFloatToInt_t *out_value, int32_t dec_pre
     in = -in;
   }
 
-  in = in + (0.5f / pow(10, dec_prec));
-  out_value->out_int = (int32_t)in;
-  in = in - (float)(out_value->out_int);
-  out_value->out_dec = (int32_t)trunc(in * pow(10, dec_prec));
+  /* One float multiply, rounding and the split are done in integer arithmetic */
+  out_value->out_int = (uint32_t)in;
+  scaled = (uint32_t)(((in - (float)out_value->out_int) * (float)scale) + 0.5f);
+  if (scaled >= scale)
+  {
+    out_value->out_int++;
+    scaled -= scale;
+  }
+  out_value->out_dec = scaled;
+}
+
+/**
+  * @brief  Refresh the cached sensitivities of an instance from its full scales
+  * @param  Instance the device instance
+  * @retval None
+  */
+static void Refresh_Sensitivity(uint32_t Instance)
+{
+  int32_t fullScale;
+
+  AccSensitivity[Instance] = 0U;
+  GyrSensitivity[Instance] = 0U;
+
+  if (CUSTOM_MOTION_SENSOR_GetFullScale(Instance, MOTION_ACCELERO, &fullScale) == BSP_ERROR_NONE)
+  {
+    (void)MEMS_FIXED_AccSensitivity(fullScale, &AccSensitivity[Instance]);
+  }
+
+  if (CUSTOM_MOTION_SENSOR_GetFullScale(Instance, MOTION_GYRO, &fullScale) == BSP_ERROR_NONE)
+  {
+    (void)MEMS_FIXED_GyroSensitivity(fullScale, &GyrSensitivity[Instance]);
+  }
 }
 
 /**
@@ -240,21 +351,24 @@ static void Motion_Accelero_Sensor_Handler(uint32_t Instance)
 {
   float odr;
   int32_t fullScale;
-  CUSTOM_MOTION_SENSOR_Axes_t acceleration;
+  CUSTOM_MOTION_SENSOR_AxesRaw_t raw;
+  MEMS_FIXED_Axes_t acceleration;
   displayFloatToInt_t out_value;
   uint8_t whoami;
 
   snprintf(dataOut, MAX_BUF_SIZE, "\r\nMotion sensor instance %d:", (int)Instance);
   printf("%s", dataOut);
 
-  if (CUSTOM_MOTION_SENSOR_GetAxes(Instance, MOTION_ACCELERO, &acceleration))
+  if (CUSTOM_MOTION_SENSOR_GetAxesRaw(Instance, MOTION_ACCELERO, &raw))
   {
     snprintf(dataOut, MAX_BUF_SIZE, "\r\nACC[%d]: Error\r\n", (int)Instance);
   }
   else
   {
+    MEMS_FIXED_Scale(raw.x, raw.y, raw.z, AccSensitivity[Instance], &acceleration);
     snprintf(dataOut, MAX_BUF_SIZE, "\r\nACC_X[%d]: %d, ACC_Y[%d]: %d, ACC_Z[%d]: %d\r\n", (int)Instance,
-             (int)acceleration.x, (int)Instance, (int)acceleration.y, (int)Instance, (int)acceleration.z);
+             (int)MEMS_FIXED_ToMilli(acceleration.x), (int)Instance, (int)MEMS_FIXED_ToMilli(acceleration.y),
+             (int)Instance, (int)MEMS_FIXED_ToMilli(acceleration.z));
   }
 
   printf("%s", dataOut);
@@ -307,21 +421,24 @@ static void Motion_Gyro_Sensor_Handler(uint32_t Instance)
 {
   float odr;
   int32_t fullScale;
-  CUSTOM_MOTION_SENSOR_Axes_t angular_velocity;
+  CUSTOM_MOTION_SENSOR_AxesRaw_t raw;
+  MEMS_FIXED_Axes_t angular_velocity;
   displayFloatToInt_t out_value;
   uint8_t whoami;
 
   snprintf(dataOut, MAX_BUF_SIZE, "\r\nMotion sensor instance %d:", (int)Instance);
   printf("%s", dataOut);
 
-  if (CUSTOM_MOTION_SENSOR_GetAxes(Instance, MOTION_GYRO, &angular_velocity))
+  if (CUSTOM_MOTION_SENSOR_GetAxesRaw(Instance, MOTION_GYRO, &raw))
   {
     snprintf(dataOut, MAX_BUF_SIZE, "\r\nGYR[%d]: Error\r\n", (int)Instance);
   }
   else
   {
+    MEMS_FIXED_Scale(raw.x, raw.y, raw.z, GyrSensitivity[Instance], &angular_velocity);
     snprintf(dataOut, MAX_BUF_SIZE, "\r\nGYR_X[%d]: %d, GYR_Y[%d]: %d, GYR_Z[%d]: %d\r\n", (int)Instance,
-             (int)angular_velocity.x, (int)Instance, (int)angular_velocity.y, (int)Instance, (int)angular_velocity.z);
+             (int)MEMS_FIXED_ToMilli(angular_velocity.x), (int)Instance, (int)MEMS_FIXED_ToMilli(angular_velocity.y),
+             (int)Instance, (int)MEMS_FIXED_ToMilli(angular_velocity.z));
   }
 
   printf("%s", dataOut);
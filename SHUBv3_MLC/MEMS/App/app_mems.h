@@ -31,6 +31,7 @@
 /* Exported functions --------------------------------------------------------*/
 void MX_MEMS_Init(void);
 void MX_MEMS_Process(void);
+void MX_MEMS_RefreshSensitivity(void);
 
 #ifdef __cplusplus
 }
@@ -30,7 +30,20 @@ extern "C" {
 #include "stm32wlxx_nucleo_errno.h"
 
 /* USER CODE BEGIN 1 */
+/* LSM6DSOX bus, chosen at build time. CUSTOM_BUS_AUTO tries SPI1 first at
+ * probe time and falls back to I2C2 when the device does not answer. */
+#define CUSTOM_BUS_I2C   0U
+#define CUSTOM_BUS_SPI   1U
+#define CUSTOM_BUS_AUTO  2U
 
+#ifndef CUSTOM_LSM6DSOX_0_BUS
+#define CUSTOM_LSM6DSOX_0_BUS  CUSTOM_BUS_I2C
+#endif
+
+#define CUSTOM_LSM6DSOX_0_SPI_Init BSP_SPI1_Init
+#define CUSTOM_LSM6DSOX_0_SPI_DeInit BSP_SPI1_DeInit
+#define CUSTOM_LSM6DSOX_0_SPI_ReadReg BSP_SPI1_ReadReg
+#define CUSTOM_LSM6DSOX_0_SPI_WriteReg BSP_SPI1_WriteReg
 /* USER CODE END 1 */
 
 #define USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0       1U
@@ -40,6 +53,16 @@ extern "C" {
 #define CUSTOM_LSM6DSOX_0_I2C_ReadReg BSP_I2C2_ReadReg
 #define CUSTOM_LSM6DSOX_0_I2C_WriteReg BSP_I2C2_WriteReg
 
+/* Second LSM6DSOX on I2C2 with SA0 high, e.g. a limb sensor next to the body one */
+#ifndef USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1
+#define USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1       0U
+#endif
+
+#define CUSTOM_LSM6DSOX_1_I2C_Init BSP_I2C2_Init
+#define CUSTOM_LSM6DSOX_1_I2C_DeInit BSP_I2C2_DeInit
+#define CUSTOM_LSM6DSOX_1_I2C_ReadReg BSP_I2C2_ReadReg
+#define CUSTOM_LSM6DSOX_1_I2C_WriteReg BSP_I2C2_WriteReg
+
 #ifdef __cplusplus
 }
 #endif
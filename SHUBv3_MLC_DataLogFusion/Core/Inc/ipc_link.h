@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * @file    ipc_link.h
+  * @author  ISCA Lab
+  * @brief   CM0+ to CM4 sensor block link over IPCC and shared SRAM
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef IPC_LINK_H
+#define IPC_LINK_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "ipc_ring.h"
+
+/*
+ * In the dual-core build the CM0+ owns I2C2: it drains the LSM6DSOX FIFO,
+ * reads the slow sensors and the MLC, and commits one IPC_LINK_Block_t per
+ * IPC_LINK_BLOCK_SAMPLES samples to an ipc_ring in the .ipc_shared section
+ * (IPC_SHARED region of STM32WL55JCIX_FLASH.ld, same address in both images).
+ * IPCC channel 1 is the doorbell from the CM0+ to the CM4, rung only while
+ * the CM4 is armed, so the CM4 sleeps for whole blocks.
+ *
+ * The CM4 formats the ring (IPC_LINK_Init) and then releases the CM0+
+ * (IPC_LINK_StartProducer). The CM0+ side of the API is built when
+ * CORE_CM0PLUS is defined.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define IPC_LINK_REGION_SIZE    2048U /* Size of the IPC_SHARED region */
+#define IPC_LINK_BLOCK_SAMPLES  8U    /* Samples per block, 80 ms at 100 Hz */
+#define IPC_LINK_IRQ_PRIORITY   5U
+
+/* Sensor samples per stream sample: the CM0+ runs the accelerometer and the
+ * gyroscope at this many times 100 Hz and the CM4 decimates the blocks down
+ * to the stream rate (sample_decim.h). 1, 2, 4 or 8 */
+#ifndef IPC_LINK_OVERSAMPLE
+#define IPC_LINK_OVERSAMPLE     1U
+#endif
+
+#define IPC_LINK_TYPE_SENSORS   1U
+
+#define IPC_LINK_OK      0
+#define IPC_LINK_ERROR  -1
+#define IPC_LINK_BUSY   -2
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  int16_t Acc[3]; /* Raw LSB */
+  int16_t Gyr[3]; /* Raw LSB */
+} IPC_LINK_Sample_t;
+
+typedef struct
+{
+  uint32_t Timestamp;   /* CM0+ tick of the first sample [ms] */
+  uint32_t AccSens;     /* [mg/LSB, Q16], see MEMS_FIXED_AccSensitivity */
+  uint32_t GyrSens;     /* [mdps/LSB, Q16], see MEMS_FIXED_GyroSensitivity */
+  int32_t Mag[3];       /* Latest magnetometer reading [mgauss] */
+  float Press;          /* Latest pressure [hPa] */
+  float Temp;           /* Latest temperature [degC] */
+  float Hum;            /* Latest humidity [%] */
+  uint32_t MlcEvents;   /* MLC interrupts seen since start */
+  uint8_t MlcCode;      /* Last MLC0_SRC value */
+  uint8_t Count;        /* Valid samples */
+  uint8_t Reserved[2];
+  IPC_LINK_Sample_t Samples[IPC_LINK_BLOCK_SAMPLES];
+} IPC_LINK_Block_t;
+
+typedef void (*IPC_LINK_Callback_t)(void);
+
+/* Exported functions --------------------------------------------------------*/
+#if defined(CORE_CM0PLUS)
+int32_t IPC_LINK_Attach(void);
+IPC_LINK_Block_t *IPC_LINK_Reserve(void);
+void IPC_LINK_Commit(void);
+#else
+int32_t IPC_LINK_Init(IPC_LINK_Callback_t Callback);
+void IPC_LINK_StartProducer(void);
+const IPC_LINK_Block_t *IPC_LINK_Peek(void);
+void IPC_LINK_Release(void);
+int32_t IPC_LINK_Arm(void);
+void IPC_LINK_SetActive(uint8_t Active);
+void IPC_LINK_RxIRQHandler(void);
+#endif
+void IPC_LINK_GetStats(IPC_RING_Stats_t *Stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IPC_LINK_H */
@@ -0,0 +1,131 @@
+/**
+  ******************************************************************************
+  * @file    ipc_ring.h
+  * @author  ISCA Lab
+  * @brief   Inter-core single producer / single consumer block ring
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef IPC_RING_H
+#define IPC_RING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * The ring lives in a memory region shared by two cores: a control block
+ * followed by fixed size slots. Each core keeps its own IPC_RING_t handle on
+ * the region. Every control word has a single writer, so no read-modify-write
+ * is needed across cores (the Cortex-M0+ has no exclusive access).
+ *
+ * Handshake: the consumer formats the region with IPC_RING_Init and publishes
+ * the magic word last. The producer calls IPC_RING_Attach until it returns
+ * IPC_RING_OK, from then on blocks are exchanged while both sides are READY.
+ *
+ * Notification: before sleeping the consumer calls IPC_RING_Arm, which asks
+ * for a doorbell and reports data that arrived meanwhile. IPC_RING_Commit
+ * returns IPC_RING_NOTIFY only while the consumer is armed, so a burst of
+ * blocks costs one doorbell. The consumer disarms when the doorbell arrives.
+ *
+ * The module has no hardware dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define IPC_RING_MAGIC     0x49504352U /* "IPCR" */
+#define IPC_RING_VERSION   1U
+
+/* Handshake states */
+#define IPC_RING_STATE_OFF    0U
+#define IPC_RING_STATE_READY  1U
+
+#define IPC_RING_OK       0
+#define IPC_RING_ERROR   -1
+#define IPC_RING_BUSY    -2
+#define IPC_RING_NOTIFY   1 /* Commit: ring the doorbell */
+#define IPC_RING_PENDING  1 /* Arm: data already waiting, do not sleep */
+
+/* Exported types ------------------------------------------------------------*/
+/* Shared control block, at the start of the region */
+typedef struct
+{
+  uint32_t Magic;         /* Written last by the consumer */
+  uint16_t Version;
+  uint16_t SlotSize;      /* Bytes per slot, header included */
+  uint32_t SlotCount;     /* Power of two */
+  uint32_t Head;          /* Producer: slots committed */
+  uint32_t Tail;          /* Consumer: slots released */
+  uint32_t ProducerState; /* Producer */
+  uint32_t ConsumerState; /* Consumer */
+  uint32_t Armed;         /* Consumer: doorbell wanted */
+  uint32_t Dropped;       /* Producer: blocks lost on a full ring */
+  uint32_t Doorbells;     /* Producer: doorbells requested */
+} IPC_RING_Ctrl_t;
+
+/* Slot header, the payload follows */
+typedef struct
+{
+  uint32_t Sequence; /* Producer block counter, a gap means a lost block */
+  uint16_t Type;
+  uint16_t Len;
+} IPC_RING_Slot_t;
+
+/* Per core handle */
+typedef struct
+{
+  IPC_RING_Ctrl_t *Ctrl;
+  uint8_t *Slots;
+  uint32_t Sequence; /* Producer: next block number */
+} IPC_RING_t;
+
+typedef struct
+{
+  uint32_t Committed;
+  uint32_t Released;
+  uint32_t Dropped;
+  uint32_t Doorbells;
+  uint32_t Used;
+} IPC_RING_Stats_t;
+
+/* Exported macro ------------------------------------------------------------*/
+/* Payload of a slot */
+#define IPC_RING_PAYLOAD(Slot)  ((void *)((IPC_RING_Slot_t *)(Slot) + 1))
+
+/* Slot size for a payload, 8-byte aligned */
+#define IPC_RING_SLOT_SIZE(Payload)  ((sizeof(IPC_RING_Slot_t) + (Payload) + 7U) & ~7U)
+
+/* Exported functions --------------------------------------------------------*/
+/* Consumer side */
+int32_t IPC_RING_Init(IPC_RING_t *Ring, void *Region, uint32_t Size, uint32_t Payload);
+const IPC_RING_Slot_t *IPC_RING_Peek(const IPC_RING_t *Ring);
+void IPC_RING_Release(IPC_RING_t *Ring);
+int32_t IPC_RING_Arm(IPC_RING_t *Ring);
+void IPC_RING_Disarm(IPC_RING_t *Ring);
+void IPC_RING_SetConsumer(IPC_RING_t *Ring, uint32_t State);
+
+/* Producer side */
+int32_t IPC_RING_Attach(IPC_RING_t *Ring, void *Region, uint32_t Size);
+void *IPC_RING_Reserve(IPC_RING_t *Ring);
+int32_t IPC_RING_Commit(IPC_RING_t *Ring, uint16_t Type, uint16_t Len);
+
+/* Either side */
+uint32_t IPC_RING_Used(const IPC_RING_t *Ring);
+uint32_t IPC_RING_Connected(const IPC_RING_t *Ring);
+void IPC_RING_GetStats(const IPC_RING_t *Ring, IPC_RING_Stats_t *Stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IPC_RING_H */
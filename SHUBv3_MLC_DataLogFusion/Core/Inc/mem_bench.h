@@ -0,0 +1,69 @@
+/**
+  ******************************************************************************
+  * @file    mem_bench.h
+  * @author  ISCA Lab
+  * @brief   DWT cycle counts of the RAM_FUNC code, from flash or SRAM2
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef MEM_BENCH_H
+#define MEM_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * With MEM_BENCH set to 1, MX_MEMS_Init times the functions marked RAM_FUNC
+ * with the DWT cycle counter before the stream starts. Each one is called
+ * MEM_BENCH_RUNS times with interrupts masked, and the fastest call less the
+ * cost of an empty call is kept. The results are read with the debugger in
+ * MemBench, along with the clock and the flash latency they were taken at.
+ *
+ * Build once with MEM_PLACEMENT_RAM_CODE 0 and once with 1 (mem_placement.h),
+ * at the same clock, and compare: InRam tells which build each count is from.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#ifndef MEM_BENCH
+#define MEM_BENCH  0
+#endif
+
+#define MEM_BENCH_RUNS   16U
+#define MEM_BENCH_CASES  5U
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  const char *Name;
+  uint32_t Cycles;  /* Fastest call, less the empty call */
+  uint8_t InRam;    /* 1 if the function ran from SRAM2 */
+} MEM_BENCH_Result_t;
+
+typedef struct
+{
+  uint32_t CoreClock;  /* SystemCoreClock [Hz] */
+  uint32_t Latency;    /* Flash wait states */
+  uint32_t Empty;      /* Fastest empty call [cycles] */
+  MEM_BENCH_Result_t Result[MEM_BENCH_CASES];
+} MEM_BENCH_t;
+
+/* Exported functions --------------------------------------------------------*/
+void MEM_BENCH_Run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEM_BENCH_H */
@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    mem_budget.h
+  * @author  ISCA Lab
+  * @brief   Static memory budget of the firmware buffers
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/*
+ * Every large buffer of the application is listed here with its size and the
+ * SRAM bank it lives in. The buffers are carved at initialization from one
+ * pool per bank (see mem_budget.c), the pools are sized from this table and
+ * the build fails if a bank goes over its limit. Each entry is also printed
+ * as a compiler note when mem_budget.c is built.
+ *
+ * To add a buffer: add its _REGION/_SIZE pair, add it to MEM_BUDGET_TOTAL
+ * and to the report in mem_budget.c, then take it with MEM_BUDGET_ALLOC.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+/* Regions */
+#define MEM_BUDGET_SRAM1  1
+#define MEM_BUDGET_SRAM2  2
+
+/* Region limits in bytes. SRAM1 also holds .data, .bss, heap and stack,
+ * SRAM2 also holds the code copied by .ram2_text. */
+#define MEM_BUDGET_SRAM1_LIMIT  8192
+#define MEM_BUDGET_SRAM2_LIMIT  16384
+
+/* UART message reception, DMA circular buffer */
+#define MEM_BUDGET_UART_RX_REGION       MEM_BUDGET_SRAM2
+#define MEM_BUDGET_UART_RX_SIZE         512
+
+/* UART message transmission, byte stuffed frame */
+#define MEM_BUDGET_UART_TX_REGION       MEM_BUDGET_SRAM2
+#define MEM_BUDGET_UART_TX_SIZE         512
+
+/* Fusion state: MotionFX library, or the in-tree engine (FUSION_MAHONY) */
+#define MEM_BUDGET_MFX_STATE_REGION     MEM_BUDGET_SRAM2
+#if defined(FUSION_MAHONY) && (FUSION_MAHONY == 1)
+#define MEM_BUDGET_MFX_STATE_SIZE       72
+#else
+#define MEM_BUDGET_MFX_STATE_SIZE       2432
+#endif
+
+/* Offline data samples received from Unicleo */
+#define MEM_BUDGET_OFFLINE_DATA_REGION  MEM_BUDGET_SRAM1
+#define MEM_BUDGET_OFFLINE_DATA_SIZE    416
+
+/* Exported macro ------------------------------------------------------------*/
+/* Block size once aligned, same as MEM_ARENA_ROUND but usable in #if */
+#define MEM_BUDGET_ROUND(Size)  (((Size) + 7) & ~7)
+
+/* Bytes taken by an entry from a region */
+#define MEM_BUDGET_ENTRY(Name, Region) \
+  ((MEM_BUDGET_##Name##_REGION == (Region)) ? MEM_BUDGET_ROUND(MEM_BUDGET_##Name##_SIZE) : 0)
+
+/* Total size of a region pool */
+#define MEM_BUDGET_TOTAL(Region)             \
+  (MEM_BUDGET_ENTRY(UART_RX, Region)         \
+   + MEM_BUDGET_ENTRY(UART_TX, Region)       \
+   + MEM_BUDGET_ENTRY(MFX_STATE, Region)     \
+   + MEM_BUDGET_ENTRY(OFFLINE_DATA, Region))
+
+/* Take the block of an entry from its region */
+#define MEM_BUDGET_ALLOC(Name) \
+  MEM_BUDGET_Alloc(MEM_BUDGET_##Name##_REGION, MEM_BUDGET_##Name##_SIZE)
+
+/* Exported functions --------------------------------------------------------*/
+void *MEM_BUDGET_Alloc(uint32_t Region, uint32_t Size);
+uint32_t MEM_BUDGET_Available(uint32_t Region);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEM_BUDGET_H */
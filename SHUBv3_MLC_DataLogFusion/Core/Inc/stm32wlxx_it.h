@@ -60,7 +60,7 @@ void DMA1_Channel6_IRQHandler(void);
 void EXTI9_5_IRQHandler(void);
 void TIM2_IRQHandler(void);
 /* USER CODE BEGIN EFP */
-
+void IPCC_C1_RX_IRQHandler(void);
 /* USER CODE END EFP */
 
 #ifdef __cplusplus
@@ -28,6 +28,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "stm32wlxx_nucleo_conf.h"
 #include "stm32wlxx_nucleo_errno.h"
+#include "bus_arbiter.h"
 
 /** @addtogroup BSP
   * @{
@@ -65,6 +66,43 @@
    #define BUS_I2C2_FREQUENCY  1000000U /* Frequency of I2Cn = 100 KHz*/
 #endif
 
+/* I2C2 arbiter clients, the statistics are kept per client */
+#define BUS_I2C2_CLIENT_SENSOR  0U /* Sensor driver accesses (streaming, configuration) */
+#define BUS_I2C2_CLIENT_MLC     1U /* MLC service */
+#define BUS_I2C2_CLIENT_CAL     2U /* Calibration */
+
+/* SPI1, 4-wire link to the LSM6DSOX, software chip select. The device is
+ * still guarded by the I2C2 arbiter: whatever its bus, its clients are the
+ * BUS_I2C2_CLIENT_xxx ones. */
+#define BUS_SPI1_INSTANCE SPI1
+#define BUS_SPI1_SCK_GPIO_AF GPIO_AF5_SPI1
+#define BUS_SPI1_SCK_GPIO_PORT GPIOA
+#define BUS_SPI1_SCK_GPIO_PIN GPIO_PIN_5
+#define BUS_SPI1_MISO_GPIO_AF GPIO_AF5_SPI1
+#define BUS_SPI1_MISO_GPIO_PORT GPIOA
+#define BUS_SPI1_MISO_GPIO_PIN GPIO_PIN_6
+#define BUS_SPI1_MOSI_GPIO_AF GPIO_AF5_SPI1
+#define BUS_SPI1_MOSI_GPIO_PORT GPIOA
+#define BUS_SPI1_MOSI_GPIO_PIN GPIO_PIN_7
+#define BUS_SPI1_CS_GPIO_PORT GPIOA
+#define BUS_SPI1_CS_GPIO_PIN GPIO_PIN_4
+#define BUS_SPI1_GPIO_CLK_ENABLE() __HAL_RCC_GPIOA_CLK_ENABLE()
+#define BUS_SPI1_DMA_RX_CHANNEL DMA2_Channel1
+#define BUS_SPI1_DMA_TX_CHANNEL DMA2_Channel2
+
+#ifndef BUS_SPI1_POLL_TIMEOUT
+   #define BUS_SPI1_POLL_TIMEOUT                100U /* [ms] */
+#endif
+/* SPI1 highest SCK in Hz, the LSM6DSOX accepts 10 MHz. The prescaler of
+ * PCLK2 is a power of two, the closest lower frequency is used. */
+#ifndef BUS_SPI1_FREQUENCY
+   #define BUS_SPI1_FREQUENCY  10000000U
+#endif
+/* Transfers of this length and more go through DMA, shorter ones are polled */
+#ifndef BUS_SPI1_DMA_THRESHOLD
+   #define BUS_SPI1_DMA_THRESHOLD  16U
+#endif
+
 /**
   * @}
   */
@@ -109,11 +147,24 @@ int32_t BSP_I2C2_ReadReg16(uint16_t Addr, uint16_t Reg, uint8_t *pData, uint16_t
 int32_t BSP_I2C2_Send(uint16_t DevAddr, uint8_t *pData, uint16_t Length);
 int32_t BSP_I2C2_Recv(uint16_t DevAddr, uint8_t *pData, uint16_t Length);
 int32_t BSP_I2C2_SendRecv(uint16_t DevAddr, uint8_t *pTxdata, uint8_t *pRxdata, uint16_t Length);
+int32_t BSP_I2C2_Acquire(uint32_t Client);
+void BSP_I2C2_Release(void);
+int32_t BSP_I2C2_Submit(BUS_ARB_Request_t *Req);
+int32_t BSP_I2C2_GetStats(uint32_t Client, BUS_ARB_Stats_t *Stats);
 #if (USE_HAL_I2C_REGISTER_CALLBACKS == 1U)
 int32_t BSP_I2C2_RegisterDefaultMspCallbacks (void);
 int32_t BSP_I2C2_RegisterMspCallbacks (BSP_I2C_Cb_t *Callbacks);
 #endif /* (USE_HAL_I2C_REGISTER_CALLBACKS == 1U) */
 
+/* BUS IO driver over SPI Peripheral */
+int32_t BSP_SPI1_Init(void);
+int32_t BSP_SPI1_DeInit(void);
+int32_t BSP_SPI1_Send(uint8_t *pData, uint16_t Length);
+int32_t BSP_SPI1_Recv(uint8_t *pData, uint16_t Length);
+int32_t BSP_SPI1_SendRecv(uint8_t *pTxData, uint8_t *pRxData, uint16_t Length);
+int32_t BSP_SPI1_WriteReg(uint16_t Addr, uint16_t Reg, uint8_t *pData, uint16_t Length);
+int32_t BSP_SPI1_ReadReg(uint16_t Addr, uint16_t Reg, uint8_t *pData, uint16_t Length);
+
 int32_t BSP_GetTick(void);
 
 /**
@@ -0,0 +1,296 @@
+/**
+  ******************************************************************************
+  * @file    bus_arbiter.c
+  * @author  ISCA Lab
+  * @brief   Shared bus arbitration with atomic sequences and deferred requests
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <string.h>
+#include "bus_arbiter.h"
+
+/* Private function prototypes -----------------------------------------------*/
+static void BUS_ARB_Take(BUS_ARB_t *Arb, uint32_t Client, uint32_t Context);
+static void BUS_ARB_Hold(BUS_ARB_t *Arb);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize an arbiter
+  * @param  Arb the arbiter
+  * @param  Port the platform hooks, all of them are mandatory
+  * @retval None
+  */
+void BUS_ARB_Init(BUS_ARB_t *Arb, const BUS_ARB_Port_t *Port)
+{
+  (void)memset(Arb, 0, sizeof(BUS_ARB_t));
+  Arb->Port = Port;
+}
+
+/**
+  * @brief  Take the bus for a sequence of accesses
+  * @note   Nests when called again from the context owning the bus. Every
+  *         successful call must be balanced by BUS_ARB_Release.
+  * @param  Arb the arbiter
+  * @param  Client the client taking the bus
+  * @retval BUS_ARB_OK if the bus is owned, BUS_ARB_BUSY if another context
+  *         owns it, BUS_ARB_ERROR on invalid client or before BUS_ARB_Init
+  */
+int32_t BUS_ARB_Acquire(BUS_ARB_t *Arb, uint32_t Client)
+{
+  int32_t ret = BUS_ARB_OK;
+  uint32_t context;
+  uint32_t state;
+
+  /* A client may come before the bus is initialized */
+  if ((Arb->Port == NULL) || (Client >= BUS_ARB_MAX_CLIENTS))
+  {
+    return BUS_ARB_ERROR;
+  }
+
+  context = Arb->Port->Context();
+  state = Arb->Port->Lock();
+
+  if (Arb->Busy == 0U)
+  {
+    BUS_ARB_Take(Arb, Client, context);
+    Arb->Stats[Client].Acquired++;
+  }
+  else if ((Arb->OwnerContext == context) && (Arb->Depth < UINT8_MAX))
+  {
+    Arb->Depth++;
+  }
+  else
+  {
+    Arb->Stats[Client].Busy++;
+    ret = BUS_ARB_BUSY;
+  }
+
+  Arb->Port->Unlock(state);
+
+  return ret;
+}
+
+/**
+  * @brief  Give the bus back
+  * @note   The outermost release runs the queued requests, by priority and in
+  *         submission order within a priority, before freeing the bus.
+  * @param  Arb the arbiter
+  * @retval None
+  */
+void BUS_ARB_Release(BUS_ARB_t *Arb)
+{
+  BUS_ARB_Request_t *req;
+  uint32_t state;
+  int32_t status;
+  uint32_t wait;
+
+  if (Arb->Port == NULL)
+  {
+    return;
+  }
+
+  state = Arb->Port->Lock();
+
+  if (Arb->Busy == 0U)
+  {
+    Arb->Port->Unlock(state);
+    return;
+  }
+
+  if (Arb->Depth > 1U)
+  {
+    Arb->Depth--;
+    Arb->Port->Unlock(state);
+    return;
+  }
+
+  BUS_ARB_Hold(Arb);
+
+  /* The bus stays taken by this context while the queue is drained */
+  while (Arb->Queue != NULL)
+  {
+    req = Arb->Queue;
+    Arb->Queue = req->Next;
+    req->Next = NULL;
+
+    BUS_ARB_Take(Arb, req->Client, Arb->OwnerContext);
+    wait = Arb->HoldStart - req->SubmitTime;
+    Arb->Stats[req->Client].Acquired++;
+    Arb->Stats[req->Client].TotalWait += wait;
+    if (wait > Arb->Stats[req->Client].MaxWait)
+    {
+      Arb->Stats[req->Client].MaxWait = wait;
+    }
+
+    Arb->Port->Unlock(state);
+
+    status = req->Sequence(req->Context);
+    req->Pending = 0;
+    if (req->Done != NULL)
+    {
+      req->Done(req->Context, status);
+    }
+
+    state = Arb->Port->Lock();
+    BUS_ARB_Hold(Arb);
+  }
+
+  Arb->Depth = 0;
+  Arb->Busy = 0;
+
+  Arb->Port->Unlock(state);
+}
+
+/**
+  * @brief  Run a sequence of accesses with the bus owned
+  * @param  Arb the arbiter
+  * @param  Client the client running the sequence
+  * @param  Sequence the sequence
+  * @param  Context the sequence argument
+  * @retval The sequence status, BUS_ARB_BUSY if the bus could not be taken
+  */
+int32_t BUS_ARB_Run(BUS_ARB_t *Arb, uint32_t Client, BUS_ARB_Sequence_t Sequence, void *Context)
+{
+  int32_t ret = BUS_ARB_Acquire(Arb, Client);
+
+  if (ret == BUS_ARB_OK)
+  {
+    ret = Sequence(Context);
+    BUS_ARB_Release(Arb);
+  }
+
+  return ret;
+}
+
+/**
+  * @brief  Submit a request, run now if the bus is free or queued otherwise
+  * @note   Usable from interrupt handlers. A queued request runs in the
+  *         context of the current owner when it releases the bus, the Done
+  *         callback then reports the status. The request must stay valid
+  *         until Done has been called.
+  * @param  Arb the arbiter
+  * @param  Req the request
+  * @retval BUS_ARB_OK if run, BUS_ARB_QUEUED if queued, BUS_ARB_BUSY if the
+  *         request is still pending, BUS_ARB_ERROR on invalid request or
+  *         before BUS_ARB_Init
+  */
+int32_t BUS_ARB_Submit(BUS_ARB_t *Arb, BUS_ARB_Request_t *Req)
+{
+  BUS_ARB_Request_t **link;
+  uint32_t context;
+  uint32_t state;
+  int32_t status;
+
+  if ((Arb->Port == NULL) || (Req == NULL) || (Req->Sequence == NULL) || (Req->Client >= BUS_ARB_MAX_CLIENTS))
+  {
+    return BUS_ARB_ERROR;
+  }
+
+  context = Arb->Port->Context();
+  state = Arb->Port->Lock();
+
+  if (Req->Pending != 0U)
+  {
+    Arb->Port->Unlock(state);
+    return BUS_ARB_BUSY;
+  }
+
+  if (Arb->Busy == 0U)
+  {
+    BUS_ARB_Take(Arb, Req->Client, context);
+    Arb->Stats[Req->Client].Acquired++;
+    Arb->Port->Unlock(state);
+
+    status = Req->Sequence(Req->Context);
+    if (Req->Done != NULL)
+    {
+      Req->Done(Req->Context, status);
+    }
+
+    BUS_ARB_Release(Arb);
+    return BUS_ARB_OK;
+  }
+
+  /* Insert after the requests of the same or higher priority */
+  link = &Arb->Queue;
+  while ((*link != NULL) && ((*link)->Priority <= Req->Priority))
+  {
+    link = &(*link)->Next;
+  }
+
+  Req->Pending = 1;
+  Req->SubmitTime = Arb->Port->Clock();
+  Req->Next = *link;
+  *link = Req;
+  Arb->Stats[Req->Client].Queued++;
+
+  Arb->Port->Unlock(state);
+
+  return BUS_ARB_QUEUED;
+}
+
+/**
+  * @brief  Get a snapshot of the counters of a client
+  * @note   Times are in Clock units.
+  * @param  Arb the arbiter
+  * @param  Client the client
+  * @param  Stats the counters
+  * @retval BUS_ARB_OK in case of success, BUS_ARB_ERROR on invalid client or
+  *         before BUS_ARB_Init
+  */
+int32_t BUS_ARB_GetStats(const BUS_ARB_t *Arb, uint32_t Client, BUS_ARB_Stats_t *Stats)
+{
+  uint32_t state;
+
+  if ((Arb->Port == NULL) || (Client >= BUS_ARB_MAX_CLIENTS))
+  {
+    return BUS_ARB_ERROR;
+  }
+
+  state = Arb->Port->Lock();
+  *Stats = Arb->Stats[Client];
+  Arb->Port->Unlock(state);
+
+  return BUS_ARB_OK;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Mark the bus as owned, called with interrupts masked
+  * @param  Arb the arbiter
+  * @param  Client the new owner
+  * @param  Context the owner context
+  * @retval None
+  */
+static void BUS_ARB_Take(BUS_ARB_t *Arb, uint32_t Client, uint32_t Context)
+{
+  Arb->Busy = 1;
+  Arb->Depth = 1;
+  Arb->Owner = (uint8_t)Client;
+  Arb->OwnerContext = Context;
+  Arb->HoldStart = Arb->Port->Clock();
+}
+
+/**
+  * @brief  Account the ownership time of the current owner
+  * @param  Arb the arbiter
+  * @retval None
+  */
+static void BUS_ARB_Hold(BUS_ARB_t *Arb)
+{
+  uint32_t hold = Arb->Port->Clock() - Arb->HoldStart;
+
+  if (hold > Arb->Stats[Arb->Owner].MaxHold)
+  {
+    Arb->Stats[Arb->Owner].MaxHold = hold;
+  }
+}
@@ -0,0 +1,196 @@
+/**
+  ******************************************************************************
+  * @file    ipc_link.c
+  * @author  ISCA Lab
+  * @brief   CM0+ to CM4 sensor block link over IPCC and shared SRAM
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "ipc_link.h"
+#include "mem_placement.h"
+
+/* Private variables ---------------------------------------------------------*/
+/* Not initialized by the startup, the CM4 formats it before the CM0+ runs */
+IPC_SHARED static uint32_t IpcRegion[IPC_LINK_REGION_SIZE / sizeof(uint32_t)];
+static IPC_RING_t IpcRing;
+
+#if !defined(CORE_CM0PLUS)
+static IPC_LINK_Callback_t IpcCallback = NULL;
+#endif
+
+/* Exported functions --------------------------------------------------------*/
+#if defined(CORE_CM0PLUS)
+/**
+  * @brief  Join the ring formatted by the CM4 (CM0+ side)
+  * @note   Call until it stops returning IPC_LINK_BUSY.
+  * @retval IPC_LINK_OK once attached, IPC_LINK_BUSY while the CM4 is not
+  *         ready, IPC_LINK_ERROR on a layout mismatch between the images
+  */
+int32_t IPC_LINK_Attach(void)
+{
+  __HAL_RCC_IPCC_CLK_ENABLE();
+
+  switch (IPC_RING_Attach(&IpcRing, IpcRegion, sizeof(IpcRegion)))
+  {
+    case IPC_RING_OK:
+      return IPC_LINK_OK;
+
+    case IPC_RING_BUSY:
+      return IPC_LINK_BUSY;
+
+    default:
+      return IPC_LINK_ERROR;
+  }
+}
+
+/**
+  * @brief  Get the next block to fill (CM0+ side)
+  * @retval The block, NULL if the ring is full or the CM4 is not streaming
+  */
+IPC_LINK_Block_t *IPC_LINK_Reserve(void)
+{
+  return (IPC_LINK_Block_t *)IPC_RING_Reserve(&IpcRing);
+}
+
+/**
+  * @brief  Publish the block and ring the doorbell if the CM4 waits for it
+  *         (CM0+ side)
+  * @note   An occupied channel means the CM4 has not taken the previous
+  *         doorbell yet, it will see this block too.
+  * @retval None
+  */
+void IPC_LINK_Commit(void)
+{
+  if (IPC_RING_Commit(&IpcRing, IPC_LINK_TYPE_SENSORS, (uint16_t)sizeof(IPC_LINK_Block_t)) == IPC_RING_NOTIFY)
+  {
+    if ((IPCC->C2TOC1SR & IPCC_C2TOC1SR_CH1F) == 0U)
+    {
+      IPCC->C2SCR = IPCC_C2SCR_CH1S;
+    }
+  }
+}
+#else
+/**
+  * @brief  Format the ring and enable the doorbell interrupt (CM4 side)
+  * @param  Callback called from the doorbell interrupt, NULL for none
+  * @retval IPC_LINK_OK in case of success, IPC_LINK_ERROR otherwise
+  */
+int32_t IPC_LINK_Init(IPC_LINK_Callback_t Callback)
+{
+  if (IPC_RING_Init(&IpcRing, IpcRegion, sizeof(IpcRegion), sizeof(IPC_LINK_Block_t)) != IPC_RING_OK)
+  {
+    return IPC_LINK_ERROR;
+  }
+
+  IpcCallback = Callback;
+
+  /* Start paused, the stream is turned on by IPC_LINK_SetActive */
+  IPC_RING_SetConsumer(&IpcRing, IPC_RING_STATE_OFF);
+
+  __HAL_RCC_IPCC_CLK_ENABLE();
+  IPCC->C1SCR = IPCC_C1SCR_CH1C;
+  IPCC->C1MR &= ~IPCC_C1MR_CH1OM;
+  IPCC->C1CR |= IPCC_C1CR_RXOIE;
+
+  HAL_NVIC_SetPriority(IPCC_C1_RX_IRQn, IPC_LINK_IRQ_PRIORITY, 0);
+  HAL_NVIC_EnableIRQ(IPCC_C1_RX_IRQn);
+
+  return IPC_LINK_OK;
+}
+
+/**
+  * @brief  Let the CM0+ boot (CM4 side)
+  * @note   The CM0+ boot address comes from the option bytes. Call once the
+  *         sensors are powered. A CM0+ image built with the producer side
+  *         of this module must have been flashed there. The tree does not
+  *         provide one yet, so app_mems.h refuses APP_DUAL_CORE 1.
+  * @retval None
+  */
+void IPC_LINK_StartProducer(void)
+{
+  HAL_PWREx_ReleaseCore(PWR_CORE_CPU2);
+}
+
+/**
+  * @brief  Get the oldest pending block (CM4 side)
+  * @note   Blocks lost on a full ring are counted in the Dropped statistic.
+  * @retval The block, NULL if none. It stays valid until IPC_LINK_Release.
+  */
+const IPC_LINK_Block_t *IPC_LINK_Peek(void)
+{
+  const IPC_RING_Slot_t *slot = IPC_RING_Peek(&IpcRing);
+
+  return (slot != NULL) ? (const IPC_LINK_Block_t *)IPC_RING_PAYLOAD(slot) : NULL;
+}
+
+/**
+  * @brief  Give the block returned by IPC_LINK_Peek back (CM4 side)
+  * @retval None
+  */
+void IPC_LINK_Release(void)
+{
+  IPC_RING_Release(&IpcRing);
+}
+
+/**
+  * @brief  Ask for a doorbell on the next block (CM4 side)
+  * @retval IPC_LINK_OK if the core can sleep, IPC_LINK_BUSY if blocks are
+  *         already waiting
+  */
+int32_t IPC_LINK_Arm(void)
+{
+  return (IPC_RING_Arm(&IpcRing) == IPC_RING_OK) ? IPC_LINK_OK : IPC_LINK_BUSY;
+}
+
+/**
+  * @brief  Start or stop the block stream (CM4 side)
+  * @param  Active 1 to stream, 0 to let the CM0+ discard its blocks
+  * @retval None
+  */
+void IPC_LINK_SetActive(uint8_t Active)
+{
+  IPC_RING_SetConsumer(&IpcRing, (Active != 0U) ? IPC_RING_STATE_READY : IPC_RING_STATE_OFF);
+
+  if (Active != 0U)
+  {
+    (void)IPC_RING_Arm(&IpcRing);
+  }
+}
+
+/**
+  * @brief  Doorbell interrupt, call from IPCC_C1_RX_IRQHandler (CM4 side)
+  * @retval None
+  */
+void IPC_LINK_RxIRQHandler(void)
+{
+  if ((IPCC->C2TOC1SR & IPCC_C2TOC1SR_CH1F) != 0U)
+  {
+    IPCC->C1SCR = IPCC_C1SCR_CH1C;
+    IPC_RING_Disarm(&IpcRing);
+
+    if (IpcCallback != NULL)
+    {
+      IpcCallback();
+    }
+  }
+}
+#endif
+
+/**
+  * @brief  Get the ring counters
+  * @param  Stats the counters
+  * @retval None
+  */
+void IPC_LINK_GetStats(IPC_RING_Stats_t *Stats)
+{
+  IPC_RING_GetStats(&IpcRing, Stats);
+}
@@ -0,0 +1,288 @@
+/**
+  ******************************************************************************
+  * @file    ipc_ring.c
+  * @author  ISCA Lab
+  * @brief   Inter-core single producer / single consumer block ring
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "ipc_ring.h"
+#include "mem_placement.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Slots start after the control block, 8-byte aligned */
+#define CTRL_SIZE  ((sizeof(IPC_RING_Ctrl_t) + 7U) & ~7U)
+
+/* Private macro -------------------------------------------------------------*/
+/* Index publication, plain loads/stores plus a DMB on both cores. The full
+ * fence orders the arm flag against the head index, see IPC_RING_Arm. */
+#define LOAD_ACQUIRE(x)      __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define STORE_RELEASE(x, v)  __atomic_store_n(&(x), (v), __ATOMIC_RELEASE)
+#define FENCE()              __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#define SLOT(Ring, Index) \
+  ((IPC_RING_Slot_t *)&(Ring)->Slots[((Index) & ((Ring)->Ctrl->SlotCount - 1U)) * (Ring)->Ctrl->SlotSize])
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Format the shared region and open the ring (consumer side)
+  * @note   Must be done before the producer core is released: a producer
+  *         attached to a previous ring would see its indexes reset.
+  * @param  Ring the consumer handle
+  * @param  Region the shared region, 4-byte aligned
+  * @param  Size the region size in bytes
+  * @param  Payload the largest block in bytes
+  * @retval IPC_RING_OK in case of success, IPC_RING_ERROR otherwise
+  */
+int32_t IPC_RING_Init(IPC_RING_t *Ring, void *Region, uint32_t Size, uint32_t Payload)
+{
+  IPC_RING_Ctrl_t *ctrl = (IPC_RING_Ctrl_t *)Region;
+  uint32_t slot_size = IPC_RING_SLOT_SIZE(Payload);
+  uint32_t count;
+
+  if ((Ring == NULL) || (Region == NULL) || (((uintptr_t)Region & 3U) != 0U)
+      || (Payload == 0U) || (slot_size > 0xFFFFU) || (Size < CTRL_SIZE))
+  {
+    return IPC_RING_ERROR;
+  }
+
+  /* Largest power of two that fits */
+  count = (Size - CTRL_SIZE) / slot_size;
+  while ((count & (count - 1U)) != 0U)
+  {
+    count &= count - 1U;
+  }
+
+  if (count < 2U)
+  {
+    return IPC_RING_ERROR;
+  }
+
+  STORE_RELEASE(ctrl->Magic, 0U);
+  ctrl->Version = IPC_RING_VERSION;
+  ctrl->SlotSize = (uint16_t)slot_size;
+  ctrl->SlotCount = count;
+  ctrl->Head = 0;
+  ctrl->Tail = 0;
+  ctrl->ProducerState = IPC_RING_STATE_OFF;
+  ctrl->ConsumerState = IPC_RING_STATE_READY;
+  ctrl->Armed = 0;
+  ctrl->Dropped = 0;
+  ctrl->Doorbells = 0;
+  STORE_RELEASE(ctrl->Magic, IPC_RING_MAGIC);
+
+  Ring->Ctrl = ctrl;
+  Ring->Slots = (uint8_t *)Region + CTRL_SIZE;
+  Ring->Sequence = 0;
+
+  return IPC_RING_OK;
+}
+
+/**
+  * @brief  Get the oldest committed block (consumer side)
+  * @param  Ring the consumer handle
+  * @retval The slot, NULL if the ring is empty. The payload stays valid until
+  *         IPC_RING_Release.
+  */
+RAM_FUNC const IPC_RING_Slot_t *IPC_RING_Peek(const IPC_RING_t *Ring)
+{
+  uint32_t tail = Ring->Ctrl->Tail;
+
+  if (LOAD_ACQUIRE(Ring->Ctrl->Head) == tail)
+  {
+    return NULL;
+  }
+
+  return SLOT(Ring, tail);
+}
+
+/**
+  * @brief  Give the block returned by IPC_RING_Peek back (consumer side)
+  * @param  Ring the consumer handle
+  * @retval None
+  */
+RAM_FUNC void IPC_RING_Release(IPC_RING_t *Ring)
+{
+  STORE_RELEASE(Ring->Ctrl->Tail, Ring->Ctrl->Tail + 1U);
+}
+
+/**
+  * @brief  Ask for a doorbell on the next commit (consumer side)
+  * @note   Call before sleeping. The flag is raised before the head index is
+  *         checked, and the producer commits before it checks the flag, so
+  *         either this call sees the new block or the producer sees the flag.
+  * @param  Ring the consumer handle
+  * @retval IPC_RING_OK if the consumer can sleep, IPC_RING_PENDING if blocks
+  *         are waiting
+  */
+int32_t IPC_RING_Arm(IPC_RING_t *Ring)
+{
+  STORE_RELEASE(Ring->Ctrl->Armed, 1U);
+  FENCE();
+
+  return (LOAD_ACQUIRE(Ring->Ctrl->Head) != Ring->Ctrl->Tail) ? IPC_RING_PENDING : IPC_RING_OK;
+}
+
+/**
+  * @brief  Stop asking for doorbells (consumer side)
+  * @note   Called when a doorbell arrives, the consumer then drains the ring
+  *         and arms again.
+  * @param  Ring the consumer handle
+  * @retval None
+  */
+void IPC_RING_Disarm(IPC_RING_t *Ring)
+{
+  STORE_RELEASE(Ring->Ctrl->Armed, 0U);
+}
+
+/**
+  * @brief  Pause or resume the exchange (consumer side)
+  * @note   While the consumer is OFF the producer discards its blocks without
+  *         counting them as dropped.
+  * @param  Ring the consumer handle
+  * @param  State IPC_RING_STATE_OFF or IPC_RING_STATE_READY
+  * @retval None
+  */
+void IPC_RING_SetConsumer(IPC_RING_t *Ring, uint32_t State)
+{
+  STORE_RELEASE(Ring->Ctrl->ConsumerState, State);
+}
+
+/**
+  * @brief  Join a ring formatted by the consumer (producer side)
+  * @param  Ring the producer handle
+  * @param  Region the shared region
+  * @param  Size the region size in bytes, as seen by the producer
+  * @retval IPC_RING_OK once attached, IPC_RING_BUSY while the consumer has not
+  *         formatted the region, IPC_RING_ERROR on a layout mismatch
+  */
+int32_t IPC_RING_Attach(IPC_RING_t *Ring, void *Region, uint32_t Size)
+{
+  IPC_RING_Ctrl_t *ctrl = (IPC_RING_Ctrl_t *)Region;
+  uint32_t count;
+
+  if ((Ring == NULL) || (Region == NULL) || (Size < CTRL_SIZE))
+  {
+    return IPC_RING_ERROR;
+  }
+
+  if (LOAD_ACQUIRE(ctrl->Magic) != IPC_RING_MAGIC)
+  {
+    return IPC_RING_BUSY;
+  }
+
+  count = ctrl->SlotCount;
+  if ((ctrl->Version != IPC_RING_VERSION) || (count == 0U) || ((count & (count - 1U)) != 0U)
+      || ((count * ctrl->SlotSize) > (Size - CTRL_SIZE)))
+  {
+    return IPC_RING_ERROR;
+  }
+
+  Ring->Ctrl = ctrl;
+  Ring->Slots = (uint8_t *)Region + CTRL_SIZE;
+  Ring->Sequence = 0;
+  STORE_RELEASE(ctrl->ProducerState, IPC_RING_STATE_READY);
+
+  return IPC_RING_OK;
+}
+
+/**
+  * @brief  Get the payload of the next free slot (producer side)
+  * @note   A full ring counts the block as dropped, the producer keeps the
+  *         newest data of its own FIFO rather than waiting for the consumer.
+  * @param  Ring the producer handle
+  * @retval The payload, NULL if the ring is full or the consumer is OFF
+  */
+RAM_FUNC void *IPC_RING_Reserve(IPC_RING_t *Ring)
+{
+  IPC_RING_Ctrl_t *ctrl = Ring->Ctrl;
+  uint32_t head = ctrl->Head;
+
+  if (LOAD_ACQUIRE(ctrl->ConsumerState) != IPC_RING_STATE_READY)
+  {
+    return NULL;
+  }
+
+  if ((head - LOAD_ACQUIRE(ctrl->Tail)) >= ctrl->SlotCount)
+  {
+    ctrl->Dropped++;
+    return NULL;
+  }
+
+  return IPC_RING_PAYLOAD(SLOT(Ring, head));
+}
+
+/**
+  * @brief  Publish the block filled after IPC_RING_Reserve (producer side)
+  * @param  Ring the producer handle
+  * @param  Type the block type, free for the application
+  * @param  Len the payload length
+  * @retval IPC_RING_NOTIFY if the consumer waits for a doorbell, IPC_RING_OK
+  *         otherwise
+  */
+RAM_FUNC int32_t IPC_RING_Commit(IPC_RING_t *Ring, uint16_t Type, uint16_t Len)
+{
+  IPC_RING_Ctrl_t *ctrl = Ring->Ctrl;
+  uint32_t head = ctrl->Head;
+  IPC_RING_Slot_t *slot = SLOT(Ring, head);
+
+  slot->Sequence = Ring->Sequence++;
+  slot->Type = Type;
+  slot->Len = Len;
+
+  STORE_RELEASE(ctrl->Head, head + 1U);
+  FENCE();
+
+  if (LOAD_ACQUIRE(ctrl->Armed) != 0U)
+  {
+    ctrl->Doorbells++;
+    return IPC_RING_NOTIFY;
+  }
+
+  return IPC_RING_OK;
+}
+
+/**
+  * @brief  Get the number of committed blocks not yet released
+  * @param  Ring the handle
+  * @retval Pending blocks
+  */
+uint32_t IPC_RING_Used(const IPC_RING_t *Ring)
+{
+  return LOAD_ACQUIRE(Ring->Ctrl->Head) - LOAD_ACQUIRE(Ring->Ctrl->Tail);
+}
+
+/**
+  * @brief  Check the handshake
+  * @param  Ring the handle
+  * @retval 1 if both sides are READY, 0 otherwise
+  */
+uint32_t IPC_RING_Connected(const IPC_RING_t *Ring)
+{
+  return ((LOAD_ACQUIRE(Ring->Ctrl->ProducerState) == IPC_RING_STATE_READY)
+          && (LOAD_ACQUIRE(Ring->Ctrl->ConsumerState) == IPC_RING_STATE_READY)) ? 1U : 0U;
+}
+
+/**
+  * @brief  Get a snapshot of the ring counters
+  * @param  Ring the handle
+  * @param  Stats the counters
+  * @retval None
+  */
+void IPC_RING_GetStats(const IPC_RING_t *Ring, IPC_RING_Stats_t *Stats)
+{
+  Stats->Committed = LOAD_ACQUIRE(Ring->Ctrl->Head);
+  Stats->Released = LOAD_ACQUIRE(Ring->Ctrl->Tail);
+  Stats->Dropped = LOAD_ACQUIRE(Ring->Ctrl->Dropped);
+  Stats->Doorbells = LOAD_ACQUIRE(Ring->Ctrl->Doorbells);
+  Stats->Used = Stats->Committed - Stats->Released;
+}
@@ -37,6 +37,8 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "shub_v3_0.h"
+#include "task_sched.h"
+#include "ipc_link.h"
 
 /* USER CODE END Includes */
 
@@ -77,6 +79,7 @@ static void MX_TIM1_Init(void);
 static void MX_CRC_Init(void);
 static void MX_USART1_UART_Init(void);
 /* USER CODE BEGIN PFP */
+static void Sched_Idle(void);
 
 /* USER CODE END PFP */
 
@@ -108,6 +111,8 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+  /* Tasks are registered by the init functions below */
+  TASK_SCHED_Init(HAL_GetTick, Sched_Idle);
 
   /* USER CODE END SysInit */
 
@@ -124,6 +129,11 @@ int main(void)
   shub_power_i2c_on();
   shub_power_i2c_mlc_on();
 
+#if (APP_DUAL_CORE == 1)
+  /* The ring is formatted by MX_MEMS_Init, the CM0+ can take the sensors */
+  IPC_LINK_StartProducer();
+#endif
+
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -132,8 +142,10 @@ int main(void)
   {
     /* USER CODE END WHILE */
 
-  MX_MEMS_Process();
     /* USER CODE BEGIN 3 */
+
+    /* The stream, command and calibration tasks run here, never returns */
+    TASK_SCHED_Run();
   }
   /* USER CODE END 3 */
 }
@@ -505,6 +517,23 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
+/**
+  * @brief  Scheduler idle hook, sleeps until the next interrupt
+  * @note   The SysTick interrupt wakes the core every tick, which keeps the
+  *         task timers running.
+  * @retval None
+  */
+static void Sched_Idle(void)
+{
+  /* A post between the check and WFI still wakes the core: the interrupt
+   * stays pending while masked */
+  __disable_irq();
+  if (TASK_SCHED_Pending() == 0U)
+  {
+    __WFI();
+  }
+  __enable_irq();
+}
 
 /* USER CODE END 4 */
 
@@ -0,0 +1,171 @@
+/**
+  ******************************************************************************
+  * @file    mem_bench.c
+  * @author  ISCA Lab
+  * @brief   DWT cycle counts of the RAM_FUNC code, from flash or SRAM2
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "mem_bench.h"
+#include "mem_placement.h"
+
+#if (MEM_BENCH == 1)
+#include "fusion_codec.h"
+#include "mems_fixed.h"
+#include "serial_protocol.h"
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  const char *Name;
+  void (*Call)(void);
+  uintptr_t Code;  /* The function timed, to tell where it runs from */
+} MEM_BENCH_Case_t;
+
+/* Private variables ---------------------------------------------------------*/
+/* Read with the debugger */
+MEM_BENCH_t MemBench;
+
+static TMsg BenchMsg;
+static uint8_t BenchOut[(2U * TMsg_MaxLen) + 2U];
+static MEMS_FIXED_Axes_t BenchAxes;
+static MFX_output_t BenchFusion;
+static const FUSION_CODEC_Config_t BenchCodec =
+{
+  FUSION_CODEC_FIXED, FUSION_CODEC_ANGLE_FRAC, FUSION_CODEC_ACC_FRAC
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void Bench_Empty(void);
+static void Bench_Scale(void);
+static void Bench_Serialize(void);
+static void Bench_Checksum(void);
+static void Bench_Stuff(void);
+static void Bench_Codec(void);
+static uint32_t Bench_Time(void (*Call)(void));
+
+static const MEM_BENCH_Case_t BenchCases[MEM_BENCH_CASES] =
+{
+  { "MEMS_FIXED_Scale", Bench_Scale, (uintptr_t)MEMS_FIXED_Scale },
+  { "Serialize_s32", Bench_Serialize, (uintptr_t)Serialize_s32 },
+  { "CHK_ComputeAndAdd", Bench_Checksum, (uintptr_t)CHK_ComputeAndAdd },
+  { "ByteStuffCopy", Bench_Stuff, (uintptr_t)ByteStuffCopy },
+  { "FUSION_CODEC_Encode", Bench_Codec, (uintptr_t)FUSION_CODEC_Encode },
+};
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Time every case and fill MemBench
+  * @note   The cycle counter is left running, it is not reset.
+  * @retval None
+  */
+void MEM_BENCH_Run(void)
+{
+  uint32_t i;
+
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  /* A 119 byte stream frame, with bytes to stuff */
+  BenchMsg.Len = 118U;
+  for (i = 0; i < BenchMsg.Len; i++)
+  {
+    BenchMsg.Data[i] = (uint8_t)(i * 37U);
+  }
+  BenchFusion.quaternion[0] = 0.1f;
+  BenchFusion.quaternion[1] = -0.2f;
+  BenchFusion.quaternion[2] = 0.3f;
+  BenchFusion.quaternion[3] = 0.927f;
+  BenchFusion.rotation[0] = 123.4f;
+  BenchFusion.gravity[2] = -0.98f;
+  BenchFusion.linear_acceleration[0] = 0.05f;
+  BenchFusion.heading = 87.5f;
+
+  MemBench.CoreClock = SystemCoreClock;
+  MemBench.Latency = __HAL_FLASH_GET_LATENCY();
+  MemBench.Empty = Bench_Time(Bench_Empty);
+
+  for (i = 0; i < MEM_BENCH_CASES; i++)
+  {
+    uint32_t cycles = Bench_Time(BenchCases[i].Call);
+
+    MemBench.Result[i].Name = BenchCases[i].Name;
+    MemBench.Result[i].Cycles = (cycles > MemBench.Empty) ? (cycles - MemBench.Empty) : 0U;
+    MemBench.Result[i].InRam = ((BenchCases[i].Code & 0xFFFF8000U) == SRAM2_BASE) ? 1U : 0U;
+  }
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Fastest of MEM_BENCH_RUNS calls
+  * @param  Call the case
+  * @retval The cycles of the fastest call
+  */
+static uint32_t Bench_Time(void (*Call)(void))
+{
+  uint32_t best = UINT32_MAX;
+  uint32_t primask;
+  uint32_t start;
+  uint32_t cycles;
+  uint32_t i;
+
+  for (i = 0; i < MEM_BENCH_RUNS; i++)
+  {
+    primask = __get_PRIMASK();
+    __disable_irq();
+    start = DWT->CYCCNT;
+    Call();
+    cycles = DWT->CYCCNT - start;
+    __set_PRIMASK(primask);
+
+    if (cycles < best)
+    {
+      best = cycles;
+    }
+  }
+
+  return best;
+}
+
+/* The cases, one call each */
+static void Bench_Empty(void)
+{
+  __NOP();
+}
+
+static void Bench_Scale(void)
+{
+  MEMS_FIXED_Scale(1234, -2345, 16000, 3998U, &BenchAxes);
+}
+
+static void Bench_Serialize(void)
+{
+  Serialize_s32(BenchOut, -123456, 4U);
+}
+
+static void Bench_Checksum(void)
+{
+  BenchMsg.Len = 118U;
+  CHK_ComputeAndAdd(&BenchMsg);
+}
+
+static void Bench_Stuff(void)
+{
+  (void)ByteStuffCopy(BenchOut, &BenchMsg);
+}
+
+static void Bench_Codec(void)
+{
+  (void)FUSION_CODEC_Encode(&BenchCodec, &BenchFusion, BenchOut);
+}
+
+#endif /* MEM_BENCH == 1 */
@@ -22,6 +22,8 @@
 #include "stm32wlxx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "app_mems.h"
+#include "ipc_link.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -256,5 +258,13 @@ void TIM2_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
-
+#if (APP_DUAL_CORE == 1)
+/**
+  * @brief This function handles IPCC CPU1 RX occupied Interrupt.
+  */
+void IPCC_C1_RX_IRQHandler(void)
+{
+  IPC_LINK_RxIRQHandler();
+}
+#endif
 /* USER CODE END 1 */
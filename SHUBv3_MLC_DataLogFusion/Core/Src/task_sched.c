@@ -0,0 +1,379 @@
+/**
+  ******************************************************************************
+  * @file    task_sched.c
+  * @author  ISCA Lab
+  * @brief   Cooperative run-to-completion task scheduler
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "task_sched.h"
+
+/* Private macro -------------------------------------------------------------*/
+/* Shared with interrupts. On the Cortex-M4 the read-modify-write ones compile
+ * to LDREX/STREX loops, no interrupt masking is needed. */
+#define ATOMIC_LOAD(x)      __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+#define ATOMIC_OR(x, v)     __atomic_fetch_or(&(x), (v), __ATOMIC_ACQ_REL)
+#define ATOMIC_AND(x, v)    __atomic_fetch_and(&(x), (v), __ATOMIC_ACQ_REL)
+#define ATOMIC_XCHG(x, v)   __atomic_exchange_n(&(x), (v), __ATOMIC_ACQ_REL)
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  const TASK_SCHED_Def_t *Def;
+  uint32_t Events;    /* Pending events, written from interrupts */
+  uint32_t PostTime;  /* Time of the first post since the last run */
+  uint32_t TimerNext;
+  uint32_t TimerPeriod;
+  uint8_t TimerActive;
+  TASK_SCHED_Stats_t Stats;
+} TASK_SCHED_Task_t;
+
+/* Private variables ---------------------------------------------------------*/
+static TASK_SCHED_Task_t Tasks[TASK_SCHED_MAX_TASKS];
+static uint32_t TaskCount = 0;
+static uint32_t ReadyMask[TASK_SCHED_PRIO_NBR]; /* One bit per task id */
+static uint32_t LastRun[TASK_SCHED_PRIO_NBR];
+static TASK_SCHED_Clock_t SchedClock = NULL;
+static TASK_SCHED_Idle_t SchedIdle = NULL;
+
+_Static_assert(TASK_SCHED_MAX_TASKS <= 32U, "Ready masks hold at most 32 tasks");
+
+/* Private function prototypes -----------------------------------------------*/
+static void TASK_SCHED_CheckTimers(uint32_t Now);
+static uint32_t TASK_SCHED_Pick(uint32_t Mask, uint32_t Last);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize the scheduler, dropping all registered tasks
+  * @param  Clock the time source used for timers and statistics
+  * @param  Idle called when no task is ready, may be NULL
+  * @retval None
+  */
+void TASK_SCHED_Init(TASK_SCHED_Clock_t Clock, TASK_SCHED_Idle_t Idle)
+{
+  uint32_t i;
+
+  for (i = 0; i < TASK_SCHED_PRIO_NBR; i++)
+  {
+    ReadyMask[i] = 0;
+    LastRun[i] = TASK_SCHED_MAX_TASKS - 1U; /* First pick is the lowest id */
+  }
+
+  TaskCount = 0;
+  SchedClock = Clock;
+  SchedIdle = Idle;
+}
+
+/**
+  * @brief  Register a task
+  * @note   To be called at initialization, before events are posted.
+  * @param  Def the task definition, must stay valid
+  * @param  Id the task id to post events to
+  * @retval TASK_SCHED_OK in case of success, TASK_SCHED_ERROR otherwise
+  */
+int32_t TASK_SCHED_Register(const TASK_SCHED_Def_t *Def, uint32_t *Id)
+{
+  TASK_SCHED_Task_t *task;
+
+  if ((Def == NULL) || (Def->Handler == NULL) || (Def->Priority >= TASK_SCHED_PRIO_NBR)
+      || (TaskCount >= TASK_SCHED_MAX_TASKS) || (SchedClock == NULL))
+  {
+    return TASK_SCHED_ERROR;
+  }
+
+  task = &Tasks[TaskCount];
+  task->Def = Def;
+  task->Events = 0;
+  task->PostTime = 0;
+  task->TimerActive = 0;
+  task->Stats.Runs = 0;
+  task->Stats.MaxLatency = 0;
+  task->Stats.MaxRunTime = 0;
+  task->Stats.DeadlineMisses = 0;
+
+  *Id = TaskCount;
+  TaskCount++;
+
+  if (Def->Period != 0U)
+  {
+    TASK_SCHED_SetTimer(*Id, Def->Period, Def->Period);
+  }
+
+  return TASK_SCHED_OK;
+}
+
+/**
+  * @brief  Post events to a task
+  * @note   Safe from interrupts. Events already pending are merged.
+  * @param  Id the task id
+  * @param  Events the events, non-zero
+  * @retval None
+  */
+void TASK_SCHED_Post(uint32_t Id, uint32_t Events)
+{
+  TASK_SCHED_Task_t *task;
+  uint32_t now;
+
+  if ((Id >= TaskCount) || (Events == 0U))
+  {
+    return;
+  }
+
+  task = &Tasks[Id];
+  now = SchedClock();
+
+  /* Latency is measured from the first post the task has not seen yet */
+  if (ATOMIC_OR(task->Events, Events) == 0U)
+  {
+    task->PostTime = now;
+  }
+
+  (void)ATOMIC_OR(ReadyMask[task->Def->Priority], 1UL << Id);
+}
+
+/**
+  * @brief  Start the timer of a task
+  * @note   Not safe from interrupts, call from tasks or at initialization.
+  * @param  Id the task id
+  * @param  Delay the time to the first TASK_SCHED_EVT_TIMER
+  * @param  Period the time between the next ones, 0 for a single one
+  * @retval None
+  */
+void TASK_SCHED_SetTimer(uint32_t Id, uint32_t Delay, uint32_t Period)
+{
+  if (Id >= TaskCount)
+  {
+    return;
+  }
+
+  Tasks[Id].TimerNext = SchedClock() + Delay;
+  Tasks[Id].TimerPeriod = Period;
+  Tasks[Id].TimerActive = 1;
+}
+
+/**
+  * @brief  Stop the timer of a task
+  * @param  Id the task id
+  * @retval None
+  */
+void TASK_SCHED_StopTimer(uint32_t Id)
+{
+  if (Id < TaskCount)
+  {
+    Tasks[Id].TimerActive = 0;
+  }
+}
+
+/**
+  * @brief  Check if a task has events pending
+  * @note   An idle hook that sleeps should mask interrupts, call this and
+  *         only then wait for an interrupt, so a post is never missed.
+  * @retval 0 if no task is ready
+  */
+uint32_t TASK_SCHED_Pending(void)
+{
+  uint32_t pending = 0;
+  uint32_t i;
+
+  for (i = 0; i < TASK_SCHED_PRIO_NBR; i++)
+  {
+    pending |= ATOMIC_LOAD(ReadyMask[i]);
+  }
+
+  return pending;
+}
+
+/**
+  * @brief  Get the time to the first task timer due
+  * @note   For an idle hook that stops the clock: nothing has to run before
+  *         that time unless an interrupt posts events.
+  * @param  Delay the time left, 0 if a timer is already due
+  * @retval TASK_SCHED_OK, TASK_SCHED_ERROR if no timer is running
+  */
+int32_t TASK_SCHED_NextTimer(uint32_t *Delay)
+{
+  uint32_t now = SchedClock();
+  int32_t left;
+  int32_t first = INT32_MAX;
+  uint32_t i;
+
+  for (i = 0; i < TaskCount; i++)
+  {
+    if (Tasks[i].TimerActive == 0U)
+    {
+      continue;
+    }
+
+    left = (int32_t)(Tasks[i].TimerNext - now);
+    if (left < first)
+    {
+      first = left;
+    }
+  }
+
+  if (first == INT32_MAX)
+  {
+    return TASK_SCHED_ERROR;
+  }
+
+  *Delay = (first > 0) ? (uint32_t)first : 0U;
+  return TASK_SCHED_OK;
+}
+
+/**
+  * @brief  Run the highest priority ready task once
+  * @retval 1 if a task ran, 0 if none was ready
+  */
+uint32_t TASK_SCHED_RunOnce(void)
+{
+  TASK_SCHED_Task_t *task;
+  uint32_t prio;
+  uint32_t mask = 0;
+  uint32_t id;
+  uint32_t events;
+  uint32_t start;
+  uint32_t elapsed;
+
+  TASK_SCHED_CheckTimers(SchedClock());
+
+  for (prio = 0; prio < TASK_SCHED_PRIO_NBR; prio++)
+  {
+    mask = ATOMIC_LOAD(ReadyMask[prio]);
+    if (mask != 0U)
+    {
+      break;
+    }
+  }
+
+  if (mask == 0U)
+  {
+    return 0;
+  }
+
+  id = TASK_SCHED_Pick(mask, LastRun[prio]);
+  LastRun[prio] = id;
+  task = &Tasks[id];
+
+  /* Clear the ready bit before taking the events: a post in between leaves
+   * the bit set and at worst costs one run with no events */
+  (void)ATOMIC_AND(ReadyMask[prio], ~(1UL << id));
+  events = ATOMIC_XCHG(task->Events, 0U);
+  if (events == 0U)
+  {
+    return 1;
+  }
+
+  start = SchedClock();
+  task->Def->Handler(events);
+  elapsed = SchedClock() - start;
+
+  task->Stats.Runs++;
+  if ((start - task->PostTime) > task->Stats.MaxLatency)
+  {
+    task->Stats.MaxLatency = start - task->PostTime;
+  }
+  if (elapsed > task->Stats.MaxRunTime)
+  {
+    task->Stats.MaxRunTime = elapsed;
+  }
+  if ((task->Def->Deadline != 0U) && (((start - task->PostTime) + elapsed) > task->Def->Deadline))
+  {
+    task->Stats.DeadlineMisses++;
+  }
+
+  return 1;
+}
+
+/**
+  * @brief  Run the tasks forever, calling the idle hook when none is ready
+  * @retval None
+  */
+void TASK_SCHED_Run(void)
+{
+  for (;;)
+  {
+    if ((TASK_SCHED_RunOnce() == 0U) && (SchedIdle != NULL))
+    {
+      SchedIdle();
+    }
+  }
+}
+
+/**
+  * @brief  Get the statistics of a task
+  * @param  Id the task id
+  * @param  Stats the statistics
+  * @retval TASK_SCHED_OK in case of success, TASK_SCHED_ERROR otherwise
+  */
+int32_t TASK_SCHED_GetStats(uint32_t Id, TASK_SCHED_Stats_t *Stats)
+{
+  if (Id >= TaskCount)
+  {
+    return TASK_SCHED_ERROR;
+  }
+
+  *Stats = Tasks[Id].Stats;
+  return TASK_SCHED_OK;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Post the timer event of the tasks whose timer expired
+  * @param  Now the current time
+  * @retval None
+  */
+static void TASK_SCHED_CheckTimers(uint32_t Now)
+{
+  TASK_SCHED_Task_t *task;
+  uint32_t i;
+
+  for (i = 0; i < TaskCount; i++)
+  {
+    task = &Tasks[i];
+
+    if ((task->TimerActive == 0U) || ((int32_t)(Now - task->TimerNext) < 0))
+    {
+      continue;
+    }
+
+    TASK_SCHED_Post(i, TASK_SCHED_EVT_TIMER);
+
+    if (task->TimerPeriod == 0U)
+    {
+      task->TimerActive = 0;
+    }
+    else
+    {
+      task->TimerNext += task->TimerPeriod;
+
+      /* Periods missed while a long task ran are skipped, not queued */
+      if ((int32_t)(Now - task->TimerNext) >= 0)
+      {
+        task->TimerNext = Now + task->TimerPeriod;
+      }
+    }
+  }
+}
+
+/**
+  * @brief  Pick the next task among the ready ones of a priority
+  * @note   Round robin: the first ready task after the last one run.
+  * @param  Mask the ready tasks, non-zero
+  * @param  Last the task run last at this priority
+  * @retval The task id
+  */
+static uint32_t TASK_SCHED_Pick(uint32_t Mask, uint32_t Last)
+{
+  uint32_t after = Mask & ~((2UL << Last) - 1UL);
+
+  return (uint32_t)__builtin_ctz((after != 0U) ? after : Mask);
+}
@@ -32,73 +32,164 @@ extern "C" {
 #include "bsp_ip_conf.h"
 #include "fw_version.h"
 #include "motion_fx_manager.h"
+#include "mem_bench.h"
+#include "mem_budget.h"
+#include "task_sched.h"
+#include "mlc_manager.h"
+#include "ipc_link.h"
+#include "sample_pipe.h"
+#include "sample_decim.h"
+#if (APP_DRDY_SAMPLING == 1)
+#include "sample_slip.h"
+#endif
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
 #define DWT_LAR_KEY  0xC5ACCE55 /* DWT register unlock key */
 #define ALGO_FREQ  100U /* Algorithm frequency 100Hz */
-#define ACC_ODR  ((float)ALGO_FREQ)
-#define ACC_FS  4 /* FS = <-4g, 4g> */
+#if (APP_DUAL_CORE == 1)
+#define SAMPLE_FACTOR  IPC_LINK_OVERSAMPLE
+#else
+#define SAMPLE_FACTOR  APP_OVERSAMPLE
+#endif
+#define SENSOR_FREQ  (ALGO_FREQ * SAMPLE_FACTOR) /* Accelerometer and gyroscope read rate [Hz] */
+#define ACC_FS  2 /* FS = <-2g, 2g>, the one the MLC program runs at */
 #define ALGO_PERIOD  (1000U / ALGO_FREQ) /* Algorithm period [ms] */
 #define MOTION_FX_ENGINE_DELTATIME  0.01f
-#define FROM_MG_TO_G  0.001f
-#define FROM_G_TO_MG  1000.0f
-#define FROM_MDPS_TO_DPS  0.001f
-#define FROM_DPS_TO_MDPS  1000.0f
 #define FROM_MGAUSS_TO_UT50  (0.1f/50.0f)
 #define FROM_UT50_TO_MGAUSS  500.0f
+#define COMMAND_PERIOD  1U /* UART command polling period [ms] */
+#define DEBOUNCE_TIME  50U /* Push button debouncing [ms] */
+#define RELEASE_POLL  10U /* Push button release polling [ms] */
+
+#if (APP_DRDY_SAMPLING == 1) && (APP_DUAL_CORE == 1)
+#error "APP_DRDY_SAMPLING needs the sensors on the CM4"
+#endif
+
+/* Task events */
+#define EVT_BUTTON  0x00000001U
 
 /* Public variables ----------------------------------------------------------*/
 volatile uint8_t DataLoggerActive = 0;
 volatile uint32_t SensorsEnabled = 0;
 char LibVersion[35];
 int LibVersionLen;
-volatile uint8_t SensorReadRequest = 0;
+uint32_t StreamTaskId;
 uint8_t UseOfflineData = 0;
-offline_data_t OfflineData[OFFLINE_DATA_SIZE];
+offline_data_t *OfflineData;
 int OfflineDataReadIndex = 0;
 int OfflineDataWriteIndex = 0;
 int OfflineDataCount = 0;
 uint32_t AlgoFreq = ALGO_FREQ;
 uint8_t Enabled6X = 0;
+FUSION_CODEC_Config_t StreamFormat = { (uint8_t)FUSION_CODEC_FLOAT, FUSION_CODEC_ANGLE_FRAC, FUSION_CODEC_ACC_FRAC };
+STREAM_PLAN_t StreamPlan; /* No subscription, the full frame is sent */
 static int32_t PushButtonState = GPIO_PIN_RESET;
 
+_Static_assert((OFFLINE_DATA_SIZE * sizeof(offline_data_t)) <= MEM_BUDGET_OFFLINE_DATA_SIZE,
+               "Offline data budget too small");
+
 /* Extern variables ----------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
-static MOTION_SENSOR_Axes_t AccValue;
-static MOTION_SENSOR_Axes_t GyrValue;
+static MEMS_FIXED_Axes_t AccValue; /* [mg, Q23.8] */
+static MEMS_FIXED_Axes_t GyrValue; /* [mdps, Q23.8] */
 static MOTION_SENSOR_Axes_t MagValue;
 static float PressValue;
 static float TempValue;
 static float HumValue;
 static volatile uint32_t TimeStamp = 0;
-static volatile uint8_t MagCalRequest = 0;
+static uint32_t MagCalTaskId;
+static uint32_t CommandTaskId;
+static uint8_t MagCalButtonState = 0; /* 0 idle, 1 wait for release, 2 release debouncing */
 static MOTION_SENSOR_Axes_t MagOffset;
 static uint8_t MagCalStatus = 0;
+static uint32_t DwtStart;        /* DWT->CYCCNT at DWT_Start */
+static TMsg StreamMsg;           /* Full frame, the stages write into it */
+static SAMPLE_PIPE_t StreamPipe; /* Built by Stream_Build */
+static uint32_t StreamLen;
+#if (APP_DUAL_CORE == 1)
+static const IPC_LINK_Block_t *IpcBlock = NULL; /* Block being streamed */
+static uint32_t IpcIndex = 0; /* Next sample in IpcBlock */
+static MLC_output_t IpcMlc;
+#else
+static uint32_t OfflineTicks = 0; /* Reads since the last offline record */
+
+/* What the fusion and the stream need of the sensors, the MLC program adds
+ * its own. The fusion runs on the decimated samples, the stream reads them
+ * SAMPLE_FACTOR times faster and averages out the low-power noise. */
+static const SENSOR_PLAN_Req_t SensorNeeds[] =
+{
+  { "fusion", ALGO_FREQ * 10U, ALGO_FREQ * 10U, 0U, 0U, 0U, 0U, 0U, SENSOR_PLAN_MODE_HP, SENSOR_PLAN_MODE_HP },
+  { "stream", SENSOR_FREQ * 10U, SENSOR_FREQ * 10U, 0U, 0U, 0U, 0U, 0U, SENSOR_PLAN_MODE_LP, SENSOR_PLAN_MODE_LP },
+};
+#endif
+static SAMPLE_DECIM_t AccDecim; /* Sensor samples to the stream rate */
+static SAMPLE_DECIM_t GyrDecim;
+static float FxDeltaTime = MOTION_FX_ENGINE_DELTATIME; /* Time since the previous fusion run [s] */
+#if (APP_DRDY_SAMPLING == 1)
+static SAMPLE_SLIP_t Slip; /* Duplicate and missed samples of the data-ready reads */
+static uint32_t SlipPeriods = 0; /* Sensor periods since the previous stream sample */
+#endif
 
 /* Private function prototypes -----------------------------------------------*/
 static void MX_DataLogFusion_Init(void);
 static void MX_DataLogFusion_Process(void);
-static void FX_Data_Handler(TMsg *Msg);
+static void Command_Task(uint32_t Events);
+static void Stream_Task(uint32_t Events);
+static void MagCal_Task(uint32_t Events);
+static void Stream_Build(void);
+#if (APP_DUAL_CORE == 0)
 static void Init_Sensors(void);
-static void RTC_Handler(TMsg *Msg);
-static void Accelero_Sensor_Handler(TMsg *Msg);
-static void Gyro_Sensor_Handler(TMsg *Msg);
-static void Magneto_Sensor_Handler(TMsg *Msg);
-static void Pressure_Sensor_Handler(TMsg *Msg);
-static void Temperature_Sensor_Handler(TMsg *Msg);
-static void Humidity_Sensor_Handler(TMsg *Msg);
+static uint8_t Motion_Read(void);
+#endif
+static void RTC_Stage(void *Source, uint8_t *Sink);
+static void Offline_Stage(void *Source, uint8_t *Sink);
+static void Offline_Next_Stage(void *Source, uint8_t *Sink);
+static void Accelero_Stage(void *Source, uint8_t *Sink);
+static void Gyro_Stage(void *Source, uint8_t *Sink);
+static void Magneto_Stage(void *Source, uint8_t *Sink);
+static void Pressure_Stage(void *Source, uint8_t *Sink);
+static void Temperature_Stage(void *Source, uint8_t *Sink);
+static void Humidity_Stage(void *Source, uint8_t *Sink);
+static void FX_Float_Stage(void *Source, uint8_t *Sink);
+static void FX_Compact_Stage(void *Source, uint8_t *Sink);
+static void FX_Idle_Stage(void *Source, uint8_t *Sink);
+static void MLC_Stage(void *Source, uint8_t *Sink);
+static uint32_t FX_Run(MFX_output_t *Output);
+static void Put_Fixed_Axes(const MEMS_FIXED_Axes_t *Axes, uint8_t *Sink);
+#if (APP_DUAL_CORE == 1)
+static uint8_t IPC_Data_Handler(void);
+static void IPC_Doorbell(void);
+#endif
 static void TIM_Config(uint32_t Freq);
 static void DWT_Init(void);
 static void DWT_Start(void);
 static uint32_t DWT_Stop(void);
 
-#ifdef BSP_IP_MEMS_INT1_PIN_NUM
+#if defined(BSP_IP_MEMS_INT1_PIN_NUM) && (APP_DUAL_CORE == 0)
 static void MEMS_INT1_Force_Low(void);
 static void MEMS_INT1_Init(void);
 #endif
 
+/* Sensor read and fusion, one run per timer period */
+static const TASK_SCHED_Def_t StreamTaskDef =
+{
+  "stream", Stream_Task, TASK_SCHED_PRIO_HIGH, 0U, ALGO_PERIOD
+};
+
+/* Unicleo command handling */
+static const TASK_SCHED_Def_t CommandTaskDef =
+{
+  "command", Command_Task, TASK_SCHED_PRIO_NORMAL, COMMAND_PERIOD, 0U
+};
+
+/* Magnetometer calibration restart from the push button */
+static const TASK_SCHED_Def_t MagCalTaskDef =
+{
+  "magcal", MagCal_Task, TASK_SCHED_PRIO_LOW, 0U, 0U
+};
+
 void MX_MEMS_Init(void)
 {
   /* USER CODE BEGIN SV */
@@ -145,10 +236,74 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
   if (htim->Instance == BSP_IP_TIM_Handle.Instance)
   {
-    SensorReadRequest = 1;
+    TASK_SCHED_Post(StreamTaskId, STREAM_EVT_READ);
+  }
+}
+
+#if (APP_DRDY_SAMPLING == 1)
+/**
+ * @brief  EXTI line detection callback
+ * @param  GPIO_Pin the pin of the EXTI line
+ * @retval None
+ */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  if (GPIO_Pin == BSP_IP_MEMS_INT2_PIN_NUM)
+  {
+    TASK_SCHED_Post(StreamTaskId, STREAM_EVT_READ);
+  }
+}
+#endif
+
+#if (APP_DUAL_CORE == 0)
+/**
+ * @brief  Start the sensor reads of the stream
+ * @note   The enabled sensors are set up by the caller. The accelerometer
+ *         and the gyroscope are read SAMPLE_FACTOR times per stream sample.
+ * @retval None
+ */
+void MX_MEMS_Start_Sampling(void)
+{
+  /* The filters restart on the first read */
+  SAMPLE_DECIM_Reset(&AccDecim);
+  SAMPLE_DECIM_Reset(&GyrDecim);
+  OfflineTicks = 0;
+
+#if (APP_DRDY_SAMPLING == 1)
+  float odr = 0.0f;
+
+  /* One pulse per accelerometer sample on INT2, the timestamp tells the
+   * samples apart */
+  BSP_SENSOR_ACC_GetOutputDataRate(&odr);
+  if (SAMPLE_SLIP_Init(&Slip, SAMPLE_SLIP_Period(odr)) != SAMPLE_SLIP_OK)
+  {
+    Error_Handler();
   }
+  SlipPeriods = 0;
+  BSP_SENSOR_ACC_SetTimestamp(1);
+  BSP_SENSOR_ACC_SetDRDYMode(1);
+  BSP_SENSOR_ACC_SetDRDYInt(1);
+#else
+  (void)HAL_TIM_Base_Start_IT(&BSP_IP_TIM_Handle);
+#endif
 }
 
+/**
+ * @brief  Stop the sensor reads of the stream
+ * @retval None
+ */
+void MX_MEMS_Stop_Sampling(void)
+{
+#if (APP_DRDY_SAMPLING == 1)
+  BSP_SENSOR_ACC_SetDRDYInt(0);
+  BSP_SENSOR_ACC_SetDRDYMode(0);
+  BSP_SENSOR_ACC_SetTimestamp(0);
+#else
+  (void)HAL_TIM_Base_Stop_IT(&BSP_IP_TIM_Handle);
+#endif
+}
+#endif
+
 /* Private functions ---------------------------------------------------------*/
 /**
   * @brief  Initialize the application
@@ -158,7 +313,7 @@ static void MX_DataLogFusion_Init(void)
 {
   float ans_float;
 
-#ifdef BSP_IP_MEMS_INT1_PIN_NUM
+#if defined(BSP_IP_MEMS_INT1_PIN_NUM) && (APP_DUAL_CORE == 0)
   /* Force MEMS INT1 pin of the sensor low during startup in order to disable I3C and enable I2C. This function needs
    * to be called only if user wants to disable I3C / enable I2C and didn't put the pull-down resistor to MEMS INT1 pin
    * on his HW setup. This is also the case of usage X-NUCLEO-IKS01A2 or X-NUCLEO-IKS01A3 expansion board together with
@@ -167,6 +322,22 @@ static void MX_DataLogFusion_Init(void)
   MEMS_INT1_Force_Low();
 #endif
 
+  if ((TASK_SCHED_Register(&StreamTaskDef, &StreamTaskId) != TASK_SCHED_OK)
+      || (TASK_SCHED_Register(&CommandTaskDef, &CommandTaskId) != TASK_SCHED_OK)
+      || (TASK_SCHED_Register(&MagCalTaskDef, &MagCalTaskId) != TASK_SCHED_OK))
+  {
+    Error_Handler();
+  }
+
+  /* Take the offline data buffer from the memory budget */
+  if (OfflineData == NULL)
+  {
+    OfflineData = (offline_data_t *)MEM_BUDGET_ALLOC(OFFLINE_DATA);
+  }
+
+  /* Stages of the default configuration, rebuilt by the Unicleo commands */
+  Stream_Build();
+
   /* Initialize button */
   BSP_PB_Init(BUTTON_KEY, BUTTON_MODE_EXTI);
 
@@ -182,9 +353,23 @@ static void MX_DataLogFusion_Init(void)
   /* Initialize Timer */
   BSP_IP_TIM_Init();
 
-  /* Configure Timer to run with desired algorithm frequency */
-  TIM_Config(ALGO_FREQ);
+  /* Configure Timer to run with the sensor read frequency */
+  TIM_Config(SENSOR_FREQ);
+
+  if ((SAMPLE_DECIM_Init(&AccDecim, SAMPLE_FACTOR) != SAMPLE_DECIM_OK)
+      || (SAMPLE_DECIM_Init(&GyrDecim, SAMPLE_FACTOR) != SAMPLE_DECIM_OK))
+  {
+    Error_Handler();
+  }
 
+#if (APP_DUAL_CORE == 1)
+  /* The sensors, INT1 and the MLC belong to the CM0+, released by main once
+   * the sensors are powered */
+  if (IPC_LINK_Init(IPC_Doorbell) != IPC_LINK_OK)
+  {
+    Error_Handler();
+  }
+#else
   /* Initialize (disabled) sensors */
   Init_Sensors();
 
@@ -193,6 +378,12 @@ static void MX_DataLogFusion_Init(void)
   MEMS_INT1_Init();
 #endif
 
+  /* Load the MLC program, it runs in the sensor next to the data stream.
+   * Its full scales stay, the stream sensitivities follow them. The rates
+   * and power modes are planned for it, the fusion and the stream. */
+  MLC_manager_init(SensorNeeds, sizeof(SensorNeeds) / sizeof(SensorNeeds[0]));
+#endif
+
   /* Sensor Fusion API initialization function */
   MotionFX_manager_init();
 
@@ -222,6 +413,10 @@ static void MX_DataLogFusion_Init(void)
 
   DWT_Init();
 
+#if (MEM_BENCH == 1)
+  MEM_BENCH_Run();
+#endif
+
   BSP_LED_On(LED2);
   HAL_Delay(500);
   BSP_LED_Off(LED2);
@@ -232,11 +427,12 @@ static void MX_DataLogFusion_Init(void)
 
 /**
   * @brief  Process of the application
+  * @note   Polls the UART for Unicleo commands, the sensor stream and the
+  *         calibration run as their own tasks.
   * @retval None
   */
 static void MX_DataLogFusion_Process(void)
 {
-  static TMsg msg_dat;
   static TMsg msg_cmd;
 
   if (UART_ReceivedMSG((TMsg *)&msg_cmd) == 1)
@@ -246,73 +442,231 @@ static void MX_DataLogFusion_Process(void)
       (void)HandleMSG((TMsg *)&msg_cmd);
     }
   }
+}
 
-  if (MagCalRequest == 1U)
+/**
+  * @brief  Command task
+  * @param  Events the scheduler events
+  * @retval None
+  */
+static void Command_Task(uint32_t Events)
+{
+  (void)Events;
+
+  MX_MEMS_Process();
+}
+
+/**
+  * @brief  Stream task, acquires the sensors, runs the fusion and sends the
+  *         data stream
+  * @param  Events the scheduler events
+  * @retval None
+  */
+static void Stream_Task(uint32_t Events)
+{
+  static TMsg msg_sub;
+
+  /* The configuration is applied before a sample posted with it */
+  if ((Events & STREAM_EVT_CONFIG) != 0U)
   {
-    /* Debouncing */
-    HAL_Delay(50);
+    Stream_Build();
+  }
 
-    /* Wait until the button is released */
-    while ((BSP_PB_GetState( BUTTON_KEY ) == PushButtonState));
+  if ((Events & STREAM_EVT_READ) == 0U)
+  {
+    return;
+  }
 
-    /* Debouncing */
-    HAL_Delay(50);
+#if (APP_DUAL_CORE == 1)
+  /* One sample of the CM0+ block per run */
+  if ((UseOfflineData == 0U) && (IPC_Data_Handler() == 0U))
+  {
+    return;
+  }
+#else
+  if (UseOfflineData == 0U)
+  {
+    /* The stream runs once the filters have taken SAMPLE_FACTOR reads */
+    if (Motion_Read() == 0U)
+    {
+      return;
+    }
+  }
+  else
+  {
+    /* Offline records come at the stream rate */
+    OfflineTicks++;
+    if (OfflineTicks < SAMPLE_FACTOR)
+    {
+      return;
+    }
+    OfflineTicks = 0;
+#if (APP_DRDY_SAMPLING == 1)
+    FxDeltaTime = MOTION_FX_ENGINE_DELTATIME;
+#endif
+  }
+#endif
 
-    MagCalRequest = 0;
+  /* Acquire data from enabled sensors, run the fusion and fill Msg stream */
+  SAMPLE_PIPE_Run(&StreamPipe);
 
-    /* Reset magnetometer calibration value*/
-    MagCalStatus = 0;
-    MagOffset.x = 0;
-    MagOffset.y = 0;
-    MagOffset.z = 0;
+  /* Send data stream */
+  INIT_STREAMING_HEADER(&StreamMsg);
+  StreamMsg.Len = StreamLen;
 
-    /* Enable magnetometer calibration */
-    MotionFX_manager_MagCal_start(ALGO_PERIOD);
+  if (StreamPlan.Fields != 0U)
+  {
+    /* Only the subscribed fields go on the wire */
+    STREAM_PLAN_Run(&StreamPlan, StreamMsg.Data, msg_sub.Data);
+    msg_sub.Data[2] = CMD_Stream_Subscribe;
+    msg_sub.Len = StreamPlan.Len;
+    UART_SendMsg(&msg_sub);
+  }
+  else
+  {
+    UART_SendMsg(&StreamMsg);
   }
+}
 
-  if (SensorReadRequest == 1U)
+/**
+  * @brief  Build the stages of a stream sample
+  * @note   Runs on STREAM_EVT_CONFIG, posted by the commands that change the
+  *         enabled sensors, the data source or the fusion format. The stages
+  *         keep the order of the Unicleo frame handlers.
+  * @retval None
+  */
+static void Stream_Build(void)
+{
+  const uint32_t fusion = ACCELEROMETER_SENSOR | GYROSCOPE_SENSOR | MAGNETIC_SENSOR;
+  uint32_t enabled = SensorsEnabled;
+  uint8_t *data = StreamMsg.Data;
+  uint8_t compact = (StreamFormat.Format != (uint8_t)FUSION_CODEC_FLOAT) ? 1U : 0U;
+  int32_t ret = SAMPLE_PIPE_OK;
+
+  SAMPLE_PIPE_Reset(&StreamPipe);
+
+#if (APP_DUAL_CORE == 0)
+  /* A sensor turned on must not be filtered with the zeros read while off */
+  SAMPLE_DECIM_Reset(&AccDecim);
+  SAMPLE_DECIM_Reset(&GyrDecim);
+#endif
+
+  if (UseOfflineData == 1U)
   {
-    SensorReadRequest = 0;
+    /* One record holds the time and every sensor */
+    ret |= SAMPLE_PIPE_Add(&StreamPipe, Offline_Stage, OfflineData, data);
+  }
+  else
+  {
+    ret |= SAMPLE_PIPE_Add(&StreamPipe, RTC_Stage, NULL, &data[3]);
 
-    /* Acquire data from enabled sensors and fill Msg stream */
-    RTC_Handler(&msg_dat);
-    Accelero_Sensor_Handler(&msg_dat);
-    Gyro_Sensor_Handler(&msg_dat);
-    Magneto_Sensor_Handler(&msg_dat);
-    Humidity_Sensor_Handler(&msg_dat);
-    Temperature_Sensor_Handler(&msg_dat);
-    Pressure_Sensor_Handler(&msg_dat);
+    if ((enabled & ACCELEROMETER_SENSOR) == ACCELEROMETER_SENSOR)
+    {
+      ret |= SAMPLE_PIPE_Add(&StreamPipe, Accelero_Stage, &AccValue, &data[19]);
+    }
+    if ((enabled & GYROSCOPE_SENSOR) == GYROSCOPE_SENSOR)
+    {
+      ret |= SAMPLE_PIPE_Add(&StreamPipe, Gyro_Stage, &GyrValue, &data[31]);
+    }
+    if ((enabled & MAGNETIC_SENSOR) == MAGNETIC_SENSOR)
+    {
+      ret |= SAMPLE_PIPE_Add(&StreamPipe, Magneto_Stage, &MagValue, &data[43]);
+    }
+    if ((enabled & HUMIDITY_SENSOR) == HUMIDITY_SENSOR)
+    {
+      ret |= SAMPLE_PIPE_Add(&StreamPipe, Humidity_Stage, &HumValue, &data[15]);
+    }
+    if ((enabled & TEMPERATURE_SENSOR) == TEMPERATURE_SENSOR)
+    {
+      ret |= SAMPLE_PIPE_Add(&StreamPipe, Temperature_Stage, &TempValue, &data[11]);
+    }
+    if ((enabled & PRESSURE_SENSOR) == PRESSURE_SENSOR)
+    {
+      ret |= SAMPLE_PIPE_Add(&StreamPipe, Pressure_Stage, &PressValue, &data[7]);
+    }
+  }
 
-    /* Sensor Fusion specific part */
-    FX_Data_Handler(&msg_dat);
+  /* Sensor Fusion specific part, the compact block is still sent, as an
+   * identity quaternion and zeros, when the fusion does not run */
+  if ((enabled & fusion) == fusion)
+  {
+    ret |= SAMPLE_PIPE_Add(&StreamPipe, (compact == 1U) ? FX_Compact_Stage : FX_Float_Stage, NULL,
+                           &data[STREAMING_FX_OFFSET]);
+  }
+  else if (compact == 1U)
+  {
+    ret |= SAMPLE_PIPE_Add(&StreamPipe, FX_Idle_Stage, NULL, &data[STREAMING_FX_OFFSET]);
+  }
 
-    /* Send data stream */
-    INIT_STREAMING_HEADER(&msg_dat);
-    msg_dat.Len = STREAMING_MSG_LENGTH;
+  StreamLen = (compact == 1U) ? STREAMING_MSG_LENGTH_COMPACT : STREAMING_MSG_LENGTH;
 
-    if (UseOfflineData == 1U)
-    {
-      OfflineDataCount--;
-      if (OfflineDataCount < 0)
-      {
-        OfflineDataCount = 0;
-      }
+  /* MLC events */
+  if ((enabled & MLC_SENSOR) == MLC_SENSOR)
+  {
+    ret |= SAMPLE_PIPE_Add(&StreamPipe, MLC_Stage, NULL, &data[StreamLen]);
+    StreamLen += 2U;
+  }
 
-      OfflineDataReadIndex++;
-      if (OfflineDataReadIndex >= OFFLINE_DATA_SIZE)
-      {
-        OfflineDataReadIndex = 0;
-      }
+  if (UseOfflineData == 1U)
+  {
+    ret |= SAMPLE_PIPE_Add(&StreamPipe, Offline_Next_Stage, NULL, NULL);
+  }
 
-      if (OfflineDataCount > 0)
-      {
-        SensorReadRequest = 1;
-      }
+  if (ret != SAMPLE_PIPE_OK)
+  {
+    Error_Handler();
+  }
+}
+
+/**
+  * @brief  Magnetometer calibration task
+  * @note   Debounces the push button and waits for its release with the task
+  *         timer, then restarts the calibration.
+  * @param  Events the scheduler events
+  * @retval None
+  */
+static void MagCal_Task(uint32_t Events)
+{
+  if (((Events & EVT_BUTTON) != 0U) && (MagCalButtonState == 0U))
+  {
+    MagCalButtonState = 1;
+    TASK_SCHED_SetTimer(MagCalTaskId, DEBOUNCE_TIME, 0U);
+    return;
+  }
+
+  if ((Events & TASK_SCHED_EVT_TIMER) == 0U)
+  {
+    return;
+  }
+
+  if (MagCalButtonState == 1U)
+  {
+    /* Wait until the button is released, then debounce again */
+    if (BSP_PB_GetState(BUTTON_KEY) == PushButtonState)
+    {
+      TASK_SCHED_SetTimer(MagCalTaskId, RELEASE_POLL, 0U);
+    }
+    else
+    {
+      MagCalButtonState = 2;
+      TASK_SCHED_SetTimer(MagCalTaskId, DEBOUNCE_TIME, 0U);
     }
-    UART_SendMsg(&msg_dat);
+    return;
   }
+
+  MagCalButtonState = 0;
+
+  /* Reset magnetometer calibration value*/
+  MagCalStatus = 0;
+  MagOffset.x = 0;
+  MagOffset.y = 0;
+  MagOffset.z = 0;
+
+  /* Enable magnetometer calibration */
+  MotionFX_manager_MagCal_start(ALGO_PERIOD);
 }
 
+#if (APP_DUAL_CORE == 0)
 /**
  * @brief  Initialize all sensors
  * @param  None
@@ -327,16 +681,78 @@ static void Init_Sensors(void)
   BSP_SENSOR_TEMP_Init();
   BSP_SENSOR_HUM_Init();
 
-  BSP_SENSOR_ACC_SetOutputDataRate(ACC_ODR);
+  /* The output data rates come from the plan, see MLC_manager_init */
   BSP_SENSOR_ACC_SetFullScale(ACC_FS);
 }
 
 /**
- * @brief  Handles the time+date getting/sending
- * @param  Msg the time+date part of the stream
+ * @brief  Read the accelerometer and the gyroscope through the decimation
+ *         filters
+ * @note   Disabled sensors feed zeros, both filters take every read so they
+ *         produce their outputs together. With the data-ready interrupt,
+ *         a read posted twice for one sample has nothing new and missed
+ *         samples lengthen the fusion step. The timestamp is read again
+ *         after the axes, a read a new sample may have landed in is
+ *         dropped and shows as a missed sample on the next read.
+ * @retval 1 if AccValue and GyrValue hold a new stream sample, 0 otherwise
+ */
+static uint8_t Motion_Read(void)
+{
+  MEMS_FIXED_Axes_t acc = {0};
+  MEMS_FIXED_Axes_t gyr = {0};
+  uint8_t ready;
+#if (APP_DRDY_SAMPLING == 1)
+  uint32_t before = 0;
+  uint32_t after = 0;
+
+  BSP_SENSOR_ACC_GetTimestamp(&before);
+  if (SAMPLE_SLIP_Peek(&Slip, before) == 0U)
+  {
+    (void)SAMPLE_SLIP_Check(&Slip, before); /* Counts the duplicate */
+    return 0;
+  }
+#endif
+
+  if ((SensorsEnabled & ACCELEROMETER_SENSOR) == ACCELEROMETER_SENSOR)
+  {
+    BSP_SENSOR_ACC_GetAxesFixed(&acc);
+  }
+  if ((SensorsEnabled & GYROSCOPE_SENSOR) == GYROSCOPE_SENSOR)
+  {
+    BSP_SENSOR_GYR_GetAxesFixed(&gyr);
+  }
+
+#if (APP_DRDY_SAMPLING == 1)
+  BSP_SENSOR_ACC_GetTimestamp(&after);
+  if (SAMPLE_SLIP_Same(&Slip, before, after) == 0U)
+  {
+    return 0;
+  }
+  SlipPeriods += SAMPLE_SLIP_Check(&Slip, before);
+#endif
+
+  ready = SAMPLE_DECIM_Push(&AccDecim, &acc, &AccValue);
+  (void)SAMPLE_DECIM_Push(&GyrDecim, &gyr, &GyrValue);
+
+#if (APP_DRDY_SAMPLING == 1)
+  if (ready != 0U)
+  {
+    FxDeltaTime = (float)(SlipPeriods * Slip.Period) / (float)SAMPLE_SLIP_TS_HZ;
+    SlipPeriods = 0;
+  }
+#endif
+
+  return ready;
+}
+#endif
+
+/**
+ * @brief  Time of day stage
+ * @param  Source unused
+ * @param  Sink the time part of the stream
  * @retval None
  */
-static void RTC_Handler(TMsg *Msg)
+static void RTC_Stage(void *Source, uint8_t *Sink)
 {
   uint8_t sub_sec = 0;
   RTC_DateTypeDef sdatestructureget;
@@ -345,88 +761,319 @@ static void RTC_Handler(TMsg *Msg)
   int32_t ans_int32;
   uint32_t RtcSynchPrediv = hrtc.Init.SynchPrediv;
 
-  if (UseOfflineData == 1)
+  (void)Source;
+
+  (void)HAL_RTC_GetTime(&hrtc, &stimestructure, FORMAT_BIN);
+  (void)HAL_RTC_GetDate(&hrtc, &sdatestructureget, FORMAT_BIN);
+
+  /* To be MISRA C-2012 compliant the original calculation:
+     sub_sec = ((((((int)RtcSynchPrediv) - ((int)stimestructure.SubSeconds)) * 100) / (RtcSynchPrediv + 1)) & 0xFF);
+     has been split to separate expressions */
+  ans_int32 = (RtcSynchPrediv - (int32_t)stimestructure.SubSeconds) * 100;
+  ans_int32 /= RtcSynchPrediv + 1;
+  ans_uint32 = (uint32_t)ans_int32 & 0xFFU;
+  sub_sec = (uint8_t)ans_uint32;
+
+  Sink[0] = (uint8_t)stimestructure.Hours;
+  Sink[1] = (uint8_t)stimestructure.Minutes;
+  Sink[2] = (uint8_t)stimestructure.Seconds;
+  Sink[3] = sub_sec;
+}
+
+/**
+ * @brief  Offline data stage, one record fills the time and the sensors
+ * @note   Offline data enables every sensor but the MLC, the record goes to
+ *         the sensor values read by the fusion as is (no calibration).
+ * @param  Source the offline data buffer
+ * @param  Sink the stream
+ * @retval None
+ */
+static void Offline_Stage(void *Source, uint8_t *Sink)
+{
+  const offline_data_t *rec = &((const offline_data_t *)Source)[OfflineDataReadIndex];
+
+  Sink[3] = rec->hours;
+  Sink[4] = rec->minutes;
+  Sink[5] = rec->seconds;
+  Sink[6] = rec->subsec;
+
+  PressValue = rec->pressure;
+  TempValue = rec->temperature;
+  HumValue = rec->humidity;
+  (void)memcpy(&Sink[7], (void *)&PressValue, sizeof(float));
+  (void)memcpy(&Sink[11], (void *)&TempValue, sizeof(float));
+  (void)memcpy(&Sink[15], (void *)&HumValue, sizeof(float));
+
+  AccValue.x = MEMS_FIXED_FromMilli(rec->acceleration_x_mg);
+  AccValue.y = MEMS_FIXED_FromMilli(rec->acceleration_y_mg);
+  AccValue.z = MEMS_FIXED_FromMilli(rec->acceleration_z_mg);
+  Put_Fixed_Axes(&AccValue, &Sink[19]);
+
+  GyrValue.x = MEMS_FIXED_FromMilli(rec->angular_rate_x_mdps);
+  GyrValue.y = MEMS_FIXED_FromMilli(rec->angular_rate_y_mdps);
+  GyrValue.z = MEMS_FIXED_FromMilli(rec->angular_rate_z_mdps);
+  Put_Fixed_Axes(&GyrValue, &Sink[31]);
+
+  MagValue.x = rec->magnetic_field_x_mgauss;
+  MagValue.y = rec->magnetic_field_y_mgauss;
+  MagValue.z = rec->magnetic_field_z_mgauss;
+  Serialize_s32(&Sink[43], MagValue.x, 4);
+  Serialize_s32(&Sink[47], MagValue.y, 4);
+  Serialize_s32(&Sink[51], MagValue.z, 4);
+}
+
+/**
+ * @brief  Offline data stage, moves to the next record
+ * @param  Source unused
+ * @param  Sink unused
+ * @retval None
+ */
+static void Offline_Next_Stage(void *Source, uint8_t *Sink)
+{
+  (void)Source;
+  (void)Sink;
+
+  OfflineDataCount--;
+  if (OfflineDataCount < 0)
   {
-    Msg->Data[3] = (uint8_t)OfflineData[OfflineDataReadIndex].hours;
-    Msg->Data[4] = (uint8_t)OfflineData[OfflineDataReadIndex].minutes;
-    Msg->Data[5] = (uint8_t)OfflineData[OfflineDataReadIndex].seconds;
-    Msg->Data[6] = (uint8_t)OfflineData[OfflineDataReadIndex].subsec;
+    OfflineDataCount = 0;
   }
-  else
+
+  OfflineDataReadIndex++;
+  if (OfflineDataReadIndex >= OFFLINE_DATA_SIZE)
   {
-    (void)HAL_RTC_GetTime(&hrtc, &stimestructure, FORMAT_BIN);
-    (void)HAL_RTC_GetDate(&hrtc, &sdatestructureget, FORMAT_BIN);
+    OfflineDataReadIndex = 0;
+  }
 
-    /* To be MISRA C-2012 compliant the original calculation:
-       sub_sec = ((((((int)RtcSynchPrediv) - ((int)stimestructure.SubSeconds)) * 100) / (RtcSynchPrediv + 1)) & 0xFF);
-       has been split to separate expressions */
-    ans_int32 = (RtcSynchPrediv - (int32_t)stimestructure.SubSeconds) * 100;
-    ans_int32 /= RtcSynchPrediv + 1;
-    ans_uint32 = (uint32_t)ans_int32 & 0xFFU;
-    sub_sec = (uint8_t)ans_uint32;
+  if (OfflineDataCount > 0)
+  {
+    TASK_SCHED_Post(StreamTaskId, STREAM_EVT_READ);
+  }
+}
 
-    Msg->Data[3] = (uint8_t)stimestructure.Hours;
-    Msg->Data[4] = (uint8_t)stimestructure.Minutes;
-    Msg->Data[5] = (uint8_t)stimestructure.Seconds;
-    Msg->Data[6] = sub_sec;
+/**
+ * @brief  Run the Sensor Fusion on the sensor values
+ * @param  Output the fusion outputs
+ * @retval The fusion run time [us]
+ */
+static uint32_t FX_Run(MFX_output_t *Output)
+{
+  uint32_t elapsed_time_us;
+#if (FUSION_MAHONY == 1)
+  uint16_t fields = StreamPlan.Fields;
+  uint32_t outputs = MFX_MANAGER_OUT_ALL;
+
+  /* The engine takes the Q23.8 samples, only the subscribed outputs are
+   * computed and converted */
+  if (fields != 0U)
+  {
+    outputs = (((fields & STREAM_FIELD_QUAT) != 0U) ? MFX_MANAGER_OUT_QUAT : 0U)
+              | (((fields & (STREAM_FIELD_ROT | STREAM_FIELD_HEADING)) != 0U) ? MFX_MANAGER_OUT_ROT : 0U)
+              | (((fields & STREAM_FIELD_GRAV) != 0U) ? MFX_MANAGER_OUT_GRAV : 0U)
+              | (((fields & STREAM_FIELD_LINACC) != 0U) ? MFX_MANAGER_OUT_LINACC : 0U);
   }
+
+  BSP_LED_On(LED2);
+  DWT_Start();
+  MotionFX_manager_run_fixed(&AccValue, &GyrValue, outputs, Output, FxDeltaTime);
+  elapsed_time_us = DWT_Stop();
+  BSP_LED_Off(LED2);
+#else
+  MFX_input_t data_in;
+
+  /* Convert angular velocity from [mdps, Q23.8] to [dps], the library takes float */
+  data_in.gyro[0] = MEMS_FIXED_ToUnit(GyrValue.x);
+  data_in.gyro[1] = MEMS_FIXED_ToUnit(GyrValue.y);
+  data_in.gyro[2] = MEMS_FIXED_ToUnit(GyrValue.z);
+
+  /* Convert acceleration from [mg, Q23.8] to [g], the library takes float */
+  data_in.acc[0] = MEMS_FIXED_ToUnit(AccValue.x);
+  data_in.acc[1] = MEMS_FIXED_ToUnit(AccValue.y);
+  data_in.acc[2] = MEMS_FIXED_ToUnit(AccValue.z);
+
+  /* Convert magnetic field intensity from [mGauss] to [uT / 50] */
+  data_in.mag[0] = (float)MagValue.x * FROM_MGAUSS_TO_UT50;
+  data_in.mag[1] = (float)MagValue.y * FROM_MGAUSS_TO_UT50;
+  data_in.mag[2] = (float)MagValue.z * FROM_MGAUSS_TO_UT50;
+
+  /* Run Sensor Fusion algorithm */
+  BSP_LED_On(LED2);
+  DWT_Start();
+  MotionFX_manager_run(&data_in, Output, FxDeltaTime);
+  elapsed_time_us = DWT_Stop();
+  BSP_LED_Off(LED2);
+#endif
+
+  return elapsed_time_us;
 }
 
 /**
- * @brief  Sensor Fusion data handler
- * @param  Msg the Sensor Fusion data part of the stream
+ * @brief  Sensor Fusion stage, Unicleo float layout
+ * @param  Source unused
+ * @param  Sink the Sensor Fusion data part of the stream
  * @retval None
  */
-static void FX_Data_Handler(TMsg *Msg)
+static void FX_Float_Stage(void *Source, uint8_t *Sink)
 {
-  uint32_t elapsed_time_us = 0U;
-  MFX_input_t data_in;
-  MFX_input_t *pdata_in = &data_in;
   MFX_output_t data_out;
-  MFX_output_t *pdata_out = &data_out;
+  uint32_t elapsed_time_us;
 
-  if ((SensorsEnabled & ACCELEROMETER_SENSOR) == ACCELEROMETER_SENSOR)
+  (void)Source;
+
+  elapsed_time_us = FX_Run(&data_out);
+
+  (void)memcpy(&Sink[0], (void *)data_out.quaternion, 4U * sizeof(float));
+  (void)memcpy(&Sink[16], (void *)data_out.rotation, 3U * sizeof(float));
+  (void)memcpy(&Sink[28], (void *)data_out.gravity, 3U * sizeof(float));
+  (void)memcpy(&Sink[40], (void *)data_out.linear_acceleration, 3U * sizeof(float));
+
+  (void)memcpy(&Sink[52], (void *) & (data_out.heading), sizeof(float));
+  (void)memcpy(&Sink[56], (void *) & (data_out.headingErr), sizeof(float));
+
+  Serialize_s32(&Sink[60], (int32_t)elapsed_time_us, 4);
+}
+
+/**
+ * @brief  Sensor Fusion stage, compact block of fusion_codec.h
+ * @param  Source unused
+ * @param  Sink the Sensor Fusion data part of the stream
+ * @retval None
+ */
+static void FX_Compact_Stage(void *Source, uint8_t *Sink)
+{
+  MFX_output_t data_out;
+  uint32_t elapsed_time_us;
+
+  (void)Source;
+
+  elapsed_time_us = FX_Run(&data_out);
+
+  (void)FUSION_CODEC_Encode(&StreamFormat, &data_out, Sink);
+  Serialize_s32(&Sink[FUSION_CODEC_SIZE], (int32_t)elapsed_time_us, 4);
+}
+
+/**
+ * @brief  Compact block without the fusion: identity quaternion and zeros
+ * @param  Source unused
+ * @param  Sink the Sensor Fusion data part of the stream
+ * @retval None
+ */
+static void FX_Idle_Stage(void *Source, uint8_t *Sink)
+{
+  (void)Source;
+
+  (void)FUSION_CODEC_Encode(&StreamFormat, NULL, Sink);
+  Serialize_s32(&Sink[FUSION_CODEC_SIZE], 0, 4);
+}
+
+/**
+ * @brief  Appends the MLC output to the stream
+ * @param  Source unused
+ * @param  Sink the MLC part of the stream
+ * @retval None
+ */
+static void MLC_Stage(void *Source, uint8_t *Sink)
+{
+  MLC_output_t mlc_out;
+
+  (void)Source;
+
+#if (APP_DUAL_CORE == 1)
+  mlc_out = IpcMlc;
+#else
+  MLC_manager_get_output(&mlc_out);
+#endif
+
+  Sink[0] = mlc_out.Code;
+  Sink[1] = (uint8_t)mlc_out.Events; /* Wraps, a change marks a new event */
+}
+
+#if (APP_DUAL_CORE == 1)
+/**
+ * @brief  Takes the next sample of the CM0+ blocks
+ * @note   Fills the sensor values read by the handlers, the task is posted
+ *         again until the ring is empty, then the doorbell is armed. The
+ *         block samples go through the decimation filters, a stream sample
+ *         takes IPC_LINK_OVERSAMPLE of them.
+ * @retval 1 if a sample was taken, 0 if there is none
+ */
+static uint8_t IPC_Data_Handler(void)
+{
+  const IPC_LINK_Sample_t *sample;
+  MEMS_FIXED_Axes_t acc;
+  MEMS_FIXED_Axes_t gyr;
+  uint8_t ready;
+
+  if (IpcBlock == NULL)
   {
-    if ((SensorsEnabled & GYROSCOPE_SENSOR) == GYROSCOPE_SENSOR)
+    IpcBlock = IPC_LINK_Peek();
+    if (IpcBlock == NULL)
     {
-      if ((SensorsEnabled & MAGNETIC_SENSOR) == MAGNETIC_SENSOR)
+      if (IPC_LINK_Arm() != IPC_LINK_OK)
       {
-        /* Convert angular velocity from [mdps] to [dps] */
-        data_in.gyro[0] = (float)GyrValue.x * FROM_MDPS_TO_DPS;
-        data_in.gyro[1] = (float)GyrValue.y * FROM_MDPS_TO_DPS;
-        data_in.gyro[2] = (float)GyrValue.z * FROM_MDPS_TO_DPS;
-
-        /* Convert acceleration from [mg] to [g] */
-        data_in.acc[0] = (float)AccValue.x * FROM_MG_TO_G;
-        data_in.acc[1] = (float)AccValue.y * FROM_MG_TO_G;
-        data_in.acc[2] = (float)AccValue.z * FROM_MG_TO_G;
-
-        /* Convert magnetic field intensity from [mGauss] to [uT / 50] */
-        data_in.mag[0] = (float)MagValue.x * FROM_MGAUSS_TO_UT50;
-        data_in.mag[1] = (float)MagValue.y * FROM_MGAUSS_TO_UT50;
-        data_in.mag[2] = (float)MagValue.z * FROM_MGAUSS_TO_UT50;
-
-        /* Run Sensor Fusion algorithm */
-        BSP_LED_On(LED2);
-        DWT_Start();
-        MotionFX_manager_run(pdata_in, pdata_out, MOTION_FX_ENGINE_DELTATIME);
-        elapsed_time_us = DWT_Stop();
-        BSP_LED_Off(LED2);
-
-        (void)memcpy(&Msg->Data[55], (void *)pdata_out->quaternion, 4U * sizeof(float));
-        (void)memcpy(&Msg->Data[71], (void *)pdata_out->rotation, 3U * sizeof(float));
-        (void)memcpy(&Msg->Data[83], (void *)pdata_out->gravity, 3U * sizeof(float));
-        (void)memcpy(&Msg->Data[95], (void *)pdata_out->linear_acceleration, 3U * sizeof(float));
-
-        (void)memcpy(&Msg->Data[107], (void *) & (pdata_out->heading), sizeof(float));
-        (void)memcpy(&Msg->Data[111], (void *) & (pdata_out->headingErr), sizeof(float));
-
-        Serialize_s32(&Msg->Data[115], (int32_t)elapsed_time_us, 4);
+        TASK_SCHED_Post(StreamTaskId, STREAM_EVT_READ);
       }
+      return 0;
+    }
+
+    IpcIndex = 0;
+  }
+
+  /* Blocks that arrive while the stream is stopped are dropped */
+  if ((DataLoggerActive == 0U) || (IpcIndex >= IpcBlock->Count))
+  {
+    if (DataLoggerActive == 0U)
+    {
+      /* The filters restart on the first sample of the next stream */
+      SAMPLE_DECIM_Reset(&AccDecim);
+      SAMPLE_DECIM_Reset(&GyrDecim);
     }
+    IPC_LINK_Release();
+    IpcBlock = NULL;
+    TASK_SCHED_Post(StreamTaskId, STREAM_EVT_READ);
+    return 0;
   }
+
+  /* Both filters take the same samples, they produce outputs together */
+  do
+  {
+    sample = &IpcBlock->Samples[IpcIndex];
+    MEMS_FIXED_Scale(sample->Acc[0], sample->Acc[1], sample->Acc[2], IpcBlock->AccSens, &acc);
+    MEMS_FIXED_Scale(sample->Gyr[0], sample->Gyr[1], sample->Gyr[2], IpcBlock->GyrSens, &gyr);
+    ready = SAMPLE_DECIM_Push(&AccDecim, &acc, &AccValue);
+    (void)SAMPLE_DECIM_Push(&GyrDecim, &gyr, &GyrValue);
+    IpcIndex++;
+  } while ((ready == 0U) && (IpcIndex < IpcBlock->Count));
+
+  MagValue.x = IpcBlock->Mag[0];
+  MagValue.y = IpcBlock->Mag[1];
+  MagValue.z = IpcBlock->Mag[2];
+  PressValue = IpcBlock->Press;
+  TempValue = IpcBlock->Temp;
+  HumValue = IpcBlock->Hum;
+  IpcMlc.Code = IpcBlock->MlcCode;
+  IpcMlc.Events = IpcBlock->MlcEvents;
+
+  if (IpcIndex >= IpcBlock->Count)
+  {
+    IPC_LINK_Release();
+    IpcBlock = NULL;
+  }
+
+  TASK_SCHED_Post(StreamTaskId, STREAM_EVT_READ);
+  return ready;
 }
 
+/**
+ * @brief  CM0+ doorbell, called from the IPCC interrupt
+ * @retval None
+ */
+static void IPC_Doorbell(void)
+{
+  TASK_SCHED_Post(StreamTaskId, STREAM_EVT_READ);
+}
+#endif
+
 /**
   * @brief  BSP Push Button callback
   * @param  Button Specifies the pin connected EXTI line
@@ -434,186 +1081,140 @@ static void FX_Data_Handler(TMsg *Msg)
   */
 void BSP_PB_Callback(Button_TypeDef Button)
 {
-  MagCalRequest = 1U;
+  TASK_SCHED_Post(MagCalTaskId, EVT_BUTTON);
 }
 
 /**
- * @brief  Handles the ACC axes data getting/sending
- * @param  Msg the ACC part of the stream
+ * @brief  Write [mg] or [mdps] axes to the stream
+ * @param  Axes the axes [Q23.8]
+ * @param  Sink the 12 bytes of the stream
  * @retval None
  */
-static void Accelero_Sensor_Handler(TMsg *Msg)
+static void Put_Fixed_Axes(const MEMS_FIXED_Axes_t *Axes, uint8_t *Sink)
 {
-  if ((SensorsEnabled & ACCELEROMETER_SENSOR) == ACCELEROMETER_SENSOR)
-  {
-    if (UseOfflineData == 1)
-    {
-      AccValue.x = OfflineData[OfflineDataReadIndex].acceleration_x_mg;
-      AccValue.y = OfflineData[OfflineDataReadIndex].acceleration_y_mg;
-      AccValue.z = OfflineData[OfflineDataReadIndex].acceleration_z_mg;
-    }
-    else
-    {
-      BSP_SENSOR_ACC_GetAxes(&AccValue);
-    }
-
-    Serialize_s32(&Msg->Data[19], (int32_t)AccValue.x, 4);
-    Serialize_s32(&Msg->Data[23], (int32_t)AccValue.y, 4);
-    Serialize_s32(&Msg->Data[27], (int32_t)AccValue.z, 4);
-  }
+  Serialize_s32(&Sink[0], MEMS_FIXED_ToMilli(Axes->x), 4);
+  Serialize_s32(&Sink[4], MEMS_FIXED_ToMilli(Axes->y), 4);
+  Serialize_s32(&Sink[8], MEMS_FIXED_ToMilli(Axes->z), 4);
 }
 
 /**
- * @brief  Handles the GYR axes data getting/sending
- * @param  Msg the GYR part of the stream
+ * @brief  ACC stage, the axes come out of the decimation filter
+ * @param  Source the ACC axes
+ * @param  Sink the ACC part of the stream
  * @retval None
  */
-static void Gyro_Sensor_Handler(TMsg *Msg)
+static void Accelero_Stage(void *Source, uint8_t *Sink)
 {
-  if ((SensorsEnabled & GYROSCOPE_SENSOR) == GYROSCOPE_SENSOR)
-  {
-    if (UseOfflineData == 1)
-    {
-      GyrValue.x = OfflineData[OfflineDataReadIndex].angular_rate_x_mdps;
-      GyrValue.y = OfflineData[OfflineDataReadIndex].angular_rate_y_mdps;
-      GyrValue.z = OfflineData[OfflineDataReadIndex].angular_rate_z_mdps;
-    }
-    else
-    {
-      BSP_SENSOR_GYR_GetAxes(&GyrValue);
-    }
+  Put_Fixed_Axes((const MEMS_FIXED_Axes_t *)Source, Sink);
+}
 
-    Serialize_s32(&Msg->Data[31], GyrValue.x, 4);
-    Serialize_s32(&Msg->Data[35], GyrValue.y, 4);
-    Serialize_s32(&Msg->Data[39], GyrValue.z, 4);
-  }
+/**
+ * @brief  GYR stage, the axes come out of the decimation filter
+ * @param  Source the GYR axes
+ * @param  Sink the GYR part of the stream
+ * @retval None
+ */
+static void Gyro_Stage(void *Source, uint8_t *Sink)
+{
+  Put_Fixed_Axes((const MEMS_FIXED_Axes_t *)Source, Sink);
 }
 
 /**
- * @brief  Handles the MAG axes data getting/sending
- * @param  Msg the MAG part of the stream
+ * @brief  MAG stage, runs the calibration until it is good
+ * @param  Source the MAG axes
+ * @param  Sink the MAG part of the stream
  * @retval None
  */
-static void Magneto_Sensor_Handler(TMsg *Msg)
+static void Magneto_Stage(void *Source, uint8_t *Sink)
 {
+  MOTION_SENSOR_Axes_t *mag = (MOTION_SENSOR_Axes_t *)Source;
   float ans_float;
   MFX_MagCal_input_t mag_data_in;
   MFX_MagCal_output_t mag_data_out;
 
-  if ((SensorsEnabled & MAGNETIC_SENSOR) == MAGNETIC_SENSOR)
-  {
-    if (UseOfflineData == 1)
-    {
-     MagValue.x = OfflineData[OfflineDataReadIndex].magnetic_field_x_mgauss;
-     MagValue.y = OfflineData[OfflineDataReadIndex].magnetic_field_y_mgauss;
-     MagValue.z = OfflineData[OfflineDataReadIndex].magnetic_field_z_mgauss;
-    }
-    else
-    {
-      BSP_SENSOR_MAG_GetAxes(&MagValue);
-
-      if (MagCalStatus == 0U)
-      {
-        mag_data_in.mag[0] = (float)MagValue.x * FROM_MGAUSS_TO_UT50;
-        mag_data_in.mag[1] = (float)MagValue.y * FROM_MGAUSS_TO_UT50;
-        mag_data_in.mag[2] = (float)MagValue.z * FROM_MGAUSS_TO_UT50;
+#if (APP_DUAL_CORE == 0)
+  BSP_SENSOR_MAG_GetAxes(mag);
+#endif
 
-        mag_data_in.time_stamp = (int)TimeStamp;
-        TimeStamp += (uint32_t)ALGO_PERIOD;
+  if (MagCalStatus == 0U)
+  {
+    mag_data_in.mag[0] = (float)mag->x * FROM_MGAUSS_TO_UT50;
+    mag_data_in.mag[1] = (float)mag->y * FROM_MGAUSS_TO_UT50;
+    mag_data_in.mag[2] = (float)mag->z * FROM_MGAUSS_TO_UT50;
 
-        MotionFX_manager_MagCal_run(&mag_data_in, &mag_data_out);
+    mag_data_in.time_stamp = (int)TimeStamp;
+    TimeStamp += (uint32_t)ALGO_PERIOD;
 
-        if (mag_data_out.cal_quality == MFX_MAGCALGOOD)
-        {
-          MagCalStatus = 1;
+    MotionFX_manager_MagCal_run(&mag_data_in, &mag_data_out);
 
-          ans_float = (mag_data_out.hi_bias[0] * FROM_UT50_TO_MGAUSS);
-          MagOffset.x = (int32_t)ans_float;
-          ans_float = (mag_data_out.hi_bias[1] * FROM_UT50_TO_MGAUSS);
-          MagOffset.y = (int32_t)ans_float;
-          ans_float = (mag_data_out.hi_bias[2] * FROM_UT50_TO_MGAUSS);
-          MagOffset.z = (int32_t)ans_float;
+    if (mag_data_out.cal_quality == MFX_MAGCALGOOD)
+    {
+      MagCalStatus = 1;
 
-          /* Disable magnetometer calibration */
-          MotionFX_manager_MagCal_stop(ALGO_PERIOD);
-        }
-      }
+      ans_float = (mag_data_out.hi_bias[0] * FROM_UT50_TO_MGAUSS);
+      MagOffset.x = (int32_t)ans_float;
+      ans_float = (mag_data_out.hi_bias[1] * FROM_UT50_TO_MGAUSS);
+      MagOffset.y = (int32_t)ans_float;
+      ans_float = (mag_data_out.hi_bias[2] * FROM_UT50_TO_MGAUSS);
+      MagOffset.z = (int32_t)ans_float;
 
-      MagValue.x = (int32_t)(MagValue.x - MagOffset.x);
-      MagValue.y = (int32_t)(MagValue.y - MagOffset.y);
-      MagValue.z = (int32_t)(MagValue.z - MagOffset.z);
+      /* Disable magnetometer calibration */
+      MotionFX_manager_MagCal_stop(ALGO_PERIOD);
     }
-
-    Serialize_s32(&Msg->Data[43], MagValue.x, 4);
-    Serialize_s32(&Msg->Data[47], MagValue.y, 4);
-    Serialize_s32(&Msg->Data[51], MagValue.z, 4);
   }
+
+  mag->x = (int32_t)(mag->x - MagOffset.x);
+  mag->y = (int32_t)(mag->y - MagOffset.y);
+  mag->z = (int32_t)(mag->z - MagOffset.z);
+
+  Serialize_s32(&Sink[0], mag->x, 4);
+  Serialize_s32(&Sink[4], mag->y, 4);
+  Serialize_s32(&Sink[8], mag->z, 4);
 }
 
 /**
- * @brief  Handles the PRESS sensor data getting/sending.
- * @param  Msg the PRESS part of the stream
+ * @brief  PRESS stage
+ * @param  Source the pressure
+ * @param  Sink the PRESS part of the stream
  * @retval None
  */
-static void Pressure_Sensor_Handler(TMsg *Msg)
+static void Pressure_Stage(void *Source, uint8_t *Sink)
 {
-  if ((SensorsEnabled & PRESSURE_SENSOR) == PRESSURE_SENSOR)
-  {
-    if (UseOfflineData == 1)
-    {
-      PressValue = OfflineData[OfflineDataReadIndex].pressure;
-    }
-    else
-    {
-      BSP_SENSOR_PRESS_GetValue(&PressValue);
-    }
+#if (APP_DUAL_CORE == 0)
+  BSP_SENSOR_PRESS_GetValue((float *)Source);
+#endif
 
-    (void)memcpy(&Msg->Data[7], (void *)&PressValue, sizeof(float));
-  }
+  (void)memcpy(Sink, Source, sizeof(float));
 }
 
 /**
- * @brief  Handles the TEMP axes data getting/sending
- * @param  Msg the TEMP part of the stream
+ * @brief  TEMP stage
+ * @param  Source the temperature
+ * @param  Sink the TEMP part of the stream
  * @retval None
  */
-static void Temperature_Sensor_Handler(TMsg *Msg)
+static void Temperature_Stage(void *Source, uint8_t *Sink)
 {
-  if ((SensorsEnabled & TEMPERATURE_SENSOR) == TEMPERATURE_SENSOR)
-  {
-    if (UseOfflineData == 1)
-    {
-      TempValue = OfflineData[OfflineDataReadIndex].temperature;
-    }
-    else
-    {
-      BSP_SENSOR_TEMP_GetValue(&TempValue);
-    }
+#if (APP_DUAL_CORE == 0)
+  BSP_SENSOR_TEMP_GetValue((float *)Source);
+#endif
 
-    (void)memcpy(&Msg->Data[11], (void *)&TempValue, sizeof(float));
-  }
+  (void)memcpy(Sink, Source, sizeof(float));
 }
 
 /**
- * @brief  Handles the HUM axes data getting/sending
- * @param  Msg the HUM part of the stream
+ * @brief  HUM stage
+ * @param  Source the humidity
+ * @param  Sink the HUM part of the stream
  * @retval None
  */
-static void Humidity_Sensor_Handler(TMsg *Msg)
+static void Humidity_Stage(void *Source, uint8_t *Sink)
 {
-  if ((SensorsEnabled & HUMIDITY_SENSOR) == HUMIDITY_SENSOR)
-  {
-    if (UseOfflineData == 1)
-    {
-      HumValue = OfflineData[OfflineDataReadIndex].humidity;
-    }
-    else
-    {
-      BSP_SENSOR_HUM_GetValue(&HumValue);
-    }
+#if (APP_DUAL_CORE == 0)
+  BSP_SENSOR_HUM_GetValue((float *)Source);
+#endif
 
-    (void)memcpy(&Msg->Data[15], (void *)&HumValue, sizeof(float));;
-  }
+  (void)memcpy(Sink, Source, sizeof(float));
 }
 
 /**
@@ -623,7 +1224,7 @@ static void Humidity_Sensor_Handler(TMsg *Msg)
  */
 static void TIM_Config(uint32_t Freq)
 {
-  const uint32_t tim_counter_clock = 2000; /* TIM counter clock 2 kHz */
+  const uint32_t tim_counter_clock = 8000; /* TIM counter clock 8 kHz, exact up to 800 Hz */
   uint32_t prescaler_value = (uint32_t)((SystemCoreClock / tim_counter_clock) - 1);
   uint32_t period = (tim_counter_clock / Freq) - 1;
 
@@ -638,7 +1239,7 @@ static void TIM_Config(uint32_t Freq)
   }
 }
 
-#ifdef BSP_IP_MEMS_INT1_PIN_NUM
+#if defined(BSP_IP_MEMS_INT1_PIN_NUM) && (APP_DUAL_CORE == 0)
 /**
  * @brief  Force MEMS INT1 pin low
  * @param  None
@@ -673,14 +1274,16 @@ static void MEMS_INT1_Init(void)
 #endif
 
 /**
- * @brief  Initialize DWT register for counting clock cycles purpose
+ * @brief  Start the DWT cycle counter
+ * @note   The counter is free running: the I2C2 arbiter times the bus
+ *         ownership with it, so it is never stopped or cleared here.
  * @param  None
  * @retval None
  */
 static void DWT_Init(void)
 {
   CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
-  DWT->CTRL &= ~DWT_CTRL_CYCCNTENA_Msk; /* Disable counter */
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; /* Enable counter */
 }
 
 /**
@@ -690,8 +1293,7 @@ static void DWT_Init(void)
  */
 static void DWT_Start(void)
 {
-  DWT->CYCCNT = 0; /* Clear count of clock cycles */
-  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk; /* Enable counter */
+  DwtStart = DWT->CYCCNT; /* Count of clock cycles at the start */
 }
 
 /**
@@ -701,11 +1303,10 @@ static void DWT_Start(void)
  */
 static uint32_t DWT_Stop(void)
 {
-  volatile uint32_t cycles_count = 0U;
-  uint32_t system_core_clock_mhz = 0U;
+  uint32_t cycles_count;
+  uint32_t system_core_clock_mhz;
 
-  DWT->CTRL &= ~DWT_CTRL_CYCCNTENA_Msk; /* Disable counter */
-  cycles_count = DWT->CYCCNT; /* Read count of clock cycles */
+  cycles_count = DWT->CYCCNT - DwtStart; /* Clock cycles since the start, modulo 2^32 */
 
   /* Calculate elapsed time in [us] */
   system_core_clock_mhz = SystemCoreClock / 1000000U;
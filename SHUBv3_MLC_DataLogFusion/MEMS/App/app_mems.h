@@ -27,10 +27,40 @@
 /* Includes ------------------------------------------------------------------*/
 
 /* Exported defines ----------------------------------------------------------*/
+/* 1: the CM0+ image owns I2C2 and sends the sensor data in blocks through
+ * ipc_link, the CM4 only runs the fusion and the Unicleo stream.
+ * Refused for now: no CM0+ image ships with the tree, CPU2 would be
+ * released with nothing to run and the stream would never get a block.
+ * Only the CM4 side and the ring (Tools/ipc_ring) are checked. */
+#ifndef APP_DUAL_CORE
+#define APP_DUAL_CORE  0
+#endif
+
+#if (APP_DUAL_CORE == 1)
+#error "APP_DUAL_CORE needs a CM0+ producer image, the tree has none yet"
+#endif
+
+/* 1: the stream runs on the accelerometer data-ready interrupt (LSM6DSOX
+ * INT2 on PB1) instead of TIM2, each read is checked against the sensor
+ * timestamp for duplicate and missed samples. Single-core build only. */
+#ifndef APP_DRDY_SAMPLING
+#define APP_DRDY_SAMPLING  0
+#endif
+
+/* Accelerometer and gyroscope reads per stream sample, single-core build:
+ * the sensors run this many times faster than the 100 Hz stream and the
+ * reads go through the decimation filters (sample_decim.h). 1, 2, 4 or 8 */
+#ifndef APP_OVERSAMPLE
+#define APP_OVERSAMPLE  2U
+#endif
 
 /* Exported functions --------------------------------------------------------*/
 void MX_MEMS_Init(void);
 void MX_MEMS_Process(void);
+#if (APP_DUAL_CORE == 0)
+void MX_MEMS_Start_Sampling(void);
+void MX_MEMS_Stop_Sampling(void);
+#endif
 
 #ifdef __cplusplus
 }
@@ -43,6 +43,9 @@ extern TIM_HandleTypeDef htim2;
 #define BSP_IP_MEMS_INT1_PIN_NUM GPIO_PIN_0
 #define BSP_IP_MEMS_INT1_GPIOX GPIOC
 
+#define BSP_IP_MEMS_INT2_PIN_NUM GPIO_PIN_1
+#define BSP_IP_MEMS_INT2_GPIOX GPIOB
+
 extern RTC_HandleTypeDef hrtc;
 
 #ifdef __cplusplus
@@ -27,15 +27,20 @@
 /* Private defines -----------------------------------------------------------*/
 #define Uart_Msg_Max_Size TMsg_MaxLen
 
+/* A message may double in size once byte stuffed */
+_Static_assert(UART_RxBufferSize >= (2 * TMsg_MaxLen), "UART Rx buffer budget too small");
+_Static_assert(UART_TxBufferSize >= (2 * TMsg_MaxLen), "UART Tx buffer budget too small");
+
 /* Private macro -------------------------------------------------------------*/
 /* Exported variables --------------------------------------------------------*/
-volatile uint8_t UartRxBuffer[UART_RxBufferSize];
+volatile uint8_t *UartRxBuffer;
 TUart_Engine UartEngine;
 
 /* Private variables ---------------------------------------------------------*/
-static volatile uint8_t UartTxBuffer[UART_TxBufferSize];
+static volatile uint8_t *UartTxBuffer;
 
 /* Private function prototypes -----------------------------------------------*/
+static void UART_AllocBuffers(void);
 static uint32_t Get_DMA_Flag_Status(DMA_HandleTypeDef *handle_dma);
 static uint32_t Get_DMA_Counter(DMA_HandleTypeDef *handle_dma);
 
@@ -139,6 +144,8 @@ void UART_SendMsg(TMsg *Msg)
 {
   uint16_t count_out;
 
+  UART_AllocBuffers();
+
   CHK_ComputeAndAdd(Msg);
 
   /* MISRA C-2012 rule 11.8 violation for purpose */
@@ -155,6 +162,8 @@ void UART_SendMsg(TMsg *Msg)
  */
 void UART_StartReceiveMsg(void)
 {
+  UART_AllocBuffers();
+
   hcom_uart[COM1].pRxBuffPtr = (uint8_t *)UartRxBuffer; /* MISRA C-2012 rule 11.8 violation for purpose */
   hcom_uart[COM1].RxXferSize = UART_RxBufferSize;
   hcom_uart[COM1].ErrorCode = (uint32_t)HAL_UART_ERROR_NONE;
@@ -166,6 +175,24 @@ void UART_StartReceiveMsg(void)
 }
 
 /* Private functions ---------------------------------------------------------*/
+/**
+ * @brief  Take the UART buffers from the memory budget on first use
+ * @param  None
+ * @retval None
+ */
+static void UART_AllocBuffers(void)
+{
+  if (UartRxBuffer == NULL)
+  {
+    UartRxBuffer = (volatile uint8_t *)MEM_BUDGET_ALLOC(UART_RX);
+  }
+
+  if (UartTxBuffer == NULL)
+  {
+    UartTxBuffer = (volatile uint8_t *)MEM_BUDGET_ALLOC(UART_TX);
+  }
+}
+
 
 /**
  * @brief  Get the DMA Stream pending flags
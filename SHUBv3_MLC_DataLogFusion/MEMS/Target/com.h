@@ -28,6 +28,7 @@ extern "C" {
 #include "main.h"
 #include "serial_protocol.h"
 #include "bsp_ip_conf.h"
+#include "mem_budget.h"
 
 /* Exported types ------------------------------------------------------------*/
 /**
@@ -40,11 +41,11 @@ typedef struct
 } TUart_Engine;
 
 /* Exported defines ----------------------------------------------------------*/
-#define UART_RxBufferSize (2 * TMsg_MaxLen)
-#define UART_TxBufferSize (2 * TMsg_MaxLen)
+#define UART_RxBufferSize MEM_BUDGET_UART_RX_SIZE /* set in mem_budget.h */
+#define UART_TxBufferSize MEM_BUDGET_UART_TX_SIZE /* set in mem_budget.h */
 
 /* Exported variables --------------------------------------------------------*/
-extern volatile uint8_t UartRxBuffer[];
+extern volatile uint8_t *UartRxBuffer;
 extern TUart_Engine UartEngine;
 
 /* Exported macro ------------------------------------------------------------*/
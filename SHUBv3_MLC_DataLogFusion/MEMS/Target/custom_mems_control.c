@@ -20,6 +20,13 @@
 #include "custom_mems_conf_app.h"
 #include "custom_mems_control.h"
 
+/* Sensitivities used by the fixed-point path, cached on full scale change */
+static uint32_t AccSensitivity = 0U;
+static uint32_t GyrSensitivity = 0U;
+
+static void Refresh_ACC_Sensitivity(void);
+static void Refresh_GYR_Sensitivity(void);
+
 /**
   * @brief  Initializes accelerometer
   * @param  None
@@ -38,6 +45,7 @@ void BSP_SENSOR_ACC_Init(void)
   #endif
 #endif
 #endif
+  Refresh_ACC_Sensitivity();
 }
 
 /**
@@ -52,6 +60,7 @@ void BSP_SENSOR_GYR_Init(void)
   (void)CUSTOM_MOTION_SENSOR_Init(CUSTOM_GYR_INSTANCE_0, MOTION_GYRO);
   #endif
 #endif
+  Refresh_GYR_Sensitivity();
 }
 
 /**
@@ -372,6 +381,59 @@ void BSP_SENSOR_MAG_GetAxes(MOTION_SENSOR_Axes_t *Axes)
 #endif
 }
 
+/**
+  * @brief  Get accelerometer data in fixed point
+  * @note   Reads the raw registers only, scaling uses the cached sensitivity
+  * @param  Axes pointer to axes data structure [mg, Q23.8]
+  * @retval None
+  */
+void BSP_SENSOR_ACC_GetAxesFixed(MEMS_FIXED_Axes_t *Axes)
+{
+#if (defined BSP_HYBRID_SENSORS)
+  MOTION_SENSOR_Axes_t axes;
+
+  BSP_SENSOR_ACC_GetAxes(&axes);
+  Axes->x = MEMS_FIXED_FromMilli(axes.x);
+  Axes->y = MEMS_FIXED_FromMilli(axes.y);
+  Axes->z = MEMS_FIXED_FromMilli(axes.z);
+#else
+#if (defined BSP_MOTION_SENSORS)
+  #ifdef CUSTOM_ACC_INSTANCE_0
+  CUSTOM_MOTION_SENSOR_AxesRaw_t raw = {0};
+
+  (void)CUSTOM_MOTION_SENSOR_GetAxesRaw(CUSTOM_ACC_INSTANCE_0, MOTION_ACCELERO, &raw);
+  MEMS_FIXED_Scale(raw.x, raw.y, raw.z, AccSensitivity, Axes);
+  #else
+  Axes->x = 0;
+  Axes->y = 0;
+  Axes->z = 0;
+  #endif
+#endif
+#endif
+}
+
+/**
+  * @brief  Get gyroscope data in fixed point
+  * @note   Reads the raw registers only, scaling uses the cached sensitivity
+  * @param  Axes pointer to axes data structure [mdps, Q23.8]
+  * @retval None
+  */
+void BSP_SENSOR_GYR_GetAxesFixed(MEMS_FIXED_Axes_t *Axes)
+{
+#if (defined BSP_MOTION_SENSORS)
+  #ifdef CUSTOM_GYR_INSTANCE_0
+  CUSTOM_MOTION_SENSOR_AxesRaw_t raw = {0};
+
+  (void)CUSTOM_MOTION_SENSOR_GetAxesRaw(CUSTOM_GYR_INSTANCE_0, MOTION_GYRO, &raw);
+  MEMS_FIXED_Scale(raw.x, raw.y, raw.z, GyrSensitivity, Axes);
+  #else
+  Axes->x = 0;
+  Axes->y = 0;
+  Axes->z = 0;
+  #endif
+#endif
+}
+
 /**
   * @brief  Get pressure sensor data
   * @param  Value pointer to pressure value
@@ -638,6 +700,7 @@ void BSP_SENSOR_ACC_SetFullScale(int32_t Fullscale)
   #endif
 #endif
 #endif
+  Refresh_ACC_Sensitivity();
 }
 
 /**
@@ -652,6 +715,7 @@ void BSP_SENSOR_GYR_SetFullScale(int32_t Fullscale)
   (void)CUSTOM_MOTION_SENSOR_SetFullScale(CUSTOM_GYR_INSTANCE_0, MOTION_GYRO, Fullscale);
   #endif
 #endif
+  Refresh_GYR_Sensitivity();
 }
 
 /**
@@ -715,3 +779,35 @@ void BSP_SENSOR_MAG_GetFullScale(int32_t *Fullscale)
   #endif
 #endif
 }
+
+/**
+  * @brief  Refresh the cached accelerometer sensitivity from the full scale
+  * @param  None
+  * @retval None
+  */
+static void Refresh_ACC_Sensitivity(void)
+{
+  int32_t fullscale = 0;
+
+  BSP_SENSOR_ACC_GetFullScale(&fullscale);
+  if (MEMS_FIXED_AccSensitivity(fullscale, &AccSensitivity) != MEMS_FIXED_OK)
+  {
+    AccSensitivity = 0U;
+  }
+}
+
+/**
+  * @brief  Refresh the cached gyroscope sensitivity from the full scale
+  * @param  None
+  * @retval None
+  */
+static void Refresh_GYR_Sensitivity(void)
+{
+  int32_t fullscale = 0;
+
+  BSP_SENSOR_GYR_GetFullScale(&fullscale);
+  if (MEMS_FIXED_GyroSensitivity(fullscale, &GyrSensitivity) != MEMS_FIXED_OK)
+  {
+    GyrSensitivity = 0U;
+  }
+}
@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 #include "RTE_Components.h"
+#include "mems_fixed.h"
 
 #if (defined BSP_MOTION_SENSORS)
 #include "custom_motion_sensors.h"
@@ -69,6 +70,8 @@ void BSP_SENSOR_HUM_Disable(void);
 void BSP_SENSOR_ACC_GetAxes(MOTION_SENSOR_Axes_t *Axes);
 void BSP_SENSOR_GYR_GetAxes(MOTION_SENSOR_Axes_t *Axes);
 void BSP_SENSOR_MAG_GetAxes(MOTION_SENSOR_Axes_t *Axes);
+void BSP_SENSOR_ACC_GetAxesFixed(MEMS_FIXED_Axes_t *Axes);
+void BSP_SENSOR_GYR_GetAxesFixed(MEMS_FIXED_Axes_t *Axes);
 void BSP_SENSOR_PRESS_GetValue(float *Value);
 void BSP_SENSOR_TEMP_GetValue(float *Value);
 void BSP_SENSOR_HUM_GetValue(float *Value);
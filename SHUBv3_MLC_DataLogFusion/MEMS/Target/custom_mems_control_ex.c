@@ -279,7 +279,7 @@ void BSP_SENSOR_MAG_GetOrientation(char *Orientation)
 }
 #endif
 
-#if (defined CUSTOM_ALGOBUILDER_FW_TEMPLATE)
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
 /**
   * @brief  Set DRDY interrupt mode for accelerometer
   * @param  Mode Mode to be set (1 means pulsed mode otherwise latched mode)
@@ -289,23 +289,27 @@ void BSP_SENSOR_ACC_SetDRDYMode(uint8_t Mode)
 {
 #if (defined BSP_MOTION_SENSORS)
   #ifdef CUSTOM_ACC_INSTANCE_0
-/*
-  Example:
-  if (Mode == 1)
+  uint8_t reg = 0;
+
+  /* dataready_pulsed, shared by the accelerometer and the gyroscope */
+  (void)CUSTOM_MOTION_SENSOR_Read_Register(CUSTOM_ACC_INSTANCE_0, LSM6DSOX_COUNTER_BDR_REG1, &reg);
+
+  if (Mode == 1U)
   {
-    (void)CUSTOM_MOTION_SENSOR_DRDY_Set_Mode(CUSTOM_ACC_INSTANCE_0, DRDY_PULSED);
+    reg = reg | 0x80U;
   }
   else
   {
-    (void)CUSTOM_MOTION_SENSOR_DRDY_Set_Mode(CUSTOM_ACC_INSTANCE_0, DRDY_LATCHED);
+    reg = reg & ~0x80U;
   }
-*/
+
+  (void)CUSTOM_MOTION_SENSOR_Write_Register(CUSTOM_ACC_INSTANCE_0, LSM6DSOX_COUNTER_BDR_REG1, reg);
   #endif
 #endif
 }
 #endif
 
-#if (defined CUSTOM_ALGOBUILDER_FW_TEMPLATE)
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
 /**
   * @brief  Set DRDY interrupt mode for gyroscope
   * @param  Mode Mode to be set (1 means pulsed mode otherwise latched mode)
@@ -315,25 +319,30 @@ void BSP_SENSOR_GYR_SetDRDYMode(uint8_t Mode)
 {
 #if (defined BSP_MOTION_SENSORS)
   #ifdef CUSTOM_GYR_INSTANCE_0
-/*
-  Example:
-  if (Mode == 1)
+  uint8_t reg = 0;
+
+  /* dataready_pulsed, shared by the accelerometer and the gyroscope */
+  (void)CUSTOM_MOTION_SENSOR_Read_Register(CUSTOM_GYR_INSTANCE_0, LSM6DSOX_COUNTER_BDR_REG1, &reg);
+
+  if (Mode == 1U)
   {
-    (void)CUSTOM_MOTION_SENSOR_DRDY_Set_Mode(CUSTOM_GYR_INSTANCE_0, DRDY_PULSED);
+    reg = reg | 0x80U;
   }
   else
   {
-    (void)CUSTOM_MOTION_SENSOR_DRDY_Set_Mode(CUSTOM_GYR_INSTANCE_0, DRDY_LATCHED);
+    reg = reg & ~0x80U;
   }
-*/
+
+  (void)CUSTOM_MOTION_SENSOR_Write_Register(CUSTOM_GYR_INSTANCE_0, LSM6DSOX_COUNTER_BDR_REG1, reg);
   #endif
 #endif
 }
 #endif
 
-#if (defined CUSTOM_ALGOBUILDER_FW_TEMPLATE)
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
 /**
   * @brief  Enables/Disables DRDY signal from accelerometer
+  * @note   The signal goes to INT2, INT1 carries the MLC interrupt
   * @param  Enable Define if DRDY signal is enabled or disabled
   * @retval None
   */
@@ -341,31 +350,29 @@ void BSP_SENSOR_ACC_SetDRDYInt(uint8_t Enable)
 {
 #if (defined BSP_MOTION_SENSORS)
   #ifdef CUSTOM_ACC_INSTANCE_0
-/*
-  Example:
   uint8_t reg = 0;
 
-  (void)CUSTOM_MOTION_SENSOR_Read_Register(CUSTOM_ACC_INSTANCE_0, INT1_CTRL, &reg);
+  (void)CUSTOM_MOTION_SENSOR_Read_Register(CUSTOM_ACC_INSTANCE_0, LSM6DSOX_INT2_CTRL, &reg);
 
-  if (Enable == 1)
+  if (Enable == 1U)
   {
-    reg = reg | 0x01;
+    reg = reg | 0x01U;
   }
   else
   {
-    reg = reg & ~0x01;
+    reg = reg & ~0x01U;
   }
 
-  (void)CUSTOM_MOTION_SENSOR_Write_Register(CUSTOM_ACC_INSTANCE_0, INT1_CTRL, reg);
-*/
+  (void)CUSTOM_MOTION_SENSOR_Write_Register(CUSTOM_ACC_INSTANCE_0, LSM6DSOX_INT2_CTRL, reg);
   #endif
 #endif
 }
 #endif
 
-#if (defined CUSTOM_ALGOBUILDER_FW_TEMPLATE)
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
 /**
   * @brief  Enables/Disables DRDY signal from gyroscope
+  * @note   The signal goes to INT2, INT1 carries the MLC interrupt
   * @param  Enable Define if DRDY signal is enabled or disabled
   * @retval None
   */
@@ -373,23 +380,65 @@ void BSP_SENSOR_GYR_SetDRDYInt(uint8_t Enable)
 {
 #if (defined BSP_MOTION_SENSORS)
   #ifdef CUSTOM_GYR_INSTANCE_0
-/*
-  Example:
   uint8_t reg = 0;
 
-  (void)CUSTOM_MOTION_SENSOR_Read_Register(CUSTOM_GYR_INSTANCE_0, INT1_CTRL, &reg);
+  (void)CUSTOM_MOTION_SENSOR_Read_Register(CUSTOM_GYR_INSTANCE_0, LSM6DSOX_INT2_CTRL, &reg);
 
-  if (Enable == 1)
+  if (Enable == 1U)
   {
-    reg = reg | 0x02;
+    reg = reg | 0x02U;
   }
   else
   {
-    reg = reg & ~0x02;
+    reg = reg & ~0x02U;
   }
 
-  (void)CUSTOM_MOTION_SENSOR_Write_Register(CUSTOM_GYR_INSTANCE_0, INT1_CTRL, reg);
-*/
+  (void)CUSTOM_MOTION_SENSOR_Write_Register(CUSTOM_GYR_INSTANCE_0, LSM6DSOX_INT2_CTRL, reg);
+  #endif
+#endif
+}
+#endif
+
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
+/**
+  * @brief  Enables/Disables the timestamp counter of accelerometer
+  * @param  Enable Define if the counter is enabled or disabled
+  * @retval None
+  */
+void BSP_SENSOR_ACC_SetTimestamp(uint8_t Enable)
+{
+#if (defined BSP_MOTION_SENSORS)
+  #ifdef CUSTOM_ACC_INSTANCE_0
+  uint8_t reg = 0;
+
+  (void)CUSTOM_MOTION_SENSOR_Read_Register(CUSTOM_ACC_INSTANCE_0, LSM6DSOX_CTRL10_C, &reg);
+
+  if (Enable == 1U)
+  {
+    reg = reg | 0x20U;
+  }
+  else
+  {
+    reg = reg & ~0x20U;
+  }
+
+  (void)CUSTOM_MOTION_SENSOR_Write_Register(CUSTOM_ACC_INSTANCE_0, LSM6DSOX_CTRL10_C, reg);
+  #endif
+#endif
+}
+#endif
+
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
+/**
+  * @brief  Get the timestamp counter of accelerometer
+  * @param  Ticks pointer where the counter is written to [25 us]
+  * @retval None
+  */
+void BSP_SENSOR_ACC_GetTimestamp(uint32_t *Ticks)
+{
+#if (defined BSP_MOTION_SENSORS)
+  #ifdef CUSTOM_ACC_INSTANCE_0
+  (void)CUSTOM_MOTION_SENSOR_Get_Timestamp(CUSTOM_ACC_INSTANCE_0, Ticks);
   #endif
 #endif
 }
@@ -65,18 +65,24 @@ void BSP_SENSOR_GYR_GetOrientation(char *Orientation);
 void BSP_SENSOR_MAG_GetOrientation(char *Orientation);
 #endif
 
-#if (defined CUSTOM_ALGOBUILDER_FW_TEMPLATE)
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
 void BSP_SENSOR_ACC_SetDRDYMode(uint8_t Mode);
 #endif
-#if (defined CUSTOM_ALGOBUILDER_FW_TEMPLATE)
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
 void BSP_SENSOR_GYR_SetDRDYMode(uint8_t Mode);
 #endif
-#if (defined CUSTOM_ALGOBUILDER_FW_TEMPLATE)
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
 void BSP_SENSOR_ACC_SetDRDYInt(uint8_t Enable);
 #endif
-#if (defined CUSTOM_ALGOBUILDER_FW_TEMPLATE)
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
 void BSP_SENSOR_GYR_SetDRDYInt(uint8_t Enable);
 #endif
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
+void BSP_SENSOR_ACC_SetTimestamp(uint8_t Enable);
+#endif
+#if ((defined CUSTOM_ALGOBUILDER_FW_TEMPLATE) || (defined CUSTOM_DATALOGFUSION_DEMO))
+void BSP_SENSOR_ACC_GetTimestamp(uint32_t *Ticks);
+#endif
 
 #if (defined CUSTOM_ALGOBUILDER_FW_TEMPLATE)
 void BSP_ACC_GYR_Read_FSM_Data(uint8_t *Data);
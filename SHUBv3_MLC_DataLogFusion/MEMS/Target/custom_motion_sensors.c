@@ -29,8 +29,17 @@ static MOTION_SENSOR_FuncDrv_t *MotionFuncDrv[CUSTOM_MOTION_INSTANCES_NBR][CUSTO
 static MOTION_SENSOR_CommonDrv_t *MotionDrv[CUSTOM_MOTION_INSTANCES_NBR];
 static CUSTOM_MOTION_SENSOR_Ctx_t MotionCtx[CUSTOM_MOTION_INSTANCES_NBR];
 
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1) || (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
+static int32_t LSM6DSOX_Probe(uint32_t Instance, LSM6DSOX_IO_t *IO, LSM6DSOX_Object_t *Obj, uint32_t Functions);
+#endif
 #if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1)
 static int32_t LSM6DSOX_0_Probe(uint32_t Functions);
+#if (CUSTOM_LSM6DSOX_0_BUS == CUSTOM_BUS_AUTO)
+static uint8_t LSM6DSOX_0_SpiDetect(void);
+#endif
+#endif
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
+static int32_t LSM6DSOX_1_Probe(uint32_t Functions);
 #endif
 
 /**
@@ -58,21 +67,13 @@ int32_t CUSTOM_MOTION_SENSOR_Init(uint32_t Instance, uint32_t Functions)
       {
         return BSP_ERROR_NO_INIT;
       }
-      if (MotionDrv[Instance]->GetCapabilities(MotionCompObj[Instance], (void *)&cap) != BSP_ERROR_NONE)
-      {
-        return BSP_ERROR_UNKNOWN_COMPONENT;
-      }
-      if (cap.Acc == 1U)
-      {
-        component_functions |= MOTION_ACCELERO;
-      }
-      if (cap.Gyro == 1U)
-      {
-        component_functions |= MOTION_GYRO;
-      }
-      if (cap.Magneto == 1U)
+      break;
+#endif
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
+    case CUSTOM_LSM6DSOX_1:
+      if (LSM6DSOX_1_Probe(Functions) != BSP_ERROR_NONE)
       {
-        component_functions |= MOTION_MAGNETO;
+        return BSP_ERROR_NO_INIT;
       }
       break;
 #endif
@@ -86,6 +87,23 @@ int32_t CUSTOM_MOTION_SENSOR_Init(uint32_t Instance, uint32_t Functions)
     return ret;
   }
 
+  if (MotionDrv[Instance]->GetCapabilities(MotionCompObj[Instance], (void *)&cap) != BSP_ERROR_NONE)
+  {
+    return BSP_ERROR_UNKNOWN_COMPONENT;
+  }
+  if (cap.Acc == 1U)
+  {
+    component_functions |= MOTION_ACCELERO;
+  }
+  if (cap.Gyro == 1U)
+  {
+    component_functions |= MOTION_GYRO;
+  }
+  if (cap.Magneto == 1U)
+  {
+    component_functions |= MOTION_MAGNETO;
+  }
+
   for (i = 0; i < CUSTOM_MOTION_FUNCTIONS_NBR; i++)
   {
     if (((Functions & function) == function) && ((component_functions & function) == function))
@@ -536,35 +554,27 @@ int32_t CUSTOM_MOTION_SENSOR_SetFullScale(uint32_t Instance, uint32_t Function,
   return ret;
 }
 
-#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1)
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1) || (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
 /**
- * @brief  Register Bus IOs for LSM6DSOX instance
+ * @brief  Register Bus IOs and initialize an LSM6DSOX instance
+ * @param  Instance Motion sensor instance
+ * @param  IO the bus of the instance
+ * @param  Obj the component object of the instance
  * @param  Functions Motion sensor functions. Could be :
  *         - MOTION_GYRO and/or MOTION_ACCELERO
  * @retval BSP status
  */
-static int32_t LSM6DSOX_0_Probe(uint32_t Functions)
+static int32_t LSM6DSOX_Probe(uint32_t Instance, LSM6DSOX_IO_t *IO, LSM6DSOX_Object_t *Obj, uint32_t Functions)
 {
-  LSM6DSOX_IO_t            io_ctx;
   uint8_t                  id;
-  static LSM6DSOX_Object_t lsm6dsox_obj_0;
   LSM6DSOX_Capabilities_t  cap;
   int32_t                  ret = BSP_ERROR_NONE;
 
-  /* Configure the driver */
-  io_ctx.BusType     = LSM6DSOX_I2C_BUS; /* I2C */
-  io_ctx.Address     = LSM6DSOX_I2C_ADD_L; /* SA0 = GND */
-  io_ctx.Init        = CUSTOM_LSM6DSOX_0_I2C_Init;
-  io_ctx.DeInit      = CUSTOM_LSM6DSOX_0_I2C_DeInit;
-  io_ctx.ReadReg     = CUSTOM_LSM6DSOX_0_I2C_ReadReg;
-  io_ctx.WriteReg    = CUSTOM_LSM6DSOX_0_I2C_WriteReg;
-  io_ctx.GetTick     = BSP_GetTick;
-
-  if (LSM6DSOX_RegisterBusIO(&lsm6dsox_obj_0, &io_ctx) != LSM6DSOX_OK)
+  if (LSM6DSOX_RegisterBusIO(Obj, IO) != LSM6DSOX_OK)
   {
     ret = BSP_ERROR_UNKNOWN_COMPONENT;
   }
-  else if (LSM6DSOX_ReadID(&lsm6dsox_obj_0, &id) != LSM6DSOX_OK)
+  else if (LSM6DSOX_ReadID(Obj, &id) != LSM6DSOX_OK)
   {
     ret = BSP_ERROR_UNKNOWN_COMPONENT;
   }
@@ -572,21 +582,27 @@ static int32_t LSM6DSOX_0_Probe(uint32_t Functions)
   {
     ret = BSP_ERROR_UNKNOWN_COMPONENT;
   }
+  else if ((IO->BusType != LSM6DSOX_I2C_BUS) && (lsm6dsox_i2c_interface_set(&Obj->Ctx, LSM6DSOX_I2C_DISABLE) != 0))
+  {
+    /* On SPI the I2C block of the device is turned off, it could take the
+       SPI frames for I2C starts */
+    ret = BSP_ERROR_COMPONENT_FAILURE;
+  }
   else
   {
-    (void)LSM6DSOX_GetCapabilities(&lsm6dsox_obj_0, &cap);
-    MotionCtx[CUSTOM_LSM6DSOX_0].Functions = ((uint32_t)cap.Gyro) | ((uint32_t)cap.Acc << 1) | ((uint32_t)cap.Magneto << 2);
+    (void)LSM6DSOX_GetCapabilities(Obj, &cap);
+    MotionCtx[Instance].Functions = ((uint32_t)cap.Gyro) | ((uint32_t)cap.Acc << 1) | ((uint32_t)cap.Magneto << 2);
 
-    MotionCompObj[CUSTOM_LSM6DSOX_0] = &lsm6dsox_obj_0;
+    MotionCompObj[Instance] = Obj;
     /* The second cast (void *) is added to bypass Misra R11.3 rule */
-    MotionDrv[CUSTOM_LSM6DSOX_0] = (MOTION_SENSOR_CommonDrv_t *)(void *)&LSM6DSOX_COMMON_Driver;
+    MotionDrv[Instance] = (MOTION_SENSOR_CommonDrv_t *)(void *)&LSM6DSOX_COMMON_Driver;
 
     if ((ret == BSP_ERROR_NONE) && ((Functions & MOTION_GYRO) == MOTION_GYRO) && (cap.Gyro == 1U))
     {
       /* The second cast (void *) is added to bypass Misra R11.3 rule */
-      MotionFuncDrv[CUSTOM_LSM6DSOX_0][FunctionIndex[MOTION_GYRO]] = (MOTION_SENSOR_FuncDrv_t *)(void *)&LSM6DSOX_GYRO_Driver;
+      MotionFuncDrv[Instance][FunctionIndex[MOTION_GYRO]] = (MOTION_SENSOR_FuncDrv_t *)(void *)&LSM6DSOX_GYRO_Driver;
 
-      if (MotionDrv[CUSTOM_LSM6DSOX_0]->Init(MotionCompObj[CUSTOM_LSM6DSOX_0]) != LSM6DSOX_OK)
+      if (MotionDrv[Instance]->Init(MotionCompObj[Instance]) != LSM6DSOX_OK)
       {
         ret = BSP_ERROR_COMPONENT_FAILURE;
       }
@@ -598,9 +614,9 @@ static int32_t LSM6DSOX_0_Probe(uint32_t Functions)
     if ((ret == BSP_ERROR_NONE) && ((Functions & MOTION_ACCELERO) == MOTION_ACCELERO) && (cap.Acc == 1U))
     {
       /* The second cast (void *) is added to bypass Misra R11.3 rule */
-      MotionFuncDrv[CUSTOM_LSM6DSOX_0][FunctionIndex[MOTION_ACCELERO]] = (MOTION_SENSOR_FuncDrv_t *)(void *)&LSM6DSOX_ACC_Driver;
+      MotionFuncDrv[Instance][FunctionIndex[MOTION_ACCELERO]] = (MOTION_SENSOR_FuncDrv_t *)(void *)&LSM6DSOX_ACC_Driver;
 
-      if (MotionDrv[CUSTOM_LSM6DSOX_0]->Init(MotionCompObj[CUSTOM_LSM6DSOX_0]) != LSM6DSOX_OK)
+      if (MotionDrv[Instance]->Init(MotionCompObj[Instance]) != LSM6DSOX_OK)
       {
         ret = BSP_ERROR_COMPONENT_FAILURE;
       }
@@ -620,3 +636,99 @@ static int32_t LSM6DSOX_0_Probe(uint32_t Functions)
 }
 #endif
 
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1)
+/**
+ * @brief  Register Bus IOs for LSM6DSOX instance
+ * @param  Functions Motion sensor functions. Could be :
+ *         - MOTION_GYRO and/or MOTION_ACCELERO
+ * @retval BSP status
+ */
+static int32_t LSM6DSOX_0_Probe(uint32_t Functions)
+{
+  LSM6DSOX_IO_t            io_ctx;
+  static LSM6DSOX_Object_t lsm6dsox_obj_0;
+  uint8_t                  spi;
+
+#if (CUSTOM_LSM6DSOX_0_BUS == CUSTOM_BUS_AUTO)
+  spi = LSM6DSOX_0_SpiDetect();
+#elif (CUSTOM_LSM6DSOX_0_BUS == CUSTOM_BUS_SPI)
+  spi = 1U;
+#else
+  spi = 0U;
+#endif
+
+  /* Configure the driver */
+  if (spi != 0U)
+  {
+    io_ctx.BusType     = LSM6DSOX_SPI_4WIRES_BUS; /* SPI 4-Wires */
+    io_ctx.Address     = 0;
+    io_ctx.Init        = CUSTOM_LSM6DSOX_0_SPI_Init;
+    io_ctx.DeInit      = CUSTOM_LSM6DSOX_0_SPI_DeInit;
+    io_ctx.ReadReg     = CUSTOM_LSM6DSOX_0_SPI_ReadReg;
+    io_ctx.WriteReg    = CUSTOM_LSM6DSOX_0_SPI_WriteReg;
+  }
+  else
+  {
+    io_ctx.BusType     = LSM6DSOX_I2C_BUS; /* I2C */
+    io_ctx.Address     = LSM6DSOX_I2C_ADD_L; /* SA0 = GND */
+    io_ctx.Init        = CUSTOM_LSM6DSOX_0_I2C_Init;
+    io_ctx.DeInit      = CUSTOM_LSM6DSOX_0_I2C_DeInit;
+    io_ctx.ReadReg     = CUSTOM_LSM6DSOX_0_I2C_ReadReg;
+    io_ctx.WriteReg    = CUSTOM_LSM6DSOX_0_I2C_WriteReg;
+  }
+  io_ctx.GetTick     = BSP_GetTick;
+
+  return LSM6DSOX_Probe(CUSTOM_LSM6DSOX_0, &io_ctx, &lsm6dsox_obj_0, Functions);
+}
+
+#if (CUSTOM_LSM6DSOX_0_BUS == CUSTOM_BUS_AUTO)
+/**
+  * @brief  Look for the LSM6DSOX on SPI1
+  * @retval 1 if WHO_AM_I answers on SPI1, 0 otherwise (SPI1 is released)
+  */
+static uint8_t LSM6DSOX_0_SpiDetect(void)
+{
+  uint8_t id = 0;
+  uint8_t found;
+
+  if (CUSTOM_LSM6DSOX_0_SPI_Init() != BSP_ERROR_NONE)
+  {
+    return 0U;
+  }
+
+  found = ((CUSTOM_LSM6DSOX_0_SPI_ReadReg(0, LSM6DSOX_WHO_AM_I, &id, 1) == BSP_ERROR_NONE)
+           && (id == (uint8_t)LSM6DSOX_ID)) ? 1U : 0U;
+
+  /* The probe initializes the bus again through the IO */
+  (void)CUSTOM_LSM6DSOX_0_SPI_DeInit();
+
+  return found;
+}
+#endif
+#endif
+
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
+/**
+ * @brief  Register Bus IOs for LSM6DSOX instance 1
+ * @param  Functions Motion sensor functions. Could be :
+ *         - MOTION_GYRO and/or MOTION_ACCELERO
+ * @retval BSP status
+ */
+static int32_t LSM6DSOX_1_Probe(uint32_t Functions)
+{
+  LSM6DSOX_IO_t            io_ctx;
+  static LSM6DSOX_Object_t lsm6dsox_obj_1;
+
+  /* Configure the driver */
+  io_ctx.BusType     = LSM6DSOX_I2C_BUS; /* I2C */
+  io_ctx.Address     = LSM6DSOX_I2C_ADD_H; /* SA0 = VDD */
+  io_ctx.Init        = CUSTOM_LSM6DSOX_1_I2C_Init;
+  io_ctx.DeInit      = CUSTOM_LSM6DSOX_1_I2C_DeInit;
+  io_ctx.ReadReg     = CUSTOM_LSM6DSOX_1_I2C_ReadReg;
+  io_ctx.WriteReg    = CUSTOM_LSM6DSOX_1_I2C_WriteReg;
+  io_ctx.GetTick     = BSP_GetTick;
+
+  return LSM6DSOX_Probe(CUSTOM_LSM6DSOX_1, &io_ctx, &lsm6dsox_obj_1, Functions);
+}
+#endif
+
@@ -30,7 +30,7 @@ extern "C" {
 #include "custom_mems_conf.h"
 #include "motion_sensor.h"
 
-#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1)
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1) || (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
 #include "lsm6dsox.h"
 #endif
 
@@ -38,6 +38,10 @@ extern "C" {
 #define CUSTOM_LSM6DSOX_0 (0)
 #endif
 
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
+#define CUSTOM_LSM6DSOX_1 (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0)
+#endif
+
 typedef struct
 {
   int32_t x;
@@ -83,7 +87,7 @@ typedef struct
 #endif
 
 #define CUSTOM_MOTION_FUNCTIONS_NBR    3U
-#define CUSTOM_MOTION_INSTANCES_NBR    (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0)
+#define CUSTOM_MOTION_INSTANCES_NBR    (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 + USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1)
 
 #if (CUSTOM_MOTION_INSTANCES_NBR == 0)
 #error "No motion sensor instance has been selected"
@@ -35,8 +35,13 @@ int32_t CUSTOM_MOTION_SENSOR_Read_Register(uint32_t Instance, uint8_t Reg, uint8
   switch (Instance)
   {
 
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1) || (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
 #if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1)
     case CUSTOM_LSM6DSOX_0:
+#endif
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
+    case CUSTOM_LSM6DSOX_1:
+#endif
       if (LSM6DSOX_Read_Reg(MotionCompObj[Instance], Reg, Data) != BSP_ERROR_NONE)
       {
         ret = BSP_ERROR_COMPONENT_FAILURE;
@@ -70,8 +75,13 @@ int32_t CUSTOM_MOTION_SENSOR_Write_Register(uint32_t Instance, uint8_t Reg, uint
   switch (Instance)
   {
 
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1) || (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
 #if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1)
     case CUSTOM_LSM6DSOX_0:
+#endif
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
+    case CUSTOM_LSM6DSOX_1:
+#endif
       if (LSM6DSOX_Write_Reg(MotionCompObj[Instance], Reg, Data) != BSP_ERROR_NONE)
       {
         ret = BSP_ERROR_COMPONENT_FAILURE;
@@ -105,8 +115,13 @@ int32_t CUSTOM_MOTION_SENSOR_Get_DRDY_Status(uint32_t Instance, uint32_t Functio
   switch (Instance)
   {
 
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1) || (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
 #if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1)
     case CUSTOM_LSM6DSOX_0:
+#endif
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
+    case CUSTOM_LSM6DSOX_1:
+#endif
       if ((Function & MOTION_ACCELERO) == MOTION_ACCELERO)
       {
         if (LSM6DSOX_ACC_Get_DRDY_Status(MotionCompObj[Instance], Status) != BSP_ERROR_NONE)
@@ -144,6 +159,45 @@ int32_t CUSTOM_MOTION_SENSOR_Get_DRDY_Status(uint32_t Instance, uint32_t Functio
   return ret;
 }
 
+/**
+ * @brief  Get the timestamp counter
+ * @param  Instance the device instance
+ * @param  Ticks the pointer to the counter [25 us]
+ * @retval BSP status
+ */
+int32_t CUSTOM_MOTION_SENSOR_Get_Timestamp(uint32_t Instance, uint32_t *Ticks)
+{
+  int32_t ret;
+
+  switch (Instance)
+  {
+
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1) || (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_0 == 1)
+    case CUSTOM_LSM6DSOX_0:
+#endif
+#if (USE_CUSTOM_MOTION_SENSOR_LSM6DSOX_1 == 1)
+    case CUSTOM_LSM6DSOX_1:
+#endif
+      if (lsm6dsox_timestamp_raw_get(&((LSM6DSOX_Object_t *)MotionCompObj[Instance])->Ctx, Ticks) != BSP_ERROR_NONE)
+      {
+        ret = BSP_ERROR_COMPONENT_FAILURE;
+      }
+      else
+      {
+        ret = BSP_ERROR_NONE;
+      }
+      break;
+#endif
+
+    default:
+      ret = BSP_ERROR_WRONG_PARAM;
+      break;
+  }
+
+  return ret;
+}
+
 /**
  * @brief  Enable the free fall detection
  * @param  Instance the device instance
@@ -25,6 +25,10 @@
 #include "demo_serial.h"
 #include "fw_version.h"
 #include "motion_fx_manager.h"
+#include "task_sched.h"
+#include "mlc_manager.h"
+#include "app_mems.h"
+#include "ipc_link.h"
 
 #ifdef USE_CUSTOM_BOARD
 #include "custom_mems_conf_app.h"
@@ -55,6 +59,8 @@
 static volatile uint8_t DataStreamingDest = 1;
 
 /* Private function prototypes -----------------------------------------------*/
+static void Send_Stream_Format(TMsg *Msg);
+
 /* Exported functions ------------------------------------------------------- */
 /**
  * @brief  Build the reply header
@@ -229,6 +235,10 @@ int HandleMSG(TMsg *Msg)
 
       SensorsEnabled = Deserialize(&Msg->Data[3], 4);
 
+#if (APP_DUAL_CORE == 1)
+      /* The CM0+ runs the sensors and paces the stream with its blocks */
+      IPC_LINK_SetActive(1);
+#else
       /* Start enabled sensors */
       if ((SensorsEnabled & PRESSURE_SENSOR) == PRESSURE_SENSOR)
       {
@@ -260,13 +270,21 @@ int HandleMSG(TMsg *Msg)
         BSP_SENSOR_MAG_Enable();
       }
 
-      (void)HAL_TIM_Base_Start_IT(&BSP_IP_TIM_Handle);
+      MX_MEMS_Start_Sampling();
+#endif
       DataLoggerActive = 1;
+      TASK_SCHED_Post(StreamTaskId, STREAM_EVT_CONFIG);
 
       DataStreamingDest = Msg->Data[1];
       BUILD_REPLY_HEADER(Msg);
       Msg->Len = 3;
       UART_SendMsg(Msg);
+
+      /* The compact frames do not carry their format, see fusion_codec.h */
+      if (StreamFormat.Format != (uint8_t)FUSION_CODEC_FLOAT)
+      {
+        Send_Stream_Format(Msg);
+      }
       break;
 
     case CMD_Stop_Data_Streaming:
@@ -276,18 +294,26 @@ int HandleMSG(TMsg *Msg)
       }
 
       DataLoggerActive = 0;
-      (void)HAL_TIM_Base_Stop_IT(&BSP_IP_TIM_Handle);
+#if (APP_DUAL_CORE == 1)
+      IPC_LINK_SetActive(0);
+#else
+      MX_MEMS_Stop_Sampling();
 
-      /* Disable all sensors */
-      BSP_SENSOR_ACC_Disable();
-      BSP_SENSOR_GYR_Disable();
+      /* Disable all sensors, the MLC keeps the accelerometer and gyroscope */
+      if (MLC_manager_is_running() == 0U)
+      {
+        BSP_SENSOR_ACC_Disable();
+        BSP_SENSOR_GYR_Disable();
+      }
       BSP_SENSOR_MAG_Disable();
       BSP_SENSOR_PRESS_Disable();
       BSP_SENSOR_TEMP_Disable();
       BSP_SENSOR_HUM_Disable();
+#endif
 
       SensorsEnabled = 0;
       UseOfflineData = 0;
+      TASK_SCHED_Post(StreamTaskId, STREAM_EVT_CONFIG);
 
       BUILD_REPLY_HEADER(Msg);
       UART_SendMsg(Msg);
@@ -353,7 +379,7 @@ int HandleMSG(TMsg *Msg)
         }
       }
 
-      SensorReadRequest = 1;
+      TASK_SCHED_Post(StreamTaskId, STREAM_EVT_READ);
 
       /* Mark Msg as read */
       BUILD_REPLY_HEADER(Msg);
@@ -370,14 +396,19 @@ int HandleMSG(TMsg *Msg)
       {
         UseOfflineData = 1U;
         sensors_enabled_prev = SensorsEnabled;
-        SensorsEnabled = 0xFFFFFFFFU;
-        (void)HAL_TIM_Base_Stop_IT(&BSP_IP_TIM_Handle);
+        SensorsEnabled = 0xFFFFFFFFU & ~MLC_SENSOR; /* Offline frames keep the Unicleo length */
+#if (APP_DUAL_CORE == 1)
+        IPC_LINK_SetActive(0);
+#else
+        MX_MEMS_Stop_Sampling();
+#endif
       }
       else
       {
         UseOfflineData = 0U;
         SensorsEnabled = sensors_enabled_prev;
       }
+      TASK_SCHED_Post(StreamTaskId, STREAM_EVT_CONFIG);
 
       BUILD_REPLY_HEADER(Msg);
       UART_SendMsg(Msg);
@@ -397,6 +428,54 @@ int HandleMSG(TMsg *Msg)
       UART_SendMsg(Msg);
       break;
 
+    case CMD_Stream_Format:
+      if (Msg->Len < 4U)
+      {
+        return 0;
+      }
+
+      /* The precision bytes are optional, the previous ones are kept */
+      if ((Msg->Data[3] > (uint8_t)FUSION_CODEC_FIXED)
+          || ((Msg->Len >= 6U) && ((Msg->Data[4] > FUSION_CODEC_MAX_FRAC) || (Msg->Data[5] > FUSION_CODEC_MAX_FRAC))))
+      {
+        return 0;
+      }
+
+      StreamFormat.Format = Msg->Data[3];
+      if (Msg->Len >= 6U)
+      {
+        StreamFormat.AngleFrac = Msg->Data[4];
+        StreamFormat.AccFrac = Msg->Data[5];
+      }
+
+      /* The field offsets in the full frame follow the format */
+      (void)STREAM_PLAN_Build(StreamPlan.Fields, StreamFormat.Format, &StreamPlan);
+      TASK_SCHED_Post(StreamTaskId, STREAM_EVT_CONFIG);
+
+      BUILD_REPLY_HEADER(Msg);
+      Send_Stream_Format(Msg);
+      break;
+
+    case CMD_Stream_Subscribe:
+      if (Msg->Len < 5U)
+      {
+        return 0;
+      }
+
+      /* The plan is built here once, each sample then only runs its copies */
+      if (STREAM_PLAN_Build((uint16_t)Deserialize(&Msg->Data[3], 2), StreamFormat.Format, &StreamPlan)
+          != STREAM_PLAN_OK)
+      {
+        return 0;
+      }
+
+      BUILD_REPLY_HEADER(Msg);
+      Serialize(&Msg->Data[3], StreamPlan.Fields, 2);
+      Msg->Data[5] = (StreamPlan.Fields != 0U) ? StreamPlan.Len : 0U;
+      Msg->Len = 3 + 3;
+      UART_SendMsg(Msg);
+      break;
+
     case CMD_ChangeSF:
       if (Msg->Len < 3U)
       {
@@ -507,6 +586,24 @@ void Get_PresentationString(char *PresentationString, uint32_t *Length)
   *Length = snprintf(PresentationString, 64, ps, lib_version_num);
 }
 
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief  Send the CMD_Stream_Format reply with the active settings
+ * @note   Also sent after the CMD_Start_Data_Streaming reply, the host
+ *         decodes the compact frames with the last one it saw.
+ * @param  Msg the message, its reply header built
+ * @retval None
+ */
+static void Send_Stream_Format(TMsg *Msg)
+{
+  Msg->Data[2] = CMD_Stream_Format + CMD_Reply_Add;
+  Msg->Data[3] = StreamFormat.Format;
+  Msg->Data[4] = StreamFormat.AngleFrac;
+  Msg->Data[5] = StreamFormat.AccFrac;
+  Msg->Len = 3 + 3;
+  UART_SendMsg(Msg);
+}
+
 /**
  * @}
  */
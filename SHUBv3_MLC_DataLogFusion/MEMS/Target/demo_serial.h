@@ -29,6 +29,8 @@ extern "C" {
 #include "serial_cmd.h"
 #include "bsp_ip_conf.h"
 #include "motion_fx_manager.h"
+#include "fusion_codec.h"
+#include "stream_plan.h"
 
 /* Exported types ------------------------------------------------------------*/
 typedef struct {
@@ -68,23 +70,38 @@ typedef struct {
 #define ACCELEROMETER_SENSOR  0x00000010U
 #define GYROSCOPE_SENSOR      0x00000020U
 #define MAGNETIC_SENSOR       0x00000040U
+#define MLC_SENSOR            0x00000080U
 
 #define STREAMING_MSG_LENGTH  119
+#define STREAMING_MSG_LENGTH_MLC  121 /* With MLC_SENSOR: MLC0_SRC and event counter appended */
+
+/* With a compact fusion format (CMD_Stream_Format) the fusion outputs at
+ * STREAMING_FX_OFFSET take FUSION_CODEC_SIZE bytes, then come the fusion
+ * time and the MLC bytes */
+#define STREAMING_FX_OFFSET  55
+#define STREAMING_MSG_LENGTH_COMPACT  (STREAMING_FX_OFFSET + FUSION_CODEC_SIZE + 4U) /* 88 */
+#define STREAMING_MSG_LENGTH_COMPACT_MLC  (STREAMING_MSG_LENGTH_COMPACT + 2U)
 
 #define REQUIRED_DATA  (ACCELEROMETER_SENSOR + GYROSCOPE_SENSOR)
 
+/* Stream task events */
+#define STREAM_EVT_READ    0x00000001U
+#define STREAM_EVT_CONFIG  0x00000002U /* Enabled sensors, data source or fusion format changed */
+
 /* Exported variables --------------------------------------------------------*/
 extern volatile uint8_t DataLoggerActive;
 extern volatile uint32_t SensorsEnabled;
-extern volatile uint8_t SensorReadRequest;
+extern uint32_t StreamTaskId;
 extern uint8_t UseOfflineData;
-extern offline_data_t OfflineData[OFFLINE_DATA_SIZE];
+extern offline_data_t *OfflineData;
 extern int OfflineDataReadIndex;
 extern int OfflineDataWriteIndex;
 extern int OfflineDataCount;
 extern uint32_t AlgoFreq;
 
 extern uint8_t Enabled6X;
+extern FUSION_CODEC_Config_t StreamFormat;
+extern STREAM_PLAN_t StreamPlan;
 
 /* Exported functions ------------------------------------------------------- */
 void BUILD_REPLY_HEADER(TMsg *Msg);
@@ -0,0 +1,277 @@
+/**
+  ******************************************************************************
+  * @file    fusion_codec.c
+  * @author  ISCA Lab
+  * @brief   Compact encoding of the MotionFX outputs for the data stream
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <string.h>
+#include "fusion_codec.h"
+#include "mem_placement.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup FUSION_CODEC FUSION CODEC
+ * @{
+ */
+
+/* Private defines -----------------------------------------------------------*/
+#define QUAT_MAX      ((1UL << FUSION_CODEC_QUAT_BITS) - 1UL)
+#define QUAT_SIZE     7U
+#define SQRT2         1.41421356f
+#define HALF_MAX      0x7BFFU /* 65504 */
+#define FIXED_MAX     32767
+
+/* Private function prototypes -----------------------------------------------*/
+static void PackQuat(const float *Quat, uint8_t *Out);
+static uint16_t ToFixed(float Value, uint8_t Frac);
+static uint8_t *PutValues(const FUSION_CODEC_Config_t *Config, uint8_t Frac, const float *Values, uint32_t Count,
+                          uint8_t *Out);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief  Encode the fusion outputs in FUSION_CODEC_SIZE bytes
+ * @param  Config the format and fixed point precision
+ * @param  Output the MotionFX outputs, NULL if the fusion did not run: an
+ *         identity quaternion and zeros are written
+ * @param  Out the destination, FUSION_CODEC_SIZE bytes
+ * @retval Bytes written, 0 if the configuration is not a compact format
+ */
+RAM_FUNC uint32_t FUSION_CODEC_Encode(const FUSION_CODEC_Config_t *Config, const MFX_output_t *Output, uint8_t *Out)
+{
+  static const float identity[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+  static const float zero[3] = { 0.0f, 0.0f, 0.0f };
+  uint8_t *p = Out;
+
+  if (((Config->Format != (uint8_t)FUSION_CODEC_HALF) && (Config->Format != (uint8_t)FUSION_CODEC_FIXED))
+      || (Config->AngleFrac > FUSION_CODEC_MAX_FRAC) || (Config->AccFrac > FUSION_CODEC_MAX_FRAC))
+  {
+    return 0;
+  }
+
+  if (Output == NULL)
+  {
+    PackQuat(identity, p);
+    p += QUAT_SIZE;
+    p = PutValues(Config, 0U, zero, 3U, p);
+    p = PutValues(Config, 0U, zero, 3U, p);
+    p = PutValues(Config, 0U, zero, 3U, p);
+    p = PutValues(Config, 0U, zero, 2U, p);
+  }
+  else
+  {
+    PackQuat(Output->quaternion, p);
+    p += QUAT_SIZE;
+    p = PutValues(Config, Config->AngleFrac, Output->rotation, 3U, p);
+    p = PutValues(Config, Config->AccFrac, Output->gravity, 3U, p);
+    p = PutValues(Config, Config->AccFrac, Output->linear_acceleration, 3U, p);
+    p = PutValues(Config, Config->AngleFrac, &Output->heading, 1U, p);
+    p = PutValues(Config, Config->AngleFrac, &Output->headingErr, 1U, p);
+  }
+
+  return (uint32_t)(p - Out);
+}
+
+/**
+ * @brief  Convert a float to an IEEE 754 half float
+ * @note   Rounds to nearest even from the float bits, no FPU needed. Values
+ *         past 65504 saturate, NaN stays NaN.
+ * @param  Value the value
+ * @retval The half float bits
+ */
+RAM_FUNC uint16_t FUSION_CODEC_ToHalf(float Value)
+{
+  uint32_t bits;
+  uint32_t sign;
+  uint32_t mant;
+  uint32_t half;
+  uint32_t rest;
+  uint32_t shift;
+  int32_t exp;
+
+  (void)memcpy(&bits, &Value, sizeof(bits));
+  sign = (bits >> 16) & 0x8000U;
+  exp = (int32_t)((bits >> 23) & 0xFFU);
+  mant = bits & 0x7FFFFFU;
+
+  if (exp == 0xFF)
+  {
+    return (uint16_t)(sign | ((mant != 0U) ? 0x7E00U : HALF_MAX));
+  }
+
+  exp = exp - 127 + 15;
+
+  if (exp >= 31)
+  {
+    return (uint16_t)(sign | HALF_MAX);
+  }
+
+  if (exp <= 0)
+  {
+    /* Subnormal half, below 2^-25 it rounds to zero */
+    if (exp < -10)
+    {
+      return (uint16_t)sign;
+    }
+    mant |= 0x800000U;
+    shift = (uint32_t)(14 - exp);
+    half = mant >> shift;
+    rest = mant & ((1U << shift) - 1U);
+  }
+  else
+  {
+    shift = 13U;
+    half = ((uint32_t)exp << 10) | (mant >> shift);
+    rest = mant & 0x1FFFU;
+  }
+
+  /* A carry out of the mantissa steps the exponent, as it should */
+  if ((rest > (1U << (shift - 1U))) || ((rest == (1U << (shift - 1U))) && ((half & 1U) != 0U)))
+  {
+    half++;
+  }
+
+  if (half > HALF_MAX)
+  {
+    half = HALF_MAX;
+  }
+
+  return (uint16_t)(sign | half);
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief  Pack a quaternion as its smallest three components
+ * @param  Quat the quaternion
+ * @param  Out the destination, 7 bytes
+ * @retval None
+ */
+static void PackQuat(const float *Quat, uint8_t *Out)
+{
+  uint64_t bits;
+  uint32_t largest = 0;
+  uint32_t shift = 2;
+  uint32_t i;
+  float norm = 0.0f;
+  float scale;
+  float value;
+
+  for (i = 0; i < 4U; i++)
+  {
+    norm += Quat[i] * Quat[i];
+    if (fabsf(Quat[i]) > fabsf(Quat[largest]))
+    {
+      largest = i;
+    }
+  }
+
+  if (norm <= 0.0f)
+  {
+    /* No orientation yet, send the identity */
+    largest = 3;
+    norm = 1.0f;
+  }
+
+  /* Normalize, negate so the dropped component is positive, then map
+   * [-1/sqrt(2), 1/sqrt(2)] to [0, QUAT_MAX] */
+  scale = ((Quat[largest] < 0.0f) ? -1.0f : 1.0f) / sqrtf(norm);
+  bits = largest;
+
+  for (i = 0; i < 4U; i++)
+  {
+    if (i == largest)
+    {
+      continue;
+    }
+
+    value = ((Quat[i] * scale * SQRT2) + 1.0f) * (0.5f * (float)QUAT_MAX) + 0.5f;
+    if (value < 0.0f)
+    {
+      value = 0.0f;
+    }
+    if (value > (float)QUAT_MAX)
+    {
+      value = (float)QUAT_MAX;
+    }
+
+    bits |= (uint64_t)(uint32_t)value << shift;
+    shift += FUSION_CODEC_QUAT_BITS;
+  }
+
+  for (i = 0; i < QUAT_SIZE; i++)
+  {
+    Out[i] = (uint8_t)(bits >> (8U * i));
+  }
+}
+
+/**
+ * @brief  Convert a value to signed fixed point, rounded and saturated
+ * @param  Value the value
+ * @param  Frac the fractional bits
+ * @retval The two's complement bits
+ */
+static uint16_t ToFixed(float Value, uint8_t Frac)
+{
+  float scaled = Value * (float)(1UL << Frac);
+  int32_t fixed;
+
+  if (scaled >= (float)FIXED_MAX)
+  {
+    fixed = FIXED_MAX;
+  }
+  else if (scaled <= -(float)FIXED_MAX)
+  {
+    fixed = -FIXED_MAX;
+  }
+  else
+  {
+    fixed = (int32_t)(scaled + ((scaled >= 0.0f) ? 0.5f : -0.5f));
+  }
+
+  return (uint16_t)fixed;
+}
+
+/**
+ * @brief  Write 16 bit values in the configured format
+ * @param  Config the format
+ * @param  Frac the fractional bits of these values (fixed point only)
+ * @param  Values the values
+ * @param  Count the number of values
+ * @param  Out the destination
+ * @retval The position after the values
+ */
+static uint8_t *PutValues(const FUSION_CODEC_Config_t *Config, uint8_t Frac, const float *Values, uint32_t Count,
+                          uint8_t *Out)
+{
+  uint16_t value;
+  uint32_t i;
+
+  for (i = 0; i < Count; i++)
+  {
+    value = (Config->Format == (uint8_t)FUSION_CODEC_HALF) ? FUSION_CODEC_ToHalf(Values[i]) : ToFixed(Values[i], Frac);
+    *Out++ = (uint8_t)value;
+    *Out++ = (uint8_t)(value >> 8);
+  }
+
+  return Out;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * @file    fusion_codec.h
+  * @author  ISCA Lab
+  * @brief   Compact encoding of the MotionFX outputs for the data stream
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef FUSION_CODEC_H
+#define FUSION_CODEC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h> /* size_t, used by motion_fx.h */
+#include <stdint.h>
+#include "motion_fx.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup FUSION_CODEC FUSION CODEC
+ * @{
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+/*
+ * The float stream copies the MotionFX outputs as 15 floats, 60 bytes. The
+ * compact block is FUSION_CODEC_SIZE bytes:
+ *   [0..6]    quaternion, smallest three
+ *   [7..12]   rotation: yaw, pitch, roll [deg]
+ *   [13..18]  gravity [g]
+ *   [19..24]  linear acceleration [g]
+ *   [25..26]  heading [deg]
+ *   [27..28]  heading error [deg]
+ * Values are 16 bit little endian: IEEE 754 half floats, or signed fixed
+ * point saturated to +/-32767.
+ *
+ * The block does not carry its format and fractional bits. They only change
+ * with CMD_Stream_Format, whose reply gives them, and that reply is sent
+ * again after the CMD_Start_Data_Streaming one while a compact format is
+ * set. The host keeps the last one it saw.
+ *
+ * Smallest three: q and -q are the same rotation, so the quaternion is
+ * normalized and negated until its largest component is positive. The 2 bit
+ * index of that component and the three others, each in
+ * [-1/sqrt(2), 1/sqrt(2)] and quantized to FUSION_CODEC_QUAT_BITS, are packed
+ * LSB first in 56 bits. The decoder restores the largest one from the unit
+ * norm.
+ */
+#define FUSION_CODEC_SIZE       29U
+#define FUSION_CODEC_QUAT_BITS  18U
+#define FUSION_CODEC_MAX_FRAC   15U
+
+/* Default fixed point precision, changed at run time with CMD_Stream_Format */
+#ifndef FUSION_CODEC_ANGLE_FRAC
+#define FUSION_CODEC_ANGLE_FRAC  6U  /* 1/64 deg, up to +/-512 deg */
+#endif
+
+#ifndef FUSION_CODEC_ACC_FRAC
+#define FUSION_CODEC_ACC_FRAC  12U   /* 1/4096 g, up to +/-8 g */
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+  FUSION_CODEC_FLOAT = 0,  /* Unicleo layout, not encoded here */
+  FUSION_CODEC_HALF  = 1,
+  FUSION_CODEC_FIXED = 2,
+} FUSION_CODEC_Format_t;
+
+typedef struct
+{
+  uint8_t Format;     /* FUSION_CODEC_Format_t */
+  uint8_t AngleFrac;  /* Fractional bits of rotation and heading */
+  uint8_t AccFrac;    /* Fractional bits of gravity and linear acceleration */
+} FUSION_CODEC_Config_t;
+
+/* Exported functions --------------------------------------------------------*/
+uint32_t FUSION_CODEC_Encode(const FUSION_CODEC_Config_t *Config, const MFX_output_t *Output, uint8_t *Out);
+uint16_t FUSION_CODEC_ToHalf(float Value);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FUSION_CODEC_H */
@@ -0,0 +1,458 @@
+/**
+  ******************************************************************************
+  * @file    fx_mahony.c
+  * @author  ISCA Lab
+  * @brief   Fixed-point 6 axes Mahony fusion, in-tree alternative to MotionFX
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "fx_mahony.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup FX_MAHONY FX MAHONY
+ * @{
+ */
+
+/* Private defines -----------------------------------------------------------*/
+/* Half angle per period of 1 mdps (Q23.8) over 1 us, Q24 in Q16:
+ * pi / (180000 * 256) / 2 / 1e6 * 2^30 * 2^24 * 2^16 */
+#define FX_MAHONY_GYRO_K_Q16  40244553ULL
+
+/* Millidegrees per radian, Q16 */
+#define FX_MAHONY_MDEG_Q16  3754936206LL
+
+/* atan(r) on [0, 1], Abramowitz and Stegun 4.4.49, 1e-5 rad, Q30 */
+#define FX_MAHONY_ATAN_A1   1073597943
+#define FX_MAHONY_ATAN_A3   (-354656388)
+#define FX_MAHONY_ATAN_A5   193424926
+#define FX_MAHONY_ATAN_A7   (-91410863)
+#define FX_MAHONY_ATAN_A9   22371518
+
+/* Private function prototypes -----------------------------------------------*/
+static int32_t FX_MAHONY_Mul(int32_t A, int32_t B);
+static uint32_t FX_MAHONY_Sqrt(uint64_t Value);
+static int32_t FX_MAHONY_Clamp(int32_t Value, int32_t Max);
+static void FX_MAHONY_Gravity(const int32_t Q[4], int32_t V[3]);
+static void FX_MAHONY_Align(FX_MAHONY_t *Eng, const int32_t A[3]);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief  Initialize the engine
+ * @param  Eng the engine
+ * @param  PeriodUs the sample period [us], 1 to FX_MAHONY_MAX_PERIOD_US
+ * @param  Kp the proportional gain [1/s, Q16]
+ * @param  Ki the integral gain [1/s, Q16]
+ * @retval FX_MAHONY_OK in case of success, FX_MAHONY_ERROR otherwise
+ */
+int32_t FX_MAHONY_Init(FX_MAHONY_t *Eng, uint32_t PeriodUs, uint32_t Kp, uint32_t Ki)
+{
+  if (Eng == NULL)
+  {
+    return FX_MAHONY_ERROR;
+  }
+
+  Eng->Kp = Kp;
+  Eng->Ki = Ki;
+  Eng->PeriodUs = 0;
+  FX_MAHONY_Reset(Eng);
+
+  return FX_MAHONY_SetPeriod(Eng, PeriodUs);
+}
+
+/**
+ * @brief  Set the sample period
+ * @note   Keeps the orientation and the bias estimate
+ * @param  Eng the engine
+ * @param  PeriodUs the sample period [us], 1 to FX_MAHONY_MAX_PERIOD_US
+ * @retval FX_MAHONY_OK in case of success, FX_MAHONY_ERROR otherwise
+ */
+int32_t FX_MAHONY_SetPeriod(FX_MAHONY_t *Eng, uint32_t PeriodUs)
+{
+  uint64_t ki;
+  int32_t bias;
+
+  if ((PeriodUs == 0U) || (PeriodUs > FX_MAHONY_MAX_PERIOD_US))
+  {
+    return FX_MAHONY_ERROR;
+  }
+
+  /* The bias estimate is a half angle per period: rescale it */
+  for (uint32_t i = 0; (i < 3U) && (Eng->PeriodUs != 0U); i++)
+  {
+    Eng->Bias[i] = (int32_t)(((int64_t)Eng->Bias[i] * PeriodUs) / Eng->PeriodUs);
+  }
+
+  Eng->PeriodUs = PeriodUs;
+  Eng->GyroK = (uint32_t)(((uint64_t)PeriodUs * FX_MAHONY_GYRO_K_Q16) >> 16);
+  Eng->KpK = (int32_t)(((uint64_t)Eng->Kp * PeriodUs * 8192U) / 1000000U);
+  ki = (uint64_t)Eng->Ki * PeriodUs * PeriodUs;
+  Eng->KiK = (int32_t)((ki * 8192U) / 1000000000000ULL);
+
+  bias = FX_MAHONY_BIAS_MAX * MEMS_FIXED_ONE;
+  Eng->BiasMax = (int32_t)(((int64_t)bias * Eng->GyroK) >> 24);
+
+  return FX_MAHONY_OK;
+}
+
+/**
+ * @brief  Restart from the identity, aligned again on the next update
+ * @param  Eng the engine
+ * @retval None
+ */
+void FX_MAHONY_Reset(FX_MAHONY_t *Eng)
+{
+  Eng->Q[0] = FX_MAHONY_ONE;
+  for (uint32_t i = 0; i < 3U; i++)
+  {
+    Eng->Q[i + 1U] = 0;
+    Eng->Corr[i] = 0;
+    Eng->Bias[i] = 0;
+  }
+  Eng->Aligned = 0;
+}
+
+/**
+ * @brief  Rotate the orientation by a gyroscope sample
+ * @param  Eng the engine
+ * @param  Gyro the angular rate [mdps, Q23.8]
+ * @retval None
+ */
+void FX_MAHONY_Propagate(FX_MAHONY_t *Eng, const MEMS_FIXED_Axes_t *Gyro)
+{
+  int32_t *q = Eng->Q;
+  int32_t h[3];
+  int32_t n[4];
+  int32_t inv;
+  int64_t norm;
+
+  /* Half angle over the period, corrected */
+  h[0] = (int32_t)(((int64_t)Gyro->x * Eng->GyroK) >> 24) + Eng->Corr[0] + Eng->Bias[0];
+  h[1] = (int32_t)(((int64_t)Gyro->y * Eng->GyroK) >> 24) + Eng->Corr[1] + Eng->Bias[1];
+  h[2] = (int32_t)(((int64_t)Gyro->z * Eng->GyroK) >> 24) + Eng->Corr[2] + Eng->Bias[2];
+
+  /* q += q * (0, h), first order */
+  n[0] = q[0] - FX_MAHONY_Mul(q[1], h[0]) - FX_MAHONY_Mul(q[2], h[1]) - FX_MAHONY_Mul(q[3], h[2]);
+  n[1] = q[1] + FX_MAHONY_Mul(q[0], h[0]) + FX_MAHONY_Mul(q[2], h[2]) - FX_MAHONY_Mul(q[3], h[1]);
+  n[2] = q[2] + FX_MAHONY_Mul(q[0], h[1]) - FX_MAHONY_Mul(q[1], h[2]) + FX_MAHONY_Mul(q[3], h[0]);
+  n[3] = q[3] + FX_MAHONY_Mul(q[0], h[2]) + FX_MAHONY_Mul(q[1], h[1]) - FX_MAHONY_Mul(q[2], h[0]);
+
+  /* Back to unit norm: near 1, 1 / sqrt(x) is (3 - x) / 2 */
+  norm = ((int64_t)n[0] * n[0]) + ((int64_t)n[1] * n[1]) + ((int64_t)n[2] * n[2]) + ((int64_t)n[3] * n[3]);
+  inv = (int32_t)(((3LL * FX_MAHONY_ONE) - (norm >> 30)) / 2);
+
+  for (uint32_t i = 0; i < 4U; i++)
+  {
+    q[i] = FX_MAHONY_Mul(n[i], inv);
+  }
+}
+
+/**
+ * @brief  Correct the orientation with an accelerometer sample
+ * @note   A sample that is not gravity alone clears the correction
+ * @param  Eng the engine
+ * @param  Acc the acceleration [mg, Q23.8]
+ * @retval None
+ */
+void FX_MAHONY_Update(FX_MAHONY_t *Eng, const MEMS_FIXED_Axes_t *Acc)
+{
+  int32_t a[3];
+  int32_t v[3];
+  int32_t e[3];
+  int64_t sum;
+  int64_t norm;
+  int64_t inv;
+
+  sum = ((int64_t)Acc->x * Acc->x) + ((int64_t)Acc->y * Acc->y) + ((int64_t)Acc->z * Acc->z);
+  norm = (int64_t)FX_MAHONY_Sqrt((uint64_t)sum);
+  if ((norm == 0) || ((Eng->Aligned != 0U)
+                      && (((norm - (1000 * MEMS_FIXED_ONE)) > (FX_MAHONY_ACC_TOL * MEMS_FIXED_ONE))
+                          || (((1000 * MEMS_FIXED_ONE) - norm) > (FX_MAHONY_ACC_TOL * MEMS_FIXED_ONE)))))
+  {
+    Eng->Corr[0] = 0;
+    Eng->Corr[1] = 0;
+    Eng->Corr[2] = 0;
+    return;
+  }
+
+  /* Unit vector in Q30, each component is at most the norm */
+  inv = ((int64_t)1 << 46) / norm;
+  a[0] = (int32_t)((Acc->x * inv) >> 16);
+  a[1] = (int32_t)((Acc->y * inv) >> 16);
+  a[2] = (int32_t)((Acc->z * inv) >> 16);
+
+  if (Eng->Aligned == 0U)
+  {
+    FX_MAHONY_Align(Eng, a);
+    return;
+  }
+
+  /* Error is the measured direction cross the estimated one */
+  FX_MAHONY_Gravity(Eng->Q, v);
+  e[0] = FX_MAHONY_Mul(a[1], v[2]) - FX_MAHONY_Mul(a[2], v[1]);
+  e[1] = FX_MAHONY_Mul(a[2], v[0]) - FX_MAHONY_Mul(a[0], v[2]);
+  e[2] = FX_MAHONY_Mul(a[0], v[1]) - FX_MAHONY_Mul(a[1], v[0]);
+
+  for (uint32_t i = 0; i < 3U; i++)
+  {
+    Eng->Corr[i] = FX_MAHONY_Mul(e[i], Eng->KpK);
+    Eng->Bias[i] = FX_MAHONY_Clamp(Eng->Bias[i] + FX_MAHONY_Mul(e[i], Eng->KiK), Eng->BiasMax);
+  }
+}
+
+/**
+ * @brief  Tell whether an accelerometer sample is gravity alone
+ * @note   The test of FX_MAHONY_Update on the squared norm
+ * @param  Acc the acceleration [mg, Q23.8]
+ * @retval 1 if the norm is within 1 g +/- FX_MAHONY_ACC_TOL, 0 otherwise
+ */
+uint8_t FX_MAHONY_Quiet(const MEMS_FIXED_Axes_t *Acc)
+{
+  const int64_t low = (int64_t)(1000 - FX_MAHONY_ACC_TOL) * MEMS_FIXED_ONE;
+  const int64_t high = (int64_t)(1000 + FX_MAHONY_ACC_TOL) * MEMS_FIXED_ONE;
+  int64_t sum;
+
+  sum = ((int64_t)Acc->x * Acc->x) + ((int64_t)Acc->y * Acc->y) + ((int64_t)Acc->z * Acc->z);
+
+  return ((sum >= (low * low)) && (sum <= (high * high))) ? 1U : 0U;
+}
+
+/**
+ * @brief  Get the fusion outputs
+ * @param  Eng the engine
+ * @param  Acc the last acceleration [mg, Q23.8], for the linear acceleration
+ * @param  Outputs the FX_MAHONY_OUT_* to compute, the others are left as
+ *         they are
+ * @param  Out the outputs
+ * @retval None
+ */
+void FX_MAHONY_GetOutput(const FX_MAHONY_t *Eng, const MEMS_FIXED_Axes_t *Acc, uint32_t Outputs,
+                         FX_MAHONY_Output_t *Out)
+{
+  const int32_t *q = Eng->Q;
+  int32_t g[3];
+  int32_t s;
+  int32_t y;
+  int32_t x;
+
+  if ((Outputs & FX_MAHONY_OUT_QUAT) != 0U)
+  {
+    Out->Quat[0] = q[1];
+    Out->Quat[1] = q[2];
+    Out->Quat[2] = q[3];
+    Out->Quat[3] = q[0];
+  }
+
+  if ((Outputs & (FX_MAHONY_OUT_GRAV | FX_MAHONY_OUT_LINACC)) != 0U)
+  {
+    FX_MAHONY_Gravity(q, g);
+  }
+
+  if ((Outputs & FX_MAHONY_OUT_GRAV) != 0U)
+  {
+    Out->Gravity[0] = g[0];
+    Out->Gravity[1] = g[1];
+    Out->Gravity[2] = g[2];
+  }
+
+  if ((Outputs & FX_MAHONY_OUT_LINACC) != 0U)
+  {
+    /* 1 g is 1000 mg, in Q23.8 */
+    Out->LinAcc.x = Acc->x - (int32_t)(((int64_t)g[0] * (1000 * MEMS_FIXED_ONE)) >> 30);
+    Out->LinAcc.y = Acc->y - (int32_t)(((int64_t)g[1] * (1000 * MEMS_FIXED_ONE)) >> 30);
+    Out->LinAcc.z = Acc->z - (int32_t)(((int64_t)g[2] * (1000 * MEMS_FIXED_ONE)) >> 30);
+  }
+
+  if ((Outputs & FX_MAHONY_OUT_ROT) == 0U)
+  {
+    return;
+  }
+
+  /* Yaw */
+  y = 2 * (FX_MAHONY_Mul(q[0], q[3]) + FX_MAHONY_Mul(q[1], q[2]));
+  x = FX_MAHONY_ONE - (2 * (FX_MAHONY_Mul(q[2], q[2]) + FX_MAHONY_Mul(q[3], q[3])));
+  Out->Rot[0] = FX_MAHONY_Atan2(y, x);
+  if (Out->Rot[0] < 0)
+  {
+    Out->Rot[0] += 360000;
+  }
+
+  /* Pitch, asin(s) as atan2(s, sqrt(1 - s^2)) */
+  s = FX_MAHONY_Clamp(2 * (FX_MAHONY_Mul(q[0], q[2]) - FX_MAHONY_Mul(q[3], q[1])), FX_MAHONY_ONE);
+  x = (int32_t)FX_MAHONY_Sqrt(((uint64_t)1 << 60) - (uint64_t)((int64_t)s * s));
+  Out->Rot[1] = FX_MAHONY_Atan2(s, x);
+
+  /* Roll */
+  y = 2 * (FX_MAHONY_Mul(q[0], q[1]) + FX_MAHONY_Mul(q[2], q[3]));
+  x = FX_MAHONY_ONE - (2 * (FX_MAHONY_Mul(q[1], q[1]) + FX_MAHONY_Mul(q[2], q[2])));
+  Out->Rot[2] = FX_MAHONY_Atan2(y, x);
+}
+
+/**
+ * @brief  Four quadrant arctangent
+ * @param  Y the ordinate, any fixed point scale
+ * @param  X the abscissa, same scale, |X| and |Y| below 2^31
+ * @retval The angle [mdeg], in (-180000, 180000], 0 for (0, 0)
+ */
+int32_t FX_MAHONY_Atan2(int32_t Y, int32_t X)
+{
+  uint32_t ax = (X < 0) ? (uint32_t)(-(int64_t)X) : (uint32_t)X;
+  uint32_t ay = (Y < 0) ? (uint32_t)(-(int64_t)Y) : (uint32_t)Y;
+  uint32_t lo = (ax < ay) ? ax : ay;
+  uint32_t hi = (ax < ay) ? ay : ax;
+  int32_t r;
+  int32_t z;
+  int32_t p;
+  int32_t angle;
+
+  if (hi == 0U)
+  {
+    return 0;
+  }
+
+  /* atan of the ratio on [0, 1], then unfolded to the octant */
+  r = (int32_t)(((uint64_t)lo << 30) / hi);
+  z = FX_MAHONY_Mul(r, r);
+  p = FX_MAHONY_ATAN_A9;
+  p = FX_MAHONY_ATAN_A7 + FX_MAHONY_Mul(z, p);
+  p = FX_MAHONY_ATAN_A5 + FX_MAHONY_Mul(z, p);
+  p = FX_MAHONY_ATAN_A3 + FX_MAHONY_Mul(z, p);
+  p = FX_MAHONY_ATAN_A1 + FX_MAHONY_Mul(z, p);
+  angle = (int32_t)((((int64_t)FX_MAHONY_Mul(r, p) * FX_MAHONY_MDEG_Q16) + ((int64_t)1 << 45)) >> 46);
+
+  if (ay > ax)
+  {
+    angle = 90000 - angle;
+  }
+  if (X < 0)
+  {
+    angle = 180000 - angle;
+  }
+
+  return (Y < 0) ? -angle : angle;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief  Q30 product, rounded
+ * @param  A the first factor
+ * @param  B the second factor
+ * @retval A * B
+ */
+static int32_t FX_MAHONY_Mul(int32_t A, int32_t B)
+{
+  return (int32_t)((((int64_t)A * B) + ((int64_t)1 << 29)) >> 30);
+}
+
+/**
+ * @brief  Integer square root
+ * @param  Value the radicand
+ * @retval floor(sqrt(Value))
+ */
+static uint32_t FX_MAHONY_Sqrt(uint64_t Value)
+{
+  uint64_t root = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+
+  while (bit > Value)
+  {
+    bit >>= 2;
+  }
+
+  while (bit != 0U)
+  {
+    if (Value >= (root + bit))
+    {
+      Value -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+
+  return (uint32_t)root;
+}
+
+/**
+ * @brief  Limit a value to +/-Max
+ * @param  Value the value
+ * @param  Max the limit, positive
+ * @retval The limited value
+ */
+static int32_t FX_MAHONY_Clamp(int32_t Value, int32_t Max)
+{
+  if (Value > Max)
+  {
+    return Max;
+  }
+
+  return (Value < -Max) ? -Max : Value;
+}
+
+/**
+ * @brief  Gravity direction in the device frame
+ * @param  Q the orientation, Q30
+ * @param  V the unit gravity vector, Q30
+ * @retval None
+ */
+static void FX_MAHONY_Gravity(const int32_t Q[4], int32_t V[3])
+{
+  V[0] = 2 * (FX_MAHONY_Mul(Q[1], Q[3]) - FX_MAHONY_Mul(Q[0], Q[2]));
+  V[1] = 2 * (FX_MAHONY_Mul(Q[0], Q[1]) + FX_MAHONY_Mul(Q[2], Q[3]));
+  V[2] = FX_MAHONY_Mul(Q[0], Q[0]) - FX_MAHONY_Mul(Q[1], Q[1]) - FX_MAHONY_Mul(Q[2], Q[2])
+         + FX_MAHONY_Mul(Q[3], Q[3]);
+}
+
+/**
+ * @brief  Set the orientation that brings a gravity direction to up
+ * @note   The shortest rotation from A to (0, 0, 1): (1 + Az, Ay, -Ax, 0),
+ *         normalized, or half a turn about x when A points down.
+ * @param  Eng the engine
+ * @param  A the unit gravity vector, Q30
+ * @retval None
+ */
+static void FX_MAHONY_Align(FX_MAHONY_t *Eng, const int32_t A[3])
+{
+  int64_t w = (int64_t)FX_MAHONY_ONE + A[2];
+  int64_t norm2 = (w * w) + ((int64_t)A[0] * A[0]) + ((int64_t)A[1] * A[1]);
+  int64_t norm = (int64_t)FX_MAHONY_Sqrt((uint64_t)norm2);
+
+  if (norm < (FX_MAHONY_ONE / 1024))
+  {
+    Eng->Q[0] = 0;
+    Eng->Q[1] = FX_MAHONY_ONE;
+    Eng->Q[2] = 0;
+    Eng->Q[3] = 0;
+  }
+  else
+  {
+    Eng->Q[0] = (int32_t)((w << 30) / norm);
+    Eng->Q[1] = (int32_t)(((int64_t)A[1] << 30) / norm);
+    Eng->Q[2] = (int32_t)((-(int64_t)A[0] << 30) / norm);
+    Eng->Q[3] = 0;
+  }
+
+  Eng->Aligned = 1;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
@@ -0,0 +1,145 @@
+/**
+  ******************************************************************************
+  * @file    fx_mahony.h
+  * @author  ISCA Lab
+  * @brief   Fixed-point 6 axes Mahony fusion, in-tree alternative to MotionFX
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef FX_MAHONY_H
+#define FX_MAHONY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "mems_fixed.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup FX_MAHONY FX MAHONY
+ * @{
+ */
+
+/*
+ * Mahony complementary filter on the accelerometer and gyroscope, integer
+ * only: the CM4 of the STM32WL has no FPU. The orientation is a unit
+ * quaternion in Q30 rotating the device frame to the ENU frame.
+ *
+ * FX_MAHONY_Propagate turns the gyroscope sample (MEMS_FIXED Q23.8 mdps)
+ * into a rotation over one period, adds the accelerometer correction and
+ * the gyroscope bias estimate, and renormalizes the quaternion.
+ * FX_MAHONY_Update compares the measured gravity direction with the one of
+ * the quaternion: Kp times the error is the correction applied on the next
+ * propagates, Ki times its integral the bias estimate. The correction holds
+ * until the next update, so the update may run at a lower rate (fx_rate.h).
+ * The first update aligns the quaternion on the measured gravity. A sample
+ * whose norm is off 1 g by more than FX_MAHONY_ACC_TOL is not gravity alone:
+ * it clears the correction and leaves the bias estimate. FX_MAHONY_Quiet
+ * applies the same test, without a square root, to hold a due update.
+ *
+ * FX_MAHONY_GetOutput only computes the outputs it is asked for: the
+ * angles take three arctangents and a square root.
+ *
+ * Angles are in millidegrees: yaw in [0, 360000), pitch in [-90000, 90000],
+ * roll in (-180000, 180000], Z-Y-X order. Without a magnetometer the yaw is
+ * relative to the start.
+ *
+ * The module has no hardware dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define FX_MAHONY_OK      0
+#define FX_MAHONY_ERROR  -1
+
+#define FX_MAHONY_ONE  ((int32_t)1 << 30)  /* 1.0 in Q30 */
+
+/* Longest sample period, the rotation over one period stays in Q30 */
+#define FX_MAHONY_MAX_PERIOD_US  100000U
+
+/* Default gains [1/s, Q16] */
+#ifndef FX_MAHONY_KP
+#define FX_MAHONY_KP  32768U  /* 0.5 */
+#endif
+
+#ifndef FX_MAHONY_KI
+#define FX_MAHONY_KI  1311U   /* 0.02 */
+#endif
+
+/* Accelerometer samples off 1 g by more than this are not used [mg] */
+#ifndef FX_MAHONY_ACC_TOL
+#define FX_MAHONY_ACC_TOL  100
+#endif
+
+/* Outputs of FX_MAHONY_GetOutput */
+#define FX_MAHONY_OUT_QUAT    0x01U
+#define FX_MAHONY_OUT_ROT     0x02U
+#define FX_MAHONY_OUT_GRAV    0x04U
+#define FX_MAHONY_OUT_LINACC  0x08U
+#define FX_MAHONY_OUT_ALL     0x0FU
+
+/* Largest gyroscope bias estimate [mdps] */
+#ifndef FX_MAHONY_BIAS_MAX
+#define FX_MAHONY_BIAS_MAX  20000
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  int32_t Q[4];       /* w, x, y, z, Q30 */
+  int32_t Corr[3];    /* Accelerometer correction, half angle per period, Q30 */
+  int32_t Bias[3];    /* Gyroscope bias estimate, half angle per period, Q30 */
+  int32_t BiasMax;
+  uint32_t GyroK;     /* Q23.8 mdps to half angle per period, Q24 */
+  int32_t KpK;        /* Kp * period / 2, Q30 */
+  int32_t KiK;        /* Ki * period^2 / 2, Q30 */
+  uint32_t PeriodUs;
+  uint32_t Kp;        /* [1/s, Q16] */
+  uint32_t Ki;        /* [1/s, Q16] */
+  uint8_t Aligned;
+} FX_MAHONY_t;
+
+typedef struct
+{
+  int32_t Quat[4];           /* x, y, z, w, Q30, the MotionFX order */
+  int32_t Rot[3];            /* yaw, pitch, roll [mdeg] */
+  int32_t Gravity[3];        /* Device frame gravity [g, Q30] */
+  MEMS_FIXED_Axes_t LinAcc;  /* Device frame linear acceleration [mg, Q23.8] */
+} FX_MAHONY_Output_t;
+
+/* Exported functions --------------------------------------------------------*/
+int32_t FX_MAHONY_Init(FX_MAHONY_t *Eng, uint32_t PeriodUs, uint32_t Kp, uint32_t Ki);
+int32_t FX_MAHONY_SetPeriod(FX_MAHONY_t *Eng, uint32_t PeriodUs);
+void FX_MAHONY_Reset(FX_MAHONY_t *Eng);
+void FX_MAHONY_Propagate(FX_MAHONY_t *Eng, const MEMS_FIXED_Axes_t *Gyro);
+void FX_MAHONY_Update(FX_MAHONY_t *Eng, const MEMS_FIXED_Axes_t *Acc);
+uint8_t FX_MAHONY_Quiet(const MEMS_FIXED_Axes_t *Acc);
+void FX_MAHONY_GetOutput(const FX_MAHONY_t *Eng, const MEMS_FIXED_Axes_t *Acc, uint32_t Outputs,
+                         FX_MAHONY_Output_t *Out);
+int32_t FX_MAHONY_Atan2(int32_t Y, int32_t X);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FX_MAHONY_H */
@@ -0,0 +1,116 @@
+/**
+  ******************************************************************************
+  * @file    fx_rate.c
+  * @author  ISCA Lab
+  * @brief   Split-rate fusion: propagate every sample, update at a lower rate
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "fx_rate.h"
+#include "mem_placement.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup FX_RATE FX RATE
+ * @{
+ */
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief  Initialize the rate scheduler
+ * @param  Rate the scheduler
+ * @param  Ops the fusion steps
+ * @param  Ctx passed to the steps
+ * @param  Div propagates per update, 1 to FX_RATE_MAX_DIV
+ * @param  MaxDefer samples an update may be held while moving
+ * @retval FX_RATE_OK in case of success, FX_RATE_ERROR otherwise
+ */
+int32_t FX_RATE_Init(FX_RATE_t *Rate, const FX_RATE_Ops_t *Ops, void *Ctx, uint32_t Div, uint32_t MaxDefer)
+{
+  if ((Rate == NULL) || (Ops == NULL) || (Ops->Propagate == NULL) || (Ops->Update == NULL)
+      || (Div == 0U) || (Div > FX_RATE_MAX_DIV))
+  {
+    return FX_RATE_ERROR;
+  }
+
+  Rate->Ops = Ops;
+  Rate->Ctx = Ctx;
+  Rate->Div = Div;
+  Rate->MaxDefer = MaxDefer;
+  Rate->Count = 0;
+  Rate->Updates = 0;
+  Rate->Deferred = 0;
+
+  return FX_RATE_OK;
+}
+
+/**
+ * @brief  Run the fusion on a sample
+ * @param  Rate the scheduler
+ * @param  In the sample
+ * @param  Out the fusion outputs
+ * @param  Dt the time since the previous sample [s]
+ * @param  Quiet 1 if the sample is fit for the correction, see FX_RATE_Quiet
+ * @retval 1 if the update ran, 0 otherwise
+ */
+RAM_FUNC uint8_t FX_RATE_Step(FX_RATE_t *Rate, void *In, void *Out, float Dt, uint8_t Quiet)
+{
+  Rate->Ops->Propagate(Rate->Ctx, In, Out, Dt);
+  Rate->Count++;
+
+  if (Rate->Count < Rate->Div)
+  {
+    return 0;
+  }
+
+  if ((Quiet == 0U) && ((Rate->Count - Rate->Div) < Rate->MaxDefer))
+  {
+    Rate->Deferred++;
+    return 0;
+  }
+
+  Rate->Ops->Update(Rate->Ctx, In, Out, Dt);
+  Rate->Count = 0;
+  Rate->Updates++;
+
+  return 1;
+}
+
+/**
+ * @brief  Tell whether the acceleration is gravity alone
+ * @param  Acc the acceleration [g]
+ * @param  Tol the tolerance on its norm [g]
+ * @retval 1 if the norm is within 1 g +/- Tol, 0 otherwise
+ */
+RAM_FUNC uint8_t FX_RATE_Quiet(const float Acc[3], float Tol)
+{
+  float norm2 = (Acc[0] * Acc[0]) + (Acc[1] * Acc[1]) + (Acc[2] * Acc[2]);
+  float low = 1.0f - Tol;
+  float high = 1.0f + Tol;
+
+  if (low < 0.0f)
+  {
+    low = 0.0f;
+  }
+
+  return ((norm2 >= (low * low)) && (norm2 <= (high * high))) ? 1U : 0U;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
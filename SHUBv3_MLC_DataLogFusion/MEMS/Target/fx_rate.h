@@ -0,0 +1,93 @@
+/**
+  ******************************************************************************
+  * @file    fx_rate.h
+  * @author  ISCA Lab
+  * @brief   Split-rate fusion: propagate every sample, update at a lower rate
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef FX_RATE_H
+#define FX_RATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup FX_RATE FX RATE
+ * @{
+ */
+
+/*
+ * The fusion has two steps: the propagate integrates the gyroscope, the
+ * update corrects the orientation with the accelerometer and magnetometer
+ * and costs most of the run. The propagate runs on every sample; the update
+ * runs once every Div samples, the decimation the library is given in its
+ * modx knob. Both take the time between two propagates.
+ *
+ * An update that falls due while the device moves (Quiet is 0: the
+ * acceleration is not gravity alone) is held, up to MaxDefer more samples,
+ * so that the correction uses a still sample.
+ *
+ * The steps are called through FX_RATE_Ops_t: a host test runs the
+ * scheduler with a mock. The module has no hardware dependency and builds
+ * on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define FX_RATE_OK      0
+#define FX_RATE_ERROR  -1
+
+/* Largest update divider, modx is 8 bits */
+#define FX_RATE_MAX_DIV  255U
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  void (*Propagate)(void *Ctx, void *In, void *Out, float Dt);
+  void (*Update)(void *Ctx, void *In, void *Out, float Dt);
+} FX_RATE_Ops_t;
+
+typedef struct
+{
+  const FX_RATE_Ops_t *Ops;
+  void *Ctx;
+  uint32_t Div;       /* Propagates per update */
+  uint32_t MaxDefer;  /* Samples an update may be held while moving */
+  uint32_t Count;     /* Propagates since the last update */
+  uint32_t Updates;
+  uint32_t Deferred;  /* Samples an update was held */
+} FX_RATE_t;
+
+/* Exported functions --------------------------------------------------------*/
+int32_t FX_RATE_Init(FX_RATE_t *Rate, const FX_RATE_Ops_t *Ops, void *Ctx, uint32_t Div, uint32_t MaxDefer);
+uint8_t FX_RATE_Step(FX_RATE_t *Rate, void *In, void *Out, float Dt, uint8_t Quiet);
+uint8_t FX_RATE_Quiet(const float Acc[3], float Tol);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FX_RATE_H */
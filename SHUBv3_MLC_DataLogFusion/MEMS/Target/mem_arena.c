@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file    mem_arena.c
+  * @author  ISCA Lab
+  * @brief   Bump allocator over a statically sized memory pool
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "mem_arena.h"
+
+/* Exported functions --------------------------------------------------------*/
+/**
+  * @brief  Initialize an arena over a memory pool
+  * @param  Arena the arena
+  * @param  Base the pool start, aligned on MEM_ARENA_ALIGNMENT
+  * @param  Size the pool size in bytes
+  * @retval None
+  */
+void MEM_ARENA_Init(MEM_ARENA_t *Arena, void *Base, uint32_t Size)
+{
+  Arena->Base = (uint8_t *)Base;
+  Arena->Size = Size;
+  Arena->Used = 0;
+  Arena->Failed = 0;
+}
+
+/**
+  * @brief  Take a block from the arena
+  * @param  Arena the arena
+  * @param  Size the block size in bytes
+  * @retval Pointer to the block, NULL if the arena is exhausted
+  */
+void *MEM_ARENA_Alloc(MEM_ARENA_t *Arena, uint32_t Size)
+{
+  uint32_t rounded = MEM_ARENA_ROUND(Size);
+  void *block;
+
+  if ((Size == 0U) || (rounded < Size) || (rounded > (Arena->Size - Arena->Used)))
+  {
+    Arena->Failed++;
+    return NULL;
+  }
+
+  block = &Arena->Base[Arena->Used];
+  Arena->Used += rounded;
+
+  return block;
+}
+
+/**
+  * @brief  Get the number of bytes still available
+  * @param  Arena the arena
+  * @retval Available bytes
+  */
+uint32_t MEM_ARENA_Available(const MEM_ARENA_t *Arena)
+{
+  return Arena->Size - Arena->Used;
+}
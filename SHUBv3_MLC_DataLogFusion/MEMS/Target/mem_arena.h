@@ -0,0 +1,61 @@
+/**
+  ******************************************************************************
+  * @file    mem_arena.h
+  * @author  ISCA Lab
+  * @brief   Bump allocator over a statically sized memory pool
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef MEM_ARENA_H
+#define MEM_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported defines ----------------------------------------------------------*/
+/* Every block starts on this boundary, enough for any type and for DMA */
+#define MEM_ARENA_ALIGNMENT   8U
+
+/* Exported macro ------------------------------------------------------------*/
+/* Size actually taken from the pool by a request of Size bytes */
+#define MEM_ARENA_ROUND(Size) \
+  (((uint32_t)(Size) + (MEM_ARENA_ALIGNMENT - 1U)) & ~(MEM_ARENA_ALIGNMENT - 1U))
+
+/* Static initializer for an arena over an array */
+#define MEM_ARENA_INITIALIZER(Pool)  { (uint8_t *)(Pool), (uint32_t)sizeof(Pool), 0U, 0U }
+
+/* Exported types ------------------------------------------------------------*/
+/*
+ * Blocks are handed out once at initialization and never released, so the
+ * layout only depends on the allocation order and sizes.
+ */
+typedef struct
+{
+  uint8_t *Base;
+  uint32_t Size;
+  uint32_t Used;
+  uint32_t Failed; /* Requests that did not fit */
+} MEM_ARENA_t;
+
+/* Exported functions --------------------------------------------------------*/
+void MEM_ARENA_Init(MEM_ARENA_t *Arena, void *Base, uint32_t Size);
+void *MEM_ARENA_Alloc(MEM_ARENA_t *Arena, uint32_t Size);
+uint32_t MEM_ARENA_Available(const MEM_ARENA_t *Arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEM_ARENA_H */
@@ -0,0 +1,128 @@
+/**
+  ******************************************************************************
+  * @file    mems_fixed.c
+  * @author  ISCA Lab
+  * @brief   Fixed-point sample scaling for the LSM6DSOX
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mems_fixed.h"
+#include "mem_placement.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup MEMS_FIXED MEMS FIXED
+ * @{
+ */
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  int32_t FullScale;
+  uint32_t Sensitivity; /* milli-unit/LSB, Q16 */
+} MEMS_FIXED_Sens_t;
+
+/* Private variables ---------------------------------------------------------*/
+/* LSM6DSOX_ACC_SENSITIVITY_FS_xG [mg/LSB] * 65536, rounded */
+static const MEMS_FIXED_Sens_t AccSensTable[] =
+{
+  {  2,  3998U }, /* 0.061 mg/LSB */
+  {  4,  7995U }, /* 0.122 mg/LSB */
+  {  8, 15991U }, /* 0.244 mg/LSB */
+  { 16, 31982U }, /* 0.488 mg/LSB */
+};
+
+/* LSM6DSOX_GYRO_SENSITIVITY_FS_xDPS [mdps/LSB] * 65536, exact */
+static const MEMS_FIXED_Sens_t GyroSensTable[] =
+{
+  {  125,  286720U }, /*  4.375 mdps/LSB */
+  {  250,  573440U }, /*  8.750 mdps/LSB */
+  {  500, 1146880U }, /* 17.500 mdps/LSB */
+  { 1000, 2293760U }, /* 35.000 mdps/LSB */
+  { 2000, 4587520U }, /* 70.000 mdps/LSB */
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static int32_t Lookup(const MEMS_FIXED_Sens_t *Table, uint32_t Size, int32_t FullScale, uint32_t *Sensitivity);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief  Get the accelerometer sensitivity for a given full scale
+ * @param  FullScale the full scale in g, as returned by GetFullScale
+ * @param  Sensitivity the sensitivity in mg/LSB, Q16
+ * @retval MEMS_FIXED_OK in case of success, MEMS_FIXED_ERROR otherwise
+ */
+int32_t MEMS_FIXED_AccSensitivity(int32_t FullScale, uint32_t *Sensitivity)
+{
+  return Lookup(AccSensTable, sizeof(AccSensTable) / sizeof(AccSensTable[0]), FullScale, Sensitivity);
+}
+
+/**
+ * @brief  Get the gyroscope sensitivity for a given full scale
+ * @param  FullScale the full scale in dps, as returned by GetFullScale
+ * @param  Sensitivity the sensitivity in mdps/LSB, Q16
+ * @retval MEMS_FIXED_OK in case of success, MEMS_FIXED_ERROR otherwise
+ */
+int32_t MEMS_FIXED_GyroSensitivity(int32_t FullScale, uint32_t *Sensitivity)
+{
+  return Lookup(GyroSensTable, sizeof(GyroSensTable) / sizeof(GyroSensTable[0]), FullScale, Sensitivity);
+}
+
+/**
+ * @brief  Scale a raw 3-axis sample to milli-units in Q23.8
+ * @param  x the raw X axis value
+ * @param  y the raw Y axis value
+ * @param  z the raw Z axis value
+ * @param  Sensitivity the sensitivity in milli-unit/LSB, Q16
+ * @param  Axes the scaled output
+ * @retval None
+ */
+RAM_FUNC void MEMS_FIXED_Scale(int16_t x, int16_t y, int16_t z, uint32_t Sensitivity, MEMS_FIXED_Axes_t *Axes)
+{
+  Axes->x = MEMS_FIXED_ScaleOne(x, Sensitivity);
+  Axes->y = MEMS_FIXED_ScaleOne(y, Sensitivity);
+  Axes->z = MEMS_FIXED_ScaleOne(z, Sensitivity);
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief  Find the sensitivity matching a full scale
+ * @param  Table the sensitivity table
+ * @param  Size the number of table entries
+ * @param  FullScale the full scale to look up
+ * @param  Sensitivity the matching sensitivity
+ * @retval MEMS_FIXED_OK in case of success, MEMS_FIXED_ERROR otherwise
+ */
+static int32_t Lookup(const MEMS_FIXED_Sens_t *Table, uint32_t Size, int32_t FullScale, uint32_t *Sensitivity)
+{
+  uint32_t i;
+
+  for (i = 0; i < Size; i++)
+  {
+    if (Table[i].FullScale == FullScale)
+    {
+      *Sensitivity = Table[i].Sensitivity;
+      return MEMS_FIXED_OK;
+    }
+  }
+
+  return MEMS_FIXED_ERROR;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
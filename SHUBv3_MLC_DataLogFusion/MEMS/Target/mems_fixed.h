@@ -0,0 +1,122 @@
+/**
+  ******************************************************************************
+  * @file    mems_fixed.h
+  * @author  ISCA Lab
+  * @brief   Fixed-point sample types and LSM6DSOX scaling tables
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef MEMS_FIXED_H
+#define MEMS_FIXED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup MEMS_FIXED MEMS FIXED
+ * @{
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+/*
+ * Samples are carried as milli-units (mg, mdps) with MEMS_FIXED_FRAC_BITS
+ * fractional bits, i.e. Q23.8. At +/-16 g and +/-2000 dps the largest value
+ * is about 2^29, so every intermediate fits in an int32_t and the whole
+ * path from the raw register read to the serialized frame is integer only.
+ */
+#define MEMS_FIXED_FRAC_BITS        8
+#define MEMS_FIXED_ONE              ((int32_t)1 << MEMS_FIXED_FRAC_BITS)
+
+/* Sensitivities are stored as milli-unit per LSB in Q16 */
+#define MEMS_FIXED_SENS_FRAC_BITS   16
+
+#define MEMS_FIXED_OK               0
+#define MEMS_FIXED_ERROR           -1
+
+/* Exported types ------------------------------------------------------------*/
+typedef int32_t mems_q8_t;
+
+typedef struct
+{
+  mems_q8_t x;
+  mems_q8_t y;
+  mems_q8_t z;
+} MEMS_FIXED_Axes_t;
+
+/* Exported functions --------------------------------------------------------*/
+int32_t MEMS_FIXED_AccSensitivity(int32_t FullScale, uint32_t *Sensitivity);
+int32_t MEMS_FIXED_GyroSensitivity(int32_t FullScale, uint32_t *Sensitivity);
+void MEMS_FIXED_Scale(int16_t x, int16_t y, int16_t z, uint32_t Sensitivity, MEMS_FIXED_Axes_t *Axes);
+
+/**
+ * @brief  Convert a raw sample to milli-units in Q23.8
+ * @param  Raw the raw register value
+ * @param  Sensitivity the sensitivity in milli-unit/LSB, Q16
+ * @retval Scaled value
+ */
+static inline mems_q8_t MEMS_FIXED_ScaleOne(int16_t Raw, uint32_t Sensitivity)
+{
+  /* 32x32->64 multiply is a single SMULL on the Cortex-M4 */
+  return (mems_q8_t)(((int64_t)Raw * (int64_t)Sensitivity)
+                     >> (MEMS_FIXED_SENS_FRAC_BITS - MEMS_FIXED_FRAC_BITS));
+}
+
+/**
+ * @brief  Round a Q23.8 value to integer milli-units (mg, mdps) for serialization
+ * @param  Value the fixed-point value
+ * @retval Rounded milli-units
+ */
+static inline int32_t MEMS_FIXED_ToMilli(mems_q8_t Value)
+{
+  return (Value + (MEMS_FIXED_ONE / 2)) >> MEMS_FIXED_FRAC_BITS;
+}
+
+/**
+ * @brief  Convert integer milli-units (mg, mdps) to Q23.8
+ * @param  Value the milli-units value
+ * @retval Fixed-point value
+ */
+static inline mems_q8_t MEMS_FIXED_FromMilli(int32_t Value)
+{
+  return (mems_q8_t)(Value * MEMS_FIXED_ONE);
+}
+
+/**
+ * @brief  Convert a Q23.8 milli-units value to float units (g, dps)
+ * @note   Only meant for library boundaries that take float (MotionFX input)
+ * @param  Value the fixed-point value
+ * @retval Value in g or dps
+ */
+static inline float MEMS_FIXED_ToUnit(mems_q8_t Value)
+{
+  return (float)Value * (1.0f / (1000.0f * (float)MEMS_FIXED_ONE));
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEMS_FIXED_H */
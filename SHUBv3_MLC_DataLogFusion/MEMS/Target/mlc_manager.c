@@ -0,0 +1,456 @@
+/**
+  ******************************************************************************
+  * @file    mlc_manager.c
+  * @author  ISCA Lab
+  * @brief   Runs the LSM6DSOX Machine Learning Core next to the data stream
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "mlc_manager.h"
+#include "main.h"
+#include "bsp_ip_conf.h"
+#include "custom_mems_conf_app.h"
+#include "custom_motion_sensors_ex.h"
+#include "stm32wlxx_nucleo_bus.h"
+#include "task_sched.h"
+#include "falling.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup DATALOG_FUSION DATALOG FUSION
+ * @{
+ */
+
+/*
+ * The MLC program (falling.h, generated by Unico) is loaded on top of the
+ * configuration made by the DataLogFusion sensor init. Both share the same
+ * driver instance and the same I2C2 bus functions. The MLC decision is
+ * latched on INT1 until read. EXTI line 0 is already taken by the user
+ * button on PA0, so the task samples the INT1 level instead of taking an
+ * interrupt. The bus is only accessed when INT1 is asserted.
+ *
+ * Every access to the embedded functions page holds the I2C2 arbiter from
+ * the page switch to the switch back, so no other client can hit the wrong
+ * register page in between.
+ *
+ * The program is not left to set the sensors alone. What it needs is read
+ * from the UCF (MLC rate, sensors on, power modes), the other consumers
+ * pass theirs, and sensor_plan picks the lowest power configuration
+ * meeting all of them. The plan is written right after the program, in
+ * the same bus hold, with the sensors off while the power modes change.
+ */
+
+/* Private defines -----------------------------------------------------------*/
+#define MLC_INSTANCE          CUSTOM_ACC_INSTANCE_0
+#define MLC_DEADLINE          9U  /* INT1 read [ms], done before the next decision at 104 Hz */
+#define MLC_MAX_NEEDS         4U  /* Consumers planned, the MLC program included */
+
+#define FUNC_CFG_ACCESS_EMB   0x80U /* FUNC_CFG_ACCESS: embedded functions page */
+#define FUNC_CFG_ACCESS_MAIN  0x00U
+#define FUNC_CFG_ACCESS_PAGE  0xC0U /* Embedded functions or sensor hub page */
+#define PAGE_RW_EMB_FUNC_LIR  0x80U /* PAGE_RW: latch embedded function interrupts */
+#define MLC_STATUS_IS_MLC1    0x01U
+#define EMB_FUNC_EN_B_MLC     0x10U
+
+#define ODR_SHIFT             4U    /* CTRL1_XL, CTRL2_G: ODR in bits [7:4] */
+#define ODR_MASK              0xF0U
+#define MLC_ODR_SHIFT         4U    /* EMB_FUNC_ODR_CFG_C: MLC_ODR in bits [5:4] */
+#define MLC_ODR_MASK          0x30U
+#define CTRL5_C_XL_ULP_EN     0x80U
+#define CTRL6_C_XL_HM_MODE    0x10U /* Set: accelerometer high-performance off */
+#define CTRL7_G_G_HM_MODE     0x80U /* Set: gyroscope high-performance off */
+#define REG_WRITE             0xFFU /* Mask of a plain write */
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t MlcRunning = 0;
+static MLC_output_t MlcOutput;
+static uint32_t MlcTaskId;
+static SENSOR_PLAN_t MlcPlan;
+
+/* MLC rates [0.1 Hz] by EMB_FUNC_ODR_CFG_C MLC_ODR value */
+static const uint32_t MlcRates[(MLC_ODR_MASK >> MLC_ODR_SHIFT) + 1U] = { 125U, 260U, 520U, 1040U };
+
+/* Register values of the sensor_plan rate ladder, 1.6 Hz is accelerometer
+ * only and the MLC runs from 12.5 Hz to 104 Hz */
+static const uint8_t PlanXlOdr[SENSOR_PLAN_RATES] =
+{
+  LSM6DSOX_XL_ODR_OFF, LSM6DSOX_XL_ODR_1Hz6, LSM6DSOX_XL_ODR_12Hz5, LSM6DSOX_XL_ODR_26Hz,
+  LSM6DSOX_XL_ODR_52Hz, LSM6DSOX_XL_ODR_104Hz, LSM6DSOX_XL_ODR_208Hz, LSM6DSOX_XL_ODR_417Hz,
+  LSM6DSOX_XL_ODR_833Hz, LSM6DSOX_XL_ODR_1667Hz, LSM6DSOX_XL_ODR_3333Hz, LSM6DSOX_XL_ODR_6667Hz
+};
+static const uint8_t PlanGyOdr[SENSOR_PLAN_RATES] =
+{
+  LSM6DSOX_GY_ODR_OFF, LSM6DSOX_GY_ODR_OFF, LSM6DSOX_GY_ODR_12Hz5, LSM6DSOX_GY_ODR_26Hz,
+  LSM6DSOX_GY_ODR_52Hz, LSM6DSOX_GY_ODR_104Hz, LSM6DSOX_GY_ODR_208Hz, LSM6DSOX_GY_ODR_417Hz,
+  LSM6DSOX_GY_ODR_833Hz, LSM6DSOX_GY_ODR_1667Hz, LSM6DSOX_GY_ODR_3333Hz, LSM6DSOX_GY_ODR_6667Hz
+};
+static const uint8_t PlanMlcOdr[SENSOR_PLAN_RATES] =
+{
+  LSM6DSOX_ODR_PRGS_12Hz5, LSM6DSOX_ODR_PRGS_12Hz5, LSM6DSOX_ODR_PRGS_12Hz5, LSM6DSOX_ODR_PRGS_26Hz,
+  LSM6DSOX_ODR_PRGS_52Hz, LSM6DSOX_ODR_PRGS_104Hz, LSM6DSOX_ODR_PRGS_104Hz, LSM6DSOX_ODR_PRGS_104Hz,
+  LSM6DSOX_ODR_PRGS_104Hz, LSM6DSOX_ODR_PRGS_104Hz, LSM6DSOX_ODR_PRGS_104Hz, LSM6DSOX_ODR_PRGS_104Hz
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void MLC_Task(uint32_t Events);
+static int32_t MLC_Read_Emb(uint8_t Reg, uint8_t *Data);
+static void MLC_Ucf_Needs(SENSOR_PLAN_Req_t *Need);
+static int32_t MLC_Apply_Plan(const SENSOR_PLAN_t *Plan);
+
+/* The timer period follows the MLC rate of the program */
+static const TASK_SCHED_Def_t MlcTaskDef =
+{
+  "mlc", MLC_Task, TASK_SCHED_PRIO_NORMAL, 0U, MLC_DEADLINE
+};
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief  Plan the sensors, load the MLC program and start watching its
+ *         output
+ * @note   To be called after the sensors are initialized. The program sets
+ *         the accelerometer and gyroscope full scales, the decision tree was
+ *         trained at them, they are kept and the stream sensitivities follow
+ *         them. The rates and power modes are those of the plan.
+ * @param  Needs what the other consumers need of the sensors
+ * @param  Count the number of consumers, up to MLC_MAX_NEEDS - 1
+ * @retval None
+ */
+void MLC_manager_init(const SENSOR_PLAN_Req_t *Needs, uint32_t Count)
+{
+  SENSOR_PLAN_Req_t needs[MLC_MAX_NEEDS] = {0};
+  uint32_t i;
+  int32_t ret = BSP_ERROR_NONE;
+  int32_t fullscale = 0;
+
+  if (Count >= MLC_MAX_NEEDS)
+  {
+    Error_Handler();
+  }
+
+  MLC_Ucf_Needs(&needs[0]);
+  for (i = 0; i < Count; i++)
+  {
+    needs[i + 1U] = Needs[i];
+  }
+  /* A program that does not run the MLC has nothing to watch */
+  if ((SENSOR_PLAN_Solve(needs, Count + 1U, &MlcPlan) != SENSOR_PLAN_OK)
+      || (MlcPlan.MlcRate == SENSOR_PLAN_RATE_OFF))
+  {
+    Error_Handler();
+  }
+
+  /* The driver keeps the planned rates and takes the sensors as enabled,
+   * the plan then writes the actual configuration */
+  BSP_SENSOR_ACC_SetOutputDataRate((float)SENSOR_PLAN_RateOf(MlcPlan.AccRate) / 10.0f);
+  BSP_SENSOR_ACC_Enable();
+  if (MlcPlan.GyrRate != SENSOR_PLAN_RATE_OFF)
+  {
+    BSP_SENSOR_GYR_SetOutputDataRate((float)SENSOR_PLAN_RateOf(MlcPlan.GyrRate) / 10.0f);
+    BSP_SENSOR_GYR_Enable();
+  }
+
+  /* The program switches register pages, load it and the plan as one bus
+   * sequence */
+  if (BSP_I2C2_Acquire(BUS_I2C2_CLIENT_MLC) != BSP_ERROR_NONE)
+  {
+    Error_Handler();
+  }
+
+  for (i = 0; (i < (sizeof(falling) / sizeof(ucf_line_t))) && (ret == BSP_ERROR_NONE); i++)
+  {
+    ret = CUSTOM_MOTION_SENSOR_Write_Register(MLC_INSTANCE, falling[i].address, falling[i].data);
+  }
+
+  if (ret == BSP_ERROR_NONE)
+  {
+    ret = MLC_Apply_Plan(&MlcPlan);
+  }
+
+  BSP_I2C2_Release();
+
+  if (ret != BSP_ERROR_NONE)
+  {
+    Error_Handler();
+  }
+
+  /* Setting back the full scales read from the sensor refreshes the
+   * sensitivities of the fixed-point reads */
+  BSP_SENSOR_ACC_GetFullScale(&fullscale);
+  BSP_SENSOR_ACC_SetFullScale(fullscale);
+  BSP_SENSOR_GYR_GetFullScale(&fullscale);
+  BSP_SENSOR_GYR_SetFullScale(fullscale);
+
+  MlcOutput.Code = 0;
+  MlcOutput.Events = 0;
+  MlcRunning = 1;
+
+  if (TASK_SCHED_Register(&MlcTaskDef, &MlcTaskId) != TASK_SCHED_OK)
+  {
+    Error_Handler();
+  }
+
+  /* One INT1 sample per MLC decision. A decision is latched until read, a
+   * period rounded down never lets two of them merge. */
+  TASK_SCHED_SetTimer(MlcTaskId, 10000U / SENSOR_PLAN_RateOf(MlcPlan.MlcRate),
+                      10000U / SENSOR_PLAN_RateOf(MlcPlan.MlcRate));
+}
+
+/**
+ * @brief  Check if the MLC program is loaded
+ * @note   While it runs the accelerometer and gyroscope must stay enabled.
+ * @param  None
+ * @retval 1 if running, 0 otherwise
+ */
+uint8_t MLC_manager_is_running(void)
+{
+  return MlcRunning;
+}
+
+/**
+ * @brief  Get the last MLC output
+ * @param  data_out the MLC output
+ * @retval None
+ */
+void MLC_manager_get_output(MLC_output_t *data_out)
+{
+  *data_out = MlcOutput;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief  MLC task, reads the decision tree output when INT1 is asserted
+ * @param  Events the scheduler events
+ * @retval None
+ */
+static void MLC_Task(uint32_t Events)
+{
+  uint8_t status;
+  uint8_t code;
+
+  (void)Events;
+
+  if (HAL_GPIO_ReadPin(BSP_IP_MEMS_INT1_GPIOX, BSP_IP_MEMS_INT1_PIN_NUM) != GPIO_PIN_SET)
+  {
+    return;
+  }
+
+  /* Reading MLC_STATUS releases the latched interrupt */
+  if (MLC_Read_Emb(LSM6DSOX_MLC_STATUS, &status) != BSP_ERROR_NONE)
+  {
+    return;
+  }
+
+  if ((status & MLC_STATUS_IS_MLC1) != 0U)
+  {
+    if (MLC_Read_Emb(LSM6DSOX_MLC0_SRC, &code) == BSP_ERROR_NONE)
+    {
+      MlcOutput.Code = code;
+      MlcOutput.Events++;
+    }
+  }
+}
+
+/**
+ * @brief  Read a register of the embedded functions page
+ * @param  Reg the register address
+ * @param  Data the register value
+ * @retval BSP_ERROR_NONE in case of success, an error code otherwise
+ */
+static int32_t MLC_Read_Emb(uint8_t Reg, uint8_t *Data)
+{
+  int32_t ret;
+
+  ret = BSP_I2C2_Acquire(BUS_I2C2_CLIENT_MLC);
+  if (ret != BSP_ERROR_NONE)
+  {
+    return ret;
+  }
+
+  ret = CUSTOM_MOTION_SENSOR_Write_Register(MLC_INSTANCE, LSM6DSOX_FUNC_CFG_ACCESS, FUNC_CFG_ACCESS_EMB);
+  if (ret == BSP_ERROR_NONE)
+  {
+    ret = CUSTOM_MOTION_SENSOR_Read_Register(MLC_INSTANCE, Reg, Data);
+  }
+
+  /* Always go back to the main page, the stream reads from there */
+  if (CUSTOM_MOTION_SENSOR_Write_Register(MLC_INSTANCE, LSM6DSOX_FUNC_CFG_ACCESS, FUNC_CFG_ACCESS_MAIN) != BSP_ERROR_NONE)
+  {
+    ret = BSP_ERROR_COMPONENT_FAILURE;
+  }
+
+  BSP_I2C2_Release();
+
+  return ret;
+}
+
+/**
+ * @brief  Read the needs of the MLC program from its UCF
+ * @note   The MLC data rate, the sensors it turns on and the power modes it
+ *         was trained in. The features are computed at the MLC data rate.
+ * @param  Need the MLC needs
+ * @retval None
+ */
+static void MLC_Ucf_Needs(SENSOR_PLAN_Req_t *Need)
+{
+  uint32_t i;
+  uint8_t page = FUNC_CFG_ACCESS_MAIN;
+  uint8_t reg;
+  uint8_t val;
+  uint8_t mlc = 0;
+  uint8_t odr = 0;
+  uint8_t gyr = 0;
+  uint8_t ulp = 0;
+  uint8_t xl_hm = 0;
+  uint8_t g_hm = 0;
+
+  Need->Name = "mlc";
+  Need->AccMode = SENSOR_PLAN_MODE_HP;
+  Need->GyrMode = SENSOR_PLAN_MODE_HP;
+
+  for (i = 0; i < (sizeof(falling) / sizeof(ucf_line_t)); i++)
+  {
+    reg = falling[i].address;
+    val = falling[i].data;
+
+    if (reg == LSM6DSOX_FUNC_CFG_ACCESS)
+    {
+      page = val & FUNC_CFG_ACCESS_PAGE;
+    }
+    else if (page == FUNC_CFG_ACCESS_EMB)
+    {
+      if (reg == LSM6DSOX_EMB_FUNC_ODR_CFG_C)
+      {
+        odr = (val & MLC_ODR_MASK) >> MLC_ODR_SHIFT;
+      }
+      else if (reg == LSM6DSOX_EMB_FUNC_EN_B)
+      {
+        mlc = ((val & EMB_FUNC_EN_B_MLC) != 0U) ? 1U : 0U;
+      }
+      else
+      {
+        /* Other registers do not change the needs */
+      }
+    }
+    else if (page == FUNC_CFG_ACCESS_MAIN)
+    {
+      if (reg == LSM6DSOX_CTRL2_G)
+      {
+        gyr = ((val & ODR_MASK) != 0U) ? 1U : 0U;
+      }
+      else if (reg == LSM6DSOX_CTRL5_C)
+      {
+        ulp = ((val & CTRL5_C_XL_ULP_EN) != 0U) ? 1U : 0U;
+      }
+      else if (reg == LSM6DSOX_CTRL6_C)
+      {
+        xl_hm = ((val & CTRL6_C_XL_HM_MODE) != 0U) ? 1U : 0U;
+      }
+      else if (reg == LSM6DSOX_CTRL7_G)
+      {
+        g_hm = ((val & CTRL7_G_G_HM_MODE) != 0U) ? 1U : 0U;
+      }
+      else
+      {
+        /* Other registers do not change the needs */
+      }
+    }
+    else
+    {
+      /* Sensor hub page */
+    }
+  }
+
+  if (mlc == 0U)
+  {
+    return;
+  }
+
+  Need->MlcRate = MlcRates[odr];
+  Need->AccRate = MlcRates[odr];
+  Need->AccMode = (ulp != 0U) ? SENSOR_PLAN_MODE_ULP : ((xl_hm != 0U) ? SENSOR_PLAN_MODE_LP : SENSOR_PLAN_MODE_HP);
+  if (gyr != 0U)
+  {
+    Need->GyrRate = MlcRates[odr];
+    Need->GyrMode = (g_hm != 0U) ? SENSOR_PLAN_MODE_LP : SENSOR_PLAN_MODE_HP;
+  }
+}
+
+/**
+ * @brief  Write a plan, in one pass with the bus held
+ * @note   The sensors are off while the power modes change, the MLC rate
+ *         is set on the embedded functions page with the interrupt latch.
+ *         Fields are changed in place, the full scales of the program stay.
+ * @param  Plan the plan
+ * @retval BSP_ERROR_NONE in case of success, an error code otherwise
+ */
+static int32_t MLC_Apply_Plan(const SENSOR_PLAN_t *Plan)
+{
+  uint8_t ulp = (Plan->AccMode == SENSOR_PLAN_MODE_ULP) ? CTRL5_C_XL_ULP_EN : 0U;
+  uint8_t xl_hm = (Plan->AccMode == SENSOR_PLAN_MODE_LP) ? CTRL6_C_XL_HM_MODE : 0U;
+  uint8_t g_hm = (Plan->GyrMode != SENSOR_PLAN_MODE_HP) ? CTRL7_G_G_HM_MODE : 0U;
+  uint8_t xl_odr = (uint8_t)(PlanXlOdr[Plan->AccRate] << ODR_SHIFT);
+  uint8_t g_odr = (uint8_t)(PlanGyOdr[Plan->GyrRate] << ODR_SHIFT);
+  uint8_t mlc_odr = (uint8_t)(PlanMlcOdr[Plan->MlcRate] << MLC_ODR_SHIFT);
+  const uint8_t pass[][3] =
+  {
+    /* Register, field, value */
+    { LSM6DSOX_CTRL1_XL, ODR_MASK, 0U },
+    { LSM6DSOX_CTRL2_G, ODR_MASK, 0U },
+    { LSM6DSOX_CTRL6_C, CTRL6_C_XL_HM_MODE, xl_hm },
+    { LSM6DSOX_CTRL5_C, CTRL5_C_XL_ULP_EN, ulp },
+    { LSM6DSOX_CTRL7_G, CTRL7_G_G_HM_MODE, g_hm },
+    { LSM6DSOX_FUNC_CFG_ACCESS, REG_WRITE, FUNC_CFG_ACCESS_EMB },
+    { LSM6DSOX_PAGE_RW, REG_WRITE, PAGE_RW_EMB_FUNC_LIR }, /* MLC interrupt kept until read */
+    { LSM6DSOX_EMB_FUNC_ODR_CFG_C, MLC_ODR_MASK, mlc_odr },
+    { LSM6DSOX_FUNC_CFG_ACCESS, REG_WRITE, FUNC_CFG_ACCESS_MAIN },
+    { LSM6DSOX_CTRL2_G, ODR_MASK, g_odr },
+    { LSM6DSOX_CTRL1_XL, ODR_MASK, xl_odr },
+  };
+  int32_t ret = BSP_ERROR_NONE;
+  uint8_t val = 0;
+  uint32_t i;
+
+  for (i = 0; (i < (sizeof(pass) / sizeof(pass[0]))) && (ret == BSP_ERROR_NONE); i++)
+  {
+    if (pass[i][1] != REG_WRITE)
+    {
+      ret = CUSTOM_MOTION_SENSOR_Read_Register(MLC_INSTANCE, pass[i][0], &val);
+      val = (uint8_t)((val & (uint8_t)~pass[i][1]) | pass[i][2]);
+    }
+    else
+    {
+      val = pass[i][2];
+    }
+    if (ret == BSP_ERROR_NONE)
+    {
+      ret = CUSTOM_MOTION_SENSOR_Write_Register(MLC_INSTANCE, pass[i][0], val);
+    }
+  }
+
+  /* Never leave the embedded functions page selected */
+  if ((ret != BSP_ERROR_NONE)
+      && (CUSTOM_MOTION_SENSOR_Write_Register(MLC_INSTANCE, LSM6DSOX_FUNC_CFG_ACCESS, FUNC_CFG_ACCESS_MAIN) != BSP_ERROR_NONE))
+  {
+    ret = BSP_ERROR_COMPONENT_FAILURE;
+  }
+
+  return ret;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
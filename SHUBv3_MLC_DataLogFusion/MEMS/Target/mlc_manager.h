@@ -0,0 +1,44 @@
+/**
+  ******************************************************************************
+  * @file    mlc_manager.h
+  * @author  ISCA Lab
+  * @brief   This file contains definitions for the mlc_manager.c file
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef MLC_MANAGER_H
+#define MLC_MANAGER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "sensor_plan.h"
+
+/* Exported Types ------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t Code;    /* Last MLC0_SRC value, the decision tree output */
+  uint32_t Events; /* MLC interrupts seen since start */
+} MLC_output_t;
+
+/* Exported Functions Prototypes ---------------------------------------------*/
+void MLC_manager_init(const SENSOR_PLAN_Req_t *Needs, uint32_t Count);
+uint8_t MLC_manager_is_running(void);
+void MLC_manager_get_output(MLC_output_t *data_out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MLC_MANAGER_H */
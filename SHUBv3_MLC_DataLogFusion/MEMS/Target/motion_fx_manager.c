@@ -19,6 +19,11 @@
 /* Includes ------------------------------------------------------------------*/
 #include "motion_fx_manager.h"
 #include "custom_mems_control_ex.h"
+#include "mem_budget.h"
+#include "fx_rate.h"
+#if (FUSION_MAHONY == 1)
+#include "fx_mahony.h"
+#endif
 
 /** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
  * @{
@@ -30,7 +35,7 @@
 
 /* Extern variables ----------------------------------------------------------*/
 /* Private defines -----------------------------------------------------------*/
-#define STATE_SIZE                      (size_t)(2432)
+#define STATE_SIZE                      (size_t)(MEM_BUDGET_MFX_STATE_SIZE)
 
 #define SAMPLETODISCARD                 15
 
@@ -38,16 +43,58 @@
 #define GBIAS_GYRO_TH_SC                (2.0f*0.002f)
 #define GBIAS_MAG_TH_SC                 (2.0f*0.001500f)
 
-#define DECIMATION                      1U
+/* Samples per Kalman update, the propagate runs on every sample */
+#ifndef MFX_UPDATE_DIV
+#define MFX_UPDATE_DIV                  1U
+#endif
+
+/* Samples a due update may wait for a still one, at most one period late */
+#ifndef MFX_UPDATE_MAX_DEFER
+#define MFX_UPDATE_MAX_DEFER            (MFX_UPDATE_DIV - 1U)
+#endif
+
+/* Acceleration norm tolerance of a still sample [g], FX_MAHONY_ACC_TOL with
+ * the in-tree engine */
+#define MFX_UPDATE_QUIET_TOL            0.1f
+
+#if (FUSION_MAHONY == 1)
+#define MAHONY_PERIOD_US                10000U  /* Until the first run */
+#define MAHONY_VERSION                  "ISCA Mahony 6X Q30 v1.0.0"
+#define MAHONY_HEADING_ERR              180.0f  /* No magnetic reference */
+#define FROM_Q30_TO_FLOAT               (1.0f / (float)FX_MAHONY_ONE)
+#define FROM_MDEG_TO_DEG                0.001f
+#endif
 
 /* Private variables ---------------------------------------------------------*/
+#if (FUSION_MAHONY == 1)
+_Static_assert(sizeof(FX_MAHONY_t) <= MEM_BUDGET_MFX_STATE_SIZE, "Fusion state budget too small");
+_Static_assert((MFX_MANAGER_OUT_QUAT == FX_MAHONY_OUT_QUAT) && (MFX_MANAGER_OUT_ROT == FX_MAHONY_OUT_ROT)
+               && (MFX_MANAGER_OUT_GRAV == FX_MAHONY_OUT_GRAV) && (MFX_MANAGER_OUT_LINACC == FX_MAHONY_OUT_LINACC),
+               "Output bits differ from the engine");
+
+static MEMS_FIXED_Axes_t MahonyAcc; /* Sample of the last propagate, for the update */
+static float MahonyDt;
+static uint8_t MahonyEnabled = 0;
+#else
 static MFX_knobs_t iKnobs;
 static MFX_knobs_t *ipKnobs = &iKnobs;
+#endif
 
 static volatile int sampleToDiscard = SAMPLETODISCARD;
 static int discardedCount = 0;
 
-static uint8_t mfxstate[STATE_SIZE];
+static uint8_t *mfxstate;
+
+/* Private function prototypes -----------------------------------------------*/
+static void FX_Propagate(void *Ctx, void *In, void *Out, float Dt);
+static void FX_Update(void *Ctx, void *In, void *Out, float Dt);
+#if (FUSION_MAHONY == 1)
+static void Mahony_ToFloat(const FX_MAHONY_Output_t *Fx, uint32_t Outputs, MFX_output_t *Out);
+#endif
+
+/* Fusion steps run by the rate scheduler */
+static const FX_RATE_Ops_t FxOps = { FX_Propagate, FX_Update };
+static FX_RATE_t FxRate;
 
 /* Private typedef -----------------------------------------------------------*/
 /* Exported function prototypes ----------------------------------------------*/
@@ -59,9 +106,29 @@ static uint8_t mfxstate[STATE_SIZE];
  */
 void MotionFX_manager_init(void)
 {
+#if (FUSION_MAHONY == 1)
+  if (mfxstate == NULL)
+  {
+    mfxstate = (uint8_t *)MEM_BUDGET_ALLOC(MFX_STATE);
+  }
+
+  if (FX_MAHONY_Init((FX_MAHONY_t *)mfxstate, MAHONY_PERIOD_US, FX_MAHONY_KP, FX_MAHONY_KI) != FX_MAHONY_OK)
+    Error_Handler();
+
+  MahonyDt = 0.0f;
+  MahonyEnabled = 0;
+
+  if (FX_RATE_Init(&FxRate, &FxOps, mfxstate, MFX_UPDATE_DIV, MFX_UPDATE_MAX_DEFER) != FX_RATE_OK)
+    Error_Handler();
+#else
   if (STATE_SIZE < MotionFX_GetStateSize())
     Error_Handler();
 
+  if (mfxstate == NULL)
+  {
+    mfxstate = (uint8_t *)MEM_BUDGET_ALLOC(MFX_STATE);
+  }
+
   MotionFX_initialize((MFXState_t *)mfxstate);
 
   MotionFX_getKnobs(mfxstate, ipKnobs);
@@ -76,14 +143,54 @@ void MotionFX_manager_init(void)
 
   ipKnobs->output_type = MFX_ENGINE_OUTPUT_ENU;
   ipKnobs->LMode = 1;
-  ipKnobs->modx = DECIMATION;
+  ipKnobs->modx = (unsigned char)MFX_UPDATE_DIV;
 
   MotionFX_setKnobs(mfxstate, ipKnobs);
 
+  if (FX_RATE_Init(&FxRate, &FxOps, mfxstate, MFX_UPDATE_DIV, MFX_UPDATE_MAX_DEFER) != FX_RATE_OK)
+    Error_Handler();
+
   MotionFX_enable_6X(mfxstate, MFX_ENGINE_DISABLE);
   MotionFX_enable_9X(mfxstate, MFX_ENGINE_DISABLE);
+#endif
 }
 
+#if (FUSION_MAHONY == 1)
+/**
+ * @brief  Run the in-tree engine on a fixed-point sample
+ * @note   The samples go to the engine as they are read, only the outputs
+ *         asked for are computed and converted to float.
+ * @param  acc the acceleration [mg, Q23.8]
+ * @param  gyr the angular rate [mdps, Q23.8]
+ * @param  outputs the MFX_MANAGER_OUT_* the caller sends
+ * @param  data_out Structure containing output data
+ * @param  delta_time Delta time
+ * @retval None
+ */
+void MotionFX_manager_run_fixed(const MEMS_FIXED_Axes_t *acc, const MEMS_FIXED_Axes_t *gyr, uint32_t outputs,
+                                MFX_output_t *data_out, float delta_time)
+{
+  FX_MAHONY_Output_t fx;
+
+  if (MahonyEnabled == 0U)
+  {
+    return;
+  }
+
+  if (discardedCount != sampleToDiscard)
+  {
+    discardedCount++;
+    return;
+  }
+
+  /* Kept for the update, which may run on a later sample */
+  MahonyAcc = *acc;
+  (void)FX_RATE_Step(&FxRate, (void *)gyr, NULL, delta_time, FX_MAHONY_Quiet(acc));
+
+  FX_MAHONY_GetOutput((const FX_MAHONY_t *)mfxstate, &MahonyAcc, outputs, &fx);
+  Mahony_ToFloat(&fx, outputs, data_out);
+}
+#else
 /**
  * @brief  Run Motion Sensor Data Fusion algorithm
  * @param  data_in  Structure containing input data
@@ -95,14 +202,40 @@ void MotionFX_manager_run(MFX_input_t *data_in, MFX_output_t *data_out, float de
 {
   if (discardedCount == sampleToDiscard)
   {
-    MotionFX_propagate(mfxstate, data_out, data_in, &delta_time);
-    MotionFX_update(mfxstate, data_out, data_in, &delta_time, NULL);
+    (void)FX_RATE_Step(&FxRate, data_in, data_out, delta_time,
+                       FX_RATE_Quiet(data_in->acc, MFX_UPDATE_QUIET_TOL));
   }
   else
   {
     discardedCount++;
   }
 }
+#endif
+
+/**
+ * @brief  Set the number of samples per Kalman update
+ * @note   The library decimation (modx) follows. An update that falls due
+ *         while moving waits for a still sample, up to div - 1 more samples.
+ *         With the in-tree engine the update is the accelerometer
+ *         correction.
+ * @param  div samples per update, 1 to run it on every sample
+ * @retval 0 in case of success, 1 if div is out of range
+ */
+int MotionFX_manager_set_update_div(uint32_t div)
+{
+  if (FX_RATE_Init(&FxRate, &FxOps, mfxstate, div, div - 1U) != FX_RATE_OK)
+  {
+    return 1;
+  }
+
+#if (FUSION_MAHONY == 0)
+  MotionFX_getKnobs(mfxstate, ipKnobs);
+  ipKnobs->modx = (unsigned char)div;
+  MotionFX_setKnobs(mfxstate, ipKnobs);
+#endif
+
+  return 0;
+}
 
 /**
  * @brief  Start 6 axes MotionFX engine
@@ -111,7 +244,11 @@ void MotionFX_manager_run(MFX_input_t *data_in, MFX_output_t *data_out, float de
  */
 void MotionFX_manager_start_6X(void)
 {
+#if (FUSION_MAHONY == 1)
+  MahonyEnabled = 1;
+#else
   MotionFX_enable_6X(mfxstate, MFX_ENGINE_ENABLE);
+#endif
 }
 
 /**
@@ -121,17 +258,26 @@ void MotionFX_manager_start_6X(void)
  */
 void MotionFX_manager_stop_6X(void)
 {
+#if (FUSION_MAHONY == 1)
+  MahonyEnabled = 0;
+#else
   MotionFX_enable_6X(mfxstate, MFX_ENGINE_DISABLE);
+#endif
 }
 
 /**
  * @brief  Start 9 axes MotionFX engine
+ * @note   The in-tree engine has no magnetometer input, it runs 6 axes
  * @param  None
  * @retval None
  */
 void MotionFX_manager_start_9X(void)
 {
+#if (FUSION_MAHONY == 1)
+  MahonyEnabled = 1;
+#else
   MotionFX_enable_9X(mfxstate, MFX_ENGINE_ENABLE);
+#endif
 }
 
 /**
@@ -141,7 +287,11 @@ void MotionFX_manager_start_9X(void)
  */
 void MotionFX_manager_stop_9X(void)
 {
+#if (FUSION_MAHONY == 1)
+  MahonyEnabled = 0;
+#else
   MotionFX_enable_9X(mfxstate, MFX_ENGINE_DISABLE);
+#endif
 }
 
 /**
@@ -152,7 +302,12 @@ void MotionFX_manager_stop_9X(void)
  */
 void MotionFX_manager_get_version(char *version, int *length)
 {
+#if (FUSION_MAHONY == 1)
+  (void)memcpy(version, MAHONY_VERSION, sizeof(MAHONY_VERSION));
+  *length = (int)sizeof(MAHONY_VERSION) - 1;
+#else
   *length = (int)MotionFX_GetLibVersion(version);
+#endif
 }
 
 /**
@@ -208,6 +363,117 @@ char MotionFX_SaveMagCalInNVM(unsigned short int dataSize, unsigned int *data)
   return (char)1;
 }
 
+/* Private functions ---------------------------------------------------------*/
+#if (FUSION_MAHONY == 1)
+/**
+ * @brief  Propagate step of the rate scheduler, in-tree engine
+ * @param  Ctx the engine
+ * @param  In the angular rate [mdps, Q23.8]
+ * @param  Out unused, the outputs are read after the step
+ * @param  Dt the time since the previous sample [s]
+ * @retval None
+ */
+static void FX_Propagate(void *Ctx, void *In, void *Out, float Dt)
+{
+  FX_MAHONY_t *eng = (FX_MAHONY_t *)Ctx;
+
+  (void)Out;
+
+  if (Dt != MahonyDt)
+  {
+    if (FX_MAHONY_SetPeriod(eng, (uint32_t)((Dt * 1000000.0f) + 0.5f)) == FX_MAHONY_OK)
+    {
+      MahonyDt = Dt;
+    }
+  }
+
+  FX_MAHONY_Propagate(eng, (const MEMS_FIXED_Axes_t *)In);
+}
+
+/**
+ * @brief  Update step of the rate scheduler, in-tree engine
+ * @param  Ctx the engine
+ * @param  In unused, the acceleration is MahonyAcc
+ * @param  Out unused
+ * @param  Dt unused
+ * @retval None
+ */
+static void FX_Update(void *Ctx, void *In, void *Out, float Dt)
+{
+  (void)In;
+  (void)Out;
+  (void)Dt;
+
+  FX_MAHONY_Update((FX_MAHONY_t *)Ctx, &MahonyAcc);
+}
+
+/**
+ * @brief  Convert the engine outputs to the MotionFX ones
+ * @param  Fx the engine outputs
+ * @param  Outputs the MFX_MANAGER_OUT_* to convert, the others are 0
+ * @param  Out the MotionFX outputs
+ * @retval None
+ */
+static void Mahony_ToFloat(const FX_MAHONY_Output_t *Fx, uint32_t Outputs, MFX_output_t *Out)
+{
+  uint32_t quat = ((Outputs & MFX_MANAGER_OUT_QUAT) != 0U) ? 1U : 0U;
+  uint32_t rot = ((Outputs & MFX_MANAGER_OUT_ROT) != 0U) ? 1U : 0U;
+  uint32_t grav = ((Outputs & MFX_MANAGER_OUT_GRAV) != 0U) ? 1U : 0U;
+
+  for (uint32_t i = 0; i < 4U; i++)
+  {
+    Out->quaternion[i] = (quat != 0U) ? ((float)Fx->Quat[i] * FROM_Q30_TO_FLOAT) : 0.0f;
+  }
+  for (uint32_t i = 0; i < 3U; i++)
+  {
+    Out->rotation[i] = (rot != 0U) ? ((float)Fx->Rot[i] * FROM_MDEG_TO_DEG) : 0.0f;
+    Out->gravity[i] = (grav != 0U) ? ((float)Fx->Gravity[i] * FROM_Q30_TO_FLOAT) : 0.0f;
+  }
+
+  if ((Outputs & MFX_MANAGER_OUT_LINACC) != 0U)
+  {
+    Out->linear_acceleration[0] = MEMS_FIXED_ToUnit(Fx->LinAcc.x);
+    Out->linear_acceleration[1] = MEMS_FIXED_ToUnit(Fx->LinAcc.y);
+    Out->linear_acceleration[2] = MEMS_FIXED_ToUnit(Fx->LinAcc.z);
+  }
+  else
+  {
+    Out->linear_acceleration[0] = 0.0f;
+    Out->linear_acceleration[1] = 0.0f;
+    Out->linear_acceleration[2] = 0.0f;
+  }
+
+  Out->heading = Out->rotation[0];
+  Out->headingErr = MAHONY_HEADING_ERR;
+}
+#else
+/**
+ * @brief  Propagate step of the rate scheduler
+ * @param  Ctx the MotionFX state
+ * @param  In the MFX_input_t sample
+ * @param  Out the MFX_output_t outputs
+ * @param  Dt the time since the previous sample [s]
+ * @retval None
+ */
+static void FX_Propagate(void *Ctx, void *In, void *Out, float Dt)
+{
+  MotionFX_propagate(Ctx, (MFX_output_t *)Out, (MFX_input_t *)In, &Dt);
+}
+
+/**
+ * @brief  Update step of the rate scheduler
+ * @param  Ctx the MotionFX state
+ * @param  In the MFX_input_t sample
+ * @param  Out the MFX_output_t outputs
+ * @param  Dt the time since the previous sample [s], as for the propagate
+ * @retval None
+ */
+static void FX_Update(void *Ctx, void *In, void *Out, float Dt)
+{
+  MotionFX_update(Ctx, (MFX_output_t *)Out, (MFX_input_t *)In, &Dt, NULL);
+}
+#endif
+
 /**
  * @}
  */
@@ -27,15 +27,37 @@ extern "C" {
 /* Includes ------------------------------------------------------------------*/
 #include "string.h"
 #include "motion_fx.h"
+#include "mems_fixed.h"
 #include "main.h"
 
 /* Extern variables ----------------------------------------------------------*/
 /* Exported Macros -----------------------------------------------------------*/
+/* 1: the in-tree fixed-point 6 axes engine (fx_mahony.h) runs the fusion in
+ * place of the MotionFX library, which then only calibrates the
+ * magnetometer. Set it in the build flags, mem_budget.h sizes the fusion
+ * state from it. */
+#ifndef FUSION_MAHONY
+#define FUSION_MAHONY  0
+#endif
+
+/* Outputs of MotionFX_manager_run_fixed, the others are written as 0 */
+#define MFX_MANAGER_OUT_QUAT     0x01U
+#define MFX_MANAGER_OUT_ROT      0x02U /* Rotation and heading */
+#define MFX_MANAGER_OUT_GRAV     0x04U
+#define MFX_MANAGER_OUT_LINACC   0x08U
+#define MFX_MANAGER_OUT_ALL      0x0FU
+
 /* Exported Types ------------------------------------------------------------*/
 /* Imported Variables --------------------------------------------------------*/
 /* Exported Functions Prototypes ---------------------------------------------*/
 void MotionFX_manager_init(void);
+#if (FUSION_MAHONY == 1)
+void MotionFX_manager_run_fixed(const MEMS_FIXED_Axes_t *acc, const MEMS_FIXED_Axes_t *gyr, uint32_t outputs,
+                                MFX_output_t *data_out, float delta_time);
+#else
 void MotionFX_manager_run(MFX_input_t *data_in, MFX_output_t *data_out, float delta_time);
+#endif
+int MotionFX_manager_set_update_div(uint32_t div);
 void MotionFX_manager_start_6X(void);
 void MotionFX_manager_stop_6X(void);
 void MotionFX_manager_start_9X(void);
@@ -0,0 +1,237 @@
+/**
+  ******************************************************************************
+  * @file    sample_decim.c
+  * @author  ISCA Lab
+  * @brief   Anti-aliasing decimation of the sensor samples
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "sample_decim.h"
+#include "mem_placement.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup SAMPLE_DECIM SAMPLE DECIM
+ * @{
+ */
+
+/* Private defines -----------------------------------------------------------*/
+#define TAPS_FRAC_BITS  15
+
+/* Private variables ---------------------------------------------------------*/
+/* Kaiser window (beta 5) low-pass, cut-off at 0.45 of the output rate, sum
+ * 32768. Printed by Tools/sample_decim (decim_check --taps). */
+static const int16_t Taps2[SAMPLE_DECIM_SPAN * 2U] =
+{
+     -47,     45,    470,     75,  -1735,  -1237,   5412,  13401,
+   13401,   5412,  -1237,  -1735,     75,    470,     45,    -47
+};
+
+static const int16_t Taps4[SAMPLE_DECIM_SPAN * 4U] =
+{
+     -25,    -38,    -11,     80,    209,    284,    183,   -161,
+    -664,  -1057,   -962,    -75,   1642,   3854,   5933,   7192,
+    7192,   5933,   3854,   1642,    -75,   -962,  -1057,   -664,
+    -161,    183,    284,    209,     80,    -11,    -38,    -25
+};
+
+static const int16_t Taps8[SAMPLE_DECIM_SPAN * 8U] =
+{
+     -12,    -18,    -21,    -20,    -13,      3,     28,     59,
+      94,    125,    145,    145,    119,     61,    -28,   -143,
+    -273,   -400,   -502,   -554,   -531,   -415,   -191,    142,
+     576,   1088,   1646,   2210,   2735,   3175,   3493,   3661,
+    3661,   3493,   3175,   2735,   2210,   1646,   1088,    576,
+     142,   -191,   -415,   -531,   -554,   -502,   -400,   -273,
+    -143,    -28,     61,    119,    145,    145,    125,     94,
+      59,     28,      3,    -13,    -20,    -21,    -18,    -12
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void Prime(SAMPLE_DECIM_t *Dec, const MEMS_FIXED_Axes_t *In);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief  Initialize a decimation filter
+ * @param  Dec the filter
+ * @param  Factor input samples per output, 1, 2, 4 or 8
+ * @retval SAMPLE_DECIM_OK, SAMPLE_DECIM_ERROR if the factor is not supported
+ */
+int32_t SAMPLE_DECIM_Init(SAMPLE_DECIM_t *Dec, uint32_t Factor)
+{
+  switch (Factor)
+  {
+    case 1U:
+      Dec->Taps = NULL;
+      break;
+
+    case 2U:
+      Dec->Taps = Taps2;
+      break;
+
+    case 4U:
+      Dec->Taps = Taps4;
+      break;
+
+    case 8U:
+      Dec->Taps = Taps8;
+      break;
+
+    default:
+      return SAMPLE_DECIM_ERROR;
+  }
+
+  Dec->Factor = Factor;
+  SAMPLE_DECIM_Reset(Dec);
+
+  return SAMPLE_DECIM_OK;
+}
+
+/**
+ * @brief  Restart the filter, the next sample primes it
+ * @note   Call when the input stream has a gap (stream stopped, samples lost)
+ * @param  Dec the filter
+ * @retval None
+ */
+void SAMPLE_DECIM_Reset(SAMPLE_DECIM_t *Dec)
+{
+  Dec->Count = 0;
+  Dec->Primed = 0;
+}
+
+/**
+ * @brief  Filter one input sample
+ * @param  Dec the filter
+ * @param  In the input sample
+ * @param  Out the output sample, written only when one is produced
+ * @retval 1 if an output was produced, 0 otherwise
+ */
+RAM_FUNC uint8_t SAMPLE_DECIM_Push(SAMPLE_DECIM_t *Dec, const MEMS_FIXED_Axes_t *In, MEMS_FIXED_Axes_t *Out)
+{
+  const int32_t round = (int32_t)1 << (TAPS_FRAC_BITS - 1);
+  const int16_t *tap;
+  const int32_t x = In->x;
+  const int32_t y = In->y;
+  const int32_t z = In->z;
+  uint32_t factor = Dec->Factor;
+  uint32_t i;
+
+  if (Dec->Taps == NULL)
+  {
+    *Out = *In;
+    return 1;
+  }
+
+  if (Dec->Primed == 0U)
+  {
+    Prime(Dec, In);
+  }
+
+  /* The sample is tap Factor - Count of the output being built, the same
+   * tap plus Factor of the next one, and so on */
+  Dec->Count++;
+  tap = &Dec->Taps[factor - Dec->Count];
+  for (i = 0; i < SAMPLE_DECIM_SPAN; i++)
+  {
+    Dec->Acc[i][0] += (int64_t)*tap * x;
+    Dec->Acc[i][1] += (int64_t)*tap * y;
+    Dec->Acc[i][2] += (int64_t)*tap * z;
+    tap += factor;
+  }
+
+  if (Dec->Count < factor)
+  {
+    return 0;
+  }
+
+  Out->x = (mems_q8_t)((Dec->Acc[0][0] + round) >> TAPS_FRAC_BITS);
+  Out->y = (mems_q8_t)((Dec->Acc[0][1] + round) >> TAPS_FRAC_BITS);
+  Out->z = (mems_q8_t)((Dec->Acc[0][2] + round) >> TAPS_FRAC_BITS);
+
+  for (i = 1; i < SAMPLE_DECIM_SPAN; i++)
+  {
+    Dec->Acc[i - 1U][0] = Dec->Acc[i][0];
+    Dec->Acc[i - 1U][1] = Dec->Acc[i][1];
+    Dec->Acc[i - 1U][2] = Dec->Acc[i][2];
+  }
+  Dec->Acc[SAMPLE_DECIM_SPAN - 1U][0] = 0;
+  Dec->Acc[SAMPLE_DECIM_SPAN - 1U][1] = 0;
+  Dec->Acc[SAMPLE_DECIM_SPAN - 1U][2] = 0;
+  Dec->Count = 0;
+
+  return 1;
+}
+
+/**
+ * @brief  Filter a block of input samples, e.g. a FIFO read
+ * @param  Dec the filter
+ * @param  In the input samples
+ * @param  Count the number of input samples
+ * @param  Out the output samples, may be In
+ * @retval The number of output samples
+ */
+uint32_t SAMPLE_DECIM_Block(SAMPLE_DECIM_t *Dec, const MEMS_FIXED_Axes_t *In, uint32_t Count,
+                            MEMS_FIXED_Axes_t *Out)
+{
+  MEMS_FIXED_Axes_t sample;
+  uint32_t outputs = 0;
+  uint32_t i;
+
+  for (i = 0; i < Count; i++)
+  {
+    /* Out[outputs] is never ahead of In[i], copy in case they are the same */
+    sample = In[i];
+    outputs += SAMPLE_DECIM_Push(Dec, &sample, &Out[outputs]);
+  }
+
+  return outputs;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief  Fill the outputs being built as if the sample had always been there
+ * @param  Dec the filter
+ * @param  In the first sample
+ * @retval None
+ */
+static void Prime(SAMPLE_DECIM_t *Dec, const MEMS_FIXED_Axes_t *In)
+{
+  int32_t past = 0;
+  uint32_t i;
+  uint32_t k;
+
+  /* Output i has already seen the samples of taps (i + 1) * Factor and up */
+  for (i = SAMPLE_DECIM_SPAN; i > 0U; i--)
+  {
+    Dec->Acc[i - 1U][0] = (int64_t)past * In->x;
+    Dec->Acc[i - 1U][1] = (int64_t)past * In->y;
+    Dec->Acc[i - 1U][2] = (int64_t)past * In->z;
+
+    for (k = (i - 1U) * Dec->Factor; k < (i * Dec->Factor); k++)
+    {
+      past += Dec->Taps[k];
+    }
+  }
+
+  Dec->Count = 0;
+  Dec->Primed = 1;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
@@ -0,0 +1,96 @@
+/**
+  ******************************************************************************
+  * @file    sample_decim.h
+  * @author  ISCA Lab
+  * @brief   Anti-aliasing decimation of the sensor samples
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SAMPLE_DECIM_H
+#define SAMPLE_DECIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "mems_fixed.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup SAMPLE_DECIM SAMPLE DECIM
+ * @{
+ */
+
+/*
+ * The sensor runs Factor times faster than the consumers (fusion, stream)
+ * and every sample goes through a linear phase low-pass FIR before one in
+ * Factor is kept, so that the noise above the output Nyquist frequency is
+ * removed instead of folded back.
+ *
+ * The filter has SAMPLE_DECIM_SPAN * Factor taps in Q15, cut-off at 0.45 of
+ * the output rate: flat within 0.1 dB up to 0.25 of the output rate, 58 dB
+ * down from 0.75 (the band that would alias below 0.25). It runs polyphase:
+ * each input sample adds its contribution to the SAMPLE_DECIM_SPAN outputs
+ * it belongs to, so the cost is SAMPLE_DECIM_SPAN multiply-accumulates per
+ * axis and per input sample whatever the factor, and no input history is
+ * kept. The group delay is about SAMPLE_DECIM_SPAN / 2 output periods.
+ *
+ * The first sample after a reset primes the filter as if it had always been
+ * there, so the outputs have no start-up ramp. A factor of 1 copies the
+ * samples.
+ *
+ * The module has no hardware dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define SAMPLE_DECIM_OK      0
+#define SAMPLE_DECIM_ERROR  -1
+
+/* Output periods covered by the filter */
+#define SAMPLE_DECIM_SPAN  8U
+
+/* Largest factor, e.g. 833 Hz sensor for a 104 Hz output */
+#define SAMPLE_DECIM_MAX_FACTOR  8U
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  const int16_t *Taps;  /* SAMPLE_DECIM_SPAN * Factor, Q15, NULL for factor 1 */
+  uint32_t Factor;
+  uint32_t Count;       /* Inputs since the last output */
+  uint8_t Primed;
+  int64_t Acc[SAMPLE_DECIM_SPAN][3];  /* Output being built, next ones after */
+} SAMPLE_DECIM_t;
+
+/* Exported functions --------------------------------------------------------*/
+int32_t SAMPLE_DECIM_Init(SAMPLE_DECIM_t *Dec, uint32_t Factor);
+void SAMPLE_DECIM_Reset(SAMPLE_DECIM_t *Dec);
+uint8_t SAMPLE_DECIM_Push(SAMPLE_DECIM_t *Dec, const MEMS_FIXED_Axes_t *In, MEMS_FIXED_Axes_t *Out);
+uint32_t SAMPLE_DECIM_Block(SAMPLE_DECIM_t *Dec, const MEMS_FIXED_Axes_t *In, uint32_t Count,
+                            MEMS_FIXED_Axes_t *Out);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_DECIM_H */
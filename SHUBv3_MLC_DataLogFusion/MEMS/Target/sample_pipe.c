@@ -0,0 +1,88 @@
+/**
+  ******************************************************************************
+  * @file    sample_pipe.c
+  * @author  ISCA Lab
+  * @brief   Stage list run once per stream sample
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stddef.h>
+#include "sample_pipe.h"
+#include "mem_placement.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup SAMPLE_PIPE SAMPLE PIPE
+ * @{
+ */
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief  Empty a stage list
+ * @param  Pipe the stage list
+ * @retval None
+ */
+void SAMPLE_PIPE_Reset(SAMPLE_PIPE_t *Pipe)
+{
+  Pipe->Count = 0;
+}
+
+/**
+ * @brief  Append a stage
+ * @param  Pipe the stage list
+ * @param  Run the stage function
+ * @param  Source the value read or filled by the stage, may be NULL
+ * @param  Sink the destination in the frame, may be NULL
+ * @retval SAMPLE_PIPE_OK, SAMPLE_PIPE_ERROR if the list is full
+ */
+int32_t SAMPLE_PIPE_Add(SAMPLE_PIPE_t *Pipe, SAMPLE_PIPE_Fn_t Run, void *Source, uint8_t *Sink)
+{
+  SAMPLE_PIPE_Stage_t *stage;
+
+  if ((Run == NULL) || (Pipe->Count >= SAMPLE_PIPE_MAX_STAGES))
+  {
+    return SAMPLE_PIPE_ERROR;
+  }
+
+  stage = &Pipe->Stages[Pipe->Count];
+  stage->Run = Run;
+  stage->Source = Source;
+  stage->Sink = Sink;
+  Pipe->Count++;
+
+  return SAMPLE_PIPE_OK;
+}
+
+/**
+ * @brief  Run every stage in order
+ * @param  Pipe the stage list
+ * @retval None
+ */
+RAM_FUNC void SAMPLE_PIPE_Run(const SAMPLE_PIPE_t *Pipe)
+{
+  const SAMPLE_PIPE_Stage_t *stage = Pipe->Stages;
+  const SAMPLE_PIPE_Stage_t *end = &Pipe->Stages[Pipe->Count];
+
+  for (; stage < end; stage++)
+  {
+    stage->Run(stage->Source, stage->Sink);
+  }
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
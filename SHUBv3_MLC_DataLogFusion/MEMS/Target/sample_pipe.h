@@ -0,0 +1,87 @@
+/**
+  ******************************************************************************
+  * @file    sample_pipe.h
+  * @author  ISCA Lab
+  * @brief   Stage list run once per stream sample
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SAMPLE_PIPE_H
+#define SAMPLE_PIPE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup SAMPLE_PIPE SAMPLE PIPE
+ * @{
+ */
+
+/*
+ * The stream configuration (enabled sensors, live or offline data, fusion
+ * format) only changes on a Unicleo command. The application turns it into
+ * a list of stages at that time: each stage is a function with its source
+ * (the value it reads or fills) and its sink (where it writes in the frame)
+ * bound. A sample then runs the list without testing the configuration
+ * again, and its cost only depends on the stages that are in it.
+ *
+ * The module has no hardware dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#ifndef SAMPLE_PIPE_MAX_STAGES
+#define SAMPLE_PIPE_MAX_STAGES  12U
+#endif
+
+#define SAMPLE_PIPE_OK      0
+#define SAMPLE_PIPE_ERROR  -1
+
+/* Exported types ------------------------------------------------------------*/
+typedef void (*SAMPLE_PIPE_Fn_t)(void *Source, uint8_t *Sink);
+
+typedef struct
+{
+  SAMPLE_PIPE_Fn_t Run;
+  void *Source;
+  uint8_t *Sink;
+} SAMPLE_PIPE_Stage_t;
+
+typedef struct
+{
+  uint32_t Count;
+  SAMPLE_PIPE_Stage_t Stages[SAMPLE_PIPE_MAX_STAGES];
+} SAMPLE_PIPE_t;
+
+/* Exported functions --------------------------------------------------------*/
+void SAMPLE_PIPE_Reset(SAMPLE_PIPE_t *Pipe);
+int32_t SAMPLE_PIPE_Add(SAMPLE_PIPE_t *Pipe, SAMPLE_PIPE_Fn_t Run, void *Source, uint8_t *Sink);
+void SAMPLE_PIPE_Run(const SAMPLE_PIPE_t *Pipe);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_PIPE_H */
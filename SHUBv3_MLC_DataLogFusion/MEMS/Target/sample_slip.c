@@ -0,0 +1,232 @@
+/**
+  ******************************************************************************
+  * @file    sample_slip.c
+  * @author  ISCA Lab
+  * @brief   Duplicate and missed sample detection on the sensor timestamp
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "sample_slip.h"
+#include "mem_placement.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup SAMPLE_SLIP SAMPLE SLIP
+ * @{
+ */
+
+/* Private defines -----------------------------------------------------------*/
+#define TICKS_PER_DIV 6U  /* SAMPLE_SLIP_TS_HZ / SAMPLE_SLIP_BASE_HZ */
+
+/* Private function prototypes -----------------------------------------------*/
+static void Start(SAMPLE_SLIP_t *Slip, uint32_t Timestamp);
+static int32_t Slot(const SAMPLE_SLIP_t *Slip, uint32_t Timestamp, uint32_t Reference);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief  Sample period of an output data rate, in timestamp ticks
+ * @param  Odr the output data rate as set in the driver [Hz], e.g. 104
+ * @retval The period [ticks], 0 if the rate is out of range
+ */
+uint32_t SAMPLE_SLIP_Period(float Odr)
+{
+  uint32_t div = 1;
+
+  if ((Odr <= 0.0f) || (Odr > (1.5f * (float)SAMPLE_SLIP_BASE_HZ)))
+  {
+    return 0;
+  }
+
+  /* Nearest divider on a log scale: 104 Hz is 6667 / 64 */
+  while (((float)SAMPLE_SLIP_BASE_HZ / (float)div) > (1.41421356f * Odr))
+  {
+    div *= 2U;
+    if (div > SAMPLE_SLIP_MAX_DIV)
+    {
+      return 0;
+    }
+  }
+
+  return TICKS_PER_DIV * div;
+}
+
+/**
+ * @brief  Initialize the detector
+ * @param  Slip the detector
+ * @param  Period the sample period [ticks], see SAMPLE_SLIP_Period
+ * @retval SAMPLE_SLIP_OK, SAMPLE_SLIP_ERROR if the period is out of range
+ */
+int32_t SAMPLE_SLIP_Init(SAMPLE_SLIP_t *Slip, uint32_t Period)
+{
+  if ((Period == 0U) || (Period > (TICKS_PER_DIV * SAMPLE_SLIP_MAX_DIV)))
+  {
+    return SAMPLE_SLIP_ERROR;
+  }
+
+  Slip->Period = Period;
+  Slip->Reads = 0;
+  Slip->Duplicates = 0;
+  Slip->Missed = 0;
+  Slip->Slips = 0;
+  Slip->Restarts = 0;
+  Slip->Torn = 0;
+  SAMPLE_SLIP_Reset(Slip);
+
+  return SAMPLE_SLIP_OK;
+}
+
+/**
+ * @brief  Restart the tracking on the next read, the counters are kept
+ * @note   Call when the reads stop and start again (stream stopped)
+ * @param  Slip the detector
+ * @retval None
+ */
+void SAMPLE_SLIP_Reset(SAMPLE_SLIP_t *Slip)
+{
+  Slip->Started = 0;
+}
+
+/**
+ * @brief  Classify a read by the sensor timestamp taken with it
+ * @param  Slip the detector
+ * @param  Timestamp the sensor timestamp of the read [ticks]
+ * @retval Sample periods since the previous read: 0 for a duplicate, 1 for
+ *         the next sample, n > 1 when n - 1 samples were missed. The first
+ *         read and a restart return 1.
+ */
+RAM_FUNC uint32_t SAMPLE_SLIP_Check(SAMPLE_SLIP_t *Slip, uint32_t Timestamp)
+{
+  const int32_t period = (int32_t)Slip->Period;
+  int32_t elapsed;
+  uint32_t n;
+
+  Slip->Reads++;
+
+  if (Slip->Started == 0U)
+  {
+    Start(Slip, Timestamp);
+    return 1;
+  }
+
+  /* Time since the grid instant of the last sample read, the difference
+   * wraps with the 32-bit timestamp */
+  elapsed = (int32_t)(Timestamp - Slip->Grid);
+
+  if ((elapsed < -(period / 2)) || (elapsed >= (((int32_t)SAMPLE_SLIP_MAX_GAP * period) + (period / 2))))
+  {
+    Slip->Restarts++;
+    Start(Slip, Timestamp);
+    return 1;
+  }
+
+  n = (uint32_t)((elapsed + (period / 2)) / period);
+  Slip->Grid += n * Slip->Period;
+
+  if (n != 1U)
+  {
+    Slip->Slips++;
+    if (n == 0U)
+    {
+      Slip->Duplicates++;
+    }
+    else
+    {
+      Slip->Missed += n - 1U;
+    }
+  }
+
+  return n;
+}
+
+/**
+ * @brief  Classify a read without taking it
+ * @note   For a read that may be dropped: SAMPLE_SLIP_Check is called once
+ *         the read is kept.
+ * @param  Slip the detector
+ * @param  Timestamp the sensor timestamp of the read [ticks]
+ * @retval What SAMPLE_SLIP_Check would return
+ */
+uint32_t SAMPLE_SLIP_Peek(const SAMPLE_SLIP_t *Slip, uint32_t Timestamp)
+{
+  const int32_t period = (int32_t)Slip->Period;
+  int32_t elapsed = (int32_t)(Timestamp - Slip->Grid);
+
+  if ((Slip->Started == 0U) || (elapsed < -(period / 2))
+      || (elapsed >= (((int32_t)SAMPLE_SLIP_MAX_GAP * period) + (period / 2))))
+  {
+    return 1;
+  }
+
+  return (uint32_t)((elapsed + (period / 2)) / period);
+}
+
+/**
+ * @brief  Check that no sample landed between two timestamps of a read
+ * @note   Before is taken ahead of the output registers, After behind them.
+ *         A torn read is counted, the caller drops it.
+ * @param  Slip the detector
+ * @param  Before the sensor timestamp before the output registers [ticks]
+ * @param  After the sensor timestamp after the output registers [ticks]
+ * @retval 1 if both are in the same sample period, 0 otherwise
+ */
+uint8_t SAMPLE_SLIP_Same(SAMPLE_SLIP_t *Slip, uint32_t Before, uint32_t After)
+{
+  /* The first read starts the grid at its own timestamp */
+  uint32_t reference = (Slip->Started != 0U) ? Slip->Grid : Before;
+
+  if (Slot(Slip, Before, reference) != Slot(Slip, After, reference))
+  {
+    Slip->Torn++;
+    return 0;
+  }
+
+  return 1;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief  Take a read as the reference of the tracking
+ * @param  Slip the detector
+ * @param  Timestamp the sensor timestamp of the read [ticks]
+ * @retval None
+ */
+static void Start(SAMPLE_SLIP_t *Slip, uint32_t Timestamp)
+{
+  Slip->Grid = Timestamp;
+  Slip->Started = 1;
+}
+
+/**
+ * @brief  Grid period a timestamp falls in
+ * @param  Slip the detector
+ * @param  Timestamp the sensor timestamp [ticks]
+ * @param  Reference the grid instant of period 0 [ticks]
+ * @retval The period, rounded to the nearest grid instant as in
+ *         SAMPLE_SLIP_Check
+ */
+static int32_t Slot(const SAMPLE_SLIP_t *Slip, uint32_t Timestamp, uint32_t Reference)
+{
+  const int32_t period = (int32_t)Slip->Period;
+  int32_t elapsed = (int32_t)(Timestamp - Reference) + (period / 2);
+
+  /* Floor division, the timestamp may be ahead of the reference */
+  return (elapsed >= 0) ? (elapsed / period) : (((elapsed + 1) / period) - 1);
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
@@ -0,0 +1,114 @@
+/**
+  ******************************************************************************
+  * @file    sample_slip.h
+  * @author  ISCA Lab
+  * @brief   Duplicate and missed sample detection on the sensor timestamp
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef SAMPLE_SLIP_H
+#define SAMPLE_SLIP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup SAMPLE_SLIP SAMPLE SLIP
+ * @{
+ */
+
+/*
+ * The LSM6DSOX timestamp counts at 40 kHz and its output data rates are
+ * 6667 Hz divided by a power of two, both from the same oscillator: a
+ * sample period is exactly 6 * divider timestamp ticks (384 at 104 Hz),
+ * whatever the oscillator trim.
+ *
+ * Each read takes the timestamp and SAMPLE_SLIP_Check rounds the time since
+ * the previous read to sample periods: 0 is a duplicate (the same sample
+ * read again), 1 the next sample, n > 1 means n - 1 samples were missed.
+ * The sample instants are a fixed grid of periods from the first read, so
+ * the rounding is centred on the latency of that read and the others may
+ * jitter by up to half a period around it. A read more than
+ * SAMPLE_SLIP_MAX_GAP periods after the previous one restarts the grid.
+ *
+ * With data-ready driven reads the latency is short and steady and every
+ * slip is seen on the read where it happens.
+ *
+ * The timestamp and the output registers are read one after the other, so a
+ * sample may land between the two. Reading the timestamp again after the
+ * output registers tells: SAMPLE_SLIP_Same finds both timestamps in the same
+ * period of the grid, or counts a torn read. The periods are centred on the
+ * reads and a new sample lands the read latency before the next grid
+ * instant, past the middle of the period: a read whose second timestamp
+ * stays in the period has the sample of the first. A torn read is dropped
+ * rather than read again, a new read that late could hold either sample,
+ * the next data-ready read takes the next sample. Reads on a free-running timer
+ * sweep the whole period instead: the counts stay right over time, a slip
+ * may be reported one read late or early.
+ *
+ * The module has no hardware dependency and builds on a host.
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+#define SAMPLE_SLIP_OK      0
+#define SAMPLE_SLIP_ERROR  -1
+
+#define SAMPLE_SLIP_TS_HZ       40000U  /* Timestamp rate, 25 us */
+#define SAMPLE_SLIP_BASE_HZ     6667U   /* Highest output data rate */
+#define SAMPLE_SLIP_MAX_DIV     4096U   /* 1.6 Hz */
+
+/* Longest gap between two reads still counted as missed samples [periods] */
+#ifndef SAMPLE_SLIP_MAX_GAP
+#define SAMPLE_SLIP_MAX_GAP  64U
+#endif
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint32_t Period;      /* Sample period [ticks] */
+  uint32_t Grid;        /* Expected timestamp of the last sample read [ticks] */
+  uint8_t Started;
+  uint32_t Reads;
+  uint32_t Duplicates;  /* Reads of a sample already read */
+  uint32_t Missed;      /* Samples never read */
+  uint32_t Slips;       /* Reads with a duplicate or missed samples */
+  uint32_t Restarts;    /* Gaps longer than SAMPLE_SLIP_MAX_GAP */
+  uint32_t Torn;        /* Reads a new sample landed in */
+} SAMPLE_SLIP_t;
+
+/* Exported functions --------------------------------------------------------*/
+uint32_t SAMPLE_SLIP_Period(float Odr);
+int32_t SAMPLE_SLIP_Init(SAMPLE_SLIP_t *Slip, uint32_t Period);
+void SAMPLE_SLIP_Reset(SAMPLE_SLIP_t *Slip);
+uint32_t SAMPLE_SLIP_Check(SAMPLE_SLIP_t *Slip, uint32_t Timestamp);
+uint32_t SAMPLE_SLIP_Peek(const SAMPLE_SLIP_t *Slip, uint32_t Timestamp);
+uint8_t SAMPLE_SLIP_Same(SAMPLE_SLIP_t *Slip, uint32_t Before, uint32_t After);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SAMPLE_SLIP_H */
@@ -38,6 +38,8 @@ extern "C" {
 #define CMD_Offline_Data               0x10 /* Offline data stream */
 #define CMD_Use_Offline_Data           0x11 /* From Msg->Data[3]: uint8_t UseOfflineData (1 ON, 0 OFF) */
 #define CMD_Get_App_Info               0x12 /* From Msg->Data[3]: int AlgoFreq; uint8_t RequiredData; */
+#define CMD_Stream_Format              0x13 /* From Msg->Data[3]: uint8_t Format; optional uint8_t AngleFrac, AccFrac */
+#define CMD_Stream_Subscribe           0x14 /* From Msg->Data[3]: uint16_t Fields (STREAM_FIELD_*), 0 for all */
 
 #define CMD_Set_DateTime               0x0C
 #define CMD_Enter_DFU_Mode             0x0E
@@ -19,6 +19,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include <string.h>
 #include "serial_protocol.h"
+#include "mem_placement.h"
 
 /** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
  * @{
@@ -37,7 +38,7 @@
  * @param  Source source
  * @retval Total number of bytes processed
  */
-int ByteStuffCopyByte(uint8_t *Dest, uint8_t Source)
+RAM_FUNC int ByteStuffCopyByte(uint8_t *Dest, uint8_t Source)
 {
   int ret = 2;
 
@@ -68,7 +69,7 @@ int ByteStuffCopyByte(uint8_t *Dest, uint8_t Source)
  * @param  Source source
  * @retval Total number of bytes processed
  */
-int ByteStuffCopy(uint8_t *Dest, TMsg *Source)
+RAM_FUNC int ByteStuffCopy(uint8_t *Dest, TMsg *Source)
 {
   uint32_t i;
   int32_t count = 0;
@@ -211,7 +212,7 @@ int ReverseByteStuffCopy(TMsg *Dest, uint8_t *Source)
  * @param  Msg pointer to the message
  * @retval None
  */
-void CHK_ComputeAndAdd(TMsg *Msg)
+RAM_FUNC void CHK_ComputeAndAdd(TMsg *Msg)
 {
   uint8_t chk = 0;
   uint32_t i;
@@ -289,7 +290,7 @@ uint32_t Deserialize(uint8_t *Source, uint32_t Len)
  * @param  Len number of bytes
  * @retval None
  */
-void Serialize_s32(uint8_t *Dest, int32_t Source, uint32_t Len)
+RAM_FUNC void Serialize_s32(uint8_t *Dest, int32_t Source, uint32_t Len)
 {
   uint32_t i;
   uint32_t source_uint32;
@@ -0,0 +1,201 @@
+/**
+  ******************************************************************************
+  * @file    stream_plan.c
+  * @author  ISCA Lab
+  * @brief   Serialization plan of the subscribed stream fields
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "stream_plan.h"
+#include "fusion_codec.h"
+#include "mem_placement.h"
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup STREAM_PLAN STREAM PLAN
+ * @{
+ */
+
+/* Private types -------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t Offset;
+  uint8_t Size;
+} STREAM_PLAN_Field_t;
+
+/* Private defines -----------------------------------------------------------*/
+#define TIME_END    7U  /* Header and time of day */
+#define FX_OFFSET   55U /* STREAMING_FX_OFFSET */
+
+/* Private variables ---------------------------------------------------------*/
+/* Full frame written by the handlers of app_mems.c, in field bit order */
+static const STREAM_PLAN_Field_t FloatLayout[STREAM_FIELD_COUNT] =
+{
+  {   7U, 12U }, /* ENV */
+  {  19U, 12U }, /* ACC */
+  {  31U, 12U }, /* GYR */
+  {  43U, 12U }, /* MAG */
+  {  55U, 16U }, /* QUAT */
+  {  71U, 12U }, /* ROT */
+  {  83U, 12U }, /* GRAV */
+  {  95U, 12U }, /* LINACC */
+  { 107U,  8U }, /* HEADING */
+  { 115U,  4U }, /* TIMING */
+  { 119U,  2U }, /* MLC */
+};
+
+/* Same with the compact fusion block at FX_OFFSET, see fusion_codec.h */
+static const STREAM_PLAN_Field_t CompactLayout[STREAM_FIELD_COUNT] =
+{
+  {   7U, 12U },
+  {  19U, 12U },
+  {  31U, 12U },
+  {  43U, 12U },
+  { FX_OFFSET,       7U },
+  { FX_OFFSET + 7U,  6U },
+  { FX_OFFSET + 13U, 6U },
+  { FX_OFFSET + 19U, 6U },
+  { FX_OFFSET + 25U, 4U },
+  { FX_OFFSET + FUSION_CODEC_SIZE, 4U },
+  { FX_OFFSET + FUSION_CODEC_SIZE + 4U, 2U },
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static void AddOp(STREAM_PLAN_t *Plan, uint32_t Src, uint32_t Dst, uint32_t Len);
+
+/* Exported functions --------------------------------------------------------*/
+/**
+ * @brief  Build the plan of a subscription
+ * @param  Fields the STREAM_FIELD_* mask, 0 for the full frame
+ * @param  Format the fusion format of the full frame
+ * @param  Plan the plan
+ * @retval STREAM_PLAN_OK, STREAM_PLAN_ERROR on an unknown field or format
+ */
+int32_t STREAM_PLAN_Build(uint16_t Fields, uint8_t Format, STREAM_PLAN_t *Plan)
+{
+  const STREAM_PLAN_Field_t *layout;
+  uint32_t dst = STREAM_PLAN_HEADER;
+  uint32_t i;
+
+  if (((Fields & ~STREAM_FIELD_ALL) != 0U) || (Format > (uint8_t)FUSION_CODEC_FIXED))
+  {
+    return STREAM_PLAN_ERROR;
+  }
+
+  layout = (Format == (uint8_t)FUSION_CODEC_FLOAT) ? FloatLayout : CompactLayout;
+
+  Plan->Fields = Fields;
+  Plan->Count = 0;
+  Plan->Len = 0;
+
+  if (Fields == 0U)
+  {
+    return STREAM_PLAN_OK;
+  }
+
+  AddOp(Plan, 0U, 0U, TIME_END);
+
+  for (i = 0; i < STREAM_FIELD_COUNT; i++)
+  {
+    if ((Fields & (1UL << i)) != 0U)
+    {
+      AddOp(Plan, layout[i].Offset, dst, layout[i].Size);
+      dst += layout[i].Size;
+    }
+  }
+
+  Plan->Len = (uint8_t)dst;
+
+  return STREAM_PLAN_OK;
+}
+
+/**
+ * @brief  Build the subscribed frame from the full frame
+ * @param  Plan the plan, with Fields not 0
+ * @param  Frame the full frame
+ * @param  Out the subscribed frame, Plan->Len bytes
+ * @retval None
+ */
+RAM_FUNC void STREAM_PLAN_Run(const STREAM_PLAN_t *Plan, const uint8_t *Frame, uint8_t *Out)
+{
+  const STREAM_PLAN_Op_t *op = Plan->Ops;
+  const STREAM_PLAN_Op_t *end = &Plan->Ops[Plan->Count];
+
+  for (; op < end; op++)
+  {
+    (void)memcpy(&Out[op->Dst], &Frame[op->Src], op->Len);
+  }
+
+  Out[TIME_END] = (uint8_t)Plan->Fields;
+  Out[TIME_END + 1U] = (uint8_t)(Plan->Fields >> 8);
+}
+
+/**
+ * @brief  Size of one field in the frame
+ * @param  Field one STREAM_FIELD_* bit
+ * @param  Format the fusion format
+ * @retval The size, 0 for an unknown field
+ */
+uint32_t STREAM_PLAN_FieldSize(uint16_t Field, uint8_t Format)
+{
+  const STREAM_PLAN_Field_t *layout = (Format == (uint8_t)FUSION_CODEC_FLOAT) ? FloatLayout : CompactLayout;
+  uint32_t i;
+
+  for (i = 0; i < STREAM_FIELD_COUNT; i++)
+  {
+    if (Field == (1UL << i))
+    {
+      return layout[i].Size;
+    }
+  }
+
+  return 0;
+}
+
+/* Private functions ---------------------------------------------------------*/
+/**
+ * @brief  Append a copy, merged with the previous one when both are contiguous
+ * @param  Plan the plan
+ * @param  Src the offset in the full frame
+ * @param  Dst the offset in the subscribed frame
+ * @param  Len the length
+ * @retval None
+ */
+static void AddOp(STREAM_PLAN_t *Plan, uint32_t Src, uint32_t Dst, uint32_t Len)
+{
+  STREAM_PLAN_Op_t *last;
+
+  if (Plan->Count > 0U)
+  {
+    last = &Plan->Ops[Plan->Count - 1U];
+    if ((((uint32_t)last->Src + last->Len) == Src) && (((uint32_t)last->Dst + last->Len) == Dst))
+    {
+      last->Len = (uint8_t)(last->Len + Len);
+      return;
+    }
+  }
+
+  Plan->Ops[Plan->Count].Src = (uint8_t)Src;
+  Plan->Ops[Plan->Count].Dst = (uint8_t)Dst;
+  Plan->Ops[Plan->Count].Len = (uint8_t)Len;
+  Plan->Count++;
+}
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
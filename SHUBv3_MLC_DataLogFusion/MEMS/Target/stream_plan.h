@@ -0,0 +1,106 @@
+/**
+  ******************************************************************************
+  * @file    stream_plan.h
+  * @author  ISCA Lab
+  * @brief   Serialization plan of the subscribed stream fields
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef STREAM_PLAN_H
+#define STREAM_PLAN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/** @addtogroup MOTION_APPLICATIONS MOTION APPLICATIONS
+ * @{
+ */
+
+/** @addtogroup STREAM_PLAN STREAM PLAN
+ * @{
+ */
+
+/* Exported defines ----------------------------------------------------------*/
+/*
+ * The handlers fill the full streaming frame (Unicleo float layout, or the
+ * compact fusion block of fusion_codec.h). With a subscription, the frame
+ * sent is built from it by a plan of copy operations, computed once when
+ * the subscription or the fusion format changes. Fields that sit next to
+ * each other in both frames are copied by one operation.
+ *
+ * Subscribed frame:
+ *   [0..1]   destination, source
+ *   [2]      CMD_Stream_Subscribe, tells the host it is not a Unicleo frame
+ *   [3..6]   time of day, as the Unicleo frame
+ *   [7..8]   subscribed fields, little endian
+ *   [9..]    the subscribed fields, in bit order, same encoding as in the
+ *            full frame
+ * As for the full frame, the fusion format is given by the CMD_Stream_Format
+ * reply, see fusion_codec.h.
+ */
+#define STREAM_FIELD_ENV      0x0001U /* Pressure, temperature, humidity */
+#define STREAM_FIELD_ACC      0x0002U
+#define STREAM_FIELD_GYR      0x0004U
+#define STREAM_FIELD_MAG      0x0008U
+#define STREAM_FIELD_QUAT     0x0010U
+#define STREAM_FIELD_ROT      0x0020U
+#define STREAM_FIELD_GRAV     0x0040U
+#define STREAM_FIELD_LINACC   0x0080U
+#define STREAM_FIELD_HEADING  0x0100U /* Heading and heading error */
+#define STREAM_FIELD_TIMING   0x0200U /* Fusion run time */
+#define STREAM_FIELD_MLC      0x0400U /* MLC0_SRC and event counter */
+#define STREAM_FIELD_ALL      0x07FFU
+#define STREAM_FIELD_COUNT    11U
+
+#define STREAM_PLAN_HEADER    9U  /* Bytes before the first field */
+#define STREAM_PLAN_MAX_OPS   (1U + STREAM_FIELD_COUNT)
+
+#define STREAM_PLAN_OK         0
+#define STREAM_PLAN_ERROR     -1
+
+/* Exported types ------------------------------------------------------------*/
+typedef struct
+{
+  uint8_t Src; /* Offset in the full frame */
+  uint8_t Dst; /* Offset in the subscribed frame */
+  uint8_t Len;
+} STREAM_PLAN_Op_t;
+
+typedef struct
+{
+  uint16_t Fields;  /* 0: no subscription, the full frame is sent */
+  uint8_t Len;      /* Subscribed frame length */
+  uint8_t Count;
+  STREAM_PLAN_Op_t Ops[STREAM_PLAN_MAX_OPS];
+} STREAM_PLAN_t;
+
+/* Exported functions --------------------------------------------------------*/
+int32_t STREAM_PLAN_Build(uint16_t Fields, uint8_t Format, STREAM_PLAN_t *Plan);
+void STREAM_PLAN_Run(const STREAM_PLAN_t *Plan, const uint8_t *Frame, uint8_t *Out);
+uint32_t STREAM_PLAN_FieldSize(uint16_t Field, uint8_t Format);
+
+/**
+ * @}
+ */
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STREAM_PLAN_H */
@@ -0,0 +1,368 @@
+/**
+  ******************************************************************************
+  * @file    bus_arb_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the bus arbiter with simulated interrupt preemption
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "bus_arbiter.h"
+
+/*
+ * Runs the firmware bus_arbiter.c on a host. The port gives the arbiter a
+ * context number the check sets by hand: 0 is thread mode, 1 and up are
+ * interrupt levels. An interrupt is a plain call made with the context
+ * raised, in the middle of what the interrupted context was doing, the way
+ * an exception preempts on the target.
+ *
+ * The bus is a counter of the sequences running on it. Two sequences must
+ * never hold it at the same time, which is what the arbiter is for: a bank
+ * switch, the access and the switch back stay together.
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static uint32_t Now;       /* Fake time, one tick per clock read */
+static uint32_t Context;   /* Running context, 0 thread mode */
+static uint32_t Masked;    /* Lock depth */
+static uint32_t OnBus;     /* Sequences on the bus */
+static uint32_t Overlaps;  /* Sequences that found the bus in use */
+
+static uint32_t PortClock(void)
+{
+  return Now++;
+}
+
+static uint32_t PortContext(void)
+{
+  return Context;
+}
+
+static uint32_t PortLock(void)
+{
+  return Masked++;
+}
+
+static void PortUnlock(uint32_t State)
+{
+  Masked = State;
+}
+
+static const BUS_ARB_Port_t Port = { PortClock, PortContext, PortLock, PortUnlock };
+
+struct Job
+{
+  BUS_ARB_Request_t Req;
+  std::vector<uint32_t> *Log;  /* Completion order */
+  uint32_t Id;
+  int32_t Status;
+  uint32_t Done;
+};
+
+/**
+  * @brief  A sequence: takes the bus, checks nobody else holds it
+  * @param  Ctx the job
+  * @retval The job id
+  */
+static int32_t Sequence(void *Ctx)
+{
+  Job *job = static_cast<Job *>(Ctx);
+
+  if (OnBus != 0U)
+  {
+    Overlaps++;
+  }
+  OnBus++;
+  Now += 3U;
+  OnBus--;
+  return (int32_t)job->Id;
+}
+
+/**
+  * @brief  Completion callback of a job
+  * @param  Ctx the job
+  * @param  Status the sequence status
+  * @retval None
+  */
+static void Done(void *Ctx, int32_t Status)
+{
+  Job *job = static_cast<Job *>(Ctx);
+
+  job->Status = Status;
+  job->Done++;
+  if (job->Log != nullptr)
+  {
+    job->Log->push_back(job->Id);
+  }
+}
+
+/**
+  * @brief  Prepare a job
+  * @param  J the job
+  * @param  Id its id
+  * @param  Client the client
+  * @param  Priority the priority, 0 highest
+  * @param  Log the completion log, may be null
+  * @retval None
+  */
+static void Prepare(Job &J, uint32_t Id, uint8_t Client, uint8_t Priority, std::vector<uint32_t> *Log)
+{
+  J = Job();
+  J.Req.Sequence = Sequence;
+  J.Req.Done = Done;
+  J.Req.Context = &J;
+  J.Req.Client = Client;
+  J.Req.Priority = Priority;
+  J.Log = Log;
+  J.Id = Id;
+  J.Status = -100;
+}
+
+/**
+  * @brief  Print a check
+  * @param  Name the check
+  * @param  Ok the outcome
+  * @retval The outcome
+  */
+static bool Report(const char *Name, bool Ok)
+{
+  std::printf("%-34s %s\n", Name, Ok ? "ok" : "FAILED");
+  return Ok;
+}
+
+/**
+  * @brief  Random thread mode work preempted by random interrupts
+  * @param  Seed the random seed
+  * @param  Steps the number of thread mode steps
+  * @param  Submitted the requests submitted
+  * @param  Completed the requests completed
+  * @retval true if every invariant held
+  */
+static bool Stress(uint32_t Seed, uint32_t Steps, uint64_t &Submitted, uint64_t &Completed)
+{
+  std::mt19937 rng(Seed);
+  BUS_ARB_t arb;
+  Job jobs[8];
+  bool ok = true;
+  uint32_t depth = 0;
+
+  BUS_ARB_Init(&arb, &Port);
+  for (uint32_t i = 0; i < 8U; i++)
+  {
+    Prepare(jobs[i], i, (uint8_t)(1U + (i % 3U)), (uint8_t)(rng() % 3U), nullptr);
+  }
+
+  for (uint32_t s = 0; s < Steps; s++)
+  {
+    uint32_t op = rng() % 8U;
+
+    Context = 0;
+    if ((op < 3U) && (depth < 4U))
+    {
+      /* Thread mode takes the bus, or nests in its own hold */
+      ok &= (BUS_ARB_Acquire(&arb, 0U) == BUS_ARB_OK);
+      depth++;
+      ok &= (arb.Depth == depth) && (arb.OwnerContext == 0U);
+    }
+    else if ((op < 6U) && (depth > 0U))
+    {
+      BUS_ARB_Release(&arb);
+      depth--;
+      ok &= ((depth == 0U) == (arb.Busy == 0U));
+      /* The outermost release drains the queue */
+      ok &= (depth != 0U) || (arb.Queue == nullptr);
+    }
+    else
+    {
+      /* An interrupt at level 1 or 2 */
+      Job &job = jobs[rng() % 8U];
+      bool pending = (job.Req.Pending != 0U);
+      uint32_t before = job.Done;
+      int32_t ret;
+
+      Context = 1U + (rng() % 2U);
+      if ((rng() % 2U) == 0U)
+      {
+        ret = BUS_ARB_Acquire(&arb, job.Req.Client);
+        if (depth != 0U)
+        {
+          ok &= (ret == BUS_ARB_BUSY);
+        }
+        else
+        {
+          ok &= (ret == BUS_ARB_OK);
+          BUS_ARB_Release(&arb);
+        }
+      }
+      else
+      {
+        ret = BUS_ARB_Submit(&arb, &job.Req);
+        if (pending)
+        {
+          ok &= (ret == BUS_ARB_BUSY);
+        }
+        else if (depth != 0U)
+        {
+          ok &= (ret == BUS_ARB_QUEUED) && (job.Done == before);
+          Submitted++;
+        }
+        else
+        {
+          ok &= (ret == BUS_ARB_OK) && (job.Done == (before + 1U)) && (job.Status == (int32_t)job.Id);
+          Submitted++;
+        }
+      }
+      ok &= (depth != 0U) || (arb.Busy == 0U);
+    }
+    ok &= (Masked == 0U);
+  }
+
+  Context = 0;
+  while (depth > 0U)
+  {
+    BUS_ARB_Release(&arb);
+    depth--;
+  }
+  for (const Job &j : jobs)
+  {
+    ok &= (j.Req.Pending == 0U);
+    Completed += j.Done;
+  }
+  return ok && (arb.Busy == 0U) && (arb.Queue == nullptr);
+}
+
+int main()
+{
+  bool ok = true;
+  BUS_ARB_t arb;
+  BUS_ARB_Stats_t stats;
+  Job a, b, c, d;
+  std::vector<uint32_t> log;
+
+  /* Before BUS_ARB_Init a bus primitive may already be called */
+  BUS_ARB_t cold = {};
+  Prepare(a, 1U, 0U, 0U, nullptr);
+  BUS_ARB_Release(&cold);
+  ok &= Report("no port: rejected",
+               (BUS_ARB_Acquire(&cold, 0U) == BUS_ARB_ERROR) && (BUS_ARB_Submit(&cold, &a.Req) == BUS_ARB_ERROR)
+               && (BUS_ARB_GetStats(&cold, 0U, &stats) == BUS_ARB_ERROR) && (a.Done == 0U));
+
+  BUS_ARB_Init(&arb, &Port);
+  ok &= Report("invalid client: rejected",
+               (BUS_ARB_Acquire(&arb, BUS_ARB_MAX_CLIENTS) == BUS_ARB_ERROR)
+               && (BUS_ARB_GetStats(&arb, BUS_ARB_MAX_CLIENTS, &stats) == BUS_ARB_ERROR));
+
+  /* The owner nests, the bus frees on the outermost release */
+  Context = 0;
+  bool nest = (BUS_ARB_Acquire(&arb, 0U) == BUS_ARB_OK) && (BUS_ARB_Acquire(&arb, 1U) == BUS_ARB_OK)
+              && (arb.Depth == 2U) && (arb.Owner == 0U);
+  BUS_ARB_Release(&arb);
+  nest &= (arb.Busy == 1U) && (arb.Depth == 1U);
+  BUS_ARB_Release(&arb);
+  nest &= (arb.Busy == 0U);
+  BUS_ARB_Release(&arb);  /* Unbalanced, ignored */
+  nest &= (arb.Busy == 0U);
+  ok &= Report("nesting", nest);
+
+  /* An interrupt preempting the owner is refused, not made to wait */
+  (void)BUS_ARB_Acquire(&arb, 0U);
+  Context = 1;
+  bool preempt = (BUS_ARB_Acquire(&arb, 2U) == BUS_ARB_BUSY);
+  Context = 0;
+  BUS_ARB_Release(&arb);
+  Context = 1;
+  preempt &= (BUS_ARB_Acquire(&arb, 2U) == BUS_ARB_OK);
+  BUS_ARB_Release(&arb);
+  Context = 0;
+  ok &= Report("preemption: busy", preempt && (arb.Busy == 0U));
+
+  /* Queued requests run on the outermost release, by priority, FIFO within
+   * a priority, in the owner context */
+  Prepare(a, 1U, 1U, 2U, &log);
+  Prepare(b, 2U, 2U, 0U, &log);
+  Prepare(c, 3U, 3U, 2U, &log);
+  Prepare(d, 4U, 2U, 0U, &log);
+  (void)BUS_ARB_Acquire(&arb, 0U);
+  (void)BUS_ARB_Acquire(&arb, 0U);
+  Context = 1;
+  bool queue = (BUS_ARB_Submit(&arb, &a.Req) == BUS_ARB_QUEUED) && (BUS_ARB_Submit(&arb, &b.Req) == BUS_ARB_QUEUED);
+  Context = 2;
+  queue &= (BUS_ARB_Submit(&arb, &c.Req) == BUS_ARB_QUEUED) && (BUS_ARB_Submit(&arb, &d.Req) == BUS_ARB_QUEUED)
+           && (BUS_ARB_Submit(&arb, &a.Req) == BUS_ARB_BUSY);
+  Context = 0;
+  BUS_ARB_Release(&arb);
+  queue &= log.empty();
+  BUS_ARB_Release(&arb);
+  queue &= (log == std::vector<uint32_t>({ 2U, 4U, 1U, 3U })) && (a.Status == 1) && (d.Status == 4)
+           && (a.Req.Pending == 0U) && (arb.Busy == 0U) && (Overlaps == 0U);
+  ok &= Report("queued submit: priority, FIFO", queue);
+
+  /* A free bus runs the request at once */
+  log.clear();
+  Context = 1;
+  bool direct = (BUS_ARB_Submit(&arb, &a.Req) == BUS_ARB_OK) && (log == std::vector<uint32_t>({ 1U }));
+  Context = 0;
+  ok &= Report("free bus submit: run now", direct && (arb.Busy == 0U));
+
+  /* Counters: client 2 was refused once and queued twice */
+  (void)BUS_ARB_GetStats(&arb, 2U, &stats);
+  bool counters = (stats.Busy == 1U) && (stats.Queued == 2U) && (stats.Acquired == 3U) && (stats.MaxWait != 0U)
+                  && (stats.TotalWait >= stats.MaxWait);
+  (void)BUS_ARB_GetStats(&arb, 0U, &stats);
+  counters &= (stats.MaxHold != 0U);
+  ok &= Report("statistics", counters);
+
+  /* The cycle counter runs free, a hold across its wrap is still short */
+  BUS_ARB_t wrap;
+  BUS_ARB_Init(&wrap, &Port);
+  Now = 0xFFFFFFF0U;
+  (void)BUS_ARB_Acquire(&wrap, 0U);
+  Now += 32U;
+  BUS_ARB_Release(&wrap);
+  (void)BUS_ARB_GetStats(&wrap, 0U, &stats);
+  ok &= Report("clock wrap", (stats.MaxHold >= 32U) && (stats.MaxHold < 64U));
+
+  /* Random preemption */
+  uint64_t submitted = 0, completed = 0;
+  bool stress = true;
+  for (uint32_t seed = 1; seed <= 200U; seed++)
+  {
+    stress &= Stress(seed, 10000U, submitted, completed);
+  }
+  stress &= (submitted == completed) && (Overlaps == 0U);
+  std::printf("random preemption: %llu requests, %llu completed, %lu overlaps\n",
+              (unsigned long long)submitted, (unsigned long long)completed, (unsigned long)Overlaps);
+  ok &= Report("random preemption", stress);
+
+  /* Cost of an uncontended acquire and release */
+  double best = 1e9;
+  for (int run = 0; run < 5; run++)
+  {
+    BenchClock::time_point t0 = BenchClock::now();
+    for (uint32_t i = 0; i < 1000000U; i++)
+    {
+      (void)BUS_ARB_Acquire(&arb, 0U);
+      BUS_ARB_Release(&arb);
+    }
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    best = std::fmin(best, ns / 1000000.0);
+  }
+  std::printf("acquire + release  %.1f ns\n", best);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,672 @@
+/**
+  ******************************************************************************
+  * @file    fx_mahony_check.cpp
+  * @author  ISCA Lab
+  * @brief   Accuracy and speed of the fixed-point Mahony fusion on a host
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "fx_mahony.h"
+#include "rec_reader.hpp"
+
+/*
+ * Runs the firmware fx_mahony.c on a host:
+ *  - FX_MAHONY_Atan2 against atan2 on a grid of both signs and scales,
+ *  - FX_MAHONY_Quiet against the norm in double, and FX_MAHONY_GetOutput
+ *    asked for each subset of the outputs against all of them,
+ *  - a synthetic dataset with a known orientation: smooth rotations up to
+ *    a few hundred dps, linear acceleration bursts, gyroscope bias and
+ *    sensor noise, both quantized as the firmware gets them. The tilt of
+ *    the fixed-point engine and of the same filter in double precision are
+ *    compared with the truth, and with each other,
+ *  - with a recording (.rec from tmsg2rec, acc, gyr and fusion groups), the
+ *    recorded samples are replayed and the tilt compared with the MotionFX
+ *    outputs recorded next to them,
+ *  - the host time per sample of both, and the state size.
+ */
+
+static const uint32_t kPeriodUs = 10000U;
+static const double kDt = kPeriodUs * 1e-6;
+static const double kPi = 3.14159265358979323846;
+static const double kDeg = 180.0 / kPi;
+
+struct Quat
+{
+  double W, X, Y, Z;
+};
+
+/**
+  * @brief  Quaternion product
+  * @retval A * B
+  */
+static Quat Mul(const Quat &A, const Quat &B)
+{
+  return { (A.W * B.W) - (A.X * B.X) - (A.Y * B.Y) - (A.Z * B.Z),
+           (A.W * B.X) + (A.X * B.W) + (A.Y * B.Z) - (A.Z * B.Y),
+           (A.W * B.Y) - (A.X * B.Z) + (A.Y * B.W) + (A.Z * B.X),
+           (A.W * B.Z) + (A.X * B.Y) - (A.Y * B.X) + (A.Z * B.W) };
+}
+
+/**
+  * @brief  Normalize a quaternion
+  * @retval The unit quaternion
+  */
+static Quat Unit(const Quat &Q)
+{
+  double n = std::sqrt((Q.W * Q.W) + (Q.X * Q.X) + (Q.Y * Q.Y) + (Q.Z * Q.Z));
+  return { Q.W / n, Q.X / n, Q.Y / n, Q.Z / n };
+}
+
+/**
+  * @brief  Gravity direction in the device frame of an orientation
+  * @param  Q the device to ENU rotation
+  * @param  V the unit vector
+  * @retval None
+  */
+static void Gravity(const Quat &Q, double V[3])
+{
+  V[0] = 2.0 * ((Q.X * Q.Z) - (Q.W * Q.Y));
+  V[1] = 2.0 * ((Q.W * Q.X) + (Q.Y * Q.Z));
+  V[2] = (Q.W * Q.W) - (Q.X * Q.X) - (Q.Y * Q.Y) + (Q.Z * Q.Z);
+}
+
+/**
+  * @brief  Angle between two directions
+  * @retval The angle [deg]
+  */
+static double AngleDeg(const double A[3], const double B[3])
+{
+  double c[3] = { (A[1] * B[2]) - (A[2] * B[1]), (A[2] * B[0]) - (A[0] * B[2]), (A[0] * B[1]) - (A[1] * B[0]) };
+  double s = std::sqrt((c[0] * c[0]) + (c[1] * c[1]) + (c[2] * c[2]));
+  return std::atan2(s, (A[0] * B[0]) + (A[1] * B[1]) + (A[2] * B[2])) * kDeg;
+}
+
+/*
+ * The same filter as fx_mahony.c in double precision: held correction,
+ * bias integral, alignment on the first accelerometer sample.
+ */
+struct Reference
+{
+  Quat Q = { 1.0, 0.0, 0.0, 0.0 };
+  double Corr[3] = { 0.0, 0.0, 0.0 };   /* [rad/s] */
+  double Bias[3] = { 0.0, 0.0, 0.0 };   /* [rad/s] */
+  double Kp = FX_MAHONY_KP / 65536.0;
+  double Ki = FX_MAHONY_KI / 65536.0;
+  bool Aligned = false;
+
+  void Propagate(const double Gyro[3])  /* [dps] */
+  {
+    double h[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+      h[i] = ((Gyro[i] / kDeg) + Corr[i] + Bias[i]) * kDt / 2.0;
+    }
+    Quat d = Mul(Q, { 0.0, h[0], h[1], h[2] });
+    Q = Unit({ Q.W + d.W, Q.X + d.X, Q.Y + d.Y, Q.Z + d.Z });
+  }
+
+  void Update(const double Acc[3])  /* [g] */
+  {
+    double n = std::sqrt((Acc[0] * Acc[0]) + (Acc[1] * Acc[1]) + (Acc[2] * Acc[2]));
+    double a[3];
+    double v[3];
+
+    if ((n == 0.0) || (Aligned && (std::fabs(n - 1.0) > (FX_MAHONY_ACC_TOL / 1000.0))))
+    {
+      Corr[0] = Corr[1] = Corr[2] = 0.0;
+      return;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+      a[i] = Acc[i] / n;
+    }
+    if (!Aligned)
+    {
+      Q = Unit({ 1.0 + a[2], a[1], -a[0], 0.0 });
+      Aligned = true;
+      return;
+    }
+
+    Gravity(Q, v);
+    double e[3] = { (a[1] * v[2]) - (a[2] * v[1]), (a[2] * v[0]) - (a[0] * v[2]), (a[0] * v[1]) - (a[1] * v[0]) };
+    for (int i = 0; i < 3; i++)
+    {
+      Corr[i] = Kp * e[i];
+      Bias[i] += Ki * e[i] * kDt;
+    }
+  }
+};
+
+struct Stats
+{
+  std::vector<double> Values;
+
+  void Add(double V) { Values.push_back(V); }
+
+  double Rms() const
+  {
+    double s = 0.0;
+    for (double v : Values)
+    {
+      s += v * v;
+    }
+    return Values.empty() ? 0.0 : std::sqrt(s / Values.size());
+  }
+
+  double Pct(double P) const
+  {
+    std::vector<double> v = Values;
+    if (v.empty())
+    {
+      return 0.0;
+    }
+    size_t k = std::min(v.size() - 1U, static_cast<size_t>(P * v.size()));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+  }
+
+  double Max() const { return Values.empty() ? 0.0 : *std::max_element(Values.begin(), Values.end()); }
+};
+
+/**
+  * @brief  Print a line of statistics
+  * @retval None
+  */
+static void Print(const char *Name, const Stats &S)
+{
+  std::printf("  %-26s rms %7.3f  p95 %7.3f  max %7.3f deg\n", Name, S.Rms(), S.Pct(0.95), S.Max());
+}
+
+/**
+  * @brief  Tilt of the fixed-point engine
+  * @param  Eng the engine
+  * @param  V the unit gravity vector
+  * @retval None
+  */
+static void EngineGravity(const FX_MAHONY_t *Eng, double V[3])
+{
+  FX_MAHONY_Output_t out;
+  MEMS_FIXED_Axes_t acc = { 0, 0, 0 };
+
+  FX_MAHONY_GetOutput(Eng, &acc, FX_MAHONY_OUT_GRAV, &out);
+  for (int i = 0; i < 3; i++)
+  {
+    V[i] = out.Gravity[i] / static_cast<double>(FX_MAHONY_ONE);
+  }
+}
+
+/**
+  * @brief  Check the fixed-point arctangent
+  * @retval true if within 0.01 deg everywhere
+  */
+static bool CheckAtan2()
+{
+  double worst = 0.0;
+
+  for (int scale = 0; scale < 31; scale += 5)
+  {
+    for (int k = 0; k < 3600; k++)
+    {
+      double t = (k * 0.1 - 180.0) / kDeg;
+      double r = std::ldexp(1.0, scale) - 1.0;
+      int32_t y = static_cast<int32_t>(std::lround(r * std::sin(t)));
+      int32_t x = static_cast<int32_t>(std::lround(r * std::cos(t)));
+      if ((x == 0) && (y == 0))
+      {
+        continue;
+      }
+      double want = std::atan2(static_cast<double>(y), static_cast<double>(x)) * kDeg * 1000.0;
+      double got = FX_MAHONY_Atan2(y, x);
+      double err = std::fabs(got - want);
+      err = std::min(err, std::fabs(err - 360000.0));
+      worst = std::max(worst, err);
+    }
+  }
+
+  std::printf("atan2        worst %.2f mdeg  %s\n", worst, (worst <= 10.0) ? "ok" : "FAILED");
+  return worst <= 10.0;
+}
+
+/**
+  * @brief  Check the still sample test against the norm in double
+  * @retval true if both agree on every sample
+  */
+static bool CheckQuiet()
+{
+  const int32_t low = (1000 - FX_MAHONY_ACC_TOL) * MEMS_FIXED_ONE;
+  const int32_t high = (1000 + FX_MAHONY_ACC_TOL) * MEMS_FIXED_ONE;
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<int32_t> axis(-1300 * MEMS_FIXED_ONE, 1300 * MEMS_FIXED_ONE);
+  std::uniform_int_distribution<int32_t> near(-2, 2);
+  uint32_t samples = 0;
+  uint32_t quiet = 0;
+  uint32_t mismatches = 0;
+
+  for (uint32_t i = 0; i < 2000000U; i++)
+  {
+    MEMS_FIXED_Axes_t a;
+
+    if (i < 20U)
+    {
+      /* On the bounds and one LSB either side, along an axis */
+      int32_t bound = ((i & 1U) != 0U) ? high : low;
+      a = { 0, 0, 0 };
+      (&a.x)[i % 3U] = (((i & 2U) != 0U) ? -1 : 1) * (bound + near(rng));
+    }
+    else
+    {
+      a = { axis(rng), axis(rng), axis(rng) };
+    }
+
+    /* The squares are exact in double */
+    double norm = std::sqrt(static_cast<double>(a.x) * a.x + static_cast<double>(a.y) * a.y
+                            + static_cast<double>(a.z) * a.z);
+    uint8_t want = ((norm >= low) && (norm <= high)) ? 1U : 0U;
+    uint8_t got = FX_MAHONY_Quiet(&a);
+
+    samples++;
+    quiet += got;
+    mismatches += (got != want) ? 1U : 0U;
+  }
+
+  std::printf("quiet        %u samples, %u still, %u mismatches  %s\n", samples, quiet, mismatches,
+              (mismatches == 0U) ? "ok" : "FAILED");
+  return mismatches == 0U;
+}
+
+/**
+  * @brief  Check that each output asked for alone is the one of all outputs,
+  *         and that the others are left as they are
+  * @retval true if every subset gives the same values
+  */
+static bool CheckOutputs()
+{
+  std::mt19937 rng(13);
+  std::uniform_int_distribution<int32_t> small(-30000, 30000);
+  FX_MAHONY_t eng;
+  uint32_t mismatches = 0;
+
+  (void)FX_MAHONY_Init(&eng, kPeriodUs, FX_MAHONY_KP, FX_MAHONY_KI);
+
+  for (uint32_t i = 0; i < 20000U; i++)
+  {
+    MEMS_FIXED_Axes_t acc = { small(rng) * 8, small(rng) * 8, (1000 * MEMS_FIXED_ONE) + small(rng) * 8 };
+    MEMS_FIXED_Axes_t gyr = { small(rng) * 64, small(rng) * 64, small(rng) * 64 };
+    FX_MAHONY_Output_t all;
+
+    FX_MAHONY_Propagate(&eng, &gyr);
+    FX_MAHONY_Update(&eng, &acc);
+    FX_MAHONY_GetOutput(&eng, &acc, FX_MAHONY_OUT_ALL, &all);
+
+    for (uint32_t mask = 0; mask <= FX_MAHONY_OUT_ALL; mask++)
+    {
+      FX_MAHONY_Output_t out;
+      std::memset(&out, 0xA5, sizeof(out));
+      FX_MAHONY_Output_t untouched = out;
+
+      FX_MAHONY_GetOutput(&eng, &acc, mask, &out);
+
+      const FX_MAHONY_Output_t &quat = ((mask & FX_MAHONY_OUT_QUAT) != 0U) ? all : untouched;
+      const FX_MAHONY_Output_t &rot = ((mask & FX_MAHONY_OUT_ROT) != 0U) ? all : untouched;
+      const FX_MAHONY_Output_t &grav = ((mask & FX_MAHONY_OUT_GRAV) != 0U) ? all : untouched;
+      const FX_MAHONY_Output_t &lin = ((mask & FX_MAHONY_OUT_LINACC) != 0U) ? all : untouched;
+      bool same = (std::memcmp(out.Quat, quat.Quat, sizeof(out.Quat)) == 0)
+                  && (std::memcmp(out.Rot, rot.Rot, sizeof(out.Rot)) == 0)
+                  && (std::memcmp(out.Gravity, grav.Gravity, sizeof(out.Gravity)) == 0)
+                  && (std::memcmp(&out.LinAcc, &lin.LinAcc, sizeof(out.LinAcc)) == 0);
+      mismatches += same ? 0U : 1U;
+    }
+  }
+
+  std::printf("outputs      16 subsets of 20000 samples, %u mismatches  %s\n", mismatches,
+              (mismatches == 0U) ? "ok" : "FAILED");
+  return mismatches == 0U;
+}
+
+#ifdef FX_MAHONY_M4_IR
+extern "C" void mahony_propagate(FX_MAHONY_t *Eng, const MEMS_FIXED_Axes_t *Gyro);
+extern "C" uint32_t mahony_quiet(const MEMS_FIXED_Axes_t *Acc);
+
+/**
+  * @brief  Check that propagate_m4.ll computes what the firmware does, so
+  *         that its Cortex-M4 count is that of the firmware
+  * @retval true if every sample gives the same state and test
+  */
+static bool CheckIr()
+{
+  std::mt19937 rng(17);
+  std::uniform_int_distribution<int32_t> rate(-2000 * 1000 * MEMS_FIXED_ONE, 2000 * 1000 * MEMS_FIXED_ONE);
+  std::uniform_int_distribution<int32_t> axis(-1300 * MEMS_FIXED_ONE, 1300 * MEMS_FIXED_ONE);
+  std::uniform_int_distribution<int32_t> small(-30000, 30000);
+  FX_MAHONY_t fw;
+  FX_MAHONY_t ir;
+  uint32_t mismatches = 0;
+
+  (void)FX_MAHONY_Init(&fw, kPeriodUs, FX_MAHONY_KP, FX_MAHONY_KI);
+
+  for (uint32_t i = 0; i < 1000000U; i++)
+  {
+    MEMS_FIXED_Axes_t acc = { axis(rng), axis(rng), axis(rng) };
+    MEMS_FIXED_Axes_t gyr = { rate(rng), rate(rng), rate(rng) };
+    MEMS_FIXED_Axes_t still = { small(rng) * 8, small(rng) * 8, (1000 * MEMS_FIXED_ONE) + small(rng) * 8 };
+
+    ir = fw;
+    FX_MAHONY_Propagate(&fw, &gyr);
+    mahony_propagate(&ir, &gyr);
+    mismatches += (std::memcmp(&fw, &ir, sizeof(fw)) == 0) ? 0U : 1U;
+    mismatches += (mahony_quiet(&acc) == FX_MAHONY_Quiet(&acc)) ? 0U : 1U;
+
+    /* Keep the state a filter state: a correction and a bias */
+    FX_MAHONY_Update(&fw, &still);
+  }
+
+  std::printf("m4 ir        %u mismatches  %s\n", mismatches, (mismatches == 0U) ? "ok" : "FAILED");
+  return mismatches == 0U;
+}
+#endif /* FX_MAHONY_M4_IR */
+
+/**
+  * @brief  Quantize to the firmware sample format
+  * @param  Value in g or dps
+  * @retval [m-unit, Q23.8] of a 16 bit register read
+  */
+static int32_t Fixed(double Value, double LsbMilli)
+{
+  double raw = std::round((Value * 1000.0) / LsbMilli);
+  raw = std::max(-32768.0, std::min(32767.0, raw));
+  return static_cast<int32_t>(std::lround(raw * LsbMilli * MEMS_FIXED_ONE));
+}
+
+/**
+  * @brief  Synthetic dataset with a known orientation
+  * @param  Seconds the length
+  * @retval true if the tilt and implementation errors are in bounds
+  */
+static bool CheckSynthetic(double Seconds)
+{
+  const double acc_lsb = 0.122;    /* mg, +/-4 g */
+  const double gyr_lsb = 70.0;     /* mdps, +/-2000 dps */
+  const double bias[3] = { 0.8, -0.5, 0.3 };  /* dps */
+  std::mt19937 rng(3);
+  std::normal_distribution<double> acc_noise(0.0, 0.002);  /* g */
+  std::normal_distribution<double> gyr_noise(0.0, 0.07);   /* dps */
+  Quat truth = Unit({ 0.9, 0.3, -0.2, 0.25 });
+  FX_MAHONY_t eng;
+  Reference ref;
+  Stats fixed_tilt;
+  Stats ref_tilt;
+  Stats impl;
+  Stats fixed_still;
+  size_t samples = static_cast<size_t>(Seconds / kDt);
+
+  (void)FX_MAHONY_Init(&eng, kPeriodUs, FX_MAHONY_KP, FX_MAHONY_KI);
+
+  for (size_t n = 0; n < samples; n++)
+  {
+    double t = n * kDt;
+    double w[3];
+    double lin[3] = { 0.0, 0.0, 0.0 };   /* World frame [g] */
+    bool moving = (std::fmod(t, 20.0) >= 12.0);
+
+    /* 12 s still, then 8 s of rotation up to about 250 dps and shakes */
+    for (int i = 0; i < 3; i++)
+    {
+      w[i] = moving ? ((150.0 + 30.0 * i) * std::sin((0.7 + 0.4 * i) * t) + 60.0 * std::sin(3.1 * t + i)) : 0.0;
+      lin[i] = moving ? (0.3 * std::sin((2.3 + i) * t)) : 0.0;
+    }
+
+    /* Truth over the period in fine steps */
+    for (int k = 0; k < 20; k++)
+    {
+      double h[3] = { w[0] / kDeg * kDt / 40.0, w[1] / kDeg * kDt / 40.0, w[2] / kDeg * kDt / 40.0 };
+      double a = std::sqrt((h[0] * h[0]) + (h[1] * h[1]) + (h[2] * h[2]));
+      double s = (a > 0.0) ? (std::sin(a) / a) : 1.0;
+      truth = Unit(Mul(truth, { std::cos(a), h[0] * s, h[1] * s, h[2] * s }));
+    }
+
+    /* Specific force in the device frame: R^T (up + linear) */
+    Quat conj = { truth.W, -truth.X, -truth.Y, -truth.Z };
+    Quat f = Mul(Mul(conj, { 0.0, lin[0], lin[1], 1.0 + lin[2] }), truth);
+    double acc[3] = { f.X + acc_noise(rng), f.Y + acc_noise(rng), f.Z + acc_noise(rng) };
+    double gyr[3] = { w[0] + bias[0] + gyr_noise(rng), w[1] + bias[1] + gyr_noise(rng), w[2] + bias[2] + gyr_noise(rng) };
+
+    MEMS_FIXED_Axes_t a = { Fixed(acc[0], acc_lsb), Fixed(acc[1], acc_lsb), Fixed(acc[2], acc_lsb) };
+    MEMS_FIXED_Axes_t g = { Fixed(gyr[0], gyr_lsb), Fixed(gyr[1], gyr_lsb), Fixed(gyr[2], gyr_lsb) };
+    double af[3] = { a.x / (1000.0 * MEMS_FIXED_ONE), a.y / (1000.0 * MEMS_FIXED_ONE), a.z / (1000.0 * MEMS_FIXED_ONE) };
+    double gf[3] = { g.x / (1000.0 * MEMS_FIXED_ONE), g.y / (1000.0 * MEMS_FIXED_ONE), g.z / (1000.0 * MEMS_FIXED_ONE) };
+
+    /* Propagate then update, as FX_RATE_Step runs them */
+    FX_MAHONY_Propagate(&eng, &g);
+    FX_MAHONY_Update(&eng, &a);
+    ref.Propagate(gf);
+    ref.Update(af);
+
+    double vt[3];
+    double ve[3];
+    double vr[3];
+    Gravity(truth, vt);
+    EngineGravity(&eng, ve);
+    Gravity(ref.Q, vr);
+
+    /* After the first 10 s: the bias estimate settles */
+    if (t >= 10.0)
+    {
+      fixed_tilt.Add(AngleDeg(vt, ve));
+      ref_tilt.Add(AngleDeg(vt, vr));
+      impl.Add(AngleDeg(ve, vr));
+      if (!moving && (std::fmod(t, 20.0) >= 2.0))
+      {
+        fixed_still.Add(AngleDeg(vt, ve));
+      }
+    }
+  }
+
+  double est[3];
+  for (int i = 0; i < 3; i++)
+  {
+    est[i] = -eng.Bias[i] / (static_cast<double>(FX_MAHONY_ONE) * kDt / 2.0) * kDeg;
+  }
+
+  std::printf("synthetic    %.0f s at 100 Hz, still 12 s / moving 8 s, gyro bias %.1f %.1f %.1f dps\n",
+              Seconds, bias[0], bias[1], bias[2]);
+  Print("tilt fixed point", fixed_tilt);
+  Print("tilt double", ref_tilt);
+  Print("tilt fixed point, still", fixed_still);
+  Print("fixed point vs double", impl);
+  std::printf("  bias estimate              %.2f %.2f %.2f dps\n", est[0], est[1], est[2]);
+
+  bool ok = (impl.Max() < 0.05) && (fixed_still.Pct(0.95) < 1.0) && (fixed_tilt.Rms() < (ref_tilt.Rms() + 0.05));
+  std::printf("  %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+/**
+  * @brief  Replay a recording and compare with the MotionFX outputs
+  * @param  Path the .rec file
+  * @retval true if the recording could be replayed
+  */
+static bool Replay(const std::string &Path)
+{
+  static const char *names[] = { "acc_x", "acc_y", "acc_z", "gyr_x", "gyr_y", "gyr_z", "grav_0", "grav_1", "grav_2" };
+  rec::Reader reader;
+  int32_t ch[9];
+  int32_t fx_time;
+  FX_MAHONY_t eng;
+  Stats tilt;
+  double fx_sum = 0.0;
+  uint64_t rows = 0;
+
+  if (!reader.Open(Path))
+  {
+    std::printf("%s: %s\n", Path.c_str(), reader.LastError().c_str());
+    return false;
+  }
+  for (int i = 0; i < 9; i++)
+  {
+    ch[i] = reader.FindChannel(names[i]);
+    if (ch[i] < 0)
+    {
+      std::printf("%s: no %s channel, record the acc, gyr and fusion groups\n", Path.c_str(), names[i]);
+      return false;
+    }
+  }
+  fx_time = reader.FindChannel("fx_time");
+
+  (void)FX_MAHONY_Init(&eng, kPeriodUs, FX_MAHONY_KP, FX_MAHONY_KI);
+
+  for (size_t c = 0; c < reader.Chunks(); c++)
+  {
+    rec::Column<int32_t> col[6];
+    rec::Column<float> grav[3];
+    for (int i = 0; i < 6; i++)
+    {
+      col[i] = reader.Get<int32_t>(c, static_cast<uint32_t>(ch[i]));
+    }
+    for (int i = 0; i < 3; i++)
+    {
+      grav[i] = reader.Get<float>(c, static_cast<uint32_t>(ch[6 + i]));
+    }
+    rec::Column<int32_t> fx = (fx_time >= 0) ? reader.Get<int32_t>(c, static_cast<uint32_t>(fx_time))
+                                             : rec::Column<int32_t>();
+
+    for (size_t r = 0; r < col[0].Size; r++, rows++)
+    {
+      /* The stream carries integer mg and mdps */
+      MEMS_FIXED_Axes_t a = { MEMS_FIXED_FromMilli(col[0][r]), MEMS_FIXED_FromMilli(col[1][r]), MEMS_FIXED_FromMilli(col[2][r]) };
+      MEMS_FIXED_Axes_t g = { MEMS_FIXED_FromMilli(col[3][r]), MEMS_FIXED_FromMilli(col[4][r]), MEMS_FIXED_FromMilli(col[5][r]) };
+      double mfx[3] = { grav[0][r], grav[1][r], grav[2][r] };
+      double ve[3];
+
+      FX_MAHONY_Propagate(&eng, &g);
+      FX_MAHONY_Update(&eng, &a);
+      EngineGravity(&eng, ve);
+
+      /* MotionFX discards its first samples, and both settle */
+      if ((rows >= 1000U) && ((mfx[0] != 0.0) || (mfx[1] != 0.0) || (mfx[2] != 0.0)))
+      {
+        tilt.Add(AngleDeg(mfx, ve));
+      }
+      if (!fx.Empty())
+      {
+        fx_sum += fx[r];
+      }
+    }
+  }
+
+  std::printf("recording    %s, %llu samples\n", Path.c_str(), static_cast<unsigned long long>(rows));
+  Print("tilt vs MotionFX", tilt);
+  if ((fx_time >= 0) && (rows > 0U))
+  {
+    std::printf("  MotionFX on the device     %.0f us per sample on average\n", fx_sum / rows);
+  }
+  return true;
+}
+
+/**
+  * @brief  Host time per sample of both implementations
+  * @retval None
+  */
+static void Bench()
+{
+  const size_t n = 2000000U;
+  std::vector<MEMS_FIXED_Axes_t> acc(1024);
+  std::vector<MEMS_FIXED_Axes_t> gyr(1024);
+  std::vector<double> accf(3 * 1024);
+  std::vector<double> gyrf(3 * 1024);
+  std::mt19937 rng(5);
+  std::uniform_int_distribution<int32_t> small(-30000, 30000);
+  FX_MAHONY_t eng;
+  FX_MAHONY_Output_t out;
+  Reference ref;
+  volatile int64_t sink = 0;   /* Keeps the results alive */
+  volatile double sinkf = 0.0;
+
+  for (size_t i = 0; i < acc.size(); i++)
+  {
+    acc[i] = { small(rng) * 8, small(rng) * 8, (1000 * MEMS_FIXED_ONE) + small(rng) * 8 };
+    gyr[i] = { small(rng) * 64, small(rng) * 64, small(rng) * 64 };
+    for (int k = 0; k < 3; k++)
+    {
+      accf[3 * i + k] = (&acc[i].x)[k] / (1000.0 * MEMS_FIXED_ONE);
+      gyrf[3 * i + k] = (&gyr[i].x)[k] / (1000.0 * MEMS_FIXED_ONE);
+    }
+  }
+
+  (void)FX_MAHONY_Init(&eng, kPeriodUs, FX_MAHONY_KP, FX_MAHONY_KI);
+
+  double best_fixed = 1e30;
+  double best_ref = 1e30;
+  for (int run = 0; run < 5; run++)
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++)
+    {
+      size_t k = i & 1023U;
+      FX_MAHONY_Propagate(&eng, &gyr[k]);
+      FX_MAHONY_Update(&eng, &acc[k]);
+      FX_MAHONY_GetOutput(&eng, &acc[k], FX_MAHONY_OUT_ALL, &out);
+      sink += out.Rot[0];
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < n; i++)
+    {
+      size_t k = i & 1023U;
+      const Quat &q = ref.Q;
+      double v[3];
+      ref.Propagate(&gyrf[3 * k]);
+      ref.Update(&accf[3 * k]);
+      Gravity(q, v);
+      sinkf += std::atan2(2.0 * ((q.W * q.Z) + (q.X * q.Y)), 1.0 - 2.0 * ((q.Y * q.Y) + (q.Z * q.Z)))
+               + std::asin(2.0 * ((q.W * q.Y) - (q.Z * q.X)))
+               + std::atan2(2.0 * ((q.W * q.X) + (q.Y * q.Z)), 1.0 - 2.0 * ((q.X * q.X) + (q.Y * q.Y)))
+               + (accf[3 * k] - v[0]);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    best_fixed = std::min(best_fixed, std::chrono::duration<double, std::nano>(t1 - t0).count() / n);
+    best_ref = std::min(best_ref, std::chrono::duration<double, std::nano>(t2 - t1).count() / n);
+  }
+
+  std::printf("host time    fixed point %.1f ns per sample, double %.1f ns, both with the outputs\n",
+              best_fixed, best_ref);
+  std::printf("state        %zu bytes, MotionFX %d bytes\n", sizeof(FX_MAHONY_t), 2432);
+}
+
+int main(int argc, char **argv)
+{
+  bool ok = true;
+
+  ok &= CheckAtan2();
+  ok &= CheckQuiet();
+  ok &= CheckOutputs();
+#ifdef FX_MAHONY_M4_IR
+  ok &= CheckIr();
+#endif /* FX_MAHONY_M4_IR */
+  ok &= CheckSynthetic(600.0);
+  for (int i = 1; i < argc; i++)
+  {
+    ok &= Replay(argv[i]);
+  }
+  Bench();
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+; The per-sample steps of the fixed-point fusion as LLVM IR, for llc and
+; llvm-mca
+;
+; mahony_propagate   FX_MAHONY_Propagate of fx_mahony.c: the gyroscope
+;                    rotation, the Q30 products written out
+; mahony_quiet       FX_MAHONY_Quiet, the still sample test the rate
+;                    scheduler runs on every sample
+;
+; FX_MAHONY_t is read as an array of int32: Q at 0, Corr at 4, Bias at 7,
+; GyroK at 11.
+
+; MEMS_FIXED_Axes_t
+%axes = type { i32, i32, i32 }
+
+define void @mahony_propagate(i32* %eng, %axes* %gyro) {
+  %t1 = getelementptr i32, i32* %eng, i32 0
+  %t2 = getelementptr i32, i32* %eng, i32 1
+  %t3 = getelementptr i32, i32* %eng, i32 2
+  %t4 = getelementptr i32, i32* %eng, i32 3
+  %t5 = load i32, i32* %t1
+  %t6 = load i32, i32* %t2
+  %t7 = load i32, i32* %t3
+  %t8 = load i32, i32* %t4
+  %t9 = getelementptr i32, i32* %eng, i32 4
+  %t10 = load i32, i32* %t9
+  %t11 = getelementptr i32, i32* %eng, i32 5
+  %t12 = load i32, i32* %t11
+  %t13 = getelementptr i32, i32* %eng, i32 6
+  %t14 = load i32, i32* %t13
+  %t15 = getelementptr i32, i32* %eng, i32 7
+  %t16 = load i32, i32* %t15
+  %t17 = getelementptr i32, i32* %eng, i32 8
+  %t18 = load i32, i32* %t17
+  %t19 = getelementptr i32, i32* %eng, i32 9
+  %t20 = load i32, i32* %t19
+  %t21 = getelementptr i32, i32* %eng, i32 11
+  %t22 = load i32, i32* %t21
+  %t23 = zext i32 %t22 to i64
+  ; Half angle over the period, corrected
+  %t24 = getelementptr %axes, %axes* %gyro, i32 0, i32 0
+  %t25 = load i32, i32* %t24
+  %t26 = sext i32 %t25 to i64
+  %t27 = mul nsw i64 %t26, %t23
+  %t28 = ashr i64 %t27, 24
+  %t29 = trunc i64 %t28 to i32
+  %t30 = add i32 %t29, %t10
+  %t31 = add i32 %t30, %t16
+  %t32 = getelementptr %axes, %axes* %gyro, i32 0, i32 1
+  %t33 = load i32, i32* %t32
+  %t34 = sext i32 %t33 to i64
+  %t35 = mul nsw i64 %t34, %t23
+  %t36 = ashr i64 %t35, 24
+  %t37 = trunc i64 %t36 to i32
+  %t38 = add i32 %t37, %t12
+  %t39 = add i32 %t38, %t18
+  %t40 = getelementptr %axes, %axes* %gyro, i32 0, i32 2
+  %t41 = load i32, i32* %t40
+  %t42 = sext i32 %t41 to i64
+  %t43 = mul nsw i64 %t42, %t23
+  %t44 = ashr i64 %t43, 24
+  %t45 = trunc i64 %t44 to i32
+  %t46 = add i32 %t45, %t14
+  %t47 = add i32 %t46, %t20
+  ; q += q * (0, h), first order
+  %t48 = sext i32 %t6 to i64
+  %t49 = sext i32 %t31 to i64
+  %t50 = mul nsw i64 %t48, %t49
+  %t51 = add nsw i64 %t50, 536870912
+  %t52 = ashr i64 %t51, 30
+  %t53 = trunc i64 %t52 to i32
+  %t54 = sub i32 %t5, %t53
+  %t55 = sext i32 %t7 to i64
+  %t56 = sext i32 %t39 to i64
+  %t57 = mul nsw i64 %t55, %t56
+  %t58 = add nsw i64 %t57, 536870912
+  %t59 = ashr i64 %t58, 30
+  %t60 = trunc i64 %t59 to i32
+  %t61 = sub i32 %t54, %t60
+  %t62 = sext i32 %t8 to i64
+  %t63 = sext i32 %t47 to i64
+  %t64 = mul nsw i64 %t62, %t63
+  %t65 = add nsw i64 %t64, 536870912
+  %t66 = ashr i64 %t65, 30
+  %t67 = trunc i64 %t66 to i32
+  %t68 = sub i32 %t61, %t67
+  %t69 = sext i32 %t5 to i64
+  %t70 = sext i32 %t31 to i64
+  %t71 = mul nsw i64 %t69, %t70
+  %t72 = add nsw i64 %t71, 536870912
+  %t73 = ashr i64 %t72, 30
+  %t74 = trunc i64 %t73 to i32
+  %t75 = add i32 %t6, %t74
+  %t76 = sext i32 %t7 to i64
+  %t77 = sext i32 %t47 to i64
+  %t78 = mul nsw i64 %t76, %t77
+  %t79 = add nsw i64 %t78, 536870912
+  %t80 = ashr i64 %t79, 30
+  %t81 = trunc i64 %t80 to i32
+  %t82 = add i32 %t75, %t81
+  %t83 = sext i32 %t8 to i64
+  %t84 = sext i32 %t39 to i64
+  %t85 = mul nsw i64 %t83, %t84
+  %t86 = add nsw i64 %t85, 536870912
+  %t87 = ashr i64 %t86, 30
+  %t88 = trunc i64 %t87 to i32
+  %t89 = sub i32 %t82, %t88
+  %t90 = sext i32 %t5 to i64
+  %t91 = sext i32 %t39 to i64
+  %t92 = mul nsw i64 %t90, %t91
+  %t93 = add nsw i64 %t92, 536870912
+  %t94 = ashr i64 %t93, 30
+  %t95 = trunc i64 %t94 to i32
+  %t96 = add i32 %t7, %t95
+  %t97 = sext i32 %t6 to i64
+  %t98 = sext i32 %t47 to i64
+  %t99 = mul nsw i64 %t97, %t98
+  %t100 = add nsw i64 %t99, 536870912
+  %t101 = ashr i64 %t100, 30
+  %t102 = trunc i64 %t101 to i32
+  %t103 = sub i32 %t96, %t102
+  %t104 = sext i32 %t8 to i64
+  %t105 = sext i32 %t31 to i64
+  %t106 = mul nsw i64 %t104, %t105
+  %t107 = add nsw i64 %t106, 536870912
+  %t108 = ashr i64 %t107, 30
+  %t109 = trunc i64 %t108 to i32
+  %t110 = add i32 %t103, %t109
+  %t111 = sext i32 %t5 to i64
+  %t112 = sext i32 %t47 to i64
+  %t113 = mul nsw i64 %t111, %t112
+  %t114 = add nsw i64 %t113, 536870912
+  %t115 = ashr i64 %t114, 30
+  %t116 = trunc i64 %t115 to i32
+  %t117 = add i32 %t8, %t116
+  %t118 = sext i32 %t6 to i64
+  %t119 = sext i32 %t39 to i64
+  %t120 = mul nsw i64 %t118, %t119
+  %t121 = add nsw i64 %t120, 536870912
+  %t122 = ashr i64 %t121, 30
+  %t123 = trunc i64 %t122 to i32
+  %t124 = add i32 %t117, %t123
+  %t125 = sext i32 %t7 to i64
+  %t126 = sext i32 %t31 to i64
+  %t127 = mul nsw i64 %t125, %t126
+  %t128 = add nsw i64 %t127, 536870912
+  %t129 = ashr i64 %t128, 30
+  %t130 = trunc i64 %t129 to i32
+  %t131 = sub i32 %t124, %t130
+  ; Back to unit norm, (3 - x) / 2
+  %t132 = sext i32 %t68 to i64
+  %t133 = mul nsw i64 %t132, %t132
+  %t134 = sext i32 %t89 to i64
+  %t135 = mul nsw i64 %t134, %t134
+  %t136 = add nsw i64 %t133, %t135
+  %t137 = sext i32 %t110 to i64
+  %t138 = mul nsw i64 %t137, %t137
+  %t139 = add nsw i64 %t136, %t138
+  %t140 = sext i32 %t131 to i64
+  %t141 = mul nsw i64 %t140, %t140
+  %t142 = add nsw i64 %t139, %t141
+  %t143 = ashr i64 %t142, 30
+  %t144 = sub nsw i64 3221225472, %t143
+  %t145 = sdiv i64 %t144, 2
+  %t146 = trunc i64 %t145 to i32
+  %t147 = sext i32 %t68 to i64
+  %t148 = sext i32 %t146 to i64
+  %t149 = mul nsw i64 %t147, %t148
+  %t150 = add nsw i64 %t149, 536870912
+  %t151 = ashr i64 %t150, 30
+  %t152 = trunc i64 %t151 to i32
+  store i32 %t152, i32* %t1
+  %t153 = sext i32 %t89 to i64
+  %t154 = sext i32 %t146 to i64
+  %t155 = mul nsw i64 %t153, %t154
+  %t156 = add nsw i64 %t155, 536870912
+  %t157 = ashr i64 %t156, 30
+  %t158 = trunc i64 %t157 to i32
+  store i32 %t158, i32* %t2
+  %t159 = sext i32 %t110 to i64
+  %t160 = sext i32 %t146 to i64
+  %t161 = mul nsw i64 %t159, %t160
+  %t162 = add nsw i64 %t161, 536870912
+  %t163 = ashr i64 %t162, 30
+  %t164 = trunc i64 %t163 to i32
+  store i32 %t164, i32* %t3
+  %t165 = sext i32 %t131 to i64
+  %t166 = sext i32 %t146 to i64
+  %t167 = mul nsw i64 %t165, %t166
+  %t168 = add nsw i64 %t167, 536870912
+  %t169 = ashr i64 %t168, 30
+  %t170 = trunc i64 %t169 to i32
+  store i32 %t170, i32* %t4
+  ret void
+}
+
+define i32 @mahony_quiet(%axes* %acc) {
+  %t171 = getelementptr %axes, %axes* %acc, i32 0, i32 0
+  %t172 = load i32, i32* %t171
+  %t173 = sext i32 %t172 to i64
+  %t174 = mul nsw i64 %t173, %t173
+  %t175 = getelementptr %axes, %axes* %acc, i32 0, i32 1
+  %t176 = load i32, i32* %t175
+  %t177 = sext i32 %t176 to i64
+  %t178 = mul nsw i64 %t177, %t177
+  %t179 = add nsw i64 %t174, %t178
+  %t180 = getelementptr %axes, %axes* %acc, i32 0, i32 2
+  %t181 = load i32, i32* %t180
+  %t182 = sext i32 %t181 to i64
+  %t183 = mul nsw i64 %t182, %t182
+  %t184 = add nsw i64 %t179, %t183
+  ; (900 mg)^2 and (1100 mg)^2 in Q23.8
+  %lo = icmp sge i64 %t184, 53084160000
+  %hi = icmp sle i64 %t184, 79298560000
+  %in = and i1 %lo, %hi
+  %r = zext i1 %in to i32
+  ret i32 %r
+}
@@ -0,0 +1,206 @@
+/**
+  ******************************************************************************
+  * @file    fx_rate_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the split-rate fusion scheduler against a mock fusion
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  * ******************************************************************************
+  */
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "fx_rate.h"
+
+/*
+ * Runs the firmware fx_rate.c on a host with a mock of the two MotionFX
+ * steps. The mock records every call (sample index, step, delta time) so the
+ * checks see exactly what the library would have been given.
+ */
+
+struct Call
+{
+  uint32_t Sample;
+  char Step;   /* 'p' propagate, 'u' update */
+  float Dt;
+  void *In;
+};
+
+struct Mock
+{
+  uint32_t Sample;
+  std::vector<Call> Calls;
+};
+
+/**
+  * @brief  Mock propagate
+  * @retval None
+  */
+static void MockPropagate(void *Ctx, void *In, void *Out, float Dt)
+{
+  Mock *m = static_cast<Mock *>(Ctx);
+
+  (void)Out;
+  m->Calls.push_back({ m->Sample, 'p', Dt, In });
+}
+
+/**
+  * @brief  Mock update
+  * @retval None
+  */
+static void MockUpdate(void *Ctx, void *In, void *Out, float Dt)
+{
+  Mock *m = static_cast<Mock *>(Ctx);
+
+  (void)Out;
+  m->Calls.push_back({ m->Sample, 'u', Dt, In });
+}
+
+static const FX_RATE_Ops_t kOps = { MockPropagate, MockUpdate };
+static const float kDt = 0.01f;
+
+/**
+  * @brief  Run a schedule and check the call sequence
+  * @param  Name the case name
+  * @param  Div propagates per update
+  * @param  MaxDefer samples an update may be held
+  * @param  Quiet the quiet flag of each sample
+  * @retval true if the sequence is right
+  */
+static bool CheckCase(const char *Name, uint32_t Div, uint32_t MaxDefer, const std::vector<uint8_t> &Quiet)
+{
+  Mock mock = { 0U, {} };
+  FX_RATE_t rate;
+  uint32_t since = 0;     /* Samples since the last update */
+  uint32_t updates = 0;
+  uint32_t held = 0;
+  uint32_t longest = 0;
+  int sample_in = 0;
+
+  if (FX_RATE_Init(&rate, &kOps, &mock, Div, MaxDefer) != FX_RATE_OK)
+  {
+    std::printf("%-14s init FAILED\n", Name);
+    return false;
+  }
+
+  for (uint32_t i = 0; i < Quiet.size(); i++)
+  {
+    size_t before = mock.Calls.size();
+    uint8_t ran;
+
+    mock.Sample = i;
+    ran = FX_RATE_Step(&rate, &sample_in, nullptr, kDt, Quiet[i]);
+    since++;
+
+    /* One propagate per sample, first, then the update if it ran */
+    if ((mock.Calls.size() != (before + 1U + ran)) || (mock.Calls[before].Step != 'p')
+        || ((ran != 0U) && (mock.Calls[before + 1U].Step != 'u')))
+    {
+      std::printf("%-14s sample %u: wrong calls  FAILED\n", Name, i);
+      return false;
+    }
+
+    for (size_t c = before; c < mock.Calls.size(); c++)
+    {
+      if ((mock.Calls[c].Dt != kDt) || (mock.Calls[c].In != &sample_in))
+      {
+        std::printf("%-14s sample %u: wrong delta time or input  FAILED\n", Name, i);
+        return false;
+      }
+    }
+
+    /* The update runs at Div samples when quiet, held while moving up to
+     * Div + MaxDefer samples, never earlier */
+    bool due = since >= Div;
+    bool want = due && ((Quiet[i] != 0U) || (since >= (Div + MaxDefer)));
+    if ((ran != 0U) != want)
+    {
+      std::printf("%-14s sample %u: update %s  FAILED\n", Name, i, (ran != 0U) ? "early" : "missing");
+      return false;
+    }
+
+    if (due && (ran == 0U))
+    {
+      held++;
+    }
+    if (ran != 0U)
+    {
+      longest = (since > longest) ? since : longest;
+      since = 0;
+      updates++;
+    }
+  }
+
+  if ((rate.Updates != updates) || (rate.Deferred != held))
+  {
+    std::printf("%-14s counters %u/%u held %u/%u  FAILED\n", Name, rate.Updates, updates, rate.Deferred, held);
+    return false;
+  }
+
+  std::printf("%-14s div %3u defer %3u  %6zu samples  %6u updates  %5u held  longest gap %3u  ok\n",
+              Name, Div, MaxDefer, Quiet.size(), updates, held, longest);
+  return true;
+}
+
+int main()
+{
+  std::mt19937 rng(7);
+  std::vector<uint8_t> quiet(10000U, 1U);
+  std::vector<uint8_t> walk(10000U);
+  std::vector<uint8_t> moving(10000U, 0U);
+  Mock mock = { 0U, {} };
+  FX_RATE_t rate;
+  bool ok = true;
+
+  /* Still most of the time, moving in bursts of up to 40 samples */
+  for (size_t i = 0; i < walk.size();)
+  {
+    uint32_t len = 1U + (rng() % 40U);
+    uint8_t q = static_cast<uint8_t>(rng() % 2U);
+
+    for (uint32_t k = 0; (k < len) && (i < walk.size()); k++, i++)
+    {
+      walk[i] = q;
+    }
+  }
+
+  ok &= CheckCase("every sample", 1U, 0U, walk);
+  ok &= CheckCase("still", 4U, 3U, quiet);
+  ok &= CheckCase("bursts", 4U, 3U, walk);
+  ok &= CheckCase("bursts 416Hz", 16U, 15U, walk);
+  ok &= CheckCase("moving", 4U, 3U, moving);
+  ok &= CheckCase("no defer", 4U, 0U, walk);
+
+  /* Configurations the library cannot take */
+  if ((FX_RATE_Init(&rate, &kOps, &mock, 0U, 0U) != FX_RATE_ERROR)
+      || (FX_RATE_Init(&rate, &kOps, &mock, FX_RATE_MAX_DIV + 1U, 0U) != FX_RATE_ERROR)
+      || (FX_RATE_Init(&rate, nullptr, &mock, 1U, 0U) != FX_RATE_ERROR))
+  {
+    std::printf("bad configuration accepted  FAILED\n");
+    ok = false;
+  }
+
+  /* Still detection on the acceleration norm */
+  const float still[3] = { 0.0f, 0.6f, 0.8f };
+  const float tilt[3] = { 0.05f, 0.0f, 1.08f };
+  const float shake[3] = { 0.9f, 0.3f, 1.1f };
+  const float fall[3] = { 0.0f, 0.0f, 0.05f };
+  if ((FX_RATE_Quiet(still, 0.1f) != 1U) || (FX_RATE_Quiet(tilt, 0.1f) != 1U)
+      || (FX_RATE_Quiet(shake, 0.1f) != 0U) || (FX_RATE_Quiet(fall, 0.1f) != 0U)
+      || (FX_RATE_Quiet(fall, 2.0f) != 1U))
+  {
+    std::printf("still detection  FAILED\n");
+    ok = false;
+  }
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,304 @@
+/**
+  ******************************************************************************
+  * @file    ipc_ring_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the inter-core block ring with producer and consumer threads
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "ipc_link.h"
+
+/*
+ * Runs the firmware ipc_ring.c on a host. The producer thread plays the
+ * CM0+, the consumer thread the CM4, on a 2 KiB region like the one of
+ * ipc_link.c.
+ *
+ * The producer waits for the consumer to format the region, attaches and
+ * commits blocks carrying their number and a payload derived from it. A
+ * commit that returns IPC_RING_NOTIFY rings the doorbell, an event the
+ * consumer sleeps on like the CM4 sleeps on the IPCC interrupt.
+ *
+ * The consumer drains the ring, arms, and sleeps only when IPC_RING_Arm
+ * finds nothing pending. Each block must be intact and in order, the
+ * sequence gaps must be the blocks the producer counted as dropped, and a
+ * consumer asleep while blocks wait would be a lost wakeup: the sleep has a
+ * timeout that catches it.
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static const uint32_t kBlocks = 2000000U;
+static const uint32_t kPayload = sizeof(IPC_LINK_Block_t);
+static const uint32_t kRegion = IPC_LINK_REGION_SIZE;
+
+struct Doorbell
+{
+  std::mutex Lock;
+  std::condition_variable Cv;
+  bool Rung;       /* IPCC channel occupied */
+  uint64_t Rings;  /* Doorbells actually sent */
+};
+
+struct Result
+{
+  uint64_t Received;
+  uint64_t Missing;
+  uint64_t Corrupt;
+  uint64_t Reorder;
+  uint64_t LostWakeups;
+  uint64_t Sleeps;
+  uint64_t Rings;
+  IPC_RING_Stats_t Stats;
+};
+
+/**
+  * @brief  Payload word of a block
+  * @param  Seq the block number
+  * @param  I the word index
+  * @retval The word
+  */
+static uint32_t Pattern(uint32_t Seq, uint32_t I)
+{
+  return (Seq * 2654435761U) ^ (I * 40503U);
+}
+
+/**
+  * @brief  Ring the doorbell
+  * @note   Like IPC_LINK_Commit, an occupied channel is not rung again
+  * @param  Bell the doorbell
+  * @retval None
+  */
+static void Ring(Doorbell &Bell)
+{
+  std::lock_guard<std::mutex> lock(Bell.Lock);
+  if (!Bell.Rung)
+  {
+    Bell.Rung = true;
+    Bell.Rings++;
+    Bell.Cv.notify_one();
+  }
+}
+
+/**
+  * @brief  Run a producer and a consumer thread on one region
+  * @param  BurstEvery the producer yields every n blocks
+  * @retval The comparison of the received blocks with what was committed
+  */
+static Result Execute(uint32_t BurstEvery)
+{
+  alignas(8) static uint32_t region[kRegion / sizeof(uint32_t)];
+  std::atomic<bool> formatted(false);
+  std::atomic<bool> done(false);
+  Doorbell bell;
+  Result res = {};
+  IPC_RING_t cons;
+
+  bell.Rung = false;
+  bell.Rings = 0;
+  std::memset(region, 0xA5, sizeof(region));
+
+  std::thread producer([&]()
+  {
+    IPC_RING_t prod;
+    uint32_t seq = 0;
+
+    /* The CM0+ boots on its own, it retries until the region is formatted */
+    while (IPC_RING_Attach(&prod, region, sizeof(region)) == IPC_RING_BUSY)
+    {
+      std::this_thread::yield();
+    }
+
+    while (seq < kBlocks)
+    {
+      uint32_t *payload = static_cast<uint32_t *>(IPC_RING_Reserve(&prod));
+
+      /* A full ring drops the block, the next one keeps its number */
+      if (payload != nullptr)
+      {
+        payload[0] = seq;
+        for (uint32_t i = 1; i < (kPayload / 4U); i++)
+        {
+          payload[i] = Pattern(seq, i);
+        }
+        if (IPC_RING_Commit(&prod, 1U, (uint16_t)kPayload) == IPC_RING_NOTIFY)
+        {
+          Ring(bell);
+        }
+      }
+      seq++;
+      if ((seq % BurstEvery) == 0U)
+      {
+        std::this_thread::yield();
+      }
+    }
+    done = true;
+    Ring(bell);
+  });
+
+  /* The producer may run before the region is formatted */
+  std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  (void)IPC_RING_Init(&cons, region, sizeof(region), kPayload);
+  formatted = true;
+
+  int64_t last = -1;
+  for (;;)
+  {
+    const IPC_RING_Slot_t *slot = IPC_RING_Peek(&cons);
+
+    if (slot != nullptr)
+    {
+      const uint32_t *payload = static_cast<const uint32_t *>(IPC_RING_PAYLOAD(slot));
+      bool ok = (slot->Len == kPayload) && (slot->Type == 1U);
+
+      for (uint32_t i = 1; ok && (i < (kPayload / 4U)); i++)
+      {
+        ok = (payload[i] == Pattern(payload[0], i));
+      }
+      if (!ok)
+      {
+        res.Corrupt++;
+      }
+      else if ((int64_t)slot->Sequence <= last)
+      {
+        res.Reorder++;
+      }
+      else
+      {
+        /* Dropped blocks never get a ring sequence number */
+        last = slot->Sequence;
+        res.Received++;
+      }
+      IPC_RING_Release(&cons);
+      continue;
+    }
+
+    if (done.load() && (IPC_RING_Used(&cons) == 0U))
+    {
+      break;
+    }
+
+    /* Sleep only when nothing arrived after arming */
+    if (IPC_RING_Arm(&cons) == IPC_RING_PENDING)
+    {
+      IPC_RING_Disarm(&cons);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(bell.Lock);
+    res.Sleeps++;
+    if (!bell.Cv.wait_for(lock, std::chrono::milliseconds(200), [&]() { return bell.Rung; }))
+    {
+      if (IPC_RING_Used(&cons) != 0U)
+      {
+        res.LostWakeups++;
+      }
+    }
+    bell.Rung = false;
+    lock.unlock();
+    IPC_RING_Disarm(&cons);
+  }
+
+  producer.join();
+  IPC_RING_GetStats(&cons, &res.Stats);
+  res.Missing = (uint64_t)kBlocks - res.Received;
+  res.Rings = bell.Rings;
+  return res;
+}
+
+/**
+  * @brief  Print a result
+  * @param  Name the run
+  * @param  Res the result
+  * @retval true if the blocks match the counters
+  */
+static bool Report(const char *Name, const Result &Res)
+{
+  bool ok = (Res.Corrupt == 0U) && (Res.Reorder == 0U) && (Res.LostWakeups == 0U)
+            && (Res.Missing == Res.Stats.Dropped) && (Res.Stats.Committed == Res.Received)
+            && (Res.Stats.Used == 0U);
+
+  std::printf("%-12s %7llu blocks  dropped %7lu/%-7llu  corrupt %llu  reordered %llu  doorbells %7lu asked "
+              "%7llu sent  sleeps %7llu  lost wakeups %llu  %s\n",
+              Name, (unsigned long long)Res.Received, (unsigned long)Res.Stats.Dropped,
+              (unsigned long long)Res.Missing, (unsigned long long)Res.Corrupt, (unsigned long long)Res.Reorder,
+              (unsigned long)Res.Stats.Doorbells, (unsigned long long)Res.Rings, (unsigned long long)Res.Sleeps,
+              (unsigned long long)Res.LostWakeups, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+int main()
+{
+  bool ok = true;
+
+  ok &= Report("burst of 8", Execute(8U));
+  ok &= Report("burst of 64", Execute(64U));
+  ok &= Report("one by one", Execute(1U));
+
+  /* Handshake and layout */
+  alignas(8) static uint32_t region[kRegion / sizeof(uint32_t)];
+  IPC_RING_t cons, prod;
+  std::memset(region, 0, sizeof(region));
+  bool edges = (IPC_RING_Attach(&prod, region, sizeof(region)) == IPC_RING_BUSY)
+               && (IPC_RING_Init(&cons, region, sizeof(region), kPayload) == IPC_RING_OK)
+               && (cons.Ctrl->SlotCount == 8U)
+               && (IPC_RING_Attach(&prod, region, 64U) == IPC_RING_ERROR)   /* Smaller view of the region */
+               && (IPC_RING_Attach(&prod, region, sizeof(region)) == IPC_RING_OK)
+               && (IPC_RING_Connected(&cons) == 1U)
+               && (IPC_RING_Init(&cons, (uint8_t *)region + 2, sizeof(region), kPayload) == IPC_RING_ERROR)
+               && (IPC_RING_Init(&cons, region, 128U, kPayload) == IPC_RING_ERROR);
+
+  /* A paused consumer discards the blocks without counting drops */
+  IPC_RING_SetConsumer(&cons, IPC_RING_STATE_OFF);
+  edges &= (IPC_RING_Reserve(&prod) == nullptr) && (cons.Ctrl->Dropped == 0U) && (IPC_RING_Connected(&cons) == 0U);
+  IPC_RING_SetConsumer(&cons, IPC_RING_STATE_READY);
+
+  /* Armed: one doorbell per burst */
+  edges &= (IPC_RING_Arm(&cons) == IPC_RING_OK);
+  (void)IPC_RING_Reserve(&prod);
+  edges &= (IPC_RING_Commit(&prod, 1U, 4U) == IPC_RING_NOTIFY);
+  edges &= (IPC_RING_Arm(&cons) == IPC_RING_PENDING);
+  IPC_RING_Disarm(&cons);
+  (void)IPC_RING_Reserve(&prod);
+  edges &= (IPC_RING_Commit(&prod, 1U, 4U) == IPC_RING_OK) && (IPC_RING_Used(&cons) == 2U);
+  std::printf("handshake and layout      %s\n", edges ? "ok" : "FAILED");
+  ok &= edges;
+
+  /* Cost of a block through the ring, no doorbell */
+  double best = 1e9;
+  IPC_RING_Release(&cons);
+  IPC_RING_Release(&cons);
+  for (int run = 0; run < 5; run++)
+  {
+    BenchClock::time_point t0 = BenchClock::now();
+    for (uint32_t i = 0; i < 1000000U; i++)
+    {
+      uint32_t *payload = static_cast<uint32_t *>(IPC_RING_Reserve(&prod));
+      payload[0] = i;
+      (void)IPC_RING_Commit(&prod, 1U, (uint16_t)kPayload);
+      IPC_RING_Release(&cons);
+    }
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    best = std::fmin(best, ns / 1000000.0);
+  }
+  std::printf("reserve + commit + release  %.1f ns per block\n", best);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+/**
+  ******************************************************************************
+  * @file    lat_hist_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the latency histogram percentiles against exact ones
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "lat_hist.h"
+
+/*
+ * Runs the firmware lat_hist.c on a host:
+ *  - every bin covers the values it is given by LAT_HIST_BinOf, with no gap
+ *    or overlap up to LAT_HIST_RANGE,
+ *  - on a few latency shapes (steady, long tail, two modes), each reported
+ *    percentile is at or above the exact one and at most one bin above it,
+ *  - halving keeps the percentiles when a bin would overflow,
+ *  - values out of range come back as the maximum.
+ */
+
+static const uint32_t Permilles[] = { 500U, 900U, 990U, 999U };
+
+/**
+  * @brief  Check the bin boundaries
+  * @retval true if they tile the range
+  */
+static bool CheckBins()
+{
+  uint32_t bin;
+
+  if (LAT_HIST_BinOf(0U) != 0U)
+  {
+    return false;
+  }
+
+  for (bin = 0; bin < (LAT_HIST_BINS - 1U); bin++)
+  {
+    uint32_t high = LAT_HIST_BinHigh(bin);
+
+    if ((LAT_HIST_BinOf(high) != bin) || (LAT_HIST_BinOf(high + 1U) != (bin + 1U)))
+    {
+      std::printf("bin %u ends at %u, next value in bin %u\n", bin, high, LAT_HIST_BinOf(high + 1U));
+      return false;
+    }
+
+    /* Width within 1/8 of the low end */
+    if ((bin >= LAT_HIST_SUB_BINS) && (((high - LAT_HIST_BinHigh(bin - 1U)) * LAT_HIST_SUB_BINS) > (high + 1U)))
+    {
+      std::printf("bin %u is too wide\n", bin);
+      return false;
+    }
+  }
+
+  if ((LAT_HIST_BinHigh(LAT_HIST_BINS - 1U) != (LAT_HIST_RANGE - 1U))
+      || (LAT_HIST_BinOf(LAT_HIST_RANGE) != (LAT_HIST_BINS - 1U))
+      || (LAT_HIST_BinOf(UINT32_MAX) != (LAT_HIST_BINS - 1U)))
+  {
+    std::printf("the last bin does not end the range\n");
+    return false;
+  }
+
+  return true;
+}
+
+/**
+  * @brief  Exact percentile, same rank as LAT_HIST_Percentile
+  * @param  Sorted the samples, sorted
+  * @param  Permille the percentile in thousandths
+  * @retval The sample of that rank
+  */
+static uint32_t Exact(const std::vector<uint32_t> &Sorted, uint32_t Permille)
+{
+  size_t rank = ((Sorted.size() * Permille) + 999U) / 1000U;
+
+  return Sorted[(rank == 0U) ? 0U : (rank - 1U)];
+}
+
+/**
+  * @brief  Compare the histogram percentiles of samples with the exact ones
+  * @param  Name the shape name
+  * @param  Samples the samples, in us
+  * @retval true if every percentile is within one bin
+  */
+static bool CheckShape(const char *Name, std::vector<uint32_t> Samples)
+{
+  static LAT_HIST_t hist;
+  bool ok = true;
+
+  LAT_HIST_Reset(&hist);
+  for (uint32_t v : Samples)
+  {
+    LAT_HIST_Add(&hist, v);
+  }
+  std::sort(Samples.begin(), Samples.end());
+
+  std::printf("%-10s n %6u", Name, hist.Count);
+  for (uint32_t p : Permilles)
+  {
+    uint32_t want = Exact(Samples, p);
+    uint32_t got = LAT_HIST_Percentile(&hist, p);
+    uint32_t limit = std::min(LAT_HIST_BinHigh(LAT_HIST_BinOf(want)), hist.Max);
+
+    std::printf("  p%-4.1f %7u/%-7u", p / 10.0, got, want);
+    if ((got < want) || (got > limit))
+    {
+      ok = false;
+    }
+  }
+  std::printf("  max %u  %s\n", hist.Max, ok ? "ok" : "FAILED");
+
+  return ok && (hist.Max == Samples.back());
+}
+
+/**
+  * @brief  Fill one bin past 16 bits
+  * @retval true if the percentiles survive the halving
+  */
+static bool CheckHalving()
+{
+  static LAT_HIST_t hist;
+  uint32_t i;
+
+  LAT_HIST_Reset(&hist);
+  for (i = 0; i < 200000U; i++)
+  {
+    LAT_HIST_Add(&hist, ((i % 10U) == 9U) ? 5000U : 100U);
+  }
+
+  /* 90 % at 100 us, 10 % at 5 ms, the maximum */
+  return (hist.Count < 2U * UINT16_MAX) && (hist.Bins[LAT_HIST_BinOf(100U)] > (hist.Count / 2U))
+         && (LAT_HIST_Percentile(&hist, 500U) == LAT_HIST_BinHigh(LAT_HIST_BinOf(100U)))
+         && (LAT_HIST_Percentile(&hist, 950U) == 5000U);
+}
+
+/**
+  * @brief  Add a value beyond the range
+  * @retval true if it comes back as the maximum
+  */
+static bool CheckRange()
+{
+  static LAT_HIST_t hist;
+
+  LAT_HIST_Reset(&hist);
+  LAT_HIST_Add(&hist, 10U);
+  LAT_HIST_Add(&hist, 9000000U);
+
+  return (LAT_HIST_Percentile(&hist, 500U) == 10U) && (LAT_HIST_Percentile(&hist, 990U) == 9000000U)
+         && (LAT_HIST_Percentile(&hist, 1000U) == 9000000U);
+}
+
+int main(int argc, char **argv)
+{
+  size_t n = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 100000U;
+  std::mt19937 rng(1);
+  std::vector<uint32_t> steady, tail, modes;
+  bool ok = true;
+
+  /* An alarm report: a few ms of UART, rarely behind a snapshot line */
+  std::normal_distribution<double> uart(4200.0, 300.0);
+  std::lognormal_distribution<double> wait(std::log(800.0), 1.2);
+  std::bernoulli_distribution behind(0.05);
+  std::uniform_int_distribution<uint32_t> small(0U, 40U);
+
+  for (size_t i = 0; i < n; i++)
+  {
+    steady.push_back(static_cast<uint32_t>(std::max(0.0, uart(rng))));
+    tail.push_back(static_cast<uint32_t>(std::min(wait(rng), 1e9)));
+    modes.push_back(behind(rng) ? 95000U + small(rng) * 100U : small(rng));
+  }
+
+  if (!CheckBins())
+  {
+    ok = false;
+  }
+  std::printf("bins       %u, range %lu us  %s\n", LAT_HIST_BINS, static_cast<unsigned long>(LAT_HIST_RANGE),
+              ok ? "ok" : "FAILED");
+
+  ok = CheckShape("steady", steady) && ok;
+  ok = CheckShape("long tail", tail) && ok;
+  ok = CheckShape("two modes", modes) && ok;
+
+  if (!CheckHalving())
+  {
+    std::printf("halving    FAILED\n");
+    ok = false;
+  }
+  if (!CheckRange())
+  {
+    std::printf("out of range FAILED\n");
+    ok = false;
+  }
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
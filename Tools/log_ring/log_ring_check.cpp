@@ -0,0 +1,294 @@
+/**
+  ******************************************************************************
+  * @file    log_ring_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the log ring with producer and consumer threads
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "log_ring.h"
+
+/*
+ * Runs the firmware log_ring.c on a host. The producers write records, the
+ * consumer takes the pending data block by block the way the DMA of
+ * log_sink.c does: LOG_RING_Peek, copy, LOG_RING_Release.
+ *
+ * A record is a length byte, the producer number, a sequence number and a
+ * payload derived from both. The consumer parses the byte stream: every
+ * record must be whole and intact, the sequence of each producer must only
+ * go up, and the records missing from it must be exactly the writes the
+ * ring counted as overflows.
+ *
+ * With two producers the writes are serialized by a mutex, the way
+ * LOG_SINK_Write masks the interrupts around the ring write when thread
+ * mode and a peripheral interrupt both log.
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static const uint32_t kRecords = 2000000U;  /* Per run, over all producers */
+static const uint32_t kHeader = 6U;         /* Length, producer, sequence */
+
+struct Run
+{
+  const char *Name;
+  uint32_t Size;       /* Ring size */
+  uint32_t Producers;
+  uint32_t SlowEvery;  /* Consumer pauses every n blocks, 0 never */
+};
+
+struct Result
+{
+  uint64_t Records;   /* Records received */
+  uint64_t Missing;   /* Sequence gaps */
+  uint64_t Corrupt;   /* Records with a bad length or payload */
+  uint64_t Reorder;   /* Sequence going backwards */
+  LOG_RING_Stats_t Stats;
+};
+
+/**
+  * @brief  Payload byte of a record
+  * @param  Producer the producer number
+  * @param  Seq the sequence number
+  * @param  I the byte index
+  * @retval The byte
+  */
+static uint8_t Pattern(uint32_t Producer, uint32_t Seq, uint32_t I)
+{
+  return (uint8_t)((Seq * 31U) + (I * 7U) + (Producer * 101U));
+}
+
+/**
+  * @brief  Run producers and a consumer on one ring
+  * @param  R the run
+  * @retval The comparison of the received stream with what was written
+  */
+static Result Execute(const Run &R)
+{
+  std::vector<uint8_t> storage(R.Size);
+  LOG_RING_t ring;
+  std::mutex producers;
+  std::atomic<uint32_t> done(0);
+  std::vector<std::thread> threads;
+  Result res = {};
+
+  (void)LOG_RING_Init(&ring, storage.data(), R.Size);
+
+  for (uint32_t p = 0; p < R.Producers; p++)
+  {
+    threads.emplace_back([&, p]()
+    {
+      std::mt19937 rng(100U + p);
+      uint8_t rec[256];
+
+      for (uint32_t seq = 0; seq < (kRecords / R.Producers); seq++)
+      {
+        uint32_t len = kHeader + (rng() % 90U);
+
+        rec[0] = (uint8_t)len;
+        rec[1] = (uint8_t)p;
+        std::memcpy(&rec[2], &seq, 4U);
+        for (uint32_t i = kHeader; i < len; i++)
+        {
+          rec[i] = Pattern(p, seq, i);
+        }
+        if (R.Producers > 1U)
+        {
+          std::lock_guard<std::mutex> lock(producers);
+          (void)LOG_RING_Write(&ring, rec, len);
+        }
+        else
+        {
+          (void)LOG_RING_Write(&ring, rec, len);
+        }
+        /* Lines come in bursts of up to 32, the ring absorbs most of them */
+        if ((rng() % 32U) == 0U)
+        {
+          std::this_thread::yield();
+        }
+      }
+      done++;
+    });
+  }
+
+  /* Consumer: blocks as the DMA takes them, parsed as a byte stream */
+  std::vector<uint8_t> stream;
+  std::vector<int64_t> last(R.Producers, -1);
+  uint32_t blocks = 0;
+  size_t pos = 0;
+
+  for (;;)
+  {
+    bool finished = (done.load() == R.Producers);
+    uint8_t *data;
+    uint32_t len = LOG_RING_Peek(&ring, &data);
+
+    if (len == 0U)
+    {
+      if (finished && (LOG_RING_Used(&ring) == 0U))
+      {
+        break;
+      }
+      std::this_thread::yield();
+      continue;
+    }
+
+    stream.insert(stream.end(), data, data + len);
+    LOG_RING_Release(&ring, len);
+    if ((R.SlowEvery != 0U) && ((++blocks % R.SlowEvery) == 0U))
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+
+    while ((stream.size() - pos) >= 1U)
+    {
+      uint32_t rlen = stream[pos];
+
+      if ((rlen < kHeader) || (rlen > (kHeader + 89U)))
+      {
+        res.Corrupt++;
+        pos = stream.size();
+        break;
+      }
+      if ((stream.size() - pos) < rlen)
+      {
+        break;
+      }
+
+      uint32_t p = stream[pos + 1U];
+      uint32_t seq;
+      std::memcpy(&seq, &stream[pos + 2U], 4U);
+      bool ok = (p < R.Producers);
+      for (uint32_t i = kHeader; ok && (i < rlen); i++)
+      {
+        ok = (stream[pos + i] == Pattern(p, seq, i));
+      }
+      if (!ok)
+      {
+        res.Corrupt++;
+      }
+      else if ((int64_t)seq <= last[p])
+      {
+        res.Reorder++;
+      }
+      else
+      {
+        res.Missing += (uint64_t)((int64_t)seq - last[p] - 1);
+        last[p] = seq;
+        res.Records++;
+      }
+      pos += rlen;
+    }
+    if (pos > 65536U)
+    {
+      stream.erase(stream.begin(), stream.begin() + (std::ptrdiff_t)pos);
+      pos = 0;
+    }
+  }
+
+  for (std::thread &t : threads)
+  {
+    t.join();
+  }
+
+  /* Records dropped at the end of a sequence do not show as a gap */
+  for (uint32_t p = 0; p < R.Producers; p++)
+  {
+    res.Missing += (uint64_t)((int64_t)(kRecords / R.Producers) - 1 - last[p]);
+  }
+  LOG_RING_GetStats(&ring, &res.Stats);
+  return res;
+}
+
+/**
+  * @brief  Print a result
+  * @param  R the run
+  * @param  Res the result
+  * @retval true if the stream matches the counters
+  */
+static bool Report(const Run &R, const Result &Res)
+{
+  bool ok = (Res.Corrupt == 0U) && (Res.Reorder == 0U) && (Res.Missing == Res.Stats.Overflows)
+            && ((Res.Records + Res.Missing) == kRecords) && (Res.Stats.Used == 0U)
+            && (Res.Stats.HighWater <= R.Size);
+
+  std::printf("%-24s %8llu records  overflows %7lu/%-7llu  corrupt %llu  reordered %llu  high water %5lu/%-5lu  %s\n",
+              R.Name, (unsigned long long)Res.Records, (unsigned long)Res.Stats.Overflows,
+              (unsigned long long)Res.Missing, (unsigned long long)Res.Corrupt, (unsigned long long)Res.Reorder,
+              (unsigned long)Res.Stats.HighWater, (unsigned long)R.Size, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+int main()
+{
+  bool ok = true;
+
+  const Run runs[] =
+  {
+    { "1 producer, 4 KiB", 4096U, 1U, 0U },
+    { "1 producer, 512 B", 512U, 1U, 0U },
+    { "1 producer, slow drain", 4096U, 1U, 8U },
+    { "2 producers, 4 KiB", 4096U, 2U, 0U },
+    { "2 producers, slow drain", 4096U, 2U, 8U },
+  };
+  for (const Run &r : runs)
+  {
+    ok &= Report(r, Execute(r));
+  }
+
+  /* A write that does not fit is dropped whole, the size must be a power
+   * of two */
+  uint8_t buf[16];
+  uint8_t line[12] = { 0 };
+  uint8_t *data;
+  LOG_RING_t ring;
+  bool edges = (LOG_RING_Init(&ring, buf, 12U) == LOG_RING_ERROR)
+               && (LOG_RING_Init(&ring, buf, sizeof(buf)) == LOG_RING_OK)
+               && (LOG_RING_Write(&ring, line, 12U) == LOG_RING_OK)
+               && (LOG_RING_Write(&ring, line, 5U) == LOG_RING_ERROR)
+               && (ring.Dropped == 5U) && (ring.Overflows == 1U) && (LOG_RING_Used(&ring) == 12U);
+  LOG_RING_Release(&ring, LOG_RING_Peek(&ring, &data));
+  edges &= (LOG_RING_Write(&ring, line, 10U) == LOG_RING_OK)      /* Wraps */
+           && (LOG_RING_Peek(&ring, &data) == 4U) && (data == &buf[12]);
+  std::printf("edge cases               %s\n", edges ? "ok" : "FAILED");
+  ok &= edges;
+
+  /* Cost of a 48 byte line */
+  std::vector<uint8_t> storage(4096U);
+  uint8_t msg[48] = { 0 };
+  double best = 1e9;
+  (void)LOG_RING_Init(&ring, storage.data(), (uint32_t)storage.size());
+  for (int run = 0; run < 5; run++)
+  {
+    BenchClock::time_point t0 = BenchClock::now();
+    for (uint32_t i = 0; i < 1000000U; i++)
+    {
+      (void)LOG_RING_Write(&ring, msg, sizeof(msg));
+      LOG_RING_Release(&ring, LOG_RING_Peek(&ring, &data));
+    }
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    best = std::fmin(best, ns / 1000000.0);
+  }
+  std::printf("write + drain  %.1f ns per 48 byte line\n", best);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,32 @@
+/**
+  ******************************************************************************
+  * @file    main.h
+  * @author  ISCA Lab
+  * @brief   Host stand-in for the firmware main.h, used by mem_budget.c
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Exported functions --------------------------------------------------------*/
+/* Defined by the check, counts the calls and returns */
+void Error_Handler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MAIN_H */
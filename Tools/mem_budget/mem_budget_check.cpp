@@ -0,0 +1,296 @@
+/**
+  ******************************************************************************
+  * @file    mem_budget_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the arena allocator and the memory budget pools
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "mem_arena.h"
+#include "mem_budget.h"
+
+/*
+ * Runs the firmware mem_arena.c and mem_budget.c of one tree on a host.
+ * mem_budget.c is built against host/main.h, where Error_Handler is the
+ * counter below and returns.
+ *
+ *  - arena: blocks are aligned, disjoint and rounded; a request that does
+ *    not fit, of zero bytes or whose rounding wraps fails without taking
+ *    anything; random requests match a reference model,
+ *  - budget: taking every entry of mem_budget.h leaves each pool empty, one
+ *    more byte ends in Error_Handler, the blocks are zero filled and a
+ *    region without a budget refuses everything,
+ *  - sources: with a tree given, every entry is taken with MEM_BUDGET_ALLOC
+ *    somewhere in Core/Src, MEMS/App or MEMS/Target.
+ */
+
+struct Entry
+{
+  const char *Name;
+  uint32_t Region;
+  uint32_t Size;
+};
+
+#define ENTRY(Name) { #Name, MEM_BUDGET_##Name##_REGION, MEM_BUDGET_##Name##_SIZE }
+
+/* The entries of both trees, as far as the mem_budget.h built against has them */
+static const Entry Entries[] =
+{
+#ifdef MEM_BUDGET_LOG_RING_SIZE
+  ENTRY(LOG_RING),
+#endif
+#ifdef MEM_BUDGET_MLC_TX_SIZE
+  ENTRY(MLC_TX),
+#endif
+#ifdef MEM_BUDGET_TERMINAL_OUT_SIZE
+  ENTRY(TERMINAL_OUT),
+#endif
+#ifdef MEM_BUDGET_SNAP_WORDS_SIZE
+  ENTRY(SNAP_WORDS),
+#endif
+#ifdef MEM_BUDGET_SNAP_OUT_SIZE
+  ENTRY(SNAP_OUT),
+#endif
+#ifdef MEM_BUDGET_LAT_TRACE_SIZE
+  ENTRY(LAT_TRACE),
+#endif
+#ifdef MEM_BUDGET_UART_RX_SIZE
+  ENTRY(UART_RX),
+#endif
+#ifdef MEM_BUDGET_UART_TX_SIZE
+  ENTRY(UART_TX),
+#endif
+#ifdef MEM_BUDGET_MFX_STATE_SIZE
+  ENTRY(MFX_STATE),
+#endif
+#ifdef MEM_BUDGET_OFFLINE_DATA_SIZE
+  ENTRY(OFFLINE_DATA),
+#endif
+};
+
+static uint32_t ErrorCalls;
+
+extern "C" void Error_Handler(void)
+{
+  ErrorCalls++;
+}
+
+/**
+  * @brief  Check the arena on fixed cases
+  * @retval true if all pass
+  */
+static bool ArenaEdges()
+{
+  alignas(MEM_ARENA_ALIGNMENT) static uint8_t pool[64];
+  MEM_ARENA_t arena = MEM_ARENA_INITIALIZER(pool);
+  MEM_ARENA_t inited;
+  bool ok;
+
+  MEM_ARENA_Init(&inited, pool, sizeof(pool));
+  ok = (arena.Base == inited.Base) && (arena.Size == inited.Size) && (arena.Used == 0U) && (arena.Failed == 0U);
+
+  uint8_t *a = (uint8_t *)MEM_ARENA_Alloc(&arena, 1U);
+  uint8_t *b = (uint8_t *)MEM_ARENA_Alloc(&arena, 8U);
+  uint8_t *c = (uint8_t *)MEM_ARENA_Alloc(&arena, 9U);
+  ok &= (a == &pool[0]) && (b == &pool[8]) && (c == &pool[16]) && (MEM_ARENA_Available(&arena) == 32U);
+
+  /* Refused requests take nothing */
+  ok &= (MEM_ARENA_Alloc(&arena, 0U) == nullptr) && (MEM_ARENA_Alloc(&arena, 33U) == nullptr)
+        && (MEM_ARENA_Alloc(&arena, 0xFFFFFFFFU) == nullptr) && (MEM_ARENA_Alloc(&arena, 0xFFFFFFF9U) == nullptr)
+        && (arena.Failed == 4U) && (MEM_ARENA_Available(&arena) == 32U);
+
+  /* The last byte can be taken, nothing after it */
+  ok &= (MEM_ARENA_Alloc(&arena, 32U) == &pool[32]) && (MEM_ARENA_Available(&arena) == 0U)
+        && (MEM_ARENA_Alloc(&arena, 1U) == nullptr) && (arena.Failed == 5U);
+
+  ok &= (MEM_ARENA_ROUND(0U) == 0U) && (MEM_ARENA_ROUND(7U) == 8U) && (MEM_ARENA_ROUND(8U) == 8U)
+        && (MEM_ARENA_ROUND(1000U) == 1000U) && (MEM_ARENA_ROUND(2336U) == 2336U) && (MEM_ARENA_ROUND(416U) == 416U)
+        && (MEM_BUDGET_ROUND(13) == 16);
+
+  std::printf("arena edge cases                     %s\n", ok ? "ok" : "FAILED");
+  return ok;
+}
+
+/**
+  * @brief  Check the arena against a reference model on random requests
+  * @retval true if all pass
+  */
+static bool ArenaRandom()
+{
+  std::mt19937 rng(54);
+  uint32_t runs = 0;
+  uint32_t blocks = 0;
+  uint32_t refused = 0;
+  bool ok = true;
+
+  for (runs = 0; runs < 20000U; runs++)
+  {
+    uint32_t size = 8U * (1U + (rng() % 512U));
+    std::vector<uint64_t> storage(size / 8U);
+    std::vector<uint8_t> owner(size, 0xFFU);
+    MEM_ARENA_t arena;
+    uint32_t used = 0;
+    uint32_t failed = 0;
+
+    MEM_ARENA_Init(&arena, storage.data(), size);
+    for (uint32_t n = 0; n < 64U; n++)
+    {
+      /* Mostly small, sometimes over the remaining space or zero */
+      uint32_t req = ((rng() % 8U) == 0U) ? (rng() % (size + 16U)) : (rng() % 64U);
+      uint8_t *block = (uint8_t *)MEM_ARENA_Alloc(&arena, req);
+      uint32_t rounded = (req + 7U) & ~7U;
+
+      if ((req == 0U) || (rounded > (size - used)))
+      {
+        failed++;
+        refused++;
+        ok &= (block == nullptr);
+        continue;
+      }
+
+      uint32_t off = (uint32_t)(block - (uint8_t *)storage.data());
+      ok &= (block != nullptr) && (off == used) && ((off % MEM_ARENA_ALIGNMENT) == 0U)
+            && (((uintptr_t)block % MEM_ARENA_ALIGNMENT) == 0U);
+      for (uint32_t i = 0; ok && (i < rounded); i++)
+      {
+        ok = (owner[off + i] == 0xFFU);
+        owner[off + i] = (uint8_t)n;
+      }
+      used += rounded;
+      blocks++;
+    }
+    ok &= (arena.Used == used) && (arena.Failed == failed) && (MEM_ARENA_Available(&arena) == (size - used));
+    if (!ok)
+    {
+      break;
+    }
+  }
+
+  std::printf("arena random, %5u pools            %u blocks, %u refused  %s\n", runs, blocks, refused,
+              ok ? "ok" : "FAILED");
+  return ok;
+}
+
+/**
+  * @brief  Take every entry of the budget and check the pools end empty
+  * @retval true if all pass
+  */
+static bool Budget()
+{
+  uint32_t total[3] = { 0U, 0U, 0U };
+  bool ok = true;
+
+  for (const Entry &e : Entries)
+  {
+    total[e.Region] += MEM_ARENA_ROUND(e.Size);
+  }
+  ok &= (total[MEM_BUDGET_SRAM1] == (uint32_t)MEM_BUDGET_TOTAL(MEM_BUDGET_SRAM1))
+        && (total[MEM_BUDGET_SRAM2] == (uint32_t)MEM_BUDGET_TOTAL(MEM_BUDGET_SRAM2));
+  ok &= (MEM_BUDGET_Available(MEM_BUDGET_SRAM1) == total[MEM_BUDGET_SRAM1])
+        && (MEM_BUDGET_Available(MEM_BUDGET_SRAM2) == total[MEM_BUDGET_SRAM2]);
+
+  std::vector<std::pair<uint8_t *, uint32_t>> taken;
+  for (const Entry &e : Entries)
+  {
+    uint8_t *block = (uint8_t *)MEM_BUDGET_Alloc(e.Region, e.Size);
+    bool zero = (block != nullptr);
+
+    for (uint32_t i = 0; zero && (i < e.Size); i++)
+    {
+      zero = (block[i] == 0U);
+    }
+    for (const std::pair<uint8_t *, uint32_t> &t : taken)
+    {
+      ok &= (block == nullptr) || ((block + e.Size) <= t.first) || ((t.first + t.second) <= block);
+    }
+    std::printf("  %-12s %5u bytes  SRAM%u  %s\n", e.Name, e.Size, e.Region,
+                (zero && (((uintptr_t)block % MEM_ARENA_ALIGNMENT) == 0U)) ? "ok" : "FAILED");
+    ok &= zero && (((uintptr_t)block % MEM_ARENA_ALIGNMENT) == 0U);
+    if (block != nullptr)
+    {
+      taken.push_back({ block, e.Size });
+    }
+  }
+  ok &= (ErrorCalls == 0U);
+
+  std::printf("  SRAM1 %5u of %5u bytes, SRAM2 %5u of %5u bytes\n", total[MEM_BUDGET_SRAM1],
+              (uint32_t)MEM_BUDGET_SRAM1_LIMIT, total[MEM_BUDGET_SRAM2], (uint32_t)MEM_BUDGET_SRAM2_LIMIT);
+
+  /* The pools are sized exactly, anything more is a configuration error */
+  bool over = (MEM_BUDGET_Available(MEM_BUDGET_SRAM1) == 0U) && (MEM_BUDGET_Available(MEM_BUDGET_SRAM2) == 0U)
+              && (MEM_BUDGET_Alloc(MEM_BUDGET_SRAM1, 1U) == nullptr) && (ErrorCalls == 1U)
+              && (MEM_BUDGET_Alloc(MEM_BUDGET_SRAM2, 1U) == nullptr) && (ErrorCalls == 2U)
+              && (MEM_BUDGET_Alloc(3U, 8U) == nullptr) && (ErrorCalls == 3U)
+              && (MEM_BUDGET_Available(3U) == 0U) && (MEM_BUDGET_Available(0U) == 0U);
+
+  std::printf("budget pools exact, overflow refused %s\n", (ok && over) ? "ok" : "FAILED");
+  return ok && over;
+}
+
+/**
+  * @brief  Check every entry is taken by the sources of a tree
+  * @param  Tree the firmware tree
+  * @retval true if all pass
+  */
+static bool Sources(const std::filesystem::path &Tree)
+{
+  std::string all;
+  std::string missing;
+
+  for (const char *sub : { "Core/Src", "MEMS/App", "MEMS/Target" })
+  {
+    for (const auto &e : std::filesystem::directory_iterator(Tree / sub))
+    {
+      if (e.path().extension() == ".c")
+      {
+        std::ifstream in(e.path());
+        std::stringstream ss;
+        ss << in.rdbuf();
+        all += ss.str();
+      }
+    }
+  }
+  for (const Entry &e : Entries)
+  {
+    if (all.find(std::string("MEM_BUDGET_ALLOC(") + e.Name + ")") == std::string::npos)
+    {
+      missing += std::string(" ") + e.Name;
+    }
+  }
+
+  std::printf("entries taken by the sources         %s%s\n", missing.empty() ? "ok" : "FAILED, not taken:",
+              missing.c_str());
+  return missing.empty();
+}
+
+int main(int argc, char **argv)
+{
+  bool ok = true;
+
+  ok &= ArenaEdges();
+  ok &= ArenaRandom();
+  ok &= Budget();
+  if (argc > 1)
+  {
+    ok &= Sources(argv[1]);
+  }
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,542 @@
+/**
+  ******************************************************************************
+  * @file    placement_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the SRAM1/SRAM2 placement of the linker scripts and startup
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * No ARM toolchain on the host, so nothing is linked here. Instead, for each
+ * firmware tree:
+ *
+ *  - memory map: the MEMORY regions of STM32WL55JCIX_FLASH.ld split the
+ *    64K of SRAM without overlap, RAM being SRAM1 at 0x20000000,
+ *  - sections: .ram2_text runs from RAM2 and loads from FLASH, comes before
+ *    .text so its input sections are taken there, and .data no longer takes
+ *    .RamFunc; .ram2_bss is NOLOAD in RAM2,
+ *  - startup: Reset_Handler of startup_stm32wl55jcix.s is interpreted on a
+ *    simulated memory. .data and .ram2_text must hold their flash image,
+ *    .bss and .ram2_bss zero, and no other word may be written,
+ *  - code in RAM: .ram2_text takes .RamFunc only, the handlers and callbacks
+ *    stay in flash, and RAM_FUNC adds the .RamFunc section only when the
+ *    build sets MEM_PLACEMENT_RAM_CODE to 1,
+ *  - sources: every file using RAM_FUNC, RAM2_BSS or IPC_SHARED gets
+ *    mem_placement.h, else the attribute is silently an unknown identifier,
+ *  - SRAM1: what the baseline Debug ELF used of it.
+ */
+
+struct Region
+{
+  std::string Name;
+  uint32_t Origin;
+  uint32_t Length;
+};
+
+struct Layout
+{
+  const char *Name;
+  uint32_t Data;      /* .data size */
+  uint32_t Bss;       /* .bss size */
+  uint32_t Ram2Text;  /* .ram2_text size */
+  uint32_t Ram2Bss;   /* .ram2_bss size */
+};
+
+static bool Ok = true;
+
+/**
+  * @brief  Print and account a check
+  * @param  Pass the check result
+  * @param  What the check
+  * @retval None
+  */
+static void Expect(bool Pass, const std::string &What)
+{
+  std::printf("  %-58s %s\n", What.c_str(), Pass ? "ok" : "FAILED");
+  Ok &= Pass;
+}
+
+/**
+  * @brief  Read a whole file
+  * @param  Path the file
+  * @retval The content, empty if the file cannot be read
+  */
+static std::string ReadFile(const std::filesystem::path &Path)
+{
+  std::ifstream in(Path, std::ios::binary);
+  std::stringstream ss;
+
+  ss << in.rdbuf();
+  return ss.str();
+}
+
+/**
+  * @brief  Parse the MEMORY block of a linker script
+  * @param  Ld the linker script
+  * @retval The regions, in order
+  */
+static std::vector<Region> Regions(const std::string &Ld)
+{
+  std::vector<Region> regions;
+  size_t start = Ld.find("MEMORY");
+  size_t end = Ld.find('}', start);
+  std::string block = Ld.substr(start, end - start);
+  std::regex line(R"((\w+)\s*\(\w+\)\s*:\s*ORIGIN\s*=\s*(0x[0-9A-Fa-f]+)\s*,\s*LENGTH\s*=\s*(\d+)K)");
+
+  for (std::sregex_iterator it(block.begin(), block.end(), line), last; it != last; ++it)
+  {
+    regions.push_back({ (*it)[1], (uint32_t)std::stoul((*it)[2], nullptr, 16),
+                        (uint32_t)std::stoul((*it)[3]) * 1024U });
+  }
+  return regions;
+}
+
+/**
+  * @brief  Get an output section of a linker script
+  * @param  Ld the linker script
+  * @param  Name the section, with its options, e.g. ".ram2_bss (NOLOAD)"
+  * @param  Pos the offset of the section, npos if absent
+  * @retval The section from its name to the end of its region line
+  */
+static std::string Section(const std::string &Ld, const std::string &Name, size_t *Pos)
+{
+  std::regex head("\n[ \t]*" + std::regex_replace(Name, std::regex(R"([.()])"), R"(\$&)") + R"(\s*:)");
+  std::smatch m;
+
+  *Pos = std::string::npos;
+  if (!std::regex_search(Ld, m, head))
+  {
+    return "";
+  }
+  *Pos = (size_t)m.position(0);
+  size_t close = Ld.find('}', *Pos);
+  size_t eol = Ld.find('\n', close);
+  return Ld.substr(*Pos, eol - *Pos);
+}
+
+/**
+  * @brief  Check the memory map and the output sections of a linker script
+  * @param  Ld the linker script
+  * @retval None
+  */
+static void CheckLinker(const std::string &Ld)
+{
+  std::vector<Region> regions = Regions(Ld);
+  std::map<std::string, Region> byName;
+  uint32_t sram = 0;
+  bool inside = true;
+  bool disjoint = true;
+
+  for (const Region &r : regions)
+  {
+    byName[r.Name] = r;
+    if ((r.Origin >> 24) == 0x20U)
+    {
+      sram += r.Length;
+      inside &= (r.Origin >= 0x20000000U) && ((r.Origin + r.Length) <= 0x20010000U);
+      for (const Region &o : regions)
+      {
+        disjoint &= (&o == &r) || ((o.Origin >> 24) != 0x20U) || ((o.Origin + o.Length) <= r.Origin)
+                    || ((r.Origin + r.Length) <= o.Origin);
+      }
+    }
+  }
+
+  Expect(byName.count("RAM") && (byName["RAM"].Origin == 0x20000000U) && (byName["RAM"].Length == 32768U),
+         "RAM is SRAM1, 0x20000000 32K");
+  Expect(byName.count("RAM2") && (byName["RAM2"].Origin == 0x20008000U), "RAM2 is SRAM2, 0x20008000");
+  Expect(inside && disjoint && (sram == 65536U), "SRAM regions disjoint, 64K in total");
+  Expect(byName.count("FLASH") && (byName["FLASH"].Length == 262144U), "FLASH 256K");
+
+  size_t textPos, ram2TextPos, dataPos, ram2BssPos;
+  std::string ram2Text = Section(Ld, ".ram2_text", &ram2TextPos);
+  std::string text = Section(Ld, ".text", &textPos);
+  std::string data = Section(Ld, ".data", &dataPos);
+  std::string ram2Bss = Section(Ld, ".ram2_bss (NOLOAD)", &ram2BssPos);
+
+  Expect((ram2TextPos != std::string::npos) && (textPos != std::string::npos) && (ram2TextPos < textPos),
+         ".ram2_text before .text");
+  Expect(std::regex_search(ram2Text, std::regex(R"(\}\s*>RAM2\s+AT>\s*FLASH)")), ".ram2_text >RAM2 AT> FLASH");
+  Expect((ram2Text.find("*(.RamFunc)") != std::string::npos) && (data.find("RamFunc") == std::string::npos),
+         ".RamFunc in .ram2_text, not in .data");
+  Expect(ram2Text.find("*(.text") == std::string::npos, ".ram2_text takes no handler or callback");
+  Expect((ram2Text.find("_sram2_text = .") != std::string::npos)
+         && (ram2Text.find("_eram2_text = .") != std::string::npos)
+         && (Ld.find("_siram2_text = LOADADDR(.ram2_text)") != std::string::npos),
+         ".ram2_text start, end and load symbols");
+  Expect((ram2BssPos != std::string::npos) && std::regex_search(ram2Bss, std::regex(R"(\}\s*>RAM2\s*$)"))
+         && (ram2Bss.find("_sram2_bss = .") != std::string::npos)
+         && (ram2Bss.find("_eram2_bss = .") != std::string::npos),
+         ".ram2_bss NOLOAD >RAM2 with start and end symbols");
+}
+
+/**
+  * @brief  Run Reset_Handler up to the static constructors on a simulated memory
+  * @param  Asm the startup file
+  * @param  Symbols the linker symbols
+  * @param  Memory the memory, words written are updated
+  * @param  Written the addresses written
+  * @retval true if the code ran to __libc_init_array
+  */
+static bool RunStartup(const std::string &Asm, const std::map<std::string, uint32_t> &Symbols,
+                       std::map<uint32_t, uint32_t> &Memory, std::set<uint32_t> &Written)
+{
+  std::vector<std::vector<std::string>> code;
+  std::map<std::string, size_t> labels;
+  std::istringstream lines(Asm.substr(Asm.find("\nReset_Handler:")));
+  std::string line;
+
+  /* Tokenize up to LoopForever: mnemonic and operands, brackets dropped */
+  while (std::getline(lines, line))
+  {
+    line = std::regex_replace(line, std::regex(R"(/\*.*\*/)"), "");
+    std::smatch m;
+    if (std::regex_match(line, m, std::regex(R"(\s*(\w+):\s*)")))
+    {
+      if (m[1] == "LoopForever")
+      {
+        break;
+      }
+      labels[m[1]] = code.size();
+      continue;
+    }
+    line = std::regex_replace(line, std::regex(R"([\[\],#=])"), " ");
+    std::istringstream words(line);
+    std::vector<std::string> ins;
+    for (std::string w; words >> w;)
+    {
+      ins.push_back(w);
+    }
+    if (!ins.empty() && (ins[0][0] != '.'))
+    {
+      code.push_back(ins);
+    }
+  }
+
+  std::map<std::string, uint32_t> reg;
+  auto load = [&](uint32_t Addr) -> uint32_t
+  {
+    return Memory.count(Addr) ? Memory[Addr] : (0xA5A5A5A5U ^ Addr);
+  };
+
+  bool carry = false;
+  size_t pc = 0;
+  for (uint32_t steps = 0; (pc < code.size()) && (steps < 1000000U); steps++)
+  {
+    const std::vector<std::string> &i = code[pc++];
+    const std::string &op = i[0];
+
+    if ((op == "bl") && (i[1] == "__libc_init_array"))
+    {
+      return true;
+    }
+    else if (op == "bl")
+    {
+      /* SystemInit touches no memory of the sections */
+    }
+    else if ((op == "ldr") && (i.size() == 3U))
+    {
+      if (!Symbols.count(i[2]))
+      {
+        return false;
+      }
+      reg[i[1]] = Symbols.at(i[2]);
+    }
+    else if (op == "ldr")
+    {
+      reg[i[1]] = load(reg[i[2]] + reg[i[3]]);
+    }
+    else if (op == "str")
+    {
+      uint32_t addr = reg[i[2]] + ((i.size() == 4U) ? reg[i[3]] : 0U);
+      Memory[addr] = reg[i[1]];
+      Written.insert(addr);
+    }
+    else if ((op == "mov") || (op == "movs"))
+    {
+      reg[i[1]] = std::isdigit((unsigned char)i[2][0]) ? (uint32_t)std::stoul(i[2], nullptr, 0) : reg[i[2]];
+    }
+    else if (op == "adds")
+    {
+      reg[i[1]] = reg[i[2]] + (std::isdigit((unsigned char)i[3][0]) ? (uint32_t)std::stoul(i[3], nullptr, 0)
+                                                                     : reg[i[3]]);
+    }
+    else if (op == "cmp")
+    {
+      /* ARM carry on compare is "no borrow", bcc branches when lower */
+      carry = (reg[i[1]] >= reg[i[2]]);
+    }
+    else if ((op == "b") || ((op == "bcc") && !carry))
+    {
+      if (!labels.count(i[1]))
+      {
+        return false;
+      }
+      pc = labels[i[1]];
+    }
+    else if (op != "bcc")
+    {
+      std::printf("  unknown instruction %s\n", op.c_str());
+      return false;
+    }
+  }
+  return false;
+}
+
+/**
+  * @brief  Check the startup initialization on a section layout
+  * @param  Asm the startup file
+  * @param  L the section sizes
+  * @param  Ram2End the end of the RAM2 region
+  * @retval None
+  */
+static void CheckStartup(const std::string &Asm, const Layout &L, uint32_t Ram2End)
+{
+  std::map<std::string, uint32_t> sym;
+  std::map<uint32_t, uint32_t> mem;
+  std::set<uint32_t> written;
+
+  /* Load images follow each other in flash, as the linker lays them out */
+  sym["_estack"] = 0x20008000U;
+  sym["_sdata"] = 0x20000000U;
+  sym["_edata"] = sym["_sdata"] + L.Data;
+  sym["_sbss"] = sym["_edata"];
+  sym["_ebss"] = sym["_sbss"] + L.Bss;
+  sym["_sram2_text"] = 0x20008000U;
+  sym["_eram2_text"] = sym["_sram2_text"] + L.Ram2Text;
+  sym["_sram2_bss"] = sym["_eram2_text"];
+  sym["_eram2_bss"] = sym["_sram2_bss"] + L.Ram2Bss;
+  sym["_siram2_text"] = 0x08010000U;
+  sym["_sidata"] = sym["_siram2_text"] + L.Ram2Text;
+
+  for (uint32_t a = 0x08010000U; a < (sym["_sidata"] + L.Data); a += 4U)
+  {
+    mem[a] = a * 2654435761U;
+  }
+
+  bool ran = RunStartup(Asm, sym, mem, written);
+  bool copied = true;
+  bool zeroed = true;
+  size_t expected = 0;
+
+  for (uint32_t o = 0; o < L.Data; o += 4U, expected++)
+  {
+    copied &= written.count(sym["_sdata"] + o) && (mem[sym["_sdata"] + o] == mem[sym["_sidata"] + o]);
+  }
+  for (uint32_t o = 0; o < L.Ram2Text; o += 4U, expected++)
+  {
+    copied &= written.count(sym["_sram2_text"] + o)
+              && (mem[sym["_sram2_text"] + o] == mem[sym["_siram2_text"] + o]);
+  }
+  for (uint32_t o = 0; o < L.Bss; o += 4U, expected++)
+  {
+    zeroed &= written.count(sym["_sbss"] + o) && (mem[sym["_sbss"] + o] == 0U);
+  }
+  for (uint32_t o = 0; o < L.Ram2Bss; o += 4U, expected++)
+  {
+    zeroed &= written.count(sym["_sram2_bss"] + o) && (mem[sym["_sram2_bss"] + o] == 0U);
+  }
+
+  bool bounded = (written.size() == expected) && (sym["_eram2_bss"] <= Ram2End)
+                 && (written.empty() || (*written.rbegin() < sym["_eram2_bss"]) || (L.Ram2Bss == 0U));
+  char what[96];
+  std::snprintf(what, sizeof(what), "startup, %s: copied %s, zeroed %s, %zu words",
+                L.Name, copied ? "yes" : "no", zeroed ? "yes" : "no", written.size());
+  Expect(ran && copied && zeroed && bounded, what);
+}
+
+/**
+  * @brief  Tell if a source gets mem_placement.h, following the project headers
+  * @param  File the source
+  * @param  Dirs the include directories of the tree
+  * @param  Seen the headers already followed
+  * @retval true if mem_placement.h is included
+  */
+static bool Includes(const std::filesystem::path &File, const std::vector<std::filesystem::path> &Dirs,
+                     std::set<std::string> &Seen)
+{
+  std::string src = ReadFile(File);
+  std::regex inc(R"(#include\s+"([^"]+)\")");
+
+  for (std::sregex_iterator it(src.begin(), src.end(), inc), last; it != last; ++it)
+  {
+    std::string name = (*it)[1];
+    if (name == "mem_placement.h")
+    {
+      return true;
+    }
+    if (!Seen.insert(name).second)
+    {
+      continue;
+    }
+    for (const std::filesystem::path &d : Dirs)
+    {
+      if (std::filesystem::exists(d / name) && Includes(d / name, Dirs, Seen))
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+  * @brief  Check the includes of the sources using the placement attributes
+  * @param  Tree the firmware tree
+  * @retval None
+  */
+static void CheckSources(const std::filesystem::path &Tree)
+{
+  std::vector<std::filesystem::path> dirs = { Tree / "Core/Inc", Tree / "MEMS/App", Tree / "MEMS/Target" };
+  std::regex use(R"((^|[^_\w])(RAM_FUNC|RAM2_BSS|IPC_SHARED)\b)");
+  uint32_t users = 0;
+  std::string missing;
+
+  for (const char *sub : { "Core/Src", "MEMS/App", "MEMS/Target" })
+  {
+    for (const auto &e : std::filesystem::directory_iterator(Tree / sub))
+    {
+      if (e.path().extension() != ".c")
+      {
+        continue;
+      }
+      std::string src = ReadFile(e.path());
+      if (!std::regex_search(src, use))
+      {
+        continue;
+      }
+      std::set<std::string> seen;
+      users++;
+      if (!Includes(e.path(), dirs, seen))
+      {
+        missing += " " + e.path().filename().string();
+      }
+    }
+  }
+
+  Expect(missing.empty(), std::to_string(users) + " sources with placement attributes include it" + missing);
+}
+
+/**
+  * @brief  Check that RAM_FUNC code stays in flash unless the build asks
+  * @param  Tree the firmware tree
+  * @retval None
+  */
+static void CheckRamCode(const std::filesystem::path &Tree)
+{
+  std::string h = ReadFile(Tree / "Core/Inc/mem_placement.h");
+  std::smatch m;
+  bool gated = std::regex_search(h, m, std::regex(R"(#if \(MEM_PLACEMENT_RAM_CODE == 1\)\s*\n#define RAM_FUNC\s+__attribute__\(\(section\("\.RamFunc"\))"))
+               && (h.find("section(\".RamFunc\")", (size_t)(m.position(0) + m.length(0))) == std::string::npos);
+
+  Expect(std::regex_search(h, std::regex(R"(#ifndef MEM_PLACEMENT_RAM_CODE\s*\n#define MEM_PLACEMENT_RAM_CODE\s+0\s*\n)"))
+         && gated, "RAM_FUNC in flash unless MEM_PLACEMENT_RAM_CODE is 1");
+}
+
+/**
+  * @brief  Report the SRAM1 use of the baseline Debug ELF
+  * @param  Elf the ELF image
+  * @retval None
+  */
+static void ReportSram1(const std::string &Elf)
+{
+  if ((Elf.size() < 52U) || (Elf.compare(0, 4, "\x7f" "ELF") != 0) || (Elf[4] != 1))
+  {
+    std::printf("  no 32-bit Debug ELF, SRAM1 use not reported\n");
+    return;
+  }
+
+  auto u32 = [&](size_t Off) { uint32_t v; std::memcpy(&v, &Elf[Off], 4U); return v; };
+  auto u16 = [&](size_t Off) { uint16_t v; std::memcpy(&v, &Elf[Off], 2U); return v; };
+
+  uint32_t shoff = u32(32U);
+  uint16_t shentsize = u16(46U);
+  uint16_t shnum = u16(48U);
+  uint32_t sram1 = 0;
+
+  for (uint16_t s = 0; s < shnum; s++)
+  {
+    size_t sh = shoff + ((size_t)s * shentsize);
+
+    /* .data, .bss and the heap and stack reserve */
+    if (((u32(sh + 12U) >> 24) == 0x20U) && ((u32(sh + 8U) & 2U) != 0U))
+    {
+      sram1 += u32(sh + 20U);
+    }
+  }
+
+  std::printf("  baseline Debug ELF: %u bytes of SRAM1 used, of 32768\n", sram1);
+}
+
+int main(int argc, char **argv)
+{
+  std::vector<std::filesystem::path> trees;
+
+  for (int i = 1; i < argc; i++)
+  {
+    trees.push_back(argv[i]);
+  }
+  if (trees.empty())
+  {
+    trees = { "../../SHUBv3_MLC", "../../SHUBv3_MLC_DataLogFusion" };
+  }
+
+  for (const std::filesystem::path &tree : trees)
+  {
+    std::string ld = ReadFile(tree / "STM32WL55JCIX_FLASH.ld");
+    std::string startup = ReadFile(tree / "Core/Startup/startup_stm32wl55jcix.s");
+    std::string elf = ReadFile(tree / "Debug" / (tree.filename().string() + ".elf"));
+
+    std::printf("%s\n", tree.filename().c_str());
+    if (ld.empty() || startup.empty())
+    {
+      Expect(false, "linker script and startup found");
+      continue;
+    }
+
+    CheckLinker(ld);
+
+    uint32_t ram2End = 0;
+    for (const Region &r : Regions(ld))
+    {
+      ram2End = (r.Name == "RAM2") ? (r.Origin + r.Length) : ram2End;
+    }
+    const Layout layouts[] =
+    {
+      { "typical", 0xECU, 0x854U, 0x600U, 0x3000U },
+      { "empty RAM2", 0xECU, 0x854U, 0U, 0U },
+      { "empty RAM1", 0U, 0U, 0x40U, 0x100U },
+      { "RAM2 full", 0x10U, 0x20U, 0x400U, (ram2End - 0x20008400U) },
+    };
+    for (const Layout &l : layouts)
+    {
+      CheckStartup(startup, l, ram2End);
+    }
+
+    CheckRamCode(tree);
+    CheckSources(tree);
+    ReportSram1(elf);
+  }
+
+  std::printf("%s\n", Ok ? "all checks passed" : "checks FAILED");
+  return Ok ? 0 : 1;
+}
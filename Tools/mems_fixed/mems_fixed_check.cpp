@@ -0,0 +1,182 @@
+/**
+  ******************************************************************************
+  * @file    mems_fixed_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the fixed-point sample scaling against the float driver path
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "mems_fixed.h"
+
+/*
+ * Runs the firmware mems_fixed.c on a host. BSP_SENSOR_ACC_GetAxesFixed and
+ * BSP_SENSOR_GYR_GetAxesFixed read the raw registers and scale them with
+ * MEMS_FIXED_Scale and the sensitivity cached for the full scale. The
+ * former path, LSM6DSOX_ACC_GetAxes and LSM6DSOX_GYRO_GetAxes, multiplies
+ * the raw value by the float sensitivity of lsm6dsox.h and truncates to
+ * integer milli-units. Every raw value of every full scale goes through
+ * both paths and is compared with the exact product in double:
+ *
+ *  - serialized: MEMS_FIXED_ToMilli against the truncated float, within
+ *    one milli-unit,
+ *  - fusion input: MEMS_FIXED_ToUnit against the Q23.8 value, within the
+ *    rounding of a float,
+ *  - error to the exact value of both, the fixed path must not be worse.
+ */
+
+struct Scale
+{
+  const char *Name;
+  bool Acc;
+  int32_t FullScale;
+  float Sensitivity;  /* lsm6dsox.h [milli-unit/LSB] */
+};
+
+struct Result
+{
+  double FixedErr;   /* Largest error of the Q23.8 value [milli-unit] */
+  double FloatErr;   /* Largest error of the truncated float [milli-unit] */
+  double UnitRel;    /* Largest relative error of ToUnit to the Q23.8 value */
+  int32_t MilliDiff; /* Largest |ToMilli - truncated float| */
+};
+
+/**
+  * @brief  Run every raw value through both paths
+  * @param  S the full scale
+  * @param  Sens the Q16 sensitivity of mems_fixed
+  * @retval The largest errors
+  */
+static Result Compare(const Scale &S, uint32_t Sens)
+{
+  Result r = {};
+
+  for (int32_t raw = -32768; raw <= 32767; raw++)
+  {
+    double exact = (double)raw * (double)S.Sensitivity;
+    int32_t trunc = (int32_t)((float)((float)raw * S.Sensitivity));
+    mems_q8_t q = MEMS_FIXED_ScaleOne((int16_t)raw, Sens);
+    double fixed = (double)q / (double)MEMS_FIXED_ONE;
+    double unit = (double)MEMS_FIXED_ToUnit(q) * 1000.0;
+
+    r.FixedErr = std::fmax(r.FixedErr, std::fabs(fixed - exact));
+    r.FloatErr = std::fmax(r.FloatErr, std::fabs((double)trunc - exact));
+    r.UnitRel = std::fmax(r.UnitRel, std::fabs(unit - fixed) / std::fmax(std::fabs(fixed), 1.0));
+    r.MilliDiff = std::max(r.MilliDiff, std::abs(MEMS_FIXED_ToMilli(q) - trunc));
+  }
+
+  return r;
+}
+
+#ifdef MEMS_FIXED_M4_IR
+extern "C" void fixed_scale(int16_t x, int16_t y, int16_t z, uint32_t Sens, MEMS_FIXED_Axes_t *Axes);
+extern "C" void float_scale(int16_t x, int16_t y, int16_t z, uint32_t Sens, MEMS_FIXED_Axes_t *Axes);
+
+/**
+  * @brief  Check that the two paths of scale_m4.ll compute what the firmware
+  *         does, so that their Cortex-M4 counts are those of the firmware
+  * @param  Scales the full scales
+  * @param  Count the number of full scales
+  * @retval true if every raw value gives the same result
+  */
+static bool CheckIr(const Scale *Scales, size_t Count)
+{
+  uint32_t mismatches = 0;
+
+  for (size_t i = 0; i < Count; i++)
+  {
+    const Scale &s = Scales[i];
+    uint32_t sens = 0;
+    uint32_t bits;
+
+    (void)(s.Acc ? MEMS_FIXED_AccSensitivity(s.FullScale, &sens) : MEMS_FIXED_GyroSensitivity(s.FullScale, &sens));
+    std::memcpy(&bits, &s.Sensitivity, sizeof(bits));
+    for (int32_t raw = -32768; raw <= 32767; raw++)
+    {
+      int16_t x = (int16_t)raw;
+      int16_t y = (int16_t)(-raw - 1);
+      int16_t z = (int16_t)(raw / 3);
+      MEMS_FIXED_Axes_t fw;
+      MEMS_FIXED_Axes_t ir;
+
+      MEMS_FIXED_Scale(x, y, z, sens, &fw);
+      fixed_scale(x, y, z, sens, &ir);
+      mismatches += (ir.x != fw.x) || (ir.y != fw.y) || (ir.z != fw.z);
+
+      float_scale(x, y, z, bits, &ir);
+      mismatches += (ir.x != (int32_t)((float)x * s.Sensitivity)) || (ir.y != (int32_t)((float)y * s.Sensitivity))
+                    || (ir.z != (int32_t)((float)z * s.Sensitivity));
+    }
+  }
+
+  std::printf("m4 ir           %u mismatches  %s\n", mismatches, (mismatches == 0U) ? "ok" : "FAILED");
+  return mismatches == 0U;
+}
+#endif /* MEMS_FIXED_M4_IR */
+
+int main()
+{
+  bool ok = true;
+
+  const Scale scales[] =
+  {
+    { "acc 2 g", true, 2, 0.061f },
+    { "acc 4 g", true, 4, 0.122f },
+    { "acc 8 g", true, 8, 0.244f },
+    { "acc 16 g", true, 16, 0.488f },
+    { "gyro 125 dps", false, 125, 4.375f },
+    { "gyro 250 dps", false, 250, 8.750f },
+    { "gyro 500 dps", false, 500, 17.500f },
+    { "gyro 1000 dps", false, 1000, 35.000f },
+    { "gyro 2000 dps", false, 2000, 70.000f },
+  };
+
+  for (const Scale &s : scales)
+  {
+    uint32_t sens = 0;
+    int32_t ret = s.Acc ? MEMS_FIXED_AccSensitivity(s.FullScale, &sens)
+                        : MEMS_FIXED_GyroSensitivity(s.FullScale, &sens);
+    Result r = Compare(s, sens);
+
+    /* The Q16 sensitivity is within half an LSB of the float one and the
+     * Q23.8 value truncates 1/256: over 32768 LSB that is 0.25 + 1/256 */
+    bool pass = (ret == MEMS_FIXED_OK) && (r.MilliDiff <= 1) && (r.FixedErr <= (0.25 + (1.0 / 256.0)))
+                && (r.FixedErr <= r.FloatErr) && (r.UnitRel <= std::ldexp(1.0, -22));
+
+    std::printf("%-14s  sens %8u  error fixed %.4f  float %.4f  unit %.1e  milli diff %d  %s\n",
+                s.Name, sens, r.FixedErr, r.FloatErr, r.UnitRel, r.MilliDiff, pass ? "ok" : "FAILED");
+    ok &= pass;
+  }
+
+  /* Full scales the sensor does not have */
+  uint32_t sens = 1234U;
+  bool edges = (MEMS_FIXED_AccSensitivity(3, &sens) == MEMS_FIXED_ERROR)
+               && (MEMS_FIXED_GyroSensitivity(4000, &sens) == MEMS_FIXED_ERROR) && (sens == 1234U)
+               && (MEMS_FIXED_ToMilli(MEMS_FIXED_FromMilli(-1000)) == -1000)
+               && (MEMS_FIXED_ToMilli(-MEMS_FIXED_ONE / 2) == 0);
+  MEMS_FIXED_Axes_t axes;
+  MEMS_FIXED_Scale(-32768, 0, 32767, 4587520U, &axes);
+  edges &= (axes.x == (-32768 * 70 * MEMS_FIXED_ONE)) && (axes.y == 0) && (axes.z == (32767 * 70 * MEMS_FIXED_ONE));
+  std::printf("edge cases      %s\n", edges ? "ok" : "FAILED");
+  ok &= edges;
+
+#ifdef MEMS_FIXED_M4_IR
+  ok &= CheckIr(scales, sizeof(scales) / sizeof(scales[0]));
+#endif /* MEMS_FIXED_M4_IR */
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+; Both sample scaling paths as LLVM IR, for llc and llvm-mca
+;
+; fixed_scale   MEMS_FIXED_Scale of mems_fixed.c: per axis one 32x32->64
+;               multiply and a shift
+; float_scale   the former LSM6DSOX_ACC_GetAxes arithmetic,
+;               (int32_t)((float)raw * sensitivity) per axis, with the three
+;               soft-float helpers of an FPU-less Cortex-M4
+;
+; The helpers stay out of line, called as the __aeabi routines are. They
+; keep only the path a sensor sample takes: finite operands, no overflow or
+; subnormal result. Zero operands and the round to nearest even are kept,
+; as selects. The library routines add their special case tests to this,
+; so float_scale is a lower bound of the float path.
+
+; MEMS_FIXED_Axes_t
+%axes = type { i32, i32, i32 }
+
+define void @fixed_scale(i16 signext %x, i16 signext %y, i16 signext %z, i32 %sens, %axes* %out) {
+  %s = zext i32 %sens to i64
+  %x64 = sext i16 %x to i64
+  %y64 = sext i16 %y to i64
+  %z64 = sext i16 %z to i64
+  %px = mul nsw i64 %x64, %s
+  %py = mul nsw i64 %y64, %s
+  %pz = mul nsw i64 %z64, %s
+  %qx = ashr i64 %px, 8
+  %qy = ashr i64 %py, 8
+  %qz = ashr i64 %pz, 8
+  %rx = trunc i64 %qx to i32
+  %ry = trunc i64 %qy to i32
+  %rz = trunc i64 %qz to i32
+  %ox = getelementptr %axes, %axes* %out, i32 0, i32 0
+  %oy = getelementptr %axes, %axes* %out, i32 0, i32 1
+  %oz = getelementptr %axes, %axes* %out, i32 0, i32 2
+  store i32 %rx, i32* %ox
+  store i32 %ry, i32* %oy
+  store i32 %rz, i32* %oz
+  ret void
+}
+
+define void @float_scale(i16 signext %x, i16 signext %y, i16 signext %z, i32 %sens, %axes* %out) {
+  %x32 = sext i16 %x to i32
+  %y32 = sext i16 %y to i32
+  %z32 = sext i16 %z to i32
+  %fx = call i32 @sf_i2f(i32 %x32)
+  %fy = call i32 @sf_i2f(i32 %y32)
+  %fz = call i32 @sf_i2f(i32 %z32)
+  %mx = call i32 @sf_fmul(i32 %fx, i32 %sens)
+  %my = call i32 @sf_fmul(i32 %fy, i32 %sens)
+  %mz = call i32 @sf_fmul(i32 %fz, i32 %sens)
+  %rx = call i32 @sf_f2iz(i32 %mx)
+  %ry = call i32 @sf_f2iz(i32 %my)
+  %rz = call i32 @sf_f2iz(i32 %mz)
+  %ox = getelementptr %axes, %axes* %out, i32 0, i32 0
+  %oy = getelementptr %axes, %axes* %out, i32 0, i32 1
+  %oz = getelementptr %axes, %axes* %out, i32 0, i32 2
+  store i32 %rx, i32* %ox
+  store i32 %ry, i32* %oy
+  store i32 %rz, i32* %oz
+  ret void
+}
+
+; __aeabi_i2f: int32 to float, rounded to nearest even
+define internal i32 @sf_i2f(i32 %a) {
+  %neg = icmp slt i32 %a, 0
+  %na = sub i32 0, %a
+  %abs = select i1 %neg, i32 %na, i32 %a
+  %sign = and i32 %a, -2147483648
+  %lz = call i32 @llvm.ctlz.i32(i32 %abs, i1 false)
+  %exp = sub i32 31, %lz
+  ; |a| < 2^24: exact, shifted up to bit 23
+  %up = sub i32 %lz, 8
+  %upc = and i32 %up, 31
+  %mlo = shl i32 %abs, %upc
+  ; |a| >= 2^24: shifted down, the lost bits rounded
+  %dn = sub i32 8, %lz
+  %dnc = and i32 %dn, 31
+  %mhi = lshr i32 %abs, %dnc
+  %rsh = sub i32 32, %dnc
+  %rshc = and i32 %rsh, 31
+  %rest = shl i32 %abs, %rshc
+  %big = icmp ugt i32 %exp, 23
+  %m = select i1 %big, i32 %mhi, i32 %mlo
+  %r = select i1 %big, i32 %rest, i32 0
+  %odd = and i32 %m, 1
+  %half = or i32 %r, %odd
+  %rup = icmp ugt i32 %half, -2147483648
+  %inc = zext i1 %rup to i32
+  ; The implicit bit of m adds one to the exponent field
+  %e126 = add i32 %exp, 126
+  %ef = shl i32 %e126, 23
+  %mag = add i32 %ef, %m
+  %magr = add i32 %mag, %inc
+  %res = or i32 %magr, %sign
+  %zero = icmp eq i32 %a, 0
+  %out = select i1 %zero, i32 0, i32 %res
+  ret i32 %out
+}
+
+; __aeabi_fmul: float product, rounded to nearest even
+define internal i32 @sf_fmul(i32 %a, i32 %b) {
+  %x = xor i32 %a, %b
+  %sign = and i32 %x, -2147483648
+  %ea0 = lshr i32 %a, 23
+  %ea = and i32 %ea0, 255
+  %eb0 = lshr i32 %b, 23
+  %eb = and i32 %eb0, 255
+  %fa = and i32 %a, 8388607
+  %fb = and i32 %b, 8388607
+  %ma = or i32 %fa, 8388608
+  %mb = or i32 %fb, 8388608
+  %ma64 = zext i32 %ma to i64
+  %mb64 = zext i32 %mb to i64
+  %p = mul nuw i64 %ma64, %mb64
+  ; 2^46 <= p < 2^48: keep 24 bits from bit 23 or 24
+  %ph = lshr i64 %p, 32
+  %phi = trunc i64 %ph to i32
+  %top = lshr i32 %phi, 15
+  %sh = add i32 %top, 23
+  %sh64 = zext i32 %sh to i64
+  %m64 = lshr i64 %p, %sh64
+  %m = trunc i64 %m64 to i32
+  %rsh = sub i32 64, %sh
+  %rsh64 = zext i32 %rsh to i64
+  %rest64 = shl i64 %p, %rsh64
+  %rh = lshr i64 %rest64, 32
+  %rhi = trunc i64 %rh to i32
+  %rl = trunc i64 %rest64 to i32
+  %sticky0 = icmp ne i32 %rl, 0
+  %sticky = zext i1 %sticky0 to i32
+  %r = or i32 %rhi, %sticky
+  %odd = and i32 %m, 1
+  %half = or i32 %r, %odd
+  %rup = icmp ugt i32 %half, -2147483648
+  %inc = zext i1 %rup to i32
+  ; ea + eb - 127 + top, less one for the implicit bit of m
+  %e0 = add i32 %ea, %eb
+  %e1 = add i32 %e0, %top
+  %e2 = sub i32 %e1, 128
+  %ef = shl i32 %e2, 23
+  %mag = add i32 %ef, %m
+  %magr = add i32 %mag, %inc
+  %res = or i32 %magr, %sign
+  %za = icmp eq i32 %ea, 0
+  %zb = icmp eq i32 %eb, 0
+  %z = or i1 %za, %zb
+  %out = select i1 %z, i32 %sign, i32 %res
+  ret i32 %out
+}
+
+; __aeabi_f2iz: float to int32, towards zero
+define internal i32 @sf_f2iz(i32 %a) {
+  %e0 = lshr i32 %a, 23
+  %e = and i32 %e0, 255
+  %f = and i32 %a, 8388607
+  %m = or i32 %f, 8388608
+  ; value = m * 2^(e - 150)
+  %dn = sub i32 150, %e
+  %dnc = and i32 %dn, 31
+  %up = sub i32 %e, 150
+  %upc = and i32 %up, 31
+  %mdn = lshr i32 %m, %dnc
+  %mup = shl i32 %m, %upc
+  %isup = icmp ugt i32 %e, 150
+  %mag = select i1 %isup, i32 %mup, i32 %mdn
+  %small = icmp ult i32 %e, 127
+  %mag1 = select i1 %small, i32 0, i32 %mag
+  %neg = icmp slt i32 %a, 0
+  %nmag = sub i32 0, %mag1
+  %out = select i1 %neg, i32 %nmag, i32 %mag1
+  ret i32 %out
+}
+
+declare i32 @llvm.ctlz.i32(i32, i1)
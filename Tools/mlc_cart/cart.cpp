@@ -0,0 +1,673 @@
+/**
+  ******************************************************************************
+  * @file    cart.cpp
+  * @author  ISCA Lab
+  * @brief   Decision tree trainer bounded by the LSM6DSOX MLC resources
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <numeric>
+
+#include "cart.hpp"
+#include "parallel.hpp"
+
+namespace mlc
+{
+
+struct Split
+{
+  int32_t Feature = -1;      /* -1 if none */
+  float Threshold = 0.0F;
+  double Gain = 0.0;
+};
+
+/* A leaf that may still be split, with its rows sorted by each feature */
+struct Candidate
+{
+  size_t TreeIndex;
+  int32_t NodeIndex;
+  uint32_t Depth;
+  std::vector<std::vector<uint32_t>> Sorted;  /* [feature] rows, by value */
+  std::vector<uint32_t> Counts;               /* [class] */
+  Split Best;
+};
+
+/* Per tree training state */
+struct Grower
+{
+  const Dataset *Data;
+  std::vector<uint32_t> Global;   /* Global feature id of each column */
+  std::vector<uint8_t> Left;      /* Side of each row for the split being applied */
+  double Total;                   /* Training rows of the tree */
+};
+
+/**
+  * @brief  x * ln(x), 0 for 0
+  * @param  X the value
+  * @retval The product
+  */
+static double XLogX(double X)
+{
+  return (X > 0.0) ? (X * std::log(X)) : 0.0;
+}
+
+/**
+  * @brief  Weighted impurity of a class histogram (impurity times rows)
+  * @param  Counts the histogram
+  * @param  Impurity the criterion
+  * @retval The weighted impurity
+  */
+static double WeightedImpurity(const std::vector<uint32_t> &Counts, Criterion Impurity)
+{
+  double n = std::accumulate(Counts.begin(), Counts.end(), 0.0);
+  double acc = 0.0;
+
+  if (n <= 0.0)
+  {
+    return 0.0;
+  }
+
+  for (uint32_t c : Counts)
+  {
+    acc += (Impurity == Criterion::Gini) ? (static_cast<double>(c) * c) : XLogX(c);
+  }
+
+  return (Impurity == Criterion::Gini) ? (n - (acc / n)) : (XLogX(n) - acc);
+}
+
+/**
+  * @brief  Best threshold of one feature for a candidate
+  * @note   The Gini sums of squares and the entropy sums of x ln x are kept up
+  *         to date as rows move left, one pass over the sorted rows.
+  * @param  G the tree state
+  * @param  C the candidate
+  * @param  Feature the column
+  * @param  Param the training parameters
+  * @retval The split, Feature -1 if no threshold respects MinLeaf
+  */
+static Split SearchFeature(const Grower &G, const Candidate &C, size_t Feature, const Params &Param)
+{
+  const std::vector<float> &values = G.Data->Columns[Feature];
+  const std::vector<uint32_t> &rows = C.Sorted[Feature];
+  const std::vector<uint16_t> &labels = G.Data->Labels;
+  std::vector<uint32_t> left(C.Counts.size(), 0U);
+  std::vector<uint32_t> right(C.Counts);
+  double parent = WeightedImpurity(C.Counts, Param.Impurity);
+  double n = static_cast<double>(rows.size());
+  double acc_left = 0.0;
+  double acc_right = 0.0;
+  Split best;
+
+  for (uint32_t c : C.Counts)
+  {
+    acc_right += (Param.Impurity == Criterion::Gini) ? (static_cast<double>(c) * c) : XLogX(c);
+  }
+
+  for (size_t i = 0U; (i + 1U) < rows.size(); i++)
+  {
+    uint16_t k = labels[rows[i]];
+    double nl = static_cast<double>(i + 1U);
+    double nr = n - nl;
+    double children;
+
+    if (Param.Impurity == Criterion::Gini)
+    {
+      acc_left += (2.0 * left[k]) + 1.0;
+      acc_right -= (2.0 * right[k]) - 1.0;
+    }
+    else
+    {
+      acc_left += XLogX(left[k] + 1.0) - XLogX(left[k]);
+      acc_right += XLogX(right[k] - 1.0) - XLogX(right[k]);
+    }
+    left[k]++;
+    right[k]--;
+
+    if ((values[rows[i]] == values[rows[i + 1U]]) || ((i + 1U) < Param.MinLeaf)
+        || ((rows.size() - i - 1U) < Param.MinLeaf))
+    {
+      continue;
+    }
+
+    if (Param.Impurity == Criterion::Gini)
+    {
+      children = (nl - (acc_left / nl)) + (nr - (acc_right / nr));
+    }
+    else
+    {
+      children = (XLogX(nl) - acc_left) + (XLogX(nr) - acc_right);
+    }
+
+    if ((parent - children) > (best.Gain * G.Total))
+    {
+      best.Feature = static_cast<int32_t>(Feature);
+      best.Threshold = values[rows[i]];
+      best.Gain = (parent - children) / G.Total;
+    }
+  }
+
+  return best;
+}
+
+/**
+  * @brief  Find the best split of a candidate over the allowed features
+  * @param  G the tree state
+  * @param  C the candidate, Best is updated
+  * @param  Allowed allowed global feature ids
+  * @param  Param the training parameters
+  * @retval None
+  */
+static void Evaluate(const Grower &G, Candidate &C, const std::vector<uint8_t> &Allowed, const Params &Param)
+{
+  std::vector<Split> found(G.Data->Features());
+
+  C.Best = Split();
+
+  /* A pure node or one too small for two leaves stays a leaf */
+  if ((std::count_if(C.Counts.begin(), C.Counts.end(), [](uint32_t N) { return N != 0U; }) < 2)
+      || (C.Sorted.empty() || (C.Sorted[0].size() < (2U * std::max<uint32_t>(Param.MinLeaf, 1U)))))
+  {
+    return;
+  }
+
+  ParallelFor(found.size(), Param.Threads, [&](size_t F)
+  {
+    if (Allowed[G.Global[F]] != 0U)
+    {
+      found[F] = SearchFeature(G, C, F, Param);
+    }
+  });
+
+  /* Lowest column wins a tie, the result does not depend on the threads */
+  for (const Split &s : found)
+  {
+    if ((s.Feature >= 0) && (s.Gain > C.Best.Gain))
+    {
+      C.Best = s;
+    }
+  }
+
+  if (C.Best.Gain < Param.MinGain)
+  {
+    C.Best = Split();
+  }
+}
+
+/**
+  * @brief  Fill the class, count and errors of a node from its histogram
+  * @param  N the node
+  * @param  Counts the histogram
+  * @retval None
+  */
+static void SetLeaf(Node &N, const std::vector<uint32_t> &Counts)
+{
+  auto best = std::max_element(Counts.begin(), Counts.end());
+
+  N.Class = static_cast<uint16_t>(best - Counts.begin());
+  N.Count = std::accumulate(Counts.begin(), Counts.end(), 0U);
+  N.Errors = N.Count - *best;
+}
+
+/**
+  * @brief  Split a candidate into two new candidates
+  * @param  G the tree state
+  * @param  T the tree
+  * @param  C the candidate, its sorted rows are released
+  * @param  Param the training parameters
+  * @param  Out the two children
+  * @retval None
+  */
+static void Apply(Grower &G, Tree &T, Candidate &C, const Params &Param, Candidate Out[2])
+{
+  const std::vector<float> &values = G.Data->Columns[static_cast<size_t>(C.Best.Feature)];
+  int32_t left = static_cast<int32_t>(T.Nodes.size());
+
+  for (uint32_t row : C.Sorted[0])
+  {
+    G.Left[row] = (values[row] <= C.Best.Threshold) ? 1U : 0U;
+  }
+
+  for (size_t side = 0U; side < 2U; side++)
+  {
+    Out[side].TreeIndex = C.TreeIndex;
+    Out[side].NodeIndex = left + static_cast<int32_t>(side);
+    Out[side].Depth = C.Depth + 1U;
+    Out[side].Sorted.resize(C.Sorted.size());
+    Out[side].Counts.assign(C.Counts.size(), 0U);
+  }
+
+  for (uint32_t row : C.Sorted[0])
+  {
+    Out[(G.Left[row] != 0U) ? 0 : 1].Counts[G.Data->Labels[row]]++;
+  }
+
+  size_t n_left = std::accumulate(Out[0].Counts.begin(), Out[0].Counts.end(), size_t(0));
+
+  /* Stable partition keeps each child's rows sorted */
+  ParallelFor(C.Sorted.size(), Param.Threads, [&](size_t F)
+  {
+    std::vector<uint32_t> &l = Out[0].Sorted[F];
+    std::vector<uint32_t> &r = Out[1].Sorted[F];
+
+    l.reserve(n_left);
+    r.reserve(C.Sorted[F].size() - n_left);
+    for (uint32_t row : C.Sorted[F])
+    {
+      ((G.Left[row] != 0U) ? l : r).push_back(row);
+    }
+    C.Sorted[F].clear();
+    C.Sorted[F].shrink_to_fit();
+  });
+
+  T.Nodes[static_cast<size_t>(C.NodeIndex)].Feature = C.Best.Feature;
+  T.Nodes[static_cast<size_t>(C.NodeIndex)].Threshold = C.Best.Threshold;
+  T.Nodes[static_cast<size_t>(C.NodeIndex)].Left = left;
+  T.Nodes[static_cast<size_t>(C.NodeIndex)].Right = left + 1;
+
+  for (size_t side = 0U; side < 2U; side++)
+  {
+    Node n;
+    SetLeaf(n, Out[side].Counts);
+    T.Nodes.push_back(n);
+  }
+}
+
+/**
+  * @brief  Fold the splits whose two leaves give the same class
+  * @param  T the tree
+  * @param  Index the subtree root
+  * @retval None
+  */
+static void MergeLeaves(Tree &T, int32_t Index)
+{
+  Node &n = T.Nodes[static_cast<size_t>(Index)];
+
+  if (n.Feature < 0)
+  {
+    return;
+  }
+
+  MergeLeaves(T, n.Left);
+  MergeLeaves(T, n.Right);
+
+  const Node &l = T.Nodes[static_cast<size_t>(n.Left)];
+  const Node &r = T.Nodes[static_cast<size_t>(n.Right)];
+  if ((l.Feature < 0) && (r.Feature < 0) && (l.Class == r.Class))
+  {
+    n.Feature = -1;
+    n.Errors = l.Errors + r.Errors;
+    n.Left = -1;
+    n.Right = -1;
+  }
+}
+
+/**
+  * @brief  Copy the nodes reachable from the root, in pre-order
+  * @param  T the tree
+  * @param  Index the subtree root in T
+  * @param  Out the compacted nodes
+  * @retval The subtree root in Out
+  */
+static int32_t Compact(const Tree &T, int32_t Index, std::vector<Node> &Out)
+{
+  int32_t self = static_cast<int32_t>(Out.size());
+  const Node &n = T.Nodes[static_cast<size_t>(Index)];
+
+  Out.push_back(n);
+  if (n.Feature >= 0)
+  {
+    int32_t l = Compact(T, n.Left, Out);
+    int32_t r = Compact(T, n.Right, Out);
+    Out[static_cast<size_t>(self)].Left = l;
+    Out[static_cast<size_t>(self)].Right = r;
+  }
+
+  return self;
+}
+
+/**
+  * @brief  Grow the trees together within the MLC limits
+  * @param  Sets one dataset per tree
+  * @param  Rows the training rows of each dataset, empty for all
+  * @param  Limit the MLC resources
+  * @param  Param the training parameters
+  * @param  Out the trees
+  * @param  Error the reason of a failure
+  * @retval true in case of success, false if the inputs exceed the limits
+  */
+bool Train(const std::vector<const Dataset *> &Sets, const RowSets &Rows, const Limits &Limit, const Params &Param,
+           std::vector<Tree> &Out, std::string &Error)
+{
+  std::map<std::string, uint32_t> ids;
+  std::vector<Grower> growers(Sets.size());
+  std::vector<Candidate> frontier;
+  std::vector<uint8_t> all;
+  std::vector<uint8_t> used;
+  uint32_t used_count = 0U;
+  uint32_t nodes = static_cast<uint32_t>(Sets.size());
+
+  if (Sets.empty() || (Sets.size() > Limit.MaxTrees) || (nodes > Limit.MaxNodes))
+  {
+    Error = std::to_string(Sets.size()) + " trees, the MLC runs 1 to " + std::to_string(Limit.MaxTrees);
+    return false;
+  }
+
+  Out.assign(Sets.size(), Tree());
+
+  for (size_t t = 0U; t < Sets.size(); t++)
+  {
+    const Dataset &d = *Sets[t];
+    Grower &g = growers[t];
+    Candidate c;
+
+    if (d.ClassNames.size() > Limit.MaxClasses)
+    {
+      Error = d.Name + ": " + std::to_string(d.ClassNames.size()) + " classes, a tree gives up to "
+              + std::to_string(Limit.MaxClasses);
+      return false;
+    }
+
+    for (const std::vector<float> &column : d.Columns)
+    {
+      if (!std::all_of(column.begin(), column.end(), [](float V) { return std::isfinite(V); }))
+      {
+        Error = d.Name + ": non-finite feature value";
+        return false;
+      }
+    }
+
+    g.Data = &d;
+    g.Left.assign(d.Rows(), 0U);
+    for (const std::string &name : d.FeatureNames)
+    {
+      g.Global.push_back(ids.emplace(name, static_cast<uint32_t>(ids.size())).first->second);
+    }
+
+    c.TreeIndex = t;
+    c.NodeIndex = 0;
+    c.Depth = 0U;
+    c.Counts.assign(std::max<size_t>(d.ClassNames.size(), 1U), 0U);
+    c.Sorted.resize(d.Features());
+
+    std::vector<uint32_t> rows;
+    if ((t < Rows.size()) && !Rows[t].empty())
+    {
+      rows = Rows[t];
+    }
+    else
+    {
+      rows.resize(d.Rows());
+      std::iota(rows.begin(), rows.end(), 0U);
+    }
+
+    for (uint32_t r : rows)
+    {
+      c.Counts[d.Labels[r]]++;
+    }
+    g.Total = std::max<double>(static_cast<double>(rows.size()), 1.0);
+
+    ParallelFor(d.Features(), Param.Threads, [&](size_t F)
+    {
+      c.Sorted[F] = rows;
+      std::stable_sort(c.Sorted[F].begin(), c.Sorted[F].end(),
+                       [&](uint32_t A, uint32_t B) { return d.Columns[F][A] < d.Columns[F][B]; });
+    });
+
+    Out[t].Data = &d;
+    Out[t].Nodes.emplace_back();
+    SetLeaf(Out[t].Nodes[0], c.Counts);
+    frontier.push_back(std::move(c));
+  }
+
+  all.assign(ids.size(), 1U);
+  used.assign(ids.size(), 0U);
+
+  for (Candidate &c : frontier)
+  {
+    Evaluate(growers[c.TreeIndex], c, all, Param);
+  }
+
+  while ((nodes + 2U) <= Limit.MaxNodes)
+  {
+    auto best = frontier.end();
+    Candidate children[2];
+
+    for (auto it = frontier.begin(); it != frontier.end(); ++it)
+    {
+      if ((it->Best.Feature >= 0) && ((best == frontier.end()) || (it->Best.Gain > best->Best.Gain)))
+      {
+        best = it;
+      }
+    }
+
+    if (best == frontier.end())
+    {
+      break;
+    }
+
+    Grower &g = growers[best->TreeIndex];
+    uint32_t feature = g.Global[static_cast<size_t>(best->Best.Feature)];
+
+    /* The feature budget filled up since this leaf was evaluated */
+    if ((used[feature] == 0U) && (used_count >= Limit.MaxFeatures))
+    {
+      Evaluate(g, *best, used, Param);
+      continue;
+    }
+
+    if (used[feature] == 0U)
+    {
+      used[feature] = 1U;
+      used_count++;
+    }
+
+    Apply(g, Out[best->TreeIndex], *best, Param, children);
+    nodes += 2U;
+    frontier.erase(best);
+
+    for (Candidate &c : children)
+    {
+      if ((Param.MaxDepth == 0U) || (c.Depth < Param.MaxDepth))
+      {
+        Evaluate(g, c, (used_count >= Limit.MaxFeatures) ? used : all, Param);
+        if (c.Best.Feature >= 0)
+        {
+          frontier.push_back(std::move(c));
+        }
+      }
+    }
+  }
+
+  for (Tree &t : Out)
+  {
+    std::vector<Node> nodes_out;
+
+    if (Param.Merge)
+    {
+      MergeLeaves(t, 0);
+    }
+
+    (void)Compact(t, 0, nodes_out);
+    t.Nodes.swap(nodes_out);
+  }
+
+  return true;
+}
+
+/**
+  * @brief  Classify one row
+  * @param  Rows a table with the tree's features, in the same columns
+  * @param  Row the row
+  * @retval The class
+  */
+uint16_t Tree::Predict(const Dataset &Rows, size_t Row) const
+{
+  const Node *n = &Nodes[0];
+
+  while (n->Feature >= 0)
+  {
+    n = &Nodes[static_cast<size_t>((Rows.Columns[static_cast<size_t>(n->Feature)][Row] <= n->Threshold) ? n->Left
+                                                                                                          : n->Right)];
+  }
+
+  return n->Class;
+}
+
+/**
+  * @brief  Node count, leaves included, as counted by the MLC
+  * @retval The nodes
+  */
+uint32_t Tree::Size() const
+{
+  return static_cast<uint32_t>(Nodes.size());
+}
+
+/**
+  * @brief  Leaf count
+  * @retval The leaves
+  */
+uint32_t Tree::Leaves() const
+{
+  return static_cast<uint32_t>(std::count_if(Nodes.begin(), Nodes.end(), [](const Node &N) { return N.Feature < 0; }));
+}
+
+/**
+  * @brief  Features tested by the trees, to enable in Unico
+  * @param  Trees the trees
+  * @retval The names, in column order of the first tree using them
+  */
+std::vector<std::string> UsedFeatures(const std::vector<Tree> &Trees)
+{
+  std::vector<std::string> names;
+
+  for (const Tree &t : Trees)
+  {
+    std::vector<int32_t> columns;
+
+    for (const Node &n : t.Nodes)
+    {
+      if (n.Feature >= 0)
+      {
+        columns.push_back(n.Feature);
+      }
+    }
+
+    std::sort(columns.begin(), columns.end());
+    for (int32_t c : columns)
+    {
+      const std::string &name = t.Data->FeatureNames[static_cast<size_t>(c)];
+      if (std::find(names.begin(), names.end(), name) == names.end())
+      {
+        names.push_back(name);
+      }
+    }
+  }
+
+  return names;
+}
+
+/**
+  * @brief  Shortest decimal text that reads back as the same float
+  * @param  Value the value
+  * @retval The text
+  */
+static std::string FloatText(float Value)
+{
+  char text[32];
+
+  for (int digits = 1; digits <= 9; digits++)
+  {
+    (void)std::snprintf(text, sizeof(text), "%.*g", digits, static_cast<double>(Value));
+    if (std::strtof(text, nullptr) == Value)
+    {
+      break;
+    }
+  }
+
+  return text;
+}
+
+/**
+  * @brief  Print a subtree in the J48 layout
+  * @param  T the tree
+  * @param  Index the subtree root
+  * @param  Depth the indentation level
+  * @param  Out the text
+  * @retval None
+  */
+static void FormatNode(const Tree &T, int32_t Index, uint32_t Depth, std::string &Out)
+{
+  const Node &n = T.Nodes[static_cast<size_t>(Index)];
+  const std::string &name = T.Data->FeatureNames[static_cast<size_t>(n.Feature)];
+  const std::string threshold = FloatText(n.Threshold);
+
+  for (int side = 0; side < 2; side++)
+  {
+    const Node &child = T.Nodes[static_cast<size_t>((side == 0) ? n.Left : n.Right)];
+    char counts[48];
+
+    for (uint32_t i = 0U; i < Depth; i++)
+    {
+      Out += "|   ";
+    }
+    Out += name + ((side == 0) ? " <= " : " > ") + threshold;
+
+    if (child.Feature < 0)
+    {
+      if (child.Errors == 0U)
+      {
+        (void)std::snprintf(counts, sizeof(counts), " (%u.0)", child.Count);
+      }
+      else
+      {
+        (void)std::snprintf(counts, sizeof(counts), " (%u.0/%u.0)", child.Count, child.Errors);
+      }
+      Out += ": " + T.Data->ClassNames[child.Class] + counts + "\n";
+    }
+    else
+    {
+      Out += "\n";
+      FormatNode(T, (side == 0) ? n.Left : n.Right, Depth + 1U, Out);
+    }
+  }
+}
+
+/**
+  * @brief  Print a tree as WEKA prints a J48 tree, the text Unico imports
+  * @param  T the tree
+  * @retval The text
+  */
+std::string FormatJ48(const Tree &T)
+{
+  std::string out = "J48 pruned tree\n------------------\n\n";
+  const Node &root = T.Nodes[0];
+
+  if (root.Feature < 0)
+  {
+    out += ": " + T.Data->ClassNames[root.Class] + " (" + std::to_string(root.Count) + ".0"
+           + ((root.Errors != 0U) ? ("/" + std::to_string(root.Errors) + ".0") : std::string()) + ")\n";
+  }
+  else
+  {
+    FormatNode(T, 0, 0U, out);
+  }
+
+  out += "\nNumber of Leaves  : \t" + std::to_string(T.Leaves()) + "\n";
+  out += "\nSize of the tree : \t" + std::to_string(T.Size()) + "\n";
+
+  return out;
+}
+
+} /* namespace mlc */
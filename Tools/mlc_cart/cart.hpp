@@ -0,0 +1,100 @@
+/**
+  ******************************************************************************
+  * @file    cart.hpp
+  * @author  ISCA Lab
+  * @brief   Decision tree trainer bounded by the LSM6DSOX MLC resources
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef CART_HPP
+#define CART_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dataset.hpp"
+
+/*
+ * The MLC runs up to MaxTrees decision trees on one shared set of window
+ * features. The limits hold for the whole configuration, so the trees are
+ * grown together, best split first, from one pool of nodes and features:
+ *  - a split is taken only while the node count of all trees stays within
+ *    MaxNodes (a split turns a leaf into a node plus two leaves),
+ *  - once MaxFeatures distinct features are used, the remaining splits may
+ *    only test those features.
+ * Growing best-first means the budget goes to the splits that separate the
+ * most windows, instead of growing a full tree and cutting it back by hand.
+ *
+ * Each tree has its own Dataset, its rows are one window each. Features are
+ * matched between trees by name.
+ */
+
+namespace mlc
+{
+
+struct Limits
+{
+  uint32_t MaxTrees = 8U;     /* Decision trees */
+  uint32_t MaxNodes = 256U;   /* Nodes of all trees, leaves included */
+  uint32_t MaxFeatures = 32U; /* Distinct features of all trees */
+  uint32_t MaxClasses = 16U;  /* Results per tree */
+  uint32_t MaxWindow = 255U;  /* Window length [samples] */
+};
+
+enum class Criterion
+{
+  Gini,
+  Entropy,
+};
+
+struct Params
+{
+  Criterion Impurity = Criterion::Gini;
+  uint32_t MinLeaf = 2U;      /* Minimum windows per leaf, as J48 -M */
+  uint32_t MaxDepth = 0U;     /* 0 for no limit */
+  double MinGain = 1e-7;      /* Minimum impurity decrease, weighted by the node share */
+  bool Merge = true;          /* Fold splits whose leaves give the same class */
+  unsigned Threads = 1U;      /* Split search threads */
+};
+
+struct Node
+{
+  int32_t Feature = -1;       /* Dataset column, -1 for a leaf */
+  float Threshold = 0.0F;     /* Left if value <= Threshold */
+  int32_t Left = -1;
+  int32_t Right = -1;
+  uint16_t Class = 0U;        /* Majority class */
+  uint32_t Count = 0U;        /* Training windows reaching the node */
+  uint32_t Errors = 0U;       /* Of which not in Class */
+};
+
+struct Tree
+{
+  const Dataset *Data = nullptr;
+  std::vector<Node> Nodes;    /* Nodes[0] is the root */
+
+  uint16_t Predict(const Dataset &Rows, size_t Row) const;
+  uint32_t Size() const;
+  uint32_t Leaves() const;
+};
+
+/* Rows of each tree's dataset used for training, all rows if empty */
+using RowSets = std::vector<std::vector<uint32_t>>;
+
+bool Train(const std::vector<const Dataset *> &Sets, const RowSets &Rows, const Limits &Limit, const Params &Param,
+           std::vector<Tree> &Out, std::string &Error);
+
+std::vector<std::string> UsedFeatures(const std::vector<Tree> &Trees);
+std::string FormatJ48(const Tree &T);
+
+} /* namespace mlc */
+
+#endif /* CART_HPP */
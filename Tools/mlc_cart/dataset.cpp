@@ -0,0 +1,471 @@
+/**
+  ******************************************************************************
+  * @file    dataset.cpp
+  * @author  ISCA Lab
+  * @brief   Column-major feature table for the MLC tree trainer
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+#include "dataset.hpp"
+
+namespace mlc
+{
+
+/**
+  * @brief  Look a feature up by name
+  * @param  Feature the name
+  * @retval The column, -1 if not found
+  */
+int32_t Dataset::FindFeature(const std::string &Feature) const
+{
+  for (size_t i = 0U; i < FeatureNames.size(); i++)
+  {
+    if (FeatureNames[i] == Feature)
+    {
+      return static_cast<int32_t>(i);
+    }
+  }
+
+  return -1;
+}
+
+/**
+  * @brief  Look a class up by name
+  * @param  Class the name
+  * @retval The label, -1 if not found
+  */
+int32_t Dataset::FindClass(const std::string &Class) const
+{
+  for (size_t i = 0U; i < ClassNames.size(); i++)
+  {
+    if (ClassNames[i] == Class)
+    {
+      return static_cast<int32_t>(i);
+    }
+  }
+
+  return -1;
+}
+
+/**
+  * @brief  Strip blanks and ARFF quotes
+  * @param  Text the token
+  * @retval The bare token
+  */
+static std::string Bare(const std::string &Text)
+{
+  size_t start = 0U;
+  size_t end = Text.size();
+
+  while ((start < end) && std::isspace(static_cast<unsigned char>(Text[start])))
+  {
+    start++;
+  }
+  while ((end > start) && std::isspace(static_cast<unsigned char>(Text[end - 1U])))
+  {
+    end--;
+  }
+  if (((end - start) >= 2U) && ((Text[start] == '\'') || (Text[start] == '"')) && (Text[end - 1U] == Text[start]))
+  {
+    start++;
+    end--;
+  }
+
+  return Text.substr(start, end - start);
+}
+
+/**
+  * @brief  Split an ARFF line on commas, outside quotes
+  * @param  Line the line
+  * @param  Fields the bare fields
+  * @retval None
+  */
+static void SplitFields(const std::string &Line, std::vector<std::string> &Fields)
+{
+  std::string field;
+  char quote = '\0';
+
+  Fields.clear();
+  for (char c : Line)
+  {
+    if (quote != '\0')
+    {
+      quote = (c == quote) ? '\0' : quote;
+      field += c;
+    }
+    else if ((c == '\'') || (c == '"'))
+    {
+      quote = c;
+      field += c;
+    }
+    else if (c == ',')
+    {
+      Fields.push_back(Bare(field));
+      field.clear();
+    }
+    else
+    {
+      field += c;
+    }
+  }
+  Fields.push_back(Bare(field));
+}
+
+/**
+  * @brief  Case-insensitive prefix test
+  * @param  Text the text
+  * @param  Prefix the lower case prefix
+  * @retval true if Text starts with Prefix
+  */
+static bool StartsWith(const std::string &Text, const char *Prefix)
+{
+  size_t len = std::strlen(Prefix);
+
+  if (Text.size() < len)
+  {
+    return false;
+  }
+
+  for (size_t i = 0U; i < len; i++)
+  {
+    if (std::tolower(static_cast<unsigned char>(Text[i])) != Prefix[i])
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+  * @brief  Load a dense ARFF file, as exported by Unico
+  * @note   Numeric attributes become features, the class attribute must be
+  *         nominal. Other nominal or string attributes are ignored. Rows with
+  *         a missing value ('?') are dropped.
+  * @param  Path the file
+  * @param  ClassAttribute the class attribute, empty for the last nominal one
+  * @param  Out the table
+  * @param  Error the reason of a failure
+  * @retval true in case of success, false otherwise
+  */
+bool LoadArff(const std::string &Path, const std::string &ClassAttribute, Dataset &Out, std::string &Error)
+{
+  enum class Kind { Numeric, Nominal, Other };
+  struct Attribute { std::string Name; Kind Type; std::vector<std::string> Values; };
+  std::ifstream in(Path);
+  std::vector<Attribute> attributes;
+  std::vector<int32_t> column;         /* Feature column of each attribute, -1 if none */
+  std::vector<std::string> fields;
+  std::string line;
+  int32_t class_attr = -1;
+  bool data = false;
+  size_t line_no = 0U;
+
+  if (!in)
+  {
+    Error = "cannot open " + Path;
+    return false;
+  }
+
+  Out = Dataset();
+  Out.Name = Path;
+
+  while (std::getline(in, line))
+  {
+    line_no++;
+    if (!line.empty() && (line.back() == '\r'))
+    {
+      line.pop_back();
+    }
+
+    std::string bare = Bare(line);
+    if (bare.empty() || (bare[0] == '%'))
+    {
+      continue;
+    }
+
+    if (!data)
+    {
+      if (StartsWith(bare, "@attribute"))
+      {
+        std::string rest = Bare(bare.substr(10U));
+        Attribute attr;
+        size_t split;
+
+        if ((rest[0] == '\'') || (rest[0] == '"'))
+        {
+          split = rest.find(rest[0], 1U) + 1U;
+        }
+        else
+        {
+          split = rest.find_first_of(" \t");
+        }
+
+        if ((split == std::string::npos) || (split == 0U))
+        {
+          Error = Path + ":" + std::to_string(line_no) + ": bad attribute";
+          return false;
+        }
+
+        attr.Name = Bare(rest.substr(0U, split));
+        rest = Bare(rest.substr(split));
+
+        if (rest[0] == '{')
+        {
+          attr.Type = Kind::Nominal;
+          SplitFields(rest.substr(1U, rest.find('}') - 1U), attr.Values);
+        }
+        else if (StartsWith(rest, "numeric") || StartsWith(rest, "real") || StartsWith(rest, "integer"))
+        {
+          attr.Type = Kind::Numeric;
+        }
+        else
+        {
+          attr.Type = Kind::Other;
+        }
+
+        attributes.push_back(attr);
+      }
+      else if (StartsWith(bare, "@data"))
+      {
+        for (size_t i = 0U; i < attributes.size(); i++)
+        {
+          if ((attributes[i].Type == Kind::Nominal)
+              && (ClassAttribute.empty() ? true : (attributes[i].Name == ClassAttribute)))
+          {
+            class_attr = static_cast<int32_t>(i);
+          }
+        }
+
+        if (class_attr < 0)
+        {
+          Error = Path + ": no nominal class attribute" + (ClassAttribute.empty() ? "" : (" " + ClassAttribute));
+          return false;
+        }
+
+        Out.ClassNames = attributes[static_cast<size_t>(class_attr)].Values;
+        for (const Attribute &attr : attributes)
+        {
+          column.push_back((attr.Type == Kind::Numeric) ? static_cast<int32_t>(Out.FeatureNames.size()) : -1);
+          if (attr.Type == Kind::Numeric)
+          {
+            Out.FeatureNames.push_back(attr.Name);
+          }
+        }
+        Out.Columns.resize(Out.FeatureNames.size());
+        data = true;
+      }
+    }
+    else
+    {
+      std::vector<float> row(Out.Features());
+      int32_t label = -1;
+      bool missing = false;
+
+      if (bare[0] == '{')
+      {
+        Error = Path + ": sparse ARFF is not supported";
+        return false;
+      }
+
+      SplitFields(bare, fields);
+      if (fields.size() != attributes.size())
+      {
+        Error = Path + ":" + std::to_string(line_no) + ": expected " + std::to_string(attributes.size()) + " values";
+        return false;
+      }
+
+      for (size_t i = 0U; i < fields.size(); i++)
+      {
+        if (fields[i] == "?")
+        {
+          missing = true;
+        }
+        else if (static_cast<int32_t>(i) == class_attr)
+        {
+          label = Out.FindClass(fields[i]);
+          if (label < 0)
+          {
+            Error = Path + ":" + std::to_string(line_no) + ": unknown class " + fields[i];
+            return false;
+          }
+        }
+        else if (column[i] >= 0)
+        {
+          char *end;
+          row[static_cast<size_t>(column[i])] = std::strtof(fields[i].c_str(), &end);
+          if ((end == fields[i].c_str()) || (*end != '\0'))
+          {
+            Error = Path + ":" + std::to_string(line_no) + ": bad number " + fields[i];
+            return false;
+          }
+        }
+      }
+
+      if (missing || (label < 0))
+      {
+        continue;
+      }
+
+      for (size_t f = 0U; f < row.size(); f++)
+      {
+        Out.Columns[f].push_back(row[f]);
+      }
+      Out.Labels.push_back(static_cast<uint16_t>(label));
+    }
+  }
+
+  if (!data)
+  {
+    Error = Path + ": no @data section";
+    return false;
+  }
+
+  return true;
+}
+
+/**
+  * @brief  Write the table as ARFF, for a check in WEKA
+  * @param  Path the file
+  * @param  Data the table
+  * @param  Error the reason of a failure
+  * @retval true in case of success, false otherwise
+  */
+bool SaveArff(const std::string &Path, const Dataset &Data, std::string &Error)
+{
+  std::ofstream out(Path);
+
+  if (!out)
+  {
+    Error = "cannot create " + Path;
+    return false;
+  }
+
+  out.precision(9);
+  out << "@relation mlc_cart\n\n";
+  for (const std::string &name : Data.FeatureNames)
+  {
+    out << "@attribute " << name << " numeric\n";
+  }
+  out << "@attribute class {";
+  for (size_t c = 0U; c < Data.ClassNames.size(); c++)
+  {
+    out << ((c == 0U) ? "" : ", ") << Data.ClassNames[c];
+  }
+  out << "}\n\n@data\n";
+
+  for (size_t r = 0U; r < Data.Rows(); r++)
+  {
+    for (size_t f = 0U; f < Data.Features(); f++)
+    {
+      out << Data.Columns[f][r] << ",";
+    }
+    out << Data.ClassNames[Data.Labels[r]] << "\n";
+  }
+
+  if (!out)
+  {
+    Error = "write failed: " + Path;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+  * @brief  Round a value to the nearest half-precision float
+  * @note   The MLC computes features and compares thresholds in half
+  *         precision. Ties round to even, overflow saturates to infinity.
+  * @param  Value the value
+  * @retval The rounded value, as a float
+  */
+float ToHalf(float Value)
+{
+  int exp;
+  float mant;
+
+  if (!std::isfinite(Value) || (Value == 0.0F))
+  {
+    return Value;
+  }
+
+  (void)std::frexp(Value, &exp);   /* |Value| = m * 2^exp, m in [0.5, 1) */
+
+  /* 11 significant bits for normals, fixed 2^-24 steps for subnormals */
+  exp = (exp < -13) ? -13 : exp;
+  mant = std::ldexp(std::nearbyint(std::ldexp(Value, 11 - exp)), exp - 11);
+
+  return (std::fabs(mant) > 65504.0F) ? std::copysign(INFINITY, Value) : mant;
+}
+
+/**
+  * @brief  Round every feature value to half precision
+  * @param  Data the table
+  * @retval None
+  */
+void QuantizeHalf(Dataset &Data)
+{
+  for (std::vector<float> &column : Data.Columns)
+  {
+    for (float &v : column)
+    {
+      v = ToHalf(v);
+    }
+  }
+}
+
+/**
+  * @brief  Assign the rows of a dataset to stratified folds
+  * @param  Data the dataset
+  * @param  Folds the fold count
+  * @param  Seed the shuffle seed
+  * @retval The fold of each row
+  */
+std::vector<uint32_t> MakeFolds(const Dataset &Data, uint32_t Folds, uint32_t Seed)
+{
+  std::vector<uint32_t> fold(Data.Rows());
+  std::mt19937 rng(Seed);
+  uint32_t next = 0U;
+
+  for (size_t c = 0U; c < Data.ClassNames.size(); c++)
+  {
+    std::vector<uint32_t> rows;
+
+    for (uint32_t r = 0U; r < Data.Rows(); r++)
+    {
+      if (Data.Labels[r] == c)
+      {
+        rows.push_back(r);
+      }
+    }
+
+    std::shuffle(rows.begin(), rows.end(), rng);
+
+    /* Continue the round robin across classes to balance the fold sizes */
+    for (uint32_t r : rows)
+    {
+      fold[r] = next;
+      next = (next + 1U) % Folds;
+    }
+  }
+
+  return fold;
+}
+
+} /* namespace mlc */
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * @file    dataset.hpp
+  * @author  ISCA Lab
+  * @brief   Column-major feature table for the MLC tree trainer
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef DATASET_HPP
+#define DATASET_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mlc
+{
+
+/*
+ * One row per MLC window: a value per feature and a class. Features are
+ * stored by column, the split search walks one feature at a time.
+ */
+struct Dataset
+{
+  std::string Name;
+  std::vector<std::string> FeatureNames;
+  std::vector<std::string> ClassNames;
+  std::vector<std::vector<float>> Columns;  /* [feature][row] */
+  std::vector<uint16_t> Labels;             /* [row] */
+
+  size_t Rows() const { return Labels.size(); }
+  size_t Features() const { return FeatureNames.size(); }
+  int32_t FindFeature(const std::string &Feature) const;
+  int32_t FindClass(const std::string &Class) const;
+};
+
+bool LoadArff(const std::string &Path, const std::string &ClassAttribute, Dataset &Out, std::string &Error);
+bool SaveArff(const std::string &Path, const Dataset &Data, std::string &Error);
+
+float ToHalf(float Value);
+void QuantizeHalf(Dataset &Data);
+
+std::vector<uint32_t> MakeFolds(const Dataset &Data, uint32_t Folds, uint32_t Seed);
+
+} /* namespace mlc */
+
+#endif /* DATASET_HPP */
@@ -0,0 +1,268 @@
+/**
+  ******************************************************************************
+  * @file    features.cpp
+  * @author  ISCA Lab
+  * @brief   MLC window features computed from stream_rec recordings
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "features.hpp"
+#include "../stream_rec/rec_reader.hpp"
+
+namespace mlc
+{
+
+static const char *const FeatureNames[] =
+{
+  "MEAN", "VARIANCE", "ENERGY", "PEAK_TO_PEAK", "MINIMUM", "MAXIMUM"
+};
+
+/* Input name, recording channels and the conversion to g or dps */
+struct InputDef
+{
+  const char *Name;
+  const char *Channels[3];  /* One channel, or three for a norm */
+  float Scale;
+};
+
+static const InputDef InputDefs[] =
+{
+  { "ACC_X", { "acc_x", nullptr, nullptr }, 0.001F },
+  { "ACC_Y", { "acc_y", nullptr, nullptr }, 0.001F },
+  { "ACC_Z", { "acc_z", nullptr, nullptr }, 0.001F },
+  { "ACC_V", { "acc_x", "acc_y", "acc_z" }, 0.001F },
+  { "GY_X", { "gyr_x", nullptr, nullptr }, 0.001F },
+  { "GY_Y", { "gyr_y", nullptr, nullptr }, 0.001F },
+  { "GY_Z", { "gyr_z", nullptr, nullptr }, 0.001F },
+  { "GY_V", { "gyr_x", "gyr_y", "gyr_z" }, 0.001F },
+};
+
+/**
+  * @brief  Split a comma list
+  * @param  List the list
+  * @retval The items
+  */
+static std::vector<std::string> SplitList(const std::string &List)
+{
+  std::vector<std::string> items;
+  std::stringstream in(List);
+  std::string item;
+
+  while (std::getline(in, item, ','))
+  {
+    if (!item.empty())
+    {
+      items.push_back(item);
+    }
+  }
+
+  return items;
+}
+
+/**
+  * @brief  Check and store the feature configuration
+  * @param  Features comma list of feature names
+  * @param  Inputs comma list of input names
+  * @param  Window the window length [samples]
+  * @param  Out the configuration
+  * @param  Error the reason of a failure
+  * @retval true in case of success, false otherwise
+  */
+bool ParseFeatureSpec(const std::string &Features, const std::string &Inputs, uint32_t Window, FeatureSpec &Out,
+                      std::string &Error)
+{
+  Out.Features = SplitList(Features);
+  Out.Inputs = SplitList(Inputs);
+  Out.Window = Window;
+
+  for (const std::string &f : Out.Features)
+  {
+    if (std::find_if(std::begin(FeatureNames), std::end(FeatureNames),
+                     [&](const char *Name) { return f == Name; }) == std::end(FeatureNames))
+    {
+      Error = "unknown feature " + f;
+      return false;
+    }
+  }
+
+  for (const std::string &i : Out.Inputs)
+  {
+    if (std::find_if(std::begin(InputDefs), std::end(InputDefs),
+                     [&](const InputDef &Def) { return i == Def.Name; }) == std::end(InputDefs))
+    {
+      Error = "unknown input " + i;
+      return false;
+    }
+  }
+
+  if (Out.Features.empty() || Out.Inputs.empty() || (Window == 0U))
+  {
+    Error = "empty feature set or window";
+    return false;
+  }
+
+  return true;
+}
+
+/**
+  * @brief  Compute one feature over a window
+  * @param  Feature the feature name
+  * @param  Values the window
+  * @param  Count the window length
+  * @retval The feature value
+  */
+static float Compute(const std::string &Feature, const float *Values, size_t Count)
+{
+  double sum = 0.0;
+  double sum2 = 0.0;
+  float lo = Values[0];
+  float hi = Values[0];
+
+  for (size_t i = 0U; i < Count; i++)
+  {
+    sum += Values[i];
+    sum2 += static_cast<double>(Values[i]) * Values[i];
+    lo = std::min(lo, Values[i]);
+    hi = std::max(hi, Values[i]);
+  }
+
+  if (Feature == "MEAN")
+  {
+    return static_cast<float>(sum / static_cast<double>(Count));
+  }
+  if (Feature == "VARIANCE")
+  {
+    double mean = sum / static_cast<double>(Count);
+    return static_cast<float>((sum2 / static_cast<double>(Count)) - (mean * mean));
+  }
+  if (Feature == "ENERGY")
+  {
+    return static_cast<float>(sum2);
+  }
+  if (Feature == "PEAK_TO_PEAK")
+  {
+    return hi - lo;
+  }
+
+  return (Feature == "MINIMUM") ? lo : hi;
+}
+
+/**
+  * @brief  Build the feature table from labeled recordings
+  * @note   A trailing partial window is dropped.
+  * @param  Recordings the recordings and their class
+  * @param  Spec the feature configuration
+  * @param  Out the table
+  * @param  Error the reason of a failure
+  * @retval true in case of success, false otherwise
+  */
+bool ExtractFeatures(const std::vector<LabeledRecording> &Recordings, const FeatureSpec &Spec, Dataset &Out,
+                     std::string &Error)
+{
+  uint32_t n = 1U;
+
+  Out = Dataset();
+  Out.Name = "recordings";
+
+  /* Numbered by input, then by feature */
+  for (const std::string &input : Spec.Inputs)
+  {
+    for (const std::string &feature : Spec.Features)
+    {
+      Out.FeatureNames.push_back("F" + std::to_string(n++) + "_" + feature + "_on_" + input);
+    }
+  }
+  Out.Columns.resize(Out.FeatureNames.size());
+
+  for (const LabeledRecording &r : Recordings)
+  {
+    rec::Reader reader;
+    std::vector<std::vector<float>> signals;
+    int32_t label = Out.FindClass(r.Class);
+
+    if (label < 0)
+    {
+      label = static_cast<int32_t>(Out.ClassNames.size());
+      Out.ClassNames.push_back(r.Class);
+    }
+
+    if (!reader.Open(r.Path))
+    {
+      Error = reader.LastError();
+      return false;
+    }
+
+    /* One converted signal per input, for the whole recording */
+    for (const std::string &name : Spec.Inputs)
+    {
+      const InputDef &def = *std::find_if(std::begin(InputDefs), std::end(InputDefs),
+                                          [&](const InputDef &Def) { return name == Def.Name; });
+      std::vector<float> signal(reader.Rows(), 0.0F);
+      bool norm = (def.Channels[1] != nullptr);
+
+      for (const char *channel : def.Channels)
+      {
+        int32_t ch = (channel != nullptr) ? reader.FindChannel(channel) : -2;
+        size_t row = 0U;
+
+        if (ch == -2)
+        {
+          continue;
+        }
+        if ((ch < 0) || (reader.ChannelType(static_cast<uint32_t>(ch)) != rec::Type::I32))
+        {
+          Error = r.Path + ": no int32 channel " + channel;
+          return false;
+        }
+
+        for (size_t c = 0U; c < reader.Chunks(); c++)
+        {
+          for (int32_t v : reader.Get<int32_t>(c, static_cast<uint32_t>(ch)))
+          {
+            float x = static_cast<float>(v) * def.Scale;
+            signal[row++] += norm ? (x * x) : x;
+          }
+        }
+      }
+
+      if (norm)
+      {
+        for (float &v : signal)
+        {
+          v = std::sqrt(v);
+        }
+      }
+
+      signals.push_back(std::move(signal));
+    }
+
+    for (uint64_t start = 0U; (start + Spec.Window) <= reader.Rows(); start += Spec.Window)
+    {
+      size_t col = 0U;
+
+      for (const std::vector<float> &signal : signals)
+      {
+        for (const std::string &feature : Spec.Features)
+        {
+          Out.Columns[col++].push_back(Compute(feature, &signal[start], Spec.Window));
+        }
+      }
+      Out.Labels.push_back(static_cast<uint16_t>(label));
+    }
+  }
+
+  return true;
+}
+
+} /* namespace mlc */
@@ -0,0 +1,58 @@
+/**
+  ******************************************************************************
+  * @file    features.hpp
+  * @author  ISCA Lab
+  * @brief   MLC window features computed from stream_rec recordings
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef FEATURES_HPP
+#define FEATURES_HPP
+
+#include <string>
+#include <vector>
+
+#include "dataset.hpp"
+
+/*
+ * Replaces the Unico ARFF export when the data was captured with tmsg2rec:
+ * each recording holds one class, it is cut in back-to-back windows of
+ * Window samples, as the MLC does, and the basic MLC features are computed
+ * per window on the acc_* [mg] and gyr_* [mdps] channels, converted to g and
+ * dps. The V inputs are the norm of the three axes.
+ *
+ * Features are named F<n>_<FEATURE>_on_<INPUT>, in the order they must be
+ * configured in Unico before the tree is imported.
+ */
+
+namespace mlc
+{
+
+struct FeatureSpec
+{
+  std::vector<std::string> Features;  /* MEAN VARIANCE ENERGY PEAK_TO_PEAK MINIMUM MAXIMUM */
+  std::vector<std::string> Inputs;    /* ACC_X ACC_Y ACC_Z ACC_V GY_X GY_Y GY_Z GY_V */
+  uint32_t Window;                    /* [samples] */
+};
+
+struct LabeledRecording
+{
+  std::string Path;
+  std::string Class;
+};
+
+bool ParseFeatureSpec(const std::string &Features, const std::string &Inputs, uint32_t Window, FeatureSpec &Out,
+                      std::string &Error);
+bool ExtractFeatures(const std::vector<LabeledRecording> &Recordings, const FeatureSpec &Spec, Dataset &Out,
+                     std::string &Error);
+
+} /* namespace mlc */
+
+#endif /* FEATURES_HPP */
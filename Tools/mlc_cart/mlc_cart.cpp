@@ -0,0 +1,500 @@
+/**
+  ******************************************************************************
+  * @file    mlc_cart.cpp
+  * @author  ISCA Lab
+  * @brief   Train MLC decision trees within the LSM6DSOX limits
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cart.hpp"
+#include "dataset.hpp"
+#include "features.hpp"
+#include "parallel.hpp"
+
+struct Options
+{
+  std::vector<std::string> Inputs;
+  std::string ClassAttribute;
+  std::string Features = "MEAN,VARIANCE,ENERGY,PEAK_TO_PEAK";
+  std::string Signals = "ACC_X,ACC_Y,ACC_Z,GY_X,GY_Y,GY_Z";
+  uint32_t Window = 52U;
+  mlc::Limits Limit;
+  mlc::Params Param;
+  bool Half = true;
+  uint32_t Folds = 10U;
+  uint32_t Seed = 1U;
+  unsigned Threads = 0U;
+  std::vector<uint32_t> SweepNodes;
+  std::vector<uint32_t> SweepLeaf;
+  std::string OutPrefix;
+  std::string ArffPrefix;
+};
+
+/* Cross-validation result of one configuration */
+struct Score
+{
+  uint32_t MaxNodes;
+  uint32_t MinLeaf;
+  uint64_t Correct;
+  uint64_t Total;
+  double Nodes;                                 /* Mean over the folds */
+  std::vector<std::vector<uint64_t>> Confusion; /* Tree 0 [actual][predicted] */
+};
+
+/**
+  * @brief  Print the command line help
+  * @retval None
+  */
+static void Usage(void)
+{
+  std::fprintf(stderr,
+               "usage: mlc_cart [options] <tree> [<tree> ...]\n"
+               "  tree: features.arff (Unico export), or a comma list of\n"
+               "        capture.rec=class (stream_rec recordings, one class each)\n"
+               "options:\n"
+               "  -c <attr>              ARFF class attribute (default: last nominal)\n"
+               "  -o <prefix>            write <prefix>_tree<n>.txt, J48 text for Unico\n"
+               "  --arff <prefix>        write the features as <prefix>_tree<n>.arff\n"
+               "  --window <n>           recording window [samples] (default 52)\n"
+               "  --features <list>      MEAN,VARIANCE,ENERGY,PEAK_TO_PEAK,MINIMUM,MAXIMUM\n"
+               "  --inputs <list>        ACC_X,ACC_Y,ACC_Z,ACC_V,GY_X,GY_Y,GY_Z,GY_V\n"
+               "  --max-nodes <n>        nodes of all trees (default 256)\n"
+               "  --max-features <n>     distinct features of all trees (default 32)\n"
+               "  --max-trees <n>        trees (default 8)\n"
+               "  --max-classes <n>      results per tree (default 16)\n"
+               "  --max-window <n>       window length limit (default 255)\n"
+               "  --min-leaf <n>         windows per leaf (default 2)\n"
+               "  --max-depth <n>        depth limit (default none)\n"
+               "  --criterion gini|entropy\n"
+               "  --no-merge             keep splits whose leaves give the same class\n"
+               "  --no-half              train on float features, not half precision\n"
+               "  --folds <k>            cross-validation folds, 0 for none (default 10)\n"
+               "  --seed <n>             fold shuffle seed (default 1)\n"
+               "  --threads <n>          worker threads (default: all)\n"
+               "  --sweep-nodes <list>   cross-validate each max-nodes value\n"
+               "  --sweep-leaf <list>    cross-validate each min-leaf value\n");
+}
+
+/**
+  * @brief  Parse a comma list of numbers
+  * @param  List the list
+  * @retval The numbers
+  */
+static std::vector<uint32_t> ParseNumbers(const std::string &List)
+{
+  std::vector<uint32_t> out;
+  std::stringstream in(List);
+  std::string item;
+
+  while (std::getline(in, item, ','))
+  {
+    out.push_back(static_cast<uint32_t>(std::strtoul(item.c_str(), nullptr, 0)));
+  }
+
+  return out;
+}
+
+/**
+  * @brief  Parse the command line
+  * @param  argc the argument count
+  * @param  argv the arguments
+  * @param  Opt the options
+  * @retval true in case of success, false otherwise
+  */
+static bool ParseArgs(int argc, char **argv, Options &Opt)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    std::string a = argv[i];
+    bool has_value = (i + 1) < argc;
+    std::string v = has_value ? argv[i + 1] : "";
+    uint32_t n = static_cast<uint32_t>(std::strtoul(v.c_str(), nullptr, 0));
+
+    if (a[0] != '-')
+    {
+      Opt.Inputs.push_back(a);
+      continue;
+    }
+
+    if (a == "--no-merge")
+    {
+      Opt.Param.Merge = false;
+      continue;
+    }
+    if (a == "--no-half")
+    {
+      Opt.Half = false;
+      continue;
+    }
+    if (!has_value)
+    {
+      return false;
+    }
+    i++;
+
+    if (a == "-c") { Opt.ClassAttribute = v; }
+    else if (a == "-o") { Opt.OutPrefix = v; }
+    else if (a == "--arff") { Opt.ArffPrefix = v; }
+    else if (a == "--window") { Opt.Window = n; }
+    else if (a == "--features") { Opt.Features = v; }
+    else if (a == "--inputs") { Opt.Signals = v; }
+    else if (a == "--max-nodes") { Opt.Limit.MaxNodes = n; }
+    else if (a == "--max-features") { Opt.Limit.MaxFeatures = n; }
+    else if (a == "--max-trees") { Opt.Limit.MaxTrees = n; }
+    else if (a == "--max-classes") { Opt.Limit.MaxClasses = n; }
+    else if (a == "--max-window") { Opt.Limit.MaxWindow = n; }
+    else if (a == "--min-leaf") { Opt.Param.MinLeaf = n; }
+    else if (a == "--max-depth") { Opt.Param.MaxDepth = n; }
+    else if (a == "--folds") { Opt.Folds = n; }
+    else if (a == "--seed") { Opt.Seed = n; }
+    else if (a == "--threads") { Opt.Threads = n; }
+    else if (a == "--sweep-nodes") { Opt.SweepNodes = ParseNumbers(v); }
+    else if (a == "--sweep-leaf") { Opt.SweepLeaf = ParseNumbers(v); }
+    else if (a == "--criterion")
+    {
+      if ((v != "gini") && (v != "entropy"))
+      {
+        return false;
+      }
+      Opt.Param.Impurity = (v == "gini") ? mlc::Criterion::Gini : mlc::Criterion::Entropy;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  return !Opt.Inputs.empty() && (Opt.Folds != 1U);
+}
+
+/**
+  * @brief  Load the dataset of one tree
+  * @param  Input an ARFF path or a list of recording=class
+  * @param  Opt the options
+  * @param  Out the dataset
+  * @param  Error the reason of a failure
+  * @retval true in case of success, false otherwise
+  */
+static bool LoadTree(const std::string &Input, const Options &Opt, mlc::Dataset &Out, std::string &Error)
+{
+  std::vector<mlc::LabeledRecording> recordings;
+  mlc::FeatureSpec spec;
+  std::stringstream in(Input);
+  std::string item;
+
+  if (Input.find('=') == std::string::npos)
+  {
+    return mlc::LoadArff(Input, Opt.ClassAttribute, Out, Error);
+  }
+
+  if (Opt.Window > Opt.Limit.MaxWindow)
+  {
+    Error = "window of " + std::to_string(Opt.Window) + " samples, the MLC takes up to "
+            + std::to_string(Opt.Limit.MaxWindow);
+    return false;
+  }
+
+  while (std::getline(in, item, ','))
+  {
+    size_t eq = item.find('=');
+    if ((eq == std::string::npos) || (eq == 0U) || ((eq + 1U) == item.size()))
+    {
+      Error = "expected capture.rec=class: " + item;
+      return false;
+    }
+    recordings.push_back({ item.substr(0U, eq), item.substr(eq + 1U) });
+  }
+
+  return mlc::ParseFeatureSpec(Opt.Features, Opt.Signals, Opt.Window, spec, Error)
+         && mlc::ExtractFeatures(recordings, spec, Out, Error);
+}
+
+/**
+  * @brief  Cross-validate configurations, one task per configuration and fold
+  * @param  Sets one dataset per tree
+  * @param  Opt the options
+  * @param  Scores the configurations to score
+  * @retval true in case of success, false otherwise
+  */
+static bool CrossValidate(const std::vector<const mlc::Dataset *> &Sets, const Options &Opt,
+                          std::vector<Score> &Scores)
+{
+  std::vector<std::vector<uint32_t>> folds;
+  std::vector<std::string> errors(Scores.size() * Opt.Folds);
+  std::vector<std::vector<std::vector<uint64_t>>> confusion(errors.size());
+  std::vector<uint64_t> correct(errors.size(), 0U);
+  std::vector<uint64_t> total(errors.size(), 0U);
+  std::vector<uint32_t> nodes(errors.size(), 0U);
+
+  for (const mlc::Dataset *d : Sets)
+  {
+    folds.push_back(mlc::MakeFolds(*d, Opt.Folds, Opt.Seed));
+  }
+
+  mlc::ParallelFor(errors.size(), mlc::ThreadCount(Opt.Threads), [&](size_t Task)
+  {
+    const Score &s = Scores[Task / Opt.Folds];
+    uint32_t k = static_cast<uint32_t>(Task % Opt.Folds);
+    mlc::Limits limit = Opt.Limit;
+    mlc::Params param = Opt.Param;
+    mlc::RowSets train(Sets.size());
+    std::vector<mlc::Tree> trees;
+
+    limit.MaxNodes = s.MaxNodes;
+    param.MinLeaf = s.MinLeaf;
+    param.Threads = 1U;
+
+    for (size_t t = 0U; t < Sets.size(); t++)
+    {
+      for (uint32_t r = 0U; r < Sets[t]->Rows(); r++)
+      {
+        if (folds[t][r] != k)
+        {
+          train[t].push_back(r);
+        }
+      }
+    }
+
+    if (!mlc::Train(Sets, train, limit, param, trees, errors[Task]))
+    {
+      return;
+    }
+
+    confusion[Task].assign(Sets[0]->ClassNames.size(), std::vector<uint64_t>(Sets[0]->ClassNames.size(), 0U));
+    for (size_t t = 0U; t < Sets.size(); t++)
+    {
+      nodes[Task] += trees[t].Size();
+      for (uint32_t r = 0U; r < Sets[t]->Rows(); r++)
+      {
+        if (folds[t][r] == k)
+        {
+          uint16_t p = trees[t].Predict(*Sets[t], r);
+          correct[Task] += (p == Sets[t]->Labels[r]) ? 1U : 0U;
+          total[Task]++;
+          if (t == 0U)
+          {
+            confusion[Task][Sets[t]->Labels[r]][p]++;
+          }
+        }
+      }
+    }
+  });
+
+  for (size_t task = 0U; task < errors.size(); task++)
+  {
+    Score &s = Scores[task / Opt.Folds];
+
+    if (!errors[task].empty())
+    {
+      std::fprintf(stderr, "%s\n", errors[task].c_str());
+      return false;
+    }
+
+    if ((task % Opt.Folds) == 0U)
+    {
+      s.Correct = 0U;
+      s.Total = 0U;
+      s.Nodes = 0.0;
+      s.Confusion = confusion[task];
+      for (std::vector<uint64_t> &row : s.Confusion)
+      {
+        std::fill(row.begin(), row.end(), 0U);
+      }
+    }
+
+    s.Correct += correct[task];
+    s.Total += total[task];
+    s.Nodes += static_cast<double>(nodes[task]) / Opt.Folds;
+    for (size_t a = 0U; a < s.Confusion.size(); a++)
+    {
+      for (size_t p = 0U; p < s.Confusion.size(); p++)
+      {
+        s.Confusion[a][p] += confusion[task][a][p];
+      }
+    }
+  }
+
+  return true;
+}
+
+/**
+  * @brief  Share of correct predictions
+  * @param  Correct the correct predictions
+  * @param  Total the predictions
+  * @retval The accuracy [%]
+  */
+static double Percent(uint64_t Correct, uint64_t Total)
+{
+  return (Total == 0U) ? 0.0 : ((100.0 * static_cast<double>(Correct)) / static_cast<double>(Total));
+}
+
+/**
+  * @brief  Seconds since a start point
+  * @param  Start the start point
+  * @retval Seconds
+  */
+static double Elapsed(std::chrono::steady_clock::time_point Start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+}
+
+int main(int argc, char **argv)
+{
+  Options opt;
+  std::vector<mlc::Dataset> data;
+  std::vector<const mlc::Dataset *> sets;
+  std::vector<mlc::Tree> trees;
+  std::vector<Score> scores;
+  std::string error;
+  auto start = std::chrono::steady_clock::now();
+
+  if (!ParseArgs(argc, argv, opt))
+  {
+    Usage();
+    return 2;
+  }
+
+  data.resize(opt.Inputs.size());
+  for (size_t t = 0U; t < opt.Inputs.size(); t++)
+  {
+    if (!LoadTree(opt.Inputs[t], opt, data[t], error))
+    {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    if (opt.Half)
+    {
+      mlc::QuantizeHalf(data[t]);
+    }
+    if (!opt.ArffPrefix.empty()
+        && !mlc::SaveArff(opt.ArffPrefix + "_tree" + std::to_string(t + 1U) + ".arff", data[t], error))
+    {
+      std::fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    sets.push_back(&data[t]);
+    std::printf("tree %zu: %zu windows, %zu features, %zu classes\n", t + 1U, data[t].Rows(), data[t].Features(),
+                data[t].ClassNames.size());
+  }
+
+  /* Cross-validation of the configuration, or of each sweep point */
+  if (opt.Folds > 1U)
+  {
+    std::vector<uint32_t> node_list = opt.SweepNodes.empty() ? std::vector<uint32_t>{ opt.Limit.MaxNodes }
+                                                             : opt.SweepNodes;
+    std::vector<uint32_t> leaf_list = opt.SweepLeaf.empty() ? std::vector<uint32_t>{ opt.Param.MinLeaf }
+                                                            : opt.SweepLeaf;
+
+    for (uint32_t nodes : node_list)
+    {
+      for (uint32_t leaf : leaf_list)
+      {
+        scores.push_back({ nodes, leaf, 0U, 0U, 0.0, {} });
+      }
+    }
+
+    if (!CrossValidate(sets, opt, scores))
+    {
+      return 1;
+    }
+
+    /* Best accuracy first, the smaller tree on a tie */
+    std::stable_sort(scores.begin(), scores.end(), [](const Score &A, const Score &B)
+    {
+      double a = Percent(A.Correct, A.Total);
+      double b = Percent(B.Correct, B.Total);
+      return (a != b) ? (a > b) : (A.Nodes < B.Nodes);
+    });
+
+    std::printf("\n%u-fold cross-validation, %zu configurations, %.2f s\n", opt.Folds, scores.size(), Elapsed(start));
+    std::printf("max-nodes min-leaf  accuracy  mean nodes\n");
+    for (const Score &s : scores)
+    {
+      std::printf("%9u %8u  %7.3f%%  %10.1f\n", s.MaxNodes, s.MinLeaf,
+                  Percent(s.Correct, s.Total), s.Nodes);
+    }
+
+    std::printf("\nconfusion of tree 1 (rows: actual, columns: predicted)\n");
+    for (size_t a = 0U; a < scores[0].Confusion.size(); a++)
+    {
+      for (uint64_t n : scores[0].Confusion[a])
+      {
+        std::printf("%8llu", static_cast<unsigned long long>(n));
+      }
+      std::printf("   %s\n", data[0].ClassNames[a].c_str());
+    }
+
+    opt.Limit.MaxNodes = scores[0].MaxNodes;
+    opt.Param.MinLeaf = scores[0].MinLeaf;
+  }
+
+  /* Final model on all windows, with the best configuration */
+  start = std::chrono::steady_clock::now();
+  opt.Param.Threads = mlc::ThreadCount(opt.Threads);
+  if (!mlc::Train(sets, mlc::RowSets(), opt.Limit, opt.Param, trees, error))
+  {
+    std::fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  uint32_t total_nodes = 0U;
+  std::printf("\nmodel: max-nodes %u, min-leaf %u, trained in %.3f s\n", opt.Limit.MaxNodes, opt.Param.MinLeaf,
+              Elapsed(start));
+  for (size_t t = 0U; t < trees.size(); t++)
+  {
+    uint64_t correct = 0U;
+    for (uint32_t r = 0U; r < data[t].Rows(); r++)
+    {
+      correct += (trees[t].Predict(data[t], r) == data[t].Labels[r]) ? 1U : 0U;
+    }
+    total_nodes += trees[t].Size();
+    std::printf("tree %zu: %u nodes, %u leaves, training accuracy %.3f%%\n", t + 1U, trees[t].Size(),
+                trees[t].Leaves(), Percent(correct, data[t].Rows()));
+  }
+
+  std::vector<std::string> used = mlc::UsedFeatures(trees);
+  std::printf("nodes %u / %u, features %zu / %u, trees %zu / %u\n", total_nodes, opt.Limit.MaxNodes, used.size(),
+              opt.Limit.MaxFeatures, trees.size(), opt.Limit.MaxTrees);
+  std::printf("features to configure in Unico:\n");
+  for (const std::string &name : used)
+  {
+    std::printf("  %s\n", name.c_str());
+  }
+
+  if (!opt.OutPrefix.empty())
+  {
+    for (size_t t = 0U; t < trees.size(); t++)
+    {
+      std::string path = opt.OutPrefix + "_tree" + std::to_string(t + 1U) + ".txt";
+      std::ofstream out(path);
+
+      out << mlc::FormatJ48(trees[t]);
+      if (!out)
+      {
+        std::fprintf(stderr, "cannot write %s\n", path.c_str());
+        return 1;
+      }
+      std::printf("wrote %s\n", path.c_str());
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,603 @@
+/**
+  ******************************************************************************
+  * @file    mlc_cart_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the MLC tree trainer: splits, limits, folds, threads, J48
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "cart.hpp"
+#include "dataset.hpp"
+
+/*
+ * Runs cart.cpp and dataset.cpp in process, and the mlc_cart command built
+ * next to it for what only the command line does:
+ *
+ *  - split: the root split of small tables worked out by hand, with Gini
+ *    and entropy, MinLeaf, and a tie between two columns,
+ *  - limits: random tables and limits, the trees never take more nodes,
+ *    features, trees or classes than allowed, nor go deeper than MaxDepth,
+ *    and mlc_cart refuses a window past --max-window,
+ *  - folds: every class spread over the folds within one row,
+ *  - threads: the same trees from 1 to 8 threads, and the same report and
+ *    tree files from mlc_cart with --threads 1 and 4,
+ *  - J48: the tree of golden/activity.arff against golden/activity_tree1.txt.
+ */
+
+/**
+  * @brief  Print a check
+  * @param  Name the check
+  * @param  Pass the result
+  * @param  Detail printed after the name
+  * @retval Pass
+  */
+static bool Report(const char *Name, bool Pass, const std::string &Detail = "")
+{
+  std::printf("%-10s %-60s %s\n", Name, Detail.c_str(), Pass ? "ok" : "FAILED");
+  return Pass;
+}
+
+/**
+  * @brief  Build a table of one feature column per list
+  * @param  Columns the values, one list per feature
+  * @param  Labels the class of each row
+  * @param  Classes the class count
+  * @retval The table
+  */
+static mlc::Dataset Table(const std::vector<std::vector<float>> &Columns, const std::vector<uint16_t> &Labels,
+                          uint32_t Classes)
+{
+  mlc::Dataset d;
+
+  d.Name = "table";
+  for (size_t f = 0U; f < Columns.size(); f++)
+  {
+    d.FeatureNames.push_back("F" + std::to_string(f + 1U));
+  }
+  for (uint32_t c = 0U; c < Classes; c++)
+  {
+    d.ClassNames.push_back(std::string(1, static_cast<char>('a' + c)));
+  }
+  d.Columns = Columns;
+  d.Labels = Labels;
+  return d;
+}
+
+/**
+  * @brief  Train one tree on all the rows of a table
+  * @param  Data the table
+  * @param  Limit the limits
+  * @param  Param the parameters
+  * @param  Out the tree
+  * @retval true if trained
+  */
+static bool TrainOne(const mlc::Dataset &Data, const mlc::Limits &Limit, const mlc::Params &Param, mlc::Tree &Out)
+{
+  std::vector<mlc::Tree> trees;
+  std::string error;
+
+  if (!mlc::Train({ &Data }, mlc::RowSets(), Limit, Param, trees, error))
+  {
+    return false;
+  }
+  Out = trees[0];
+  return true;
+}
+
+/**
+  * @brief  Check the root split of a tree
+  * @param  T the tree
+  * @param  Feature the expected column
+  * @param  Threshold the expected threshold
+  * @retval true if it matches
+  */
+static bool RootIs(const mlc::Tree &T, int32_t Feature, float Threshold)
+{
+  return (T.Nodes.size() >= 3U) && (T.Nodes[0].Feature == Feature) && (T.Nodes[0].Threshold == Threshold);
+}
+
+/**
+  * @brief  Root splits of small tables, worked out by hand
+  * @retval true if passed
+  */
+static bool Splits()
+{
+  mlc::Limits root;
+  mlc::Params param;
+  mlc::Tree t;
+  bool ok = true;
+
+  root.MaxNodes = 3U;
+  param.MinLeaf = 1U;
+
+  /*
+   * x 1..9, classes a a a b a b b b b. The weighted Gini (n - sum c^2 / n)
+   * of the root is 9 - 41/9 = 4.44. Left of each threshold, right:
+   *   <= 3   aaa 0,        ab4 6 - 26/6 = 1.67,   1.67
+   *   <= 4   a3b 1.5,      ab4 1.6,               3.1
+   *   <= 5   a4b 1.6,      b4 0,                  1.6
+   * x <= 5 is the best, a (5.0/1.0) and b (4.0).
+   */
+  mlc::Dataset d = Table({ { 1, 2, 3, 4, 5, 6, 7, 8, 9 } }, { 0, 0, 0, 1, 0, 1, 1, 1, 1 }, 2U);
+  ok &= TrainOne(d, root, param, t) && RootIs(t, 0, 5.0F) && (t.Nodes[1].Class == 0U) && (t.Nodes[1].Count == 5U)
+        && (t.Nodes[1].Errors == 1U) && (t.Nodes[2].Class == 1U) && (t.Nodes[2].Errors == 0U);
+
+  /* MinLeaf 4 leaves x <= 4 (4 | 5) and x <= 5 (5 | 4): still 5. MinLeaf 5
+     leaves nothing, the root is a leaf a (9.0/4.0) */
+  param.MinLeaf = 4U;
+  ok &= TrainOne(d, root, param, t) && RootIs(t, 0, 5.0F);
+  param.MinLeaf = 5U;
+  ok &= TrainOne(d, root, param, t) && (t.Nodes.size() == 1U) && (t.Nodes[0].Count == 9U)
+        && (t.Nodes[0].Errors == 4U);
+
+  /* The same column reversed, 10 - x, gives the same split at 10 - x <= 4.
+     The lower column wins the tie, whichever it is */
+  param.MinLeaf = 1U;
+  d = Table({ { 1, 2, 3, 4, 5, 6, 7, 8, 9 }, { 9, 8, 7, 6, 5, 4, 3, 2, 1 } }, { 0, 0, 0, 1, 0, 1, 1, 1, 1 }, 2U);
+  ok &= TrainOne(d, root, param, t) && RootIs(t, 0, 5.0F);
+  std::swap(d.Columns[0], d.Columns[1]);
+  ok &= TrainOne(d, root, param, t) && RootIs(t, 0, 4.0F);
+
+  /*
+   * x 1..8, classes b a b c c c a a. Gini and entropy disagree:
+   *            Gini                      entropy (n ln n - sum c ln c)
+   *   <= 3    (a1 b2) 1.33 + (a2 c3) 2.4 = 3.73    1.91 + 3.37 = 5.27
+   *   <= 6    (a1 b2 c3) 3.67 + (a2) 0   = 3.67    6.07 + 0    = 6.07
+   */
+  d = Table({ { 1, 2, 3, 4, 5, 6, 7, 8 } }, { 1, 0, 1, 2, 2, 2, 0, 0 }, 3U);
+  param.Impurity = mlc::Criterion::Gini;
+  ok &= TrainOne(d, root, param, t) && RootIs(t, 0, 6.0F);
+  param.Impurity = mlc::Criterion::Entropy;
+  ok &= TrainOne(d, root, param, t) && RootIs(t, 0, 3.0F);
+
+  /* Equal values are never split apart: 1 1 | 2 2 only */
+  d = Table({ { 1, 1, 2, 2 } }, { 0, 1, 1, 1 }, 2U);
+  param.Impurity = mlc::Criterion::Gini;
+  ok &= TrainOne(d, root, param, t) && RootIs(t, 0, 1.0F) && (t.Nodes[1].Count == 2U);
+
+  return Report("split", ok, "4 tables by hand, Gini, entropy, MinLeaf, column tie");
+}
+
+/**
+  * @brief  A random table whose class depends on a few features, with noise
+  * @param  Rng the generator
+  * @param  Tree the tree index, shifts the feature names
+  * @param  Rows the rows
+  * @param  Classes the classes
+  * @retval The table
+  */
+static mlc::Dataset RandomTable(std::mt19937 &Rng, uint32_t Tree, uint32_t Rows, uint32_t Classes)
+{
+  std::normal_distribution<float> noise(0.0F, 1.0F);
+  mlc::Dataset d;
+  const uint32_t features = 24U;
+
+  d.Name = "tree" + std::to_string(Tree);
+  for (uint32_t f = 0U; f < features; f++)
+  {
+    /* Trees share some feature names, not all */
+    d.FeatureNames.push_back("F" + std::to_string(((f + (5U * Tree)) % 40U) + 1U));
+  }
+  for (uint32_t c = 0U; c < Classes; c++)
+  {
+    d.ClassNames.push_back("c" + std::to_string(c));
+  }
+  d.Columns.assign(features, std::vector<float>(Rows));
+  for (uint32_t r = 0U; r < Rows; r++)
+  {
+    uint16_t label = static_cast<uint16_t>(Rng() % Classes);
+
+    d.Labels.push_back(label);
+    for (uint32_t f = 0U; f < features; f++)
+    {
+      /* Every third feature carries the class, rounded so values repeat */
+      float v = noise(Rng) * 2.0F + (((f % 3U) == 0U) ? static_cast<float>(label * (1U + (f % 4U))) : 0.0F);
+      d.Columns[f][r] = static_cast<float>(static_cast<int32_t>(v * 8.0F)) / 8.0F;
+    }
+  }
+  return d;
+}
+
+/**
+  * @brief  Depth of the deepest leaf
+  * @param  T the tree
+  * @param  Index the subtree root
+  * @retval The depth, 0 for a leaf
+  */
+static uint32_t Depth(const mlc::Tree &T, int32_t Index)
+{
+  const mlc::Node &n = T.Nodes[static_cast<size_t>(Index)];
+
+  return (n.Feature < 0) ? 0U : (1U + std::max(Depth(T, n.Left), Depth(T, n.Right)));
+}
+
+/**
+  * @brief  Check that the node counts add up and every leaf holds MinLeaf
+  * @param  T the tree
+  * @param  MinLeaf the minimum leaf size
+  * @retval true if consistent
+  */
+static bool Consistent(const mlc::Tree &T, uint32_t MinLeaf)
+{
+  for (const mlc::Node &n : T.Nodes)
+  {
+    if (n.Feature < 0)
+    {
+      if (n.Count < MinLeaf)
+      {
+        return false;
+      }
+      continue;
+    }
+    const mlc::Node &l = T.Nodes[static_cast<size_t>(n.Left)];
+    const mlc::Node &r = T.Nodes[static_cast<size_t>(n.Right)];
+    if ((static_cast<size_t>(n.Feature) >= T.Data->Features()) || ((l.Count + r.Count) != n.Count))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+  * @brief  Run the mlc_cart command
+  * @param  Args the arguments
+  * @param  Output the standard output and error
+  * @retval The exit code
+  */
+static int Command(const std::string &Args, std::string &Output)
+{
+  std::string cmd = "./mlc_cart " + Args + " 2>&1";
+  FILE *p = popen(cmd.c_str(), "r");
+  char buf[512];
+  size_t n;
+
+  Output.clear();
+  if (p == nullptr)
+  {
+    return -1;
+  }
+  while ((n = std::fread(buf, 1U, sizeof(buf), p)) > 0U)
+  {
+    Output.append(buf, n);
+  }
+  int status = pclose(p);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/**
+  * @brief  Random limits on random tables, and the command line limits
+  * @retval true if passed
+  */
+static bool LimitChecks()
+{
+  std::mt19937 rng(65U);
+  uint32_t runs = 0U;
+  uint32_t full = 0U;
+  bool ok = true;
+
+  for (uint32_t run = 0U; ok && (run < 200U); run++)
+  {
+    uint32_t count = 1U + (rng() % 4U);
+    std::vector<mlc::Dataset> data;
+    std::vector<const mlc::Dataset *> sets;
+    std::vector<mlc::Tree> trees;
+    mlc::Limits limit;
+    mlc::Params param;
+    std::string error;
+
+    for (uint32_t t = 0U; t < count; t++)
+    {
+      data.push_back(RandomTable(rng, t, 100U + (rng() % 300U), 2U + (rng() % 4U)));
+    }
+    for (const mlc::Dataset &d : data)
+    {
+      sets.push_back(&d);
+    }
+    limit.MaxNodes = count + (rng() % 120U);
+    limit.MaxFeatures = 1U + (rng() % 12U);
+    param.MinLeaf = 1U + (rng() % 6U);
+    param.MaxDepth = rng() % 8U;
+    param.Impurity = ((rng() % 2U) == 0U) ? mlc::Criterion::Gini : mlc::Criterion::Entropy;
+    param.Merge = ((rng() % 4U) != 0U);
+
+    ok &= mlc::Train(sets, mlc::RowSets(), limit, param, trees, error);
+    if (!ok)
+    {
+      break;
+    }
+
+    uint32_t nodes = 0U;
+    for (const mlc::Tree &t : trees)
+    {
+      nodes += t.Size();
+      ok &= ((param.MaxDepth == 0U) || (Depth(t, 0) <= param.MaxDepth)) && Consistent(t, param.MinLeaf);
+    }
+    ok &= (nodes <= limit.MaxNodes) && (mlc::UsedFeatures(trees).size() <= limit.MaxFeatures);
+    full += ((nodes + 2U) > limit.MaxNodes) ? 1U : 0U;
+    runs++;
+
+    /* One tree or one class too many is refused */
+    mlc::Limits tight = limit;
+    tight.MaxTrees = count - 1U;
+    ok &= !mlc::Train(sets, mlc::RowSets(), tight, param, trees, error);
+    tight = limit;
+    tight.MaxClasses = static_cast<uint32_t>(data[0].ClassNames.size()) - 1U;
+    ok &= !mlc::Train(sets, mlc::RowSets(), tight, param, trees, error);
+    tight = limit;
+    tight.MaxNodes = count - 1U;
+    ok &= !mlc::Train(sets, mlc::RowSets(), tight, param, trees, error);
+  }
+
+  /* The command line: a window past --max-window is refused before any
+     recording is read, the report stays within the limits */
+  std::string out;
+  ok &= (Command("--folds 0 --window 256 none.rec=a", out) == 1) && (out.find("takes up to 255") != std::string::npos);
+  ok &= (Command("--folds 0 --max-window 32 --window 52 none.rec=a", out) == 1)
+        && (out.find("takes up to 32") != std::string::npos);
+  ok &= (Command("--folds 0 --max-window 32 --window 32 none.rec=a", out) == 1)
+        && (out.find("takes up to") == std::string::npos);
+  ok &= (Command("--folds 0 --max-trees 1 golden/activity.arff golden/activity.arff", out) == 1)
+        && (out.find("2 trees, the MLC runs 1 to 1") != std::string::npos);
+  ok &= (Command("--folds 0 --max-nodes 3 --max-features 1 golden/activity.arff", out) == 0)
+        && (out.find("nodes 3 / 3, features 1 / 1, trees 1 / 8") != std::string::npos);
+
+  char detail[96];
+  std::snprintf(detail, sizeof(detail), "%u random configurations, %u with the node budget full", runs, full);
+  return Report("limits", ok, detail);
+}
+
+/**
+  * @brief  Check the stratified folds
+  * @retval true if passed
+  */
+static bool Folds()
+{
+  std::mt19937 rng(66U);
+  bool ok = true;
+
+  for (uint32_t run = 0U; ok && (run < 100U); run++)
+  {
+    uint32_t classes = 2U + (rng() % 6U);
+    uint32_t folds = 2U + (rng() % 10U);
+    mlc::Dataset d = RandomTable(rng, 0U, 20U + (rng() % 400U), classes);
+
+    /* Uneven classes */
+    for (uint16_t &l : d.Labels)
+    {
+      l = ((rng() % 3U) == 0U) ? 0U : l;
+    }
+
+    std::vector<uint32_t> fold = mlc::MakeFolds(d, folds, run);
+    std::vector<std::vector<uint32_t>> count(classes, std::vector<uint32_t>(folds, 0U));
+    std::vector<uint32_t> size(folds, 0U);
+
+    ok &= (fold.size() == d.Rows()) && (mlc::MakeFolds(d, folds, run) == fold);
+    for (size_t r = 0U; ok && (r < d.Rows()); r++)
+    {
+      ok = (fold[r] < folds);
+      if (ok)
+      {
+        count[d.Labels[r]][fold[r]]++;
+        size[fold[r]]++;
+      }
+    }
+    /* Each class, and the folds, within one row of even */
+    for (uint32_t c = 0U; ok && (c < classes); c++)
+    {
+      auto mm = std::minmax_element(count[c].begin(), count[c].end());
+      ok = ((*mm.second - *mm.first) <= 1U);
+    }
+    auto mm = std::minmax_element(size.begin(), size.end());
+    ok &= ((*mm.second - *mm.first) <= 1U);
+  }
+
+  return Report("folds", ok, "100 tables, 2 to 11 folds, each class within one row");
+}
+
+/**
+  * @brief  Compare two trees node by node
+  * @param  A a tree
+  * @param  B a tree
+  * @retval true if identical
+  */
+static bool SameTree(const mlc::Tree &A, const mlc::Tree &B)
+{
+  if (A.Nodes.size() != B.Nodes.size())
+  {
+    return false;
+  }
+  for (size_t i = 0U; i < A.Nodes.size(); i++)
+  {
+    const mlc::Node &a = A.Nodes[i];
+    const mlc::Node &b = B.Nodes[i];
+    if ((a.Feature != b.Feature) || (std::memcmp(&a.Threshold, &b.Threshold, sizeof(float)) != 0)
+        || (a.Left != b.Left) || (a.Right != b.Right) || (a.Class != b.Class) || (a.Count != b.Count)
+        || (a.Errors != b.Errors))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+  * @brief  Read a whole file
+  * @param  Path the file
+  * @retval The text, empty if missing
+  */
+static std::string ReadFile(const std::string &Path)
+{
+  std::ifstream in(Path);
+  std::stringstream text;
+
+  text << in.rdbuf();
+  return text.str();
+}
+
+/**
+  * @brief  The report of mlc_cart without its timing and output lines
+  * @param  Output the report
+  * @param  Prefix the -o prefix of the run
+  * @retval The lines that do not depend on the run time or the prefix
+  */
+static std::string Untimed(const std::string &Output, const std::string &Prefix)
+{
+  std::stringstream in(Output);
+  std::string line;
+  std::string out;
+
+  while (std::getline(in, line))
+  {
+    if ((line.find("cross-validation,") == std::string::npos) && (line.find("trained in") == std::string::npos)
+        && (line != ("wrote " + Prefix + "_tree1.txt")) && (line != ("wrote " + Prefix + "_tree2.txt")))
+    {
+      out += line + "\n";
+    }
+  }
+  return out;
+}
+
+/**
+  * @brief  Same trees whatever the thread count
+  * @retval true if passed
+  */
+static bool Threads()
+{
+  std::mt19937 rng(67U);
+  uint32_t nodes = 0U;
+  bool ok = true;
+
+  for (uint32_t run = 0U; ok && (run < 20U); run++)
+  {
+    std::vector<mlc::Dataset> data;
+    std::vector<const mlc::Dataset *> sets;
+    std::vector<mlc::Tree> ref;
+    mlc::Limits limit;
+    mlc::Params param;
+    std::string error;
+
+    for (uint32_t t = 0U; t < 3U; t++)
+    {
+      data.push_back(RandomTable(rng, t, 2000U, 4U));
+    }
+    for (const mlc::Dataset &d : data)
+    {
+      sets.push_back(&d);
+    }
+    limit.MaxNodes = 64U + (rng() % 200U);
+    limit.MaxFeatures = 4U + (rng() % 20U);
+    param.MinLeaf = 1U + (rng() % 4U);
+    param.Impurity = ((run % 2U) == 0U) ? mlc::Criterion::Gini : mlc::Criterion::Entropy;
+
+    param.Threads = 1U;
+    ok &= mlc::Train(sets, mlc::RowSets(), limit, param, ref, error);
+    for (unsigned threads : { 2U, 3U, 8U })
+    {
+      std::vector<mlc::Tree> trees;
+
+      param.Threads = threads;
+      ok &= mlc::Train(sets, mlc::RowSets(), limit, param, trees, error) && (trees.size() == ref.size());
+      for (size_t t = 0U; ok && (t < ref.size()); t++)
+      {
+        ok = SameTree(ref[t], trees[t]);
+      }
+    }
+    for (const mlc::Tree &t : ref)
+    {
+      nodes += t.Size();
+    }
+  }
+
+  /* The command line: cross-validation sweep and final trees */
+  std::vector<mlc::Dataset> data;
+  std::string error;
+  for (uint32_t t = 0U; t < 2U; t++)
+  {
+    data.push_back(RandomTable(rng, t, 600U, 3U));
+    ok &= mlc::SaveArff("threads_in" + std::to_string(t) + ".arff", data[t], error);
+  }
+  std::string one;
+  std::string four;
+  const std::string args = "--folds 5 --sweep-nodes 16,48 --sweep-leaf 1,4 threads_in0.arff threads_in1.arff -o ";
+  ok &= (Command("--threads 1 " + args + "threads_one", one) == 0);
+  ok &= (Command("--threads 4 " + args + "threads_four", four) == 0);
+  ok &= (Untimed(one, "threads_one") == Untimed(four, "threads_four"));
+  for (uint32_t t = 1U; t <= 2U; t++)
+  {
+    std::string a = ReadFile("threads_one_tree" + std::to_string(t) + ".txt");
+    ok &= !a.empty() && (a == ReadFile("threads_four_tree" + std::to_string(t) + ".txt"));
+    (void)std::remove(("threads_one_tree" + std::to_string(t) + ".txt").c_str());
+    (void)std::remove(("threads_four_tree" + std::to_string(t) + ".txt").c_str());
+    (void)std::remove(("threads_in" + std::to_string(t - 1U) + ".arff").c_str());
+  }
+
+  char detail[96];
+  std::snprintf(detail, sizeof(detail), "20 x 3 trees, %u nodes, 1 2 3 8 threads, mlc_cart 1 and 4", nodes);
+  return Report("threads", ok, detail);
+}
+
+/**
+  * @brief  The J48 text of the golden table against the golden file
+  * @retval true if passed
+  */
+static bool Golden()
+{
+  mlc::Dataset d;
+  mlc::Limits limit;
+  mlc::Params param;
+  mlc::Tree t;
+  std::string error;
+  std::string want = ReadFile("golden/activity_tree1.txt");
+  bool ok = mlc::LoadArff("golden/activity.arff", "", d, error) && !want.empty();
+
+  param.MinLeaf = 3U;
+  ok = ok && TrainOne(d, limit, param, t) && (mlc::FormatJ48(t) == want);
+  if (ok)
+  {
+    /* The command line writes the same file */
+    std::string out;
+    ok = (Command("--folds 0 --no-half --min-leaf 3 -o golden_out golden/activity.arff", out) == 0)
+         && (ReadFile("golden_out_tree1.txt") == want);
+    (void)std::remove("golden_out_tree1.txt");
+  }
+  else
+  {
+    std::printf("%s", mlc::FormatJ48(t).c_str());
+  }
+
+  return Report("J48", ok, "golden/activity.arff, 3 leaves, one with an error");
+}
+
+int main()
+{
+  bool ok = true;
+
+  ok &= Splits();
+  ok &= LimitChecks();
+  ok &= Folds();
+  ok &= Threads();
+  ok &= Golden();
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * @file    parallel.hpp
+  * @author  ISCA Lab
+  * @brief   Minimal parallel loop for the trainer
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace mlc
+{
+
+/**
+  * @brief  Number of worker threads to use
+  * @param  Requested the requested count, 0 for one per hardware thread
+  * @retval The count, at least 1
+  */
+inline unsigned ThreadCount(unsigned Requested)
+{
+  unsigned hw = std::thread::hardware_concurrency();
+
+  return (Requested != 0U) ? Requested : ((hw != 0U) ? hw : 1U);
+}
+
+/**
+  * @brief  Run Fn(0) .. Fn(Count - 1) on up to Threads threads
+  * @note   Items are handed out one at a time, so uneven items balance out.
+  *         The calling thread takes part. Fn must not throw.
+  * @param  Count the number of items
+  * @param  Threads the thread limit, 1 runs inline
+  * @param  Fn the work for one item
+  * @retval None
+  */
+template <typename F> void ParallelFor(size_t Count, unsigned Threads, F &&Fn)
+{
+  std::atomic<size_t> next(0U);
+  std::vector<std::thread> workers;
+  size_t extra = std::min<size_t>(Threads, Count);
+  auto run = [&]()
+  {
+    for (size_t i = next++; i < Count; i = next++)
+    {
+      Fn(i);
+    }
+  };
+
+  for (size_t t = 1U; t < extra; t++)
+  {
+    workers.emplace_back(run);
+  }
+
+  run();
+
+  for (std::thread &w : workers)
+  {
+    w.join();
+  }
+}
+
+} /* namespace mlc */
+
+#endif /* PARALLEL_HPP */
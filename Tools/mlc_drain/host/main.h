@@ -0,0 +1,64 @@
+/**
+  ******************************************************************************
+  * @file    main.h
+  * @author  ISCA Lab
+  * @brief   Host stand-in for the application main.h
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported types ------------------------------------------------------------*/
+/* Only what lsm6dsox_mlc.c touches, the check gives them a meaning */
+typedef struct
+{
+  uint32_t Id;
+} GPIO_TypeDef;
+
+typedef enum
+{
+  GPIO_PIN_RESET = 0,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+typedef struct
+{
+  uint32_t CCR1;
+} TIM_TypeDef;
+
+/* Exported variables --------------------------------------------------------*/
+extern GPIO_TypeDef HostGpioC;
+extern TIM_TypeDef HostTim1;
+
+/* Exported defines ----------------------------------------------------------*/
+#define GPIOC       (&HostGpioC)
+#define TIM1        (&HostTim1)
+#define GPIO_PIN_0  0x0001U
+
+/* Exported functions --------------------------------------------------------*/
+/* Defined by the check */
+uint32_t HAL_GetTick(void);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void Error_Handler(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __MAIN_H */
@@ -0,0 +1,23 @@
+/**
+  ******************************************************************************
+  * @file    stm32wlxx_hal.h
+  * @author  ISCA Lab
+  * @brief   Host stand-in for the HAL, the few types come from main.h
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef STM32WLXX_HAL_H
+#define STM32WLXX_HAL_H
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+#endif /* STM32WLXX_HAL_H */
@@ -0,0 +1,52 @@
+/**
+  ******************************************************************************
+  * @file    stm32wlxx_nucleo_bus.h
+  * @author  ISCA Lab
+  * @brief   Host stand-in for the BSP bus, I2C2 register access and arbiter
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef STM32WLXX_NUCLEO_BUS_H
+#define STM32WLXX_NUCLEO_BUS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "stm32wlxx_nucleo_errno.h"
+
+/* Exported defines ----------------------------------------------------------*/
+/* Same clients as the firmware header */
+#define BUS_I2C2_CLIENT_SENSOR  0U
+#define BUS_I2C2_CLIENT_MLC     1U
+#define BUS_I2C2_CLIENT_CAL     2U
+
+/* Exported functions --------------------------------------------------------*/
+/* Defined by the check on a simulated bus */
+int32_t BSP_I2C2_Init(void);
+int32_t BSP_I2C2_DeInit(void);
+int32_t BSP_I2C2_WriteReg(uint16_t Addr, uint16_t Reg, uint8_t *pData, uint16_t Length);
+int32_t BSP_I2C2_ReadReg(uint16_t Addr, uint16_t Reg, uint8_t *pData, uint16_t Length);
+int32_t BSP_I2C2_Acquire(uint32_t Client);
+void BSP_I2C2_Release(void);
+int32_t BSP_SPI1_Init(void);
+int32_t BSP_SPI1_DeInit(void);
+int32_t BSP_SPI1_WriteReg(uint16_t Addr, uint16_t Reg, uint8_t *pData, uint16_t Length);
+int32_t BSP_SPI1_ReadReg(uint16_t Addr, uint16_t Reg, uint8_t *pData, uint16_t Length);
+int32_t BSP_GetTick(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STM32WLXX_NUCLEO_BUS_H */
@@ -0,0 +1,1244 @@
+/**
+  ******************************************************************************
+  * @file    mlc_drain_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the two-sensor MLC service against two simulated LSM6DSOX
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "main.h"
+#include "stm32wlxx_nucleo_bus.h"
+#include "app_mems.h"
+#include "custom_motion_sensors.h"
+#include "lsm6dsox_reg.h"
+#include "lsm6dsox_mlc.h"
+#include "log_sink.h"
+#include "mlc_snapshot.h"
+#include "startup_seq.h"
+#include "task_sched.h"
+#include "uplink.h"
+
+/*
+ * Runs the firmware lsm6dsox_mlc.c, custom_motion_sensors.c and the ST
+ * drivers on a host, with two LSM6DSOX simulated behind BSP_I2C2 at the SA0
+ * low and high addresses. Each device holds its register banks, the MLC
+ * latch and its INT1 line, and a FIFO batching tagged words at the
+ * configured rates. The words carry the device and a sequence number, so
+ * every word of a snapshot can be traced to its sensor and FIFO slot.
+ *
+ *  - routing: startup and configuration of both devices, the sensitivities
+ *    refreshed after the MLC full scales, the MLC events of each reported
+ *    with its sensor on the log and the uplink, sensor 0 read on its INT
+ *    line only,
+ *  - drain: every snapshot holds the FIFO of its own sensor at the freeze,
+ *    in order, the trigger at the pre-trigger level,
+ *  - interleave: bursts of at most SNAP_BURST_WORDS, one per bus hold,
+ *    sensors taking turns, a task run draining for about SNAP_DRAIN_SLICE,
+ *  - busy bus: the same with refused acquisitions and failed FIFO reads,
+ *  - send: the SNAP lines of one snapshot not mixed with another, their
+ *    bytes those of the words drained.
+ *
+ * The snapshot calls are wrapped at link time (--wrap) to see which sensor
+ * each word went to, and the uplink post to see the sensor of each event.
+ */
+
+/* As lsm6dsox_mlc.c */
+#define SNAP_PRE_WORDS    156U
+#define SNAP_BURST_WORDS  16U
+#define SNAP_DRAIN_SLICE  5U
+#define SNAP_LINE_BYTES   48U
+#define SNAP_ODR          26U
+
+#define SENSORS           2U
+#define I2C_BYTE_US       9U     /* 9 bits at 1 MHz */
+#define I2C_FRAME_US      10U    /* Start, stop and turnaround */
+#define BOOT_US           10000U
+#define UART_BYTES_PER_S  11520U /* 115200 baud */
+
+using BenchClock = std::chrono::steady_clock;
+
+extern "C" {
+GPIO_TypeDef HostGpioC;
+TIM_TypeDef HostTim1;
+extern void *MotionCompObj[CUSTOM_MOTION_INSTANCES_NBR];
+
+void __real_MLC_SNAP_Init(MLC_SNAP_t *Snap, MLC_SNAP_Word_t *Words, uint32_t Capacity);
+void __real_MLC_SNAP_Start(MLC_SNAP_t *Snap, uint8_t Code, uint16_t Odr);
+int32_t __real_MLC_SNAP_AddRaw(MLC_SNAP_t *Snap, const uint8_t *Raw);
+void __real_MLC_SNAP_MarkTrigger(MLC_SNAP_t *Snap);
+int32_t __real_UPLINK_PostMlc(uint8_t Sensor, uint8_t Code, uint32_t Time);
+}
+
+struct FifoWord
+{
+  uint8_t Tag;
+  uint32_t Seq;
+};
+
+/* A capture, from MLC_SNAP_Start to its END line */
+struct Capture
+{
+  uint32_t Sensor;
+  uint8_t Code;
+  std::vector<std::vector<uint8_t>> Raw;  /* Words given to MLC_SNAP_AddRaw */
+  int32_t Trigger;
+  uint32_t FirstPost;       /* Sequence of the first word after the trigger */
+  uint32_t DroppedAtLevel;  /* FIFO overwrites at the trigger level read */
+  uint32_t DroppedAtFreeze;
+  bool Frozen;
+  std::vector<uint32_t> FrozenSeqs;
+  uint32_t Delivered;       /* Words of successful FIFO reads */
+  bool ReadError;
+  bool Sent;
+};
+
+struct Device
+{
+  uint8_t Addr;
+  uint32_t Index;
+  uint8_t User[128];
+  uint8_t Emb[128];
+  bool ResetPending;
+  bool Latch;
+  uint8_t Code;
+  std::deque<FifoWord> Fifo;
+  uint32_t Seq;
+  uint64_t NextXl;
+  uint64_t NextGy;
+  uint32_t Dropped;
+  bool Frozen;
+  int32_t Cap;              /* Open capture, -1 none */
+  bool Expect;              /* Event while armed, a capture must start */
+  /* Last FIFO level read */
+  uint32_t LevelOldest;
+  uint32_t LevelCount;
+  uint32_t LevelDropped;
+  /* What the device saw */
+  uint32_t Accesses;
+  uint32_t WhoAmI;
+  uint32_t Resets;
+  uint32_t SourceReads;
+  uint32_t SourceReadsLow;  /* With the INT line low */
+  /* CTRL1_XL and CTRL2_G when the sensitivities were last refreshed */
+  uint8_t RefreshedXl;
+  uint8_t RefreshedGy;
+};
+
+struct Burst
+{
+  uint32_t Sensor;
+  uint32_t Words;
+  bool OtherWaiting;        /* The other sensor frozen with words left */
+};
+
+static uint64_t NowUs;
+static Device Dev[SENSORS];
+static std::vector<Capture> Captures;
+static std::map<const MLC_SNAP_t *, uint32_t> SnapSensor;
+static std::vector<uint8_t> Uplinked[SENSORS];  /* MLC codes posted to the uplink */
+static uint32_t UplinkBadSensor;
+static std::mt19937 Rng(63U);
+
+/* Bus */
+static uint32_t Depth;
+static uint64_t HoldStart;
+static uint32_t HoldFifoReads;
+static uint32_t HoldFifoWords;
+static bool Running;          /* Startup over, the task runs */
+static uint32_t BusyPercent;
+static uint32_t FailPermille;
+static uint32_t BusyRefused;
+static uint32_t ReadFailures;
+static uint32_t Refreshes;
+static uint32_t Unheld;       /* Task accesses outside an acquisition */
+static uint32_t UnknownAddr;
+static uint32_t Leaks;        /* Task runs ending with the bus held */
+static uint32_t MultiBurstHolds;
+static uint32_t LongBursts;
+static uint64_t MaxBurstHold;
+static uint64_t BurstBusUs;
+static std::vector<Burst> Bursts;
+static uint64_t RunFirstBurst;
+static uint64_t RunLastBurst;
+static bool RunDrained;
+
+/* Log */
+static std::string LogOut;
+static uint32_t LogUsed;
+static uint32_t LogPosition;
+static uint32_t LogBlocking;
+static uint64_t LogDrainedBytes;
+
+/**
+  * @brief  Sample period of a batch data rate code
+  * @param  Code BDR_XL or BDR_GY of FIFO_CTRL3
+  * @param  Gyro 1 for BDR_GY, its code 11 is 6.5 Hz
+  * @retval The period in us, 0 if not batched
+  */
+static uint64_t BdrPeriod(uint32_t Code, bool Gyro)
+{
+  static const double Odr[11] = { 0.0, 12.5, 26.0, 52.0, 104.0, 208.0, 417.0, 833.0, 1667.0, 3333.0, 6667.0 };
+
+  if (Code == 0U)
+  {
+    return 0;
+  }
+  if (Code == 11U)
+  {
+    return Gyro ? 153846U : 625000U;
+  }
+  return (Code < 11U) ? (uint64_t)std::lround(1e6 / Odr[Code]) : 0U;
+}
+
+/**
+  * @brief  Queue a word in the FIFO as the mode and watermark allow
+  * @param  d the device
+  * @param  Tag MLC_SNAP_TAG_ACC or MLC_SNAP_TAG_GYR
+  * @retval None
+  */
+static void Push(Device *d, uint8_t Tag)
+{
+  uint32_t mode = d->User[LSM6DSOX_FIFO_CTRL4] & 0x07U;
+  uint32_t wtm = d->User[LSM6DSOX_FIFO_CTRL1] | ((d->User[LSM6DSOX_FIFO_CTRL2] & 0x01U) << 8);
+  uint32_t depth = (((d->User[LSM6DSOX_FIFO_CTRL2] & 0x80U) != 0U) && (wtm != 0U)) ? wtm : 512U;
+
+  if (mode == 0U)
+  {
+    return;
+  }
+  if (d->Fifo.size() >= depth)
+  {
+    if (mode == 1U)
+    {
+      return;   /* FIFO mode stops */
+    }
+    d->Fifo.pop_front();
+    d->Dropped++;
+  }
+  d->Fifo.push_back({ Tag, d->Seq++ });
+}
+
+/**
+  * @brief  Batch the words due up to now
+  * @param  d the device
+  * @retval None
+  */
+static void Advance(Device *d)
+{
+  uint64_t xl = BdrPeriod(d->User[LSM6DSOX_FIFO_CTRL3] & 0x0FU, false);
+  uint64_t gy = BdrPeriod(d->User[LSM6DSOX_FIFO_CTRL3] >> 4, true);
+
+  for (;;)
+  {
+    bool doXl = (xl != 0U) && (d->NextXl <= NowUs);
+    bool doGy = (gy != 0U) && (d->NextGy <= NowUs);
+
+    if (doXl && (!doGy || (d->NextXl <= d->NextGy)))
+    {
+      Push(d, MLC_SNAP_TAG_ACC);
+      d->NextXl += xl;
+    }
+    else if (doGy)
+    {
+      Push(d, MLC_SNAP_TAG_GYR);
+      d->NextGy += gy;
+    }
+    else
+    {
+      break;
+    }
+  }
+}
+
+/**
+  * @brief  Power on reset of the registers
+  * @param  d the device
+  * @retval None
+  */
+static void ResetRegs(Device *d)
+{
+  std::memset(d->User, 0, sizeof(d->User));
+  std::memset(d->Emb, 0, sizeof(d->Emb));
+  d->User[LSM6DSOX_CTRL3_C] = 0x04U;   /* IF_INC */
+  d->Fifo.clear();
+  d->Latch = false;
+  d->Code = 0;
+  d->Frozen = false;
+}
+
+/**
+  * @brief  Read one register
+  * @param  d the device
+  * @param  Reg the register
+  * @param  Cur the FIFO word being read
+  * @retval The value
+  */
+static uint8_t ReadByte(Device *d, uint8_t Reg, FifoWord *Cur)
+{
+  uint32_t bank = d->User[LSM6DSOX_FUNC_CFG_ACCESS] >> 6;
+  uint8_t v;
+
+  if ((bank != 0U) && (Reg != LSM6DSOX_FUNC_CFG_ACCESS))
+  {
+    return (Reg == LSM6DSOX_MLC0_SRC) ? d->Code : d->Emb[Reg];
+  }
+
+  switch (Reg)
+  {
+    case LSM6DSOX_WHO_AM_I:
+      d->WhoAmI++;
+      return LSM6DSOX_ID;
+    case LSM6DSOX_CTRL3_C:
+      v = (uint8_t)((d->User[Reg] & 0xFEU) | (d->ResetPending ? 1U : 0U));
+      d->ResetPending = false;
+      return v;
+    case LSM6DSOX_ALL_INT_SRC:
+      d->SourceReads++;
+      d->SourceReadsLow += ((d->Index == 0U) && !d->Latch) ? 1U : 0U;
+      return 0;
+    case LSM6DSOX_MLC_STATUS_MAINPAGE:
+      /* Latched: reading the status clears the event and the line */
+      v = d->Latch ? 0x01U : 0x00U;
+      d->Latch = false;
+      return v;
+    case LSM6DSOX_FIFO_STATUS1:
+      d->LevelCount = (uint32_t)d->Fifo.size();
+      d->LevelOldest = d->Fifo.empty() ? d->Seq : d->Fifo.front().Seq;
+      d->LevelDropped = d->Dropped;
+      return (uint8_t)d->Fifo.size();
+    case LSM6DSOX_FIFO_STATUS2:
+      return (uint8_t)((d->Fifo.size() >> 8) & 0x03U);
+    case LSM6DSOX_FIFO_DATA_OUT_TAG:
+      if (d->Fifo.empty())
+      {
+        *Cur = { 0, 0 };
+        return 0;
+      }
+      *Cur = d->Fifo.front();
+      d->Fifo.pop_front();
+      return (uint8_t)(Cur->Tag << 3);
+    default:
+      break;
+  }
+
+  if ((Reg > LSM6DSOX_FIFO_DATA_OUT_TAG) && (Reg <= (LSM6DSOX_FIFO_DATA_OUT_TAG + 6U)))
+  {
+    /* X: 0x5A00 and the device, Y and Z: the sequence number */
+    uint32_t k = Reg - LSM6DSOX_FIFO_DATA_OUT_TAG - 1U;
+    uint16_t axis[3] = { (uint16_t)(0x5A00U | d->Index), (uint16_t)Cur->Seq, (uint16_t)(Cur->Seq >> 16) };
+
+    if (Cur->Tag == 0U)
+    {
+      return 0;
+    }
+    return (uint8_t)(axis[k / 2U] >> ((k % 2U) * 8U));
+  }
+
+  return d->User[Reg];
+}
+
+/**
+  * @brief  Write one register
+  * @param  d the device
+  * @param  Reg the register
+  * @param  Val the value
+  * @retval None
+  */
+static void WriteByte(Device *d, uint8_t Reg, uint8_t Val)
+{
+  uint32_t bank = d->User[LSM6DSOX_FUNC_CFG_ACCESS] >> 6;
+  uint8_t old = d->User[Reg];
+
+  if ((bank != 0U) && (Reg != LSM6DSOX_FUNC_CFG_ACCESS))
+  {
+    d->Emb[Reg] = Val;
+    return;
+  }
+  if ((Reg == LSM6DSOX_CTRL3_C) && ((Val & 0x01U) != 0U))
+  {
+    ResetRegs(d);
+    d->ResetPending = true;
+    d->Resets++;
+    return;
+  }
+
+  d->User[Reg] = Val;
+
+  if ((Reg == LSM6DSOX_FIFO_CTRL4) && ((Val & 0x07U) == 0U))
+  {
+    d->Fifo.clear();   /* Bypass flushes */
+    d->Frozen = false;
+  }
+  if (Reg == LSM6DSOX_FIFO_CTRL3)
+  {
+    if (((Val & 0x0FU) != 0U) && ((Val & 0x0FU) != (old & 0x0FU)))
+    {
+      d->NextXl = NowUs + BdrPeriod(Val & 0x0FU, false);
+    }
+    if (((Val >> 4) != 0U) && ((Val >> 4) != (old >> 4)))
+    {
+      d->NextGy = NowUs + BdrPeriod(Val >> 4, true);
+    }
+    if ((Val == 0U) && (old != 0U) && !d->Frozen)
+    {
+      /* Frozen: this is what the snapshot must hold */
+      d->Frozen = true;
+      if (d->Cap >= 0)
+      {
+        Capture &c = Captures[(size_t)d->Cap];
+        c.Frozen = true;
+        c.DroppedAtFreeze = d->Dropped;
+        for (const FifoWord &w : d->Fifo)
+        {
+          c.FrozenSeqs.push_back(w.Seq);
+        }
+      }
+    }
+    else if (Val != 0U)
+    {
+      d->Frozen = false;
+    }
+  }
+}
+
+/**
+  * @brief  Find the device at an I2C address
+  * @param  Addr the 8 bit address
+  * @retval The device, NULL if none answers
+  */
+static Device *Find(uint16_t Addr)
+{
+  for (uint32_t i = 0; i < SENSORS; i++)
+  {
+    if (Dev[i].Addr == Addr)
+    {
+      return &Dev[i];
+    }
+  }
+  return nullptr;
+}
+
+/**
+  * @brief  Tell if a sensor waits with a frozen FIFO
+  * @param  Sensor the sensor
+  * @retval true if frozen with words left
+  */
+static bool Waiting(uint32_t Sensor)
+{
+  return Dev[Sensor].Frozen && !Dev[Sensor].Fifo.empty();
+}
+
+/**
+  * @brief  One register transaction on the simulated bus
+  * @param  Addr the 8 bit address
+  * @param  Reg the first register
+  * @param  Data the data
+  * @param  Len the length
+  * @param  Read true for a read
+  * @retval BSP status
+  */
+static int32_t Transfer(uint16_t Addr, uint16_t Reg, uint8_t *Data, uint16_t Len, bool Read)
+{
+  Device *d = Find(Addr);
+  uint64_t start = NowUs;
+  bool fifo = Read && (Reg == LSM6DSOX_FIFO_DATA_OUT_TAG);
+  bool fail = false;
+  FifoWord cur = { 0, 0 };
+  uint32_t words = 0;
+  uint8_t r = (uint8_t)Reg;
+
+  NowUs += I2C_FRAME_US + (uint64_t)(Len + (Read ? 3U : 2U)) * I2C_BYTE_US;
+  if ((d == nullptr) || (start < BOOT_US))   /* Powered at 0 */
+  {
+    UnknownAddr += (d == nullptr) ? 1U : 0U;
+    return BSP_ERROR_BUS_ACKNOWLEDGE_FAILURE;
+  }
+  Advance(d);
+  d->Accesses++;
+  if (Running && (Depth == 0U))
+  {
+    Unheld++;
+  }
+
+  if (fifo && (FailPermille != 0U) && ((Rng() % 1000U) < FailPermille))
+  {
+    /* The transfer breaks after half of it, those words are lost */
+    fail = true;
+    Len = (uint16_t)(Len / 2U);
+  }
+
+  for (uint32_t i = 0; i < Len; i++)
+  {
+    if (Read)
+    {
+      Data[i] = ReadByte(d, r, &cur);
+      words += (fifo && (r == LSM6DSOX_FIFO_DATA_OUT_TAG)) ? 1U : 0U;
+    }
+    else
+    {
+      WriteByte(d, r, Data[i]);
+    }
+    /* FIFO_DATA_OUT_Z_H rolls back to the tag, the source registers
+     * round from ALL_INT_SRC to the embedded function ones */
+    if (r == (LSM6DSOX_FIFO_DATA_OUT_TAG + 6U))
+    {
+      r = LSM6DSOX_FIFO_DATA_OUT_TAG;
+    }
+    else if ((r == 0x1EU) && ((d->User[LSM6DSOX_CTRL5_C] & 0x10U) != 0U))
+    {
+      r = LSM6DSOX_EMB_FUNC_STATUS_MAINPAGE;
+    }
+    else
+    {
+      r = (uint8_t)((r + 1U) & 0x7FU);
+    }
+  }
+
+  if (fifo)
+  {
+    Burst b = { d->Index, words, Waiting(1U - d->Index) };
+
+    HoldFifoReads++;
+    HoldFifoWords += words;
+    Bursts.push_back(b);
+    BurstBusUs += NowUs - start;
+    if (!RunDrained)
+    {
+      RunFirstBurst = start;
+      RunDrained = true;
+    }
+    RunLastBurst = NowUs;
+    if (d->Cap >= 0)
+    {
+      Capture &c = Captures[(size_t)d->Cap];
+      c.Delivered += fail ? 0U : words;
+      c.ReadError |= fail;
+    }
+  }
+
+  if (fail)
+  {
+    ReadFailures++;
+    return BSP_ERROR_PERIPH_FAILURE;
+  }
+  return BSP_ERROR_NONE;
+}
+
+extern "C" {
+
+/**
+  * @brief  Simulated clock
+  * @retval The time in ms
+  */
+uint32_t HAL_GetTick(void)
+{
+  return (uint32_t)(NowUs / 1000U);
+}
+
+/**
+  * @brief  BSP clock of the component drivers
+  * @retval The time in ms
+  */
+int32_t BSP_GetTick(void)
+{
+  return (int32_t)HAL_GetTick();
+}
+
+/**
+  * @brief  INT1 of sensor 0 on PC0
+  * @param  GPIOx the port
+  * @param  GPIO_Pin the pin
+  * @retval The line
+  */
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  return ((GPIOx == GPIOC) && (GPIO_Pin == GPIO_PIN_0) && Dev[0].Latch) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void Error_Handler(void)
+{
+}
+
+int32_t BSP_I2C2_Init(void)
+{
+  return BSP_ERROR_NONE;
+}
+
+int32_t BSP_I2C2_DeInit(void)
+{
+  return BSP_ERROR_NONE;
+}
+
+int32_t BSP_I2C2_WriteReg(uint16_t Addr, uint16_t Reg, uint8_t *pData, uint16_t Length)
+{
+  return Transfer(Addr, Reg, pData, Length, false);
+}
+
+int32_t BSP_I2C2_ReadReg(uint16_t Addr, uint16_t Reg, uint8_t *pData, uint16_t Length)
+{
+  return Transfer(Addr, Reg, pData, Length, true);
+}
+
+/**
+  * @brief  Take the bus, refused now and then to the MLC client once running
+  * @param  Client the client
+  * @retval BSP status
+  */
+int32_t BSP_I2C2_Acquire(uint32_t Client)
+{
+  if (Depth == 0U)
+  {
+    if (Running && (Client == BUS_I2C2_CLIENT_MLC) && (BusyPercent != 0U) && ((Rng() % 100U) < BusyPercent))
+    {
+      BusyRefused++;
+      return BSP_ERROR_BUSY;
+    }
+    HoldStart = NowUs;
+    HoldFifoReads = 0;
+    HoldFifoWords = 0;
+  }
+  Depth++;
+  return BSP_ERROR_NONE;
+}
+
+/**
+  * @brief  Give the bus back, a hold with a FIFO read is a burst
+  * @retval None
+  */
+void BSP_I2C2_Release(void)
+{
+  if (--Depth != 0U)
+  {
+    return;
+  }
+  if (HoldFifoReads != 0U)
+  {
+    MultiBurstHolds += (HoldFifoReads > 1U) ? 1U : 0U;
+    LongBursts += (HoldFifoWords > SNAP_BURST_WORDS) ? 1U : 0U;
+    if ((NowUs - HoldStart) > MaxBurstHold)
+    {
+      MaxBurstHold = NowUs - HoldStart;
+    }
+  }
+}
+
+void LAT_TRACE_Stamp(uint32_t Pipe, uint32_t Point)
+{
+  (void)Pipe;
+  (void)Point;
+}
+
+void LAT_TRACE_Queue(uint32_t Pipe, uint32_t Mark)
+{
+  (void)Pipe;
+  (void)Mark;
+}
+
+void LAT_TRACE_Abort(uint32_t Pipe)
+{
+  (void)Pipe;
+}
+
+/**
+  * @brief  Sensitivity refresh of app_mems.c, notes the full scales it reads
+  * @retval None
+  */
+void MX_MEMS_RefreshSensitivity(void)
+{
+  Refreshes++;
+  for (uint32_t i = 0; i < SENSORS; i++)
+  {
+    Dev[i].RefreshedXl = Dev[i].User[LSM6DSOX_CTRL1_XL];
+    Dev[i].RefreshedGy = Dev[i].User[LSM6DSOX_CTRL2_G];
+  }
+}
+
+/**
+  * @brief  Log ring, emptied by the UART at 115200 baud
+  * @param  Data the line
+  * @param  Len the length
+  * @retval LOG_SINK_OK, LOG_SINK_ERROR if it does not fit
+  */
+int32_t LOG_SINK_Write(const uint8_t *Data, uint32_t Len)
+{
+  if ((LogUsed + Len) > LOG_SINK_BUFFER_SIZE)
+  {
+    return LOG_SINK_ERROR;
+  }
+  LogUsed += Len;
+  LogPosition += Len;
+  LogOut.append((const char *)Data, Len);
+  return LOG_SINK_OK;
+}
+
+void LOG_SINK_WriteBlocking(const uint8_t *Data, uint32_t Len)
+{
+  LogBlocking++;
+  LogOut.append((const char *)Data, Len);
+}
+
+uint32_t LOG_SINK_Position(void)
+{
+  return LogPosition;
+}
+
+void LOG_SINK_GetStats(LOG_RING_Stats_t *Stats)
+{
+  std::memset(Stats, 0, sizeof(*Stats));
+  Stats->Used = LogUsed;
+}
+
+/* Which sensor each word goes to */
+void __wrap_MLC_SNAP_Init(MLC_SNAP_t *Snap, MLC_SNAP_Word_t *Words, uint32_t Capacity)
+{
+  uint32_t n = (uint32_t)SnapSensor.size();
+
+  SnapSensor[Snap] = n;
+  __real_MLC_SNAP_Init(Snap, Words, Capacity);
+}
+
+void __wrap_MLC_SNAP_Start(MLC_SNAP_t *Snap, uint8_t Code, uint16_t Odr)
+{
+  Device *d = &Dev[SnapSensor.at(Snap)];
+  Capture c = {};
+
+  c.Sensor = d->Index;
+  c.Code = Code;
+  c.Trigger = -1;
+  /* The trigger level was the last read */
+  c.FirstPost = d->LevelOldest + ((d->LevelCount < SNAP_PRE_WORDS) ? d->LevelCount : SNAP_PRE_WORDS);
+  c.DroppedAtLevel = d->LevelDropped;
+  d->Expect = false;
+  d->Cap = (int32_t)Captures.size();
+  Captures.push_back(c);
+  __real_MLC_SNAP_Start(Snap, Code, Odr);
+}
+
+int32_t __wrap_MLC_SNAP_AddRaw(MLC_SNAP_t *Snap, const uint8_t *Raw)
+{
+  Device *d = &Dev[SnapSensor.at(Snap)];
+
+  if (d->Cap >= 0)
+  {
+    Captures[(size_t)d->Cap].Raw.emplace_back(Raw, Raw + MLC_SNAP_FIFO_WORD_SIZE);
+  }
+  return __real_MLC_SNAP_AddRaw(Snap, Raw);
+}
+
+void __wrap_MLC_SNAP_MarkTrigger(MLC_SNAP_t *Snap)
+{
+  Device *d = &Dev[SnapSensor.at(Snap)];
+
+  if (d->Cap >= 0)
+  {
+    Captures[(size_t)d->Cap].Trigger = (int32_t)Captures[(size_t)d->Cap].Raw.size();
+  }
+  __real_MLC_SNAP_MarkTrigger(Snap);
+}
+
+/* The sensor of each uplink MLC event */
+int32_t __wrap_UPLINK_PostMlc(uint8_t Sensor, uint8_t Code, uint32_t Time)
+{
+  if (Sensor < SENSORS)
+  {
+    Uplinked[Sensor].push_back(Code);
+  }
+  else
+  {
+    UplinkBadSensor++;
+  }
+  return __real_UPLINK_PostMlc(Sensor, Code, Time);
+}
+
+} /* extern "C" */
+
+/**
+  * @brief  Print a check
+  * @param  Name the check
+  * @param  Pass the result
+  * @param  Detail printed after the name
+  * @retval Pass
+  */
+static bool Report(const char *Name, bool Pass, const std::string &Detail = "")
+{
+  std::printf("%-12s %-58s %s\n", Name, Detail.c_str(), Pass ? "ok" : "FAILED");
+  return Pass;
+}
+
+/**
+  * @brief  Let the UART take bytes out of the log ring
+  * @retval None
+  */
+static void LogDrain()
+{
+  uint64_t total = (NowUs * UART_BYTES_PER_S) / 1000000U;
+  uint64_t n = total - LogDrainedBytes;
+
+  LogDrainedBytes = total;
+  LogUsed = (n >= LogUsed) ? 0U : (uint32_t)(LogUsed - n);
+}
+
+/* Outcome of a scenario */
+struct Run
+{
+  bool Startup;
+  uint32_t Events[SENSORS];
+  uint32_t Detected[SENSORS];
+  bool DetectOk;
+  uint32_t Lost;              /* Events while armed without a capture */
+  uint32_t Snapshots;
+  uint32_t Concurrent;        /* Drains overlapping the other sensor's */
+  uint32_t Truncated;
+  uint32_t Races;             /* Words overwritten between level and freeze */
+  bool WordsOk;
+  bool TriggerOk;
+  bool SendOk;
+  uint32_t Lines;
+  uint32_t Tasks;
+  uint64_t MaxRunDrain;
+};
+
+/**
+  * @brief  Bring up both devices and the service as main.c does
+  * @param  Probe true to probe the sensors through custom_motion_sensors.c
+  * @retval true if every step completed
+  */
+static bool Startup(bool Probe)
+{
+  bool ok = true;
+  uint32_t i;
+
+  Running = false;
+  Depth = 0;
+  Refreshes = 0;
+  for (i = 0; i < SENSORS; i++)
+  {
+    Device *d = &Dev[i];
+
+    *d = Device();
+    d->Index = i;
+    d->Addr = (i == 0U) ? LSM6DSOX_I2C_ADD_L : LSM6DSOX_I2C_ADD_H;
+    d->Cap = -1;
+    ResetRegs(d);
+  }
+  Captures.clear();
+  LogOut.clear();
+  LogUsed = 0;
+  LogPosition = 0;
+  LogBlocking = 0;
+  LogDrainedBytes = (NowUs * UART_BYTES_PER_S) / 1000000U;
+  TASK_SCHED_Init(HAL_GetTick, NULL);
+  UPLINK_Init(NULL, HAL_GetTick());
+  UplinkBadSensor = 0;
+  for (i = 0; i < SENSORS; i++)
+  {
+    Uplinked[i].clear();
+  }
+
+  ok &= (lsm6dsox_mlc_power_on() == STARTUP_DONE);
+  /* The boot step polls the IDs until the devices answer */
+  while (lsm6dsox_mlc_boot_poll(HAL_GetTick()) == STARTUP_PENDING)
+  {
+    NowUs += 1000U;
+  }
+  for (i = 0; i < SENSORS; i++)
+  {
+    if (Probe)
+    {
+      ok &= (CUSTOM_MOTION_SENSOR_Init(i, MOTION_ACCELERO | MOTION_GYRO) == BSP_ERROR_NONE);
+    }
+    else
+    {
+      MotionCompObj[i] = NULL;
+    }
+  }
+  ok &= (lsm6dsox_mlc_self_test_start() == STARTUP_DONE);
+  ok &= (lsm6dsox_mlc_reset_start() == STARTUP_PENDING);
+  while (lsm6dsox_mlc_reset_poll(0) == STARTUP_PENDING)
+  {
+    NowUs += 1000U;
+  }
+  ok &= (lsm6dsox_mlc_config() == STARTUP_DONE);
+  Running = true;
+
+  return ok;
+}
+
+/**
+  * @brief  Split the log in lines
+  * @retval The lines, without CR LF
+  */
+static std::vector<std::string> Lines()
+{
+  std::vector<std::string> out;
+  size_t pos = 0;
+  size_t end;
+
+  while ((end = LogOut.find("\r\n", pos)) != std::string::npos)
+  {
+    out.push_back(LogOut.substr(pos, end - pos));
+    pos = end + 2U;
+  }
+  return out;
+}
+
+/**
+  * @brief  The SNAP lines a capture must give, from its words
+  * @param  c the capture
+  * @param  Id the snapshot id
+  * @retval The lines
+  */
+static std::vector<std::string> Expected(const Capture &c, uint32_t Id)
+{
+  static MLC_SNAP_Word_t words[512];
+  static uint8_t enc[MLC_SNAP_ENCODED_MAX(512)];
+  static char b64[MLC_SNAP_BASE64_SIZE(SNAP_LINE_BYTES) + 1U];
+  std::vector<std::string> out;
+  MLC_SNAP_t snap;
+  uint32_t len = 0;
+  char head[32];
+
+  __real_MLC_SNAP_Init(&snap, words, 512U);
+  __real_MLC_SNAP_Start(&snap, c.Code, SNAP_ODR);
+  for (size_t i = 0; i < c.Raw.size(); i++)
+  {
+    (void)__real_MLC_SNAP_AddRaw(&snap, c.Raw[i].data());
+  }
+  snap.Trigger = (c.Trigger < 0) ? snap.Count : (uint32_t)c.Trigger;
+  if (MLC_SNAP_Encode(&snap, enc, sizeof(enc), &len) != MLC_SNAP_OK)
+  {
+    len = 0;
+  }
+
+  for (uint32_t off = 0; off < len; off += SNAP_LINE_BYTES)
+  {
+    uint32_t chunk = ((len - off) > SNAP_LINE_BYTES) ? SNAP_LINE_BYTES : (len - off);
+
+    b64[MLC_SNAP_Base64(&enc[off], chunk, b64)] = '\0';
+    std::snprintf(head, sizeof(head), "SNAP %u %u ", Id, off);
+    out.push_back(head + std::string(b64));
+  }
+  std::snprintf(head, sizeof(head), "SNAP %u END %u %u", Id, len, c.Sensor);
+  out.push_back(head);
+
+  return out;
+}
+
+/**
+  * @brief  Run a scenario of random MLC events on both sensors
+  * @param  Probe true to probe the sensors
+  * @param  Minutes the simulated time
+  * @param  Busy percent of MLC acquisitions refused
+  * @param  Fail per mille of FIFO reads failing
+  * @param  Base first snapshot id of the run
+  * @retval The outcome
+  */
+static Run Scenario(bool Probe, uint32_t Minutes, uint32_t Busy, uint32_t Fail, uint32_t Base)
+{
+  std::vector<uint8_t> injected[SENSORS];
+  uint64_t next[SENSORS];
+  uint64_t last = 0;
+  uint64_t end;
+  std::exponential_distribution<double> gap(1.0 / 4.0e6);
+  Run r = {};
+
+  BusyPercent = 0;
+  FailPermille = 0;
+  BusyRefused = 0;
+  ReadFailures = 0;
+  Unheld = 0;
+  UnknownAddr = 0;
+  Leaks = 0;
+  MultiBurstHolds = 0;
+  LongBursts = 0;
+  MaxBurstHold = 0;
+  BurstBusUs = 0;
+  Bursts.clear();
+
+  r.Startup = Startup(Probe);
+  next[0] = NowUs + 2000000U;
+  next[1] = NowUs + 2500000U;
+  end = NowUs + ((uint64_t)Minutes * 60000000U);
+  /* Same configuration on both, at their own address */
+  r.Startup &= (std::memcmp(Dev[0].User, Dev[1].User, sizeof(Dev[0].User)) == 0)
+               && (std::memcmp(Dev[0].Emb, Dev[1].Emb, sizeof(Dev[0].Emb)) == 0);
+  for (uint32_t i = 0; i < SENSORS; i++)
+  {
+    const uint8_t *u = Dev[i].User;
+
+    /* The IDs are read once, the second startup finds them */
+    /* The sensitivities are taken from the full scales the MLC set */
+    r.Startup &= (Refreshes == 1U) && (Dev[i].RefreshedXl == u[LSM6DSOX_CTRL1_XL])
+                 && (Dev[i].RefreshedGy == u[LSM6DSOX_CTRL2_G]);
+    r.Startup &= ((Dev[i].WhoAmI > 0U) || !Probe) && (Dev[i].Resets == 1U) && ((u[LSM6DSOX_FIFO_CTRL4] & 0x07U) == 6U)
+                 && (u[LSM6DSOX_FIFO_CTRL1] == SNAP_PRE_WORDS) && (u[LSM6DSOX_FIFO_CTRL2] == 0x80U)
+                 && (u[LSM6DSOX_FIFO_CTRL3] == 0x22U);
+  }
+  BusyPercent = Busy;
+  FailPermille = Fail;
+
+  while (NowUs < (end + 20000000U))
+  {
+    for (uint32_t i = 0; i < SENSORS; i++)
+    {
+      if ((NowUs < end) && (next[i] <= NowUs))
+      {
+        uint8_t code = (uint8_t)(((i + 1U) << 4) | (injected[i].size() & 0x0FU));
+        Device *d = &Dev[i];
+
+        /* An event while armed must start a capture before the next */
+        r.Lost += d->Expect ? 1U : 0U;
+        d->Expect = ((d->User[LSM6DSOX_FIFO_CTRL4] & 0x07U) == 6U) && (d->User[LSM6DSOX_FIFO_CTRL1] == SNAP_PRE_WORDS);
+        d->Code = code;
+        d->Latch = true;
+        injected[i].push_back(code);
+        next[i] = NowUs + 200000U + (uint64_t)gap(Rng);
+        /* Often both at once, the MLC of each at most every 200 ms */
+        if (i == 1U)
+        {
+          last = NowUs;
+        }
+        else if (((Rng() % 3U) == 0U) && ((NowUs - last) >= 200000U))
+        {
+          next[1] = NowUs;
+        }
+      }
+    }
+
+    RunDrained = false;
+    while (TASK_SCHED_RunOnce() != 0U)
+    {
+      r.Tasks++;
+    }
+    if (Depth != 0U)
+    {
+      Leaks++;
+      Depth = 0;
+    }
+    if (RunDrained && ((RunLastBurst - RunFirstBurst) > r.MaxRunDrain))
+    {
+      r.MaxRunDrain = RunLastBurst - RunFirstBurst;
+    }
+    NowUs = ((NowUs / 1000U) + 1U) * 1000U;
+    LogDrain();
+  }
+
+  for (uint32_t i = 0; i < SENSORS; i++)
+  {
+    r.Lost += Dev[i].Expect ? 1U : 0U;
+  }
+
+  /* Detect lines, per sensor in the order of the events */
+  std::vector<std::string> lines = Lines();
+  std::vector<uint8_t> detected[SENSORS];
+  std::map<uint32_t, std::vector<std::string>> snapLines;
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> sender;
+  uint32_t open = 0;
+  bool mixed = false;
+
+  for (const std::string &l : lines)
+  {
+    unsigned code = 0;
+    unsigned long sensor = 0;
+    unsigned id = 0;
+
+    if (std::sscanf(l.c_str(), "Detect MLC interrupt code: %X, sensor %lu", &code, &sensor) == 2)
+    {
+      if (sensor < SENSORS)
+      {
+        detected[sensor].push_back((uint8_t)code);
+      }
+      else
+      {
+        mixed = true;
+      }
+    }
+    else if (std::sscanf(l.c_str(), "SNAP %u", &id) == 1)
+    {
+      /* One snapshot at a time: its lines up to END before the next */
+      if (snapLines[id].empty())
+      {
+        mixed |= (open != 0U);
+        open = id;
+        order.push_back(id);
+      }
+      mixed |= (id != open);
+      snapLines[id].push_back(l);
+      if (std::sscanf(l.c_str(), "SNAP %u END %*u %lu", &id, &sensor) == 2)
+      {
+        sender.push_back((uint32_t)sensor);
+        open = 0;
+      }
+      r.Lines++;
+    }
+  }
+  r.DetectOk = !mixed;
+  for (uint32_t i = 0; i < SENSORS; i++)
+  {
+    r.Events[i] = (uint32_t)injected[i].size();
+    r.Detected[i] = (uint32_t)detected[i].size();
+    r.DetectOk &= (detected[i] == injected[i]) && (Uplinked[i] == injected[i]);
+  }
+  r.DetectOk &= (UplinkBadSensor == 0U);
+  r.DetectOk &= (Dev[0].SourceReadsLow == 0U) && (Dev[1].SourceReads + BusyRefused >= r.Tasks) && (UnknownAddr == 0U)
+                && (Unheld == 0U);
+
+  /* Every capture: its words, its trigger, then its lines */
+  r.WordsOk = (MultiBurstHolds == 0U) && (LongBursts == 0U) && (Leaks == 0U);
+  r.TriggerOk = true;
+  r.SendOk = (order.size() == Captures.size()) && (sender.size() == order.size()) && (LogBlocking == 0U);
+  for (size_t k = 0; k < Captures.size(); k++)
+  {
+    Capture &c = Captures[k];
+    std::vector<uint32_t> seqs;
+    uint32_t before = 0;
+
+    for (const std::vector<uint8_t> &w : c.Raw)
+    {
+      uint16_t x = (uint16_t)(w[1] | (w[2] << 8));
+      uint32_t seq = (uint32_t)(w[3] | (w[4] << 8) | (w[5] << 16) | ((uint32_t)w[6] << 24));
+
+      r.WordsOk &= (x == (0x5A00U | c.Sensor)) && (((w[0] >> 3) == MLC_SNAP_TAG_ACC) || ((w[0] >> 3) == MLC_SNAP_TAG_GYR));
+      seqs.push_back(seq);
+      before += (seq < c.FirstPost) ? 1U : 0U;
+    }
+    r.WordsOk &= c.Frozen && (seqs.size() == c.Delivered) && (seqs.size() <= c.FrozenSeqs.size())
+                 && std::equal(seqs.begin(), seqs.end(), c.FrozenSeqs.begin());
+    /* The whole FIFO unless a read failed */
+    r.WordsOk &= c.ReadError || (seqs.size() == c.FrozenSeqs.size());
+    r.Truncated += c.ReadError ? 1U : 0U;
+
+    /* A word overwritten between the level read and the freeze moves the
+     * window by one */
+    uint32_t race = c.DroppedAtFreeze - c.DroppedAtLevel;
+    r.Races += race;
+    r.TriggerOk &= (c.Trigger >= 0) && ((uint32_t)std::abs(c.Trigger - (int32_t)before) <= race);
+  }
+
+  /* The n-th END of a sensor is its n-th capture, ids count up */
+  for (size_t k = 0; r.SendOk && (k < order.size()); k++)
+  {
+    size_t n = 0;
+
+    while ((n < Captures.size()) && (Captures[n].Sent || (Captures[n].Sensor != sender[k])))
+    {
+      n++;
+    }
+    r.SendOk &= (n < Captures.size()) && (order[k] == (Base + k));
+    if (r.SendOk)
+    {
+      Captures[n].Sent = true;
+      r.SendOk &= (snapLines[order[k]] == Expected(Captures[n], order[k]));
+    }
+  }
+  r.Snapshots = (uint32_t)Captures.size();
+
+  /* Drains that overlapped: bursts of one sensor while the other waited */
+  for (size_t k = 1; k < Bursts.size(); k++)
+  {
+    r.Concurrent += (Bursts[k].OtherWaiting && !Bursts[k - 1].OtherWaiting) ? 1U : 0U;
+  }
+
+  return r;
+}
+
+/**
+  * @brief  Check the turns and holds of a clean run's bursts
+  * @param  r the run
+  * @retval true if passed
+  */
+static bool Interleave(const Run &r)
+{
+  uint32_t turns = 0;
+  bool ok = (MultiBurstHolds == 0U) && (LongBursts == 0U) && (Leaks == 0U) && !Bursts.empty();
+
+  /* While both have words, no sensor takes two bursts in a row */
+  for (size_t k = 1; k < Bursts.size(); k++)
+  {
+    if (Bursts[k].OtherWaiting && Bursts[k - 1].OtherWaiting)
+    {
+      ok &= (Bursts[k].Sensor != Bursts[k - 1].Sensor);
+      turns++;
+    }
+  }
+
+  /* A burst is 16 words of 7 bytes, a task run drains for the slice plus
+   * the round in progress, the tick being in ms */
+  uint64_t burstUs = I2C_FRAME_US + (uint64_t)((SNAP_BURST_WORDS * MLC_SNAP_FIFO_WORD_SIZE) + 3U) * I2C_BYTE_US;
+  uint64_t fifoUs = I2C_FRAME_US + (uint64_t)((256U * MLC_SNAP_FIFO_WORD_SIZE) + 3U) * I2C_BYTE_US;
+
+  ok &= (MaxBurstHold <= burstUs) && (r.MaxRunDrain <= (((SNAP_DRAIN_SLICE + 1U) * 1000U) + (2U * burstUs)));
+  ok &= (turns > 0U);
+
+  char detail[96];
+  std::snprintf(detail, sizeof(detail), "%zu bursts, %u turns, hold %llu us, whole FIFO %llu us", Bursts.size(),
+                turns, (unsigned long long)MaxBurstHold, (unsigned long long)fifoUs);
+  bool pass = Report("interleave", ok, detail);
+  std::printf("  a task run drains for at most %.1f ms\n", (double)r.MaxRunDrain / 1000.0);
+  return pass;
+}
+
+int main()
+{
+  bool ok = true;
+  char detail[96];
+
+  /* Clean bus, sensors probed through custom_motion_sensors.c */
+  Run clean = Scenario(true, 30U, 0U, 0U, 1U);
+
+  std::snprintf(detail, sizeof(detail), "0xD5 on PC0, 0xD7 polled, %u + %u events", clean.Events[0], clean.Events[1]);
+  ok &= Report("routing", clean.Startup && clean.DetectOk && (clean.Lost == 0U), detail);
+  std::snprintf(detail, sizeof(detail), "%u snapshots, %u overlapping, %u words overwritten", clean.Snapshots,
+                clean.Concurrent, clean.Races);
+  ok &= Report("drain", clean.WordsOk && clean.TriggerOk && (clean.Truncated == 0U) && (clean.Concurrent > 0U), detail);
+  ok &= Interleave(clean);
+  std::snprintf(detail, sizeof(detail), "%u SNAP lines, one snapshot at a time", clean.Lines);
+  ok &= Report("send", clean.SendOk, detail);
+
+  /* Busy bus, sensors at their fixed addresses */
+  Run busy = Scenario(false, 30U, 20U, 10U, clean.Snapshots + 1U);
+
+  std::snprintf(detail, sizeof(detail), "%u refused, %u reads failed, %u snapshots, %u lost", BusyRefused,
+                ReadFailures, busy.Snapshots, busy.Lost);
+  ok &= Report("busy bus", busy.Startup && busy.DetectOk && busy.WordsOk && busy.TriggerOk && busy.SendOk
+               && (busy.Lost == 0U) && (MultiBurstHolds == 0U) && (busy.Truncated > 0U), detail);
+
+  /* Host cost of a task run with no event: PC0 and one polled source read */
+  BusyPercent = 0;
+  FailPermille = 0;
+  double best = 1e9;
+  for (int run = 0; run < 5; run++)
+  {
+    BenchClock::time_point t0 = BenchClock::now();
+    for (uint32_t i = 0; i < 100000U; i++)
+    {
+      NowUs += 10000U;
+      (void)TASK_SCHED_RunOnce();
+    }
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    best = std::fmin(best, ns / 100000.0);
+  }
+  std::printf("idle task run, device model included  %.0f ns\n", best);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
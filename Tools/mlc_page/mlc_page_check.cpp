@@ -0,0 +1,340 @@
+/**
+  ******************************************************************************
+  * @file    mlc_page_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the MLC page switch hold against preempting sensor reads
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <cstdint>
+#include <cstdio>
+#include <random>
+
+#include "bus_arbiter.h"
+
+/*
+ * Runs the firmware bus_arbiter.c under the register sequences of the
+ * DataLogFusion I2C2 bus (Core/Src/stm32wlxx_nucleo_bus.c) and of the MLC
+ * manager (MEMS/Target/mlc_manager.c), on a simulated LSM6DSOX.
+ *
+ * The sensor has two register pages, FUNC_CFG_ACCESS selects one. A read
+ * returns the page it was served from in bit 7, so a reader knows when it
+ * hit the wrong page.
+ *
+ *   BSP_I2C2_ReadReg    acquires the bus as the sensor client for one
+ *                       transfer, BSP_ERROR_BUSY if a preempted context
+ *                       owns it
+ *   MLC_Read_Emb        acquires the bus as the MLC client, switches to the
+ *                       embedded functions page, reads, switches back and
+ *                       releases
+ *
+ * Every transfer, and the gaps between them, may be preempted by an
+ * interrupt reading the accelerometer on the main page, directly or
+ * through a submitted request. The same
+ * traffic runs once with the MLC sequence holding the bus and once without,
+ * which is how the manager read the page before the hold.
+ */
+
+#define CLIENT_SENSOR        0U
+#define CLIENT_MLC           1U
+#define REG_FUNC_CFG_ACCESS  0x01U
+#define REG_OUTX_L_A         0x28U
+#define REG_MLC_STATUS       0x38U  /* Embedded page, 0x38 is STATUS_MASTER on main */
+#define PAGE_EMB             0x80U
+#define BSP_OK               0
+#define BSP_BUSY            -1
+
+struct Sensor
+{
+  uint8_t Page;
+};
+
+static Sensor Lsm;
+static BUS_ARB_t Arb;
+static uint32_t Context;       /* 0 thread mode, 1 interrupt */
+static uint32_t Masked;
+static uint32_t Now;
+static std::mt19937 Rng;
+static uint32_t PreemptOneIn;  /* An interrupt every n transfers */
+
+struct Counts
+{
+  uint64_t MlcReads;
+  uint64_t MlcWrongPage;
+  uint64_t IrqReads;
+  uint64_t IrqWrongPage;
+  uint64_t IrqBusy;
+  uint64_t Queued;
+  uint64_t QueuedWrongPage;
+};
+
+static Counts Cnt;
+
+static uint32_t PortClock(void)
+{
+  return Now++;
+}
+
+static uint32_t PortContext(void)
+{
+  return Context;
+}
+
+static uint32_t PortLock(void)
+{
+  return Masked++;
+}
+
+static void PortUnlock(uint32_t State)
+{
+  Masked = State;
+}
+
+static const BUS_ARB_Port_t Port = { PortClock, PortContext, PortLock, PortUnlock };
+
+static void Interrupt(void);
+
+/**
+  * @brief  A point where thread mode may be preempted
+  * @retval None
+  */
+static void Preempt(void)
+{
+  if ((Context == 0U) && ((Rng() % PreemptOneIn) == 0U))
+  {
+    Interrupt();
+  }
+}
+
+/**
+  * @brief  One I2C transfer on the simulated sensor
+  * @param  Write 1 to write, 0 to read
+  * @param  Reg the register
+  * @param  Data the value written or read
+  * @retval None
+  */
+static void Transfer(uint8_t Write, uint8_t Reg, uint8_t *Data)
+{
+  if (Write != 0U)
+  {
+    if (Reg == REG_FUNC_CFG_ACCESS)
+    {
+      Lsm.Page = *Data & PAGE_EMB;
+    }
+  }
+  else
+  {
+    *Data = (uint8_t)(Lsm.Page | (Reg & 0x7FU));
+  }
+  Now += 10U;
+
+  /* The transfer may be preempted between two bytes */
+  Preempt();
+}
+
+/**
+  * @brief  BSP_I2C2_WriteReg
+  * @param  Reg the register
+  * @param  Value the value
+  * @retval BSP_OK, BSP_BUSY
+  */
+static int32_t WriteReg(uint8_t Reg, uint8_t Value)
+{
+  if (BUS_ARB_Acquire(&Arb, CLIENT_SENSOR) != BUS_ARB_OK)
+  {
+    return BSP_BUSY;
+  }
+  Transfer(1U, Reg, &Value);
+  BUS_ARB_Release(&Arb);
+  return BSP_OK;
+}
+
+/**
+  * @brief  BSP_I2C2_ReadReg
+  * @param  Reg the register
+  * @param  Value the value
+  * @retval BSP_OK, BSP_BUSY
+  */
+static int32_t ReadReg(uint8_t Reg, uint8_t *Value)
+{
+  if (BUS_ARB_Acquire(&Arb, CLIENT_SENSOR) != BUS_ARB_OK)
+  {
+    return BSP_BUSY;
+  }
+  Transfer(0U, Reg, Value);
+  BUS_ARB_Release(&Arb);
+  return BSP_OK;
+}
+
+/**
+  * @brief  MLC_Read_Emb
+  * @param  Hold 1 to hold the bus over the sequence
+  * @param  Value the value
+  * @retval BSP_OK, BSP_BUSY
+  */
+static int32_t ReadEmb(uint8_t Hold, uint8_t *Value)
+{
+  int32_t ret;
+
+  if ((Hold != 0U) && (BUS_ARB_Acquire(&Arb, CLIENT_MLC) != BUS_ARB_OK))
+  {
+    return BSP_BUSY;
+  }
+
+  ret = WriteReg(REG_FUNC_CFG_ACCESS, PAGE_EMB);
+  Preempt();
+  if (ret == BSP_OK)
+  {
+    ret = ReadReg(REG_MLC_STATUS, Value);
+  }
+  Preempt();
+  if (WriteReg(REG_FUNC_CFG_ACCESS, 0U) != BSP_OK)
+  {
+    ret = BSP_BUSY;
+  }
+
+  if (Hold != 0U)
+  {
+    BUS_ARB_Release(&Arb);
+  }
+  return ret;
+}
+
+/**
+  * @brief  Sequence of a submitted accelerometer read
+  * @param  Ctx unused
+  * @retval The read status
+  */
+static int32_t QueuedRead(void *Ctx)
+{
+  uint8_t value = 0;
+  int32_t ret;
+
+  (void)Ctx;
+
+  /* Runs in the owner context, before the owner frees the bus */
+  ret = ReadReg(REG_OUTX_L_A, &value);
+  Cnt.Queued++;
+  if ((ret == BSP_OK) && ((value & PAGE_EMB) != 0U))
+  {
+    Cnt.QueuedWrongPage++;
+  }
+  return ret;
+}
+
+static BUS_ARB_Request_t Req = { QueuedRead, nullptr, nullptr, CLIENT_SENSOR, 0U, 0U, 0U, nullptr };
+
+/**
+  * @brief  Data-ready interrupt: reads the accelerometer on the main page
+  * @retval None
+  */
+static void Interrupt(void)
+{
+  uint8_t value = 0;
+
+  Context = 1;
+  if ((Rng() % 4U) == 0U)
+  {
+    /* Submitted, runs now or on the owner release */
+    (void)BUS_ARB_Submit(&Arb, &Req);
+  }
+  else if (ReadReg(REG_OUTX_L_A, &value) == BSP_OK)
+  {
+    Cnt.IrqReads++;
+    if ((value & PAGE_EMB) != 0U)
+    {
+      Cnt.IrqWrongPage++;
+    }
+  }
+  else
+  {
+    Cnt.IrqBusy++;
+  }
+  Context = 0;
+}
+
+/**
+  * @brief  Run MLC reads preempted by sensor reads
+  * @param  Hold 1 to hold the bus over the page switch
+  * @param  Reads the number of MLC reads
+  * @retval The counts
+  */
+static Counts Execute(uint8_t Hold, uint32_t Reads)
+{
+  uint8_t value = 0;
+
+  Cnt = Counts();
+  Lsm.Page = 0;
+  Rng.seed(7U);
+  PreemptOneIn = 3U;
+  BUS_ARB_Init(&Arb, &Port);
+
+  for (uint32_t i = 0; i < Reads; i++)
+  {
+    Preempt();
+    if (ReadEmb(Hold, &value) == BSP_OK)
+    {
+      Cnt.MlcReads++;
+      if ((value & PAGE_EMB) == 0U)
+      {
+        Cnt.MlcWrongPage++;
+      }
+    }
+  }
+
+  /* A request still pending would run on the next release */
+  return Cnt;
+}
+
+/**
+  * @brief  Print a run
+  * @param  Name the run
+  * @param  C the counts
+  * @retval None
+  */
+static void Print(const char *Name, const Counts &C)
+{
+  std::printf("%-10s mlc %7llu reads %5llu wrong page | irq %7llu reads %6llu wrong page %6llu busy"
+              " | queued %6llu %5llu wrong page\n",
+              Name, (unsigned long long)C.MlcReads, (unsigned long long)C.MlcWrongPage,
+              (unsigned long long)C.IrqReads, (unsigned long long)C.IrqWrongPage, (unsigned long long)C.IrqBusy,
+              (unsigned long long)C.Queued, (unsigned long long)C.QueuedWrongPage);
+}
+
+int main()
+{
+  const uint32_t reads = 1000000U;
+  bool ok = true;
+
+  Counts held = Execute(1U, reads);
+  Print("hold", held);
+  bool hold_ok = (held.MlcReads == reads) && (held.MlcWrongPage == 0U) && (held.IrqWrongPage == 0U)
+                 && (held.QueuedWrongPage == 0U) && (held.IrqReads != 0U) && (held.IrqBusy != 0U)
+                 && (held.Queued != 0U)
+                 && (Lsm.Page == 0U) && (Arb.Busy == 0U) && (Req.Pending == 0U) && (Masked == 0U);
+  std::printf("page switch held          %s\n", hold_ok ? "ok" : "FAILED");
+  ok &= hold_ok;
+
+  /* Without the hold the interrupts read the embedded page */
+  Counts loose = Execute(0U, reads);
+  Print("no hold", loose);
+  bool control = (loose.IrqWrongPage != 0U) || (loose.QueuedWrongPage != 0U);
+  std::printf("control: wrong page seen  %s\n", control ? "ok" : "FAILED");
+  ok &= control;
+
+  /* The longest hold is one MLC sequence and the requests run at its end */
+  BUS_ARB_Stats_t stats;
+  (void)Execute(1U, reads);
+  (void)BUS_ARB_GetStats(&Arb, CLIENT_MLC, &stats);
+  std::printf("mlc hold: max %lu ticks, a transfer takes 10\n", (unsigned long)stats.MaxHold);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
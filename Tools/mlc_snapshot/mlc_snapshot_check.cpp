@@ -0,0 +1,520 @@
+/**
+  ******************************************************************************
+  * @file    mlc_snapshot_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the snapshot encoder: varint, CRC and base64 vectors
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mlc_snapshot.h"
+
+/*
+ * Runs the firmware mlc_snapshot.c on a host:
+ *
+ *  - CRC-16/CCITT-FALSE: the catalogue check value of "123456789" and the
+ *    empty input,
+ *  - base64: the RFC 4648 vectors, and random blocks through a decoder,
+ *  - varint: zigzag deltas from 0 to the +-65535 extremes, taken from the
+ *    bytes MLC_SNAP_Encode writes for a two sample stream,
+ *  - encoding: a snapshot against bytes worked out by hand from the format
+ *    in mlc_snapshot.h, then random snapshots through a decoder written
+ *    from that format, within MLC_SNAP_ENCODED_MAX and refusing a buffer
+ *    one byte short,
+ *  - capture: FIFO tags, the trigger, the capacity and the peak.
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+struct Sample
+{
+  uint8_t Tag;
+  int16_t Data[3];
+};
+
+struct Decoded
+{
+  uint8_t Code;
+  uint16_t Odr;
+  uint16_t Pre[MLC_SNAP_STREAMS];
+  std::vector<Sample> Streams[MLC_SNAP_STREAMS];
+};
+
+/**
+  * @brief  Print a check
+  * @param  Name the check
+  * @param  Pass the result
+  * @param  Detail printed after the name
+  * @retval Pass
+  */
+static bool Report(const char *Name, bool Pass, const std::string &Detail = "")
+{
+  std::printf("%-22s %-46s %s\n", Name, Detail.c_str(), Pass ? "ok" : "FAILED");
+  return Pass;
+}
+
+/**
+  * @brief  Build a raw FIFO word
+  * @param  Tag the sensor tag
+  * @param  X the x axis
+  * @param  Y the y axis
+  * @param  Z the z axis
+  * @retval The MLC_SNAP_FIFO_WORD_SIZE bytes, tag count bits set
+  */
+static std::vector<uint8_t> Raw(uint8_t Tag, int16_t X, int16_t Y, int16_t Z)
+{
+  std::vector<uint8_t> raw(MLC_SNAP_FIFO_WORD_SIZE);
+  int16_t v[3] = { X, Y, Z };
+
+  /* TAG_CNT and parity in the low bits are ignored */
+  raw[0] = (uint8_t)((Tag << 3) | 0x05U);
+  for (uint32_t i = 0; i < 3U; i++)
+  {
+    raw[1U + (2U * i)] = (uint8_t)((uint16_t)v[i] & 0xFFU);
+    raw[2U + (2U * i)] = (uint8_t)((uint16_t)v[i] >> 8);
+  }
+  return raw;
+}
+
+/**
+  * @brief  Decode base64 text
+  * @param  Text the text
+  * @param  Out the data
+  * @retval true if the text is valid
+  */
+static bool FromBase64(const std::string &Text, std::vector<uint8_t> &Out)
+{
+  static const std::string table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+  Out.clear();
+  if ((Text.size() % 4U) != 0U)
+  {
+    return false;
+  }
+  for (size_t i = 0; i < Text.size(); i += 4U)
+  {
+    uint32_t v = 0;
+    uint32_t pad = 0;
+    for (size_t j = 0; j < 4U; j++)
+    {
+      char c = Text[i + j];
+      size_t k = table.find(c);
+      if ((c == '=') && ((i + 4U) == Text.size()) && (j >= 2U))
+      {
+        pad++;
+        k = 0;
+      }
+      else if ((k == std::string::npos) || (pad != 0U))
+      {
+        return false;
+      }
+      v = (v << 6) | (uint32_t)k;
+    }
+    Out.push_back((uint8_t)(v >> 16));
+    if (pad < 2U)
+    {
+      Out.push_back((uint8_t)(v >> 8));
+    }
+    if (pad < 1U)
+    {
+      Out.push_back((uint8_t)v);
+    }
+  }
+  return true;
+}
+
+/**
+  * @brief  Decode an encoded snapshot, from the format of mlc_snapshot.h
+  * @param  In the encoded snapshot
+  * @param  D the content
+  * @retval true if well formed with a valid CRC
+  */
+static bool Decode(const std::vector<uint8_t> &In, Decoded &D)
+{
+  size_t p = 0;
+  auto u8 = [&](uint8_t &V) { if (p >= In.size()) return false; V = In[p++]; return true; };
+  auto u16 = [&](uint16_t &V)
+  {
+    uint8_t lo, hi;
+    if (!u8(lo) || !u8(hi)) return false;
+    V = (uint16_t)(lo | (hi << 8));
+    return true;
+  };
+  auto varint = [&](int32_t &V)
+  {
+    uint32_t zz = 0;
+    uint8_t b;
+    for (uint32_t shift = 0; shift < 35U; shift += 7U)
+    {
+      if (!u8(b)) return false;
+      zz |= (uint32_t)(b & 0x7FU) << shift;
+      if ((b & 0x80U) == 0U)
+      {
+        V = (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1U);
+        return true;
+      }
+    }
+    return false;
+  };
+
+  uint8_t s, n, version, streams, reserved;
+  uint16_t crc;
+  if ((In.size() < 2U) || (MLC_SNAP_Crc16(In.data(), (uint32_t)In.size() - 2U)
+                           != (uint16_t)(In[In.size() - 2U] | (In[In.size() - 1U] << 8))))
+  {
+    return false;
+  }
+  if (!u8(s) || !u8(n) || !u8(version) || !u8(D.Code) || !u16(D.Odr) || !u8(streams) || !u8(reserved)
+      || (s != 'S') || (n != 'N') || (version != MLC_SNAP_VERSION) || (streams != MLC_SNAP_STREAMS))
+  {
+    return false;
+  }
+  for (uint32_t st = 0; st < MLC_SNAP_STREAMS; st++)
+  {
+    uint8_t tag;
+    uint16_t count;
+    if (!u8(tag) || !u16(D.Pre[st]) || !u16(count))
+    {
+      return false;
+    }
+    D.Streams[st].clear();
+    for (uint32_t i = 0; i < count; i++)
+    {
+      Sample smp = { tag, { 0, 0, 0 } };
+      for (uint32_t a = 0; a < 3U; a++)
+      {
+        uint16_t first;
+        int32_t delta;
+        if (i == 0U)
+        {
+          if (!u16(first)) return false;
+          smp.Data[a] = (int16_t)first;
+        }
+        else
+        {
+          if (!varint(delta)) return false;
+          smp.Data[a] = (int16_t)(D.Streams[st].back().Data[a] + delta);
+        }
+      }
+      D.Streams[st].push_back(smp);
+    }
+  }
+  return u16(crc) && (p == In.size());
+}
+
+/**
+  * @brief  Check the CRC vectors
+  * @retval true if passed
+  */
+static bool Crc()
+{
+  const char *check = "123456789";
+  uint8_t one = 0x00U;
+  bool ok = (MLC_SNAP_Crc16((const uint8_t *)check, 9U) == 0x29B1U) && (MLC_SNAP_Crc16(nullptr, 0U) == 0xFFFFU)
+            && (MLC_SNAP_Crc16(&one, 1U) == 0xE1F0U);
+
+  return Report("crc-16/ccitt-false", ok, "\"123456789\" 0x29B1, empty 0xFFFF");
+}
+
+/**
+  * @brief  Check the base64 vectors and random blocks
+  * @retval true if passed
+  */
+static bool Base64()
+{
+  const char *vectors[][2] =
+  {
+    { "", "" }, { "f", "Zg==" }, { "fo", "Zm8=" }, { "foo", "Zm9v" },
+    { "foob", "Zm9vYg==" }, { "fooba", "Zm9vYmE=" }, { "foobar", "Zm9vYmFy" },
+  };
+  char text[MLC_SNAP_BASE64_SIZE(64U) + 1U];
+  bool ok = true;
+
+  for (const auto &v : vectors)
+  {
+    uint32_t len = (uint32_t)std::strlen(v[0]);
+    std::memset(text, '#', sizeof(text));
+    uint32_t n = MLC_SNAP_Base64((const uint8_t *)v[0], len, text);
+    ok &= (n == MLC_SNAP_BASE64_SIZE(len)) && (std::string(text, n) == v[1]) && (text[n] == '#');
+  }
+
+  /* Every length and byte value through the decoder */
+  std::mt19937 rng(58);
+  uint32_t blocks = 0;
+  for (uint32_t len = 0; len <= 64U; len++)
+  {
+    for (uint32_t r = 0; r < 200U; r++, blocks++)
+    {
+      std::vector<uint8_t> in(len), out;
+      for (uint8_t &b : in)
+      {
+        b = (uint8_t)rng();
+      }
+      uint32_t n = MLC_SNAP_Base64(in.data(), len, text);
+      ok &= (n == MLC_SNAP_BASE64_SIZE(len)) && FromBase64(std::string(text, n), out) && (out == in);
+    }
+  }
+
+  return Report("base64", ok, "RFC 4648 vectors, " + std::to_string(blocks) + " random blocks");
+}
+
+/**
+  * @brief  Check the zigzag varint of the deltas
+  * @retval true if passed
+  */
+static bool Varint()
+{
+  const struct
+  {
+    int32_t Delta;
+    std::vector<uint8_t> Bytes;
+  } vectors[] =
+  {
+    { 0, { 0x00 } }, { -1, { 0x01 } }, { 1, { 0x02 } }, { -2, { 0x03 } }, { 63, { 0x7E } }, { -64, { 0x7F } },
+    { 64, { 0x80, 0x01 } }, { -65, { 0x81, 0x01 } }, { 8191, { 0xFE, 0x7F } }, { -8192, { 0xFF, 0x7F } },
+    { 8192, { 0x80, 0x80, 0x01 } }, { 65535, { 0xFE, 0xFF, 0x07 } }, { -65535, { 0xFD, 0xFF, 0x07 } },
+  };
+  MLC_SNAP_Word_t words[2];
+  MLC_SNAP_t snap;
+  uint8_t out[64];
+  uint32_t len;
+  bool ok = true;
+
+  for (const auto &v : vectors)
+  {
+    /* Two accelerometer samples, the delta on x */
+    int16_t base = (v.Delta >= 0) ? -32768 : 32767;
+    MLC_SNAP_Init(&snap, words, 2U);
+    (void)MLC_SNAP_AddRaw(&snap, Raw(MLC_SNAP_TAG_ACC, base, 7, -7).data());
+    (void)MLC_SNAP_AddRaw(&snap, Raw(MLC_SNAP_TAG_ACC, (int16_t)(base + v.Delta), 7, -7).data());
+
+    /* Header 8, stream header 5, first sample 6: the deltas start at 19 */
+    std::vector<uint8_t> expect = v.Bytes;
+    expect.push_back(0x00);
+    expect.push_back(0x00);
+    ok &= (MLC_SNAP_Encode(&snap, out, sizeof(out), &len) == MLC_SNAP_OK)
+          && (len == (19U + expect.size() + 5U + 2U))
+          && (std::vector<uint8_t>(&out[19], &out[19U + expect.size()]) == expect);
+  }
+
+  return Report("zigzag varint", ok, std::to_string(sizeof(vectors) / sizeof(vectors[0])) + " deltas, 0 to +-65535");
+}
+
+/**
+  * @brief  Check a snapshot against its bytes worked out by hand
+  * @retval true if passed
+  */
+static bool Golden()
+{
+  const std::vector<uint8_t> expect =
+  {
+    0x53, 0x4E, 0x01, 0x05, 0x68, 0x00, 0x02, 0x00,              /* 'S' 'N' v1 code 5, 104 Hz, 2 streams */
+    0x02, 0x01, 0x00, 0x03, 0x00,                                /* acc, 1 pre, 3 samples */
+    0x64, 0x00, 0x38, 0xFF, 0xE8, 0x03,                          /* 100 -200 1000 */
+    0x02, 0x7F, 0x80, 0x01,                                      /* +1 -64 +64 */
+    0xB4, 0xFE, 0x03, 0xEF, 0xFB, 0x03, 0x00,                    /* +32666 -32504 0 */
+    0x01, 0x01, 0x00, 0x02, 0x00,                                /* gyro, 1 pre, 2 samples */
+    0x01, 0x00, 0x02, 0x00, 0x03, 0x00,                          /* 1 2 3 */
+    0x0B, 0x00, 0xD2, 0x04,                                      /* -6 0 +297 */
+    0x9C, 0x43,                                                  /* CRC */
+  };
+  MLC_SNAP_Word_t words[8];
+  MLC_SNAP_t snap;
+  uint8_t out[MLC_SNAP_ENCODED_MAX(8U)];
+  uint32_t len = 0;
+
+  MLC_SNAP_Init(&snap, words, 8U);
+  MLC_SNAP_Start(&snap, 5U, 104U);
+  (void)MLC_SNAP_AddRaw(&snap, Raw(MLC_SNAP_TAG_ACC, 100, -200, 1000).data());
+  (void)MLC_SNAP_AddRaw(&snap, Raw(MLC_SNAP_TAG_GYR, 1, 2, 3).data());
+  MLC_SNAP_MarkTrigger(&snap);
+  (void)MLC_SNAP_AddRaw(&snap, Raw(MLC_SNAP_TAG_ACC, 101, -264, 1064).data());
+  (void)MLC_SNAP_AddRaw(&snap, Raw(MLC_SNAP_TAG_ACC, 32767, -32768, 1064).data());
+  (void)MLC_SNAP_AddRaw(&snap, Raw(MLC_SNAP_TAG_GYR, -5, 2, 300).data());
+
+  bool ok = (MLC_SNAP_Encode(&snap, out, sizeof(out), &len) == MLC_SNAP_OK)
+            && (std::vector<uint8_t>(out, out + len) == expect);
+
+  char text[MLC_SNAP_BASE64_SIZE(sizeof(out))];
+  std::vector<uint8_t> back;
+  uint32_t n = MLC_SNAP_Base64(out, len, text);
+  ok &= FromBase64(std::string(text, n), back) && (back == expect);
+
+  return Report("encoded snapshot", ok, std::to_string(len) + " bytes, as worked out by hand");
+}
+
+/**
+  * @brief  Encode random snapshots and decode them back
+  * @param  Bytes set to the mean encoded bytes per sample of slow motion
+  * @retval true if passed
+  */
+static bool RoundTrip(double *Bytes)
+{
+  const uint32_t capacity = 256U;
+  std::vector<MLC_SNAP_Word_t> words(capacity);
+  std::vector<uint8_t> out(MLC_SNAP_ENCODED_MAX(capacity));
+  std::mt19937 rng(5858);
+  uint32_t runs = 0;
+  uint64_t slowBytes = 0;
+  uint64_t slowSamples = 0;
+  bool ok = true;
+
+  for (runs = 0; ok && (runs < 20000U); runs++)
+  {
+    /* Kind 0 slow motion, 1 full range noise, 2 one sensor, 3 empty */
+    uint32_t kind = runs % 4U;
+    uint32_t count = (kind == 3U) ? 0U : (1U + (rng() % capacity));
+    uint32_t trigger = (count == 0U) ? 0U : (rng() % (count + 1U));
+    std::vector<Sample> in[MLC_SNAP_STREAMS];
+    uint16_t pre[MLC_SNAP_STREAMS] = { 0, 0 };
+    int32_t level[MLC_SNAP_STREAMS][3] = { { 0, 0, 1000 }, { 0, 0, 0 } };
+    MLC_SNAP_t snap;
+
+    MLC_SNAP_Init(&snap, words.data(), capacity);
+    MLC_SNAP_Start(&snap, (uint8_t)rng(), (uint16_t)rng());
+    for (uint32_t i = 0; i < count; i++)
+    {
+      uint32_t st = (kind == 2U) ? 0U : (rng() % 2U);
+      Sample smp = { (st == 0U) ? (uint8_t)MLC_SNAP_TAG_ACC : (uint8_t)MLC_SNAP_TAG_GYR, { 0, 0, 0 } };
+      for (uint32_t a = 0; a < 3U; a++)
+      {
+        if (kind == 1U)
+        {
+          smp.Data[a] = (int16_t)rng();
+        }
+        else
+        {
+          level[st][a] = std::max(-32768, std::min(32767, level[st][a] + (int32_t)(rng() % 41U) - 20));
+          smp.Data[a] = (int16_t)level[st][a];
+        }
+      }
+      if (i == trigger)
+      {
+        MLC_SNAP_MarkTrigger(&snap);
+      }
+      pre[st] += (i < trigger) ? 1U : 0U;
+      /* A timestamp word between the samples is skipped */
+      (void)MLC_SNAP_AddRaw(&snap, Raw(0x04U, 1, 2, 3).data());
+      ok &= (MLC_SNAP_AddRaw(&snap, Raw(smp.Tag, smp.Data[0], smp.Data[1], smp.Data[2]).data()) == MLC_SNAP_OK);
+      in[st].push_back(smp);
+    }
+    if (trigger == count)
+    {
+      MLC_SNAP_MarkTrigger(&snap);
+    }
+
+    uint32_t len = 0;
+    uint32_t shortLen = 0;
+    Decoded d;
+    ok &= (MLC_SNAP_Encode(&snap, out.data(), (uint32_t)out.size(), &len) == MLC_SNAP_OK)
+          && (len <= MLC_SNAP_ENCODED_MAX(count))
+          && (MLC_SNAP_Encode(&snap, out.data(), len - 1U, &shortLen) == MLC_SNAP_ERROR)
+          && (MLC_SNAP_Encode(&snap, out.data(), len, &shortLen) == MLC_SNAP_OK) && (shortLen == len);
+    ok &= Decode(std::vector<uint8_t>(out.begin(), out.begin() + len), d) && (d.Code == snap.Code)
+          && (d.Odr == snap.Odr);
+    for (uint32_t st = 0; ok && (st < MLC_SNAP_STREAMS); st++)
+    {
+      ok = (d.Pre[st] == pre[st]) && (d.Streams[st].size() == in[st].size())
+           && ((in[st].empty()) || (std::memcmp(d.Streams[st].data(), in[st].data(),
+                                                in[st].size() * sizeof(Sample)) == 0));
+    }
+    if (kind == 0U)
+    {
+      slowBytes += len;
+      slowSamples += count;
+    }
+  }
+
+  *Bytes = (double)slowBytes / (double)slowSamples;
+  return Report("round trip", ok, std::to_string(runs) + " random snapshots, up to 256 words");
+}
+
+/**
+  * @brief  Check the capture: tags, capacity, trigger and peak
+  * @retval true if passed
+  */
+static bool Capture()
+{
+  MLC_SNAP_Word_t words[3];
+  MLC_SNAP_t snap;
+  uint32_t count = 99U;
+  bool ok = true;
+
+  MLC_SNAP_Init(&snap, words, 3U);
+  MLC_SNAP_Start(&snap, 9U, 26U);
+  ok &= (MLC_SNAP_AddRaw(&snap, Raw(0x13U, 1, 1, 1).data()) == MLC_SNAP_OK) && (snap.Count == 0U);
+  ok &= (MLC_SNAP_AddRaw(&snap, Raw(MLC_SNAP_TAG_ACC, -32768, 5, 0).data()) == MLC_SNAP_OK)
+        && (MLC_SNAP_AddRaw(&snap, Raw(MLC_SNAP_TAG_GYR, 100, -300, 200).data()) == MLC_SNAP_OK);
+  MLC_SNAP_MarkTrigger(&snap);
+  ok &= (MLC_SNAP_AddRaw(&snap, Raw(MLC_SNAP_TAG_ACC, 3, 4, 5).data()) == MLC_SNAP_OK)
+        && (MLC_SNAP_AddRaw(&snap, Raw(MLC_SNAP_TAG_ACC, 6, 7, 8).data()) == MLC_SNAP_ERROR)
+        && (snap.Count == 3U) && (snap.Dropped == 1U) && (snap.Trigger == 2U);
+  ok &= (MLC_SNAP_Peak(&snap, MLC_SNAP_TAG_ACC, &count) == 32768U) && (count == 2U)
+        && (MLC_SNAP_Peak(&snap, MLC_SNAP_TAG_GYR, nullptr) == 300U);
+
+  MLC_SNAP_Start(&snap, 0U, 0U);
+  ok &= (snap.Count == 0U) && (snap.Dropped == 0U) && (snap.Trigger == 0U)
+        && (MLC_SNAP_Peak(&snap, MLC_SNAP_TAG_ACC, &count) == 0U) && (count == 0U);
+
+  return Report("capture", ok, "tags, capacity, trigger, peak");
+}
+
+int main()
+{
+  double bytes = 0.0;
+  bool ok = true;
+
+  ok &= Crc();
+  ok &= Base64();
+  ok &= Varint();
+  ok &= Golden();
+  ok &= RoundTrip(&bytes);
+  ok &= Capture();
+  std::printf("slow motion  %.2f bytes per sample encoded, 6 raw\n", bytes);
+
+  /* Cost of the encoding of a full snapshot of 256 words */
+  std::vector<MLC_SNAP_Word_t> words(256U);
+  std::vector<uint8_t> out(MLC_SNAP_ENCODED_MAX(256U));
+  std::vector<char> text(MLC_SNAP_BASE64_SIZE(out.size()));
+  MLC_SNAP_t snap;
+  std::mt19937 rng(1);
+  MLC_SNAP_Init(&snap, words.data(), 256U);
+  for (uint32_t i = 0; i < 256U; i++)
+  {
+    int16_t v = (int16_t)((int32_t)(i * 3U) + (int32_t)(rng() % 21U) - 10);
+    (void)MLC_SNAP_AddRaw(&snap, Raw((i % 2U) ? MLC_SNAP_TAG_GYR : MLC_SNAP_TAG_ACC, v, (int16_t)-v, 1000).data());
+  }
+  double best = 1e9;
+  uint32_t len = 0;
+  for (int run = 0; run < 5; run++)
+  {
+    BenchClock::time_point t0 = BenchClock::now();
+    for (uint32_t r = 0; r < 2000U; r++)
+    {
+      (void)MLC_SNAP_Encode(&snap, out.data(), (uint32_t)out.size(), &len);
+      (void)MLC_SNAP_Base64(out.data(), len, text.data());
+    }
+    double us = std::chrono::duration<double, std::micro>(BenchClock::now() - t0).count();
+    best = std::fmin(best, us / 2000.0);
+  }
+  std::printf("encode + base64  %.2f us per 256 word snapshot (%u bytes)\n", best, len);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
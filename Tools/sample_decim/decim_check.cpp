@@ -0,0 +1,403 @@
+/**
+  ******************************************************************************
+  * @file    decim_check.cpp
+  * @author  ISCA Lab
+  * @brief   Frequency response and cost of the sensor decimation filter
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "sample_decim.h"
+
+/*
+ * Runs the firmware sample_decim.c on a host:
+ *  - response: a full-scale sine at each input frequency goes through
+ *    SAMPLE_DECIM_Push and the output amplitude is measured with a
+ *    single-bin DFT at the frequency it lands on after decimation (its alias
+ *    above the output Nyquist frequency), so the stopband figures are what
+ *    really folds into the output band,
+ *  - noise: white noise through the filter, against keeping one sample in
+ *    Factor,
+ *  - exactness: a constant input comes out unchanged from the first output,
+ *    a step settles, a block in place matches the sample by sample run,
+ *  - cost: time per input sample, host only.
+ * "decim_check --taps" prints the Q15 tables of sample_decim.c from the
+ * Kaiser window design below.
+ */
+
+static const double kPi = 3.14159265358979323846;
+static const double kCutoff = 0.45;  /* Of the output rate */
+static const double kBeta = 5.0;     /* Kaiser window */
+static const double kPass = 0.25;    /* Passband edge, of the output rate */
+static const double kStop = 0.75;    /* Aliases into the passband from here */
+static const int32_t kAmp = 2000 * MEMS_FIXED_ONE;  /* 2 g in Q23.8 mg */
+
+using BenchClock = std::chrono::steady_clock;
+
+/**
+  * @brief  Modified Bessel function of order 0
+  * @param  X the argument
+  * @retval I0(X)
+  */
+static double BesselI0(double X)
+{
+  double sum = 1.0;
+  double term = 1.0;
+
+  for (int k = 1; k < 40; k++)
+  {
+    term *= (X / (2.0 * k)) * (X / (2.0 * k));
+    sum += term;
+  }
+  return sum;
+}
+
+/**
+  * @brief  Design the Q15 taps of a factor, unity gain at DC
+  * @param  Factor the decimation factor
+  * @retval The taps
+  */
+static std::vector<int32_t> Design(uint32_t Factor)
+{
+  size_t n = SAMPLE_DECIM_SPAN * Factor;
+  std::vector<double> h(n);
+  std::vector<int32_t> q(n);
+  double fc = kCutoff / (double)Factor;  /* Of the input rate */
+  double sum = 0.0;
+  int32_t qsum = 0;
+
+  for (size_t i = 0; i < n; i++)
+  {
+    double m = (double)i - (double)(n - 1) / 2.0;
+    double r = 2.0 * (double)i / (double)(n - 1) - 1.0;
+    double sinc = (m == 0.0) ? 2.0 * fc : std::sin(2.0 * kPi * fc * m) / (kPi * m);
+
+    h[i] = sinc * BesselI0(kBeta * std::sqrt(1.0 - r * r)) / BesselI0(kBeta);
+    sum += h[i];
+  }
+
+  for (size_t i = 0; i < n; i++)
+  {
+    q[i] = (int32_t)std::lround(h[i] / sum * 32768.0);
+    qsum += q[i];
+  }
+
+  /* The taps are symmetric, the rounding error is even: split it on the two
+   * middle taps */
+  q[n / 2U - 1U] += (32768 - qsum) / 2;
+  q[n / 2U] += (32768 - qsum) / 2;
+  return q;
+}
+
+/**
+  * @brief  Print the tables of sample_decim.c
+  * @retval None
+  */
+static void PrintTaps()
+{
+  for (uint32_t factor = 2U; factor <= SAMPLE_DECIM_MAX_FACTOR; factor *= 2U)
+  {
+    std::vector<int32_t> q = Design(factor);
+
+    std::printf("static const int16_t Taps%u[SAMPLE_DECIM_SPAN * %uU] =\n{", factor, factor);
+    for (size_t i = 0; i < q.size(); i++)
+    {
+      std::printf("%s%6d%s", (i % 8U == 0U) ? "\n  " : " ", q[i], (i + 1U < q.size()) ? "," : "");
+    }
+    std::printf("\n};\n\n");
+  }
+}
+
+/**
+  * @brief  Output amplitude of a sine through the filter, relative to the input
+  * @param  Factor the decimation factor
+  * @param  Freq the input frequency, of the input rate
+  * @retval Gain [dB]
+  */
+static double Gain(uint32_t Factor, double Freq)
+{
+  SAMPLE_DECIM_t dec;
+  MEMS_FIXED_Axes_t in;
+  MEMS_FIXED_Axes_t out;
+  const uint32_t skip = 2U * SAMPLE_DECIM_SPAN;
+  const uint32_t outputs = 4096U;
+  double alias = std::fmod(Freq * Factor, 1.0);  /* Of the output rate */
+  double re = 0.0;
+  double im = 0.0;
+  uint32_t m = 0;
+
+  (void)SAMPLE_DECIM_Init(&dec, Factor);
+
+  for (uint64_t n = 0; m < (skip + outputs); n++)
+  {
+    in.x = (int32_t)std::lround(kAmp * std::cos(2.0 * kPi * Freq * (double)n));
+    in.y = in.x;
+    in.z = -in.x;
+    if ((SAMPLE_DECIM_Push(&dec, &in, &out) != 0U) && (m++ >= skip))
+    {
+      re += out.x * std::cos(2.0 * kPi * alias * m);
+      im += out.x * std::sin(2.0 * kPi * alias * m);
+    }
+  }
+
+  /* A bin at 0 or at the output Nyquist frequency holds the whole cosine */
+  double scale = ((alias == 0.0) || (alias == 0.5)) ? 1.0 : 2.0;
+  double amp = scale * std::hypot(re, im) / outputs;
+  return 20.0 * std::log10(amp / kAmp + 1e-12);
+}
+
+/**
+  * @brief  Response of a factor over the input band
+  * @param  Factor the decimation factor
+  * @retval true if it meets the passband and stopband limits
+  */
+static bool CheckResponse(uint32_t Factor)
+{
+  const uint32_t points = 400U;
+  double ripple = 0.0;
+  double stop = -300.0;
+  double half = -300.0;
+
+  for (uint32_t i = 0; i <= points; i++)
+  {
+    double f = 0.5 * i / points;         /* Of the input rate */
+    double fo = f * Factor;              /* Of the output rate */
+    double g = Gain(Factor, f);
+
+    if (fo <= kPass)
+    {
+      ripple = std::fmax(ripple, std::fabs(g));
+    }
+    else if (fo >= kStop)
+    {
+      stop = std::fmax(stop, g);
+    }
+    if (std::fabs(fo - 0.5) < 1e-9)
+    {
+      half = g;
+    }
+  }
+
+  bool ok = (ripple < 0.1) && (stop < -55.0);
+  std::printf("factor %u  %2u taps  passband ripple %.3f dB  at output Nyquist %6.1f dB"
+              "  aliased stopband %6.1f dB  %s\n",
+              Factor, SAMPLE_DECIM_SPAN * Factor, ripple, half, stop, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+/**
+  * @brief  White noise through the filter against plain subsampling
+  * @param  Factor the decimation factor
+  * @retval true if the noise goes down by about Factor
+  */
+static bool CheckNoise(uint32_t Factor)
+{
+  SAMPLE_DECIM_t dec;
+  MEMS_FIXED_Axes_t in;
+  MEMS_FIXED_Axes_t out;
+  std::mt19937 rng(11);
+  std::normal_distribution<double> noise(0.0, 20.0 * MEMS_FIXED_ONE);  /* 20 mg rms */
+  double filt = 0.0;
+  double sub = 0.0;
+  uint32_t count = 0;
+
+  (void)SAMPLE_DECIM_Init(&dec, Factor);
+
+  for (uint32_t n = 0; n < (200000U * Factor); n++)
+  {
+    in.x = 1000 * MEMS_FIXED_ONE + (int32_t)std::lround(noise(rng));
+    in.y = in.x;
+    in.z = in.x;
+    if (SAMPLE_DECIM_Push(&dec, &in, &out) != 0U)
+    {
+      double e = (double)(out.x - 1000 * MEMS_FIXED_ONE);
+      double s = (double)(in.x - 1000 * MEMS_FIXED_ONE);
+      filt += e * e;
+      sub += s * s;
+      count++;
+    }
+  }
+
+  filt = std::sqrt(filt / count) / MEMS_FIXED_ONE;
+  sub = std::sqrt(sub / count) / MEMS_FIXED_ONE;
+
+  /* White noise power goes through as the sum of the squared taps */
+  std::vector<int32_t> q = Design(Factor);
+  double power = 0.0;
+  for (int32_t t : q)
+  {
+    power += ((double)t / 32768.0) * ((double)t / 32768.0);
+  }
+  double expected = sub * std::sqrt(power);
+  bool ok = std::fabs(filt / expected - 1.0) < 0.1;
+  std::printf("factor %u  noise 20 mg rms: kept one in %u %5.2f mg, filtered %5.2f mg  %s\n",
+              Factor, Factor, sub, filt, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+/**
+  * @brief  Constant input, step, block in place
+  * @param  Factor the decimation factor
+  * @retval true if all hold
+  */
+static bool CheckExact(uint32_t Factor)
+{
+  SAMPLE_DECIM_t dec;
+  SAMPLE_DECIM_t ref;
+  MEMS_FIXED_Axes_t in = { 123457, -1000 * MEMS_FIXED_ONE, 4000 * MEMS_FIXED_ONE - 1 };
+  MEMS_FIXED_Axes_t out;
+  std::vector<MEMS_FIXED_Axes_t> block(64U * Factor + 5U);
+  std::vector<MEMS_FIXED_Axes_t> single;
+  std::mt19937 rng(3);
+  uint32_t outputs = 0;
+  bool ok = true;
+
+  /* Constant: every output, the first included, is the input */
+  (void)SAMPLE_DECIM_Init(&dec, Factor);
+  for (uint32_t n = 0; n < 10U * Factor; n++)
+  {
+    if (SAMPLE_DECIM_Push(&dec, &in, &out) != 0U)
+    {
+      outputs++;
+      ok &= (out.x == in.x) && (out.y == in.y) && (out.z == in.z);
+    }
+  }
+  ok &= (outputs == 10U);
+
+  /* Step: settles to the new value within the span */
+  in.x = 0;
+  for (uint32_t n = 0; n < (SAMPLE_DECIM_SPAN + 1U) * Factor; n++)
+  {
+    (void)SAMPLE_DECIM_Push(&dec, &in, &out);
+  }
+  ok &= (out.x == 0);
+
+  /* Block in place against one sample at a time */
+  for (MEMS_FIXED_Axes_t &s : block)
+  {
+    s.x = (int32_t)(rng() % 2000000U) - 1000000;
+    s.y = (int32_t)(rng() % 2000000U) - 1000000;
+    s.z = (int32_t)(rng() % 2000000U) - 1000000;
+  }
+  (void)SAMPLE_DECIM_Init(&ref, Factor);
+  for (const MEMS_FIXED_Axes_t &s : block)
+  {
+    if (SAMPLE_DECIM_Push(&ref, &s, &out) != 0U)
+    {
+      single.push_back(out);
+    }
+  }
+  SAMPLE_DECIM_Reset(&dec);
+  outputs = SAMPLE_DECIM_Block(&dec, block.data(), (uint32_t)block.size(), block.data());
+  ok &= (outputs == single.size())
+        && (std::memcmp(block.data(), single.data(), outputs * sizeof(MEMS_FIXED_Axes_t)) == 0);
+
+  std::printf("factor %u  constant, step and block in place  %s\n", Factor, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+/**
+  * @brief  Time per input sample, one axes triplet
+  * @param  Factor the decimation factor
+  * @retval None
+  */
+static void Bench(uint32_t Factor)
+{
+  SAMPLE_DECIM_t dec;
+  std::vector<MEMS_FIXED_Axes_t> block(SAMPLE_DECIM_SPAN * 32U);
+  const uint32_t rounds = 20000U;
+  volatile int32_t sink = 0;
+  double best = 1e9;
+
+  for (size_t i = 0; i < block.size(); i++)
+  {
+    block[i].x = (int32_t)(i * 977U) & 0xFFFFF;
+    block[i].y = -block[i].x;
+    block[i].z = block[i].x >> 1;
+  }
+
+  (void)SAMPLE_DECIM_Init(&dec, Factor);
+  for (int run = 0; run < 5; run++)
+  {
+    std::vector<MEMS_FIXED_Axes_t> work(block);
+    BenchClock::time_point t0 = BenchClock::now();
+    for (uint32_t r = 0; r < rounds; r++)
+    {
+      work = block;
+      sink = sink + (int32_t)SAMPLE_DECIM_Block(&dec, work.data(), (uint32_t)work.size(), work.data());
+    }
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    best = std::fmin(best, ns / ((double)rounds * (double)block.size()));
+  }
+
+  std::printf("factor %u  %.1f ns per input sample (3 axes)\n", Factor, best);
+}
+
+int main(int argc, char **argv)
+{
+  SAMPLE_DECIM_t dec;
+  bool ok = true;
+
+  if ((argc > 1) && (std::strcmp(argv[1], "--taps") == 0))
+  {
+    PrintTaps();
+    return 0;
+  }
+
+  /* The firmware tables are the design */
+  for (uint32_t factor = 2U; factor <= SAMPLE_DECIM_MAX_FACTOR; factor *= 2U)
+  {
+    std::vector<int32_t> q = Design(factor);
+
+    (void)SAMPLE_DECIM_Init(&dec, factor);
+    for (size_t i = 0; i < q.size(); i++)
+    {
+      ok &= (dec.Taps[i] == q[i]);
+    }
+  }
+  if (!ok)
+  {
+    std::printf("firmware taps differ from the design  FAILED\n");
+  }
+
+  if ((SAMPLE_DECIM_Init(&dec, 0U) != SAMPLE_DECIM_ERROR) || (SAMPLE_DECIM_Init(&dec, 3U) != SAMPLE_DECIM_ERROR)
+      || (SAMPLE_DECIM_Init(&dec, 2U * SAMPLE_DECIM_MAX_FACTOR) != SAMPLE_DECIM_ERROR))
+  {
+    std::printf("bad factor accepted  FAILED\n");
+    ok = false;
+  }
+
+  for (uint32_t factor = 2U; factor <= SAMPLE_DECIM_MAX_FACTOR; factor *= 2U)
+  {
+    ok &= CheckResponse(factor);
+  }
+  for (uint32_t factor = 2U; factor <= SAMPLE_DECIM_MAX_FACTOR; factor *= 2U)
+  {
+    ok &= CheckNoise(factor);
+  }
+  for (uint32_t factor = 1U; factor <= SAMPLE_DECIM_MAX_FACTOR; factor *= 2U)
+  {
+    ok &= CheckExact(factor);
+  }
+  for (uint32_t factor = 1U; factor <= SAMPLE_DECIM_MAX_FACTOR; factor *= 2U)
+  {
+    Bench(factor);
+  }
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,538 @@
+/**
+  ******************************************************************************
+  * @file    pipe_bench.cpp
+  * @author  ISCA Lab
+  * @brief   Compare the stage list of a stream sample with the handler chain
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "sample_pipe.h"
+
+/*
+ * Models one sample of the DataLogFusion Stream_Task both ways:
+ *  - the handler chain it had: seven sensor handlers, the fusion handler and
+ *    the MLC handler, each testing SensorsEnabled, UseOfflineData and the
+ *    fusion format,
+ *  - the stage list of MEMS/Target/sample_pipe.c, built once per
+ *    configuration as Stream_Build does.
+ * The sensor reads and the fusion are stubs that cost a few cycles, so the
+ * numbers are the dispatch and serialization cost around them. Both paths
+ * must write the same frame.
+ */
+
+#define PRESSURE_SENSOR       0x00000001U
+#define TEMPERATURE_SENSOR    0x00000002U
+#define HUMIDITY_SENSOR       0x00000004U
+#define ACCELEROMETER_SENSOR  0x00000010U
+#define GYROSCOPE_SENSOR      0x00000020U
+#define MAGNETIC_SENSOR       0x00000040U
+#define MLC_SENSOR            0x00000080U
+#define FUSION_SENSORS        (ACCELEROMETER_SENSOR | GYROSCOPE_SENSOR | MAGNETIC_SENSOR)
+
+#define FX_OFFSET      55U
+#define LENGTH         119U
+#define LENGTH_COMPACT 90U
+#define OFFLINE_SIZE   8
+#define RUNS           5U
+
+#define NOINLINE __attribute__((noinline))
+
+using BenchClock = std::chrono::steady_clock;
+
+struct Axes
+{
+  int32_t x;
+  int32_t y;
+  int32_t z;
+};
+
+struct Offline
+{
+  uint8_t Time[4];
+  float Env[3];
+  int32_t Acc[3];
+  int32_t Gyr[3];
+  int32_t Mag[3];
+};
+
+/* Application state, as app_mems.c */
+static volatile uint32_t SensorsEnabled;
+static uint8_t UseOfflineData;
+static uint8_t Compact;
+static Offline OfflineData[OFFLINE_SIZE];
+static int OfflineReadIndex;
+static Axes AccValue;
+static Axes GyrValue;
+static Axes MagValue;
+static Axes MagOffset = { 3, -2, 1 };
+static float PressValue;
+static float TempValue;
+static float HumValue;
+static volatile int32_t Bus;     /* Sensor register model */
+static uint8_t Frame[256];
+static SAMPLE_PIPE_t Pipe;
+static uint32_t PipeLen;
+
+/**
+  * @brief  Little-endian int32, as Serialize_s32
+  * @param  Dest the bytes
+  * @param  Value the value
+  * @retval None
+  */
+static void Put32(uint8_t *Dest, int32_t Value)
+{
+  uint32_t v = static_cast<uint32_t>(Value);
+
+  Dest[0] = static_cast<uint8_t>(v);
+  Dest[1] = static_cast<uint8_t>(v >> 8);
+  Dest[2] = static_cast<uint8_t>(v >> 16);
+  Dest[3] = static_cast<uint8_t>(v >> 24);
+}
+
+/**
+  * @brief  Sensor read stubs
+  * @retval None
+  */
+NOINLINE static void ReadAxes(Axes *A)
+{
+  A->x = Bus;
+  A->y = Bus + 1;
+  A->z = Bus + 2;
+}
+
+NOINLINE static void ReadValue(float *V)
+{
+  *V = static_cast<float>(Bus);
+}
+
+NOINLINE static void ReadTime(uint8_t *Time)
+{
+  Time[0] = static_cast<uint8_t>(Bus);
+  Time[1] = 1U;
+  Time[2] = 2U;
+  Time[3] = 3U;
+}
+
+NOINLINE static uint8_t ReadMlc(void)
+{
+  return static_cast<uint8_t>(Bus);
+}
+
+/**
+  * @brief  Fusion stub, float or compact layout
+  * @param  Out the fusion part of the frame
+  * @param  Bytes the outputs size
+  * @retval None
+  */
+NOINLINE static void Fusion(uint8_t *Out, uint32_t Bytes)
+{
+  int32_t v = AccValue.x + GyrValue.y + MagValue.z;
+
+  for (uint32_t i = 0U; i < Bytes; i += 4U)
+  {
+    Put32(&Out[i], v++);
+  }
+}
+
+/**
+  * @brief  Three axes to the frame
+  * @param  A the axes
+  * @param  Out the 12 bytes
+  * @retval None
+  */
+static void PutAxes(const Axes &A, uint8_t *Out)
+{
+  Put32(&Out[0], A.x);
+  Put32(&Out[4], A.y);
+  Put32(&Out[8], A.z);
+}
+
+/* Handler chain ------------------------------------------------------------*/
+static void RTC_Handler(uint8_t *Msg)
+{
+  if (UseOfflineData == 1U)
+  {
+    std::memcpy(&Msg[3], OfflineData[OfflineReadIndex].Time, 4U);
+  }
+  else
+  {
+    ReadTime(&Msg[3]);
+  }
+}
+
+static void Axes_Handler(uint8_t *Msg, uint32_t Sensor, Axes *Value, const int32_t *Rec, uint32_t Offset)
+{
+  if ((SensorsEnabled & Sensor) == Sensor)
+  {
+    if (UseOfflineData == 1U)
+    {
+      Value->x = Rec[0];
+      Value->y = Rec[1];
+      Value->z = Rec[2];
+    }
+    else
+    {
+      ReadAxes(Value);
+      if (Sensor == MAGNETIC_SENSOR)
+      {
+        Value->x -= MagOffset.x;
+        Value->y -= MagOffset.y;
+        Value->z -= MagOffset.z;
+      }
+    }
+    PutAxes(*Value, &Msg[Offset]);
+  }
+}
+
+static void Env_Handler(uint8_t *Msg, uint32_t Sensor, float *Value, float Rec, uint32_t Offset)
+{
+  if ((SensorsEnabled & Sensor) == Sensor)
+  {
+    if (UseOfflineData == 1U)
+    {
+      *Value = Rec;
+    }
+    else
+    {
+      ReadValue(Value);
+    }
+    std::memcpy(&Msg[Offset], Value, sizeof(float));
+  }
+}
+
+static void FX_Handler(uint8_t *Msg)
+{
+  if ((SensorsEnabled & ACCELEROMETER_SENSOR) == ACCELEROMETER_SENSOR)
+  {
+    if ((SensorsEnabled & GYROSCOPE_SENSOR) == GYROSCOPE_SENSOR)
+    {
+      if ((SensorsEnabled & MAGNETIC_SENSOR) == MAGNETIC_SENSOR)
+      {
+        if (Compact == 0U)
+        {
+          Fusion(&Msg[FX_OFFSET], LENGTH - FX_OFFSET);
+        }
+        else
+        {
+          Fusion(&Msg[FX_OFFSET], LENGTH_COMPACT - FX_OFFSET);
+        }
+        return;
+      }
+    }
+  }
+
+  if (Compact != 0U)
+  {
+    std::memset(&Msg[FX_OFFSET], 0, LENGTH_COMPACT - FX_OFFSET);
+  }
+}
+
+static void MLC_Handler(uint8_t *Msg)
+{
+  uint32_t offset = (Compact == 0U) ? LENGTH : LENGTH_COMPACT;
+
+  if ((SensorsEnabled & MLC_SENSOR) == MLC_SENSOR)
+  {
+    Msg[offset] = ReadMlc();
+    Msg[offset + 1U] = 0U;
+  }
+}
+
+/**
+  * @brief  One sample through the handler chain
+  * @retval The frame length
+  */
+NOINLINE static uint32_t ChainTick(void)
+{
+  const Offline &rec = OfflineData[OfflineReadIndex];
+  uint32_t len;
+
+  RTC_Handler(Frame);
+  Axes_Handler(Frame, ACCELEROMETER_SENSOR, &AccValue, rec.Acc, 19U);
+  Axes_Handler(Frame, GYROSCOPE_SENSOR, &GyrValue, rec.Gyr, 31U);
+  Axes_Handler(Frame, MAGNETIC_SENSOR, &MagValue, rec.Mag, 43U);
+  Env_Handler(Frame, HUMIDITY_SENSOR, &HumValue, rec.Env[2], 15U);
+  Env_Handler(Frame, TEMPERATURE_SENSOR, &TempValue, rec.Env[1], 11U);
+  Env_Handler(Frame, PRESSURE_SENSOR, &PressValue, rec.Env[0], 7U);
+  FX_Handler(Frame);
+  MLC_Handler(Frame);
+
+  len = (Compact == 0U) ? LENGTH : LENGTH_COMPACT;
+  len += ((SensorsEnabled & MLC_SENSOR) == MLC_SENSOR) ? 2U : 0U;
+
+  if (UseOfflineData == 1U)
+  {
+    OfflineReadIndex = (OfflineReadIndex + 1) % OFFLINE_SIZE;
+  }
+
+  return len;
+}
+
+/* Stage list ----------------------------------------------------------------*/
+static void RTC_Stage(void *Source, uint8_t *Sink)
+{
+  (void)Source;
+  ReadTime(Sink);
+}
+
+static void Axes_Stage(void *Source, uint8_t *Sink)
+{
+  ReadAxes(static_cast<Axes *>(Source));
+  PutAxes(*static_cast<Axes *>(Source), Sink);
+}
+
+static void Mag_Stage(void *Source, uint8_t *Sink)
+{
+  Axes *mag = static_cast<Axes *>(Source);
+
+  ReadAxes(mag);
+  mag->x -= MagOffset.x;
+  mag->y -= MagOffset.y;
+  mag->z -= MagOffset.z;
+  PutAxes(*mag, Sink);
+}
+
+static void Env_Stage(void *Source, uint8_t *Sink)
+{
+  ReadValue(static_cast<float *>(Source));
+  std::memcpy(Sink, Source, sizeof(float));
+}
+
+static void Offline_Stage(void *Source, uint8_t *Sink)
+{
+  const Offline &rec = static_cast<const Offline *>(Source)[OfflineReadIndex];
+
+  std::memcpy(&Sink[3], rec.Time, 4U);
+  PressValue = rec.Env[0];
+  TempValue = rec.Env[1];
+  HumValue = rec.Env[2];
+  std::memcpy(&Sink[7], &PressValue, sizeof(float));
+  std::memcpy(&Sink[11], &TempValue, sizeof(float));
+  std::memcpy(&Sink[15], &HumValue, sizeof(float));
+  AccValue = { rec.Acc[0], rec.Acc[1], rec.Acc[2] };
+  GyrValue = { rec.Gyr[0], rec.Gyr[1], rec.Gyr[2] };
+  MagValue = { rec.Mag[0], rec.Mag[1], rec.Mag[2] };
+  PutAxes(AccValue, &Sink[19]);
+  PutAxes(GyrValue, &Sink[31]);
+  PutAxes(MagValue, &Sink[43]);
+}
+
+static void Offline_Next_Stage(void *Source, uint8_t *Sink)
+{
+  (void)Source;
+  (void)Sink;
+  OfflineReadIndex = (OfflineReadIndex + 1) % OFFLINE_SIZE;
+}
+
+static void FX_Float_Stage(void *Source, uint8_t *Sink)
+{
+  (void)Source;
+  Fusion(Sink, LENGTH - FX_OFFSET);
+}
+
+static void FX_Compact_Stage(void *Source, uint8_t *Sink)
+{
+  (void)Source;
+  Fusion(Sink, LENGTH_COMPACT - FX_OFFSET);
+}
+
+static void FX_Idle_Stage(void *Source, uint8_t *Sink)
+{
+  (void)Source;
+  std::memset(Sink, 0, LENGTH_COMPACT - FX_OFFSET);
+}
+
+static void MLC_Stage(void *Source, uint8_t *Sink)
+{
+  (void)Source;
+  Sink[0] = ReadMlc();
+  Sink[1] = 0U;
+}
+
+/**
+  * @brief  Build the stage list of the configuration, as Stream_Build
+  * @retval None
+  */
+static void Build(void)
+{
+  uint32_t enabled = SensorsEnabled;
+
+  SAMPLE_PIPE_Reset(&Pipe);
+
+  if (UseOfflineData == 1U)
+  {
+    (void)SAMPLE_PIPE_Add(&Pipe, Offline_Stage, OfflineData, Frame);
+  }
+  else
+  {
+    (void)SAMPLE_PIPE_Add(&Pipe, RTC_Stage, nullptr, &Frame[3]);
+    if ((enabled & ACCELEROMETER_SENSOR) != 0U)
+    {
+      (void)SAMPLE_PIPE_Add(&Pipe, Axes_Stage, &AccValue, &Frame[19]);
+    }
+    if ((enabled & GYROSCOPE_SENSOR) != 0U)
+    {
+      (void)SAMPLE_PIPE_Add(&Pipe, Axes_Stage, &GyrValue, &Frame[31]);
+    }
+    if ((enabled & MAGNETIC_SENSOR) != 0U)
+    {
+      (void)SAMPLE_PIPE_Add(&Pipe, Mag_Stage, &MagValue, &Frame[43]);
+    }
+    if ((enabled & HUMIDITY_SENSOR) != 0U)
+    {
+      (void)SAMPLE_PIPE_Add(&Pipe, Env_Stage, &HumValue, &Frame[15]);
+    }
+    if ((enabled & TEMPERATURE_SENSOR) != 0U)
+    {
+      (void)SAMPLE_PIPE_Add(&Pipe, Env_Stage, &TempValue, &Frame[11]);
+    }
+    if ((enabled & PRESSURE_SENSOR) != 0U)
+    {
+      (void)SAMPLE_PIPE_Add(&Pipe, Env_Stage, &PressValue, &Frame[7]);
+    }
+  }
+
+  if ((enabled & FUSION_SENSORS) == FUSION_SENSORS)
+  {
+    (void)SAMPLE_PIPE_Add(&Pipe, (Compact != 0U) ? FX_Compact_Stage : FX_Float_Stage, nullptr, &Frame[FX_OFFSET]);
+  }
+  else if (Compact != 0U)
+  {
+    (void)SAMPLE_PIPE_Add(&Pipe, FX_Idle_Stage, nullptr, &Frame[FX_OFFSET]);
+  }
+
+  PipeLen = (Compact != 0U) ? LENGTH_COMPACT : LENGTH;
+  if ((enabled & MLC_SENSOR) != 0U)
+  {
+    (void)SAMPLE_PIPE_Add(&Pipe, MLC_Stage, nullptr, &Frame[PipeLen]);
+    PipeLen += 2U;
+  }
+
+  if (UseOfflineData == 1U)
+  {
+    (void)SAMPLE_PIPE_Add(&Pipe, Offline_Next_Stage, nullptr, nullptr);
+  }
+}
+
+/**
+  * @brief  One sample through the stage list
+  * @retval The frame length
+  */
+NOINLINE static uint32_t PipeTick(void)
+{
+  SAMPLE_PIPE_Run(&Pipe);
+  return PipeLen;
+}
+
+/**
+  * @brief  Time one way of running samples
+  * @param  Tick the sample function
+  * @param  Count the number of samples
+  * @retval Nanoseconds per sample
+  */
+static double Time(uint32_t (*Tick)(void), uint32_t Count)
+{
+  BenchClock::time_point start = BenchClock::now();
+  uint32_t sum = 0U;
+
+  for (uint32_t i = 0U; i < Count; i++)
+  {
+    Bus = static_cast<int32_t>(i);
+    sum += Tick();
+  }
+
+  if (sum == 0U)
+  {
+    std::printf("?");
+  }
+
+  return std::chrono::duration<double, std::nano>(BenchClock::now() - start).count() / Count;
+}
+
+/**
+  * @brief  Check that both ways write the same frame
+  * @retval true if they do
+  */
+static bool Same(void)
+{
+  uint8_t chain[256];
+  int index = OfflineReadIndex;
+  uint32_t len;
+
+  std::memset(Frame, 0, sizeof(Frame));
+  Bus = 1234;
+  len = ChainTick();
+  std::memcpy(chain, Frame, sizeof(chain));
+
+  OfflineReadIndex = index;
+  std::memset(Frame, 0, sizeof(Frame));
+  return (PipeTick() == len) && (std::memcmp(chain, Frame, sizeof(chain)) == 0);
+}
+
+int main(int argc, char **argv)
+{
+  static const struct { const char *Name; uint32_t Enabled; uint8_t Offline; uint8_t Compact; } configs[] =
+  {
+    { "acc", ACCELEROMETER_SENSOR, 0U, 0U },
+    { "acc,gyr", ACCELEROMETER_SENSOR | GYROSCOPE_SENSOR, 0U, 0U },
+    { "acc,gyr,mag + fusion", FUSION_SENSORS, 0U, 0U },
+    { "acc,gyr,mag + compact", FUSION_SENSORS, 0U, 1U },
+    { "all sensors + mlc", 0xF7U, 0U, 0U },
+    { "offline", 0xFFFFFFFFU & ~MLC_SENSOR, 1U, 0U },
+  };
+  uint32_t count = (argc > 1) ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 0)) : 2000000U;
+  bool ok = true;
+
+  for (int i = 0; i < OFFLINE_SIZE; i++)
+  {
+    OfflineData[i] = { { 1U, 2U, 3U, static_cast<uint8_t>(i) }, { 1000.0F, 25.0F, 40.0F },
+                       { i, 2, 1000 }, { 3, i, 5 }, { 300, 200, i } };
+  }
+
+  std::printf("%u samples per configuration, best of %u\n\n", count, RUNS);
+  std::printf("%-24s %7s %10s %10s %7s  %s\n", "configuration", "stages", "chain ns", "stages ns", "ratio",
+              "frame");
+
+  for (const auto &c : configs)
+  {
+    double chain;
+    double pipe;
+    bool same;
+
+    SensorsEnabled = c.Enabled;
+    UseOfflineData = c.Offline;
+    Compact = c.Compact;
+    OfflineReadIndex = 0;
+    Build();
+
+    same = Same();
+    ok = ok && same;
+
+    /* Best of alternated runs, the host is not idle */
+    chain = Time(ChainTick, count);
+    pipe = Time(PipeTick, count);
+    for (uint32_t run = 1U; run < RUNS; run++)
+    {
+      chain = std::min(chain, Time(ChainTick, count));
+      pipe = std::min(pipe, Time(PipeTick, count));
+    }
+
+    std::printf("%-24s %7u %10.2f %10.2f %7.2f  %s\n", c.Name, Pipe.Count, chain, pipe, chain / pipe,
+                same ? "same" : "DIFFERENT");
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,359 @@
+/**
+  ******************************************************************************
+  * @file    slip_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the sample slip detector against a simulated sensor
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "sample_slip.h"
+
+/*
+ * Runs the firmware sample_slip.c on a host against a simulated LSM6DSOX.
+ * The sensor oscillator is off by Trim from nominal: sample k is ready at
+ * k * 384 / (40 kHz * (1 + Trim)) and the timestamp counts at
+ * 40 kHz * (1 + Trim). A read at time t gets the latest sample ready and the
+ * timestamp at t. The truth for each read is the number of samples since
+ * the previous read, the detector must find it from the timestamp only.
+ *
+ *  - data-ready: one read per sample, a fixed latency plus a random jitter,
+ *    with lost interrupts, stalls that coalesce several data-ready events
+ *    into one read, and repeated reads of the same sample,
+ *  - timer: reads on a free-running 100 Hz or 120 Hz timer with its own
+ *    clock error, as the TIM2 polling of DataLogFusion,
+ *  - torn: data-ready reads where the axes come some time after the
+ *    timestamp, now and then a period later when the read is preempted.
+ *    The axes must belong to the sample the detector gives the read, as
+ *    Motion_Read of app_mems.c does it.
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static const double kTsHz = 40000.0;
+static const uint32_t kDiv = 64U;  /* 104 Hz */
+
+struct Sensor
+{
+  double Trim;      /* Oscillator error */
+  uint32_t TsBase;  /* Timestamp at t = 0 */
+
+  double Period() const
+  {
+    return (6.0 * kDiv) / (kTsHz * (1.0 + Trim));
+  }
+  int64_t Sample(double T) const
+  {
+    return (int64_t)std::floor(T / Period());
+  }
+  uint32_t Timestamp(double T) const
+  {
+    return TsBase + (uint32_t)(uint64_t)std::floor(T * kTsHz * (1.0 + Trim));
+  }
+};
+
+struct Result
+{
+  uint32_t Reads;
+  uint32_t Wrong;      /* Reads classified differently from the truth */
+  uint64_t Missed;     /* Truth */
+  uint64_t Duplicates; /* Truth */
+  SAMPLE_SLIP_t Slip;
+};
+
+/**
+  * @brief  Run the detector on a list of read times
+  * @param  S the sensor
+  * @param  Times the read times [s]
+  * @retval The comparison with the truth
+  */
+static Result Run(const Sensor &S, const std::vector<double> &Times)
+{
+  Result r = {};
+  int64_t prev = 0;
+
+  (void)SAMPLE_SLIP_Init(&r.Slip, SAMPLE_SLIP_Period(104.0f));
+
+  for (size_t i = 0; i < Times.size(); i++)
+  {
+    int64_t k = S.Sample(Times[i]);
+    uint32_t n = SAMPLE_SLIP_Check(&r.Slip, S.Timestamp(Times[i]));
+
+    if (i > 0U)
+    {
+      int64_t truth = k - prev;
+
+      r.Wrong += ((int64_t)n != truth) ? 1U : 0U;
+      r.Duplicates += (truth == 0) ? 1U : 0U;
+      r.Missed += (truth > 1) ? (uint64_t)(truth - 1) : 0U;
+    }
+    prev = k;
+    r.Reads++;
+  }
+
+  return r;
+}
+
+struct TornResult
+{
+  uint32_t Reads;    /* Reads kept */
+  uint32_t Wrong;    /* Kept reads whose axes are of another sample */
+  uint32_t Dropped;  /* Torn reads dropped */
+  uint32_t Peek;     /* Peeks differing from the check that follows */
+  SAMPLE_SLIP_t Slip;
+};
+
+/**
+  * @brief  Data-ready reads with the axes read after the timestamp
+  * @param  S the sensor
+  * @param  Samples the number of samples
+  * @param  Recheck true to read the timestamp again after the axes and
+  *         drop the torn reads
+  * @param  Rng the random source
+  * @retval The axes kept against the sample of each read
+  */
+static TornResult TornReads(const Sensor &S, uint32_t Samples, bool Recheck, std::mt19937 &Rng)
+{
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  const double p = S.Period();
+  const double latency = 150e-6;   /* EXTI, task dispatch */
+  const double ts_read = 100e-6;   /* Timestamp, 4 bytes on I2C */
+  const double axes_read = 400e-6; /* Accelerometer and gyroscope axes */
+  TornResult r = {};
+  int64_t assigned = 0;
+  double now = 0.0;
+
+  (void)SAMPLE_SLIP_Init(&r.Slip, SAMPLE_SLIP_Period(104.0f));
+
+  for (uint32_t k = 0; k < Samples; k++)
+  {
+    /* A read does not start before the previous one is over */
+    now = std::fmax(now, ((double)k * p) + latency + (u(Rng) * 0.1 * p));
+
+    uint32_t before = S.Timestamp(now);
+    if (SAMPLE_SLIP_Peek(&r.Slip, before) == 0U)
+    {
+      (void)SAMPLE_SLIP_Check(&r.Slip, before);
+      continue;
+    }
+
+    /* Preempted for up to 1.2 periods between the timestamp and the axes */
+    double axes = now + ts_read + (((k > 0U) && (u(Rng) < 0.02)) ? (u(Rng) * 1.2 * p) : 0.0);
+    now = axes + axes_read;
+    uint32_t after = S.Timestamp(now);
+    now += ts_read;
+
+    if (Recheck && (SAMPLE_SLIP_Same(&r.Slip, before, after) == 0U))
+    {
+      r.Dropped++;
+      continue;
+    }
+
+    uint32_t peek = SAMPLE_SLIP_Peek(&r.Slip, before);
+    uint32_t n = SAMPLE_SLIP_Check(&r.Slip, before);
+    r.Peek += (peek != n) ? 1U : 0U;
+    assigned = (r.Reads == 0U) ? S.Sample(axes) : (assigned + (int64_t)n);
+    r.Wrong += (S.Sample(axes) != assigned) ? 1U : 0U;
+    r.Reads++;
+  }
+
+  return r;
+}
+
+/**
+  * @brief  Print a torn read result
+  * @param  Name the case name
+  * @param  R the result
+  * @param  Exact true if every kept read must carry its own sample
+  * @retval true if the result meets the expectation
+  */
+static bool TornReport(const char *Name, const TornResult &R, bool Exact)
+{
+  bool ok = (R.Peek == 0U) && (Exact ? (R.Wrong == 0U) : (R.Wrong != 0U));
+
+  std::printf("%-22s %7u reads  torn %5u  dropped %4u  missed %5u  wrong axes %5u  %s\n",
+              Name, R.Reads, R.Slip.Torn, R.Dropped, R.Slip.Missed, R.Wrong, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+/**
+  * @brief  Data-ready driven reads
+  * @param  S the sensor
+  * @param  Samples the number of samples
+  * @param  Jitter the read latency jitter, of the period
+  * @param  Rng the random source
+  * @retval The read times
+  */
+static std::vector<double> DrdyReads(const Sensor &S, uint32_t Samples, double Jitter, std::mt19937 &Rng)
+{
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  std::vector<double> t;
+  const double p = S.Period();
+  const double latency = 150e-6;  /* EXTI, task dispatch, I2C */
+
+  for (uint32_t k = 0; k < Samples; k++)
+  {
+    double x = u(Rng);
+
+    if (x < 0.002)
+    {
+      continue;  /* Lost interrupt: the sample is never read */
+    }
+    if (x < 0.003)
+    {
+      /* Stall of up to 10 periods, the events coalesce in one read */
+      uint32_t stall = 1U + (uint32_t)(u(Rng) * 10.0);
+      k += stall;
+      t.push_back(((double)k + 0.2) * p);
+      continue;
+    }
+
+    double read = ((double)k * p) + latency + (u(Rng) * Jitter * p);
+    t.push_back(read);
+    if (x > 0.999)
+    {
+      t.push_back(read + 0.2 * p);  /* Same sample read again */
+    }
+  }
+
+  return t;
+}
+
+/**
+  * @brief  Free-running timer reads
+  * @param  Hz the timer rate
+  * @param  Ppm the timer clock error
+  * @param  Seconds the duration
+  * @retval The read times
+  */
+static std::vector<double> TimerReads(double Hz, double Ppm, double Seconds)
+{
+  std::vector<double> t;
+  double period = 1.0 / (Hz * (1.0 + Ppm * 1e-6));
+
+  for (double x = 0.0013; x < Seconds; x += period)
+  {
+    t.push_back(x);
+  }
+  return t;
+}
+
+/**
+  * @brief  Print a result
+  * @param  Name the case name
+  * @param  R the result
+  * @param  Exact true if every read must be classified right
+  * @retval true if the result meets the expectation
+  */
+static bool Report(const char *Name, const Result &R, bool Exact)
+{
+  bool counts = (std::llabs((long long)R.Slip.Missed - (long long)R.Missed) <= 1)
+                && (std::llabs((long long)R.Slip.Duplicates - (long long)R.Duplicates) <= 1);
+  bool ok = Exact ? ((R.Wrong == 0U) && (R.Slip.Missed == R.Missed) && (R.Slip.Duplicates == R.Duplicates)) : counts;
+
+  std::printf("%-22s %7u reads  missed %5u/%-5llu  duplicates %5u/%-5llu  slips %5u  wrong reads %4u  %s\n",
+              Name, R.Reads, R.Slip.Missed, (unsigned long long)R.Missed, R.Slip.Duplicates,
+              (unsigned long long)R.Duplicates, R.Slip.Slips, R.Wrong, ok ? "ok" : "FAILED");
+  return ok;
+}
+
+int main()
+{
+  std::mt19937 rng(5);
+  SAMPLE_SLIP_t slip;
+  bool ok = true;
+
+  /* Periods of the output data rates, in ticks */
+  if ((SAMPLE_SLIP_Period(104.0f) != 384U) || (SAMPLE_SLIP_Period(100.0f) != 384U)
+      || (SAMPLE_SLIP_Period(26.0f) != 1536U) || (SAMPLE_SLIP_Period(12.5f) != 3072U)
+      || (SAMPLE_SLIP_Period(416.0f) != 96U) || (SAMPLE_SLIP_Period(6667.0f) != 6U)
+      || (SAMPLE_SLIP_Period(1.6f) != 24576U) || (SAMPLE_SLIP_Period(0.0f) != 0U)
+      || (SAMPLE_SLIP_Period(0.5f) != 0U) || (SAMPLE_SLIP_Init(&slip, 0U) != SAMPLE_SLIP_ERROR))
+  {
+    std::printf("output data rate periods  FAILED\n");
+    ok = false;
+  }
+
+  /* One hour at 104 Hz, the timestamp wraps during the run */
+  const uint32_t samples = 374400U;
+  Sensor nominal = { 0.0, 0xFFF00000U };
+  Sensor fast = { 0.015, 0xFFF00000U };   /* +1.5 %, the trim range edge */
+  Sensor slow = { -0.015, 0x00001234U };
+
+  ok &= Report("drdy nominal", Run(nominal, DrdyReads(nominal, samples, 0.1, rng)), true);
+  ok &= Report("drdy osc +1.5%", Run(fast, DrdyReads(fast, samples, 0.1, rng)), true);
+  ok &= Report("drdy osc -1.5%", Run(slow, DrdyReads(slow, samples, 0.1, rng)), true);
+  ok &= Report("drdy jitter 0.25", Run(nominal, DrdyReads(nominal, samples, 0.25, rng)), true);
+  ok &= Report("timer 100Hz", Run(nominal, TimerReads(100.0, 30.0, 3600.0)), false);
+  ok &= Report("timer 100Hz osc -1.5%", Run(slow, TimerReads(100.0, -20.0, 3600.0)), false);
+  ok &= Report("timer 120Hz", Run(nominal, TimerReads(120.0, 30.0, 3600.0)), false);
+
+  /* Without the second timestamp the preempted reads carry a later sample */
+  ok &= TornReport("torn, one timestamp", TornReads(nominal, samples, false, rng), false);
+  ok &= TornReport("torn, re-read", TornReads(nominal, samples, true, rng), true);
+  ok &= TornReport("torn, re-read +1.5%", TornReads(fast, samples, true, rng), true);
+
+  /* Peek takes nothing, Same compares before the first read */
+  (void)SAMPLE_SLIP_Init(&slip, SAMPLE_SLIP_Period(104.0f));
+  bool peek = (SAMPLE_SLIP_Peek(&slip, 1000U) == 1U) && (SAMPLE_SLIP_Same(&slip, 1000U, 1150U) == 1U)
+              && (SAMPLE_SLIP_Same(&slip, 1000U, 1200U) == 0U) && (slip.Torn == 1U);
+  (void)SAMPLE_SLIP_Check(&slip, 1000U);
+  peek &= (SAMPLE_SLIP_Peek(&slip, 1010U) == 0U) && (SAMPLE_SLIP_Peek(&slip, 1384U + 1152U) == 4U)
+          && (SAMPLE_SLIP_Peek(&slip, 1000U + (100U * 384U)) == 1U) && (slip.Grid == 1000U)
+          && (slip.Duplicates == 0U) && (slip.Missed == 0U) && (slip.Restarts == 0U)
+          && (SAMPLE_SLIP_Same(&slip, 1100U, 1300U) == 0U) && (SAMPLE_SLIP_Same(&slip, 1200U, 1500U) == 1U);
+  std::printf("peek and same          %s\n", peek ? "ok" : "FAILED");
+  ok &= peek;
+
+  /* A gap longer than SAMPLE_SLIP_MAX_GAP restarts */
+  (void)SAMPLE_SLIP_Init(&slip, SAMPLE_SLIP_Period(104.0f));
+  (void)SAMPLE_SLIP_Check(&slip, 1000U);
+  (void)SAMPLE_SLIP_Check(&slip, 1384U);
+  if ((SAMPLE_SLIP_Check(&slip, 1384U + (100U * 384U)) != 1U) || (slip.Restarts != 1U)
+      || (SAMPLE_SLIP_Check(&slip, 1384U + (103U * 384U)) != 3U) || (slip.Missed != 2U))
+  {
+    std::printf("restart after a gap  FAILED\n");
+    ok = false;
+  }
+
+  /* Cost of a check */
+  std::vector<uint32_t> ts(4096U);
+  for (size_t i = 0; i < ts.size(); i++)
+  {
+    ts[i] = (uint32_t)(i * 384U) + (uint32_t)(rng() % 20U);
+  }
+  volatile uint32_t sink = 0;
+  double best = 1e9;
+  for (int run = 0; run < 5; run++)
+  {
+    (void)SAMPLE_SLIP_Init(&slip, SAMPLE_SLIP_Period(104.0f));
+    BenchClock::time_point t0 = BenchClock::now();
+    for (uint32_t r = 0; r < 200U; r++)
+    {
+      SAMPLE_SLIP_Reset(&slip);
+      for (uint32_t t : ts)
+      {
+        sink = sink + SAMPLE_SLIP_Check(&slip, t);
+      }
+    }
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    best = std::fmin(best, ns / (200.0 * (double)ts.size()));
+  }
+  std::printf("check  %.1f ns per read\n", best);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
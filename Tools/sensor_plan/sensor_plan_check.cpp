@@ -0,0 +1,438 @@
+/**
+  ******************************************************************************
+  * @file    sensor_plan_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the sensor configuration planner against an exhaustive search
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "sensor_plan.h"
+
+/*
+ * Runs the firmware sensor_plan.c on a host. For each set of consumer needs
+ * every configuration of the sensor is tried: accelerometer rate and mode,
+ * gyroscope rate and mode, MLC rate. The cheapest one meeting all the needs
+ * is the reference, the planner must find one as cheap, meeting all the
+ * needs, or report an error when no configuration does. The rules and the
+ * currents below are written out again from the datasheet, not taken from
+ * the module.
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static const uint32_t kRates[12] = { 0, 16, 125, 260, 520, 1040, 2080, 4170, 8330, 16670, 33330, 66670 };
+
+/* [0.1 uA], 0 where the mode has no such rate */
+static const uint32_t kAcc[3][12] =
+{
+  { 0, 0, 1700, 1700, 1700, 1700, 1700, 1700, 1700, 1700, 1700, 1700 },
+  { 0, 45, 95, 150, 260, 450, 850, 0, 0, 0, 0, 0 },
+  { 0, 30, 44, 65, 105, 190, 360, 0, 0, 0, 0, 0 },
+};
+static const uint32_t kGyr[2][12] =
+{
+  { 0, 0, 4300, 4300, 4300, 4300, 4300, 4300, 4300, 4300, 4300, 4300 },
+  { 0, 0, 2350, 2550, 2900, 3500, 4000, 0, 0, 0, 0, 0 },
+};
+static const uint32_t kMlc[12] = { 0, 0, 20, 30, 50, 90, 0, 0, 0, 0, 0, 0 };
+
+struct Needs
+{
+  uint32_t Acc, Gyr, Mlc, AccBatch, GyrBatch;
+  uint8_t AccMode, GyrMode;
+  uint32_t Window, Latency;
+  bool AccUsed, GyrUsed;
+};
+
+/**
+  * @brief  Merge the consumers the plain way
+  * @param  Reqs the consumers
+  * @retval The merged needs
+  */
+static Needs Merge(const std::vector<SENSOR_PLAN_Req_t> &Reqs)
+{
+  Needs n = {};
+
+  n.AccMode = 2;
+  n.GyrMode = 1;
+  for (const SENSOR_PLAN_Req_t &r : Reqs)
+  {
+    bool acc = (r.AccRate != 0U) || (r.MlcRate != 0U) || (r.AccBatch != 0U);
+    bool gyr = (r.GyrRate != 0U) || (r.GyrBatch != 0U);
+
+    n.AccUsed |= acc;
+    n.GyrUsed |= gyr;
+    n.AccMode = acc ? std::min(n.AccMode, r.AccMode) : n.AccMode;
+    n.GyrMode = gyr ? std::min(n.GyrMode, r.GyrMode) : n.GyrMode;
+    n.Acc = std::max(n.Acc, r.AccRate);
+    n.Gyr = std::max(n.Gyr, r.GyrRate);
+    n.Mlc = std::max(n.Mlc, r.MlcRate);
+    n.AccBatch = std::max(n.AccBatch, r.AccBatch);
+    n.GyrBatch = std::max(n.GyrBatch, r.GyrBatch);
+    n.Window = std::max(n.Window, (uint32_t)r.FifoWindow);
+    if ((r.FifoLatency != 0U) && ((n.Latency == 0U) || (r.FifoLatency < n.Latency)))
+    {
+      n.Latency = r.FifoLatency;
+    }
+  }
+  return n;
+}
+
+/**
+  * @brief  Lowest FIFO batching step covering a rate
+  * @param  Rate the rate [0.1 Hz], 0 if not batched
+  * @retval The step, 0 if not batched, 12 if none covers it
+  */
+static uint32_t BatchStep(uint32_t Rate)
+{
+  if (Rate == 0U)
+  {
+    return 0;
+  }
+  for (uint32_t s = 2; s < 12U; s++)
+  {
+    if (kRates[s] >= Rate)
+    {
+      return s;
+    }
+  }
+  return 12;
+}
+
+struct Best
+{
+  bool Found;
+  uint32_t Current;
+};
+
+/**
+  * @brief  Try every configuration
+  * @param  N the needs
+  * @param  AccB the accelerometer batching step
+  * @param  GyrB the gyroscope batching step
+  * @retval The cheapest configuration meeting the needs
+  */
+static Best Search(const Needs &N, uint32_t AccB, uint32_t GyrB)
+{
+  Best best = { false, 0 };
+
+  for (uint32_t m = 0; m < 12U; m++)
+  {
+    if ((N.Mlc != 0U) ? ((kMlc[m] == 0U) || (kRates[m] < N.Mlc)) : (m != 0U))
+    {
+      continue;
+    }
+    for (uint32_t gr = 0; gr < 12U; gr++)
+    {
+      for (uint32_t gm = 0; gm < 2U; gm++)
+      {
+        bool gon = (gr != 0U);
+
+        if (gon ? ((kGyr[gm][gr] == 0U) || (gm > N.GyrMode)) : (gm != 0U))
+        {
+          continue;
+        }
+        if ((kRates[gr] < N.Gyr) || (kRates[gr] < kRates[GyrB]))
+        {
+          continue;
+        }
+        for (uint32_t ar = 0; ar < 12U; ar++)
+        {
+          for (uint32_t am = 0; am < 3U; am++)
+          {
+            bool aon = (ar != 0U);
+
+            if (aon ? ((kAcc[am][ar] == 0U) || (am > N.AccMode)) : (am != 0U))
+            {
+              continue;
+            }
+            if ((am == 2U) && gon)
+            {
+              continue;  /* Ultra-low-power needs the gyroscope off */
+            }
+            if ((kRates[ar] < N.Acc) || (kRates[ar] < kRates[AccB]) || (kRates[ar] < kRates[m]))
+            {
+              continue;
+            }
+            uint32_t cost = kAcc[am][ar] + kGyr[gon ? gm : 0][gr] + kMlc[m];
+            if (!best.Found || (cost < best.Current))
+            {
+              best.Found = true;
+              best.Current = cost;
+            }
+          }
+        }
+      }
+    }
+  }
+  return best;
+}
+
+/**
+  * @brief  Check the plan of a set of consumers
+  * @param  Reqs the consumers
+  * @param  Errors count of the sets the planner rejected
+  * @retval true if the planner agrees with the search
+  */
+static bool Check(const std::vector<SENSOR_PLAN_Req_t> &Reqs, uint32_t &Errors)
+{
+  Needs n = Merge(Reqs);
+  uint32_t accb = BatchStep(n.AccBatch);
+  uint32_t gyrb = BatchStep(n.GyrBatch);
+  SENSOR_PLAN_t plan;
+  SENSOR_PLAN_t keep;
+  bool feasible = (accb < 12U) && (gyrb < 12U);
+  uint32_t watermark = 0;
+  Best best = { false, 0 };
+
+  if (feasible)
+  {
+    uint32_t words = kRates[accb] + kRates[gyrb];
+
+    best = Search(n, accb, gyrb);
+    feasible = best.Found;
+    if (words == 0U)
+    {
+      feasible &= (n.Window == 0U) && (n.Latency == 0U);
+    }
+    else if (n.Latency != 0U)
+    {
+      watermark = std::min<uint32_t>((n.Latency * words) / 10000U, 511U);
+      feasible &= (watermark != 0U) && (watermark >= n.Window);
+    }
+    else
+    {
+      watermark = n.Window;
+      feasible &= (watermark <= 511U);
+    }
+  }
+
+  (void)std::memset(&plan, 0xA5, sizeof(plan));
+  keep = plan;
+  int32_t ret = SENSOR_PLAN_Solve(Reqs.data(), (uint32_t)Reqs.size(), &plan);
+
+  if (!feasible)
+  {
+    Errors++;
+    return (ret == SENSOR_PLAN_ERROR) && (std::memcmp(&plan, &keep, sizeof(plan)) == 0);
+  }
+  if (ret != SENSOR_PLAN_OK)
+  {
+    return false;
+  }
+
+  /* The plan meets every need, at the cost of the cheapest configuration */
+  bool gon = (plan.GyrRate != 0U);
+  bool ok = (plan.AccRate < 12U) && (plan.GyrRate < 12U) && (plan.MlcRate < 12U)
+            && (plan.AccMode < 3U) && (plan.GyrMode < 2U);
+  if (!ok)
+  {
+    return false;
+  }
+  uint32_t cost = (plan.AccRate ? kAcc[plan.AccMode][plan.AccRate] : 0U)
+                  + (gon ? kGyr[plan.GyrMode][plan.GyrRate] : 0U) + kMlc[plan.MlcRate];
+
+  ok &= (plan.AccRate == 0U) || (kAcc[plan.AccMode][plan.AccRate] != 0U);
+  ok &= !gon || (kGyr[plan.GyrMode][plan.GyrRate] != 0U);
+  ok &= (plan.AccRate == 0U) || (plan.AccMode <= n.AccMode);
+  ok &= !gon || (plan.GyrMode <= n.GyrMode);
+  ok &= !((plan.AccMode == 2U) && gon);
+  ok &= (kRates[plan.AccRate] >= n.Acc) && (kRates[plan.AccRate] >= kRates[plan.AccBatch])
+        && (kRates[plan.AccRate] >= kRates[plan.MlcRate]);
+  ok &= (kRates[plan.GyrRate] >= n.Gyr) && (kRates[plan.GyrRate] >= kRates[plan.GyrBatch]);
+  ok &= (n.Mlc == 0U) ? (plan.MlcRate == 0U) : ((kMlc[plan.MlcRate] != 0U) && (kRates[plan.MlcRate] >= n.Mlc));
+  ok &= (plan.AccBatch == accb) && (plan.GyrBatch == gyrb) && (plan.Watermark == watermark);
+  ok &= (plan.Current == cost) && (cost == best.Current);
+
+  return ok;
+}
+
+/**
+  * @brief  A random rate, biased to the ladder steps and their neighbours
+  * @param  Rng the random source
+  * @retval The rate [0.1 Hz]
+  */
+static uint32_t RandomRate(std::mt19937 &Rng)
+{
+  uint32_t x = Rng() % 8U;
+  uint32_t s = Rng() % 12U;
+
+  if (x < 2U)
+  {
+    return 0;
+  }
+  if (x == 2U)
+  {
+    return kRates[s];
+  }
+  if (x == 3U)
+  {
+    return kRates[s] + 1U;
+  }
+  if (x == 4U)
+  {
+    return 1U + (Rng() % 70000U);
+  }
+  return 1U + (Rng() % 2100U);
+}
+
+/**
+  * @brief  Print a plan
+  * @param  Plan the plan
+  * @retval None
+  */
+static void Print(const SENSOR_PLAN_t &Plan)
+{
+  static const char *const mode[3] = { "HP", "LP", "ULP" };
+
+  std::printf("    acc %6.1f Hz %-3s  gyro %6.1f Hz %-3s  mlc %5.1f Hz  batch %4.1f / %4.1f Hz  watermark %3u  %6.1f uA\n",
+              SENSOR_PLAN_RateOf(Plan.AccRate) / 10.0, mode[Plan.AccMode], SENSOR_PLAN_RateOf(Plan.GyrRate) / 10.0,
+              mode[Plan.GyrMode], SENSOR_PLAN_RateOf(Plan.MlcRate) / 10.0, SENSOR_PLAN_RateOf(Plan.AccBatch) / 10.0,
+              SENSOR_PLAN_RateOf(Plan.GyrBatch) / 10.0, Plan.Watermark, Plan.Current / 10.0);
+}
+
+int main()
+{
+  std::mt19937 rng(75);
+  bool ok = true;
+  uint32_t errors = 0, bad = 0;
+  const uint32_t sets = 200000U;
+
+  /* Random consumer sets of one to four consumers */
+  for (uint32_t i = 0; i < sets; i++)
+  {
+    std::vector<SENSOR_PLAN_Req_t> reqs(1U + (rng() % 4U));
+
+    for (SENSOR_PLAN_Req_t &r : reqs)
+    {
+      bool batch = (rng() % 3U) == 0U;
+
+      r.Name = "random";
+      r.AccRate = RandomRate(rng);
+      r.GyrRate = ((rng() % 2U) == 0U) ? RandomRate(rng) : 0U;
+      r.MlcRate = ((rng() % 4U) == 0U) ? (1U + (rng() % 1200U)) : 0U;
+      r.AccBatch = batch ? RandomRate(rng) : 0U;
+      r.GyrBatch = batch ? RandomRate(rng) : 0U;
+      r.FifoWindow = batch ? (uint16_t)(rng() % 600U) : 0U;
+      r.FifoLatency = (batch && ((rng() % 2U) == 0U)) ? (uint16_t)(rng() % 20000U) : 0U;
+      r.AccMode = (uint8_t)(rng() % 3U);
+      r.GyrMode = (uint8_t)(rng() % 2U);
+    }
+    if (!Check(reqs, errors))
+    {
+      bad++;
+    }
+  }
+  std::printf("random sets     %6u checked  %6u rejected as expected  mismatches %u  %s\n",
+              sets, errors, bad, (bad == 0U) ? "ok" : "FAILED");
+  ok &= (bad == 0U);
+
+  /* Edge cases */
+  SENSOR_PLAN_t plan;
+  SENSOR_PLAN_Req_t one = { "edge", 0, 0, 0, 0, 0, 0, 0, 2, 1 };
+  bool edges = (SENSOR_PLAN_Solve(nullptr, 1, &plan) == SENSOR_PLAN_ERROR)
+               && (SENSOR_PLAN_Solve(&one, 1, nullptr) == SENSOR_PLAN_ERROR)
+               && (SENSOR_PLAN_Solve(&one, 0, &plan) == SENSOR_PLAN_OK) && (plan.Current == 0U)
+               && (SENSOR_PLAN_RateOf(SENSOR_PLAN_RATE_104Hz) == 1040U) && (SENSOR_PLAN_RateOf(12) == 0U);
+  one.MlcRate = 1041;  /* Above 104 Hz */
+  edges &= (SENSOR_PLAN_Solve(&one, 1, &plan) == SENSOR_PLAN_ERROR);
+  one = { "edge", 16, 0, 0, 0, 0, 0, 0, 2, 1 };  /* 1.6 Hz ultra-low-power */
+  edges &= (SENSOR_PLAN_Solve(&one, 1, &plan) == SENSOR_PLAN_OK) && (plan.AccRate == SENSOR_PLAN_RATE_1Hz6)
+           && (plan.AccMode == SENSOR_PLAN_MODE_ULP) && (plan.Current == 30U);
+  one.GyrRate = 10;  /* The gyroscope turns ultra-low-power off */
+  edges &= (SENSOR_PLAN_Solve(&one, 1, &plan) == SENSOR_PLAN_OK) && (plan.AccMode == SENSOR_PLAN_MODE_LP)
+           && (plan.GyrRate == SENSOR_PLAN_RATE_12Hz5);
+  one = { "edge", 0, 0, 0, 260, 0, 600, 0, 2, 1 };  /* Window above the FIFO */
+  edges &= (SENSOR_PLAN_Solve(&one, 1, &plan) == SENSOR_PLAN_ERROR);
+  one = { "edge", 0, 0, 0, 0, 0, 10, 0, 2, 1 };  /* Window with nothing batched */
+  edges &= (SENSOR_PLAN_Solve(&one, 1, &plan) == SENSOR_PLAN_ERROR);
+  one = { "edge", 0, 0, 0, 260, 260, 0, 1000, 2, 1 };  /* 1 s latency at 52 words/s */
+  edges &= (SENSOR_PLAN_Solve(&one, 1, &plan) == SENSOR_PLAN_OK) && (plan.Watermark == 52U);
+  one.FifoLatency = 10;  /* Shorter than a word */
+  edges &= (SENSOR_PLAN_Solve(&one, 1, &plan) == SENSOR_PLAN_ERROR);
+  std::printf("edge cases      %s\n", edges ? "ok" : "FAILED");
+  ok &= edges;
+
+  /* The consumers of SHUBv3_MLC: falling.h trains at 104 Hz in
+   * high-performance with the gyroscope on */
+  SENSOR_PLAN_Req_t tree[3] =
+  {
+    { "mlc", 1040, 1040, 1040, 0, 0, 0, 0, 0, 0 },
+    { "snapshot", 0, 0, 0, 260, 260, 156, 0, 2, 1 },
+    { "terminal", 125, 125, 0, 0, 0, 0, 0, 2, 1 },
+  };
+  std::printf("SHUBv3_MLC, falling.h\n");
+  ok &= (SENSOR_PLAN_Solve(tree, 3, &plan) == SENSOR_PLAN_OK) && (plan.Watermark == 156U);
+  Print(plan);
+  std::printf("  same program trained in low-power\n");
+  tree[0].AccMode = 1;
+  tree[0].GyrMode = 1;
+  ok &= (SENSOR_PLAN_Solve(tree, 3, &plan) == SENSOR_PLAN_OK);
+  Print(plan);
+  std::printf("  accelerometer only program at 26 Hz, ultra-low-power\n");
+  tree[0] = { "mlc", 260, 0, 260, 0, 0, 0, 0, 2, 1 };
+  tree[1].GyrBatch = 0;
+  tree[2].GyrRate = 0;
+  ok &= (SENSOR_PLAN_Solve(tree, 3, &plan) == SENSOR_PLAN_OK);
+  Print(plan);
+  std::printf("  former fixed set up, 26 Hz high-performance, gyroscope off\n");
+  std::printf("    acc   26.0 Hz HP   gyro    0.0 Hz      mlc 104.0 Hz  starved              %6.1f uA\n",
+              (kAcc[0][3] + kMlc[5]) / 10.0);
+
+  /* The consumers of SHUBv3_MLC_DataLogFusion: the same program, the
+   * fusion at 100 Hz and the stream reading twice as fast */
+  SENSOR_PLAN_Req_t dlf[3] =
+  {
+    { "mlc", 1040, 1040, 1040, 0, 0, 0, 0, 0, 0 },
+    { "fusion", 1000, 1000, 0, 0, 0, 0, 0, 0, 0 },
+    { "stream", 2000, 2000, 0, 0, 0, 0, 0, 1, 1 },
+  };
+  std::printf("SHUBv3_MLC_DataLogFusion, falling.h\n");
+  ok &= (SENSOR_PLAN_Solve(dlf, 3, &plan) == SENSOR_PLAN_OK) && (plan.AccRate == SENSOR_PLAN_RATE_208Hz)
+        && (plan.GyrRate == SENSOR_PLAN_RATE_208Hz) && (plan.MlcRate == SENSOR_PLAN_RATE_104Hz)
+        && (plan.AccMode == SENSOR_PLAN_MODE_HP) && (plan.GyrMode == SENSOR_PLAN_MODE_HP);
+  Print(plan);
+  std::printf("  stream read at 100 Hz, no oversampling\n");
+  dlf[2].AccRate = 1000;
+  dlf[2].GyrRate = 1000;
+  ok &= (SENSOR_PLAN_Solve(dlf, 3, &plan) == SENSOR_PLAN_OK) && (plan.AccRate == SENSOR_PLAN_RATE_104Hz);
+  Print(plan);
+
+  /* Cost of a plan */
+  tree[0] = { "mlc", 1040, 1040, 1040, 0, 0, 0, 0, 0, 0 };
+  tree[1].GyrBatch = 260;
+  tree[2].GyrRate = 125;
+  volatile uint32_t sink = 0;
+  double best = 1e9;
+  for (int run = 0; run < 5; run++)
+  {
+    BenchClock::time_point t0 = BenchClock::now();
+    for (uint32_t r = 0; r < 100000U; r++)
+    {
+      (void)SENSOR_PLAN_Solve(tree, 3, &plan);
+      sink = sink + plan.Current;
+    }
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    best = std::fmin(best, ns / 100000.0);
+  }
+  std::printf("solve  %.0f ns per plan of 3 consumers\n", best);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+/**
+  ******************************************************************************
+  * @file    spi_reg_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the SPI register framing against a simulated device
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "spi_reg.h"
+
+/*
+ * Runs the firmware spi_reg.c on a host. The port drives a simulated ST
+ * MEMS device, byte by byte as the shift register sees them: the first
+ * byte after chip select is the address with the read bit, the next ones
+ * move data and increment the address (IF_INC), wrapping at 0x7F.
+ *
+ *  - framing: the address byte of reads and writes, bit 7 of Reg ignored,
+ *    zeros sent during reads, chip select around each transaction,
+ *  - round trip: random reads and writes of 0 to 256 registers against a
+ *    copy of the register file,
+ *  - errors: a failing exchange at each point of a transaction releases
+ *    chip select and stops the transaction; NULL arguments never reach
+ *    the bus.
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+struct Device
+{
+  uint8_t Reg[128];
+  bool Selected;
+  uint32_t Pos;         /* Bytes since chip select */
+  uint8_t Addr;
+  bool Read;
+  /* What the bus saw */
+  uint32_t Selects;
+  uint32_t Releases;
+  uint32_t Exchanges;
+  uint32_t Unselected;  /* Exchanges without chip select */
+  uint32_t TxNonZero;   /* Non-zero bytes sent during a read */
+  int32_t FailAt;       /* Exchange call that fails, -1 none */
+  std::vector<uint8_t> Cmds;
+};
+
+static Device Dev;
+
+/**
+  * @brief  Port chip select
+  * @param  Context the device
+  * @param  Active 1 to select
+  * @retval None
+  */
+static void Select(void *Context, uint8_t Active)
+{
+  Device *d = static_cast<Device *>(Context);
+
+  if (Active != 0U)
+  {
+    d->Selects++;
+    d->Pos = 0;
+  }
+  else
+  {
+    d->Releases++;
+  }
+  d->Selected = (Active != 0U);
+}
+
+/**
+  * @brief  Port transfer, shifts each byte through the device
+  * @param  Context the device
+  * @param  Tx the data to send, NULL sends zeros
+  * @param  Rx the data received, NULL discards
+  * @param  Len the length
+  * @retval 0 on success
+  */
+static int32_t Exchange(void *Context, const uint8_t *Tx, uint8_t *Rx, uint16_t Len)
+{
+  Device *d = static_cast<Device *>(Context);
+
+  if ((d->FailAt >= 0) && (d->FailAt-- == 0))
+  {
+    return -1;
+  }
+  d->Exchanges++;
+  if (!d->Selected)
+  {
+    d->Unselected++;
+    return 0;
+  }
+
+  for (uint32_t i = 0; i < Len; i++)
+  {
+    uint8_t mosi = (Tx != nullptr) ? Tx[i] : 0U;
+    uint8_t miso = 0xFFU;   /* Line high while the address shifts in */
+
+    if (d->Pos == 0U)
+    {
+      d->Read = (mosi & 0x80U) != 0U;
+      d->Addr = mosi & 0x7FU;
+      d->Cmds.push_back(mosi);
+    }
+    else if (d->Read)
+    {
+      d->TxNonZero += (mosi != 0U) ? 1U : 0U;
+      miso = d->Reg[d->Addr];
+      d->Addr = (d->Addr + 1U) & 0x7FU;
+    }
+    else
+    {
+      d->Reg[d->Addr] = mosi;
+      d->Addr = (d->Addr + 1U) & 0x7FU;
+    }
+    d->Pos++;
+    if (Rx != nullptr)
+    {
+      Rx[i] = miso;
+    }
+  }
+
+  return 0;
+}
+
+static const SPI_REG_Port_t Port = { &Dev, Select, Exchange };
+
+/**
+  * @brief  Clear what the bus saw
+  * @retval None
+  */
+static void ResetBus()
+{
+  Dev.Selected = false;
+  Dev.Selects = 0;
+  Dev.Releases = 0;
+  Dev.Exchanges = 0;
+  Dev.Unselected = 0;
+  Dev.TxNonZero = 0;
+  Dev.FailAt = -1;
+  Dev.Cmds.clear();
+}
+
+/**
+  * @brief  Print a check
+  * @param  Name the check
+  * @param  Pass the result
+  * @param  Detail printed after the name
+  * @retval Pass
+  */
+static bool Report(const char *Name, bool Pass, const std::string &Detail = "")
+{
+  std::printf("%-16s %-52s %s\n", Name, Detail.c_str(), Pass ? "ok" : "FAILED");
+  return Pass;
+}
+
+/**
+  * @brief  Check the address bytes and chip select
+  * @retval true if passed
+  */
+static bool Framing()
+{
+  uint8_t data[4] = { 0x11U, 0x22U, 0x33U, 0x44U };
+  uint8_t back[4] = { 0 };
+  bool ok = true;
+
+  /* Write 4 at CTRL1_XL (0x10), read them back from 0x10 */
+  ResetBus();
+  std::memset(Dev.Reg, 0, sizeof(Dev.Reg));
+  ok &= (SPI_REG_Write(&Port, 0x10U, data, 4U) == SPI_REG_OK) && (SPI_REG_Read(&Port, 0x10U, back, 4U) == SPI_REG_OK);
+  ok &= (Dev.Cmds == std::vector<uint8_t>{ 0x10U, 0x90U }) && (std::memcmp(back, data, 4U) == 0)
+        && (Dev.Selects == 2U) && (Dev.Releases == 2U) && !Dev.Selected && (Dev.Exchanges == 4U)
+        && (Dev.TxNonZero == 0U) && (Dev.Unselected == 0U);
+
+  /* Bit 7 of Reg does not turn a write into a read, nor the reverse */
+  ResetBus();
+  ok &= (SPI_REG_Write(&Port, 0x90U, data, 1U) == SPI_REG_OK) && (SPI_REG_Read(&Port, 0x90U, back, 1U) == SPI_REG_OK);
+  ok &= (Dev.Cmds == std::vector<uint8_t>{ 0x10U, 0x90U }) && (back[0] == 0x11U);
+
+  /* No data: the address byte alone, chip select still released */
+  ResetBus();
+  ok &= (SPI_REG_Read(&Port, 0x0FU, back, 0U) == SPI_REG_OK) && (SPI_REG_Write(&Port, 0x0FU, data, 0U) == SPI_REG_OK);
+  ok &= (Dev.Cmds == std::vector<uint8_t>{ 0x8FU, 0x0FU }) && (Dev.Exchanges == 2U) && (Dev.Releases == 2U);
+
+  /* Auto increment wraps from 0x7F to 0x00 */
+  ResetBus();
+  ok &= (SPI_REG_Write(&Port, 0x7EU, data, 4U) == SPI_REG_OK) && (Dev.Reg[0x7EU] == 0x11U)
+        && (Dev.Reg[0x7FU] == 0x22U) && (Dev.Reg[0x00U] == 0x33U) && (Dev.Reg[0x01U] == 0x44U);
+
+  return Report("framing", ok, "address byte, read bit, chip select, no data");
+}
+
+/**
+  * @brief  Random reads and writes against a copy of the registers
+  * @retval true if passed
+  */
+static bool RoundTrip()
+{
+  std::mt19937 rng(62U);
+  uint8_t model[128];
+  uint8_t buf[256];
+  uint32_t bytes = 0;
+  const uint32_t n = 100000U;
+  bool ok = true;
+
+  ResetBus();
+  for (uint32_t i = 0; i < 128U; i++)
+  {
+    Dev.Reg[i] = (uint8_t)rng();
+    model[i] = Dev.Reg[i];
+  }
+
+  for (uint32_t k = 0; ok && (k < n); k++)
+  {
+    uint8_t reg = (uint8_t)(rng() % 128U);
+    uint16_t len = (uint16_t)((rng() % 8U == 0U) ? (rng() % 257U) : (rng() % 8U));
+
+    if (rng() % 2U)
+    {
+      for (uint32_t i = 0; i < len; i++)
+      {
+        buf[i] = (uint8_t)rng();
+        model[(reg + i) & 0x7FU] = buf[i];
+      }
+      ok &= (SPI_REG_Write(&Port, reg, buf, len) == SPI_REG_OK);
+    }
+    else
+    {
+      std::memset(buf, 0xA5, sizeof(buf));
+      ok &= (SPI_REG_Read(&Port, reg, buf, len) == SPI_REG_OK);
+      for (uint32_t i = 0; i < len; i++)
+      {
+        ok &= (buf[i] == model[(reg + i) & 0x7FU]);
+      }
+      /* Nothing written past Len */
+      ok &= (len == 256U) || (buf[len] == 0xA5U);
+    }
+    bytes += len;
+  }
+  ok &= (std::memcmp(Dev.Reg, model, sizeof(model)) == 0) && (Dev.Selects == n) && (Dev.Releases == n)
+        && (Dev.Unselected == 0U) && (Dev.TxNonZero == 0U);
+
+  char detail[80];
+  std::snprintf(detail, sizeof(detail), "%u transactions, %u data bytes", n, bytes);
+  return Report("round trip", ok, detail);
+}
+
+/**
+  * @brief  Check failures and bad arguments
+  * @retval true if passed
+  */
+static bool Errors()
+{
+  const SPI_REG_Port_t noSelect = { &Dev, nullptr, Exchange };
+  const SPI_REG_Port_t noExchange = { &Dev, Select, nullptr };
+  uint8_t data[8] = { 1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U };
+  bool ok = true;
+
+  /* A failure at the address byte or at the data, for reads and writes */
+  for (int32_t at = 0; at < 2; at++)
+  {
+    ResetBus();
+    std::memset(Dev.Reg, 0, sizeof(Dev.Reg));
+    Dev.FailAt = at;
+    ok &= (SPI_REG_Write(&Port, 0x20U, data, 8U) == SPI_REG_ERROR) && !Dev.Selected && (Dev.Releases == 1U)
+          && (Dev.Exchanges == (uint32_t)at) && (Dev.Reg[0x20U] == 0U);
+    ResetBus();
+    Dev.FailAt = at;
+    ok &= (SPI_REG_Read(&Port, 0x20U, data, 8U) == SPI_REG_ERROR) && !Dev.Selected && (Dev.Releases == 1U)
+          && (Dev.Exchanges == (uint32_t)at);
+    /* The next transaction is framed from its own address byte */
+    ok &= (SPI_REG_Write(&Port, 0x30U, data, 1U) == SPI_REG_OK) && (Dev.Cmds.back() == 0x30U);
+  }
+
+  /* Bad arguments never touch the bus */
+  ResetBus();
+  ok &= (SPI_REG_Read(nullptr, 0U, data, 1U) == SPI_REG_ERROR) && (SPI_REG_Write(nullptr, 0U, data, 1U) == SPI_REG_ERROR)
+        && (SPI_REG_Read(&Port, 0U, nullptr, 1U) == SPI_REG_ERROR)
+        && (SPI_REG_Write(&Port, 0U, nullptr, 1U) == SPI_REG_ERROR)
+        && (SPI_REG_Read(&noSelect, 0U, data, 1U) == SPI_REG_ERROR)
+        && (SPI_REG_Write(&noExchange, 0U, data, 1U) == SPI_REG_ERROR);
+  ok &= (Dev.Selects == 0U) && (Dev.Releases == 0U) && (Dev.Exchanges == 0U);
+
+  return Report("errors", ok, "failing address or data exchange, NULL arguments");
+}
+
+int main()
+{
+  bool ok = true;
+
+  ok &= Framing();
+  ok &= RoundTrip();
+  ok &= Errors();
+
+  /* Framing cost of a 2 byte read, without the device */
+  static const SPI_REG_Port_t nullPort = {
+    nullptr, [](void *, uint8_t) {}, [](void *, const uint8_t *, uint8_t *, uint16_t) -> int32_t { return 0; }
+  };
+  uint8_t data[2];
+  double best = 1e9;
+  for (int run = 0; run < 5; run++)
+  {
+    BenchClock::time_point t0 = BenchClock::now();
+    for (uint32_t i = 0; i < 1000000U; i++)
+    {
+      (void)SPI_REG_Read(&nullPort, (uint8_t)i, data, 2U);
+    }
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    best = std::fmin(best, ns / 1000000.0);
+  }
+  std::printf("register read framing  %.1f ns\n", best);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,600 @@
+/**
+  ******************************************************************************
+  * @file    startup_seq_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the startup sequencer on a simulated clock
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "startup_seq.h"
+
+/*
+ * Runs the firmware startup_seq.c on a host. Each clock read takes one
+ * tick and a step start takes its own cost, so a sweep over the steps has
+ * a known bound. The steps are scripted:
+ *
+ *  - main.c table: the six steps of SHUBv3_MLC main.c with scripted waits,
+ *    a failed optional self-test and a boot timeout,
+ *  - random tables: dependencies, waits, costs, outcomes and optional
+ *    flags drawn at random, against a reference model of the statuses.
+ *    Each step starts within a sweep of its last dependency, runs its
+ *    callbacks in order, and the sequence ends within a sweep per level
+ *    of the critical path, so the waits overlap,
+ *  - limits: no steps, 32 steps, 33 steps, a clock wrapping at 2^32,
+ *  - bad tables: a dependency past the table, on itself or through a
+ *    cycle, and a poll without a timeout, all refused before any runs.
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+enum Outcome
+{
+  OUT_START_DONE,     /* Start returns done */
+  OUT_START_ERROR,    /* Start fails */
+  OUT_POLL_DONE,      /* Poll returns done once Wait elapsed */
+  OUT_POLL_ERROR,     /* Poll fails once Wait elapsed */
+  OUT_HANG            /* Poll stays pending, the timeout ends it */
+};
+
+struct Script
+{
+  Outcome Out;
+  uint32_t Wait;
+  uint32_t Cost;      /* Ticks taken by Start */
+  bool HasStart;
+  bool HasPoll;
+  /* What the callbacks saw */
+  uint32_t Starts;
+  uint32_t Polls;
+  uint32_t LastElapsed;
+  bool PollAfterEnd;
+  bool BadElapsed;
+};
+
+static uint32_t Now;
+static uint32_t Reads;
+static Script Scripts[STARTUP_MAX_STEPS + 1U];
+static STARTUP_Record_t *CurrentRecords;
+
+/**
+  * @brief  Sequencer clock, one tick per read
+  * @retval The simulated time
+  */
+static uint32_t Clock(void)
+{
+  Reads++;
+  return Now++;
+}
+
+/**
+  * @brief  Scripted step start
+  * @retval The scripted status
+  */
+template <uint32_t I>
+static int32_t Start(void)
+{
+  Script &s = Scripts[I];
+
+  s.Starts++;
+  Now += s.Cost;
+  switch (s.Out)
+  {
+    case OUT_START_DONE:
+      return STARTUP_DONE;
+    case OUT_START_ERROR:
+      return STARTUP_ERROR;
+    default:
+      return STARTUP_PENDING;
+  }
+}
+
+/**
+  * @brief  Scripted step poll
+  * @param  Elapsed the time since the step started
+  * @retval The scripted status
+  */
+template <uint32_t I>
+static int32_t Poll(uint32_t Elapsed)
+{
+  Script &s = Scripts[I];
+
+  s.Polls++;
+  s.PollAfterEnd |= (CurrentRecords[I].Status != STARTUP_NOT_RUN);
+  s.BadElapsed |= (Elapsed < s.LastElapsed) || ((Now - 1U - CurrentRecords[I].Start) != Elapsed);
+  s.LastElapsed = Elapsed;
+  if ((s.Out == OUT_HANG) || (Elapsed < s.Wait))
+  {
+    return STARTUP_PENDING;
+  }
+  return (s.Out == OUT_POLL_DONE) ? STARTUP_DONE : STARTUP_ERROR;
+}
+
+template <uint32_t... I>
+static constexpr std::pair<int32_t (*)(void), int32_t (*)(uint32_t)> Callback(uint32_t N,
+                                                                              std::integer_sequence<uint32_t, I...>)
+{
+  constexpr int32_t (*starts[])(void) = { Start<I>... };
+  constexpr int32_t (*polls[])(uint32_t) = { Poll<I>... };
+  return { starts[N], polls[N] };
+}
+
+/**
+  * @brief  Fill a step from its script
+  * @param  Step the step
+  * @param  Index the step index
+  * @param  Depends the dependencies
+  * @param  Timeout the timeout
+  * @param  Optional the optional flag
+  * @retval None
+  */
+static void MakeStep(STARTUP_Step_t *Step, uint32_t Index, uint32_t Depends, uint32_t Timeout, bool Optional)
+{
+  auto cb = Callback(Index, std::make_integer_sequence<uint32_t, STARTUP_MAX_STEPS + 1U>());
+  Script &s = Scripts[Index];
+
+  Step->Name = "step";
+  Step->Start = s.HasStart ? cb.first : nullptr;
+  Step->Poll = s.HasPoll ? cb.second : nullptr;
+  Step->Depends = Depends;
+  Step->Timeout = Timeout;
+  Step->Optional = Optional ? 1U : 0U;
+}
+
+/**
+  * @brief  Print a check
+  * @param  Name the check
+  * @param  Pass the result
+  * @param  Detail printed after the name
+  * @retval Pass
+  */
+static bool Report(const char *Name, bool Pass, const std::string &Detail = "")
+{
+  std::printf("%-22s %-50s %s\n", Name, Detail.c_str(), Pass ? "ok" : "FAILED");
+  return Pass;
+}
+
+/**
+  * @brief  Run a table
+  * @param  Steps the steps
+  * @param  Count the number of steps
+  * @param  Records the records
+  * @param  From the clock at start
+  * @retval The sequencer result
+  */
+static int32_t Run(const STARTUP_Step_t *Steps, uint32_t Count, STARTUP_Record_t *Records, uint32_t From)
+{
+  for (Script &s : Scripts)
+  {
+    s.Starts = 0;
+    s.Polls = 0;
+    s.LastElapsed = 0;
+    s.PollAfterEnd = false;
+    s.BadElapsed = false;
+  }
+  CurrentRecords = Records;
+  Now = From;
+  Reads = 0;
+  return STARTUP_Run(Steps, Count, Records, Clock);
+}
+
+/**
+  * @brief  Run the shape of the SHUBv3_MLC main.c table
+  * @retval true if passed
+  */
+static bool MainTable()
+{
+  enum { POWER, UPLINK, BOOT, SELF_TEST, RESET, MLC, NBR };
+  const uint32_t timeout[NBR] = { 0U, 0U, 100U, 1000U, 50U, 0U };
+  const uint32_t depends[NBR] = { 0U, 0U, STARTUP_DEP(POWER), STARTUP_DEP(BOOT), STARTUP_DEP(SELF_TEST),
+                                  STARTUP_DEP(RESET) };
+  STARTUP_Step_t steps[NBR];
+  STARTUP_Record_t rec[NBR];
+  bool ok = true;
+  std::string detail;
+
+  /* Power and uplink start at once, the boot wait of 20 overlaps the rest */
+  Scripts[POWER] = { OUT_START_DONE, 0U, 3U, true, false };
+  Scripts[UPLINK] = { OUT_START_DONE, 0U, 40U, true, false };
+  Scripts[BOOT] = { OUT_POLL_DONE, 20U, 0U, false, true };
+  Scripts[SELF_TEST] = { OUT_POLL_DONE, 200U, 1U, true, true };
+  Scripts[RESET] = { OUT_POLL_DONE, 5U, 1U, true, true };
+  Scripts[MLC] = { OUT_START_DONE, 0U, 30U, true, false };
+  for (uint32_t i = 0; i < NBR; i++)
+  {
+    MakeStep(&steps[i], i, depends[i], timeout[i], i == SELF_TEST);
+  }
+  ok &= (Run(steps, NBR, rec, 0U) == STARTUP_DONE);
+  for (uint32_t i = 0; i < NBR; i++)
+  {
+    ok &= (rec[i].Status == STARTUP_DONE);
+  }
+  /* Boot starts as soon as the uplink start returns, in the same sweep */
+  ok &= (rec[BOOT].Start == (rec[UPLINK].End + 1U))
+        && (rec[BOOT].End >= rec[BOOT].Start + 20U) && (rec[MLC].End <= 20U + 200U + 5U + 30U + 3U + 40U + 20U);
+  detail = "done in " + std::to_string(rec[MLC].End) + " ticks";
+
+  /* A failed self-test is optional, reset and mlc still run */
+  Scripts[SELF_TEST].Out = OUT_POLL_ERROR;
+  ok &= (Run(steps, NBR, rec, 0U) == STARTUP_DONE) && (rec[SELF_TEST].Status == STARTUP_ERROR)
+        && (rec[RESET].Status == STARTUP_DONE) && (rec[MLC].Status == STARTUP_DONE);
+
+  /* A boot timeout skips what follows, through the optional self-test. The
+     uplink is not affected */
+  Scripts[BOOT].Out = OUT_HANG;
+  ok &= (Run(steps, NBR, rec, 0U) == STARTUP_ERROR) && (rec[BOOT].Status == STARTUP_TIMEOUT)
+        && (rec[BOOT].End - rec[BOOT].Start >= 100U) && (rec[BOOT].End - rec[BOOT].Start <= 100U + 10U)
+        && (rec[SELF_TEST].Status == STARTUP_SKIPPED) && (rec[RESET].Status == STARTUP_SKIPPED)
+        && (rec[MLC].Status == STARTUP_SKIPPED) && (rec[UPLINK].Status == STARTUP_DONE)
+        && (Scripts[SELF_TEST].Starts == 0U) && (Scripts[RESET].Starts == 0U) && (Scripts[MLC].Starts == 0U);
+
+  return Report("main.c table", ok, detail + ", self-test failure, boot timeout");
+}
+
+/**
+  * @brief  Run random tables against a reference model
+  * @param  Tables the number of tables
+  * @param  From the clock at start
+  * @retval true if passed
+  */
+static bool RandomTables(uint32_t Tables, uint32_t From)
+{
+  std::mt19937 rng(60U + From);
+  STARTUP_Step_t steps[STARTUP_MAX_STEPS];
+  STARTUP_Record_t rec[STARTUP_MAX_STEPS];
+  uint32_t statuses[5] = { 0 };   /* done, error, timeout, skipped, optional failures */
+  uint64_t sumWaits = 0;
+  uint64_t sumTotal = 0;
+  bool ok = true;
+
+  for (uint32_t t = 0; ok && (t < Tables); t++)
+  {
+    uint32_t count = 1U + (rng() % STARTUP_MAX_STEPS);
+    uint32_t order[STARTUP_MAX_STEPS];
+    uint32_t rank[STARTUP_MAX_STEPS];
+    uint32_t depends[STARTUP_MAX_STEPS] = { 0 };
+    uint32_t timeout[STARTUP_MAX_STEPS] = { 0 };
+    bool optional[STARTUP_MAX_STEPS];
+    int32_t expect[STARTUP_MAX_STEPS];
+
+    /* Dependencies follow a random order, so the table is acyclic but not
+       sorted */
+    for (uint32_t i = 0; i < count; i++)
+    {
+      order[i] = i;
+    }
+    std::shuffle(order, order + count, rng);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      rank[order[i]] = i;
+    }
+
+    uint32_t costs = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+      Script &s = Scripts[i];
+      uint32_t r = rng() % 32U;
+
+      s = {};
+      s.Out = (r < 8U) ? OUT_START_DONE : (r < 9U) ? OUT_START_ERROR : (r < 30U) ? OUT_POLL_DONE
+            : (r < 31U) ? OUT_POLL_ERROR : OUT_HANG;
+      s.Wait = (rng() % 4U == 0U) ? 0U : (rng() % 500U);
+      s.Cost = rng() % 8U;
+      s.HasStart = (s.Out == OUT_START_DONE) || (s.Out == OUT_START_ERROR) || (rng() % 2U == 0U);
+      s.HasPoll = (s.Out >= OUT_POLL_DONE) || (rng() % 2U == 0U);
+      costs += s.Cost;
+      if ((s.Out == OUT_HANG) || (rng() % 2U == 0U))
+      {
+        /* Never before a done poll, or the status would depend on the sweep */
+        timeout[i] = (s.Out >= OUT_POLL_DONE) ? (s.Wait + (rng() % 3U)) : (1U + (rng() % 100U));
+        timeout[i] = std::max(timeout[i], 1U);
+      }
+      if (s.HasPoll && (timeout[i] == 0U))
+      {
+        /* A polled step needs a timeout, this one is never reached */
+        timeout[i] = s.Wait + 1U + (rng() % 100U);
+      }
+      optional[i] = (rng() % 4U == 0U);
+      for (uint32_t j = 0; j < count; j++)
+      {
+        if ((rank[j] < rank[i]) && (rng() % std::max(rank[i], 1U) < 2U))
+        {
+          depends[i] |= STARTUP_DEP(j);
+        }
+      }
+      if ((s.Out == OUT_START_DONE) && s.HasPoll)
+      {
+        s.Out = OUT_POLL_DONE;
+        s.Wait = 0U;
+      }
+      MakeStep(&steps[i], i, depends[i], timeout[i], optional[i]);
+    }
+
+    /* Reference: statuses in dependency order, and the earliest end of
+       each step counting only its waits */
+    bool allDone = true;
+    uint32_t earliest[STARTUP_MAX_STEPS];
+    uint32_t level[STARTUP_MAX_STEPS];
+    uint32_t path = 0;
+    uint32_t levels = 0;
+    for (uint32_t k = 0; k < count; k++)
+    {
+      uint32_t i = order[k];
+      bool skip = false;
+      earliest[i] = 0;
+      level[i] = 1;
+      for (uint32_t j = 0; j < count; j++)
+      {
+        if ((depends[i] & STARTUP_DEP(j)) != 0U)
+        {
+          skip |= (expect[j] != STARTUP_DONE) && (!optional[j] || (expect[j] == STARTUP_SKIPPED));
+          earliest[i] = std::max(earliest[i], earliest[j]);
+          level[i] = std::max(level[i], level[j] + 1U);
+        }
+      }
+      switch (Scripts[i].Out)
+      {
+        case OUT_START_DONE:
+          expect[i] = STARTUP_DONE;
+          break;
+        case OUT_START_ERROR:
+          expect[i] = STARTUP_ERROR;
+          break;
+        case OUT_POLL_DONE:
+          expect[i] = STARTUP_DONE;
+          earliest[i] += Scripts[i].HasPoll ? Scripts[i].Wait : 0U;
+          break;
+        case OUT_POLL_ERROR:
+          expect[i] = Scripts[i].HasPoll ? STARTUP_ERROR : STARTUP_DONE;
+          earliest[i] += Scripts[i].HasPoll ? Scripts[i].Wait : 0U;
+          break;
+        default:
+          expect[i] = Scripts[i].HasPoll ? STARTUP_TIMEOUT : STARTUP_DONE;
+          earliest[i] += Scripts[i].HasPoll ? timeout[i] : 0U;
+          break;
+      }
+      if (skip)
+      {
+        expect[i] = STARTUP_SKIPPED;
+        earliest[i] = 0;
+      }
+      allDone &= (expect[i] == STARTUP_DONE) || optional[i];
+      path = std::max(path, earliest[i]);
+      levels = std::max(levels, level[i]);
+    }
+
+    int32_t ret = Run(steps, count, rec, From);
+    ok &= (ret == (allDone ? STARTUP_DONE : STARTUP_ERROR));
+
+    /* A sweep reads the clock twice per step and runs the starts */
+    uint32_t sweep = (2U * count) + costs;
+    uint32_t end = From;
+    for (uint32_t i = 0; i < count; i++)
+    {
+      const Script &s = Scripts[i];
+      uint32_t deps = From;
+      uint32_t fail = 0xFFFFFFFFU;
+      bool started = (expect[i] != STARTUP_SKIPPED);
+
+      /* A step starts after its last dependency, or is skipped after its
+         first failed one */
+      for (uint32_t j = 0; j < count; j++)
+      {
+        if ((depends[i] & STARTUP_DEP(j)) != 0U)
+        {
+          deps = std::max(deps - From, rec[j].End - From) + From;
+          if ((expect[j] != STARTUP_DONE) && (!optional[j] || (expect[j] == STARTUP_SKIPPED)))
+          {
+            fail = std::min(fail, rec[j].End - From);
+          }
+        }
+      }
+      if (!started)
+      {
+        deps = fail + From;
+      }
+      ok &= (rec[i].Status == expect[i]) && ((rec[i].Start - From) >= (deps - From))
+            && ((rec[i].Start - deps) <= sweep) && ((rec[i].End - From) >= (rec[i].Start - From))
+            && (s.Starts == ((started && s.HasStart) ? 1U : 0U)) && !s.PollAfterEnd && !s.BadElapsed
+            && (started || (rec[i].End == rec[i].Start));
+      if (started && s.HasPoll && (s.Out >= OUT_POLL_DONE))
+      {
+        uint32_t wait = (s.Out == OUT_HANG) ? timeout[i] : s.Wait;
+        ok &= ((rec[i].End - rec[i].Start) >= wait) && ((rec[i].End - rec[i].Start) <= (wait + sweep));
+      }
+      end = std::max(end - From, rec[i].End - From) + From;
+      statuses[(rec[i].Status == STARTUP_DONE) ? 0 : (rec[i].Status == STARTUP_ERROR) ? 1
+               : (rec[i].Status == STARTUP_TIMEOUT) ? 2 : 3]++;
+      statuses[4] += (optional[i] && (rec[i].Status != STARTUP_DONE)) ? 1U : 0U;
+      if (started && s.HasPoll && (s.Out >= OUT_POLL_DONE))
+      {
+        sumWaits += (s.Out == OUT_HANG) ? timeout[i] : s.Wait;
+      }
+    }
+
+    /* The waits overlap: the critical path plus a sweep per level */
+    ok &= ((end - From) <= (path + ((levels + 1U) * sweep)));
+    sumTotal += end - From;
+  }
+
+  char detail[96];
+  std::snprintf(detail, sizeof(detail), "%u tables, %u done %u error %u timeout %u skipped", Tables, statuses[0],
+                statuses[1], statuses[2], statuses[3]);
+  bool pass = Report((From == 0U) ? "random tables" : "random tables, wrap", ok, detail);
+  if (From == 0U)
+  {
+    std::printf("  waits add up to %.0f ticks per table, the tables take %.0f\n", (double)sumWaits / Tables,
+                (double)sumTotal / Tables);
+  }
+  return pass;
+}
+
+/**
+  * @brief  Check the table sizes
+  * @retval true if passed
+  */
+static bool Limits()
+{
+  STARTUP_Step_t steps[STARTUP_MAX_STEPS + 1U];
+  STARTUP_Record_t rec[STARTUP_MAX_STEPS + 1U];
+  bool ok = true;
+
+  /* No step: nothing to do */
+  ok &= (Run(steps, 0U, rec, 0U) == STARTUP_DONE) && (Reads == 0U);
+
+  /* 32 steps, each on the previous one, listed backwards: one start per
+     sweep, the mask covers bit 31 */
+  for (uint32_t i = 0; i < STARTUP_MAX_STEPS; i++)
+  {
+    Scripts[i] = { OUT_START_DONE, 0U, 0U, true, false };
+    MakeStep(&steps[i], i, (i == (STARTUP_MAX_STEPS - 1U)) ? 0U : STARTUP_DEP(i + 1U), 0U, false);
+  }
+  ok &= (Run(steps, STARTUP_MAX_STEPS, rec, 0U) == STARTUP_DONE);
+  for (uint32_t i = 0; i + 1U < STARTUP_MAX_STEPS; i++)
+  {
+    ok &= (rec[i].Status == STARTUP_DONE) && (rec[i].Start > rec[i + 1U].End);
+  }
+
+  /* A failure at the far end skips the 31 others */
+  Scripts[STARTUP_MAX_STEPS - 1U].Out = OUT_START_ERROR;
+  ok &= (Run(steps, STARTUP_MAX_STEPS, rec, 0U) == STARTUP_ERROR)
+        && (std::count_if(rec, rec + STARTUP_MAX_STEPS, [](const STARTUP_Record_t &R)
+                          { return R.Status == STARTUP_SKIPPED; }) == (STARTUP_MAX_STEPS - 1));
+
+  /* One step too many is refused before any runs */
+  Scripts[STARTUP_MAX_STEPS] = { OUT_START_DONE, 0U, 0U, true, false };
+  MakeStep(&steps[STARTUP_MAX_STEPS], STARTUP_MAX_STEPS, 0U, 0U, false);
+  ok &= (Run(steps, STARTUP_MAX_STEPS + 1U, rec, 0U) == STARTUP_ERROR) && (Reads == 0U)
+        && (Scripts[STARTUP_MAX_STEPS - 1U].Starts == 0U);
+
+  return Report("limits", ok, "0, 32 and 33 steps");
+}
+
+/**
+  * @brief  Run a table that must be refused
+  * @param  Steps the steps
+  * @param  Count the number of steps
+  * @retval true if refused before any step ran
+  */
+static bool Refused(const STARTUP_Step_t *Steps, uint32_t Count)
+{
+  STARTUP_Record_t rec[STARTUP_MAX_STEPS];
+  bool ok = (Run(Steps, Count, rec, 0U) == STARTUP_ERROR) && (Reads == 0U);
+
+  for (uint32_t i = 0; i < Count; i++)
+  {
+    ok &= (Scripts[i].Starts == 0U) && (Scripts[i].Polls == 0U) && (rec[i].Status == STARTUP_NOT_RUN);
+  }
+  return ok;
+}
+
+/**
+  * @brief  Check the tables that could never finish
+  * @retval true if passed
+  */
+static bool BadTables()
+{
+  STARTUP_Step_t steps[STARTUP_MAX_STEPS];
+  STARTUP_Record_t rec[STARTUP_MAX_STEPS];
+  bool ok = true;
+
+  /* A valid chain of 4 to break */
+  auto chain = [&steps]()
+  {
+    for (uint32_t i = 0; i < 4U; i++)
+    {
+      Scripts[i] = { OUT_POLL_DONE, 3U, 0U, true, true };
+      MakeStep(&steps[i], i, (i == 0U) ? 0U : STARTUP_DEP(i - 1U), 10U, false);
+    }
+  };
+  chain();
+  ok &= (Run(steps, 4U, rec, 0U) == STARTUP_DONE);
+
+  /* A dependency past the table, just past it and at bit 31 */
+  chain();
+  steps[2].Depends |= STARTUP_DEP(4U);
+  ok &= Refused(steps, 4U);
+  chain();
+  steps[0].Depends = STARTUP_DEP(31U);
+  ok &= Refused(steps, 4U);
+
+  /* A step on itself */
+  chain();
+  steps[3].Depends |= STARTUP_DEP(3U);
+  ok &= Refused(steps, 4U);
+
+  /* A cycle of two, and a cycle of three behind a valid step */
+  chain();
+  steps[1].Depends = STARTUP_DEP(2U);
+  steps[2].Depends = STARTUP_DEP(1U);
+  ok &= Refused(steps, 4U);
+  chain();
+  steps[1].Depends = STARTUP_DEP(0U) | STARTUP_DEP(3U);
+  ok &= Refused(steps, 4U);
+
+  /* A polled step without a timeout, and the same step without Poll */
+  chain();
+  steps[2].Timeout = 0U;
+  ok &= Refused(steps, 4U);
+  steps[2].Poll = nullptr;
+  ok &= (Run(steps, 4U, rec, 0U) == STARTUP_DONE);
+
+  /* A ring through all 32 steps */
+  for (uint32_t i = 0; i < STARTUP_MAX_STEPS; i++)
+  {
+    Scripts[i] = { OUT_START_DONE, 0U, 0U, true, false };
+    MakeStep(&steps[i], i, STARTUP_DEP((i + 1U) % STARTUP_MAX_STEPS), 0U, false);
+  }
+  ok &= Refused(steps, STARTUP_MAX_STEPS);
+
+  return Report("bad tables", ok, "past the table, self, cycles, no timeout");
+}
+
+int main()
+{
+  bool ok = true;
+
+  ok &= MainTable();
+  ok &= RandomTables(20000U, 0U);
+  ok &= RandomTables(20000U, 0xFFFFFF00U);
+  ok &= Limits();
+  ok &= BadTables();
+
+  /* Cost of a sweep over 16 polled steps */
+  enum { N = 16, SWEEPS = 1000 };
+  STARTUP_Step_t steps[N];
+  STARTUP_Record_t rec[N];
+  for (uint32_t i = 0; i < N; i++)
+  {
+    Scripts[i] = { OUT_POLL_DONE, (uint32_t)(2 * SWEEPS * N), 0U, false, true };
+    MakeStep(&steps[i], i, 0U, (uint32_t)(4 * SWEEPS * N), false);
+  }
+  double best = 1e9;
+  for (int run = 0; run < 5; run++)
+  {
+    BenchClock::time_point t0 = BenchClock::now();
+    (void)Run(steps, N, rec, 0U);
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    best = std::fmin(best, ns / Reads);
+  }
+  std::printf("step poll  %.1f ns\n", best);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,405 @@
+/**
+  ******************************************************************************
+  * @file    fx_codec_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the compact fusion stream against the host decoder
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "fusion_codec.h"
+#include "tmsg_stream.hpp"
+
+/*
+ * Builds streaming frames with the firmware encoder (fusion_codec.c) and
+ * the TMsg framing of serial_protocol.c, decodes them with tmsg::Decoder and
+ * checks every decoded fusion output against tmsg::Bounds. Values past the
+ * fixed point range saturate and are not checked. The compact frames follow
+ * a CMD_Stream_Format reply, as after the start of the stream. Also reports
+ * the frame size of each format on the wire.
+ */
+
+struct Worst
+{
+  double Quat = 0.0;        /* Largest error / bound */
+  double Angle = 0.0;
+  double Acc = 0.0;
+  double QuatAngle = 0.0;   /* [deg] */
+  uint64_t Samples = 0U;
+  uint64_t WireBytes = 0U;
+};
+
+/**
+  * @brief  Checksum, byte stuffing and EOF, as UART_SendMsg
+  * @param  Data the message
+  * @param  Len the message length
+  * @param  Out the wire bytes are appended here
+  * @retval None
+  */
+static void Frame(std::vector<uint8_t> Data, size_t Len, std::vector<uint8_t> &Out)
+{
+  uint8_t chk = 0U;
+
+  for (size_t i = 0U; i < Len; i++)
+  {
+    chk = static_cast<uint8_t>(chk - Data[i]);
+  }
+  Data[Len] = chk;
+
+  for (size_t i = 0U; i <= Len; i++)
+  {
+    if (Data[i] == tmsg::kEof)
+    {
+      Out.push_back(tmsg::kBs);
+      Out.push_back(tmsg::kBsEof);
+    }
+    else if (Data[i] == tmsg::kBs)
+    {
+      Out.push_back(tmsg::kBs);
+      Out.push_back(tmsg::kBs);
+    }
+    else
+    {
+      Out.push_back(Data[i]);
+    }
+  }
+  Out.push_back(tmsg::kEof);
+}
+
+/**
+  * @brief  CMD_Stream_Format reply, as Send_Stream_Format in demo_serial.c
+  * @param  Config the format
+  * @param  Out the wire bytes are appended here
+  * @retval None
+  */
+static void FormatReply(const FUSION_CODEC_Config_t &Config, std::vector<uint8_t> &Out)
+{
+  std::vector<uint8_t> msg = { 1U, 50U, tmsg::kCmdStreamFormat | tmsg::kCmdReply, Config.Format, Config.AngleFrac,
+                               Config.AccFrac, 0U };
+
+  Frame(msg, tmsg::kFormatReply, Out);
+}
+
+/**
+  * @brief  Compact streaming frame with random sensor bytes
+  * @param  Config the format
+  * @param  Output the fusion outputs, nullptr for the idle block
+  * @param  Rng the generator
+  * @param  Out the wire bytes are appended here
+  * @retval None
+  */
+static void CompactFrame(const FUSION_CODEC_Config_t &Config, const MFX_output_t *Output, std::mt19937 &Rng,
+                         std::vector<uint8_t> &Out)
+{
+  std::vector<uint8_t> msg(tmsg::kStreamLengthCompact + 1U, 0U);
+
+  msg[2] = tmsg::kCmdStartDataStreaming;
+  for (size_t i = 3U; i < tmsg::kFxOffset; i++)
+  {
+    msg[i] = static_cast<uint8_t>(Rng());
+  }
+  (void)FUSION_CODEC_Encode(&Config, Output, &msg[tmsg::kFxOffset]);
+  Frame(msg, tmsg::kStreamLengthCompact, Out);
+}
+
+/**
+  * @brief  Random fusion output in the MotionFX ranges
+  * @param  Rng the generator
+  * @retval The output
+  */
+static MFX_output_t RandomOutput(std::mt19937 &Rng)
+{
+  std::normal_distribution<float> gauss(0.0F, 1.0F);
+  std::uniform_real_distribution<float> uni(0.0F, 1.0F);
+  MFX_output_t o = {};
+  float norm = 0.0F;
+
+  /* Uniform rotation, not normalized, either sign */
+  for (float &q : o.quaternion)
+  {
+    q = gauss(Rng);
+    norm += q * q;
+  }
+  for (float &q : o.quaternion)
+  {
+    q *= (0.9F + (0.2F * uni(Rng))) / std::sqrt(norm);
+  }
+
+  o.rotation[0] = 360.0F * uni(Rng);
+  o.rotation[1] = 360.0F * uni(Rng) - 180.0F;
+  o.rotation[2] = 180.0F * uni(Rng) - 90.0F;
+  for (size_t i = 0U; i < 3U; i++)
+  {
+    o.gravity[i] = 2.0F * uni(Rng) - 1.0F;
+    o.linear_acceleration[i] = 8.0F * uni(Rng) - 4.0F;
+  }
+  o.heading = 360.0F * uni(Rng);
+  o.headingErr = 30.0F * uni(Rng);
+
+  return o;
+}
+
+/**
+  * @brief  Error of a value over its bound
+  * @param  Sent the encoded value
+  * @param  Got the decoded value
+  * @param  Abs the absolute bound
+  * @param  Rel the relative bound
+  * @param  Range the largest value without saturation
+  * @retval Error / bound, above 1 is a failure, 0 past Range
+  */
+static double Ratio(float Sent, float Got, float Abs, float Rel, float Range)
+{
+  if (std::fabs(Sent) > Range)
+  {
+    return 0.0;
+  }
+
+  return std::fabs(static_cast<double>(Got) - Sent) / (Abs + (Rel * std::fabs(Sent)));
+}
+
+/**
+  * @brief  Encode, frame and decode samples in one format
+  * @param  Config the format
+  * @param  Count the number of samples
+  * @param  Seed the generator seed
+  * @param  Result the worst errors and the wire size
+  * @retval true if every sample decoded within the bounds
+  */
+static bool Check(const FUSION_CODEC_Config_t &Config, size_t Count, uint32_t Seed, Worst &Result)
+{
+  tmsg::FxBounds b = tmsg::Bounds(Config.Format, Config.AngleFrac, Config.AccFrac);
+  std::vector<MFX_output_t> sent;
+  std::vector<uint8_t> wire;
+  std::vector<tmsg::Sample> got;
+  std::mt19937 rng(Seed);
+  tmsg::Decoder decoder;
+  bool compact = (Config.Format != FUSION_CODEC_FLOAT);
+  size_t len = compact ? tmsg::kStreamLengthCompact : tmsg::kStreamLength;
+
+  for (size_t n = 0U; n < Count; n++)
+  {
+    std::vector<uint8_t> msg(tmsg::kStreamLengthMlc + 1U, 0U);
+    MFX_output_t o = RandomOutput(rng);
+
+    msg[0] = 1U;
+    msg[1] = 50U;
+    msg[2] = tmsg::kCmdStartDataStreaming;
+    for (size_t i = 3U; i < tmsg::kFxOffset; i++)
+    {
+      msg[i] = static_cast<uint8_t>(rng());
+    }
+
+    if (compact)
+    {
+      if (FUSION_CODEC_Encode(&Config, &o, &msg[tmsg::kFxOffset]) != tmsg::kFxSize)
+      {
+        std::printf("encoder rejected the configuration\n");
+        return false;
+      }
+    }
+    else
+    {
+      std::memcpy(&msg[55], o.quaternion, sizeof(o.quaternion));
+      std::memcpy(&msg[71], o.rotation, sizeof(o.rotation));
+      std::memcpy(&msg[83], o.gravity, sizeof(o.gravity));
+      std::memcpy(&msg[95], o.linear_acceleration, sizeof(o.linear_acceleration));
+      std::memcpy(&msg[107], &o.heading, sizeof(float));
+      std::memcpy(&msg[111], &o.headingErr, sizeof(float));
+    }
+
+    Frame(msg, len, wire);
+    sent.push_back(o);
+  }
+
+  if (compact)
+  {
+    std::vector<uint8_t> reply;
+
+    FormatReply(Config, reply);
+    decoder.Feed(reply.data(), reply.size(), got);
+  }
+  decoder.Feed(wire.data(), wire.size(), got);
+  Result.WireBytes = wire.size();
+  Result.Samples = got.size();
+
+  if (got.size() != sent.size())
+  {
+    std::printf("decoded %zu of %zu frames\n", got.size(), sent.size());
+    return false;
+  }
+
+  for (size_t n = 0U; compact && (n < sent.size()); n++)
+  {
+    const MFX_output_t &o = sent[n];
+    const tmsg::Sample &s = got[n];
+    const float *q = o.quaternion;
+    size_t largest = static_cast<size_t>(std::max_element(q, q + 4, [](float A, float B)
+    {
+      return std::fabs(A) < std::fabs(B);
+    }) - q);
+    double norm = std::sqrt((q[0] * q[0]) + (q[1] * q[1]) + (q[2] * q[2]) + (q[3] * q[3]));
+    double sign = (q[largest] < 0.0F) ? -1.0 : 1.0;
+    double chord = 0.0;
+
+    for (size_t i = 0U; i < 4U; i++)
+    {
+      double diff = s.Quat[i] - (sign * q[i] / norm);
+      Result.Quat = std::max(Result.Quat, std::fabs(diff) / b.Quat);
+      chord += diff * diff;
+    }
+
+    /* Unit quaternions at chord c are 2 asin(c / 2) apart, twice that as a rotation */
+    Result.QuatAngle = std::max(Result.QuatAngle, 4.0 * std::asin(std::sqrt(chord) / 2.0) * 180.0 / M_PI);
+
+    for (size_t i = 0U; i < 3U; i++)
+    {
+      Result.Angle = std::max(Result.Angle, Ratio(o.rotation[i], s.Rotation[i], b.AngleAbs, b.AngleRel, b.AngleRange));
+      Result.Acc = std::max(Result.Acc, Ratio(o.gravity[i], s.Gravity[i], b.AccAbs, b.AccRel, b.AccRange));
+      Result.Acc = std::max(Result.Acc, Ratio(o.linear_acceleration[i], s.LinAcc[i], b.AccAbs, b.AccRel, b.AccRange));
+    }
+    Result.Angle = std::max(Result.Angle, Ratio(o.heading, s.Heading, b.AngleAbs, b.AngleRel, b.AngleRange));
+    Result.Angle = std::max(Result.Angle, Ratio(o.headingErr, s.HeadingErr, b.AngleAbs, b.AngleRel, b.AngleRange));
+  }
+
+  return !compact || ((Result.Quat <= 1.0) && (Result.Angle <= 1.0) && (Result.Acc <= 1.0)
+                      && (Result.QuatAngle <= (b.QuatAngle + 1e-3)));
+}
+
+/**
+  * @brief  Check a compact frame sent while the fusion does not run, with
+  *         the MLC bytes
+  * @retval true if it decodes to the identity and zeros
+  */
+static bool CheckIdle(void)
+{
+  FUSION_CODEC_Config_t config = { FUSION_CODEC_FIXED, FUSION_CODEC_ANGLE_FRAC, FUSION_CODEC_ACC_FRAC };
+  std::vector<uint8_t> msg(tmsg::kStreamLengthCompactMlc + 1U, 0U);
+  std::vector<uint8_t> wire;
+  std::vector<tmsg::Sample> got;
+  tmsg::Decoder decoder;
+  float bound = tmsg::Bounds(config.Format, config.AngleFrac, config.AccFrac).Quat;
+  bool ok;
+
+  msg[2] = tmsg::kCmdStartDataStreaming;
+  (void)FUSION_CODEC_Encode(&config, nullptr, &msg[tmsg::kFxOffset]);
+  msg[tmsg::kStreamLengthCompact] = 0xF0U;
+  msg[tmsg::kStreamLengthCompact + 1U] = 7U;
+  FormatReply(config, wire);
+  Frame(msg, tmsg::kStreamLengthCompactMlc, wire);
+  decoder.Feed(wire.data(), wire.size(), got);
+
+  ok = (got.size() == 1U) && got[0].HasMlc && (got[0].MlcCode == 0xF0U) && (got[0].MlcEvents == 7U)
+       && (std::fabs(got[0].Quat[3] - 1.0F) <= bound) && (std::fabs(got[0].Quat[0]) <= bound)
+       && (got[0].Rotation[0] == 0.0F)
+       && (got[0].HeadingErr == 0.0F) && (got[0].AngleFrac == FUSION_CODEC_ANGLE_FRAC)
+       && (got[0].AccFrac == FUSION_CODEC_ACC_FRAC);
+  std::printf("fusion idle frame with MLC bytes: %s\n", ok ? "ok" : "FAIL");
+
+  return ok;
+}
+
+/**
+  * @brief  Check that the decoder follows the format replies
+  * @note   Compact frames before any reply are skipped, SetFormat stands in
+  *         for a missed reply, a reply in the stream switches the format
+  *         from the next frame on.
+  * @retval true if every frame decoded in the format it was sent in
+  */
+static bool CheckFormat(void)
+{
+  static const FUSION_CODEC_Config_t half = { FUSION_CODEC_HALF, 0U, 0U };
+  static const FUSION_CODEC_Config_t fixed = { FUSION_CODEC_FIXED, 4U, 10U };
+  std::vector<uint8_t> wire;
+  std::vector<tmsg::Sample> got;
+  std::mt19937 rng(2U);
+  MFX_output_t o = RandomOutput(rng);
+  tmsg::Decoder unknown;
+  tmsg::Decoder given;
+  tmsg::Decoder switched;
+  float bound = tmsg::Bounds(fixed.Format, fixed.AngleFrac, fixed.AccFrac).AngleAbs;
+  bool ok;
+
+  o.rotation[0] = 100.0F;
+
+  CompactFrame(half, &o, rng, wire);
+  unknown.Feed(wire.data(), wire.size(), got);
+  ok = got.empty() && (unknown.GetStats().NoFormat == 1U);
+
+  ok = ok && given.SetFormat(tmsg::kFxHalf, 0U, 0U) && !given.SetFormat(tmsg::kFxFixed, 16U, 0U);
+  given.Feed(wire.data(), wire.size(), got);
+  ok = ok && (got.size() == 1U) && (got[0].FxFormat == tmsg::kFxHalf) && (got[0].Rotation[0] == 100.0F);
+
+  /* half, then a reply for fixed 4/10 and a frame in it */
+  got.clear();
+  FormatReply(fixed, wire);
+  CompactFrame(fixed, &o, rng, wire);
+  switched.SetFormat(tmsg::kFxHalf, 0U, 0U);
+  switched.Feed(wire.data(), wire.size(), got);
+  ok = ok && (got.size() == 2U) && (switched.GetStats().Formats == 1U) && (got[0].FxFormat == tmsg::kFxHalf)
+       && (got[1].FxFormat == tmsg::kFxFixed) && (got[1].AngleFrac == 4U) && (got[1].AccFrac == 10U)
+       && (std::fabs(got[1].Rotation[0] - 100.0F) <= bound);
+
+  std::printf("format taken from the reply: %s\n", ok ? "ok" : "FAIL");
+
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  static const FUSION_CODEC_Config_t configs[] =
+  {
+    { FUSION_CODEC_FLOAT, 0U, 0U },
+    { FUSION_CODEC_HALF, 0U, 0U },
+    { FUSION_CODEC_FIXED, FUSION_CODEC_ANGLE_FRAC, FUSION_CODEC_ACC_FRAC },
+    { FUSION_CODEC_FIXED, 4U, 10U },
+    { FUSION_CODEC_FIXED, 7U, 13U },
+  };
+  size_t count = (argc > 1) ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 0)) : 200000U;
+  bool ok = true;
+
+  std::printf("%zu samples per format\n\n", count);
+  std::printf("format          frame  on wire  quat err  quat deg  angle err  acc err  result\n");
+
+  for (const FUSION_CODEC_Config_t &c : configs)
+  {
+    Worst w;
+    bool pass = Check(c, count, 1U, w);
+    char name[32];
+
+    if (c.Format == FUSION_CODEC_FIXED)
+    {
+      std::snprintf(name, sizeof(name), "fixed %u/%u", c.AngleFrac, c.AccFrac);
+    }
+    else
+    {
+      std::snprintf(name, sizeof(name), "%s", tmsg::FormatName(c.Format));
+    }
+    std::printf("%-14s  %5zu  %6.1f B  %8.3f  %8.5f  %9.3f  %7.3f  %s\n", name,
+                (c.Format == FUSION_CODEC_FLOAT) ? tmsg::kStreamLength : tmsg::kStreamLengthCompact,
+                static_cast<double>(w.WireBytes) / static_cast<double>(std::max<uint64_t>(w.Samples, 1U)), w.Quat,
+                w.QuatAngle, w.Angle, w.Acc, pass ? "ok" : "FAIL");
+    ok = ok && pass;
+  }
+
+  ok = ok && CheckIdle();
+  ok = ok && CheckFormat();
+
+  std::printf("\nerrors are the worst error over the tmsg::Bounds bound, ok up to 1\n");
+
+  return ok ? 0 : 1;
+}
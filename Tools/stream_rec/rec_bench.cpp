@@ -0,0 +1,304 @@
+/**
+  ******************************************************************************
+  * @file    rec_bench.cpp
+  * @author  ISCA Lab
+  * @brief   Compare a text log with a recording for scans and seeks
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "rec_reader.hpp"
+#include "rec_writer.hpp"
+
+/*
+ * Synthesizes a 100 Hz accelerometer/gyroscope/magnetometer/quaternion
+ * stream, writes it as a CSV text log and as a recording, then times:
+ *  - parsing the whole text log,
+ *  - summing one channel and all channels of the mapped recording,
+ *  - random row lookups through the chunk index.
+ * Both files are read right after being written, so the page cache is warm:
+ * the numbers compare parsing with zero-copy access, not disk speed.
+ */
+
+#define AXES_CHANNELS  9U  /* acc, gyr, mag */
+#define QUAT_CHANNELS  4U
+#define SEEKS          1000000U
+
+using BenchClock = std::chrono::steady_clock;
+
+/**
+  * @brief  Seconds since a start point
+  * @param  Start the start point
+  * @retval Seconds
+  */
+static double Elapsed(BenchClock::time_point Start)
+{
+  return std::chrono::duration<double>(BenchClock::now() - Start).count();
+}
+
+/**
+  * @brief  File size
+  * @param  Path the file
+  * @retval Bytes
+  */
+static double FileMb(const std::string &Path)
+{
+  struct stat st;
+
+  return (::stat(Path.c_str(), &st) == 0) ? (static_cast<double>(st.st_size) / 1e6) : 0.0;
+}
+
+/**
+  * @brief  Print one result line
+  * @param  Name the test
+  * @param  Seconds the run time
+  * @param  Mb the data read
+  * @param  Check the checksum, keeps the loop from being optimized out
+  * @retval None
+  */
+static void Report(const char *Name, double Seconds, double Mb, double Check)
+{
+  std::printf("%-22s %9.3f s %10.1f MB/s   check %.6g\n", Name, Seconds, (Seconds > 0.0) ? (Mb / Seconds) : 0.0,
+              Check);
+}
+
+/**
+  * @brief  Write the same synthetic stream in both formats
+  * @param  Rows the sample count
+  * @param  Csv the text log path
+  * @param  Rec the recording path
+  * @retval true in case of success, false otherwise
+  */
+static bool Generate(uint64_t Rows, const std::string &Csv, const std::string &Rec)
+{
+  static const char *names[AXES_CHANNELS] =
+  {
+    "acc_x", "acc_y", "acc_z", "gyr_x", "gyr_y", "gyr_z", "mag_x", "mag_y", "mag_z"
+  };
+  std::vector<rec::ChannelSpec> channels;
+  std::mt19937 rng(1U);
+  std::uniform_int_distribution<int32_t> noise(-2000, 2000);
+  rec::Writer writer;
+  std::FILE *csv;
+
+  for (const char *name : names)
+  {
+    channels.push_back({ name, rec::Type::I32, "", 1.0F });
+  }
+  for (uint32_t i = 0U; i < QUAT_CHANNELS; i++)
+  {
+    channels.push_back({ "quat_" + std::to_string(i), rec::Type::F32, "", 1.0F });
+  }
+
+  csv = std::fopen(Csv.c_str(), "w");
+  if ((csv == nullptr) || !writer.Open(Rec, channels, rec::kDefaultChunkRows, "rec_bench"))
+  {
+    return false;
+  }
+
+  std::fprintf(csv, "time");
+  for (const rec::ChannelSpec &ch : channels)
+  {
+    std::fprintf(csv, ",%s", ch.Name.c_str());
+  }
+  std::fprintf(csv, "\n");
+
+  for (uint64_t r = 0U; r < Rows; r++)
+  {
+    int64_t time = static_cast<int64_t>(r) * 10000;
+    uint32_t ch = 1U;
+
+    writer.BeginRow(time);
+    std::fprintf(csv, "%lld", static_cast<long long>(time));
+
+    for (uint32_t i = 0U; i < AXES_CHANNELS; i++)
+    {
+      int32_t v = noise(rng);
+      writer.Put(ch++, v);
+      std::fprintf(csv, ",%d", v);
+    }
+    for (uint32_t i = 0U; i < QUAT_CHANNELS; i++)
+    {
+      float v = static_cast<float>(noise(rng)) / 2000.0F;
+      writer.Put(ch++, v);
+      std::fprintf(csv, ",%.6f", static_cast<double>(v));
+    }
+
+    writer.EndRow();
+    std::fprintf(csv, "\n");
+  }
+
+  return (std::fclose(csv) == 0) && writer.Close();
+}
+
+/**
+  * @brief  Parse every field of the text log
+  * @param  Csv the text log path
+  * @param  Check the sum of acc_x
+  * @retval true in case of success, false otherwise
+  */
+static bool ParseCsv(const std::string &Csv, double &Check)
+{
+  std::FILE *in = std::fopen(Csv.c_str(), "r");
+  char line[512];
+  bool header = true;
+
+  if (in == nullptr)
+  {
+    return false;
+  }
+
+  Check = 0.0;
+  while (std::fgets(line, sizeof(line), in) != nullptr)
+  {
+    char *p = line;
+    double fields[1U + AXES_CHANNELS + QUAT_CHANNELS];
+
+    if (header)
+    {
+      header = false;
+      continue;
+    }
+
+    for (double &f : fields)
+    {
+      f = std::strtod(p, &p);
+      if (*p == ',')
+      {
+        p++;
+      }
+    }
+    Check += fields[1];
+  }
+
+  std::fclose(in);
+
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  uint64_t rows = 10000000U;
+  std::string dir = "/tmp";
+  std::string csv;
+  std::string rec_path;
+  rec::Reader reader;
+  BenchClock::time_point start;
+  double check;
+  double seconds;
+
+  for (int i = 1; i < argc; i++)
+  {
+    if ((std::strcmp(argv[i], "-n") == 0) && ((i + 1) < argc))
+    {
+      rows = std::strtoull(argv[++i], nullptr, 0);
+    }
+    else if ((std::strcmp(argv[i], "-d") == 0) && ((i + 1) < argc))
+    {
+      dir = argv[++i];
+    }
+    else
+    {
+      std::fprintf(stderr, "usage: rec_bench [-n rows] [-d dir]\n");
+      return 2;
+    }
+  }
+
+  csv = dir + "/rec_bench.csv";
+  rec_path = dir + "/rec_bench.rec";
+
+  start = BenchClock::now();
+  if (!Generate(rows, csv, rec_path))
+  {
+    std::fprintf(stderr, "cannot write to %s\n", dir.c_str());
+    return 1;
+  }
+  std::printf("%llu rows (%.1f h at 100 Hz), generated in %.3f s\n", static_cast<unsigned long long>(rows),
+              static_cast<double>(rows) / 360000.0, Elapsed(start));
+  std::printf("text log  %10.1f MB\nrecording %10.1f MB\n\n", FileMb(csv), FileMb(rec_path));
+
+  start = BenchClock::now();
+  if (!ParseCsv(csv, check))
+  {
+    return 1;
+  }
+  Report("text parse, all", Elapsed(start), FileMb(csv), check);
+
+  start = BenchClock::now();
+  if (!reader.Open(rec_path))
+  {
+    std::fprintf(stderr, "%s\n", reader.LastError().c_str());
+    return 1;
+  }
+  check = 0.0;
+  for (size_t c = 0U; c < reader.Chunks(); c++)
+  {
+    int64_t sum = 0;
+    for (int32_t v : reader.Get<int32_t>(c, 1U))
+    {
+      sum += v;
+    }
+    check += static_cast<double>(sum);
+  }
+  seconds = Elapsed(start);
+  Report("rec open + acc_x", seconds, static_cast<double>(reader.Rows()) * sizeof(int32_t) / 1e6, check);
+
+  start = BenchClock::now();
+  check = 0.0;
+  for (size_t c = 0U; c < reader.Chunks(); c++)
+  {
+    for (int64_t t : reader.Time(c))
+    {
+      check += static_cast<double>(t);
+    }
+    for (uint32_t ch = 1U; ch <= AXES_CHANNELS; ch++)
+    {
+      int64_t sum = 0;
+      for (int32_t v : reader.Get<int32_t>(c, ch))
+      {
+        sum += v;
+      }
+      check += static_cast<double>(sum);
+    }
+    for (uint32_t ch = AXES_CHANNELS + 1U; ch < reader.Channels(); ch++)
+    {
+      for (float v : reader.Get<float>(c, ch))
+      {
+        check += static_cast<double>(v);
+      }
+    }
+  }
+  Report("rec all channels", Elapsed(start), FileMb(rec_path), check);
+
+  std::mt19937_64 rng(2U);
+  std::uniform_int_distribution<uint64_t> pick(0U, (reader.Rows() > 0U) ? (reader.Rows() - 1U) : 0U);
+  start = BenchClock::now();
+  check = 0.0;
+  for (uint32_t i = 0U; (i < SEEKS) && (reader.Rows() > 0U); i++)
+  {
+    uint64_t row = pick(rng);
+    size_t chunk = static_cast<size_t>(row / reader.ChunkRows());
+    check += reader.Get<int32_t>(chunk, 1U)[static_cast<size_t>(row % reader.ChunkRows())];
+  }
+  seconds = Elapsed(start);
+  std::printf("%-22s %9.3f s %10.1f ns/seek check %.6g\n", "rec random rows", seconds,
+              seconds * 1e9 / SEEKS, check);
+
+  return 0;
+}
@@ -0,0 +1,156 @@
+/**
+  ******************************************************************************
+  * @file    rec_dump.cpp
+  * @author  ISCA Lab
+  * @brief   Print the layout or the values of a recording
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "rec_reader.hpp"
+
+/**
+  * @brief  Print the command line help
+  * @retval None
+  */
+static void Usage(void)
+{
+  std::fprintf(stderr,
+               "usage: rec_dump info <file.rec>\n"
+               "       rec_dump csv <file.rec> [-f from_us] [-t to_us] [channel ...]\n");
+}
+
+/**
+  * @brief  Print the header, channel table and chunk index summary
+  * @param  Rec the recording
+  * @retval None
+  */
+static void Info(const rec::Reader &Rec)
+{
+  std::printf("source   %.*s\n", 24, Rec.Source());
+  std::printf("rows     %llu\n", static_cast<unsigned long long>(Rec.Rows()));
+  std::printf("chunks   %zu x %u rows%s\n", Rec.Chunks(), Rec.ChunkRows(),
+              Rec.Recovered() ? " (index rebuilt: file not closed or damaged)" : "");
+  if (Rec.Chunks() > 0U)
+  {
+    std::printf("time     %lld .. %lld us\n", static_cast<long long>(Rec.ChunkInfo(0U).TimeFirst),
+                static_cast<long long>(Rec.ChunkInfo(Rec.Chunks() - 1U).TimeLast));
+  }
+
+  for (uint32_t i = 0U; i < Rec.Channels(); i++)
+  {
+    const rec::ChannelDesc &ch = Rec.Channel(i);
+    std::printf("%3u %-24.24s %-4s %-12.12s x%g\n", i, ch.Name, rec::TypeName(Rec.ChannelType(i)), ch.Unit,
+                static_cast<double>(ch.Scale));
+  }
+}
+
+/**
+  * @brief  Print rows as CSV, raw values scaled to physical units
+  * @param  Rec the recording
+  * @param  Channels the channels to print, time first
+  * @param  From first timestamp [us]
+  * @param  To last timestamp [us]
+  * @retval None
+  */
+static void Csv(const rec::Reader &Rec, const std::vector<uint32_t> &Channels, int64_t From, int64_t To)
+{
+  for (size_t i = 0U; i < Channels.size(); i++)
+  {
+    std::printf("%s%.*s", (i == 0U) ? "" : ",", 24, Rec.Channel(Channels[i]).Name);
+  }
+  std::printf("\n");
+
+  for (size_t c = Rec.FindChunk(From); (c < Rec.Chunks()) && (Rec.ChunkInfo(c).TimeFirst <= To); c++)
+  {
+    rec::Column<int64_t> time = Rec.Time(c);
+
+    for (size_t r = 0U; r < time.Size; r++)
+    {
+      if ((time[r] < From) || (time[r] > To))
+      {
+        continue;
+      }
+
+      for (size_t i = 0U; i < Channels.size(); i++)
+      {
+        double v = Rec.Value(c, Channels[i], r) * Rec.Channel(Channels[i]).Scale;
+        std::printf((i == 0U) ? "%.17g" : ",%.9g", v);
+      }
+      std::printf("\n");
+    }
+  }
+}
+
+int main(int argc, char **argv)
+{
+  rec::Reader reader;
+  std::vector<uint32_t> channels;
+  int64_t from = INT64_MIN;
+  int64_t to = INT64_MAX;
+
+  if ((argc < 3) || ((std::strcmp(argv[1], "info") != 0) && (std::strcmp(argv[1], "csv") != 0)))
+  {
+    Usage();
+    return 2;
+  }
+
+  if (!reader.Open(argv[2]))
+  {
+    std::fprintf(stderr, "%s\n", reader.LastError().c_str());
+    return 1;
+  }
+
+  if (std::strcmp(argv[1], "info") == 0)
+  {
+    Info(reader);
+    return 0;
+  }
+
+  channels.push_back(rec::kTimeChannel);
+  for (int i = 3; i < argc; i++)
+  {
+    if ((std::strcmp(argv[i], "-f") == 0) && ((i + 1) < argc))
+    {
+      from = std::strtoll(argv[++i], nullptr, 0);
+    }
+    else if ((std::strcmp(argv[i], "-t") == 0) && ((i + 1) < argc))
+    {
+      to = std::strtoll(argv[++i], nullptr, 0);
+    }
+    else
+    {
+      int32_t ch = reader.FindChannel(argv[i]);
+      if (ch < 0)
+      {
+        std::fprintf(stderr, "unknown channel: %s\n", argv[i]);
+        return 1;
+      }
+      channels.push_back(static_cast<uint32_t>(ch));
+    }
+  }
+
+  if (channels.size() == 1U)
+  {
+    for (uint32_t i = 1U; i < reader.Channels(); i++)
+    {
+      channels.push_back(i);
+    }
+  }
+
+  Csv(reader, channels, from, to);
+
+  return 0;
+}
@@ -0,0 +1,181 @@
+/**
+  ******************************************************************************
+  * @file    rec_format.hpp
+  * @author  ISCA Lab
+  * @brief   On-disk layout of the columnar sensor recording (.rec)
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef REC_FORMAT_HPP
+#define REC_FORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * A recording is a file header, a channel table, then chunks of up to
+ * ChunkRows rows, then the chunk index:
+ *
+ *   FileHeader | ChannelDesc[Channels] | Chunk ... Chunk | IndexHeader IndexEntry[Chunks]
+ *
+ * A chunk is a ChunkHeader followed by one column per channel, in channel
+ * order. A column holds Rows raw values of the channel type, padded to 8
+ * bytes, so every column of a memory-mapped file is an aligned array.
+ *
+ * Channel 0 is always the sensor timestamp, int64 microseconds. All chunks
+ * but the last hold exactly ChunkRows rows: row R lives in chunk
+ * R / ChunkRows, and the index gives its offset.
+ *
+ * The header counters and IndexOffset are written when the recording is
+ * closed. A file with IndexOffset 0 was not closed: the reader rebuilds the
+ * index by walking the chunk headers, as it does for a damaged index.
+ *
+ * Values are little-endian, the byte order of the STM32 and of the hosts.
+ */
+
+namespace rec
+{
+
+constexpr char kMagic[8] = { 'S', 'H', 'U', 'B', 'R', 'E', 'C', '1' };
+constexpr uint16_t kVersion = 1U;
+constexpr uint32_t kChunkMagic = 0x4B4E4843U; /* "CHNK" */
+constexpr uint32_t kIndexMagic = 0x58444E49U; /* "INDX" */
+constexpr uint32_t kAlign = 8U;
+constexpr uint32_t kTimeChannel = 0U;
+constexpr uint32_t kDefaultChunkRows = 4096U;
+
+enum class Type : uint8_t
+{
+  U8  = 1,
+  I16 = 2,
+  I32 = 3,
+  I64 = 4,
+  F32 = 5,
+};
+
+struct FileHeader
+{
+  char Magic[8];
+  uint16_t Version;
+  uint16_t Channels;     /* Time channel included */
+  uint32_t ChunkRows;
+  uint64_t Rows;         /* Written on close */
+  uint64_t Chunks;       /* Written on close */
+  uint64_t IndexOffset;  /* Written on close, 0 if the file was not closed */
+  char Source[24];       /* Free text, e.g. the converter name */
+};
+
+struct ChannelDesc
+{
+  char Name[24];
+  char Unit[12];
+  float Scale;           /* Physical value = raw * Scale */
+  uint8_t Type;          /* rec::Type */
+  uint8_t Reserved[7];
+};
+
+struct ChunkHeader
+{
+  uint32_t Magic;
+  uint32_t Rows;
+  uint64_t FirstRow;
+  int64_t TimeFirst;     /* [us] */
+  int64_t TimeLast;      /* [us] */
+};
+
+struct IndexHeader
+{
+  uint32_t Magic;
+  uint32_t Reserved;
+  uint64_t Count;
+};
+
+struct IndexEntry
+{
+  uint64_t Offset;       /* ChunkHeader position in the file */
+  uint64_t FirstRow;
+  int64_t TimeFirst;     /* [us] */
+  int64_t TimeLast;      /* [us] */
+};
+
+static_assert(sizeof(FileHeader) == 64U, "FileHeader layout");
+static_assert(sizeof(ChannelDesc) == 48U, "ChannelDesc layout");
+static_assert(sizeof(ChunkHeader) == 32U, "ChunkHeader layout");
+static_assert(sizeof(IndexHeader) == 16U, "IndexHeader layout");
+static_assert(sizeof(IndexEntry) == 32U, "IndexEntry layout");
+
+/**
+  * @brief  Size of one value
+  * @param  T the channel type
+  * @retval Bytes, 0 for an unknown type
+  */
+inline size_t TypeSize(Type T)
+{
+  switch (T)
+  {
+    case Type::U8:
+      return 1U;
+    case Type::I16:
+      return 2U;
+    case Type::I32:
+    case Type::F32:
+      return 4U;
+    case Type::I64:
+      return 8U;
+    default:
+      return 0U;
+  }
+}
+
+/**
+  * @brief  Type name, as printed by the tools
+  * @param  T the channel type
+  * @retval The name
+  */
+inline const char *TypeName(Type T)
+{
+  switch (T)
+  {
+    case Type::U8:
+      return "u8";
+    case Type::I16:
+      return "i16";
+    case Type::I32:
+      return "i32";
+    case Type::I64:
+      return "i64";
+    case Type::F32:
+      return "f32";
+    default:
+      return "?";
+  }
+}
+
+/**
+  * @brief  Round up to the column alignment
+  * @param  Size bytes
+  * @retval The padded size
+  */
+constexpr uint64_t AlignUp(uint64_t Size)
+{
+  return (Size + kAlign - 1U) & ~static_cast<uint64_t>(kAlign - 1U);
+}
+
+/* Type tag of a C++ value type */
+template <typename T> struct TypeOf;
+template <> struct TypeOf<uint8_t> { static constexpr Type Value = Type::U8; };
+template <> struct TypeOf<int16_t> { static constexpr Type Value = Type::I16; };
+template <> struct TypeOf<int32_t> { static constexpr Type Value = Type::I32; };
+template <> struct TypeOf<int64_t> { static constexpr Type Value = Type::I64; };
+template <> struct TypeOf<float> { static constexpr Type Value = Type::F32; };
+
+} /* namespace rec */
+
+#endif /* REC_FORMAT_HPP */
@@ -0,0 +1,375 @@
+/**
+  ******************************************************************************
+  * @file    rec_reader.cpp
+  * @author  ISCA Lab
+  * @brief   Memory-mapped columnar sensor recording reader
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "rec_reader.hpp"
+
+namespace rec
+{
+
+/**
+  * @brief  Unmap the file
+  */
+Reader::~Reader()
+{
+  Close();
+}
+
+/**
+  * @brief  Map a recording and load its index
+  * @note   A recording that was not closed, or whose index is damaged, is
+  *         opened from its complete chunks, see Recovered.
+  * @param  Path the file
+  * @retval true in case of success, false otherwise (see LastError)
+  */
+bool Reader::Open(const std::string &Path)
+{
+  struct stat st;
+  void *map;
+  int fd;
+
+  Close();
+
+  fd = ::open(Path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return Fail("cannot open " + Path);
+  }
+
+  if ((::fstat(fd, &st) != 0) || (st.st_size < static_cast<off_t>(sizeof(FileHeader))))
+  {
+    (void)::close(fd);
+    return Fail("not a recording: " + Path);
+  }
+
+  map = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+  (void)::close(fd);
+  if (map == MAP_FAILED)
+  {
+    return Fail("cannot map " + Path);
+  }
+
+  Map = static_cast<const uint8_t *>(map);
+  MapSize = static_cast<size_t>(st.st_size);
+  std::memcpy(&Header, Map, sizeof(Header));
+
+  if ((std::memcmp(Header.Magic, kMagic, sizeof(kMagic)) != 0) || (Header.Version != kVersion))
+  {
+    return Fail("not a recording or unsupported version: " + Path);
+  }
+
+  DataOffset = sizeof(FileHeader) + static_cast<uint64_t>(Header.Channels) * sizeof(ChannelDesc);
+  if ((Header.Channels == 0U) || (Header.ChunkRows == 0U) || (DataOffset > MapSize))
+  {
+    return Fail("corrupted header: " + Path);
+  }
+
+  Table = reinterpret_cast<const ChannelDesc *>(Map + sizeof(FileHeader));
+  for (uint32_t i = 0U; i < Header.Channels; i++)
+  {
+    if (TypeSize(ChannelType(i)) == 0U)
+    {
+      return Fail("unknown type in channel table: " + Path);
+    }
+  }
+
+  if (ChannelType(kTimeChannel) != Type::I64)
+  {
+    return Fail("time channel is not int64: " + Path);
+  }
+
+  ColumnOffsets(Header.ChunkRows, FullOffset);
+
+  /* Fall back on the chunk headers for a file not closed or cut short */
+  if ((Header.IndexOffset == 0U) || !LoadIndex())
+  {
+    Index.clear();
+    (void)RebuildIndex();
+  }
+
+  ColumnOffsets(Index.empty() ? 0U : ChunkSize(Index.size() - 1U), LastOffset);
+  TotalRows = Index.empty() ? 0U : (Index.back().FirstRow + ChunkSize(Index.size() - 1U));
+
+  return true;
+}
+
+/**
+  * @brief  Unmap the file, the columns handed out become invalid
+  * @retval None
+  */
+void Reader::Close()
+{
+  if (Map != nullptr)
+  {
+    (void)::munmap(const_cast<uint8_t *>(Map), MapSize);
+  }
+
+  Map = nullptr;
+  MapSize = 0U;
+  Table = nullptr;
+  Header = {};
+  Index.clear();
+  TotalRows = 0U;
+  Rebuilt = false;
+}
+
+/**
+  * @brief  Look a channel up by name
+  * @param  Name the channel name
+  * @retval The channel number, -1 if not found
+  */
+int32_t Reader::FindChannel(const std::string &Name) const
+{
+  for (uint32_t i = 0U; i < Header.Channels; i++)
+  {
+    if (std::strncmp(Table[i].Name, Name.c_str(), sizeof(Table[i].Name)) == 0)
+    {
+      return static_cast<int32_t>(i);
+    }
+  }
+
+  return -1;
+}
+
+/**
+  * @brief  Rows in a chunk
+  * @param  Chunk the chunk number
+  * @retval The rows
+  */
+uint32_t Reader::ChunkSize(size_t Chunk) const
+{
+  uint64_t next = ((Chunk + 1U) < Index.size()) ? Index[Chunk + 1U].FirstRow
+                  : reinterpret_cast<const ChunkHeader *>(Map + Index[Chunk].Offset)->Rows + Index[Chunk].FirstRow;
+
+  return static_cast<uint32_t>(next - Index[Chunk].FirstRow);
+}
+
+/**
+  * @brief  Find the chunk holding a timestamp
+  * @note   Timestamps are expected to grow, as in a sensor stream.
+  * @param  TimeUs the timestamp [us]
+  * @retval The last chunk starting at or before TimeUs, 0 if none
+  */
+size_t Reader::FindChunk(int64_t TimeUs) const
+{
+  auto it = std::upper_bound(Index.begin(), Index.end(), TimeUs,
+                             [](int64_t Time, const IndexEntry &Entry) { return Time < Entry.TimeFirst; });
+
+  return (it == Index.begin()) ? 0U : static_cast<size_t>((it - Index.begin()) - 1);
+}
+
+/**
+  * @brief  Get the start of a column in the mapping
+  * @param  Chunk the chunk number
+  * @param  Channel the channel number
+  * @retval The column, 8-byte aligned
+  */
+const void *Reader::RawColumn(size_t Chunk, uint32_t Channel) const
+{
+  const std::vector<uint64_t> &offsets = ((Chunk + 1U) == Index.size()) ? LastOffset : FullOffset;
+
+  return Map + Index[Chunk].Offset + offsets[Channel];
+}
+
+/**
+  * @brief  Read one raw value of any type, for tools that print values
+  * @param  Chunk the chunk number
+  * @param  Channel the channel number
+  * @param  Row the row in the chunk
+  * @retval The raw value
+  */
+double Reader::Value(size_t Chunk, uint32_t Channel, size_t Row) const
+{
+  const void *column = RawColumn(Chunk, Channel);
+
+  switch (ChannelType(Channel))
+  {
+    case Type::U8:
+      return static_cast<const uint8_t *>(column)[Row];
+    case Type::I16:
+      return static_cast<const int16_t *>(column)[Row];
+    case Type::I32:
+      return static_cast<const int32_t *>(column)[Row];
+    case Type::I64:
+      return static_cast<double>(static_cast<const int64_t *>(column)[Row]);
+    case Type::F32:
+      return static_cast<const float *>(column)[Row];
+    default:
+      return 0.0;
+  }
+}
+
+/**
+  * @brief  Record the error and unmap
+  * @param  Message the error
+  * @retval false
+  */
+bool Reader::Fail(const std::string &Message)
+{
+  Close();
+  Error = Message;
+
+  return false;
+}
+
+/**
+  * @brief  Record the error, keep the mapping
+  * @param  Message the error
+  * @retval false
+  */
+bool Reader::Reject(const std::string &Message)
+{
+  Error = Message;
+
+  return false;
+}
+
+/**
+  * @brief  Load and check the index written on close
+  * @retval true in case of success, false otherwise (see LastError)
+  */
+bool Reader::LoadIndex()
+{
+  IndexHeader index;
+  const IndexEntry *entries;
+  const ChunkHeader *chunk;
+  uint64_t rows = 0U;
+
+  if ((Header.IndexOffset < DataOffset) || (Header.IndexOffset > (MapSize - sizeof(index))))
+  {
+    return Reject("index out of the file");
+  }
+
+  std::memcpy(&index, Map + Header.IndexOffset, sizeof(index));
+  if ((index.Magic != kIndexMagic) || (index.Count != Header.Chunks)
+      || (index.Count > ((MapSize - Header.IndexOffset - sizeof(index)) / sizeof(IndexEntry))))
+  {
+    return Reject("corrupted index");
+  }
+
+  entries = reinterpret_cast<const IndexEntry *>(Map + Header.IndexOffset + sizeof(index));
+  Index.assign(entries, entries + index.Count);
+
+  for (size_t i = 0U; i < Index.size(); i++)
+  {
+    if ((Index[i].Offset < DataOffset) || (Index[i].Offset > (Header.IndexOffset - sizeof(ChunkHeader))))
+    {
+      return Reject("corrupted index entry " + std::to_string(i));
+    }
+
+    chunk = reinterpret_cast<const ChunkHeader *>(Map + Index[i].Offset);
+    if ((chunk->Magic != kChunkMagic) || (chunk->FirstRow != rows) || (chunk->Rows == 0U)
+        || (chunk->Rows > Header.ChunkRows) || (((i + 1U) < Index.size()) && (chunk->Rows != Header.ChunkRows))
+        || ((Index[i].Offset + ChunkBytes(chunk->Rows)) > Header.IndexOffset))
+    {
+      return Reject("corrupted chunk " + std::to_string(i));
+    }
+
+    rows += chunk->Rows;
+  }
+
+  if (rows != Header.Rows)
+  {
+    return Reject("row count mismatch");
+  }
+
+  return true;
+}
+
+/**
+  * @brief  Rebuild the index of a recording that was not closed
+  * @note   Walks the chunk headers up to the first incomplete chunk.
+  * @retval true
+  */
+bool Reader::RebuildIndex()
+{
+  const ChunkHeader *chunk;
+  IndexEntry entry;
+  uint64_t offset = DataOffset;
+  uint64_t rows = 0U;
+
+  while ((offset + sizeof(ChunkHeader)) <= MapSize)
+  {
+    chunk = reinterpret_cast<const ChunkHeader *>(Map + offset);
+    if ((chunk->Magic != kChunkMagic) || (chunk->FirstRow != rows) || (chunk->Rows == 0U)
+        || (chunk->Rows > Header.ChunkRows) || ((offset + ChunkBytes(chunk->Rows)) > MapSize))
+    {
+      break;
+    }
+
+    entry.Offset = offset;
+    entry.FirstRow = chunk->FirstRow;
+    entry.TimeFirst = chunk->TimeFirst;
+    entry.TimeLast = chunk->TimeLast;
+    Index.push_back(entry);
+
+    rows += chunk->Rows;
+    offset += ChunkBytes(chunk->Rows);
+
+    /* Only the last chunk is short */
+    if (chunk->Rows != Header.ChunkRows)
+    {
+      break;
+    }
+  }
+
+  Rebuilt = true;
+
+  return true;
+}
+
+/**
+  * @brief  Size of a chunk on disk
+  * @param  Rows the rows in the chunk
+  * @retval Bytes, header included
+  */
+uint64_t Reader::ChunkBytes(uint32_t Rows) const
+{
+  uint64_t size = sizeof(ChunkHeader);
+
+  for (uint32_t i = 0U; i < Header.Channels; i++)
+  {
+    size += AlignUp(static_cast<uint64_t>(Rows) * TypeSize(ChannelType(i)));
+  }
+
+  return size;
+}
+
+/**
+  * @brief  Column offsets in a chunk, from the chunk header
+  * @param  Rows the rows in the chunk
+  * @param  Offsets the offsets, one per channel
+  * @retval None
+  */
+void Reader::ColumnOffsets(uint32_t Rows, std::vector<uint64_t> &Offsets) const
+{
+  uint64_t offset = sizeof(ChunkHeader);
+
+  Offsets.resize(Header.Channels);
+  for (uint32_t i = 0U; i < Header.Channels; i++)
+  {
+    Offsets[i] = offset;
+    offset += AlignUp(static_cast<uint64_t>(Rows) * TypeSize(ChannelType(i)));
+  }
+}
+
+} /* namespace rec */
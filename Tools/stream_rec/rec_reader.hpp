@@ -0,0 +1,123 @@
+/**
+  ******************************************************************************
+  * @file    rec_reader.hpp
+  * @author  ISCA Lab
+  * @brief   Memory-mapped columnar sensor recording reader
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef REC_READER_HPP
+#define REC_READER_HPP
+
+#include <string>
+#include <vector>
+
+#include "rec_format.hpp"
+
+namespace rec
+{
+
+/* Read-only view on a column of a mapped chunk, valid while the Reader is open */
+template <typename T> struct Column
+{
+  const T *Data = nullptr;
+  size_t Size = 0U;
+
+  const T *begin() const { return Data; }
+  const T *end() const { return Data + Size; }
+  const T &operator[](size_t Index) const { return Data[Index]; }
+  bool Empty() const { return Size == 0U; }
+};
+
+/*
+ * The whole file is mapped, columns are returned as pointers into the
+ * mapping: nothing is copied or parsed. Chunk(R / ChunkRows()) holds row R,
+ * FindChunk looks a timestamp up in the index.
+ */
+class Reader
+{
+public:
+  Reader() = default;
+  ~Reader();
+  Reader(const Reader &) = delete;
+  Reader &operator=(const Reader &) = delete;
+
+  bool Open(const std::string &Path);
+  void Close();
+
+  uint32_t Channels() const { return Header.Channels; }
+  const ChannelDesc &Channel(uint32_t Channel) const { return Table[Channel]; }
+  int32_t FindChannel(const std::string &Name) const;
+  Type ChannelType(uint32_t Channel) const { return static_cast<Type>(Table[Channel].Type); }
+
+  uint64_t Rows() const { return TotalRows; }
+  uint32_t ChunkRows() const { return Header.ChunkRows; }
+  size_t Chunks() const { return Index.size(); }
+  const IndexEntry &ChunkInfo(size_t Chunk) const { return Index[Chunk]; }
+  uint32_t ChunkSize(size_t Chunk) const;
+  size_t FindChunk(int64_t TimeUs) const;
+  bool Recovered() const { return Rebuilt; }
+  const char *Source() const { return Header.Source; }
+  const std::string &LastError() const { return Error; }
+
+  const void *RawColumn(size_t Chunk, uint32_t Channel) const;
+
+  /**
+    * @brief  Get a column of a chunk
+    * @param  Chunk the chunk number
+    * @param  Channel the channel number
+    * @retval The values, empty if the channel has another type
+    */
+  template <typename T> Column<T> Get(size_t Chunk, uint32_t Channel) const
+  {
+    Column<T> column;
+
+    if ((Chunk < Index.size()) && (Channel < Header.Channels) && (ChannelType(Channel) == TypeOf<T>::Value))
+    {
+      column.Data = static_cast<const T *>(RawColumn(Chunk, Channel));
+      column.Size = ChunkSize(Chunk);
+    }
+
+    return column;
+  }
+
+  /**
+    * @brief  Get the timestamps of a chunk
+    * @param  Chunk the chunk number
+    * @retval The timestamps [us]
+    */
+  Column<int64_t> Time(size_t Chunk) const { return Get<int64_t>(Chunk, kTimeChannel); }
+
+  double Value(size_t Chunk, uint32_t Channel, size_t Row) const;
+
+private:
+  bool Fail(const std::string &Message);
+  bool Reject(const std::string &Message);
+  bool LoadIndex();
+  bool RebuildIndex();
+  uint64_t ChunkBytes(uint32_t Rows) const;
+  void ColumnOffsets(uint32_t Rows, std::vector<uint64_t> &Offsets) const;
+
+  const uint8_t *Map = nullptr;
+  size_t MapSize = 0U;
+  FileHeader Header = {};
+  const ChannelDesc *Table = nullptr;
+  std::vector<IndexEntry> Index;
+  std::vector<uint64_t> FullOffset;   /* Column offsets in a full chunk */
+  std::vector<uint64_t> LastOffset;   /* Column offsets in the last chunk */
+  uint64_t TotalRows = 0U;
+  uint64_t DataOffset = 0U;           /* First chunk */
+  bool Rebuilt = false;
+  std::string Error;
+};
+
+} /* namespace rec */
+
+#endif /* REC_READER_HPP */
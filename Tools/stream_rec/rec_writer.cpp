@@ -0,0 +1,250 @@
+/**
+  ******************************************************************************
+  * @file    rec_writer.cpp
+  * @author  ISCA Lab
+  * @brief   Columnar sensor recording writer
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include "rec_writer.hpp"
+
+namespace rec
+{
+
+static const uint8_t Padding[kAlign] = { 0 };
+
+/**
+  * @brief  Copy a string into a fixed size field, zero padded
+  * @param  Dest the field
+  * @param  Size the field size
+  * @param  Source the string, truncated to Size - 1 characters
+  * @retval None
+  */
+static void CopyField(char *Dest, size_t Size, const std::string &Source)
+{
+  std::memset(Dest, 0, Size);
+  std::memcpy(Dest, Source.data(), (Source.size() < Size) ? Source.size() : Size - 1U);
+}
+
+/**
+  * @brief  Close the file if the owner did not
+  */
+Writer::~Writer()
+{
+  if (File != nullptr)
+  {
+    (void)Close();
+  }
+}
+
+/**
+  * @brief  Create the recording and write the header and channel table
+  * @param  Path the file, replaced if it exists
+  * @param  Channels the channels after the time channel
+  * @param  ChunkRows rows per chunk
+  * @param  Source free text stored in the header
+  * @retval true in case of success, false otherwise (see LastError)
+  */
+bool Writer::Open(const std::string &Path, const std::vector<ChannelSpec> &Channels,
+                  uint32_t ChunkRows, const std::string &Source)
+{
+  std::vector<ChannelDesc> table;
+  ChannelDesc desc;
+
+  if ((ChunkRows == 0U) || ((Channels.size() + 1U) > 0xFFFFU))
+  {
+    Error = "invalid chunk size or channel count";
+    return false;
+  }
+
+  File = std::fopen(Path.c_str(), "wb");
+  if (File == nullptr)
+  {
+    Error = "cannot create " + Path;
+    return false;
+  }
+
+  std::memcpy(Header.Magic, kMagic, sizeof(Header.Magic));
+  Header.Version = kVersion;
+  Header.Channels = static_cast<uint16_t>(Channels.size() + 1U);
+  Header.ChunkRows = ChunkRows;
+  CopyField(Header.Source, sizeof(Header.Source), Source);
+
+  Columns.clear();
+  Columns.push_back({ Type::I64, TypeSize(Type::I64), {} });
+  desc = {};
+  CopyField(desc.Name, sizeof(desc.Name), "time");
+  CopyField(desc.Unit, sizeof(desc.Unit), "us");
+  desc.Scale = 1.0F;
+  desc.Type = static_cast<uint8_t>(Type::I64);
+  table.push_back(desc);
+
+  for (const ChannelSpec &spec : Channels)
+  {
+    if (TypeSize(spec.ValueType) == 0U)
+    {
+      Error = "unknown type for channel " + spec.Name;
+      std::fclose(File);
+      File = nullptr;
+      return false;
+    }
+    Columns.push_back({ spec.ValueType, TypeSize(spec.ValueType), {} });
+    desc = {};
+    CopyField(desc.Name, sizeof(desc.Name), spec.Name);
+    CopyField(desc.Unit, sizeof(desc.Unit), spec.Unit);
+    desc.Scale = spec.Scale;
+    desc.Type = static_cast<uint8_t>(spec.ValueType);
+    table.push_back(desc);
+  }
+
+  for (Column &column : Columns)
+  {
+    column.Data.assign(static_cast<size_t>(ChunkRows) * column.Size, 0U);
+  }
+
+  Index.clear();
+  Row = 0U;
+  TotalRows = 0U;
+  Offset = 0U;
+  Failed = false;
+  Error.clear();
+
+  return WriteAll(&Header, sizeof(Header)) && WriteAll(table.data(), table.size() * sizeof(ChannelDesc));
+}
+
+/**
+  * @brief  Start a row
+  * @param  TimeUs the sensor timestamp [us]
+  * @retval None
+  */
+void Writer::BeginRow(int64_t TimeUs)
+{
+  Put(kTimeChannel, TimeUs);
+}
+
+/**
+  * @brief  Commit the current row, write the chunk once full
+  * @retval None
+  */
+void Writer::EndRow()
+{
+  Row++;
+  TotalRows++;
+
+  if (Row == Header.ChunkRows)
+  {
+    (void)Flush();
+  }
+}
+
+/**
+  * @brief  Write the last chunk and the index, then fill in the header
+  * @retval true in case of success, false otherwise (see LastError)
+  */
+bool Writer::Close()
+{
+  IndexHeader index = {};
+  bool ok;
+
+  if (File == nullptr)
+  {
+    return false;
+  }
+
+  ok = Flush();
+
+  index.Magic = kIndexMagic;
+  index.Count = Index.size();
+  Header.Rows = TotalRows;
+  Header.Chunks = Index.size();
+  Header.IndexOffset = Offset;
+
+  ok = ok && WriteAll(&index, sizeof(index)) && WriteAll(Index.data(), Index.size() * sizeof(IndexEntry));
+  ok = ok && (std::fseek(File, 0L, SEEK_SET) == 0) && (std::fwrite(&Header, sizeof(Header), 1U, File) == 1U);
+  ok = (std::fclose(File) == 0) && ok;
+  File = nullptr;
+
+  if (!ok && Error.empty())
+  {
+    Error = "write failed";
+  }
+
+  return ok && !Failed;
+}
+
+/**
+  * @brief  Write the buffered chunk
+  * @retval true in case of success, false otherwise
+  */
+bool Writer::Flush()
+{
+  ChunkHeader chunk = {};
+  IndexEntry entry = {};
+  const int64_t *time = reinterpret_cast<const int64_t *>(Columns[kTimeChannel].Data.data());
+  size_t len;
+
+  if (Row == 0U)
+  {
+    return true;
+  }
+
+  chunk.Magic = kChunkMagic;
+  chunk.Rows = Row;
+  chunk.FirstRow = TotalRows - Row;
+  chunk.TimeFirst = time[0];
+  chunk.TimeLast = time[Row - 1U];
+
+  entry.Offset = Offset;
+  entry.FirstRow = chunk.FirstRow;
+  entry.TimeFirst = chunk.TimeFirst;
+  entry.TimeLast = chunk.TimeLast;
+  Index.push_back(entry);
+
+  if (!WriteAll(&chunk, sizeof(chunk)))
+  {
+    return false;
+  }
+
+  for (Column &column : Columns)
+  {
+    len = Row * column.Size;
+    if (!WriteAll(column.Data.data(), len) || !WriteAll(Padding, AlignUp(len) - len))
+    {
+      return false;
+    }
+    std::memset(column.Data.data(), 0, len);
+  }
+
+  Row = 0U;
+
+  return true;
+}
+
+/**
+  * @brief  Write and track the file position
+  * @param  Data the bytes
+  * @param  Len the length
+  * @retval true in case of success, false otherwise
+  */
+bool Writer::WriteAll(const void *Data, size_t Len)
+{
+  if ((Len != 0U) && (std::fwrite(Data, 1U, Len, File) != Len))
+  {
+    Failed = true;
+    Error = "write failed";
+    return false;
+  }
+
+  Offset += Len;
+
+  return true;
+}
+
+} /* namespace rec */
@@ -0,0 +1,110 @@
+/**
+  ******************************************************************************
+  * @file    rec_writer.hpp
+  * @author  ISCA Lab
+  * @brief   Columnar sensor recording writer
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef REC_WRITER_HPP
+#define REC_WRITER_HPP
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "rec_format.hpp"
+
+namespace rec
+{
+
+struct ChannelSpec
+{
+  std::string Name;
+  Type ValueType;
+  std::string Unit;
+  float Scale;
+};
+
+/*
+ * Rows are appended one at a time:
+ *
+ *   writer.BeginRow(time_us);
+ *   writer.Put(acc_x, int32_t(...));
+ *   ...
+ *   writer.EndRow();
+ *
+ * Channels are numbered from 1 in the order given to Open, 0 is the time.
+ * A channel not written in a row keeps 0. Each column of the current chunk
+ * is buffered, a full chunk costs one write.
+ */
+class Writer
+{
+public:
+  Writer() = default;
+  ~Writer();
+  Writer(const Writer &) = delete;
+  Writer &operator=(const Writer &) = delete;
+
+  bool Open(const std::string &Path, const std::vector<ChannelSpec> &Channels,
+            uint32_t ChunkRows = kDefaultChunkRows, const std::string &Source = "");
+  bool Close();
+
+  void BeginRow(int64_t TimeUs);
+  void EndRow();
+
+  /**
+    * @brief  Set a value of the current row
+    * @note   The value type must match the channel type, a mismatch is
+    *         reported by Close.
+    * @param  Channel the channel number, 1 for the first one given to Open
+    * @param  Value the raw value
+    * @retval None
+    */
+  template <typename T> void Put(uint32_t Channel, T Value)
+  {
+    if ((Channel >= Columns.size()) || (Columns[Channel].ValueType != TypeOf<T>::Value))
+    {
+      Failed = true;
+      Error = "type or channel mismatch on channel " + std::to_string(Channel);
+      return;
+    }
+    std::memcpy(&Columns[Channel].Data[Row * sizeof(T)], &Value, sizeof(T));
+  }
+
+  uint64_t Rows() const { return TotalRows; }
+  const std::string &LastError() const { return Error; }
+
+private:
+  struct Column
+  {
+    Type ValueType;
+    size_t Size;
+    std::vector<uint8_t> Data;
+  };
+
+  bool Flush();
+  bool WriteAll(const void *Data, size_t Len);
+
+  std::FILE *File = nullptr;
+  FileHeader Header = {};
+  std::vector<Column> Columns;
+  std::vector<IndexEntry> Index;
+  uint32_t Row = 0U;         /* Rows in the current chunk */
+  uint64_t TotalRows = 0U;
+  uint64_t Offset = 0U;      /* Write position */
+  bool Failed = false;
+  std::string Error;
+};
+
+} /* namespace rec */
+
+#endif /* REC_WRITER_HPP */
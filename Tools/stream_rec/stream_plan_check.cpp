@@ -0,0 +1,381 @@
+/**
+  ******************************************************************************
+  * @file    stream_plan_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the stream subscription plans against the host decoder
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "fusion_codec.h"
+#include "stream_plan.h"
+#include "tmsg_stream.hpp"
+
+/*
+ * For every field mask and fusion format, builds the plan with the firmware
+ * stream_plan.c, runs it on a random full frame as Stream_Task does and
+ * decodes both frames with tmsg::Decoder, set to that format as a
+ * CMD_Stream_Format reply would. Every subscribed field must decode
+ * to the same bits as in the full frame, the others must be absent. Also
+ * checks the frame length and the number of copies, and reports the frame
+ * size of a few subscriptions on the wire.
+ */
+
+struct Format
+{
+  const char *Name;
+  uint8_t Format;
+  uint8_t AngleFrac;
+  uint8_t AccFrac;
+};
+
+static const Format Formats[] =
+{
+  { "float", tmsg::kFxFloat, 0U, 0U },
+  { "half", tmsg::kFxHalf, 0U, 0U },
+  { "fixed 6/12", tmsg::kFxFixed, 6U, 12U },
+};
+
+/**
+  * @brief  Checksum, byte stuffing and EOF, as UART_SendMsg
+  * @param  Data the message, one spare byte for the checksum
+  * @param  Len the message length
+  * @param  Out the wire bytes are appended here
+  * @retval None
+  */
+static void Frame(std::vector<uint8_t> Data, size_t Len, std::vector<uint8_t> &Out)
+{
+  uint8_t chk = 0U;
+
+  for (size_t i = 0U; i < Len; i++)
+  {
+    chk = static_cast<uint8_t>(chk - Data[i]);
+  }
+  Data[Len] = chk;
+
+  for (size_t i = 0U; i <= Len; i++)
+  {
+    if (Data[i] == tmsg::kEof)
+    {
+      Out.push_back(tmsg::kBs);
+      Out.push_back(tmsg::kBsEof);
+    }
+    else if (Data[i] == tmsg::kBs)
+    {
+      Out.push_back(tmsg::kBs);
+      Out.push_back(tmsg::kBs);
+    }
+    else
+    {
+      Out.push_back(Data[i]);
+    }
+  }
+  Out.push_back(tmsg::kEof);
+}
+
+/**
+  * @brief  Random full frame with the MLC output, as the handlers leave it
+  * @param  F the fusion format
+  * @param  Rng the generator
+  * @param  Len the frame length
+  * @retval The frame, 256 bytes
+  */
+static std::vector<uint8_t> FullFrame(const Format &F, std::mt19937 &Rng, size_t &Len)
+{
+  std::vector<uint8_t> d(256U);
+
+  for (uint8_t &b : d)
+  {
+    b = static_cast<uint8_t>(Rng());
+  }
+
+  d[2] = tmsg::kCmdStartDataStreaming;
+  Len = (F.Format == tmsg::kFxFloat) ? tmsg::kStreamLengthMlc : tmsg::kStreamLengthCompactMlc;
+
+  return d;
+}
+
+/**
+  * @brief  Decode one frame
+  * @param  F the fusion format
+  * @param  Data the message
+  * @param  Len the message length
+  * @param  S the sample
+  * @retval true if the frame decoded to a sample
+  */
+static bool Decode(const Format &F, const std::vector<uint8_t> &Data, size_t Len, tmsg::Sample &S)
+{
+  std::vector<uint8_t> wire;
+  std::vector<tmsg::Sample> out;
+  tmsg::Decoder decoder;
+
+  (void)decoder.SetFormat(F.Format, F.AngleFrac, F.AccFrac);
+  Frame(Data, Len, wire);
+  decoder.Feed(wire.data(), wire.size(), out);
+  if (out.size() != 1U)
+  {
+    return false;
+  }
+
+  S = out[0];
+  return true;
+}
+
+/**
+  * @brief  Compare the decoded fields of a subscribed frame
+  * @param  Full the sample of the full frame
+  * @param  Sub the sample of the subscribed frame
+  * @param  Fields the subscription
+  * @retval true if the subscribed fields match and the others are 0
+  */
+static bool Same(const tmsg::Sample &Full, const tmsg::Sample &Sub, uint16_t Fields)
+{
+  tmsg::Sample want = {};
+
+  want.Hours = Full.Hours;
+  want.Minutes = Full.Minutes;
+  want.Seconds = Full.Seconds;
+  want.Subsec = Full.Subsec;
+  want.FxFormat = Full.FxFormat;
+  want.AngleFrac = Full.AngleFrac;
+  want.AccFrac = Full.AccFrac;
+  want.Fields = Fields;
+  want.HasMlc = ((Fields & tmsg::kFieldMlc) != 0U);
+
+#define COPY_IF(field, member) \
+  if ((Fields & (field)) != 0U) { std::memcpy(&want.member, &Full.member, sizeof(want.member)); }
+  COPY_IF(tmsg::kFieldEnv, Press)
+  COPY_IF(tmsg::kFieldEnv, Temp)
+  COPY_IF(tmsg::kFieldEnv, Hum)
+  COPY_IF(tmsg::kFieldAcc, Acc)
+  COPY_IF(tmsg::kFieldGyr, Gyr)
+  COPY_IF(tmsg::kFieldMag, Mag)
+  COPY_IF(tmsg::kFieldQuat, Quat)
+  COPY_IF(tmsg::kFieldRot, Rotation)
+  COPY_IF(tmsg::kFieldGrav, Gravity)
+  COPY_IF(tmsg::kFieldLinAcc, LinAcc)
+  COPY_IF(tmsg::kFieldHeading, Heading)
+  COPY_IF(tmsg::kFieldHeading, HeadingErr)
+  COPY_IF(tmsg::kFieldTiming, FxTime)
+  COPY_IF(tmsg::kFieldMlc, MlcCode)
+  COPY_IF(tmsg::kFieldMlc, MlcEvents)
+#undef COPY_IF
+
+  /* Bitwise, NaN included: the plan copies bytes */
+  return (std::memcmp(&want.Press, &Sub.Press, sizeof(want.Press)) == 0)
+         && (std::memcmp(&want.Temp, &Sub.Temp, sizeof(want.Temp)) == 0)
+         && (std::memcmp(&want.Hum, &Sub.Hum, sizeof(want.Hum)) == 0)
+         && (std::memcmp(want.Acc, Sub.Acc, sizeof(want.Acc)) == 0)
+         && (std::memcmp(want.Gyr, Sub.Gyr, sizeof(want.Gyr)) == 0)
+         && (std::memcmp(want.Mag, Sub.Mag, sizeof(want.Mag)) == 0)
+         && (std::memcmp(want.Quat, Sub.Quat, sizeof(want.Quat)) == 0)
+         && (std::memcmp(want.Rotation, Sub.Rotation, sizeof(want.Rotation)) == 0)
+         && (std::memcmp(want.Gravity, Sub.Gravity, sizeof(want.Gravity)) == 0)
+         && (std::memcmp(want.LinAcc, Sub.LinAcc, sizeof(want.LinAcc)) == 0)
+         && (std::memcmp(&want.Heading, &Sub.Heading, sizeof(want.Heading)) == 0)
+         && (std::memcmp(&want.HeadingErr, &Sub.HeadingErr, sizeof(want.HeadingErr)) == 0)
+         && (want.FxTime == Sub.FxTime) && (want.MlcCode == Sub.MlcCode) && (want.MlcEvents == Sub.MlcEvents)
+         && (want.Hours == Sub.Hours) && (want.Minutes == Sub.Minutes) && (want.Seconds == Sub.Seconds)
+         && (want.Subsec == Sub.Subsec) && (want.FxFormat == Sub.FxFormat) && (want.AngleFrac == Sub.AngleFrac)
+         && (want.AccFrac == Sub.AccFrac) && (want.Fields == Sub.Fields) && (want.HasMlc == Sub.HasMlc);
+}
+
+/**
+  * @brief  Expected length and number of copies of a plan
+  * @note   Fields next to each other in bit order are contiguous in both
+  *         frames, each run of them is one copy after the header.
+  * @param  Fields the subscription
+  * @param  F the fusion format
+  * @param  Ops the number of copies
+  * @retval The frame length
+  */
+static size_t Expected(uint16_t Fields, const Format &F, size_t &Ops)
+{
+  size_t len = tmsg::kSubHeader;
+  int32_t prev = -1;
+
+  Ops = 1U;
+
+  for (uint32_t i = 0U; i < tmsg::kFieldCount; i++)
+  {
+    uint16_t field = static_cast<uint16_t>(1U << i);
+
+    if ((Fields & field) == 0U)
+    {
+      continue;
+    }
+
+    len += tmsg::FieldSize(field, F.Format);
+
+    if ((prev < 0) || (static_cast<uint32_t>(prev) + 1U != i))
+    {
+      Ops++;
+    }
+    prev = static_cast<int32_t>(i);
+  }
+
+  return len;
+}
+
+/**
+  * @brief  Check every subscription in one format
+  * @param  F the fusion format
+  * @param  Rng the generator
+  * @retval true if all passed
+  */
+static bool Check(const Format &F, std::mt19937 &Rng)
+{
+  STREAM_PLAN_t plan;
+  std::vector<uint8_t> sub(256U);
+  tmsg::Sample full;
+  tmsg::Sample got;
+  size_t full_len;
+  size_t ops;
+  size_t len;
+  uint32_t failed = 0U;
+
+  for (uint32_t mask = 1U; mask <= tmsg::kFieldAll; mask++)
+  {
+    uint16_t fields = static_cast<uint16_t>(mask);
+    std::vector<uint8_t> d = FullFrame(F, Rng, full_len);
+
+    len = Expected(fields, F, ops);
+
+    if ((STREAM_PLAN_Build(fields, F.Format, &plan) != STREAM_PLAN_OK) || (plan.Len != len) || (plan.Count != ops))
+    {
+      std::printf("%s: mask 0x%03X: plan of %u bytes in %u copies, expected %zu in %zu\n", F.Name, mask, plan.Len,
+                  plan.Count, len, ops);
+      failed++;
+      continue;
+    }
+
+    /* As Stream_Task */
+    std::fill(sub.begin(), sub.end(), 0xA5U);
+    STREAM_PLAN_Run(&plan, d.data(), sub.data());
+    sub[2] = tmsg::kCmdStreamSubscribe;
+
+    if (!Decode(F, d, full_len, full) || !Decode(F, sub, plan.Len, got) || !Same(full, got, fields))
+    {
+      std::printf("%s: mask 0x%03X: the subscribed frame does not decode to the full one\n", F.Name, mask);
+      failed++;
+    }
+  }
+
+  return (failed == 0U);
+}
+
+/**
+  * @brief  Check the rejected subscriptions
+  * @retval true if all passed
+  */
+static bool CheckErrors(void)
+{
+  STREAM_PLAN_t plan;
+  bool ok = true;
+
+  ok = ok && (STREAM_PLAN_Build(0x0800U, tmsg::kFxFloat, &plan) == STREAM_PLAN_ERROR);
+  ok = ok && (STREAM_PLAN_Build(tmsg::kFieldAcc, 3U, &plan) == STREAM_PLAN_ERROR);
+  ok = ok && (STREAM_PLAN_Build(0U, tmsg::kFxHalf, &plan) == STREAM_PLAN_OK) && (plan.Fields == 0U) && (plan.Len == 0U);
+
+  if (!ok)
+  {
+    std::printf("bad subscriptions are not rejected\n");
+  }
+
+  return ok;
+}
+
+/**
+  * @brief  Average bytes on the wire of a subscription
+  * @param  F the fusion format
+  * @param  Fields the subscription, 0 for the full frame
+  * @param  Rng the generator
+  * @param  Len the frame length
+  * @retval Wire bytes per frame, with stuffing, checksum and EOF
+  */
+static double Wire(const Format &F, uint16_t Fields, std::mt19937 &Rng, size_t &Len)
+{
+  const uint32_t frames = 2000U;
+  STREAM_PLAN_t plan;
+  std::vector<uint8_t> sub(256U);
+  std::vector<uint8_t> wire;
+
+  (void)STREAM_PLAN_Build(Fields, F.Format, &plan);
+
+  for (uint32_t n = 0U; n < frames; n++)
+  {
+    std::vector<uint8_t> d = FullFrame(F, Rng, Len);
+
+    if (Fields == 0U)
+    {
+      Frame(d, Len, wire);
+    }
+    else
+    {
+      STREAM_PLAN_Run(&plan, d.data(), sub.data());
+      sub[2] = tmsg::kCmdStreamSubscribe;
+      Len = plan.Len;
+      Frame(sub, Len, wire);
+    }
+  }
+
+  return static_cast<double>(wire.size()) / frames;
+}
+
+int main(int argc, char **argv)
+{
+  static const struct { const char *Name; uint16_t Fields; } subs[] =
+  {
+    { "full frame", 0U },
+    { "acc,gyr", tmsg::kFieldAcc | tmsg::kFieldGyr },
+    { "quat", tmsg::kFieldQuat },
+    { "quat,linacc,heading", tmsg::kFieldQuat | tmsg::kFieldLinAcc | tmsg::kFieldHeading },
+    { "acc,gyr,mag,quat", tmsg::kFieldAcc | tmsg::kFieldGyr | tmsg::kFieldMag | tmsg::kFieldQuat },
+    { "all", tmsg::kFieldAll },
+  };
+  uint32_t seed = (argc > 1) ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 0)) : 1U;
+  std::mt19937 rng(seed);
+  bool ok = CheckErrors();
+  size_t len;
+
+  for (const Format &f : Formats)
+  {
+    bool passed = Check(f, rng);
+
+    std::printf("%-10s  %u subscriptions  %s\n", f.Name, tmsg::kFieldAll, passed ? "ok" : "FAILED");
+    ok = ok && passed;
+  }
+
+  std::printf("\n%-22s", "fields");
+  for (const Format &f : Formats)
+  {
+    std::printf("  %16s", f.Name);
+  }
+  std::printf("\n");
+
+  for (const auto &s : subs)
+  {
+    std::printf("%-22s", s.Name);
+    for (const Format &f : Formats)
+    {
+      double wire = Wire(f, s.Fields, rng, len);
+      std::printf("  %4zu B %6.1f B", len, wire);
+    }
+    std::printf("\n");
+  }
+
+  return ok ? 0 : 1;
+}
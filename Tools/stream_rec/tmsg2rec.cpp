@@ -0,0 +1,466 @@
+/**
+  ******************************************************************************
+  * @file    tmsg2rec.cpp
+  * @author  ISCA Lab
+  * @brief   Convert a raw DataLogFusion serial capture to a recording
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "rec_writer.hpp"
+#include "tmsg_stream.hpp"
+
+/* Channel groups, from the streaming message layout */
+#define GROUP_ENV     0x01U
+#define GROUP_ACC     0x02U
+#define GROUP_GYR     0x04U
+#define GROUP_MAG     0x08U
+#define GROUP_FUSION  0x10U
+#define GROUP_MLC     0x20U
+#define GROUP_DEFAULT (GROUP_ENV | GROUP_ACC | GROUP_GYR | GROUP_MAG | GROUP_FUSION | GROUP_MLC)
+
+#define READ_SIZE  65536U
+
+/**
+  * @brief  Print the command line help
+  * @retval None
+  */
+static void Usage(void)
+{
+  std::fprintf(stderr,
+               "usage: tmsg2rec [-c groups] [-r chunk_rows] [-f format] <capture.bin|-> <out.rec>\n"
+               "  capture: raw bytes of the streaming UART, '-' for stdin\n"
+               "  groups:  comma list of env,acc,gyr,mag,fusion,mlc (default: the\n"
+               "           ones the first frame carries)\n"
+               "  format:  half, or fixed[:angle_frac/acc_frac] (default 6/12), the\n"
+               "           compact fusion format until the capture gives it\n");
+}
+
+/**
+  * @brief  Parse the compact fusion format option
+  * @param  Text half, fixed or fixed:A/B
+  * @param  Decoder the decoder to set
+  * @retval false on a bad format
+  */
+static bool ParseFormat(const char *Text, tmsg::Decoder &Decoder)
+{
+  unsigned angle = 6U;
+  unsigned acc = 12U;
+  char end;
+
+  if (std::strcmp(Text, "half") == 0)
+  {
+    return Decoder.SetFormat(tmsg::kFxHalf, 0U, 0U);
+  }
+
+  if ((std::strcmp(Text, "fixed") != 0)
+      && (std::sscanf(Text, "fixed:%u/%u%c", &angle, &acc, &end) != 2))
+  {
+    return false;
+  }
+
+  return (angle <= 15U) && (acc <= 15U)
+         && Decoder.SetFormat(tmsg::kFxFixed, static_cast<uint8_t>(angle), static_cast<uint8_t>(acc));
+}
+
+/**
+  * @brief  Parse the channel group list
+  * @param  List the comma separated names
+  * @retval The group mask, 0 on an unknown name
+  */
+static uint32_t ParseGroups(const char *List)
+{
+  static const struct { const char *Name; uint32_t Mask; } names[] =
+  {
+    { "env", GROUP_ENV }, { "acc", GROUP_ACC }, { "gyr", GROUP_GYR },
+    { "mag", GROUP_MAG }, { "fusion", GROUP_FUSION }, { "mlc", GROUP_MLC },
+  };
+  std::string list(List);
+  uint32_t mask = 0U;
+  size_t start = 0U;
+
+  while (start <= list.size())
+  {
+    size_t end = list.find(',', start);
+    std::string name = list.substr(start, (end == std::string::npos) ? std::string::npos : end - start);
+    uint32_t found = 0U;
+
+    for (const auto &n : names)
+    {
+      if (name == n.Name)
+      {
+        found = n.Mask;
+      }
+    }
+
+    if (found == 0U)
+    {
+      std::fprintf(stderr, "unknown group: %s\n", name.c_str());
+      return 0U;
+    }
+
+    mask |= found;
+    start = (end == std::string::npos) ? (list.size() + 1U) : (end + 1U);
+  }
+
+  return mask;
+}
+
+/**
+  * @brief  Groups carried by a frame
+  * @param  Fields the stream fields of the frame
+  * @retval The group mask
+  */
+static uint32_t Groups(uint16_t Fields)
+{
+  static const struct { uint16_t Fields; uint32_t Group; } map[] =
+  {
+    { tmsg::kFieldEnv, GROUP_ENV }, { tmsg::kFieldAcc, GROUP_ACC }, { tmsg::kFieldGyr, GROUP_GYR },
+    { tmsg::kFieldMag, GROUP_MAG }, { tmsg::kFieldMlc, GROUP_MLC },
+    { static_cast<uint16_t>(tmsg::kFieldAll & ~(tmsg::kFieldEnv | tmsg::kFieldAcc | tmsg::kFieldGyr
+                                                | tmsg::kFieldMag | tmsg::kFieldMlc)), GROUP_FUSION },
+  };
+  uint32_t groups = 0U;
+
+  for (const auto &m : map)
+  {
+    if ((Fields & m.Fields) != 0U)
+    {
+      groups |= m.Group;
+    }
+  }
+
+  return groups;
+}
+
+/**
+  * @brief  Add three axis channels
+  * @param  Channels the channel list
+  * @param  Prefix the name prefix
+  * @param  Unit the unit
+  * @retval None
+  */
+static void AddAxes(std::vector<rec::ChannelSpec> &Channels, const char *Prefix, const char *Unit)
+{
+  static const char axis[3] = { 'x', 'y', 'z' };
+
+  for (char a : axis)
+  {
+    Channels.push_back({ std::string(Prefix) + "_" + a, rec::Type::I32, Unit, 1.0F });
+  }
+}
+
+/**
+  * @brief  Add float channels
+  * @param  Channels the channel list
+  * @param  Prefix the name prefix
+  * @param  Count the number of channels, suffixed _0.._n if more than one
+  * @param  Unit the unit
+  * @retval None
+  */
+static void AddFloats(std::vector<rec::ChannelSpec> &Channels, const char *Prefix, size_t Count, const char *Unit)
+{
+  for (size_t i = 0U; i < Count; i++)
+  {
+    std::string name = (Count == 1U) ? std::string(Prefix) : (std::string(Prefix) + "_" + std::to_string(i));
+    Channels.push_back({ name, rec::Type::F32, Unit, 1.0F });
+  }
+}
+
+/**
+  * @brief  Build the channel list of the selected groups
+  * @param  Groups the group mask
+  * @retval The channels, in the order written by WriteSample
+  */
+static std::vector<rec::ChannelSpec> Channels(uint32_t Groups)
+{
+  std::vector<rec::ChannelSpec> channels;
+
+  if ((Groups & GROUP_ENV) != 0U)
+  {
+    AddFloats(channels, "press", 1U, "hPa");
+    AddFloats(channels, "temp", 1U, "degC");
+    AddFloats(channels, "hum", 1U, "%");
+  }
+  if ((Groups & GROUP_ACC) != 0U)
+  {
+    AddAxes(channels, "acc", "mg");
+  }
+  if ((Groups & GROUP_GYR) != 0U)
+  {
+    AddAxes(channels, "gyr", "mdps");
+  }
+  if ((Groups & GROUP_MAG) != 0U)
+  {
+    AddAxes(channels, "mag", "mgauss");
+  }
+  if ((Groups & GROUP_FUSION) != 0U)
+  {
+    AddFloats(channels, "quat", 4U, "");
+    AddFloats(channels, "rot", 3U, "deg");
+    AddFloats(channels, "grav", 3U, "g");
+    AddFloats(channels, "linacc", 3U, "g");
+    AddFloats(channels, "heading", 1U, "deg");
+    AddFloats(channels, "heading_err", 1U, "deg");
+    channels.push_back({ "fx_time", rec::Type::I32, "us", 1.0F });
+  }
+  if ((Groups & GROUP_MLC) != 0U)
+  {
+    channels.push_back({ "mlc_code", rec::Type::U8, "", 1.0F });
+    channels.push_back({ "mlc_events", rec::Type::U8, "", 1.0F });
+  }
+
+  return channels;
+}
+
+/**
+  * @brief  Write one sample, in the order of Channels
+  * @param  Writer the recording
+  * @param  Groups the group mask
+  * @param  S the sample
+  * @param  Time the timestamp [us]
+  * @retval None
+  */
+static void WriteSample(rec::Writer &Writer, uint32_t Groups, const tmsg::Sample &S, int64_t Time)
+{
+  uint32_t ch = 1U;
+
+  Writer.BeginRow(Time);
+
+  if ((Groups & GROUP_ENV) != 0U)
+  {
+    Writer.Put(ch++, S.Press);
+    Writer.Put(ch++, S.Temp);
+    Writer.Put(ch++, S.Hum);
+  }
+  if ((Groups & GROUP_ACC) != 0U)
+  {
+    for (int32_t v : S.Acc)
+    {
+      Writer.Put(ch++, v);
+    }
+  }
+  if ((Groups & GROUP_GYR) != 0U)
+  {
+    for (int32_t v : S.Gyr)
+    {
+      Writer.Put(ch++, v);
+    }
+  }
+  if ((Groups & GROUP_MAG) != 0U)
+  {
+    for (int32_t v : S.Mag)
+    {
+      Writer.Put(ch++, v);
+    }
+  }
+  if ((Groups & GROUP_FUSION) != 0U)
+  {
+    for (float v : S.Quat)
+    {
+      Writer.Put(ch++, v);
+    }
+    for (float v : S.Rotation)
+    {
+      Writer.Put(ch++, v);
+    }
+    for (float v : S.Gravity)
+    {
+      Writer.Put(ch++, v);
+    }
+    for (float v : S.LinAcc)
+    {
+      Writer.Put(ch++, v);
+    }
+    Writer.Put(ch++, S.Heading);
+    Writer.Put(ch++, S.HeadingErr);
+    Writer.Put(ch++, S.FxTime);
+  }
+  if ((Groups & GROUP_MLC) != 0U)
+  {
+    Writer.Put(ch++, S.MlcCode);
+    Writer.Put(ch++, S.MlcEvents);
+  }
+
+  Writer.EndRow();
+}
+
+/**
+  * @brief  Print the fusion output format and its coding error
+  * @param  S a sample in that format
+  * @retval None
+  */
+static void PrintFusionFormat(const tmsg::Sample &S)
+{
+  tmsg::FxBounds b = tmsg::Bounds(S.FxFormat, S.AngleFrac, S.AccFrac);
+
+  if (S.FxFormat == tmsg::kFxFloat)
+  {
+    std::printf("fusion outputs: float, exact\n");
+    return;
+  }
+
+  if (S.FxFormat == tmsg::kFxFixed)
+  {
+    std::printf("fusion outputs: fixed point, %u fractional bits for angles, %u for accelerations\n", S.AngleFrac,
+                S.AccFrac);
+  }
+  else
+  {
+    std::printf("fusion outputs: half float\n");
+  }
+
+  std::printf("  quaternion   +/-%.2g per component, %.2g deg rotation\n", static_cast<double>(b.Quat),
+              static_cast<double>(b.QuatAngle));
+  std::printf("  angles       +/-(%.2g + %.2g |v|) deg, up to %.6g deg\n", static_cast<double>(b.AngleAbs),
+              static_cast<double>(b.AngleRel), static_cast<double>(b.AngleRange));
+  std::printf("  acc, gravity +/-(%.2g + %.2g |v|) g, up to %.6g g\n", static_cast<double>(b.AccAbs),
+              static_cast<double>(b.AccRel), static_cast<double>(b.AccRange));
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t groups = GROUP_DEFAULT;
+  bool explicit_groups = false;
+  uint32_t chunk_rows = rec::kDefaultChunkRows;
+  std::vector<uint8_t> buffer(READ_SIZE);
+  std::vector<tmsg::Sample> samples;
+  tmsg::Decoder decoder;
+  tmsg::Clock clock;
+  tmsg::Sample format = {};
+  bool mixed = false;
+  rec::Writer writer;
+  bool opened = false;
+  std::FILE *in;
+  size_t len;
+  int arg = 1;
+
+  while ((arg < argc) && (argv[arg][0] == '-') && (argv[arg][1] != '\0'))
+  {
+    if ((std::strcmp(argv[arg], "-c") == 0) && ((arg + 1) < argc))
+    {
+      groups = ParseGroups(argv[++arg]);
+      explicit_groups = true;
+    }
+    else if ((std::strcmp(argv[arg], "-r") == 0) && ((arg + 1) < argc))
+    {
+      chunk_rows = static_cast<uint32_t>(std::strtoul(argv[++arg], nullptr, 0));
+    }
+    else if ((std::strcmp(argv[arg], "-f") == 0) && ((arg + 1) < argc) && ParseFormat(argv[arg + 1], decoder))
+    {
+      arg++;
+    }
+    else
+    {
+      Usage();
+      return 2;
+    }
+    arg++;
+  }
+
+  if (((argc - arg) != 2) || (groups == 0U) || (chunk_rows == 0U))
+  {
+    Usage();
+    return 2;
+  }
+
+  in = (std::strcmp(argv[arg], "-") == 0) ? stdin : std::fopen(argv[arg], "rb");
+  if (in == nullptr)
+  {
+    std::fprintf(stderr, "cannot open %s\n", argv[arg]);
+    return 1;
+  }
+
+  while ((len = std::fread(buffer.data(), 1U, buffer.size(), in)) > 0U)
+  {
+    samples.clear();
+    decoder.Feed(buffer.data(), len, samples);
+
+    for (const tmsg::Sample &s : samples)
+    {
+      if (!opened)
+      {
+        /* The MLC bytes are only in the stream when the GUI enabled them,
+         * a subscription may leave out any group. Fields missing from a
+         * kept group are written as 0. */
+        if (!explicit_groups)
+        {
+          groups &= Groups(s.Fields);
+        }
+
+        if (!writer.Open(argv[arg + 1], Channels(groups), chunk_rows, "tmsg2rec"))
+        {
+          std::fprintf(stderr, "%s\n", writer.LastError().c_str());
+          return 1;
+        }
+        opened = true;
+        format = s;
+      }
+
+      /* The GUI may switch the fusion format while streaming */
+      if ((s.FxFormat != format.FxFormat) || (s.AngleFrac != format.AngleFrac) || (s.AccFrac != format.AccFrac))
+      {
+        mixed = true;
+        format = s;
+      }
+
+      WriteSample(writer, groups, s, clock.Update(s));
+    }
+  }
+
+  if (in != stdin)
+  {
+    std::fclose(in);
+  }
+
+  if (!opened)
+  {
+    std::fprintf(stderr, "no streaming frame found\n");
+    if (decoder.GetStats().NoFormat != 0U)
+    {
+      std::fprintf(stderr, "%llu compact frames without their fusion format, see -f\n",
+                   static_cast<unsigned long long>(decoder.GetStats().NoFormat));
+    }
+    return 1;
+  }
+
+  if (!writer.Close())
+  {
+    std::fprintf(stderr, "%s\n", writer.LastError().c_str());
+    return 1;
+  }
+
+  const tmsg::Stats &stats = decoder.GetStats();
+  std::printf("%llu frames, %llu samples (%llu subscribed), %llu bad stuffing, %llu bad checksum, %llu other\n",
+              static_cast<unsigned long long>(stats.Frames), static_cast<unsigned long long>(stats.Samples),
+              static_cast<unsigned long long>(stats.Subscribed),
+              static_cast<unsigned long long>(stats.BadStuffing), static_cast<unsigned long long>(stats.BadChecksum),
+              static_cast<unsigned long long>(stats.Other));
+  if (stats.NoFormat != 0U)
+  {
+    std::printf("%llu compact frames skipped before the fusion format was known, see -f\n",
+                static_cast<unsigned long long>(stats.NoFormat));
+  }
+  if ((groups & GROUP_FUSION) != 0U)
+  {
+    if (mixed)
+    {
+      std::printf("fusion format changed during the capture, last one:\n");
+    }
+    PrintFusionFormat(format);
+  }
+
+  return 0;
+}
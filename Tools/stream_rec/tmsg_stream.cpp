@@ -0,0 +1,512 @@
+/**
+  ******************************************************************************
+  * @file    tmsg_stream.cpp
+  * @author  ISCA Lab
+  * @brief   Decoder for the DataLogFusion TMsg streaming frames
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "tmsg_stream.hpp"
+
+namespace tmsg
+{
+
+static constexpr int64_t kDayUs = 24LL * 3600LL * 1000000LL;
+
+/* Field sizes in bit order, as MEMS/Target/stream_plan.c */
+static constexpr uint8_t kFloatSizes[kFieldCount] = { 12U, 12U, 12U, 12U, 16U, 12U, 12U, 12U, 8U, 4U, 2U };
+static constexpr uint8_t kCompactSizes[kFieldCount] = { 12U, 12U, 12U, 12U, 7U, 6U, 6U, 6U, 4U, 4U, 2U };
+
+/**
+  * @brief  Read a little-endian int32 (Serialize_s32 on the target)
+  * @param  Data the bytes
+  * @retval The value
+  */
+static int32_t GetS32(const uint8_t *Data)
+{
+  return static_cast<int32_t>(static_cast<uint32_t>(Data[0]) | (static_cast<uint32_t>(Data[1]) << 8)
+                              | (static_cast<uint32_t>(Data[2]) << 16) | (static_cast<uint32_t>(Data[3]) << 24));
+}
+
+/**
+  * @brief  Read floats copied with memcpy on the target
+  * @param  Dest the values
+  * @param  Data the bytes
+  * @param  Count the number of floats
+  * @retval None
+  */
+static void GetF32(float *Dest, const uint8_t *Data, size_t Count)
+{
+  std::memcpy(Dest, Data, Count * sizeof(float));
+}
+
+/**
+  * @brief  Read a little-endian uint16
+  * @param  Data the bytes
+  * @retval The value
+  */
+static uint16_t GetU16(const uint8_t *Data)
+{
+  return static_cast<uint16_t>(Data[0] | (Data[1] << 8));
+}
+
+/**
+  * @brief  Read 16 bit fusion values
+  * @param  Dest the values
+  * @param  Data the bytes
+  * @param  Count the number of values
+  * @param  Format kFxHalf or kFxFixed
+  * @param  Frac the fractional bits (fixed point)
+  * @retval None
+  */
+static void GetFx(float *Dest, const uint8_t *Data, size_t Count, uint8_t Format, uint8_t Frac)
+{
+  for (size_t i = 0U; i < Count; i++)
+  {
+    uint16_t v = GetU16(&Data[2U * i]);
+
+    Dest[i] = (Format == kFxHalf) ? HalfToFloat(v) : std::ldexp(static_cast<float>(static_cast<int16_t>(v)), -Frac);
+  }
+}
+
+/**
+  * @brief  Convert an IEEE 754 half float
+  * @param  Half the half float bits
+  * @retval The value
+  */
+float HalfToFloat(uint16_t Half)
+{
+  int exp = (Half >> 10) & 0x1F;
+  float mant = static_cast<float>(Half & 0x3FFU);
+  float value;
+
+  if (exp == 0x1F)
+  {
+    value = (mant != 0.0F) ? NAN : INFINITY;
+  }
+  else if (exp == 0)
+  {
+    value = std::ldexp(mant, -24);
+  }
+  else
+  {
+    value = std::ldexp(mant + 1024.0F, exp - 25);
+  }
+
+  return ((Half & 0x8000U) != 0U) ? -value : value;
+}
+
+/**
+  * @brief  Unpack a smallest three quaternion
+  * @param  Data the 7 bytes
+  * @param  Quat the unit quaternion, largest component positive
+  * @retval None
+  */
+void UnpackQuat(const uint8_t *Data, float Quat[4])
+{
+  const uint64_t max = (1ULL << kQuatBits) - 1ULL;
+  uint64_t bits = 0U;
+  uint32_t largest;
+  uint32_t shift = 2U;
+  double sum = 0.0;
+
+  for (size_t i = 0U; i < 7U; i++)
+  {
+    bits |= static_cast<uint64_t>(Data[i]) << (8U * i);
+  }
+
+  largest = static_cast<uint32_t>(bits & 3U);
+
+  for (uint32_t i = 0U; i < 4U; i++)
+  {
+    if (i != largest)
+    {
+      double v = ((static_cast<double>((bits >> shift) & max) * 2.0 / static_cast<double>(max)) - 1.0) / std::sqrt(2.0);
+
+      Quat[i] = static_cast<float>(v);
+      sum += v * v;
+      shift += kQuatBits;
+    }
+  }
+
+  Quat[largest] = static_cast<float>(std::sqrt(std::max(0.0, 1.0 - sum)));
+}
+
+/**
+  * @brief  Worst case coding error of a fusion format
+  * @note   The quaternion bound is against the normalized quaternion with its
+  *         largest component positive. The three sent components are off by
+  *         half a step, the restored one by at most three times that (its
+  *         value is at least 1/2). The encoder rounds in float, 5% margin.
+  * @param  Format kFxFloat, kFxHalf or kFxFixed
+  * @param  AngleFrac fixed point fractional bits of the angles
+  * @param  AccFrac fixed point fractional bits of the accelerations
+  * @retval The bounds
+  */
+FxBounds Bounds(uint8_t Format, uint8_t AngleFrac, uint8_t AccFrac)
+{
+  FxBounds b = {};
+  double half_step = 1.05 / (std::sqrt(2.0) * static_cast<double>((1ULL << kQuatBits) - 1ULL));
+
+  if (Format == kFxFloat)
+  {
+    return b;
+  }
+
+  b.Quat = static_cast<float>(3.0 * half_step);
+  b.QuatAngle = static_cast<float>(2.0 * std::sqrt(12.0) * half_step * 180.0 / M_PI);
+
+  if (Format == kFxHalf)
+  {
+    b.AngleAbs = b.AccAbs = std::ldexp(1.0F, -25);
+    b.AngleRel = b.AccRel = std::ldexp(1.0F, -11);
+    b.AngleRange = b.AccRange = 65504.0F;
+  }
+  else
+  {
+    b.AngleAbs = std::ldexp(1.0F, -(AngleFrac + 1));
+    b.AccAbs = std::ldexp(1.0F, -(AccFrac + 1));
+    b.AngleRange = std::ldexp(32767.0F, -AngleFrac);
+    b.AccRange = std::ldexp(32767.0F, -AccFrac);
+  }
+
+  return b;
+}
+
+/**
+  * @brief  Name of a fusion format
+  * @param  Format the format
+  * @retval The name
+  */
+const char *FormatName(uint8_t Format)
+{
+  return (Format == kFxFloat) ? "float" : ((Format == kFxHalf) ? "half" : ((Format == kFxFixed) ? "fixed" : "?"));
+}
+
+/**
+  * @brief  Size of a stream field
+  * @param  Field one kField* bit
+  * @param  Format the fusion format
+  * @retval The size in bytes, 0 for an unknown field
+  */
+size_t FieldSize(uint16_t Field, uint8_t Format)
+{
+  for (uint32_t i = 0U; i < kFieldCount; i++)
+  {
+    if (Field == (1U << i))
+    {
+      return (Format == kFxFloat) ? kFloatSizes[i] : kCompactSizes[i];
+    }
+  }
+
+  return 0U;
+}
+
+/**
+  * @brief  Set the fusion format of the compact frames that follow
+  * @note   For a capture started after the CMD_Stream_Format reply, a reply
+  *         in the capture overrides it.
+  * @param  Format kFxFloat, kFxHalf or kFxFixed
+  * @param  AngleFrac kFxFixed: fractional bits of the angles
+  * @param  AccFrac kFxFixed: fractional bits of the accelerations
+  * @retval false if the settings are not valid, the format is kept
+  */
+bool Decoder::SetFormat(uint8_t Format, uint8_t AngleFrac, uint8_t AccFrac)
+{
+  if ((Format > kFxFixed) || (AngleFrac > 15U) || (AccFrac > 15U))
+  {
+    return false;
+  }
+
+  FxFormat = Format;
+  this->AngleFrac = (Format == kFxFixed) ? AngleFrac : 0U;
+  this->AccFrac = (Format == kFxFixed) ? AccFrac : 0U;
+
+  return true;
+}
+
+/**
+  * @brief  Unstuff the input and decode every complete frame
+  * @param  Data raw serial bytes
+  * @param  Len the length
+  * @param  Out the decoded samples are appended here
+  * @retval None
+  */
+void Decoder::Feed(const uint8_t *Data, size_t Len, std::vector<Sample> &Out)
+{
+  for (size_t i = 0U; i < Len; i++)
+  {
+    uint8_t byte = Data[i];
+
+    if (byte == kEof)
+    {
+      Frame(Out);
+      Buffer.clear();
+      Escape = false;
+      Broken = false;
+    }
+    else if (Escape)
+    {
+      Escape = false;
+      if (byte == kBs)
+      {
+        Buffer.push_back(kBs);
+      }
+      else if (byte == kBsEof)
+      {
+        Buffer.push_back(kEof);
+      }
+      else
+      {
+        Broken = true;
+      }
+    }
+    else if (byte == kBs)
+    {
+      Escape = true;
+    }
+    else
+    {
+      Buffer.push_back(byte);
+    }
+  }
+}
+
+/**
+  * @brief  Read fusion outputs in the format of the sample
+  * @param  Dest the values
+  * @param  Data the bytes
+  * @param  Count the number of values
+  * @param  S the sample, with its fusion format set
+  * @param  Frac the fractional bits (fixed point)
+  * @retval None
+  */
+static void GetOutputs(float *Dest, const uint8_t *Data, size_t Count, const Sample &S, uint8_t Frac)
+{
+  if (S.FxFormat == kFxFloat)
+  {
+    GetF32(Dest, Data, Count);
+  }
+  else
+  {
+    GetFx(Dest, Data, Count, S.FxFormat, Frac);
+  }
+}
+
+/**
+  * @brief  Decode consecutive fields
+  * @param  S the sample, with its fusion format set
+  * @param  Data the first field
+  * @param  Fields the kField* mask, the fields follow in bit order
+  * @retval None
+  */
+static void DecodeFields(Sample &S, const uint8_t *Data, uint16_t Fields)
+{
+  const uint8_t *p = Data;
+  bool compact = (S.FxFormat != kFxFloat);
+
+  for (uint32_t i = 0U; i < kFieldCount; i++)
+  {
+    uint16_t field = static_cast<uint16_t>(1U << i);
+
+    if ((Fields & field) == 0U)
+    {
+      continue;
+    }
+
+    switch (field)
+    {
+      case kFieldEnv:
+        GetF32(&S.Press, &p[0], 1U);
+        GetF32(&S.Temp, &p[4], 1U);
+        GetF32(&S.Hum, &p[8], 1U);
+        break;
+      case kFieldAcc:
+      case kFieldGyr:
+      case kFieldMag:
+        for (size_t j = 0U; j < 3U; j++)
+        {
+          int32_t *axes = (field == kFieldAcc) ? S.Acc : ((field == kFieldGyr) ? S.Gyr : S.Mag);
+          axes[j] = GetS32(&p[4U * j]);
+        }
+        break;
+      case kFieldQuat:
+        if (compact)
+        {
+          UnpackQuat(p, S.Quat);
+        }
+        else
+        {
+          GetF32(S.Quat, p, 4U);
+        }
+        break;
+      case kFieldRot:
+        GetOutputs(S.Rotation, p, 3U, S, S.AngleFrac);
+        break;
+      case kFieldGrav:
+        GetOutputs(S.Gravity, p, 3U, S, S.AccFrac);
+        break;
+      case kFieldLinAcc:
+        GetOutputs(S.LinAcc, p, 3U, S, S.AccFrac);
+        break;
+      case kFieldHeading:
+        GetOutputs(&S.Heading, p, 1U, S, S.AngleFrac);
+        GetOutputs(&S.HeadingErr, &p[compact ? 2U : 4U], 1U, S, S.AngleFrac);
+        break;
+      case kFieldTiming:
+        S.FxTime = GetS32(p);
+        break;
+      default:
+        S.MlcCode = p[0];
+        S.MlcEvents = p[1];
+        break;
+    }
+
+    p += FieldSize(field, S.FxFormat);
+  }
+
+  S.Fields = Fields;
+  S.HasMlc = ((Fields & kFieldMlc) != 0U);
+}
+
+/**
+  * @brief  Check and decode the buffered frame
+  * @param  Out the decoded sample is appended here
+  * @retval None
+  */
+void Decoder::Frame(std::vector<Sample> &Out)
+{
+  const uint8_t *d = Buffer.data();
+  uint8_t chk = 0U;
+  size_t len;
+  size_t expected;
+  uint16_t fields;
+  Sample s = {};
+
+  if (Buffer.empty())
+  {
+    return;
+  }
+
+  Counters.Frames++;
+
+  if (Broken || Escape)
+  {
+    Counters.BadStuffing++;
+    return;
+  }
+
+  for (uint8_t byte : Buffer)
+  {
+    chk = static_cast<uint8_t>(chk + byte);
+  }
+
+  if (chk != 0U)
+  {
+    Counters.BadChecksum++;
+    return;
+  }
+
+  len = Buffer.size() - 1U;
+  s.FxFormat = FxFormat;
+  s.AngleFrac = AngleFrac;
+  s.AccFrac = AccFrac;
+
+  if ((len == kFormatReply) && (d[2] == (kCmdStreamFormat | kCmdReply)))
+  {
+    /* The format of the compact frames from here on */
+    if (SetFormat(d[3], d[4], d[5]))
+    {
+      Counters.Formats++;
+    }
+    else
+    {
+      Counters.Other++;
+    }
+    return;
+  }
+  else if ((len >= kSubHeader) && (d[2] == kCmdStreamSubscribe))
+  {
+    /* Subscribed frame: the length follows from the mask and the format */
+    fields = GetU16(&d[7]);
+    expected = kSubHeader;
+    for (uint32_t i = 0U; i < kFieldCount; i++)
+    {
+      expected += FieldSize(fields & static_cast<uint16_t>(1U << i), s.FxFormat);
+    }
+
+    if ((fields == 0U) || ((fields & ~kFieldAll) != 0U) || (len != expected))
+    {
+      Counters.Other++;
+      return;
+    }
+
+    DecodeFields(s, &d[kSubHeader], fields);
+    Counters.Subscribed++;
+  }
+  else if ((d[2] == kCmdStartDataStreaming) && ((len == kStreamLength) || (len == kStreamLengthMlc)))
+  {
+    s.FxFormat = kFxFloat;
+    s.AngleFrac = 0U;
+    s.AccFrac = 0U;
+    DecodeFields(s, &d[7], (len == kStreamLengthMlc) ? kFieldAll : (kFieldAll & ~kFieldMlc));
+  }
+  else if ((d[2] == kCmdStartDataStreaming) && ((len == kStreamLengthCompact) || (len == kStreamLengthCompactMlc)))
+  {
+    if (s.FxFormat == kFxFloat)
+    {
+      Counters.NoFormat++;
+      return;
+    }
+
+    DecodeFields(s, &d[7], (len == kStreamLengthCompactMlc) ? kFieldAll : (kFieldAll & ~kFieldMlc));
+  }
+  else
+  {
+    Counters.Other++;
+    return;
+  }
+
+  s.Hours = d[3];
+  s.Minutes = d[4];
+  s.Seconds = d[5];
+  s.Subsec = d[6];
+
+  Out.push_back(s);
+  Counters.Samples++;
+}
+
+/**
+  * @brief  Get the timestamp of the next sample
+  * @note   A time of day going back by more than 12 h is a midnight
+  *         rollover, a smaller step back (RTC set by the GUI) is kept.
+  * @param  S the sample
+  * @retval Microseconds since midnight of the first sample's day
+  */
+int64_t Clock::Update(const Sample &S)
+{
+  int64_t now = ((((static_cast<int64_t>(S.Hours) * 60) + S.Minutes) * 60 + S.Seconds) * 1000000LL)
+                + (static_cast<int64_t>(S.Subsec) * 10000LL);
+
+  if ((Last >= 0) && ((Last - now) > (kDayUs / 2)))
+  {
+    Offset += kDayUs;
+  }
+
+  Last = now;
+
+  return Offset + now;
+}
+
+} /* namespace tmsg */
@@ -0,0 +1,187 @@
+/**
+  ******************************************************************************
+  * @file    tmsg_stream.hpp
+  * @author  ISCA Lab
+  * @brief   Decoder for the DataLogFusion TMsg streaming frames
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#ifndef TMSG_STREAM_HPP
+#define TMSG_STREAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Host side of MEMS/Target/serial_protocol.c and the streaming message built
+ * by MEMS/App/app_mems.c: frames are byte-stuffed and end with TMsg_EOF,
+ * the last byte is a checksum (all bytes sum to 0). A streaming frame is
+ * STREAMING_MSG_LENGTH bytes, STREAMING_MSG_LENGTH_MLC with the MLC output.
+ *
+ * With a compact fusion format (CMD_Stream_Format) the fusion outputs are the
+ * MEMS/Target/fusion_codec.h block and the frame is
+ * STREAMING_MSG_LENGTH_COMPACT bytes, or STREAMING_MSG_LENGTH_COMPACT_MLC.
+ * They are decoded to the same Sample, Bounds gives the coding error. The
+ * block does not carry its format: the decoder takes it from the last
+ * CMD_Stream_Format reply, which the firmware also sends after starting the
+ * stream, or from SetFormat for a capture that missed it.
+ *
+ * With a subscription (CMD_Stream_Subscribe) the frame is tagged with that
+ * command and only carries the subscribed fields, see
+ * MEMS/Target/stream_plan.h. Sample::Fields tells which ones were decoded,
+ * the others are 0.
+ */
+
+namespace tmsg
+{
+
+constexpr uint8_t kEof = 0xF0U;
+constexpr uint8_t kBs = 0xF1U;
+constexpr uint8_t kBsEof = 0xF2U;
+constexpr uint8_t kCmdStartDataStreaming = 0x08U;
+constexpr uint8_t kCmdStreamFormat = 0x13U;
+constexpr uint8_t kCmdStreamSubscribe = 0x14U;
+constexpr uint8_t kCmdReply = 0x80U;
+constexpr size_t kStreamLength = 119U;
+constexpr size_t kStreamLengthMlc = 121U;
+constexpr size_t kStreamLengthCompact = 88U;
+constexpr size_t kStreamLengthCompactMlc = 90U;
+constexpr size_t kFxOffset = 55U;
+constexpr size_t kFxSize = 29U;
+constexpr uint32_t kQuatBits = 18U;
+constexpr size_t kSubHeader = 9U;
+constexpr size_t kFormatReply = 6U;
+
+/* Stream fields, STREAM_FIELD_* */
+constexpr uint16_t kFieldEnv = 0x0001U;
+constexpr uint16_t kFieldAcc = 0x0002U;
+constexpr uint16_t kFieldGyr = 0x0004U;
+constexpr uint16_t kFieldMag = 0x0008U;
+constexpr uint16_t kFieldQuat = 0x0010U;
+constexpr uint16_t kFieldRot = 0x0020U;
+constexpr uint16_t kFieldGrav = 0x0040U;
+constexpr uint16_t kFieldLinAcc = 0x0080U;
+constexpr uint16_t kFieldHeading = 0x0100U;
+constexpr uint16_t kFieldTiming = 0x0200U;
+constexpr uint16_t kFieldMlc = 0x0400U;
+constexpr uint16_t kFieldAll = 0x07FFU;
+constexpr uint32_t kFieldCount = 11U;
+
+/* Fusion output formats, FUSION_CODEC_Format_t */
+constexpr uint8_t kFxFloat = 0U;
+constexpr uint8_t kFxHalf = 1U;
+constexpr uint8_t kFxFixed = 2U;
+
+struct Sample
+{
+  uint8_t Hours;
+  uint8_t Minutes;
+  uint8_t Seconds;
+  uint8_t Subsec;       /* 1/100 s */
+  float Press;          /* [hPa] */
+  float Temp;           /* [degC] */
+  float Hum;            /* [%] */
+  int32_t Acc[3];       /* [mg] */
+  int32_t Gyr[3];       /* [mdps] */
+  int32_t Mag[3];       /* [mgauss] */
+  float Quat[4];
+  float Rotation[3];    /* [deg] */
+  float Gravity[3];     /* [g] */
+  float LinAcc[3];      /* [g] */
+  float Heading;        /* [deg] */
+  float HeadingErr;     /* [deg] */
+  int32_t FxTime;       /* Fusion run time [us] */
+  uint16_t Fields;      /* kField* decoded from the frame */
+  uint8_t FxFormat;     /* kFxFloat, kFxHalf or kFxFixed */
+  uint8_t AngleFrac;    /* kFxFixed: fractional bits of rotation and heading */
+  uint8_t AccFrac;      /* kFxFixed: fractional bits of gravity and linear acceleration */
+  bool HasMlc;          /* Same as Fields & kFieldMlc */
+  uint8_t MlcCode;
+  uint8_t MlcEvents;    /* Wraps */
+};
+
+/*
+ * Worst case coding error of the fusion outputs: a decoded value v is within
+ * Abs + Rel * |v| of the sent one, inside +/-Range (fixed point saturates
+ * there). All zero for the float format.
+ */
+struct FxBounds
+{
+  float Quat;           /* Per component */
+  float QuatAngle;      /* Rotation between sent and decoded quaternion [deg] */
+  float AngleAbs;       /* [deg] */
+  float AngleRel;
+  float AngleRange;     /* [deg] */
+  float AccAbs;         /* [g] */
+  float AccRel;
+  float AccRange;       /* [g] */
+};
+
+struct Stats
+{
+  uint64_t Frames;      /* Frames delimited by EOF */
+  uint64_t Samples;     /* Streaming frames decoded */
+  uint64_t Subscribed;  /* Of which subscribed frames */
+  uint64_t Formats;     /* CMD_Stream_Format replies */
+  uint64_t NoFormat;    /* Compact frames seen before any format was known */
+  uint64_t BadStuffing;
+  uint64_t BadChecksum;
+  uint64_t Other;       /* Replies and unknown lengths */
+};
+
+float HalfToFloat(uint16_t Half);
+void UnpackQuat(const uint8_t *Data, float Quat[4]);
+FxBounds Bounds(uint8_t Format, uint8_t AngleFrac, uint8_t AccFrac);
+const char *FormatName(uint8_t Format);
+size_t FieldSize(uint16_t Field, uint8_t Format);
+
+/*
+ * Feed raw serial bytes in any slicing, each decoded streaming frame is
+ * appended to the output. The decoder keeps the partial frame between
+ * calls.
+ */
+class Decoder
+{
+public:
+  void Feed(const uint8_t *Data, size_t Len, std::vector<Sample> &Out);
+  bool SetFormat(uint8_t Format, uint8_t AngleFrac, uint8_t AccFrac);
+  const Stats &GetStats() const { return Counters; }
+
+private:
+  void Frame(std::vector<Sample> &Out);
+
+  std::vector<uint8_t> Buffer;
+  bool Escape = false;
+  bool Broken = false;
+  uint8_t FxFormat = kFxFloat;  /* Until a reply says otherwise, as the firmware boots */
+  uint8_t AngleFrac = 0U;
+  uint8_t AccFrac = 0U;
+  Stats Counters = {};
+};
+
+/*
+ * Turns the RTC time of day of consecutive samples into a monotonic
+ * timestamp. The stream only carries 1/100 s: samples inside the same
+ * 10 ms step keep the same time.
+ */
+class Clock
+{
+public:
+  int64_t Update(const Sample &S);
+
+private:
+  int64_t Last = -1;    /* Previous time of day [us] */
+  int64_t Offset = 0;   /* Days elapsed [us] */
+};
+
+} /* namespace tmsg */
+
+#endif /* TMSG_STREAM_HPP */
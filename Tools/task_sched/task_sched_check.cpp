@@ -0,0 +1,495 @@
+/**
+  ******************************************************************************
+  * @file    task_sched_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the cooperative task scheduler on a simulated clock
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "task_sched.h"
+
+/*
+ * Runs the firmware task_sched.c on a host. The clock is a counter the
+ * handlers advance by their run time, so every latency and run time is
+ * known in advance:
+ *
+ *  - priority: a ready task of a higher priority always runs first,
+ *  - round robin: tasks of the same priority that keep reposting
+ *    themselves take strict turns, whatever the ids ready,
+ *  - timers: periodic, one-shot, stop, NextTimer, periods missed during a
+ *    long task skipped and not queued, and a clock wrapping at 2^32,
+ *  - statistics: runs, latency, run time and deadline misses,
+ *  - interrupts: a post from the clock callback, at each point the
+ *    scheduler reads the clock, and from a thread while the scheduler
+ *    runs; no post may be lost between the ready bit and the event mask,
+ *  - errors: registration before TASK_SCHED_Init, bad priority, too many
+ *    tasks, bad ids.
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+static std::atomic<uint32_t> Now(0);
+static int32_t PostOnCall = -1;            /* Clock call that posts, -1 none */
+static uint32_t PostId;
+static uint32_t PostEvents;
+static std::vector<uint32_t> Trace;        /* Task ids in the order they ran */
+static std::vector<uint32_t> TraceEvents;  /* Events of each run */
+static uint32_t RunTime[TASK_SCHED_MAX_TASKS];
+static uint32_t Ids[TASK_SCHED_MAX_TASKS];
+static uint32_t Repost[TASK_SCHED_MAX_TASKS];
+
+/**
+  * @brief  Scheduler clock, posts on the call set by PostOnCall
+  * @retval The simulated time
+  */
+static uint32_t Clock(void)
+{
+  /* Stands for an interrupt posting at this point of the scheduler */
+  if ((PostOnCall >= 0) && (PostOnCall-- == 0))
+  {
+    TASK_SCHED_Post(PostId, PostEvents);
+  }
+  return Now.load();
+}
+
+/**
+  * @brief  Handler body shared by the tasks: trace, take the run time, repost
+  * @param  Task the task index
+  * @param  Events the events
+  * @retval None
+  */
+static void Body(uint32_t Task, uint32_t Events)
+{
+  Trace.push_back(Task);
+  TraceEvents.push_back(Events);
+  Now += RunTime[Task];
+  if (Repost[Task] != 0U)
+  {
+    Repost[Task]--;
+    TASK_SCHED_Post(Ids[Task], 1U);
+  }
+}
+
+template <uint32_t N>
+static void Handler(uint32_t Events)
+{
+  Body(N, Events);
+}
+
+static const TASK_SCHED_Handler_t Handlers[TASK_SCHED_MAX_TASKS] =
+{
+  Handler<0>, Handler<1>, Handler<2>, Handler<3>, Handler<4>, Handler<5>, Handler<6>, Handler<7>,
+};
+
+/**
+  * @brief  Restart the scheduler with a set of tasks
+  * @param  Defs the tasks, Handler filled here
+  * @retval None
+  */
+static void Setup(std::vector<TASK_SCHED_Def_t> &Defs)
+{
+  TASK_SCHED_Init(Clock, nullptr);
+  Trace.clear();
+  TraceEvents.clear();
+  for (uint32_t i = 0; i < Defs.size(); i++)
+  {
+    Defs[i].Handler = Handlers[i];
+    RunTime[i] = 0;
+    Repost[i] = 0;
+    (void)TASK_SCHED_Register(&Defs[i], &Ids[i]);
+  }
+}
+
+/**
+  * @brief  Run until no task is ready
+  * @retval The number of runs
+  */
+static uint32_t Drain()
+{
+  uint32_t runs = 0;
+
+  while (TASK_SCHED_RunOnce() != 0U)
+  {
+    runs++;
+  }
+  return runs;
+}
+
+/**
+  * @brief  Print a check
+  * @param  Name the check
+  * @param  Pass the result
+  * @param  Detail printed after the name
+  * @retval Pass
+  */
+static bool Report(const char *Name, bool Pass, const std::string &Detail = "")
+{
+  std::printf("%-28s %-44s %s\n", Name, Detail.c_str(), Pass ? "ok" : "FAILED");
+  return Pass;
+}
+
+/**
+  * @brief  Check the order of the priorities
+  * @retval true if passed
+  */
+static bool Priorities()
+{
+  std::vector<TASK_SCHED_Def_t> defs =
+  {
+    { "low", nullptr, TASK_SCHED_PRIO_LOW, 0U, 0U },
+    { "normal", nullptr, TASK_SCHED_PRIO_NORMAL, 0U, 0U },
+    { "high", nullptr, TASK_SCHED_PRIO_HIGH, 0U, 0U },
+  };
+
+  Setup(defs);
+  TASK_SCHED_Post(Ids[0], 1U);
+  TASK_SCHED_Post(Ids[1], 1U);
+  TASK_SCHED_Post(Ids[2], 1U);
+
+  /* The normal task reposts the high one: it runs before the low one */
+  Repost[2] = 1;
+  bool ok = (Drain() == 4U) && (Trace == std::vector<uint32_t>{ 2, 2, 1, 0 });
+  return Report("priority", ok, "high, high again, normal, low");
+}
+
+/**
+  * @brief  Check the turns between tasks of the same priority
+  * @retval true if passed
+  */
+static bool RoundRobin()
+{
+  std::vector<TASK_SCHED_Def_t> defs(5, { "rr", nullptr, TASK_SCHED_PRIO_NORMAL, 0U, 0U });
+  bool ok = true;
+
+  /* Five tasks reposting themselves 100 times each run in strict turns */
+  Setup(defs);
+  for (uint32_t i = 0; i < 5U; i++)
+  {
+    Repost[i] = 99U;
+    TASK_SCHED_Post(Ids[4U - i], 1U);
+  }
+  ok &= (Drain() == 500U);
+  for (uint32_t n = 0; ok && (n < Trace.size()); n++)
+  {
+    ok = (Trace[n] == (n % 5U));
+  }
+
+  /* With 1 and 3 ready and 3 run last, 1 goes next then 3, not 3 twice */
+  Setup(defs);
+  TASK_SCHED_Post(Ids[3], 1U);
+  ok &= (TASK_SCHED_RunOnce() == 1U);
+  TASK_SCHED_Post(Ids[1], 1U);
+  TASK_SCHED_Post(Ids[3], 1U);
+  ok &= (Drain() == 2U) && (Trace == std::vector<uint32_t>{ 3, 1, 3 });
+
+  /* A task posted again while ready runs once with the events merged */
+  Setup(defs);
+  TASK_SCHED_Post(Ids[2], 0x1U);
+  TASK_SCHED_Post(Ids[2], 0x4U);
+  TASK_SCHED_Post(Ids[2], 0U);
+  ok &= (Drain() == 1U) && (TraceEvents == std::vector<uint32_t>{ 0x5U });
+
+  return Report("round robin", ok, "5 tasks x 100 runs in turn, merged events");
+}
+
+/**
+  * @brief  Check the task timers
+  * @param  Start the clock at the start
+  * @retval true if passed
+  */
+static bool Timers(uint32_t Start)
+{
+  std::vector<TASK_SCHED_Def_t> defs =
+  {
+    { "periodic", nullptr, TASK_SCHED_PRIO_NORMAL, 10U, 0U },
+    { "long", nullptr, TASK_SCHED_PRIO_HIGH, 0U, 0U },
+    { "oneshot", nullptr, TASK_SCHED_PRIO_LOW, 0U, 0U },
+  };
+  std::vector<uint32_t> fired;
+  uint32_t delay = 0;
+  bool ok = true;
+
+  Now = Start;
+  Setup(defs);
+  TASK_SCHED_SetTimer(Ids[2], 25U, 0U);
+  ok &= (TASK_SCHED_NextTimer(&delay) == TASK_SCHED_OK) && (delay == 10U);
+
+  /* One tick at a time up to 100, a 35 tick task posted at 42 */
+  RunTime[1] = 35U;
+  for (uint32_t t = 0; t <= 100U; t++)
+  {
+    Now = Start + t;
+    if (t == 42U)
+    {
+      TASK_SCHED_Post(Ids[1], 1U);
+    }
+    while (TASK_SCHED_RunOnce() != 0U)
+    {
+      if ((Trace.back() != 1U) && (TraceEvents.back() == TASK_SCHED_EVT_TIMER))
+      {
+        fired.push_back(((Trace.back() == 0U) ? 0U : 1000U) + (Now.load() - Start));
+      }
+    }
+    t = Now.load() - Start;
+  }
+
+  /* Periodic at 10..40, the long task ends at 77 after 50, 60 and 70 were
+   * due: one run at 77, then 87 and 97. The one-shot at 25 only */
+  std::vector<uint32_t> expect = { 10, 20, 1025, 30, 40, 77, 87, 97 };
+  ok &= (fired == expect);
+
+  ok &= (TASK_SCHED_NextTimer(&delay) == TASK_SCHED_OK) && (delay == 7U);
+  Now = Start + 120U;
+  ok &= (TASK_SCHED_NextTimer(&delay) == TASK_SCHED_OK) && (delay == 0U);
+  TASK_SCHED_StopTimer(Ids[0]);
+  ok &= (TASK_SCHED_NextTimer(&delay) == TASK_SCHED_ERROR) && (Drain() == 0U);
+
+  char detail[64];
+  std::snprintf(detail, sizeof(detail), "clock from 0x%08X, %zu fires", Start, fired.size());
+  return Report("timers", ok, detail);
+}
+
+/**
+  * @brief  Check the statistics and the deadline misses
+  * @retval true if passed
+  */
+static bool Statistics()
+{
+  std::vector<TASK_SCHED_Def_t> defs =
+  {
+    { "blocker", nullptr, TASK_SCHED_PRIO_HIGH, 0U, 0U },
+    { "deadline", nullptr, TASK_SCHED_PRIO_NORMAL, 0U, 5U },
+  };
+  TASK_SCHED_Stats_t stats = {};
+  bool ok = true;
+
+  Now = 1000U;
+  Setup(defs);
+  RunTime[0] = 3U;
+  RunTime[1] = 2U;
+
+  /* Alone: latency 0, run 2, within the deadline */
+  TASK_SCHED_Post(Ids[1], 1U);
+  (void)Drain();
+
+  /* Behind the blocker: latency 3 + run 2 = 5, still within */
+  TASK_SCHED_Post(Ids[0], 1U);
+  TASK_SCHED_Post(Ids[1], 1U);
+  (void)Drain();
+
+  /* Posted at 1007, reposted at 1009 before it runs: the latency counts
+   * from the first post, 3 + 2 + 2 = 7 */
+  TASK_SCHED_Post(Ids[1], 1U);
+  Now += 2U;
+  TASK_SCHED_Post(Ids[1], 2U);
+  TASK_SCHED_Post(Ids[0], 1U);
+  RunTime[1] = 3U;
+  (void)Drain();
+
+  ok &= (TASK_SCHED_GetStats(Ids[1], &stats) == TASK_SCHED_OK) && (stats.Runs == 3U) && (stats.MaxLatency == 5U)
+        && (stats.MaxRunTime == 3U) && (stats.DeadlineMisses == 1U);
+  ok &= (TASK_SCHED_GetStats(Ids[0], &stats) == TASK_SCHED_OK) && (stats.Runs == 2U) && (stats.MaxLatency == 0U)
+        && (stats.MaxRunTime == 3U) && (stats.DeadlineMisses == 0U);
+
+  return Report("statistics", ok, "latency 5, run 3, 1 miss of 3 runs");
+}
+
+/**
+  * @brief  Check a post at each point the scheduler reads the clock is run
+  * @retval true if passed
+  */
+static bool ClockPosts()
+{
+  std::vector<TASK_SCHED_Def_t> defs =
+  {
+    { "target", nullptr, TASK_SCHED_PRIO_NORMAL, 0U, 0U },
+    { "other", nullptr, TASK_SCHED_PRIO_NORMAL, 0U, 0U },
+  };
+  uint32_t points = 0;
+  bool ok = true;
+
+  /* RunOnce reads the clock before the timers, before and after the
+   * handler; Post reads it too */
+  for (int32_t call = 0; call < 8; call++)
+  {
+    for (uint32_t to = 0; to < 2U; to++)
+    {
+      uint32_t seen = 0;
+
+      Setup(defs);
+      TASK_SCHED_Post(Ids[0], 0x1U);
+      PostId = Ids[to];
+      PostEvents = 0x2U;
+      PostOnCall = call;
+      (void)Drain();
+      for (size_t n = 0; n < Trace.size(); n++)
+      {
+        seen |= (Trace[n] == to) ? TraceEvents[n] : 0U;
+      }
+      points += (PostOnCall < 0) ? 1U : 0U;
+      ok &= ((seen & 0x2U) != 0U) || (PostOnCall >= 0);
+      ok &= (TASK_SCHED_Pending() == 0U);
+      PostOnCall = -1;
+    }
+  }
+
+  char detail[64];
+  std::snprintf(detail, sizeof(detail), "posted at %u of 16 clock reads, none lost", points);
+  return Report("posts inside RunOnce", ok && (points > 0U), detail);
+}
+
+/**
+  * @brief  Check no post from another thread is lost
+  * @retval true if passed
+  */
+static bool Interrupts()
+{
+  static std::atomic<uint32_t> seen(0);
+  std::vector<TASK_SCHED_Def_t> defs =
+  {
+    { "isr", nullptr, TASK_SCHED_PRIO_NORMAL, 0U, 0U },
+    { "busy", nullptr, TASK_SCHED_PRIO_LOW, 0U, 0U },
+  };
+  const uint32_t posts = 200000U;
+  std::atomic<bool> stop(false);
+  uint32_t lost = 0;
+
+  defs[0].Handler = [](uint32_t Events) { seen.fetch_or(Events); };
+  defs[1].Handler = [](uint32_t) {};
+  TASK_SCHED_Init(Clock, nullptr);
+  (void)TASK_SCHED_Register(&defs[0], &Ids[0]);
+  (void)TASK_SCHED_Register(&defs[1], &Ids[1]);
+  seen = 0;
+
+  std::thread scheduler([&]()
+  {
+    while (!stop.load())
+    {
+      /* A low priority task keeps the scheduler busy between the posts */
+      TASK_SCHED_Post(Ids[1], 1U);
+      (void)TASK_SCHED_RunOnce();
+      std::this_thread::yield();
+    }
+  });
+
+  /* Each post must be seen, else it sat in Events with no ready bit */
+  for (uint32_t n = 0; n < posts; n++)
+  {
+    uint32_t bit = 1U << (n % 31U);
+    BenchClock::time_point t0 = BenchClock::now();
+
+    TASK_SCHED_Post(Ids[0], bit);
+    while ((seen.load() & bit) == 0U)
+    {
+      if ((BenchClock::now() - t0) > std::chrono::seconds(1))
+      {
+        lost++;
+        break;
+      }
+      std::this_thread::yield();
+    }
+    seen.fetch_and(~bit);
+  }
+  stop = true;
+  scheduler.join();
+
+  TASK_SCHED_Stats_t stats;
+  (void)TASK_SCHED_GetStats(Ids[0], &stats);
+
+  char detail[64];
+  std::snprintf(detail, sizeof(detail), "%u posts, %u lost, %u handler runs", posts, lost, stats.Runs);
+  return Report("posts from a thread", (lost == 0U) && (stats.Runs <= posts), detail);
+}
+
+/**
+  * @brief  Check the refused calls
+  * @retval true if passed
+  */
+static bool Errors()
+{
+  TASK_SCHED_Def_t def = { "t", Handlers[0], TASK_SCHED_PRIO_NORMAL, 0U, 0U };
+  TASK_SCHED_Def_t bad = def;
+  TASK_SCHED_Def_t none = def;
+  TASK_SCHED_Stats_t stats;
+  uint32_t id = 0xFFU;
+  uint32_t delay = 0;
+  bool ok = true;
+
+  bad.Priority = TASK_SCHED_PRIO_NBR;
+  none.Handler = nullptr;
+
+  TASK_SCHED_Init(nullptr, nullptr);
+  ok &= (TASK_SCHED_Register(&def, &id) == TASK_SCHED_ERROR) && (id == 0xFFU);
+
+  TASK_SCHED_Init(Clock, nullptr);
+  ok &= (TASK_SCHED_Register(&bad, &id) == TASK_SCHED_ERROR) && (TASK_SCHED_Register(&none, &id) == TASK_SCHED_ERROR)
+        && (TASK_SCHED_Register(nullptr, &id) == TASK_SCHED_ERROR) && (TASK_SCHED_NextTimer(&delay) == TASK_SCHED_ERROR);
+  for (uint32_t i = 0; i < TASK_SCHED_MAX_TASKS; i++)
+  {
+    ok &= (TASK_SCHED_Register(&def, &id) == TASK_SCHED_OK) && (id == i);
+  }
+  ok &= (TASK_SCHED_Register(&def, &id) == TASK_SCHED_ERROR);
+
+  /* Out of range ids are ignored */
+  TASK_SCHED_Post(TASK_SCHED_MAX_TASKS, 1U);
+  TASK_SCHED_SetTimer(TASK_SCHED_MAX_TASKS, 0U, 1U);
+  TASK_SCHED_StopTimer(TASK_SCHED_MAX_TASKS);
+  ok &= (TASK_SCHED_Pending() == 0U) && (TASK_SCHED_RunOnce() == 0U)
+        && (TASK_SCHED_GetStats(TASK_SCHED_MAX_TASKS, &stats) == TASK_SCHED_ERROR);
+
+  return Report("errors", ok);
+}
+
+int main()
+{
+  bool ok = true;
+
+  ok &= Priorities();
+  ok &= RoundRobin();
+  ok &= Timers(0U);
+  ok &= Timers(0xFFFFFFC0U);
+  ok &= Statistics();
+  ok &= ClockPosts();
+  ok &= Interrupts();
+  ok &= Errors();
+
+  /* Cost of a post and a dispatch, 8 tasks registered */
+  std::vector<TASK_SCHED_Def_t> defs(TASK_SCHED_MAX_TASKS, { "b", nullptr, TASK_SCHED_PRIO_NORMAL, 0U, 0U });
+  double best = 1e9;
+  Setup(defs);
+  for (TASK_SCHED_Def_t &d : defs)
+  {
+    d.Handler = [](uint32_t) {};
+  }
+  for (int run = 0; run < 5; run++)
+  {
+    BenchClock::time_point t0 = BenchClock::now();
+    for (uint32_t i = 0; i < 1000000U; i++)
+    {
+      TASK_SCHED_Post(Ids[i & 7U], 1U);
+      (void)TASK_SCHED_RunOnce();
+    }
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    best = std::fmin(best, ns / 1000000.0);
+  }
+  std::printf("post + dispatch  %.1f ns\n", best);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,198 @@
+/**
+  ******************************************************************************
+  * @file    tick_comp_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the tickless tick compensation against a simulated clock
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  * ******************************************************************************
+  */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+#include "tick_comp.h"
+
+/*
+ * Runs the firmware tick_comp.c on a host:
+ *  - TICK_COMP_Ticks wakes on the first counter tick at which the requested
+ *    milliseconds are due, for every remainder,
+ *  - TICK_COMP_MaxMs stays within the counter range,
+ *  - a simulated node alternating runs on a 1 ms SysTick and tickless
+ *    sleeps on a 32768 Hz counter, as TICKLESS_Sleep does, keeps uwTick on
+ *    the real time. Without the compensation (the fraction of the current
+ *    millisecond and the remainder dropped) the tick falls behind.
+ */
+
+static const uint32_t kHz = 32768U;           /* LSE */
+static const uint32_t kCoreHz = 4000000U;     /* MSI range 6 */
+static const uint32_t kLoad = kCoreHz / 1000U; /* SysTick clocks per ms */
+static const uint32_t kMaxTicks = 0xFF00U;
+
+/**
+  * @brief  Check the wake tick of every sleep length and remainder
+  * @retval true if each wake is the first due tick
+  */
+static bool CheckTicks()
+{
+  TICK_COMP_t comp;
+  uint32_t maxms;
+
+  (void)TICK_COMP_Init(&comp, kHz);
+  maxms = TICK_COMP_MaxMs(&comp, kMaxTicks);
+
+  for (uint32_t rem = 0; rem < (2U * kHz); rem += 97U)
+  {
+    for (uint32_t ms = 1; ms <= maxms; ms += ((ms < 50U) ? 1U : 37U))
+    {
+      TICK_COMP_t a = { kHz, rem };
+      TICK_COMP_t b = { kHz, rem };
+      uint32_t ticks = TICK_COMP_Ticks(&a, ms);
+
+      if ((ticks > kMaxTicks) || (TICK_COMP_Elapsed(&a, ticks, 1U) < ms)
+          || ((ticks > 0U) && (TICK_COMP_Elapsed(&b, ticks - 1U, 1U) >= ms)))
+      {
+        std::printf("rem %u, %u ms: wake after %u ticks is not the first due one\n", rem, ms, ticks);
+        return false;
+      }
+    }
+  }
+
+  std::printf("wake ticks   up to %u ms (%u ticks max)  ok\n", maxms, kMaxTicks);
+  return true;
+}
+
+struct Node
+{
+  bool Comp;               /* Use tick_comp, else drop the fractions */
+  TICK_COMP_t State;
+  uint64_t Now;            /* Real time [ns] */
+  uint64_t TickBase;       /* Real time of the last SysTick (re)start [ns] */
+  uint32_t Tick;           /* uwTick */
+  double MaxErr;           /* Largest |real ms - uwTick| seen */
+  double SumErr;
+};
+
+/**
+  * @brief  LSE counter value at a real time
+  * @param  Ns the real time [ns]
+  * @retval Counter ticks since time 0
+  */
+static uint64_t Counter(uint64_t Ns)
+{
+  return static_cast<uint64_t>((static_cast<unsigned __int128>(Ns) * kHz) / 1000000000U);
+}
+
+/**
+  * @brief  Run with SysTick for a while
+  * @param  N the node
+  * @param  Ns the run time [ns]
+  * @retval None
+  */
+static void Run(Node &N, uint64_t Ns)
+{
+  uint64_t before = (N.Now - N.TickBase) / 1000000U;
+
+  N.Now += Ns;
+  N.Tick += static_cast<uint32_t>(((N.Now - N.TickBase) / 1000000U) - before);
+}
+
+/**
+  * @brief  Sleep as TICKLESS_Sleep does
+  * @param  N the node
+  * @param  Ms the time to the next timer
+  * @param  Early real time to an earlier interrupt [ns], 0 for none
+  * @retval None
+  */
+static void Sleep(Node &N, uint32_t Ms, uint64_t Early)
+{
+  uint64_t cycles = ((N.Now - N.TickBase) % 1000000U) * kCoreHz / 1000000000U;
+  uint64_t start = Counter(N.Now);
+  uint64_t wake;
+  uint32_t ticks;
+  uint32_t elapsed;
+  uint8_t edge = 1;
+
+  if (N.Comp)
+  {
+    TICK_COMP_AddFraction(&N.State, static_cast<uint32_t>(cycles), kLoad);
+    ticks = std::max(TICK_COMP_Ticks(&N.State, Ms), 4U);
+  }
+  else
+  {
+    ticks = static_cast<uint32_t>((static_cast<uint64_t>(Ms) * kHz) / 1000U);
+  }
+
+  /* Real time of the compare match: the counter reaches start + ticks */
+  wake = static_cast<uint64_t>(((static_cast<unsigned __int128>(start + ticks) * 1000000000U) + kHz - 1U) / kHz);
+  if ((Early != 0U) && ((N.Now + Early) < wake))
+  {
+    wake = N.Now + Early;
+    edge = 0;
+  }
+
+  N.Now = wake;
+  elapsed = static_cast<uint32_t>(Counter(N.Now) - start);
+  N.Tick += N.Comp ? TICK_COMP_Elapsed(&N.State, elapsed, edge)
+                   : static_cast<uint32_t>((static_cast<uint64_t>(elapsed) * 1000U) / kHz);
+  N.TickBase = N.Now;
+
+  double err = (static_cast<double>(N.Now) / 1e6) - N.Tick;
+  N.MaxErr = std::max(N.MaxErr, std::fabs(err));
+  N.SumErr += err;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t cycles = (argc > 1) ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1000000U;
+  Node comp = { true, { 0U, 0U }, 0U, 0U, 0U, 0.0, 0.0 };
+  Node naive = comp;
+  std::mt19937 rng(1);
+  std::uniform_int_distribution<uint32_t> run(20000U, 3000000U);  /* 20 us to 3 ms of work */
+  std::uniform_int_distribution<uint32_t> due(2U, 1999U);
+  std::bernoulli_distribution early(0.2);
+  bool ok;
+
+  naive.Comp = false;
+  (void)TICK_COMP_Init(&comp.State, kHz);
+
+  ok = CheckTicks();
+
+  for (uint32_t i = 0; i < cycles; i++)
+  {
+    uint64_t r = run(rng);
+    uint32_t ms = due(rng);
+    uint64_t e = early(rng) ? (static_cast<uint64_t>(run(rng)) * 3U) : 0U;
+
+    Run(comp, r);
+    Run(naive, r);
+    Sleep(comp, ms, e);
+    Sleep(naive, ms, e);
+  }
+
+  std::printf("%u sleeps, %.1f s simulated\n", cycles, static_cast<double>(comp.Now) / 1e9);
+  std::printf("compensated  uwTick behind by %.3f ms at the end, %.3f ms at most, %.3f ms on average\n",
+              (static_cast<double>(comp.Now) / 1e6) - comp.Tick, comp.MaxErr, comp.SumErr / cycles);
+  std::printf("naive        uwTick behind by %.3f ms at the end\n",
+              (static_cast<double>(naive.Now) / 1e6) - naive.Tick);
+
+  /* Within the counter and tick quantization: under 1 ms plus the random
+   * walk of the counter phase (one tick per sleep at most) */
+  if (comp.MaxErr > (1.0 + (4.0 * std::sqrt(static_cast<double>(cycles)) * 1000.0 / kHz)))
+  {
+    std::printf("compensated tick drifts  FAILED\n");
+    ok = false;
+  }
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}
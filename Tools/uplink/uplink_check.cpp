@@ -0,0 +1,570 @@
+/**
+  ******************************************************************************
+  * @file    uplink_check.cpp
+  * @author  ISCA Lab
+  * @brief   Check the uplink packer round trip and the duty cycle credit
+  ******************************************************************************
+  * @attention
+  *
+  * This software is licensed under terms that can be found in the LICENSE file
+  * in the root directory of this software component.
+  * If no LICENSE file comes with this software, it is provided AS-IS.
+  *
+  ******************************************************************************
+  */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "uplink.h"
+
+/*
+ * Runs the firmware uplink.c on a host, the transport captures the payloads:
+ *
+ *  - vectors: payloads worked out by hand from the format in uplink.h, the
+ *    four delta codes, and LoRa time on air against the Semtech formula,
+ *  - round trip: random MLC events of two sensors, snapshot and health
+ *    events over a day,
+ *    each payload decoded by a decoder written from the format. Every event
+ *    queued comes back once, in order, with its time to UPLINK_TIME_UNIT;
+ *    payloads are full when more was queued, urgent events go at once and
+ *    the others within UPLINK_MAX_LATENCY,
+ *  - token bucket: a day of one MLC change per second on LoRa SF9. The time
+ *    on air of any interval stays within the duty cycle plus the saved up
+ *    credit, and the duty cycle is used,
+ *  - edges: suppression, clamping, full queue, refused sends.
+ */
+
+using BenchClock = std::chrono::steady_clock;
+
+struct Event
+{
+  uint32_t Type;
+  uint32_t Units;   /* Time in UPLINK_TIME_UNIT */
+  std::vector<uint32_t> Data;
+  uint32_t Posted;  /* Time posted, ms */
+  bool Urgent;
+  bool AfterDrop;   /* Queued behind an event too big for any payload */
+};
+
+struct Packet
+{
+  std::vector<uint8_t> Data;
+  uint32_t Sent;    /* ms */
+};
+
+static uint32_t Now;
+static std::vector<Packet> Sent;
+static uint32_t Sf = 0;          /* 0: no time on air */
+static int32_t SendResult = UPLINK_OK;
+
+static uint32_t TimeOnAir(uint32_t Len)
+{
+  return (Sf == 0U) ? 0U : UPLINK_LoraTimeOnAir(Len, Sf);
+}
+
+static int32_t Send(const uint8_t *Data, uint32_t Len)
+{
+  if (SendResult == UPLINK_OK)
+  {
+    Sent.push_back({ std::vector<uint8_t>(Data, Data + Len), Now });
+  }
+  return SendResult;
+}
+
+static UPLINK_Transport_t Transport = { UPLINK_MAX_PAYLOAD, TimeOnAir, Send };
+
+/**
+  * @brief  Print a check
+  * @param  Name the check
+  * @param  Pass the result
+  * @param  Detail printed after the name
+  * @retval Pass
+  */
+static bool Report(const char *Name, bool Pass, const std::string &Detail = "")
+{
+  std::printf("%-20s %-52s %s\n", Name, Detail.c_str(), Pass ? "ok" : "FAILED");
+  return Pass;
+}
+
+/**
+  * @brief  Bits taken by an event, from the format
+  * @param  E the event
+  * @param  Delta the delta time
+  * @retval The number of bits
+  */
+static uint32_t EventBits(const Event &E, uint32_t Delta)
+{
+  uint32_t bits = 3U + ((Delta < 16U) ? 5U : (Delta < 1024U) ? 12U : (Delta < (1U << 18)) ? 21U : 35U);
+
+  switch (E.Type)
+  {
+    case UPLINK_EVT_MLC:
+      return bits + 9U;
+    case UPLINK_EVT_SNAPSHOT:
+      return bits + 24U;
+    default:
+      bits += 3U;
+      for (uint32_t v : E.Data)
+      {
+        uint32_t n = 0;
+        for (uint32_t x = v; x != 0U; x >>= 1)
+        {
+          n++;
+        }
+        bits += 5U + n;
+      }
+      return bits;
+  }
+}
+
+/**
+  * @brief  Decode a payload, from the format of uplink.h
+  * @param  P the payload
+  * @param  Seq the sequence number
+  * @param  Base the base time in s
+  * @param  Events the events, appended
+  * @param  End the bit position after the last event
+  * @retval true if well formed
+  */
+static bool Decode(const std::vector<uint8_t> &P, uint32_t *Seq, uint32_t *Base, std::vector<Event> &Events,
+                   uint32_t *End)
+{
+  uint32_t pos = 0;
+  uint32_t total = (uint32_t)P.size() * 8U;
+  bool ok = true;
+  auto get = [&](uint32_t N) -> uint32_t
+  {
+    uint32_t v = 0;
+    for (uint32_t i = 0; i < N; i++, pos++)
+    {
+      if (pos >= total)
+      {
+        ok = false;
+        return 0;
+      }
+      v = (v << 1) | ((P[pos / 8U] >> (7U - (pos % 8U))) & 1U);
+    }
+    return v;
+  };
+
+  if (get(2) != UPLINK_VERSION)
+  {
+    return false;
+  }
+  *Seq = get(6);
+  *Base = get(24);
+
+  uint32_t units = (*Base * 1000U) / UPLINK_TIME_UNIT;
+  while (ok && ((total - pos) >= 8U))
+  {
+    Event e = {};
+    e.Type = get(3);
+    uint32_t delta = (get(1) == 0U) ? get(4) : (get(1) == 0U) ? get(10) : (get(1) == 0U) ? get(18) : get(32);
+    units += delta;
+    e.Units = units;
+    switch (e.Type)
+    {
+      case UPLINK_EVT_MLC:
+        e.Data = { get(1) };
+        e.Data.push_back(get(8));
+        break;
+      case UPLINK_EVT_SNAPSHOT:
+        e.Data = { get(8) };
+        e.Data.push_back(get(8));
+        e.Data.push_back(get(8));
+        break;
+      case UPLINK_EVT_HEALTH:
+      {
+        uint32_t count = get(3);
+        for (uint32_t i = 0; ok && (i < count); i++)
+        {
+          e.Data.push_back(get(get(5)));
+        }
+        break;
+      }
+      default:
+        return false;
+    }
+    if (ok)
+    {
+      Events.push_back(e);
+      *End = pos;
+    }
+  }
+
+  /* Only the padding of the last byte, zero, is left */
+  return ok && ((total - *End) < 8U) && ((P.back() & ((1U << (total - *End)) - 1U)) == 0U);
+}
+
+/**
+  * @brief  Check payloads worked out by hand and the LoRa time on air
+  * @retval true if passed
+  */
+static bool Vectors()
+{
+  bool ok = true;
+  uint32_t seq, base, end;
+  std::vector<Event> ev;
+
+  /* MLC 3 of sensor 1 at 12.345 s: v2 seq 0 base 12, MLC delta 3 sensor 1
+     code 3 */
+  Sent.clear();
+  Sf = 0;
+  UPLINK_Init(&Transport, 0U);
+  (void)UPLINK_PostMlc(1U, 3U, 12345U);
+  Now = 12345U;
+  UPLINK_Process(Now);
+  ok &= (Sent.size() == 1U) && (Sent[0].Data == std::vector<uint8_t>{ 0x80, 0x00, 0x00, 0x0C, 0x03, 0x81, 0x80 });
+
+  /* A snapshot and a health report wait for the MLC change of sensor 0 at
+     5.1 s */
+  Sent.clear();
+  UPLINK_Init(&Transport, 0U);
+  const uint32_t counters[3] = { 0U, 5U, 300U };
+  (void)UPLINK_PostSnapshot(7U, 1000U, 2500U, 5000U);
+  (void)UPLINK_PostHealth(counters, 3U, 5050U);
+  UPLINK_Process(5050U);
+  ok &= Sent.empty() && (UPLINK_Pending() == 2U);
+  (void)UPLINK_PostMlc(0U, 9U, 5100U);
+  UPLINK_Process(5100U);
+  ok &= (Sent.size() == 1U)
+        && (Sent[0].Data == std::vector<uint8_t>{ 0x80, 0x00, 0x00, 0x05, 0x40, 0x07, 0x0F, 0x19,
+                                                   0x60, 0x60, 0x1D, 0x4C, 0xB0, 0x04, 0x12 });
+
+  /* The delta codes: 5, 12, 21 and 35 bits, gaps of 1.5 s, 100 s, 7 h, 8 h */
+  Sent.clear();
+  UPLINK_Init(&Transport, 0U);
+  const uint32_t times[] = { 1000U, 2500U, 102500U, 25302500U, 54102500U };
+  for (uint32_t t : times)
+  {
+    (void)UPLINK_PostSnapshot(1U, 64U, 100U, t);
+  }
+  UPLINK_Process(54102500U);
+  ev.clear();
+  ok &= (Sent.size() == 1U) && Decode(Sent[0].Data, &seq, &base, ev, &end) && (ev.size() == 5U) && (base == 1U)
+        && (end == (32U + 32U + 32U + 39U + 48U + 62U));
+  for (uint32_t i = 0; ok && (i < 5U); i++)
+  {
+    ok = (ev[i].Units == (times[i] / UPLINK_TIME_UNIT)) && (ev[i].Data == std::vector<uint32_t>{ 1U, 1U, 1U });
+  }
+
+  /* Semtech formula, 125 kHz CR 4/5, rounded up */
+  ok &= (UPLINK_LoraTimeOnAir(10U, 7U) == 42U) && (UPLINK_LoraTimeOnAir(1U, 7U) == 26U)
+        && (UPLINK_LoraTimeOnAir(51U, 7U) == 103U) && (UPLINK_LoraTimeOnAir(20U, 9U) == 186U)
+        && (UPLINK_LoraTimeOnAir(11U, 10U) == 289U) && (UPLINK_LoraTimeOnAir(51U, 11U) == 1315U)
+        && (UPLINK_LoraTimeOnAir(51U, 12U) == 2466U);
+
+  return Report("vectors", ok, "2 payloads by hand, 4 delta codes, LoRa time on air");
+}
+
+/**
+  * @brief  Post random events for a day and decode every payload
+  * @param  MaxPayload the transport payload size
+  * @retval true if passed
+  */
+static bool RoundTrip(uint32_t MaxPayload)
+{
+  std::mt19937 rng(59U + MaxPayload);
+  std::vector<Event> queued;
+  uint32_t lastMlc[UPLINK_MLC_SENSORS];
+  uint32_t dropped = 0;
+  uint32_t tooBig = 0;
+  bool skipped = false;
+  uint32_t maxStep = 0;
+  bool ok = true;
+
+  std::fill(std::begin(lastMlc), std::end(lastMlc), 0x100U);
+  Transport.MaxPayload = MaxPayload;
+  Sent.clear();
+  Sf = 0;
+  Now = 1000000U;
+  UPLINK_Init(&Transport, Now);
+
+  while (Now < (1000000U + (24U * 3600U * 1000U)))
+  {
+    uint32_t step = (rng() % 16U == 0U) ? (1U + (rng() % 90000U)) : (1U + (rng() % 3000U));
+    maxStep = std::max(maxStep, step);
+    Now += step;
+
+    /* Now and then a burst overflows the queue */
+    for (uint32_t k = (rng() % 64U == 0U) ? 24U : (rng() % 4U); k > 0U; k--)
+    {
+      Event e = {};
+      uint32_t pending = UPLINK_Pending();
+      e.Posted = Now;
+      e.Units = Now / UPLINK_TIME_UNIT;
+      e.Type = (rng() % 2U == 0U) ? UPLINK_EVT_MLC : (rng() % 2U == 0U) ? UPLINK_EVT_SNAPSHOT : UPLINK_EVT_HEALTH;
+      uint32_t prev = 0;
+      bool fresh = true;
+      switch (e.Type)
+      {
+        case UPLINK_EVT_MLC:
+        {
+          uint32_t sensor = rng() % UPLINK_MLC_SENSORS;
+          uint32_t code = rng() % 4U;
+          prev = lastMlc[sensor];
+          fresh = (code != prev);
+          e.Data = { sensor, code };
+          e.Urgent = true;
+          (void)UPLINK_PostMlc((uint8_t)sensor, (uint8_t)code, Now);
+          lastMlc[sensor] = code;
+          break;
+        }
+        case UPLINK_EVT_SNAPSHOT:
+        {
+          uint32_t peak = rng() % 20000U;
+          uint32_t dur = rng() % 30000U;
+          e.Data = { (uint32_t)(rng() % 256U), std::min(peak / 64U, 255U), std::min(dur / 100U, 255U) };
+          (void)UPLINK_PostSnapshot((uint8_t)e.Data[0], peak, dur, Now);
+          break;
+        }
+        default:
+        {
+          uint32_t c[UPLINK_HEALTH_MAX];
+          uint32_t n = rng() % (UPLINK_HEALTH_MAX + 1U);
+          for (uint32_t i = 0; i < n; i++)
+          {
+            c[i] = (rng() % 2U) ? (rng() % 100U) : (uint32_t)rng();
+            e.Data.push_back(std::min(c[i], 0x7FFFFFFFU));
+          }
+          (void)UPLINK_PostHealth(c, n, Now);
+          break;
+        }
+      }
+      if (fresh && (pending >= UPLINK_MAX_EVENTS))
+      {
+        /* A dropped change is not remembered */
+        dropped++;
+        if (e.Type == UPLINK_EVT_MLC)
+        {
+          lastMlc[e.Data[0]] = prev;
+        }
+        fresh = false;
+      }
+      /* Alone in a payload, the first delta is under 1 s: 5 bits */
+      if (fresh && ((32U + EventBits(e, 0U)) > (MaxPayload * 8U)))
+      {
+        tooBig++;
+        fresh = false;
+        skipped = true;
+      }
+      if (fresh)
+      {
+        e.AfterDrop = skipped;
+        skipped = false;
+        queued.push_back(e);
+      }
+    }
+    UPLINK_Process(Now);
+  }
+
+  /* Flush what is left */
+  Now += UPLINK_MAX_LATENCY;
+  UPLINK_Process(Now);
+  ok &= (UPLINK_Pending() == 0U);
+
+  std::vector<Event> got;
+  std::vector<uint32_t> first;   /* Index in got of the first event of each payload */
+  std::vector<uint32_t> ends;
+  for (uint32_t p = 0; ok && (p < Sent.size()); p++)
+  {
+    uint32_t seq, base, end = 0;
+    first.push_back((uint32_t)got.size());
+    ok = (Sent[p].Data.size() <= MaxPayload) && Decode(Sent[p].Data, &seq, &base, got, &end)
+         && (seq == (p & 0x3FU)) && (got.size() > first.back())
+         && (base == ((queued[first.back()].Posted / 1000U) & 0xFFFFFFU));
+    ends.push_back(end);
+  }
+  ok &= (got.size() == queued.size());
+
+  uint32_t late = 0;
+  uint32_t notFull = 0;
+  for (uint32_t p = 0; ok && (p < Sent.size()); p++)
+  {
+    uint32_t stop = (p + 1U < Sent.size()) ? first[p + 1U] : (uint32_t)got.size();
+    for (uint32_t i = first[p]; ok && (i < stop); i++)
+    {
+      ok = (got[i].Type == queued[i].Type) && (got[i].Units == queued[i].Units) && (got[i].Data == queued[i].Data);
+      if (queued[i].Urgent ? (Sent[p].Sent != queued[i].Posted)
+                           : ((Sent[p].Sent - queued[i].Posted) > (UPLINK_MAX_LATENCY + maxStep)))
+      {
+        late++;
+      }
+    }
+    /* The next event was queued already: it must not have fit. Packing
+       stops at an event too big for any payload, which goes next */
+    if (ok && (stop < got.size()) && (queued[stop].Posted <= Sent[p].Sent) && !queued[stop].AfterDrop
+        && ((ends[p] + EventBits(queued[stop], queued[stop].Units - queued[stop - 1U].Units)) <= (MaxPayload * 8U)))
+    {
+      notFull++;
+    }
+  }
+  ok &= (late == 0U) && (notFull == 0U);
+
+  UPLINK_Stats_t stats;
+  UPLINK_GetStats(&stats);
+  ok &= (stats.Events == (queued.size() + tooBig)) && (stats.Dropped == (dropped + tooBig)) && (stats.Packets == Sent.size());
+
+  char detail[80];
+  std::snprintf(detail, sizeof(detail), "%zu events in %zu payloads of %u B, %u dropped", queued.size(),
+                Sent.size(), MaxPayload, dropped + tooBig);
+  Transport.MaxPayload = UPLINK_MAX_PAYLOAD;
+  return Report("round trip", ok, detail);
+}
+
+/**
+  * @brief  Check the duty cycle credit over a day of LoRa sends
+  * @param  Period the time between two MLC changes in ms
+  * @retval true if passed
+  */
+static bool Bucket(uint32_t Period)
+{
+  const uint32_t day = 24U * 3600U * 1000U;
+  std::vector<std::pair<uint32_t, uint32_t>> sends; /* Time, time on air */
+  uint64_t airtime = 0;
+  bool ok = true;
+
+  Sent.clear();
+  Sf = 9;
+  Now = 0;
+  UPLINK_Init(&Transport, Now);
+  for (Now = 100U; Now <= day; Now += 100U)
+  {
+    if ((Now % Period) == 0U)
+    {
+      (void)UPLINK_PostMlc(0U, (uint8_t)((Now / Period) & 1U), Now);
+    }
+    size_t before = Sent.size();
+    UPLINK_Process(Now);
+    for (size_t i = before; i < Sent.size(); i++)
+    {
+      uint32_t toa = UPLINK_LoraTimeOnAir((uint32_t)Sent[i].Data.size(), Sf);
+      sends.push_back({ Now, toa });
+      airtime += toa;
+    }
+  }
+
+  /* Any interval: the credit saved up plus what the duty cycle earns */
+  for (size_t a = 0; a < sends.size(); a++)
+  {
+    uint64_t sum = 0;
+    for (size_t b = a; b < sends.size(); b++)
+    {
+      sum += sends[b].second;
+      uint64_t allowed = UPLINK_MAX_CREDIT + (((uint64_t)(sends[b].first - sends[a].first) * UPLINK_DUTY_PERMILLE) / 1000U);
+      ok &= (sum <= allowed);
+    }
+  }
+
+  UPLINK_Stats_t stats;
+  UPLINK_GetStats(&stats);
+  double duty = (double)airtime / (double)day;
+  bool heavy = (Period < 10000U);
+  ok &= (stats.Airtime == airtime) && (airtime <= (UPLINK_MAX_CREDIT + ((uint64_t)day * UPLINK_DUTY_PERMILLE / 1000U)));
+  ok &= heavy ? ((duty > 0.0095) && (stats.Deferred > 0U)) : ((stats.Deferred == 0U) && (stats.Dropped == 0U));
+
+  char detail[96];
+  std::snprintf(detail, sizeof(detail), "change every %5.1f s: duty %.3f %%, %u sends, %u deferred",
+                Period / 1000.0, duty * 100.0, stats.Packets, stats.Deferred);
+  return Report("token bucket", ok, detail);
+}
+
+/**
+  * @brief  Check suppression, clamping, full queue and refused sends
+  * @retval true if passed
+  */
+static bool Edges()
+{
+  const uint32_t big[UPLINK_HEALTH_MAX + 1U] = { 0xFFFFFFFFU, 1U, 2U, 3U, 4U };
+  UPLINK_Stats_t stats;
+  std::vector<Event> ev;
+  uint32_t seq, base, end;
+  bool ok = true;
+
+  Sent.clear();
+  Sf = 0;
+  Now = 0;
+  UPLINK_Init(&Transport, 0U);
+
+  /* Unchanged outputs are suppressed per sensor, bad arguments refused */
+  ok &= (UPLINK_PostMlc(0U, 1U, 0U) == UPLINK_OK) && (UPLINK_PostMlc(0U, 1U, 0U) == UPLINK_OK)
+        && (UPLINK_PostMlc(1U, 1U, 0U) == UPLINK_OK) && (UPLINK_PostMlc(1U, 1U, 0U) == UPLINK_OK)
+        && (UPLINK_PostMlc(UPLINK_MLC_SENSORS, 1U, 0U) == UPLINK_ERROR)
+        && (UPLINK_PostHealth(big, 5U, 0U) == UPLINK_ERROR) && (UPLINK_Pending() == 2U);
+
+  /* Values clamped to their field */
+  ok &= (UPLINK_PostSnapshot(1U, 100000U, 60000U, 0U) == UPLINK_OK) && (UPLINK_PostHealth(big, 4U, 0U) == UPLINK_OK);
+
+  /* A refused send keeps the events for the next try */
+  SendResult = UPLINK_ERROR;
+  UPLINK_Process(0U);
+  ok &= Sent.empty() && (UPLINK_Pending() == 4U);
+  SendResult = UPLINK_OK;
+  UPLINK_Process(100U);
+  ok &= (Sent.size() == 1U) && Decode(Sent[0].Data, &seq, &base, ev, &end) && (ev.size() == 4U)
+        && (ev[2].Data == std::vector<uint32_t>{ 1U, 255U, 255U })
+        && (ev[3].Data == std::vector<uint32_t>{ 0x7FFFFFFFU, 1U, 2U, 3U });
+
+  /* A full queue drops, and goes out without waiting, the snapshots 1 to
+     15 units apart take 32 bits each. The rest is not due yet */
+  Sent.clear();
+  UPLINK_Init(&Transport, 0U);
+  for (uint32_t i = 0; i < (UPLINK_MAX_EVENTS + 3U); i++)
+  {
+    (void)UPLINK_PostSnapshot((uint8_t)i, 0U, 0U, 1000U + (i * UPLINK_TIME_UNIT));
+  }
+  ok &= (UPLINK_Pending() == UPLINK_MAX_EVENTS);
+  UPLINK_Process(3000U);
+  UPLINK_GetStats(&stats);
+  ok &= (stats.Suppressed == 0U) && (stats.Dropped == 3U) && (Sent.size() == 1U)
+        && (UPLINK_Pending() == (UPLINK_MAX_EVENTS - (((UPLINK_MAX_PAYLOAD * 8U) - 32U) / 32U)));
+
+  /* No transport: only the credit moves */
+  UPLINK_Init(nullptr, 0U);
+  ok &= (UPLINK_PostMlc(0U, 2U, 0U) == UPLINK_OK);
+  UPLINK_Process(0U);
+  ok &= (UPLINK_Pending() == 1U);
+
+  return Report("edges", ok, "suppression, clamping, refused send, full queue");
+}
+
+int main()
+{
+  bool ok = true;
+
+  ok &= Vectors();
+  ok &= RoundTrip(UPLINK_MAX_PAYLOAD);
+  ok &= RoundTrip(11U);
+  ok &= Bucket(1000U);
+  ok &= Bucket(600000U);
+  ok &= Edges();
+
+  /* Cost of a post and the packing of a full payload */
+  Sf = 0;
+  double best = 1e9;
+  for (int run = 0; run < 5; run++)
+  {
+    Sent.clear();
+    Sent.reserve(200000U);
+    UPLINK_Init(&Transport, 0U);
+    BenchClock::time_point t0 = BenchClock::now();
+    for (uint32_t i = 0; i < 100000U; i++)
+    {
+      (void)UPLINK_PostSnapshot((uint8_t)i, i, i, i * 10U);
+      UPLINK_Process(i * 10U);
+    }
+    double ns = std::chrono::duration<double, std::nano>(BenchClock::now() - t0).count();
+    best = std::fmin(best, ns / 100000.0);
+  }
+  std::printf("post + process  %.0f ns per event\n", best);
+
+  std::printf("%s\n", ok ? "all checks passed" : "checks FAILED");
+  return ok ? 0 : 1;
+}